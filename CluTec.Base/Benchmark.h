@@ -0,0 +1,802 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Base
+// file:      Benchmark.h
+//
+// summary:   Declares a minimal micro benchmark harness with JSON output and baseline comparison
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// namespace: Clu.Benchmark
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace Clu
+{
+	namespace Benchmark
+	{
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Counts heap allocations. The counters are only updated if the benchmark executable replaces the global
+		/// 	allocation operators with CLU_BENCHMARK_TRACK_ALLOCATIONS() in exactly one of its translation units.
+		/// </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CAllocationCounter
+		{
+		public:
+			static std::atomic<size_t>& Bytes()
+			{
+				static std::atomic<size_t> s_nBytes(0);
+				return s_nBytes;
+			}
+
+			static std::atomic<size_t>& Count()
+			{
+				static std::atomic<size_t> s_nCount(0);
+				return s_nCount;
+			}
+
+			static void Add(size_t nBytes)
+			{
+				Bytes().fetch_add(nBytes, std::memory_order_relaxed);
+				Count().fetch_add(1, std::memory_order_relaxed);
+			}
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Keeps the compiler from removing the computation of the given value as dead code.
+		/// </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TValue>
+		inline void DoNotOptimize(const TValue& xValue)
+		{
+			static const void* volatile s_pSink = nullptr;
+			s_pSink = &xValue;
+			(void)s_pSink;
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	The measurement of a single benchmark. </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		struct SResult
+		{
+			std::string sName;
+			size_t nIterationCount = 0;
+
+			/// <summary>	Median time per operation over all repetitions. </summary>
+			double dNsPerOp = 0.0;
+
+			/// <summary>	Floating point throughput derived from the nominal flop count. Zero if no count was given. </summary>
+			double dGFlops = 0.0;
+
+			double dBytesAllocatedPerOp = 0.0;
+			double dAllocationsPerOp = 0.0;
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	The comparison of a benchmark result with its baseline. </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		struct SComparison
+		{
+			std::string sName;
+			bool bHasBaseline = false;
+			bool bIsRegression = false;
+			double dBaselineNsPerOp = 0.0;
+			double dNsPerOp = 0.0;
+
+			/// <summary>	Ratio of current to baseline time. Values above one are slower. </summary>
+			double dRatio = 0.0;
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Options of a benchmark run, as set from the command line. </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		struct SOptions
+		{
+			/// <summary>	Minimal duration of a single repetition in seconds. </summary>
+			double dMinTime = 0.1;
+			unsigned uRepeatCount = 5;
+
+			/// <summary>	Only benchmarks whose names contain this string are run. </summary>
+			std::string sFilter;
+
+			std::string sOutputFile;
+			std::string sBaselineFile;
+
+			/// <summary>	Relative slow down against the baseline that counts as regression. </summary>
+			double dThreshold = 0.1;
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Runs benchmarks and collects their results. The number of iterations per repetition is calibrated so that
+		/// 	each repetition takes at least SOptions::dMinTime. The reported time is the median over the repetitions.
+		/// </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CRunner
+		{
+		public:
+			using TClock = std::chrono::steady_clock;
+
+		public:
+			CRunner(const SOptions& xOptions) : m_xOptions(xOptions)
+			{ }
+
+			const std::vector<SResult>& Results() const
+			{
+				return m_vecResult;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Runs a benchmark if its name passes the filter. </summary>
+			///
+			/// <typeparam name="FuncOp">	Operation to measure, called without arguments. </typeparam>
+			/// <param name="sName">	 	Unique name of the benchmark. It is the key for baseline comparison. </param>
+			/// <param name="dFlopPerOp">	Nominal floating point operations per operation or zero. </param>
+			/// <param name="funcOp">	 	The operation. </param>
+			/// <param name="nOpPerCall">	Number of operations a call of funcOp performs, for batched small kernels. </param>
+			///
+			/// <returns>	True if the benchmark was run. </returns>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename FuncOp>
+			bool Run(const std::string& sName, double dFlopPerOp, FuncOp funcOp, size_t nOpPerCall = 1)
+			{
+				if (!m_xOptions.sFilter.empty() && sName.find(m_xOptions.sFilter) == std::string::npos)
+				{
+					return false;
+				}
+
+				// Calibrate the iteration count, starting with a warm up call.
+				size_t nIterCnt = 1;
+				double dTime = _Measure(nIterCnt, funcOp);
+				while (dTime < m_xOptions.dMinTime / 10.0 && nIterCnt < (size_t(1) << 40))
+				{
+					nIterCnt *= 2;
+					dTime = _Measure(nIterCnt, funcOp);
+				}
+
+				if (dTime < m_xOptions.dMinTime)
+				{
+					nIterCnt = size_t(std::ceil(double(nIterCnt) * m_xOptions.dMinTime / std::max(dTime, 1e-9)));
+				}
+
+				SResult xResult;
+				xResult.sName = sName;
+				xResult.nIterationCount = nIterCnt;
+
+				std::vector<double> vecTime;
+				const unsigned uRepeatCnt = std::max(m_xOptions.uRepeatCount, 1u);
+				for (unsigned uRepeat = 0; uRepeat < uRepeatCnt; ++uRepeat)
+				{
+					const size_t nBytes = CAllocationCounter::Bytes().load();
+					const size_t nCount = CAllocationCounter::Count().load();
+
+					const double dRepeatTime = _Measure(nIterCnt, funcOp);
+
+					if (uRepeat == 0)
+					{
+						const double dOpCnt = double(nIterCnt) * double(nOpPerCall);
+						xResult.dBytesAllocatedPerOp = double(CAllocationCounter::Bytes().load() - nBytes) / dOpCnt;
+						xResult.dAllocationsPerOp = double(CAllocationCounter::Count().load() - nCount) / dOpCnt;
+					}
+
+					vecTime.push_back(dRepeatTime);
+				}
+
+				std::sort(vecTime.begin(), vecTime.end());
+				const double dMedian = vecTime[vecTime.size() / 2];
+
+				xResult.dNsPerOp = 1e9 * dMedian / (double(nIterCnt) * double(nOpPerCall));
+				xResult.dGFlops = (xResult.dNsPerOp > 0.0 ? dFlopPerOp / xResult.dNsPerOp : 0.0);
+
+				std::cout << std::left << std::setw(56) << sName << std::right
+					<< std::setw(14) << std::fixed << std::setprecision(1) << xResult.dNsPerOp << " ns"
+					<< std::setw(10) << std::setprecision(3) << xResult.dGFlops << " GFLOP/s"
+					<< std::setw(12) << std::setprecision(0) << xResult.dBytesAllocatedPerOp << " B" << std::endl;
+
+				m_vecResult.push_back(std::move(xResult));
+				return true;
+			}
+
+		protected:
+			template<typename FuncOp>
+			static double _Measure(size_t nIterCnt, FuncOp& funcOp)
+			{
+				const TClock::time_point tpStart = TClock::now();
+				for (size_t nIter = 0; nIter < nIterCnt; ++nIter)
+				{
+					funcOp();
+				}
+				return std::chrono::duration<double>(TClock::now() - tpStart).count();
+			}
+
+		protected:
+			SOptions m_xOptions;
+			std::vector<SResult> m_vecResult;
+		};
+
+#pragma region JSON
+		inline void _WriteJsonString(std::ostream& xOut, const std::string& sText)
+		{
+			xOut << '"';
+			for (char cChar : sText)
+			{
+				if (cChar == '"' || cChar == '\\')
+				{
+					xOut << '\\';
+				}
+				xOut << cChar;
+			}
+			xOut << '"';
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Writes benchmark results as JSON. ReadJson() reads this format back. </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline void WriteJson(std::ostream& xOut, const std::string& sSuite, const std::vector<SResult>& vecResult)
+		{
+			xOut << "{\n  \"suite\": ";
+			_WriteJsonString(xOut, sSuite);
+			xOut << ",\n  \"benchmarks\": [";
+
+			xOut << std::setprecision(6);
+			for (size_t nIdx = 0; nIdx < vecResult.size(); ++nIdx)
+			{
+				const SResult& xR = vecResult[nIdx];
+				xOut << (nIdx == 0 ? "\n" : ",\n") << "    { \"name\": ";
+				_WriteJsonString(xOut, xR.sName);
+				xOut << ", \"iterations\": " << xR.nIterationCount
+					<< ", \"ns_per_op\": " << std::fixed << xR.dNsPerOp
+					<< ", \"gflops\": " << xR.dGFlops
+					<< ", \"bytes_allocated_per_op\": " << xR.dBytesAllocatedPerOp
+					<< ", \"allocations_per_op\": " << xR.dAllocationsPerOp << " }";
+			}
+
+			xOut << "\n  ]\n}\n";
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	A small JSON reader that extracts the benchmark results from a document written by WriteJson(). Unknown keys
+		/// 	are skipped, so that the format can be extended without invalidating stored baselines.
+		/// </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CJsonResultReader
+		{
+		public:
+			CJsonResultReader(const std::string& sText) : m_sText(sText), m_nPos(0)
+			{ }
+
+			bool Read(std::vector<SResult>& vecResult)
+			{
+				vecResult.clear();
+
+				if (!_Accept('{'))
+				{
+					return false;
+				}
+
+				if (_Peek() == '}')
+				{
+					++m_nPos;
+					return true;
+				}
+
+				do
+				{
+					std::string sKey;
+					if (!_ReadString(sKey) || !_Accept(':'))
+					{
+						return false;
+					}
+
+					if (sKey == "benchmarks")
+					{
+						if (!_ReadResults(vecResult))
+						{
+							return false;
+						}
+					}
+					else if (!_SkipValue())
+					{
+						return false;
+					}
+				} while (_Accept(','));
+
+				return _Accept('}');
+			}
+
+		protected:
+			bool _ReadResults(std::vector<SResult>& vecResult)
+			{
+				if (!_Accept('['))
+				{
+					return false;
+				}
+
+				if (_Accept(']'))
+				{
+					return true;
+				}
+
+				do
+				{
+					SResult xResult;
+					if (!_Accept('{'))
+					{
+						return false;
+					}
+
+					do
+					{
+						std::string sKey;
+						if (!_ReadString(sKey) || !_Accept(':'))
+						{
+							return false;
+						}
+
+						bool bOk;
+						if (sKey == "name")
+						{
+							bOk = _ReadString(xResult.sName);
+						}
+						else if (sKey == "iterations")
+						{
+							double dValue = 0.0;
+							bOk = _ReadNumber(dValue);
+							xResult.nIterationCount = size_t(dValue);
+						}
+						else if (sKey == "ns_per_op")
+						{
+							bOk = _ReadNumber(xResult.dNsPerOp);
+						}
+						else if (sKey == "gflops")
+						{
+							bOk = _ReadNumber(xResult.dGFlops);
+						}
+						else if (sKey == "bytes_allocated_per_op")
+						{
+							bOk = _ReadNumber(xResult.dBytesAllocatedPerOp);
+						}
+						else if (sKey == "allocations_per_op")
+						{
+							bOk = _ReadNumber(xResult.dAllocationsPerOp);
+						}
+						else
+						{
+							bOk = _SkipValue();
+						}
+
+						if (!bOk)
+						{
+							return false;
+						}
+					} while (_Accept(','));
+
+					if (!_Accept('}'))
+					{
+						return false;
+					}
+
+					vecResult.push_back(std::move(xResult));
+				} while (_Accept(','));
+
+				return _Accept(']');
+			}
+
+			char _Peek()
+			{
+				while (m_nPos < m_sText.size() && isspace((unsigned char)m_sText[m_nPos]))
+				{
+					++m_nPos;
+				}
+
+				return (m_nPos < m_sText.size() ? m_sText[m_nPos] : '\0');
+			}
+
+			bool _Accept(char cChar)
+			{
+				if (_Peek() != cChar)
+				{
+					return false;
+				}
+
+				++m_nPos;
+				return true;
+			}
+
+			bool _ReadString(std::string& sValue)
+			{
+				sValue.clear();
+				if (!_Accept('"'))
+				{
+					return false;
+				}
+
+				while (m_nPos < m_sText.size())
+				{
+					char cChar = m_sText[m_nPos++];
+					if (cChar == '"')
+					{
+						return true;
+					}
+
+					if (cChar == '\\')
+					{
+						if (m_nPos >= m_sText.size())
+						{
+							return false;
+						}
+
+						cChar = m_sText[m_nPos++];
+						switch (cChar)
+						{
+						case 'n': cChar = '\n'; break;
+						case 't': cChar = '\t'; break;
+						case 'r': cChar = '\r'; break;
+						case 'u': return false;
+						default: break;
+						}
+					}
+
+					sValue += cChar;
+				}
+
+				return false;
+			}
+
+			bool _ReadNumber(double& dValue)
+			{
+				_Peek();
+				const char* pcStart = m_sText.c_str() + m_nPos;
+				char* pcEnd = nullptr;
+				dValue = strtod(pcStart, &pcEnd);
+				if (pcEnd == pcStart)
+				{
+					return false;
+				}
+
+				m_nPos += size_t(pcEnd - pcStart);
+				return true;
+			}
+
+			bool _SkipValue()
+			{
+				const char cChar = _Peek();
+				if (cChar == '"')
+				{
+					std::string sValue;
+					return _ReadString(sValue);
+				}
+
+				if (cChar == '{' || cChar == '[')
+				{
+					const char cClose = (cChar == '{' ? '}' : ']');
+					++m_nPos;
+					if (_Accept(cClose))
+					{
+						return true;
+					}
+
+					do
+					{
+						if (cChar == '{')
+						{
+							std::string sKey;
+							if (!_ReadString(sKey) || !_Accept(':'))
+							{
+								return false;
+							}
+						}
+
+						if (!_SkipValue())
+						{
+							return false;
+						}
+					} while (_Accept(','));
+
+					return _Accept(cClose);
+				}
+
+				for (const char* pcWord : { "true", "false", "null" })
+				{
+					const size_t nLen = strlen(pcWord);
+					if (m_sText.compare(m_nPos, nLen, pcWord) == 0)
+					{
+						m_nPos += nLen;
+						return true;
+					}
+				}
+
+				double dValue;
+				return _ReadNumber(dValue);
+			}
+
+		protected:
+			const std::string& m_sText;
+			size_t m_nPos;
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Reads benchmark results from a JSON file written by WriteJson(). </summary>
+		///
+		/// <returns>	False if the file cannot be opened or parsed. </returns>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline bool ReadJsonFile(const std::string& sFilename, std::vector<SResult>& vecResult)
+		{
+			std::ifstream xIn(sFilename);
+			if (!xIn)
+			{
+				return false;
+			}
+
+			std::stringstream xText;
+			xText << xIn.rdbuf();
+
+			const std::string sText = xText.str();
+			return CJsonResultReader(sText).Read(vecResult);
+		}
+#pragma endregion
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Compares benchmark results with a baseline. A benchmark regresses if it is slower than its baseline by more
+		/// 	than the relative threshold. Benchmarks without baseline are listed but never count as regression.
+		/// </summary>
+		///
+		/// <param name="vecCmp">	   	[out] The comparison per current result. </param>
+		/// <param name="vecBaseline"> 	The baseline results. </param>
+		/// <param name="vecResult">   	The current results. </param>
+		/// <param name="dThreshold">  	The relative threshold, e.g. 0.1 for 10%. </param>
+		///
+		/// <returns>	The number of regressions. </returns>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline size_t Compare(std::vector<SComparison>& vecCmp, const std::vector<SResult>& vecBaseline
+			, const std::vector<SResult>& vecResult, double dThreshold)
+		{
+			size_t nRegressionCnt = 0;
+			vecCmp.clear();
+
+			for (const SResult& xResult : vecResult)
+			{
+				SComparison xCmp;
+				xCmp.sName = xResult.sName;
+				xCmp.dNsPerOp = xResult.dNsPerOp;
+
+				auto itBase = std::find_if(vecBaseline.begin(), vecBaseline.end(), [&](const SResult& xBase)
+				{
+					return xBase.sName == xResult.sName;
+				});
+
+				if (itBase != vecBaseline.end() && itBase->dNsPerOp > 0.0)
+				{
+					xCmp.bHasBaseline = true;
+					xCmp.dBaselineNsPerOp = itBase->dNsPerOp;
+					xCmp.dRatio = xResult.dNsPerOp / itBase->dNsPerOp;
+					xCmp.bIsRegression = (xCmp.dRatio > 1.0 + dThreshold);
+
+					if (xCmp.bIsRegression)
+					{
+						++nRegressionCnt;
+					}
+				}
+
+				vecCmp.push_back(std::move(xCmp));
+			}
+
+			return nRegressionCnt;
+		}
+
+		inline void PrintComparison(std::ostream& xOut, const std::vector<SComparison>& vecCmp)
+		{
+			for (const SComparison& xCmp : vecCmp)
+			{
+				xOut << std::left << std::setw(56) << xCmp.sName << std::right << std::fixed << std::setprecision(1);
+				if (xCmp.bHasBaseline)
+				{
+					xOut << std::setw(14) << xCmp.dBaselineNsPerOp << " ->" << std::setw(14) << xCmp.dNsPerOp << " ns"
+						<< std::setw(10) << std::showpos << std::setprecision(1) << 100.0 * (xCmp.dRatio - 1.0) << std::noshowpos << "%"
+						<< (xCmp.bIsRegression ? "  REGRESSION" : "") << std::endl;
+				}
+				else
+				{
+					xOut << std::setw(14) << "-" << " ->" << std::setw(14) << xCmp.dNsPerOp << " ns  (no baseline)" << std::endl;
+				}
+			}
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Parses the command line of a benchmark executable. Supported arguments are
+		/// 	--filter text, --min-time seconds, --repeat count, --out file.json, --compare baseline.json, --threshold ratio.
+		/// </summary>
+		///
+		/// <returns>	False on an unknown or incomplete argument. </returns>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline bool ParseCommandLine(SOptions& xOptions, int iArgCnt, char* ppcArg[])
+		{
+			for (int iArgIdx = 1; iArgIdx < iArgCnt; ++iArgIdx)
+			{
+				const std::string sArg = ppcArg[iArgIdx];
+				if (iArgIdx + 1 >= iArgCnt)
+				{
+					return false;
+				}
+
+				const char* pcValue = ppcArg[++iArgIdx];
+				if (sArg == "--filter")
+				{
+					xOptions.sFilter = pcValue;
+				}
+				else if (sArg == "--min-time")
+				{
+					xOptions.dMinTime = atof(pcValue);
+				}
+				else if (sArg == "--repeat")
+				{
+					xOptions.uRepeatCount = unsigned(atoi(pcValue));
+				}
+				else if (sArg == "--out")
+				{
+					xOptions.sOutputFile = pcValue;
+				}
+				else if (sArg == "--compare")
+				{
+					xOptions.sBaselineFile = pcValue;
+				}
+				else if (sArg == "--threshold")
+				{
+					xOptions.dThreshold = atof(pcValue);
+				}
+				else
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Implements the main function of a benchmark executable: parses the command line, runs the benchmarks, writes
+		/// 	the JSON output and compares with the baseline.
+		/// </summary>
+		///
+		/// <typeparam name="FuncRun">	Function of type void(CRunner&amp;) that runs all benchmarks of the suite. </typeparam>
+		///
+		/// <returns>	0 on success, 1 if regressions were found, 2 on an error. </returns>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename FuncRun>
+		int Main(int iArgCnt, char* ppcArg[], const std::string& sSuite, FuncRun funcRun)
+		{
+			SOptions xOptions;
+			if (!ParseCommandLine(xOptions, iArgCnt, ppcArg))
+			{
+				std::cerr << "Usage: " << ppcArg[0] << " [--filter text] [--min-time sec] [--repeat n]"
+					" [--out file.json] [--compare baseline.json] [--threshold ratio]" << std::endl;
+				return 2;
+			}
+
+			std::vector<SResult> vecBaseline;
+			if (!xOptions.sBaselineFile.empty() && !ReadJsonFile(xOptions.sBaselineFile, vecBaseline))
+			{
+				std::cerr << "Error reading baseline '" << xOptions.sBaselineFile << "'" << std::endl;
+				return 2;
+			}
+
+			CRunner xRunner(xOptions);
+			try
+			{
+				funcRun(xRunner);
+			}
+			catch (std::exception& xEx)
+			{
+				std::cerr << "Benchmark failed: " << xEx.what() << std::endl;
+				return 2;
+			}
+
+			if (!xOptions.sOutputFile.empty())
+			{
+				std::ofstream xOut(xOptions.sOutputFile);
+				if (!xOut)
+				{
+					std::cerr << "Error writing '" << xOptions.sOutputFile << "'" << std::endl;
+					return 2;
+				}
+
+				WriteJson(xOut, sSuite, xRunner.Results());
+			}
+			else
+			{
+				WriteJson(std::cout, sSuite, xRunner.Results());
+			}
+
+			if (xOptions.sBaselineFile.empty())
+			{
+				return 0;
+			}
+
+			std::vector<SComparison> vecCmp;
+			const size_t nRegressionCnt = Compare(vecCmp, vecBaseline, xRunner.Results(), xOptions.dThreshold);
+
+			std::cout << std::endl << "Comparison with '" << xOptions.sBaselineFile << "'" << std::endl;
+			PrintComparison(std::cout, vecCmp);
+			std::cout << nRegressionCnt << " regression(s) above " << 100.0 * xOptions.dThreshold << "%" << std::endl;
+
+			return (nRegressionCnt > 0 ? 1 : 0);
+		}
+	} // namespace Benchmark
+} // namespace Clu
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// <summary>
+/// 	Replaces the global allocation operators with versions that update Clu::Benchmark::CAllocationCounter. Use in
+/// 	exactly one translation unit of a benchmark executable, at global scope.
+/// </summary>
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define CLU_BENCHMARK_TRACK_ALLOCATIONS() \
+	void* operator new(size_t nSize) \
+	{ \
+		Clu::Benchmark::CAllocationCounter::Add(nSize); \
+		void* pData = malloc(nSize > 0 ? nSize : 1); \
+		if (pData == nullptr) throw std::bad_alloc(); \
+		return pData; \
+	} \
+	void* operator new[](size_t nSize) \
+	{ \
+		return operator new(nSize); \
+	} \
+	void operator delete(void* pData) noexcept \
+	{ \
+		free(pData); \
+	} \
+	void operator delete[](void* pData) noexcept \
+	{ \
+		free(pData); \
+	} \
+	void operator delete(void* pData, size_t) noexcept \
+	{ \
+		free(pData); \
+	} \
+	void operator delete[](void* pData, size_t) noexcept \
+	{ \
+		free(pData); \
+	}
@@ -187,6 +187,39 @@ namespace Clu
 			return false;
 		}
 
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Query whether the processor supports AVX2 and the operating system saves the 256 bit registers. Code
+		/// 	compiled with /arch:AVX2 may only run if this returns true. The processor is queried once.
+		/// </summary>
+		///
+		/// <returns> True if AVX2 instructions can be executed. </returns>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline bool HasAvx2()
+		{
+			static const bool s_bHasAvx2 = []()
+			{
+				int piInfo[4];
+				__cpuid(piInfo, 0);
+				if (piInfo[0] < 7)
+				{
+					return false;
+				}
+
+				// AVX and OSXSAVE, and the XMM and YMM state enabled in XCR0.
+				__cpuid(piInfo, 1);
+				if ((piInfo[2] & (1 << 27)) == 0 || (piInfo[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+				{
+					return false;
+				}
+
+				__cpuidex(piInfo, 7, 0);
+				return (piInfo[1] & (1 << 5)) != 0;
+			}();
+
+			return s_bHasAvx2;
+		}
+
 
 	}
 }
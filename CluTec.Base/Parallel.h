@@ -0,0 +1,352 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Base
+// file:      Parallel.h
+//
+// summary:   Declares the parallel helper functions
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// namespace: Clu.Parallel
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace Clu
+{
+	namespace Parallel
+	{
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Returns the number of threads the parallel helpers use at most.
+		/// </summary>
+		///
+		/// <returns> The number of hardware threads, at least one. </returns>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline unsigned ThreadCount()
+		{
+			unsigned uCount = std::thread::hardware_concurrency();
+			return (uCount == 0 ? 1u : uCount);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Returns the number of blocks ForEachBlock() splits a range of the given size into. Use this to allocate per
+		/// 	block accumulators before calling ForEachBlock().
+		/// </summary>
+		///
+		/// <param name="nCount">		  Number of elements in the range. </param>
+		/// <param name="nMinBlockSize"> The minimal number of elements per block. </param>
+		/// <param name="uMaxBlocks">	  The maximal number of blocks. If zero, ThreadCount() is used. </param>
+		///
+		/// <returns> The number of blocks. </returns>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline unsigned BlockCount(size_t nCount, size_t nMinBlockSize, unsigned uMaxBlocks = 0)
+		{
+			if (nCount == 0)
+			{
+				return 0;
+			}
+
+			if (uMaxBlocks == 0)
+			{
+				uMaxBlocks = ThreadCount();
+			}
+
+			size_t nBlocks = nCount / std::max<size_t>(nMinBlockSize, 1);
+			nBlocks = std::max<size_t>(nBlocks, 1);
+			nBlocks = std::min<size_t>(nBlocks, uMaxBlocks);
+
+			return unsigned(nBlocks);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	A pool of persistent worker threads, which process the blocks of jobs. The thread that runs a job also
+		/// 	processes its blocks, so that a job completes even if all workers are busy. This allows jobs to be run
+		/// 	from within the blocks of other jobs.
+		/// </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CThreadPool
+		{
+		public:
+			/// <summary>	Starts the given number of worker threads. </summary>
+			explicit CThreadPool(unsigned uWorkerCount)
+				: m_bStop(false)
+			{
+				m_vecWorker.reserve(uWorkerCount);
+				for (unsigned uWorkerIdx = 0; uWorkerIdx < uWorkerCount; ++uWorkerIdx)
+				{
+					m_vecWorker.emplace_back(&CThreadPool::_WorkerLoop, this);
+				}
+			}
+
+			CThreadPool(const CThreadPool&) = delete;
+			CThreadPool& operator=(const CThreadPool&) = delete;
+
+			~CThreadPool()
+			{
+				{
+					std::lock_guard<std::mutex> xLock(m_mxQueue);
+					m_bStop = true;
+				}
+				m_cvWork.notify_all();
+
+				for (std::thread& xWorker : m_vecWorker)
+				{
+					xWorker.join();
+				}
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	The pool of the parallel helpers with ThreadCount() - 1 workers. It is created on first use and never
+			/// 	destroyed, since joining threads while a process or module unloads can dead lock.
+			/// </summary>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			static CThreadPool& Global()
+			{
+				static CThreadPool* s_pPool = new CThreadPool(ThreadCount() - 1);
+				return *s_pPool;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Calls funcBlock(uBlockIdx) for each block in [0, uBlockCount) and returns when all blocks are done. The
+			/// 	operator must not throw.
+			/// </summary>
+			///
+			/// <param name="uBlockCount"> Number of blocks. </param>
+			/// <param name="funcBlock">   The block operator. </param>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			void Run(unsigned uBlockCount, const std::function<void(unsigned)>& funcBlock)
+			{
+				SJob xJob(uBlockCount, funcBlock);
+
+				{
+					std::lock_guard<std::mutex> xLock(m_mxQueue);
+					m_dqJob.push_back(&xJob);
+				}
+				m_cvWork.notify_all();
+
+				std::unique_lock<std::mutex> xLock(m_mxQueue);
+				unsigned uBlockIdx;
+				while (_NextBlock(xJob, uBlockIdx))
+				{
+					_RunBlock(xLock, xJob, uBlockIdx);
+				}
+
+				m_cvDone.wait(xLock, [&xJob]() { return xJob.uDoneCount == xJob.uBlockCount; });
+			}
+
+		private:
+			struct SJob
+			{
+				SJob(unsigned _uBlockCount, const std::function<void(unsigned)>& _funcBlock)
+					: uBlockCount(_uBlockCount)
+					, uNextBlock(0)
+					, uDoneCount(0)
+					, funcBlock(_funcBlock)
+				{
+				}
+
+				const unsigned uBlockCount;
+				unsigned uNextBlock;
+				unsigned uDoneCount;
+				const std::function<void(unsigned)>& funcBlock;
+			};
+
+			// Claims the next block of the job while the queue is locked. The job leaves the queue with its last block.
+			bool _NextBlock(SJob& xJob, unsigned& uBlockIdx)
+			{
+				if (xJob.uNextBlock == xJob.uBlockCount)
+				{
+					return false;
+				}
+
+				uBlockIdx = xJob.uNextBlock++;
+				if (xJob.uNextBlock == xJob.uBlockCount)
+				{
+					m_dqJob.erase(std::find(m_dqJob.begin(), m_dqJob.end(), &xJob));
+				}
+
+				return true;
+			}
+
+			// Runs a block with the queue unlocked. The job stays alive until its last block is counted as done.
+			void _RunBlock(std::unique_lock<std::mutex>& xLock, SJob& xJob, unsigned uBlockIdx)
+			{
+				xLock.unlock();
+				xJob.funcBlock(uBlockIdx);
+				xLock.lock();
+
+				if (++xJob.uDoneCount == xJob.uBlockCount)
+				{
+					m_cvDone.notify_all();
+				}
+			}
+
+			void _WorkerLoop()
+			{
+				std::unique_lock<std::mutex> xLock(m_mxQueue);
+				while (true)
+				{
+					m_cvWork.wait(xLock, [this]() { return m_bStop || !m_dqJob.empty(); });
+					if (m_bStop)
+					{
+						return;
+					}
+
+					SJob& xJob = *m_dqJob.front();
+					unsigned uBlockIdx;
+					if (_NextBlock(xJob, uBlockIdx))
+					{
+						_RunBlock(xLock, xJob, uBlockIdx);
+					}
+				}
+			}
+
+		private:
+			std::vector<std::thread> m_vecWorker;
+			std::deque<SJob*> m_dqJob;
+			std::mutex m_mxQueue;
+			std::condition_variable m_cvWork;
+			std::condition_variable m_cvDone;
+			bool m_bStop;
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Splits the range [0, nCount) into BlockCount() contiguous blocks of nearly equal size and calls
+		/// 	funcOp(nBegin, nEnd, uBlockIdx) for each block on the global thread pool, whose workers share the blocks with
+		/// 	the calling thread. If an operator throws, the first exception is re-thrown after all blocks have finished.
+		/// </summary>
+		///
+		/// <typeparam name="FuncOp"> Type of the block operator. </typeparam>
+		/// <param name="nCount">		  Number of elements in the range. </param>
+		/// <param name="nMinBlockSize"> The minimal number of elements per block. </param>
+		/// <param name="funcOp">		  The block operator. </param>
+		/// <param name="uMaxBlocks">	  The maximal number of blocks. If zero, ThreadCount() is used. </param>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename FuncOp>
+		void ForEachBlock(size_t nCount, size_t nMinBlockSize, FuncOp funcOp, unsigned uMaxBlocks = 0)
+		{
+			const unsigned uBlockCount = BlockCount(nCount, nMinBlockSize, uMaxBlocks);
+			if (uBlockCount == 0)
+			{
+				return;
+			}
+
+			if (uBlockCount == 1)
+			{
+				funcOp(size_t(0), nCount, 0u);
+				return;
+			}
+
+			std::exception_ptr xError;
+			std::mutex mxError;
+
+			auto funcBlock = [&](unsigned uBlockIdx)
+			{
+				const size_t nBegin = (nCount * uBlockIdx) / uBlockCount;
+				const size_t nEnd = (nCount * (uBlockIdx + 1)) / uBlockCount;
+
+				try
+				{
+					funcOp(nBegin, nEnd, uBlockIdx);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> xLock(mxError);
+					if (!xError)
+					{
+						xError = std::current_exception();
+					}
+				}
+			};
+
+			CThreadPool::Global().Run(uBlockCount, funcBlock);
+
+			if (xError)
+			{
+				std::rethrow_exception(xError);
+			}
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Calls funcOp(nIdx) for each index in [0, nCount), distributing contiguous blocks of indices over threads.
+		/// </summary>
+		///
+		/// <typeparam name="FuncOp"> Type of the element operator. </typeparam>
+		/// <param name="nCount">		  Number of elements. </param>
+		/// <param name="nMinBlockSize"> The minimal number of elements per thread. </param>
+		/// <param name="funcOp">		  The element operator. </param>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename FuncOp>
+		void ForEachIndex(size_t nCount, size_t nMinBlockSize, FuncOp funcOp)
+		{
+			ForEachBlock(nCount, nMinBlockSize, [&funcOp](size_t nBegin, size_t nEnd, unsigned)
+			{
+				for (size_t nIdx = nBegin; nIdx < nEnd; ++nIdx)
+				{
+					funcOp(nIdx);
+				}
+			});
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Calls funcOp(nTaskIdx, uThreadIdx) for each task in [0, nTaskCount). Tasks are handed out dynamically to
+		/// 	the threads, which balances tasks of different cost, e.g. image tiles. The thread index is smaller than
+		/// 	BlockCount(nTaskCount, 1, uMaxThreads) and can be used to address per thread scratch memory.
+		/// </summary>
+		///
+		/// <typeparam name="FuncOp"> Type of the task operator. </typeparam>
+		/// <param name="nTaskCount">  Number of tasks. </param>
+		/// <param name="funcOp">	   The task operator. </param>
+		/// <param name="uMaxThreads"> The maximal number of threads. If zero, ThreadCount() is used. </param>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename FuncOp>
+		void ForEachTask(size_t nTaskCount, FuncOp funcOp, unsigned uMaxThreads = 0)
+		{
+			std::atomic<size_t> nNextTask(0);
+
+			ForEachBlock(nTaskCount, 1, [&](size_t, size_t, unsigned uThreadIdx)
+			{
+				for (size_t nTaskIdx = nNextTask++; nTaskIdx < nTaskCount; nTaskIdx = nNextTask++)
+				{
+					funcOp(nTaskIdx, uThreadIdx);
+				}
+			}, uMaxThreads);
+		}
+	} // namespace Parallel
+} // namespace Clu
@@ -0,0 +1,639 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Bench
+// file:      ImgProcBench.cpp
+//
+// summary:   Benchmarks of the CluTec.ImgProc image kernels
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "stdafx.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "CluTec.Base/Benchmark.h"
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Codec.h"
+#include "CluTec.ImgProc/Image.Convert.h"
+#include "CluTec.ImgProc/Image.Demosaic.h"
+#include "CluTec.ImgProc/Image.Filter.h"
+#include "CluTec.ImgProc/Image.Integral.h"
+#include "CluTec.ImgProc/Image.Label.h"
+#include "CluTec.ImgProc/Image.Median.h"
+#include "CluTec.ImgProc/Image.Morphology.h"
+#include "CluTec.ImgProc/Image.Pyramid.h"
+#include "CluTec.ImgProc/Image.Remap.h"
+#include "CluTec.ImgProc/Image.Statistics.h"
+#include "CluTec.ImgProc/Image.View.h"
+
+CLU_BENCHMARK_TRACK_ALLOCATIONS()
+
+namespace
+{
+	using Clu::Benchmark::CRunner;
+	using Clu::Benchmark::DoNotOptimize;
+
+	// The benchmarks pass the pixel count as the nominal operation count per call, so the GFLOP/s column reports
+	// the throughput in gigapixels per second.
+
+	struct SSize
+	{
+		int iWidth;
+		int iHeight;
+	};
+
+	const SSize ImageSizes[] = { { 1920, 1080 }, { 4096, 3072 } };
+
+	std::string SizeName(const SSize& xSize)
+	{
+		return std::to_string(xSize.iWidth) + "x" + std::to_string(xSize.iHeight);
+	}
+
+	const char* DataTypeName(Clu::EDataType eDataType)
+	{
+		switch (eDataType)
+		{
+		case Clu::EDataType::UInt8:
+			return "UInt8";
+		case Clu::EDataType::UInt16:
+			return "UInt16";
+		case Clu::EDataType::Single:
+			return "Single";
+		default:
+			return "Other";
+		}
+	}
+
+	const char* PixelTypeName(Clu::EPixelType ePixelType)
+	{
+		switch (ePixelType)
+		{
+		case Clu::EPixelType::RGB:
+			return "RGB";
+		case Clu::EPixelType::RGBA:
+			return "RGBA";
+		case Clu::EPixelType::BGR:
+			return "BGR";
+		case Clu::EPixelType::BGRA:
+			return "BGRA";
+		case Clu::EPixelType::Lum:
+			return "Lum";
+		case Clu::EPixelType::BayerRG:
+			return "BayerRG";
+		default:
+			return "Other";
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>	Creates an image filled with reproducible values that vary smoothly with some noise. </summary>
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Clu::CIImage MakeImage(const Clu::SImageFormat& xFormat)
+	{
+		Clu::CIImage imgA(xFormat);
+
+		unsigned char* puData = (unsigned char*)imgA.DataPointer();
+		const size_t nByteCount = xFormat.RowPitch() * size_t(xFormat.iHeight);
+
+		unsigned uState = 12345u;
+		for (size_t nIdx = 0; nIdx < nByteCount; ++nIdx)
+		{
+			uState = uState * 1664525u + 1013904223u;
+			puData[nIdx] = (unsigned char)((nIdx / 7) + (uState >> 28));
+		}
+
+		return imgA;
+	}
+
+	void BenchDemosaic(CRunner& xRunner)
+	{
+		const char* const pcMethod[] = { "Bilinear", "EdgeAware", "HalfResolution" };
+
+		for (const SSize& xSize : ImageSizes)
+		{
+			for (Clu::EDataType eDataType : { Clu::EDataType::UInt8, Clu::EDataType::UInt16 })
+			{
+				const Clu::CIImage imgSrc = MakeImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, Clu::EPixelType::BayerRG, eDataType));
+
+				for (int iMethod = 0; iMethod < 3; ++iMethod)
+				{
+					for (Clu::EPixelType ePixelType : { Clu::EPixelType::RGB, Clu::EPixelType::BGRA })
+					{
+						const Clu::ImgProc::EDemosaicMethod eMethod = Clu::ImgProc::EDemosaicMethod(iMethod);
+						Clu::CIImage imgTrg;
+
+						const std::string sName = std::string("Demosaic/") + pcMethod[iMethod] + "/" + DataTypeName(eDataType)
+							+ "/" + PixelTypeName(ePixelType) + "/" + SizeName(xSize);
+
+						xRunner.Run(sName, double(xSize.iWidth) * double(xSize.iHeight), [&]()
+						{
+							Clu::ImgProc::Demosaic(imgTrg, imgSrc, eMethod, ePixelType);
+							DoNotOptimize(imgTrg);
+						});
+					}
+				}
+			}
+		}
+	}
+
+	void BenchConvert(CRunner& xRunner)
+	{
+		struct SCase
+		{
+			Clu::EPixelType eSrcPixelType;
+			Clu::EDataType eSrcDataType;
+			Clu::EPixelType eTrgPixelType;
+			Clu::EDataType eTrgDataType;
+		};
+
+		const SCase pCase[] =
+		{
+			{ Clu::EPixelType::RGB, Clu::EDataType::UInt8, Clu::EPixelType::Lum, Clu::EDataType::UInt8 },
+			{ Clu::EPixelType::BGRA, Clu::EDataType::UInt8, Clu::EPixelType::RGBA, Clu::EDataType::UInt8 },
+			{ Clu::EPixelType::RGB, Clu::EDataType::UInt8, Clu::EPixelType::RGBA, Clu::EDataType::Single },
+			{ Clu::EPixelType::Lum, Clu::EDataType::UInt16, Clu::EPixelType::Lum, Clu::EDataType::Single },
+		};
+
+		const SSize& xSize = ImageSizes[0];
+		for (const SCase& xCase : pCase)
+		{
+			const Clu::CIImage imgSrc = MakeImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, xCase.eSrcPixelType, xCase.eSrcDataType));
+			Clu::CIImage imgTrg;
+
+			const std::string sName = std::string("ConvertImage/") + PixelTypeName(xCase.eSrcPixelType) + DataTypeName(xCase.eSrcDataType)
+				+ "/" + PixelTypeName(xCase.eTrgPixelType) + DataTypeName(xCase.eTrgDataType) + "/" + SizeName(xSize);
+
+			xRunner.Run(sName, double(xSize.iWidth) * double(xSize.iHeight), [&]()
+			{
+				Clu::ImgProc::ConvertImage(imgTrg, imgSrc, xCase.eTrgPixelType, xCase.eTrgDataType);
+				DoNotOptimize(imgTrg);
+			});
+		}
+	}
+
+	void BenchFilter(CRunner& xRunner)
+	{
+		struct SCase
+		{
+			const char* pcName;
+			Clu::ImgProc::SFilterKernel xKernel;
+			Clu::EDataType eTrgDataType;
+		};
+
+		const SCase pCase[] =
+		{
+			{ "Gaussian1", Clu::ImgProc::GaussianKernel(1.0), Clu::EDataType::Unknown },
+			{ "Gaussian3", Clu::ImgProc::GaussianKernel(3.0), Clu::EDataType::Unknown },
+			{ "Box2", Clu::ImgProc::BoxKernel(2), Clu::EDataType::Unknown },
+			{ "SobelX", Clu::ImgProc::SobelKernel(1, 0), Clu::EDataType::Single },
+			{ "General5x5", Clu::ImgProc::GeneralKernel(5, 5, std::vector<float>(25, 1.0f / 25.0f)), Clu::EDataType::Unknown },
+		};
+
+		const SSize& xSize = ImageSizes[0];
+		for (Clu::EPixelType ePixelType : { Clu::EPixelType::Lum, Clu::EPixelType::RGBA })
+		{
+			for (Clu::EDataType eDataType : { Clu::EDataType::UInt8, Clu::EDataType::UInt16, Clu::EDataType::Single })
+			{
+				const Clu::CIImage imgSrc = MakeImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, ePixelType, eDataType));
+
+				for (const SCase& xCase : pCase)
+				{
+					Clu::CIImage imgTrg;
+
+					const std::string sName = std::string("Filter/") + xCase.pcName + "/" + PixelTypeName(ePixelType) + DataTypeName(eDataType)
+						+ "/" + SizeName(xSize);
+
+					xRunner.Run(sName, double(xSize.iWidth) * double(xSize.iHeight), [&]()
+					{
+						Clu::ImgProc::FilterImage(imgTrg, imgSrc, xCase.xKernel, Clu::ImgProc::EBorderMode::Mirror, xCase.eTrgDataType);
+						DoNotOptimize(imgTrg);
+					});
+				}
+			}
+		}
+	}
+
+	void BenchPyramid(CRunner& xRunner)
+	{
+		const char* const pcFilter[] = { "Box2x2", "Gaussian5", "Area" };
+
+		struct SCase
+		{
+			Clu::EPixelType ePixelType;
+			Clu::EDataType eDataType;
+		};
+
+		const SCase pCase[] =
+		{
+			{ Clu::EPixelType::Lum, Clu::EDataType::UInt8 },
+			{ Clu::EPixelType::RGBA, Clu::EDataType::UInt8 },
+			{ Clu::EPixelType::Lum, Clu::EDataType::UInt16 },
+			{ Clu::EPixelType::Lum, Clu::EDataType::Single },
+		};
+
+		const SSize& xSize = ImageSizes[1];
+		for (const SCase& xCase : pCase)
+		{
+			Clu::CIImage imgBase = MakeImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, xCase.ePixelType, xCase.eDataType));
+
+			for (int iFilter = 0; iFilter < 3; ++iFilter)
+			{
+				Clu::ImgProc::CImagePyramid xPyramid;
+				xPyramid.Create(imgBase, 0, Clu::ImgProc::EPyramidFilter(iFilter));
+
+				const std::string sName = std::string("Pyramid/") + pcFilter[iFilter] + "/" + PixelTypeName(xCase.ePixelType)
+					+ DataTypeName(xCase.eDataType) + "/" + SizeName(xSize);
+
+				// The pixel count of all reduced levels is about a third of the base image.
+				xRunner.Run(sName + "/Full", double(xSize.iWidth) * double(xSize.iHeight) / 3.0, [&]()
+				{
+					xPyramid.Update();
+					DoNotOptimize(xPyramid);
+				});
+
+				xRunner.Run(sName + "/Rect64", 64.0 * 64.0 / 3.0, [&]()
+				{
+					xPyramid.Update(xSize.iWidth / 2, xSize.iHeight / 2, 64, 64);
+					DoNotOptimize(xPyramid);
+				});
+			}
+		}
+	}
+	void BenchRemap(CRunner& xRunner)
+	{
+		const char* const pcInterpolation[] = { "Nearest", "Bilinear", "Bicubic" };
+
+		struct SCase
+		{
+			Clu::EPixelType ePixelType;
+			Clu::EDataType eDataType;
+		};
+
+		const SCase pCase[] =
+		{
+			{ Clu::EPixelType::Lum, Clu::EDataType::UInt8 },
+			{ Clu::EPixelType::RGBA, Clu::EDataType::UInt8 },
+			{ Clu::EPixelType::Lum, Clu::EDataType::UInt16 },
+			{ Clu::EPixelType::Lum, Clu::EDataType::Single },
+		};
+
+		const SSize& xSize = ImageSizes[0];
+
+		// A radial distortion about the image center, as for the undistortion of a wide angle lens.
+		const double dCenterX = 0.5 * double(xSize.iWidth);
+		const double dCenterY = 0.5 * double(xSize.iHeight);
+		const double dNorm = 1.0 / (dCenterX * dCenterX);
+
+		Clu::ImgProc::CRemapLut xLut;
+		xLut.Create(xSize.iWidth, xSize.iHeight, [&](double& dX, double& dY, int iX, int iY)
+		{
+			const double dRelX = double(iX) - dCenterX;
+			const double dRelY = double(iY) - dCenterY;
+			const double dScale = 1.0 - 0.1 * (dRelX * dRelX + dRelY * dRelY) * dNorm;
+
+			dX = dCenterX + dScale * dRelX;
+			dY = dCenterY + dScale * dRelY;
+			return true;
+		});
+
+		for (const SCase& xCase : pCase)
+		{
+			const Clu::CIImage imgSrc = MakeImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, xCase.ePixelType, xCase.eDataType));
+
+			for (int iInterpolation = 0; iInterpolation < 3; ++iInterpolation)
+			{
+				const Clu::ImgProc::ERemapInterpolation eInterpolation = Clu::ImgProc::ERemapInterpolation(iInterpolation);
+				Clu::CIImage imgTrg;
+
+				const std::string sName = std::string("Remap/") + pcInterpolation[iInterpolation] + "/" + PixelTypeName(xCase.ePixelType)
+					+ DataTypeName(xCase.eDataType) + "/" + SizeName(xSize);
+
+				xRunner.Run(sName, double(xSize.iWidth) * double(xSize.iHeight), [&]()
+				{
+					Clu::ImgProc::RemapImage(imgTrg, imgSrc, xLut, eInterpolation);
+					DoNotOptimize(imgTrg);
+				});
+			}
+		}
+	}
+
+	void BenchStatistics(CRunner& xRunner)
+	{
+		const SSize& xSize = ImageSizes[1];
+		for (Clu::EPixelType ePixelType : { Clu::EPixelType::Lum, Clu::EPixelType::RGBA })
+		{
+			for (Clu::EDataType eDataType : { Clu::EDataType::UInt8, Clu::EDataType::UInt16, Clu::EDataType::Single })
+			{
+				const Clu::CIImage imgSrc = MakeImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, ePixelType, eDataType));
+
+				const std::string sName = std::string("Statistics/") + PixelTypeName(ePixelType) + DataTypeName(eDataType)
+					+ "/" + SizeName(xSize);
+
+				std::vector<Clu::ImgProc::SChannelStatistics> vecStats;
+				xRunner.Run(sName, double(xSize.iWidth) * double(xSize.iHeight), [&]()
+				{
+					Clu::ImgProc::ComputeStatistics(vecStats, imgSrc);
+					DoNotOptimize(vecStats);
+				});
+
+				// With a given range the histogram of floating point images is counted in the same pass as the moments.
+				const Clu::ImgProc::SStatisticsConfig xConfig(256, 0.0, 256.0);
+				xRunner.Run(sName + "/Range", double(xSize.iWidth) * double(xSize.iHeight), [&]()
+				{
+					Clu::ImgProc::ComputeStatistics(vecStats, imgSrc, xConfig);
+					DoNotOptimize(vecStats);
+				});
+			}
+		}
+	}
+
+	void BenchView(CRunner& xRunner)
+	{
+		using TPixelRGBA = Clu::TPixel_RGBA_UInt8;
+		using TPixelLum = Clu::TPixel_Lum_Single;
+
+		for (const SSize& xSize : ImageSizes)
+		{
+			const Clu::CIImage imgSrc = MakeImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, Clu::EPixelType::RGBA, Clu::EDataType::UInt8));
+			Clu::CIImage imgTrg(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, Clu::EPixelType::Lum, Clu::EDataType::Single));
+
+			const Clu::ImgProc::CImageView<const TPixelRGBA> viewSrc(imgSrc);
+			const Clu::ImgProc::CImageView<TPixelLum> viewTrg(imgTrg);
+
+			xRunner.Run("View/Transform/RGBAUInt8-LumSingle/" + SizeName(xSize), double(xSize.iWidth) * double(xSize.iHeight), [&]()
+			{
+				Clu::ImgProc::Transform(viewTrg, viewSrc, [](const TPixelRGBA& xPixel)
+				{
+					TPixelLum xLum;
+					xLum.pPixel[0] = 0.299f * float(xPixel.pPixel[0]) + 0.587f * float(xPixel.pPixel[1]) + 0.114f * float(xPixel.pPixel[2]);
+					return xLum;
+				});
+				DoNotOptimize(imgTrg);
+			});
+
+			xRunner.Run("View/ForEachPixel/LumSingle/" + SizeName(xSize), double(xSize.iWidth) * double(xSize.iHeight), [&]()
+			{
+				Clu::ImgProc::ForEachPixel(viewTrg, [](TPixelLum& xPixel)
+				{
+					xPixel.pPixel[0] = 0.5f * xPixel.pPixel[0] + 1.0f;
+				});
+				DoNotOptimize(imgTrg);
+			});
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Creates an image like those of a camera, with a smooth scene and a few bits of sensor noise. 16 bit images have
+	/// 	12 significant bits.
+	/// </summary>
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	Clu::CIImage MakeCameraImage(const Clu::SImageFormat& xFormat)
+	{
+		Clu::CIImage imgA(xFormat);
+
+		const bool bWide = (xFormat.eDataType == Clu::EDataType::UInt16);
+		const int iMaxValue = (bWide ? 4095 : 255);
+		const size_t nSampleCount = xFormat.RowByteCount() / (bWide ? 2 : 1);
+
+		unsigned uState = 12345u;
+		for (int iY = 0; iY < xFormat.iHeight; ++iY)
+		{
+			unsigned char* puRow = (unsigned char*)imgA.DataPointer() + size_t(iY) * xFormat.RowPitch();
+			for (size_t nIdx = 0; nIdx < nSampleCount; ++nIdx)
+			{
+				uState = uState * 1664525u + 1013904223u;
+
+				const int iScene = int((nIdx * 3 + size_t(iY) * 2) % size_t(2 * iMaxValue));
+				const int iValue = std::min(std::abs(iScene - iMaxValue) + int(uState >> 29) - 4, iMaxValue);
+
+				if (bWide)
+				{
+					((uint16_t*)puRow)[nIdx] = uint16_t(std::max(iValue, 0));
+				}
+				else
+				{
+					puRow[nIdx] = uint8_t(std::max(iValue, 0));
+				}
+			}
+		}
+
+		return imgA;
+	}
+
+	void BenchCodec(CRunner& xRunner)
+	{
+		const char* const pcPredictor[] = { "Left", "Up", "Med" };
+
+		const SSize& xSize = ImageSizes[1];
+		for (Clu::EPixelType ePixelType : { Clu::EPixelType::Lum, Clu::EPixelType::BayerRG })
+		{
+			for (Clu::EDataType eDataType : { Clu::EDataType::UInt8, Clu::EDataType::UInt16 })
+			{
+				const Clu::CIImage imgSrc = MakeCameraImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, ePixelType, eDataType));
+				const double dPixelCount = double(xSize.iWidth) * double(xSize.iHeight);
+
+				for (int iPredictor = 0; iPredictor < 3; ++iPredictor)
+				{
+					const Clu::ImgProc::ECodecPredictor ePredictor = Clu::ImgProc::ECodecPredictor(iPredictor);
+					const std::string sName = std::string("Codec/") + pcPredictor[iPredictor] + "/" + PixelTypeName(ePixelType)
+						+ DataTypeName(eDataType) + "/" + SizeName(xSize);
+
+					Clu::ImgProc::CCompressedImage xCompressed;
+					xRunner.Run(sName + "/Compress", dPixelCount, [&]()
+					{
+						xCompressed.Compress(imgSrc, ePredictor);
+						DoNotOptimize(xCompressed);
+					});
+
+					Clu::CIImage imgTrg;
+					xRunner.Run(sName + "/Decompress", dPixelCount, [&]()
+					{
+						xCompressed.Decompress(imgTrg);
+						DoNotOptimize(imgTrg);
+					});
+				}
+			}
+		}
+	}
+
+	void BenchIntegral(CRunner& xRunner)
+	{
+		const SSize& xSize = ImageSizes[1];
+		for (Clu::EPixelType ePixelType : { Clu::EPixelType::Lum, Clu::EPixelType::RGBA })
+		{
+			for (Clu::EDataType eDataType : { Clu::EDataType::UInt8, Clu::EDataType::UInt16 })
+			{
+				const Clu::CIImage imgSrc = MakeImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, ePixelType, eDataType));
+				const double dPixelCount = double(xSize.iWidth) * double(xSize.iHeight);
+
+				const std::string sName = std::string("Integral/") + PixelTypeName(ePixelType) + DataTypeName(eDataType)
+					+ "/" + SizeName(xSize);
+
+				Clu::CIImage imgSum, imgSquaredSum;
+				xRunner.Run(sName + "/Sum", dPixelCount, [&]()
+				{
+					Clu::ImgProc::IntegralImage(imgSum, imgSrc);
+					DoNotOptimize(imgSum);
+				});
+
+				xRunner.Run(sName + "/SumSquared", dPixelCount, [&]()
+				{
+					Clu::ImgProc::IntegralImage(imgSum, imgSquaredSum, imgSrc);
+					DoNotOptimize(imgSquaredSum);
+				});
+
+				Clu::ImgProc::CIntegralImage xIntegral;
+				xIntegral.Create(imgSrc);
+
+				// The box filters take the same time for any radius.
+				Clu::CIImage imgTrg;
+				xRunner.Run(sName + "/BoxMean", dPixelCount, [&]()
+				{
+					Clu::ImgProc::BoxMean(imgTrg, xIntegral, 7, 7);
+					DoNotOptimize(imgTrg);
+				});
+
+				xRunner.Run(sName + "/BoxVariance", dPixelCount, [&]()
+				{
+					Clu::ImgProc::BoxVariance(imgTrg, xIntegral, 7, 7);
+					DoNotOptimize(imgTrg);
+				});
+			}
+		}
+	}
+
+	void BenchMorphology(CRunner& xRunner)
+	{
+		const SSize& xSize = ImageSizes[1];
+		for (Clu::EDataType eDataType : { Clu::EDataType::UInt8, Clu::EDataType::UInt16, Clu::EDataType::Single })
+		{
+			const Clu::CIImage imgSrc = MakeImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, Clu::EPixelType::Lum, eDataType));
+			const double dPixelCount = double(xSize.iWidth) * double(xSize.iHeight);
+
+			// The run time does not depend on the radius.
+			for (int iRadius : { 1, 15 })
+			{
+				const std::string sName = std::string("Morphology/Lum") + DataTypeName(eDataType) + "/" + SizeName(xSize)
+					+ "/R" + std::to_string(iRadius);
+
+				Clu::CIImage imgTrg;
+				xRunner.Run(sName + "/Erode", dPixelCount, [&]()
+				{
+					Clu::ImgProc::MorphImage(imgTrg, imgSrc, Clu::ImgProc::EMorphOp::Erode, iRadius, iRadius);
+					DoNotOptimize(imgTrg);
+				});
+
+				xRunner.Run(sName + "/Open", dPixelCount, [&]()
+				{
+					Clu::ImgProc::MorphImage(imgTrg, imgSrc, Clu::ImgProc::EMorphOp::Open, iRadius, iRadius);
+					DoNotOptimize(imgTrg);
+				});
+			}
+		}
+	}
+
+	void BenchMedian(CRunner& xRunner)
+	{
+		const SSize& xSize = ImageSizes[1];
+		for (Clu::EDataType eDataType : { Clu::EDataType::UInt8, Clu::EDataType::UInt16 })
+		{
+			const Clu::CIImage imgSrc = MakeCameraImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, Clu::EPixelType::Lum, eDataType));
+			const double dPixelCount = double(xSize.iWidth) * double(xSize.iHeight);
+
+			// Radius 1 and 2 use sorting networks, larger radii the constant time histograms.
+			for (int iRadius : { 1, 2, 3, 7 })
+			{
+				const std::string sName = std::string("Median/Lum") + DataTypeName(eDataType) + "/" + SizeName(xSize)
+					+ "/R" + std::to_string(iRadius);
+
+				Clu::CIImage imgTrg;
+				xRunner.Run(sName, dPixelCount, [&]()
+				{
+					Clu::ImgProc::MedianImage(imgTrg, imgSrc, Clu::ImgProc::SMedianConfig(iRadius));
+					DoNotOptimize(imgTrg);
+				});
+
+				xRunner.Run(sName + "/IgnoreInvalid", dPixelCount, [&]()
+				{
+					Clu::ImgProc::MedianImage(imgTrg, imgSrc, Clu::ImgProc::SMedianConfig(iRadius, 0.0));
+					DoNotOptimize(imgTrg);
+				});
+			}
+		}
+	}
+
+	void BenchLabel(CRunner& xRunner)
+	{
+		const SSize& xSize = ImageSizes[1];
+		const Clu::CIImage imgSrc = MakeCameraImage(Clu::SImageFormat(xSize.iWidth, xSize.iHeight, Clu::EPixelType::Lum, Clu::EDataType::UInt16));
+		const double dPixelCount = double(xSize.iWidth) * double(xSize.iHeight);
+
+		for (Clu::ImgProc::EConnectivity eConnectivity : { Clu::ImgProc::EConnectivity::Four, Clu::ImgProc::EConnectivity::Eight })
+		{
+			const std::string sName = std::string("Label/LumUInt16/") + SizeName(xSize)
+				+ (eConnectivity == Clu::ImgProc::EConnectivity::Four ? "/Four" : "/Eight");
+
+			// Neighbors that differ by the sensor noise are joined, and zero values are invalid.
+			const Clu::ImgProc::SLabelConfig xConfig(eConnectivity, 4.0, 0.0);
+
+			Clu::CIImage imgLabel;
+			std::vector<Clu::ImgProc::SComponent> vecComponent;
+			xRunner.Run(sName, dPixelCount, [&]()
+			{
+				Clu::ImgProc::LabelImage(imgLabel, vecComponent, imgSrc, xConfig);
+				DoNotOptimize(imgLabel);
+			});
+
+			// Includes copying the image, as the speckles are removed in place.
+			xRunner.Run(sName + "/RemoveSpeckles", dPixelCount, [&]()
+			{
+				Clu::CIImage imgImage = imgSrc.Copy();
+				Clu::ImgProc::RemoveSpeckles(imgImage, xConfig, 100);
+				DoNotOptimize(imgImage);
+			});
+		}
+	}
+} // namespace
+
+int main(int iArgCnt, char* ppcArg[])
+{
+	return Clu::Benchmark::Main(iArgCnt, ppcArg, "CluTec.ImgProc", [](CRunner& xRunner)
+	{
+		BenchDemosaic(xRunner);
+		BenchConvert(xRunner);
+		BenchFilter(xRunner);
+		BenchPyramid(xRunner);
+		BenchRemap(xRunner);
+		BenchStatistics(xRunner);
+		BenchView(xRunner);
+		BenchCodec(xRunner);
+		BenchIntegral(xRunner);
+		BenchMorphology(xRunner);
+		BenchMedian(xRunner);
+		BenchLabel(xRunner);
+	});
+}
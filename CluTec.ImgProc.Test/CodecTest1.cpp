@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      CodecTest1.cpp
+//
+// summary:   Implements the codec test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Codec.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(CodecTest1)
+	{
+	public:
+		template<typename TValue>
+		static void TestCompress(EPixelType ePixelType, EDataType eDataType, double dMin, double dMax)
+		{
+			const int piSize[][2] = { { 1, 1 }, { 3, 50 }, { 37, 23 }, { 129, 3 }, { 200, 40 } };
+			std::mt19937 xRandom(unsigned(eDataType) + unsigned(ePixelType));
+
+			for (const auto& piWH : piSize)
+			{
+				for (bool bSmooth : { false, true })
+				{
+					// Random values test the escape to raw blocks, smooth values the short residual codes.
+					CIImage imgSrc(SImageFormat(piWH[0], piWH[1], ePixelType, eDataType));
+					FillRandom<TValue>(imgSrc, xRandom, dMin, dMax);
+					if (bSmooth)
+					{
+						const int iChannelCount = int(SImageType::DimOf(ePixelType));
+						for (int iY = 0; iY < piWH[1]; ++iY)
+						{
+							TValue* pRow = Pixel<TValue>(imgSrc, 0, iY);
+							for (int iIdx = 0; iIdx < piWH[0] * iChannelCount; ++iIdx)
+							{
+								pRow[iIdx] = TValue((iIdx / iChannelCount + iY * 2 + int(xRandom() % 4)) % 200);
+							}
+						}
+					}
+
+					for (ECodecPredictor ePredictor : { ECodecPredictor::Left, ECodecPredictor::Up, ECodecPredictor::Med })
+					{
+						for (int iBandRowCount : { 0, 1, 7 })
+						{
+							CCompressedImage xCompressed;
+							xCompressed.Compress(imgSrc, ePredictor, iBandRowCount);
+
+							CIImage imgTrg;
+							xCompressed.Decompress(imgTrg);
+							Assert::IsTrue(IsEqual<TValue>(imgTrg, imgSrc), L"Decompressed image differs from the source");
+
+							// Decompress into memory whose rows are further apart than in the source.
+							const SImageFormat xPitched(piWH[0], piWH[1], ePixelType, eDataType, (piWH[0] + 17) * int(imgSrc.Format().BytesPerPixel()));
+							std::vector<unsigned char> vecData(xPitched.ByteCount());
+							xCompressed.Decompress(vecData.data(), xPitched);
+							for (int iY = 0; iY < piWH[1]; ++iY)
+							{
+								Assert::IsTrue(memcmp(vecData.data() + size_t(iY) * xPitched.RowPitch(), Pixel<TValue>(imgSrc, 0, iY), imgSrc.Format().RowByteCount()) == 0
+									, L"Image decompressed into pitched memory differs from the source");
+							}
+
+							if (piWH[0] > 4 && piWH[1] > 4)
+							{
+								const CIImage imgView = imgSrc.CropView(1, 1, piWH[0] - 3, piWH[1] - 2);
+								CCompressedImage xViewCompressed;
+								xViewCompressed.Compress(imgView, ePredictor, iBandRowCount);
+								xViewCompressed.Decompress(imgTrg);
+								Assert::IsTrue(IsEqual<TValue>(imgTrg, imgView), L"Decompressed view differs from the source");
+							}
+						}
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(CompressRoundtrip)
+		{
+			try
+			{
+				TestCompress<uint8_t>(EPixelType::Lum, EDataType::UInt8, 0.0, 256.0);
+				TestCompress<int8_t>(EPixelType::Lum, EDataType::Int8, -128.0, 128.0);
+				TestCompress<uint16_t>(EPixelType::Lum, EDataType::UInt16, 0.0, 65536.0);
+				TestCompress<uint16_t>(EPixelType::Lum, EDataType::UInt16, 0.0, 4096.0);
+				TestCompress<int16_t>(EPixelType::Lum, EDataType::Int16, -32768.0, 32768.0);
+				TestCompress<uint8_t>(EPixelType::RGB, EDataType::UInt8, 0.0, 256.0);
+				TestCompress<uint16_t>(EPixelType::RGBA, EDataType::UInt16, 0.0, 1024.0);
+				TestCompress<uint8_t>(EPixelType::BayerRG, EDataType::UInt8, 0.0, 256.0);
+				TestCompress<uint16_t>(EPixelType::BayerGB, EDataType::UInt16, 0.0, 4096.0);
+				TestCompress<float>(EPixelType::Lum, EDataType::Single, -1.0, 1.0);
+				TestCompress<uint32_t>(EPixelType::Lum, EDataType::UInt32, 0.0, 1e9);
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
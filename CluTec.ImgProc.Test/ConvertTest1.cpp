@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      ConvertTest1.cpp
+//
+// summary:   Implements the conversion test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Math/MapPixelValue.h"
+#include "CluTec.ImgProc/Image.Convert.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(ConvertTest1)
+	{
+	public:
+		// The fixed point luminance weights of the conversion, which sum to 1 << 15.
+		static int Luminance(int iR, int iG, int iB)
+		{
+			return (9798 * iR + 19235 * iG + 3735 * iB + 16384) >> 15;
+		}
+
+		template<typename TSrc, typename TTrg>
+		static bool IsMappedData(const CIImage& imgTrg, const CIImage& imgSrc)
+		{
+			const SImageFormat& xFormat = imgSrc.Format();
+			const int iValueCount = xFormat.iWidth * int(SImageType::DimOf(xFormat.ePixelType));
+
+			for (int iY = 0; iY < xFormat.iHeight; ++iY)
+			{
+				const TSrc* pSrc = Pixel<TSrc>(imgSrc, 0, iY);
+				const TTrg* pTrg = Pixel<TTrg>(imgTrg, 0, iY);
+				for (int iIdx = 0; iIdx < iValueCount; ++iIdx)
+				{
+					if (pTrg[iIdx] != Clu::MapPixelValue<TTrg>(pSrc[iIdx]))
+					{
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		// Converts an RGB type image of UInt8 to Lum and compares with the scalar luminance.
+		static bool IsLuminance(const CIImage& imgSrc, int iR, int iB)
+		{
+			CIImage imgLum;
+			ConvertImage(imgLum, imgSrc, EPixelType::Lum, EDataType::UInt8);
+
+			for (int iY = 0; iY < imgSrc.Format().iHeight; ++iY)
+			{
+				for (int iX = 0; iX < imgSrc.Format().iWidth; ++iX)
+				{
+					const uint8_t* pSrc = Pixel<uint8_t>(imgSrc, iX, iY);
+					if (int(Pixel<uint8_t>(imgLum, iX, iY)[0]) != Luminance(pSrc[iR], pSrc[1], pSrc[iB]))
+					{
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		TEST_METHOD(ConvertDataTypeMatchesMapPixelValue)
+		{
+			try
+			{
+				std::mt19937 xRandom(3);
+
+				for (int iWidth : c_piOddWidth)
+				{
+					CIImage imgU8(SImageFormat(iWidth, 3, EPixelType::RGBA, EDataType::UInt8));
+					FillRandom<uint8_t>(imgU8, xRandom, 0.0, 256.0);
+
+					CIImage imgTrg;
+					ConvertImage(imgTrg, imgU8, EPixelType::RGBA, EDataType::Single);
+					Assert::IsTrue(IsMappedData<uint8_t, float>(imgTrg, imgU8), L"UInt8 to Single differs from MapPixelValue");
+
+					CIImage imgU16(SImageFormat(iWidth, 3, EPixelType::Lum, EDataType::UInt16));
+					FillRandom<uint16_t>(imgU16, xRandom, 0.0, 65536.0);
+
+					ConvertImage(imgTrg, imgU16, EPixelType::Lum, EDataType::Single);
+					Assert::IsTrue(IsMappedData<uint16_t, float>(imgTrg, imgU16), L"UInt16 to Single differs from MapPixelValue");
+
+					// Values outside of the range, on the rounding boundaries and NaN.
+					CIImage imgF(SImageFormat(iWidth, 3, EPixelType::Lum, EDataType::Single));
+					FillRandom<float>(imgF, xRandom, -0.2, 1.2);
+					const float pfSpecial[] = { NAN, 0.5f / 255.0f, 1.5f / 255.0f, 254.5f / 255.0f };
+					for (int iIdx = 0; iIdx < std::min(iWidth, 4); ++iIdx)
+					{
+						Pixel<float>(imgF, iIdx, 1)[0] = pfSpecial[iIdx];
+					}
+
+					ConvertImage(imgTrg, imgF, EPixelType::Lum, EDataType::UInt8);
+					Assert::IsTrue(IsMappedData<float, uint8_t>(imgTrg, imgF), L"Single to UInt8 differs from MapPixelValue");
+
+					// A view that starts one pixel into the row, so that the SIMD loads are not aligned.
+					CIImage imgBig(SImageFormat(iWidth + 2, 4, EPixelType::RGBA, EDataType::UInt8));
+					FillRandom<uint8_t>(imgBig, xRandom, 0.0, 256.0);
+					const CIImage imgView = imgBig.CropView(1, 1, iWidth, 3);
+
+					ConvertImage(imgTrg, imgView, EPixelType::RGBA, EDataType::Single);
+					Assert::IsTrue(IsMappedData<uint8_t, float>(imgTrg, imgView), L"UInt8 view to Single differs from MapPixelValue");
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(ConvertToLumMatchesScalarReference)
+		{
+			try
+			{
+				std::mt19937 xRandom(5);
+
+				for (int iWidth : c_piOddWidth)
+				{
+					CIImage imgRGBA(SImageFormat(iWidth + 1, 5, EPixelType::RGBA, EDataType::UInt8));
+					FillRandom<uint8_t>(imgRGBA, xRandom, 0.0, 256.0);
+
+					CIImage imgRGB, imgBGR, imgBGRA;
+					ConvertImage(imgRGB, imgRGBA, EPixelType::RGB, EDataType::UInt8);
+					ConvertImage(imgBGR, imgRGBA, EPixelType::BGR, EDataType::UInt8);
+					ConvertImage(imgBGRA, imgRGBA, EPixelType::BGRA, EDataType::UInt8);
+
+					Assert::IsTrue(IsLuminance(imgRGBA, 0, 2), L"RGBA to Lum differs from the scalar reference");
+					Assert::IsTrue(IsLuminance(imgRGB, 0, 2), L"RGB to Lum differs from the scalar reference");
+					Assert::IsTrue(IsLuminance(imgBGR, 2, 0), L"BGR to Lum differs from the scalar reference");
+					Assert::IsTrue(IsLuminance(imgBGRA, 2, 0), L"BGRA to Lum differs from the scalar reference");
+
+					Assert::IsTrue(IsLuminance(imgRGBA.CropView(1, 1, iWidth, 4), 0, 2), L"RGBA view to Lum differs from the scalar reference");
+					Assert::IsTrue(IsLuminance(imgRGB.CropView(1, 1, iWidth, 4), 0, 2), L"RGB view to Lum differs from the scalar reference");
+					Assert::IsTrue(IsLuminance(imgBGR.CropView(1, 1, iWidth, 4), 2, 0), L"BGR view to Lum differs from the scalar reference");
+				}
+
+				// Int16 uses the same weights in 64 bit.
+				CIImage imgSrc(SImageFormat(37, 3, EPixelType::RGB, EDataType::Int16));
+				FillRandom<int16_t>(imgSrc, xRandom, -32768.0, 32768.0);
+
+				CIImage imgTrg;
+				ConvertImage(imgTrg, imgSrc, EPixelType::Lum, EDataType::Double);
+
+				for (int iY = 0; iY < 3; ++iY)
+				{
+					for (int iX = 0; iX < 37; ++iX)
+					{
+						const int16_t* pSrc = Pixel<int16_t>(imgSrc, iX, iY);
+						const int64_t iSum = 9798LL * pSrc[0] + 19235LL * pSrc[1] + 3735LL * pSrc[2];
+						const int16_t iLum = int16_t((iSum + 16384) >> 15);
+						Assert::IsTrue(Pixel<double>(imgTrg, iX, iY)[0] == Clu::MapPixelValue<double>(iLum), L"Int16 RGB to Lum differs from the scalar reference");
+					}
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(ConvertSwizzleRoundtrip)
+		{
+			try
+			{
+				std::mt19937 xRandom(7);
+
+				for (int iWidth : c_piOddWidth)
+				{
+					CIImage imgRGBA(SImageFormat(iWidth, 3, EPixelType::RGBA, EDataType::UInt8));
+					FillRandom<uint8_t>(imgRGBA, xRandom, 0.0, 256.0);
+
+					CIImage imgBGRA, imgBack;
+					ConvertImage(imgBGRA, imgRGBA, EPixelType::BGRA, EDataType::UInt8);
+					ConvertImage(imgBack, imgBGRA, EPixelType::RGBA, EDataType::UInt8);
+					Assert::IsTrue(IsEqual<uint8_t>(imgBack, imgRGBA), L"RGBA to BGRA and back is not the identity");
+
+					for (int iX = 0; iX < iWidth; ++iX)
+					{
+						const uint8_t* pA = Pixel<uint8_t>(imgRGBA, iX, 1);
+						const uint8_t* pB = Pixel<uint8_t>(imgBGRA, iX, 1);
+						Assert::IsTrue(pA[0] == pB[2] && pA[1] == pB[1] && pA[2] == pB[0] && pA[3] == pB[3], L"BGRA has the wrong channel order");
+					}
+
+					CIImage imgRGB, imgBGR;
+					ConvertImage(imgRGB, imgRGBA, EPixelType::RGB, EDataType::UInt8);
+					ConvertImage(imgBGR, imgRGB, EPixelType::BGR, EDataType::UInt8);
+					ConvertImage(imgBack, imgBGR, EPixelType::RGB, EDataType::UInt8);
+					Assert::IsTrue(IsEqual<uint8_t>(imgBack, imgRGB), L"RGB to BGR and back is not the identity");
+
+					// Lum is replicated to the colors with an opaque alpha.
+					CIImage imgLum(SImageFormat(iWidth, 3, EPixelType::Lum, EDataType::UInt8));
+					FillRandom<uint8_t>(imgLum, xRandom, 0.0, 256.0);
+
+					CIImage imgTrg;
+					ConvertImage(imgTrg, imgLum, EPixelType::RGBA, EDataType::UInt16);
+					for (int iX = 0; iX < iWidth; ++iX)
+					{
+						const uint16_t* pTrg = Pixel<uint16_t>(imgTrg, iX, 2);
+						const uint16_t uValue = Clu::MapPixelValue<uint16_t>(Pixel<uint8_t>(imgLum, iX, 2)[0]);
+						Assert::IsTrue(pTrg[0] == uValue && pTrg[1] == uValue && pTrg[2] == uValue && pTrg[3] == 0xFFFF, L"Lum to RGBA is not replicated");
+					}
+				}
+
+				// Converting an image into itself.
+				CIImage imgImage(SImageFormat(53, 7, EPixelType::RGB, EDataType::UInt8));
+				FillRandom<uint8_t>(imgImage, xRandom, 0.0, 256.0);
+				const CIImage imgKeep = imgImage.Copy();
+
+				ConvertImage(imgImage, imgImage, EPixelType::Lum, EDataType::Single);
+				Assert::IsTrue(imgImage.Format().ePixelType == EPixelType::Lum, L"In place conversion has the wrong pixel type");
+
+				for (int iY = 0; iY < 7; ++iY)
+				{
+					for (int iX = 0; iX < 53; ++iX)
+					{
+						const uint8_t* pSrc = Pixel<uint8_t>(imgKeep, iX, iY);
+						const float fLum = float(Luminance(pSrc[0], pSrc[1], pSrc[2])) / 255.0f;
+						Assert::IsTrue(fabs(Pixel<float>(imgImage, iX, iY)[0] - fLum) <= 1e-6f, L"In place conversion differs from the scalar reference");
+					}
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      DemosaicTest1.cpp
+//
+// summary:   Implements the demosaicing test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Demosaic.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(DemosaicTest1)
+	{
+	public:
+		// The Bayer value at a position, mirrored at the image border.
+		template<typename TValue>
+		static int BayerValue(const CIImage& imgSrc, int iX, int iY)
+		{
+			const int iWidth = imgSrc.Format().iWidth;
+			const int iHeight = imgSrc.Format().iHeight;
+			iX = iX < 0 ? -iX : (iX >= iWidth ? 2 * iWidth - 2 - iX : iX);
+			iY = iY < 0 ? -iY : (iY >= iHeight ? 2 * iHeight - 2 - iY : iY);
+			return int(Pixel<TValue>(imgSrc, iX, iY)[0]);
+		}
+
+		// Compares the demosaiced image with a scalar implementation of the interpolation formulas.
+		// The red pixel of the Bayer cell is at (iRedX, iRedY).
+		template<typename TValue>
+		static void TestDemosaic(EPixelType eBayer, int iRedX, int iRedY, int iWidth, int iHeight, EDemosaicMethod eMethod, EPixelType eTrgType)
+		{
+			const EDataType eDataType = sizeof(TValue) == 1 ? EDataType::UInt8 : EDataType::UInt16;
+			const int iMax = sizeof(TValue) == 1 ? 255 : 65535;
+
+			std::mt19937 xRandom(unsigned(iWidth * 31 + iHeight));
+			CIImage imgSrc(SImageFormat(iWidth, iHeight, eBayer, eDataType));
+			FillRandom<TValue>(imgSrc, xRandom, 0.0, double(iMax) + 1.0);
+
+			CIImage imgTrg;
+			Demosaic(imgTrg, imgSrc, eMethod, eTrgType);
+
+			const int iChannelCount = int(SImageType::DimOf(eTrgType));
+			const int iR = (eTrgType == EPixelType::RGB || eTrgType == EPixelType::RGBA) ? 0 : 2;
+			const int iB = 2 - iR;
+			auto S = [&](int iX, int iY) { return BayerValue<TValue>(imgSrc, iX, iY); };
+			auto Clamp = [&](int iValue) { return std::min(std::max(iValue, 0), iMax); };
+
+			if (eMethod == EDemosaicMethod::HalfResolution)
+			{
+				Assert::IsTrue(imgTrg.Format().iWidth == iWidth / 2 && imgTrg.Format().iHeight == iHeight / 2, L"Half resolution image has the wrong size");
+
+				for (int iY = 0; iY < iHeight / 2; ++iY)
+				{
+					for (int iX = 0; iX < iWidth / 2; ++iX)
+					{
+						const TValue* pTrg = Pixel<TValue>(imgTrg, iX, iY);
+						const int iRed = S(2 * iX + iRedX, 2 * iY + iRedY);
+						const int iBlue = S(2 * iX + 1 - iRedX, 2 * iY + 1 - iRedY);
+						const int iGreen = (S(2 * iX + 1 - iRedX, 2 * iY + iRedY) + S(2 * iX + iRedX, 2 * iY + 1 - iRedY) + 1) >> 1;
+
+						Assert::IsTrue(pTrg[iR] == iRed && pTrg[1] == iGreen && pTrg[iB] == iBlue && (iChannelCount == 3 || pTrg[3] == iMax)
+							, L"Half resolution demosaic differs from the scalar reference");
+					}
+				}
+				return;
+			}
+
+			for (int iY = 0; iY < iHeight; ++iY)
+			{
+				for (int iX = 0; iX < iWidth; ++iX)
+				{
+					const int iC = S(iX, iY);
+					const int iH = S(iX - 1, iY) + S(iX + 1, iY);
+					const int iV = S(iX, iY - 1) + S(iX, iY + 1);
+					const int iD = S(iX - 1, iY - 1) + S(iX + 1, iY - 1) + S(iX - 1, iY + 1) + S(iX + 1, iY + 1);
+					const int iFH = S(iX - 2, iY) + S(iX + 2, iY);
+					const int iFV = S(iX, iY - 2) + S(iX, iY + 2);
+
+					const bool bRedRow = (iY & 1) == iRedY;
+					const bool bRed = bRedRow && (iX & 1) == iRedX;
+					const bool bBlue = !bRedRow && (iX & 1) != iRedX;
+					int iRed, iGreen, iBlue;
+
+					if (!bRed && !bBlue)
+					{
+						int iRowC, iColC;
+						if (eMethod == EDemosaicMethod::Bilinear)
+						{
+							iRowC = (iH + 1) >> 1;
+							iColC = (iV + 1) >> 1;
+						}
+						else
+						{
+							iRowC = Clamp((10 * iC + 8 * iH - 2 * iD - 2 * iFH + iFV + 8) >> 4);
+							iColC = Clamp((10 * iC + 8 * iV - 2 * iD - 2 * iFV + iFH + 8) >> 4);
+						}
+
+						iGreen = iC;
+						iRed = bRedRow ? iRowC : iColC;
+						iBlue = bRedRow ? iColC : iRowC;
+					}
+					else
+					{
+						int iDiagC;
+						if (eMethod == EDemosaicMethod::Bilinear)
+						{
+							iGreen = (iH + iV + 2) >> 2;
+							iDiagC = (iD + 2) >> 2;
+						}
+						else
+						{
+							iGreen = Clamp((4 * iC + 2 * (iH + iV) - iFH - iFV + 4) >> 3);
+							iDiagC = Clamp((12 * iC + 4 * iD - 3 * (iFH + iFV) + 8) >> 4);
+						}
+
+						iRed = bRed ? iC : iDiagC;
+						iBlue = bRed ? iDiagC : iC;
+					}
+
+					const TValue* pTrg = Pixel<TValue>(imgTrg, iX, iY);
+					Assert::IsTrue(pTrg[iR] == iRed && pTrg[1] == iGreen && pTrg[iB] == iBlue && (iChannelCount == 3 || pTrg[3] == iMax)
+						, L"Demosaic differs from the scalar reference");
+				}
+			}
+		}
+
+		TEST_METHOD(DemosaicMatchesScalarReference)
+		{
+			try
+			{
+				struct SCell
+				{
+					EPixelType eBayer;
+					int iRedX, iRedY;
+				};
+
+				const SCell pxCell[] = { { EPixelType::BayerRG, 0, 0 }, { EPixelType::BayerBG, 1, 1 }, { EPixelType::BayerGR, 1, 0 }, { EPixelType::BayerGB, 0, 1 } };
+				const int piSize[][2] = { { 3, 3 }, { 37, 9 }, { 64, 6 }, { 4, 20 } };
+
+				for (const SCell& xCell : pxCell)
+				{
+					for (const auto& piWH : piSize)
+					{
+						for (EDemosaicMethod eMethod : { EDemosaicMethod::Bilinear, EDemosaicMethod::EdgeAware, EDemosaicMethod::HalfResolution })
+						{
+							for (EPixelType eTrgType : { EPixelType::RGB, EPixelType::BGRA, EPixelType::RGBA })
+							{
+								TestDemosaic<uint8_t>(xCell.eBayer, xCell.iRedX, xCell.iRedY, piWH[0], piWH[1], eMethod, eTrgType);
+								TestDemosaic<uint16_t>(xCell.eBayer, xCell.iRedX, xCell.iRedY, piWH[0], piWH[1], eMethod, eTrgType);
+							}
+						}
+					}
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
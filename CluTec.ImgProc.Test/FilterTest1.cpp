@@ -0,0 +1,155 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      FilterTest1.cpp
+//
+// summary:   Implements the filter test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.ImgProc/Image.Filter.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(FilterTest1)
+	{
+	public:
+		// Compares the filtered image with a direct convolution, which reads the border pixels through BorderIndex().
+		template<typename TSrc, typename TTrg>
+		static void TestFilter(EPixelType ePixelType, EDataType eSrcType, EDataType eTrgType, int iWidth, int iHeight
+			, const SFilterKernel& xKernel, EBorderMode eBorder, double dMin, double dMax)
+		{
+			const double dBorderValue = 7.0;
+
+			std::mt19937 xRandom(unsigned(iWidth + 3 * iHeight));
+			CIImage imgSrc(SImageFormat(iWidth, iHeight, ePixelType, eSrcType));
+			FillRandom<TSrc>(imgSrc, xRandom, dMin, dMax);
+
+			CIImage imgTrg;
+			FilterImage(imgTrg, imgSrc, xKernel, eBorder, eTrgType, dBorderValue);
+
+			const int iChannelCount = int(SImageType::DimOf(ePixelType));
+			const int iRadiusX = xKernel.iWidth / 2;
+			const int iRadiusY = xKernel.iHeight / 2;
+
+			for (int iY = 0; iY < iHeight; ++iY)
+			{
+				for (int iX = 0; iX < iWidth; ++iX)
+				{
+					for (int iC = 0; iC < iChannelCount; ++iC)
+					{
+						double dSum = 0.0;
+						for (int iJ = 0; iJ < xKernel.iHeight; ++iJ)
+						{
+							for (int iI = 0; iI < xKernel.iWidth; ++iI)
+							{
+								const double dWeight = xKernel.bSeparable ? double(xKernel.vecX[iI]) * xKernel.vecY[iJ] : double(xKernel.vecXY[iJ * xKernel.iWidth + iI]);
+								const ptrdiff_t iSrcX = BorderIndex(iX + iI - iRadiusX, iWidth, eBorder);
+								const ptrdiff_t iSrcY = BorderIndex(iY + iJ - iRadiusY, iHeight, eBorder);
+								const double dValue = (iSrcX < 0 || iSrcY < 0) ? dBorderValue : double(Pixel<TSrc>(imgSrc, int(iSrcX), int(iSrcY))[iC]);
+								dSum += dWeight * dValue;
+							}
+						}
+
+						Assert::IsTrue(IsNear<TTrg>(double(Pixel<TTrg>(imgTrg, iX, iY)[iC]), dSum), L"Filter differs from the direct convolution");
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(FilterMatchesDirectConvolution)
+		{
+			try
+			{
+				const std::vector<SFilterKernel> vecKernel = { GaussianKernel(1.2), BoxKernel(2), SobelKernel(1, 0), SobelKernel(0, 1)
+					, GeneralKernel(3, 5, { 1, 2, 3, -1, 0, 2, 0.5f, 1, 1, -2, 3, 1, 0, 0, 1 }), SeparableKernel({ 0.25f, 0.5f, 0.25f }, { 1.0f }) };
+				const int piSize[][2] = { { 1, 1 }, { 2, 7 }, { 16, 3 }, { 17, 4 }, { 37, 9 } };
+
+				for (const SFilterKernel& xKernel : vecKernel)
+				{
+					for (EBorderMode eBorder : { EBorderMode::Constant, EBorderMode::Replicate, EBorderMode::Reflect, EBorderMode::Mirror, EBorderMode::Wrap })
+					{
+						for (const auto& piWH : piSize)
+						{
+							TestFilter<uint8_t, uint8_t>(EPixelType::Lum, EDataType::UInt8, EDataType::UInt8, piWH[0], piWH[1], xKernel, eBorder, 0.0, 256.0);
+							TestFilter<uint8_t, float>(EPixelType::RGB, EDataType::UInt8, EDataType::Single, piWH[0], piWH[1], xKernel, eBorder, 0.0, 256.0);
+							TestFilter<uint16_t, uint16_t>(EPixelType::RGBA, EDataType::UInt16, EDataType::UInt16, piWH[0], piWH[1], xKernel, eBorder, 0.0, 4096.0);
+							TestFilter<float, float>(EPixelType::LumA, EDataType::Single, EDataType::Single, piWH[0], piWH[1], xKernel, eBorder, -1.0, 1.0);
+							TestFilter<int32_t, double>(EPixelType::Lum, EDataType::Int32, EDataType::Double, piWH[0], piWH[1], xKernel, eBorder, -1e6, 1e6);
+							TestFilter<uint8_t, int16_t>(EPixelType::Lum, EDataType::UInt8, EDataType::Int16, piWH[0], piWH[1], xKernel, eBorder, 0.0, 256.0);
+						}
+					}
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(FilterKeepsSourceShared)
+		{
+			try
+			{
+				std::mt19937 xRandom(1);
+				CIImage imgA(SImageFormat(37, 23, EPixelType::RGB, EDataType::UInt8));
+				FillRandom<uint8_t>(imgA, xRandom, 0.0, 256.0);
+
+				// Filtering a copy only reads the memory it shares with the original.
+				const CIImage imgB = imgA.Copy();
+				CIImage imgTrg;
+				FilterImage(imgTrg, imgB, GaussianKernel(1.0));
+				Assert::IsTrue(!imgA.IsUnique() && ((const CIImage&)imgA).DataPointer() == imgB.DataPointer(), L"Filtering detached the shared source");
+
+				CILayerImage imgLayerA(SImageFormat(37, 23, EPixelType::RGB, EDataType::UInt8));
+				for (size_t nLayer = 0; nLayer < imgLayerA.LayerCount(); ++nLayer)
+				{
+					memset(imgLayerA.DataPointer(nLayer), int(nLayer), imgLayerA.LayerRowPitch() * 23);
+				}
+
+				const CILayerImage imgLayerB = imgLayerA.Copy();
+				CILayerImage imgLayerTrg;
+				FilterImage(imgLayerTrg, imgLayerB, GaussianKernel(1.0));
+				Assert::IsTrue(!imgLayerA.IsUnique() && ((const CILayerImage&)imgLayerA).DataPointer(0) == imgLayerB.DataPointer(0), L"Filtering detached the shared layer source");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
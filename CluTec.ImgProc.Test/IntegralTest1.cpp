@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      IntegralTest1.cpp
+//
+// summary:   Implements the integral image test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Integral.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(IntegralTest1)
+	{
+	public:
+		template<typename TValue>
+		static void TestIntegral(EPixelType ePixelType, EDataType eDataType, int iWidth, int iHeight, double dMin, double dMax)
+		{
+			std::mt19937 xRandom(unsigned(iWidth * 13 + iHeight));
+			CIImage imgSrc(SImageFormat(iWidth, iHeight, ePixelType, eDataType));
+			FillRandom<TValue>(imgSrc, xRandom, dMin, dMax);
+
+			CIntegralImage xIntegral;
+			xIntegral.Create(imgSrc);
+
+			const int iChannelCount = int(SImageType::DimOf(ePixelType));
+			Assert::IsTrue(xIntegral.Width() == iWidth && xIntegral.Height() == iHeight && xIntegral.ChannelCount() == iChannelCount, L"Integral image has the wrong size");
+
+			// Sums of the source pixels in the box [iX0, iX1) x [iY0, iY1).
+			auto BoxRef = [&](int iX0, int iY0, int iX1, int iY1, int iC, double& dSum, double& dSqSum)
+			{
+				dSum = dSqSum = 0.0;
+				for (int iY = iY0; iY < iY1; ++iY)
+				{
+					for (int iX = iX0; iX < iX1; ++iX)
+					{
+						const double dValue = double(Pixel<TValue>(imgSrc, iX, iY)[iC]);
+						dSum += dValue;
+						dSqSum += dValue * dValue;
+					}
+				}
+			};
+
+			for (int iTest = 0; iTest < 20; ++iTest)
+			{
+				const int iX = int(xRandom() % unsigned(iWidth));
+				const int iY = int(xRandom() % unsigned(iHeight));
+				const int iW = 1 + int(xRandom() % unsigned(iWidth - iX));
+				const int iH = 1 + int(xRandom() % unsigned(iHeight - iY));
+				const int iC = int(xRandom() % unsigned(iChannelCount));
+
+				double dSum, dSqSum;
+				BoxRef(iX, iY, iX + iW, iY + iH, iC, dSum, dSqSum);
+				const double dCount = double(iW) * iH;
+				const double dMean = dSum / dCount;
+
+				Assert::IsTrue(fabs(xIntegral.Sum(iX, iY, iW, iH, iC) - dSum) <= 1e-9 * fabs(dSum) + 1e-9, L"Integral sum differs from the scalar reference");
+				Assert::IsTrue(fabs(xIntegral.Mean(iX, iY, iW, iH, iC) - dMean) <= 1e-9 * fabs(dMean) + 1e-9, L"Integral mean differs from the scalar reference");
+				Assert::IsTrue(fabs(xIntegral.Variance(iX, iY, iW, iH, iC) - (dSqSum / dCount - dMean * dMean)) <= 1e-6 * (dSqSum / dCount) + 1e-9
+					, L"Integral variance differs from the scalar reference");
+			}
+
+			for (int iRadius : { 0, 1, 3 })
+			{
+				CIImage imgSum, imgMean, imgVar;
+				BoxSum(imgSum, xIntegral, iRadius, iRadius + 1);
+				BoxMean(imgMean, xIntegral, iRadius, iRadius + 1);
+				BoxVariance(imgVar, xIntegral, iRadius, iRadius + 1);
+
+				for (int iY = 0; iY < iHeight; ++iY)
+				{
+					for (int iX = 0; iX < iWidth; ++iX)
+					{
+						for (int iC = 0; iC < iChannelCount; ++iC)
+						{
+							const int iX0 = std::max(0, iX - iRadius), iX1 = std::min(iWidth, iX + iRadius + 1);
+							const int iY0 = std::max(0, iY - iRadius - 1), iY1 = std::min(iHeight, iY + iRadius + 2);
+
+							double dSum, dSqSum;
+							BoxRef(iX0, iY0, iX1, iY1, iC, dSum, dSqSum);
+							const double dCount = double(iX1 - iX0) * (iY1 - iY0);
+							const double dMean = dSum / dCount;
+							const double dVar = std::max(dSqSum / dCount - dMean * dMean, 0.0);
+
+							Assert::IsTrue(fabs(Pixel<double>(imgSum, iX, iY)[iC] - dSum) <= 1e-9 * fabs(dSum) + 1e-9, L"Box sum differs from the scalar reference");
+							Assert::IsTrue(fabs(Pixel<float>(imgMean, iX, iY)[iC] - dMean) <= 1e-6 * fabs(dMean) + 1e-6, L"Box mean differs from the scalar reference");
+							Assert::IsTrue(fabs(Pixel<float>(imgVar, iX, iY)[iC] - dVar) <= 1e-5 * (dSqSum / dCount) + 1e-6, L"Box variance differs from the scalar reference");
+						}
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(IntegralMatchesScalarReference)
+		{
+			try
+			{
+				const int piSize[][2] = { { 1, 1 }, { 1, 7 }, { 17, 5 }, { 37, 11 } };
+
+				for (const auto& piWH : piSize)
+				{
+					TestIntegral<uint8_t>(EPixelType::Lum, EDataType::UInt8, piWH[0], piWH[1], 0.0, 256.0);
+					TestIntegral<int8_t>(EPixelType::RGB, EDataType::Int8, piWH[0], piWH[1], -128.0, 128.0);
+					TestIntegral<uint16_t>(EPixelType::LumA, EDataType::UInt16, piWH[0], piWH[1], 0.0, 4096.0);
+					TestIntegral<int32_t>(EPixelType::Lum, EDataType::Int32, piWH[0], piWH[1], -1e5, 1e5);
+					TestIntegral<float>(EPixelType::RGBA, EDataType::Single, piWH[0], piWH[1], 0.0, 250.0);
+					TestIntegral<double>(EPixelType::Lum, EDataType::Double, piWH[0], piWH[1], -500.0, 500.0);
+				}
+
+				// Without the squared sums there is no variance.
+				CIImage imgSrc(SImageFormat(8, 8, EPixelType::Lum, EDataType::UInt8));
+				CIntegralImage xIntegral;
+				xIntegral.Create(imgSrc, false);
+				Assert::IsFalse(xIntegral.HasSquaredSum(), L"Integral image has squared sums");
+
+				bool bThrown = false;
+				try
+				{
+					CIImage imgVar;
+					BoxVariance(imgVar, xIntegral, 1, 1);
+				}
+				catch (Clu::CIException&)
+				{
+					bThrown = true;
+				}
+				Assert::IsTrue(bThrown, L"Box variance without squared sums did not throw");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      InterleaveTest1.cpp
+//
+// summary:   Implements the interleave test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.ImgProc/Image.Interleave.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(InterleaveTest1)
+	{
+	public:
+		template<typename TValue>
+		static void TestInterleaveData(EPixelType ePixelType, EDataType eDataType, int iWidth, int iHeight, size_t nPitchExtra)
+		{
+			const int iChannelCount = int(SImageType::DimOf(ePixelType));
+			std::mt19937 xRandom(unsigned(iWidth * iHeight + iChannelCount));
+
+			// Zero layer pitch means that the layers are packed.
+			const size_t nLayerPitch = nPitchExtra ? iWidth * sizeof(TValue) + nPitchExtra : 0;
+			const size_t nLayerRowBytes = nLayerPitch ? nLayerPitch : iWidth * sizeof(TValue);
+
+			std::vector<std::vector<unsigned char>> vecLayer(iChannelCount, std::vector<unsigned char>(nLayerRowBytes * iHeight));
+			std::vector<std::vector<unsigned char>> vecResult(iChannelCount, std::vector<unsigned char>(nLayerRowBytes * iHeight));
+			std::vector<const void*> vecSrc(iChannelCount);
+			std::vector<void*> vecTrg(iChannelCount);
+			for (int iC = 0; iC < iChannelCount; ++iC)
+			{
+				for (unsigned char& uByte : vecLayer[iC])
+				{
+					uByte = (unsigned char)xRandom();
+				}
+
+				vecSrc[iC] = vecLayer[iC].data();
+				vecTrg[iC] = vecResult[iC].data();
+			}
+
+			const int iRowPitch = nPitchExtra ? int((iWidth + 3) * iChannelCount * sizeof(TValue)) : 0;
+			const SImageFormat xFormat(iWidth, iHeight, ePixelType, eDataType, iRowPitch);
+			std::vector<unsigned char> vecImage(xFormat.ByteCount());
+
+			InterleaveData(vecImage.data(), xFormat, vecSrc.data(), nLayerPitch);
+
+			for (int iY = 0; iY < iHeight; ++iY)
+			{
+				for (int iX = 0; iX < iWidth; ++iX)
+				{
+					for (int iC = 0; iC < iChannelCount; ++iC)
+					{
+						const unsigned char* pPixel = vecImage.data() + iY * xFormat.RowPitch() + (iX * iChannelCount + iC) * sizeof(TValue);
+						const unsigned char* pLayer = vecLayer[iC].data() + iY * nLayerRowBytes + iX * sizeof(TValue);
+						Assert::IsTrue(memcmp(pPixel, pLayer, sizeof(TValue)) == 0, L"Interleaved data differs from the layers");
+					}
+				}
+			}
+
+			DeinterleaveData(vecTrg.data(), nLayerPitch, vecImage.data(), xFormat);
+
+			for (int iC = 0; iC < iChannelCount; ++iC)
+			{
+				for (int iY = 0; iY < iHeight; ++iY)
+				{
+					const size_t nOffset = iY * nLayerRowBytes;
+					Assert::IsTrue(memcmp(vecResult[iC].data() + nOffset, vecLayer[iC].data() + nOffset, iWidth * sizeof(TValue)) == 0
+						, L"Deinterleaved data differs from the layers");
+				}
+			}
+		}
+
+		TEST_METHOD(InterleaveMatchesScalarReference)
+		{
+			try
+			{
+				for (int iWidth : c_piOddWidth)
+				{
+					for (size_t nPitchExtra : { size_t(0), size_t(24) })
+					{
+						TestInterleaveData<uint8_t>(EPixelType::Lum, EDataType::UInt8, iWidth, 3, nPitchExtra);
+						TestInterleaveData<uint8_t>(EPixelType::LumA, EDataType::UInt8, iWidth, 3, nPitchExtra);
+						TestInterleaveData<uint8_t>(EPixelType::RGB, EDataType::UInt8, iWidth, 3, nPitchExtra);
+						TestInterleaveData<uint8_t>(EPixelType::RGBA, EDataType::Int8, iWidth, 3, nPitchExtra);
+						TestInterleaveData<uint16_t>(EPixelType::LumA, EDataType::UInt16, iWidth, 3, nPitchExtra);
+						TestInterleaveData<uint16_t>(EPixelType::BGR, EDataType::Int16, iWidth, 3, nPitchExtra);
+						TestInterleaveData<uint16_t>(EPixelType::BGRA, EDataType::UInt16, iWidth, 3, nPitchExtra);
+						TestInterleaveData<float>(EPixelType::LumA, EDataType::Single, iWidth, 3, nPitchExtra);
+						TestInterleaveData<float>(EPixelType::RGB, EDataType::Single, iWidth, 3, nPitchExtra);
+						TestInterleaveData<uint32_t>(EPixelType::RGBA, EDataType::UInt32, iWidth, 3, nPitchExtra);
+						TestInterleaveData<double>(EPixelType::RGB, EDataType::Double, iWidth, 3, nPitchExtra);
+					}
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(InterleaveImageRoundtrip)
+		{
+			try
+			{
+				std::mt19937 xRandom(1);
+				CIImage imgSrc(SImageFormat(37, 11, EPixelType::RGB, EDataType::UInt16));
+				FillRandom<uint16_t>(imgSrc, xRandom, 0.0, 65536.0);
+
+				CILayerImage imgLayer;
+				CIImage imgTrg;
+				Deinterleave(imgLayer, imgSrc);
+				Interleave(imgTrg, imgLayer);
+				Assert::IsTrue(IsEqual<uint16_t>(imgTrg, imgSrc), L"Image roundtrip through the layers changed the pixels");
+
+				const CIImage imgView = imgSrc.CropView(2, 3, 20, 5);
+				Deinterleave(imgLayer, imgView);
+				Interleave(imgTrg, imgLayer);
+				Assert::IsTrue(IsEqual<uint16_t>(imgTrg, imgView), L"View roundtrip through the layers changed the pixels");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(SingleChannelViewsKeepSourceAlive)
+		{
+			try
+			{
+				std::mt19937 xRandom(2);
+				CIImage imgSrc(SImageFormat(37, 11, EPixelType::Lum, EDataType::UInt16));
+				FillRandom<uint16_t>(imgSrc, xRandom, 0.0, 65536.0);
+				const CIImage imgRef = imgSrc.Copy();
+
+				// The view writes to the source, but not to the copy taken before.
+				CILayerImage imgLayerView = LayerView(imgSrc);
+				Assert::IsTrue(imgLayerView.LayerCount() == 1 && imgLayerView.Width() == 37 && imgLayerView.Height() == 11
+					&& imgLayerView.LayerRowPitch() == imgSrc.RowPitch(), L"Layer view has the wrong layout");
+
+				*(uint16_t*)imgLayerView.DataPointer(0) ^= 0xFFFF;
+				Assert::IsTrue(Pixel<uint16_t>((const CIImage&)imgSrc, 0, 0)[0] == uint16_t(Pixel<uint16_t>(imgRef, 0, 0)[0] ^ 0xFFFF)
+					, L"Writing to the layer view did not write to the source");
+				*(uint16_t*)imgLayerView.DataPointer(0) ^= 0xFFFF;
+
+				// The view keeps the memory alive after the source is destroyed.
+				imgSrc.Destroy();
+				for (int iY = 0; iY < 11; ++iY)
+				{
+					const void* pRow = (const unsigned char*)((const CILayerImage&)imgLayerView).DataPointer(0) + iY * imgLayerView.LayerRowPitch();
+					Assert::IsTrue(memcmp(pRow, Pixel<uint16_t>(imgRef, 0, iY), 37 * sizeof(uint16_t)) == 0, L"Layer view differs from its destroyed source");
+				}
+
+				CILayerImage imgLayer;
+				Deinterleave(imgLayer, imgRef);
+
+				CIImage imgView = InterleavedView(imgLayer);
+				Assert::IsTrue(imgView.Format() == imgRef.Format() && imgView.RowPitch() == imgLayer.LayerRowPitch(), L"Interleaved view has the wrong layout");
+
+				Pixel<uint16_t>(imgView, 36, 10)[0] ^= 0xFFFF;
+				Assert::IsTrue(*((const uint16_t*)((const CILayerImage&)imgLayer).DataPointer(0) + 10 * imgLayer.LayerRowPitch() / sizeof(uint16_t) + 36)
+					== uint16_t(Pixel<uint16_t>(imgRef, 36, 10)[0] ^ 0xFFFF), L"Writing to the interleaved view did not write to the source");
+				Pixel<uint16_t>(imgView, 36, 10)[0] ^= 0xFFFF;
+
+				imgLayer.Destroy();
+				Assert::IsTrue(IsEqual<uint16_t>(imgView, imgRef), L"Interleaved view differs from its destroyed source");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
@@ -0,0 +1,233 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      LabelTest1.cpp
+//
+// summary:   Implements the labeling test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Label.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(LabelTest1)
+	{
+	public:
+		// Labels the components by flood filling from the first pixel of each component in row order.
+		template<typename TValue>
+		static size_t LabelRef(std::vector<uint32_t>& vecLabel, std::vector<SComponent>& vecComponent, const CIImage& imgSrc
+			, bool bEight, double dMaxDifference, bool bIgnoreInvalid, TValue tInvalid)
+		{
+			const int iWidth = imgSrc.Format().iWidth, iHeight = imgSrc.Format().iHeight;
+			const double dMaxDiff = std::is_integral<TValue>::value ? floor(dMaxDifference) : dMaxDifference;
+			auto IsValid = [&](int iX, int iY) { return !bIgnoreInvalid || Pixel<TValue>(imgSrc, iX, iY)[0] != tInvalid; };
+
+			vecLabel.assign(size_t(iWidth) * iHeight, 0);
+			vecComponent.clear();
+
+			std::vector<int> vecStack;
+			uint32_t uLabel = 0;
+			for (int iY = 0; iY < iHeight; ++iY)
+			{
+				for (int iX = 0; iX < iWidth; ++iX)
+				{
+					if (!IsValid(iX, iY) || vecLabel[size_t(iY) * iWidth + iX] != 0)
+					{
+						continue;
+					}
+
+					++uLabel;
+					SComponent xComp;
+					xComp.iMinX = xComp.iMaxX = iX;
+					xComp.iMinY = xComp.iMaxY = iY;
+					double dSumX = 0.0, dSumY = 0.0;
+
+					vecLabel[size_t(iY) * iWidth + iX] = uLabel;
+					vecStack.push_back(iY * iWidth + iX);
+					while (!vecStack.empty())
+					{
+						const int iPX = vecStack.back() % iWidth, iPY = vecStack.back() / iWidth;
+						vecStack.pop_back();
+
+						++xComp.uArea;
+						dSumX += iPX;
+						dSumY += iPY;
+						xComp.iMinX = std::min(xComp.iMinX, iPX);
+						xComp.iMaxX = std::max(xComp.iMaxX, iPX);
+						xComp.iMinY = std::min(xComp.iMinY, iPY);
+						xComp.iMaxY = std::max(xComp.iMaxY, iPY);
+
+						for (int iDY = -1; iDY <= 1; ++iDY)
+						{
+							for (int iDX = -1; iDX <= 1; ++iDX)
+							{
+								const int iQX = iPX + iDX, iQY = iPY + iDY;
+								if ((iDX == 0 && iDY == 0) || (!bEight && iDX != 0 && iDY != 0)
+									|| iQX < 0 || iQY < 0 || iQX >= iWidth || iQY >= iHeight
+									|| !IsValid(iQX, iQY) || vecLabel[size_t(iQY) * iWidth + iQX] != 0
+									|| fabs(double(Pixel<TValue>(imgSrc, iPX, iPY)[0]) - double(Pixel<TValue>(imgSrc, iQX, iQY)[0])) > dMaxDiff)
+								{
+									continue;
+								}
+
+								vecLabel[size_t(iQY) * iWidth + iQX] = uLabel;
+								vecStack.push_back(iQY * iWidth + iQX);
+							}
+						}
+					}
+
+					xComp.dCentroidX = dSumX / double(xComp.uArea);
+					xComp.dCentroidY = dSumY / double(xComp.uArea);
+					vecComponent.push_back(xComp);
+				}
+			}
+
+			return uLabel;
+		}
+
+		template<typename TValue>
+		static void TestLabel(EDataType eDataType, int iRange)
+		{
+			// Tall images are split into several bands, whose labels are merged.
+			const int piSize[][2] = { { 1, 1 }, { 1, 9 }, { 9, 1 }, { 17, 19 }, { 40, 33 }, { 64, 300 } };
+			std::mt19937 xRandom(unsigned(eDataType) + 1);
+
+			for (const auto& piWH : piSize)
+			{
+				for (bool bEight : { false, true })
+				{
+					for (bool bIgnoreInvalid : { false, true })
+					{
+						for (double dMaxDifference : { 0.0, 1.0, 2.5 })
+						{
+							CIImage imgSrc(SImageFormat(piWH[0], piWH[1], EPixelType::Lum, eDataType));
+							for (int iY = 0; iY < piWH[1]; ++iY)
+							{
+								for (int iX = 0; iX < piWH[0]; ++iX)
+								{
+									int iValue = int(xRandom() % unsigned(iRange)) + ((iX / 7 + iY / 5) % 3) * 4;
+									iValue = bIgnoreInvalid && xRandom() % 4 == 0 ? 0 : iValue;
+									Pixel<TValue>(imgSrc, iX, iY)[0] = std::is_integral<TValue>::value ? TValue(iValue) : TValue(iValue * 0.5);
+								}
+							}
+
+							const EConnectivity eConnect = bEight ? EConnectivity::Eight : EConnectivity::Four;
+							const SLabelConfig xConfig = bIgnoreInvalid ? SLabelConfig(eConnect, dMaxDifference, 0.0) : SLabelConfig(eConnect, dMaxDifference);
+
+							CIImage imgLabel;
+							std::vector<SComponent> vecComp, vecRefComp;
+							std::vector<uint32_t> vecRefLabel;
+							const size_t nCount = LabelImage(imgLabel, vecComp, imgSrc, xConfig);
+							const size_t nRefCount = LabelRef<TValue>(vecRefLabel, vecRefComp, imgSrc, bEight, dMaxDifference, bIgnoreInvalid, TValue(0));
+
+							Assert::IsTrue(nCount == nRefCount && vecComp.size() == nRefCount, L"Labeling found the wrong number of components");
+							for (int iY = 0; iY < piWH[1]; ++iY)
+							{
+								for (int iX = 0; iX < piWH[0]; ++iX)
+								{
+									Assert::IsTrue(Pixel<uint32_t>(imgLabel, iX, iY)[0] == vecRefLabel[size_t(iY) * piWH[0] + iX], L"Label differs from the flood fill");
+								}
+							}
+
+							for (size_t nComp = 0; nComp < nCount; ++nComp)
+							{
+								const SComponent& xA = vecComp[nComp];
+								const SComponent& xB = vecRefComp[nComp];
+								Assert::IsTrue(xA.uArea == xB.uArea && xA.iMinX == xB.iMinX && xA.iMaxX == xB.iMaxX && xA.iMinY == xB.iMinY && xA.iMaxY == xB.iMaxY
+									&& fabs(xA.dCentroidX - xB.dCentroidX) < 1e-9 && fabs(xA.dCentroidY - xB.dCentroidY) < 1e-9, L"Component differs from the flood fill");
+							}
+
+							if (!bIgnoreInvalid)
+							{
+								continue;
+							}
+
+							// Speckles are the components of at most the given area, which are set to the invalid value.
+							for (size_t nMaxArea : { size_t(0), size_t(1), size_t(5) })
+							{
+								CIImage imgImage = imgSrc.Copy();
+								const size_t nRemoved = RemoveSpeckles(imgImage, xConfig, nMaxArea);
+
+								size_t nExpected = 0;
+								for (int iY = 0; iY < piWH[1]; ++iY)
+								{
+									for (int iX = 0; iX < piWH[0]; ++iX)
+									{
+										const uint32_t uLabel = vecRefLabel[size_t(iY) * piWH[0] + iX];
+										const bool bSpeckle = uLabel != 0 && vecRefComp[uLabel - 1].uArea <= nMaxArea;
+										nExpected += bSpeckle ? 1 : 0;
+										Assert::IsTrue(Pixel<TValue>(imgImage, iX, iY)[0] == (bSpeckle ? TValue(0) : Pixel<TValue>(imgSrc, iX, iY)[0]), L"Speckle removal differs from the flood fill");
+									}
+								}
+								Assert::IsTrue(nRemoved == nExpected, L"Speckle removal returned the wrong pixel count");
+							}
+						}
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(LabelMatchesFloodFill)
+		{
+			try
+			{
+				TestLabel<uint8_t>(EDataType::UInt8, 4);
+				TestLabel<int8_t>(EDataType::Int8, 4);
+				TestLabel<uint16_t>(EDataType::UInt16, 6);
+				TestLabel<int16_t>(EDataType::Int16, 3);
+				TestLabel<int32_t>(EDataType::Int32, 6);
+				TestLabel<float>(EDataType::Single, 6);
+
+				bool bThrown = false;
+				try
+				{
+					CIImage imgSrc(SImageFormat(8, 8, EPixelType::RGB, EDataType::UInt8)), imgLabel;
+					std::vector<SComponent> vecComp;
+					LabelImage(imgLabel, vecComp, imgSrc, SLabelConfig());
+				}
+				catch (Clu::CIException&)
+				{
+					bThrown = true;
+				}
+				Assert::IsTrue(bThrown, L"Labeling an RGB image did not throw");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      MedianTest1.cpp
+//
+// summary:   Implements the median test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Median.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(MedianTest1)
+	{
+	public:
+		// The lower median of the sorted values in the clipped window, leaving out the invalid value.
+		template<typename TValue>
+		static void MedianRef(CIImage& imgTrg, const CIImage& imgSrc, int iRadius, bool bIgnoreInvalid, TValue tInvalid)
+		{
+			const int iWidth = imgSrc.Format().iWidth, iHeight = imgSrc.Format().iHeight;
+			imgTrg.Create(SImageFormat(iWidth, iHeight, EPixelType::Lum, imgSrc.Format().eDataType));
+
+			std::vector<TValue> vecValue;
+			for (int iY = 0; iY < iHeight; ++iY)
+			{
+				for (int iX = 0; iX < iWidth; ++iX)
+				{
+					vecValue.clear();
+					if (!bIgnoreInvalid || Pixel<TValue>(imgSrc, iX, iY)[0] != tInvalid)
+					{
+						for (int iJ = std::max(0, iY - iRadius); iJ <= std::min(iHeight - 1, iY + iRadius); ++iJ)
+						{
+							for (int iI = std::max(0, iX - iRadius); iI <= std::min(iWidth - 1, iX + iRadius); ++iI)
+							{
+								const TValue tValue = Pixel<TValue>(imgSrc, iI, iJ)[0];
+								if (!bIgnoreInvalid || tValue != tInvalid)
+								{
+									vecValue.push_back(tValue);
+								}
+							}
+						}
+					}
+
+					std::sort(vecValue.begin(), vecValue.end());
+					Pixel<TValue>(imgTrg, iX, iY)[0] = vecValue.empty() ? tInvalid : vecValue[(vecValue.size() - 1) / 2];
+				}
+			}
+		}
+
+		template<typename TValue>
+		static void TestMedian(EDataType eDataType, unsigned uMaxValue)
+		{
+			const int piSize[][2] = { { 1, 1 }, { 1, 9 }, { 9, 1 }, { 17, 19 }, { 40, 13 } };
+			std::mt19937 xRandom(unsigned(eDataType) + uMaxValue);
+
+			for (const auto& piWH : piSize)
+			{
+				for (int iInvalidMode = 0; iInvalidMode < 3; ++iInvalidMode)
+				{
+					const TValue tInvalid = TValue(iInvalidMode == 2 ? uMaxValue : 0);
+
+					CIImage imgSrc(SImageFormat(piWH[0], piWH[1], EPixelType::Lum, eDataType));
+					for (int iY = 0; iY < piWH[1]; ++iY)
+					{
+						for (int iX = 0; iX < piWH[0]; ++iX)
+						{
+							const bool bInvalid = iInvalidMode != 0 && xRandom() % 3 == 0;
+							Pixel<TValue>(imgSrc, iX, iY)[0] = bInvalid ? tInvalid : TValue(xRandom() % (uMaxValue + 1));
+						}
+					}
+
+					for (int iRadius : { 0, 1, 2, 3, 5, 8 })
+					{
+						const SMedianConfig xConfig = iInvalidMode ? SMedianConfig(iRadius, double(tInvalid)) : SMedianConfig(iRadius);
+
+						CIImage imgTrg, imgRef;
+						MedianImage(imgTrg, imgSrc, xConfig);
+						MedianRef<TValue>(imgRef, imgSrc, iRadius, iInvalidMode != 0, tInvalid);
+						Assert::IsTrue(IsEqual<TValue>(imgTrg, imgRef), L"Median differs from the scalar reference");
+					}
+				}
+			}
+
+			CIImage imgSrc(SImageFormat(50, 40, EPixelType::Lum, eDataType)), imgRef;
+			for (int iY = 0; iY < 40; ++iY)
+			{
+				for (int iX = 0; iX < 50; ++iX)
+				{
+					Pixel<TValue>(imgSrc, iX, iY)[0] = TValue((iX * 7 + iY * 13) % 97);
+				}
+			}
+
+			CIImage imgInPlace = imgSrc.Copy();
+			MedianImage(imgInPlace, imgInPlace, SMedianConfig(4));
+			MedianRef<TValue>(imgRef, imgSrc, 4, false, TValue(0));
+			Assert::IsTrue(IsEqual<TValue>(imgInPlace, imgRef), L"In place median differs from the scalar reference");
+		}
+
+		TEST_METHOD(MedianMatchesScalarReference)
+		{
+			try
+			{
+				TestMedian<uint8_t>(EDataType::UInt8, 255);
+				TestMedian<uint16_t>(EDataType::UInt16, 4095);
+				TestMedian<uint16_t>(EDataType::UInt16, 65535);
+				TestMedian<float>(EDataType::Single, 1000);
+
+				bool bThrown = false;
+				try
+				{
+					CIImage imgSrc(SImageFormat(8, 8, EPixelType::RGB, EDataType::UInt8)), imgTrg;
+					MedianImage(imgTrg, imgSrc, SMedianConfig(1));
+				}
+				catch (Clu::CIException&)
+				{
+					bThrown = true;
+				}
+				Assert::IsTrue(bThrown, L"Median of an RGB image did not throw");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(MedianKeepsSourceShared)
+		{
+			try
+			{
+				std::mt19937 xRandom(1);
+				CIImage imgA(SImageFormat(37, 23, EPixelType::Lum, EDataType::UInt8));
+				FillRandom<uint8_t>(imgA, xRandom, 0.0, 256.0);
+
+				// Median filtering a copy only reads the memory it shares with the original.
+				const CIImage imgB = imgA.Copy();
+				CIImage imgTrg;
+				MedianImage(imgTrg, imgB, SMedianConfig(2));
+				Assert::IsTrue(!imgA.IsUnique() && ((const CIImage&)imgA).DataPointer() == imgB.DataPointer(), L"Median filtering detached the shared source");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
@@ -0,0 +1,228 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      MorphologyTest1.cpp
+//
+// summary:   Implements the morphology test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.ImgProc/Image.Morphology.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(MorphologyTest1)
+	{
+	public:
+		// Erodes or dilates with a rectangle that is clipped at the image border, one direction after the other.
+		template<typename TValue>
+		static void MorphRef(CIImage& imgTrg, const CIImage& imgSrc, bool bMin, int iRadiusX, int iRadiusY)
+		{
+			const SImageFormat& xFormat = imgSrc.Format();
+			const int iWidth = xFormat.iWidth, iHeight = xFormat.iHeight;
+			const int iChannelCount = int(SImageType::DimOf(xFormat.ePixelType));
+			auto Select = [bMin](TValue tA, TValue tB) { return bMin ? std::min(tA, tB) : std::max(tA, tB); };
+
+			CIImage imgRow(SImageFormat(iWidth, iHeight, xFormat.ePixelType, xFormat.eDataType));
+			imgTrg.Create(SImageFormat(iWidth, iHeight, xFormat.ePixelType, xFormat.eDataType));
+
+			for (int iY = 0; iY < iHeight; ++iY)
+			{
+				for (int iX = 0; iX < iWidth; ++iX)
+				{
+					for (int iC = 0; iC < iChannelCount; ++iC)
+					{
+						TValue tValue = Pixel<TValue>(imgSrc, iX, iY)[iC];
+						for (int iI = std::max(0, iX - iRadiusX); iI <= std::min(iWidth - 1, iX + iRadiusX); ++iI)
+						{
+							tValue = Select(tValue, Pixel<TValue>(imgSrc, iI, iY)[iC]);
+						}
+						Pixel<TValue>(imgRow, iX, iY)[iC] = tValue;
+					}
+				}
+			}
+
+			for (int iY = 0; iY < iHeight; ++iY)
+			{
+				for (int iX = 0; iX < iWidth; ++iX)
+				{
+					for (int iC = 0; iC < iChannelCount; ++iC)
+					{
+						TValue tValue = Pixel<TValue>(imgRow, iX, iY)[iC];
+						for (int iJ = std::max(0, iY - iRadiusY); iJ <= std::min(iHeight - 1, iY + iRadiusY); ++iJ)
+						{
+							tValue = Select(tValue, Pixel<TValue>(imgRow, iX, iJ)[iC]);
+						}
+						Pixel<TValue>(imgTrg, iX, iY)[iC] = tValue;
+					}
+				}
+			}
+		}
+
+		template<typename TValue>
+		static void TestMorph(EDataType eDataType, double dMin, double dMax)
+		{
+			const int piRadius[][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 2, 3 }, { 7, 5 }, { 300, 300 } };
+			std::mt19937 xRandom(unsigned(eDataType) + 1);
+
+			for (EPixelType ePixelType : { EPixelType::Lum, EPixelType::LumA, EPixelType::RGB, EPixelType::RGBA })
+			{
+				for (int iWidth : c_piOddWidth)
+				{
+					// The view starts one pixel into the row, so that the SIMD loads are not aligned.
+					CIImage imgBig(SImageFormat(iWidth + 1, 10, ePixelType, eDataType));
+					FillRandom<TValue>(imgBig, xRandom, dMin, dMax);
+					const CIImage imgSrc = imgBig.CropView(1, 1, iWidth, 9);
+
+					for (const auto& piR : piRadius)
+					{
+						CIImage imgErode, imgDilate, imgRefErode, imgRefDilate, imgTrg, imgRef;
+
+						MorphImage(imgErode, imgSrc, EMorphOp::Erode, piR[0], piR[1]);
+						MorphRef<TValue>(imgRefErode, imgSrc, true, piR[0], piR[1]);
+						Assert::IsTrue(IsEqual<TValue>(imgErode, imgRefErode), L"Erosion differs from the scalar reference");
+
+						MorphImage(imgDilate, imgSrc, EMorphOp::Dilate, piR[0], piR[1]);
+						MorphRef<TValue>(imgRefDilate, imgSrc, false, piR[0], piR[1]);
+						Assert::IsTrue(IsEqual<TValue>(imgDilate, imgRefDilate), L"Dilation differs from the scalar reference");
+
+						MorphImage(imgTrg, imgSrc, EMorphOp::Open, piR[0], piR[1]);
+						MorphRef<TValue>(imgRef, imgRefErode, false, piR[0], piR[1]);
+						Assert::IsTrue(IsEqual<TValue>(imgTrg, imgRef), L"Opening differs from the scalar reference");
+
+						MorphImage(imgTrg, imgSrc, EMorphOp::Close, piR[0], piR[1]);
+						MorphRef<TValue>(imgRef, imgRefDilate, true, piR[0], piR[1]);
+						Assert::IsTrue(IsEqual<TValue>(imgTrg, imgRef), L"Closing differs from the scalar reference");
+
+						CIImage imgInPlace = imgSrc.Copy();
+						MorphImage(imgInPlace, imgInPlace, EMorphOp::Dilate, piR[0], piR[1]);
+						Assert::IsTrue(IsEqual<TValue>(imgInPlace, imgRefDilate), L"In place dilation differs from the scalar reference");
+					}
+				}
+			}
+
+			// Each layer of a layer image is processed like a Lum image.
+			CILayerImage imgLayer(SImageFormat(23, 17, EPixelType::RGB, eDataType));
+			for (size_t nLayer = 0; nLayer < imgLayer.LayerCount(); ++nLayer)
+			{
+				for (int iY = 0; iY < 17; ++iY)
+				{
+					TValue* pRow = (TValue*)((unsigned char*)imgLayer.DataPointer(nLayer) + iY * imgLayer.LayerRowPitch());
+					for (int iX = 0; iX < 23; ++iX)
+					{
+						pRow[iX] = TValue(xRandom() % 200);
+					}
+				}
+			}
+
+			CILayerImage imgLayerTrg;
+			MorphImage(imgLayerTrg, imgLayer, EMorphOp::Erode, 2, 1);
+
+			for (size_t nLayer = 0; nLayer < imgLayer.LayerCount(); ++nLayer)
+			{
+				CIImage imgLum(SImageFormat(23, 17, EPixelType::Lum, eDataType)), imgRef;
+				for (int iY = 0; iY < 17; ++iY)
+				{
+					memcpy(Pixel<TValue>(imgLum, 0, iY), (const unsigned char*)((const CILayerImage&)imgLayer).DataPointer(nLayer) + iY * imgLayer.LayerRowPitch(), 23 * sizeof(TValue));
+				}
+
+				MorphRef<TValue>(imgRef, imgLum, true, 2, 1);
+				for (int iY = 0; iY < 17; ++iY)
+				{
+					const unsigned char* pRow = (const unsigned char*)((const CILayerImage&)imgLayerTrg).DataPointer(nLayer) + iY * imgLayerTrg.LayerRowPitch();
+					Assert::IsTrue(memcmp(pRow, Pixel<TValue>(imgRef, 0, iY), 23 * sizeof(TValue)) == 0, L"Layer erosion differs from the scalar reference");
+				}
+			}
+		}
+
+		TEST_METHOD(MorphMatchesScalarReference)
+		{
+			try
+			{
+				TestMorph<uint8_t>(EDataType::UInt8, 0.0, 256.0);
+				TestMorph<uint16_t>(EDataType::UInt16, 0.0, 65536.0);
+				TestMorph<float>(EDataType::Single, -500.0, 500.0);
+
+				bool bThrown = false;
+				try
+				{
+					CIImage imgSrc(SImageFormat(4, 4, EPixelType::Lum, EDataType::UInt8)), imgTrg;
+					MorphImage(imgTrg, imgSrc, EMorphOp::Erode, -1, 1);
+				}
+				catch (Clu::CIException&)
+				{
+					bThrown = true;
+				}
+				Assert::IsTrue(bThrown, L"Negative radius did not throw");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(MorphKeepsSourceShared)
+		{
+			try
+			{
+				std::mt19937 xRandom(1);
+				CIImage imgA(SImageFormat(37, 23, EPixelType::RGB, EDataType::UInt8));
+				FillRandom<uint8_t>(imgA, xRandom, 0.0, 256.0);
+
+				// Eroding a copy only reads the memory it shares with the original.
+				const CIImage imgB = imgA.Copy();
+				CIImage imgTrg;
+				MorphImage(imgTrg, imgB, EMorphOp::Erode, 2, 1);
+				Assert::IsTrue(!imgA.IsUnique() && ((const CIImage&)imgA).DataPointer() == imgB.DataPointer(), L"Eroding detached the shared source");
+
+				CILayerImage imgLayerA(SImageFormat(37, 23, EPixelType::RGB, EDataType::UInt8));
+				for (size_t nLayer = 0; nLayer < imgLayerA.LayerCount(); ++nLayer)
+				{
+					memset(imgLayerA.DataPointer(nLayer), int(nLayer), imgLayerA.LayerRowPitch() * 23);
+				}
+
+				const CILayerImage imgLayerB = imgLayerA.Copy();
+				CILayerImage imgLayerTrg;
+				MorphImage(imgLayerTrg, imgLayerB, EMorphOp::Erode, 2, 1);
+				Assert::IsTrue(!imgLayerA.IsUnique() && ((const CILayerImage&)imgLayerA).DataPointer(0) == imgLayerB.DataPointer(0), L"Eroding detached the shared layer source");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
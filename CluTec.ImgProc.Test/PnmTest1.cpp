@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      PnmTest1.cpp
+//
+// summary:   Implements the PNM file test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <stdio.h>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Pnm.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(PnmTest1)
+	{
+	public:
+		template<typename TValue>
+		static void TestPnm(EPixelType ePixelType, EDataType eDataType, double dMin, double dMax)
+		{
+			const char* pcFilename = "CluTec.ImgProc.Test.pnm";
+			std::mt19937 xRandom(unsigned(eDataType) + unsigned(ePixelType));
+
+			for (int iWidth : { 1, 5, 37, 128 })
+			{
+				for (int iHeight : { 1, 12, 31 })
+				{
+					CIImage imgSrc(SImageFormat(iWidth, iHeight, ePixelType, eDataType));
+					FillRandom<TValue>(imgSrc, xRandom, dMin, dMax);
+					const size_t nRowBytes = imgSrc.Format().RowByteCount();
+
+					CIImage imgTrg;
+					WritePnm(pcFilename, imgSrc);
+					ReadPnm(imgTrg, pcFilename);
+					Assert::IsTrue(IsEqual<TValue>(imgTrg, imgSrc), L"Read PNM image differs from the written image");
+
+					imgTrg.Create(imgSrc.Format());
+					ReadPnmBands(pcFilename, 7, [&](const CIImage& imgBand, int iY)
+					{
+						for (int iRow = 0; iRow < imgBand.Format().iHeight; ++iRow)
+						{
+							memcpy(Pixel<TValue>(imgTrg, 0, iY + iRow), Pixel<TValue>(imgBand, 0, iRow), nRowBytes);
+						}
+					});
+					Assert::IsTrue(IsEqual<TValue>(imgTrg, imgSrc), L"PNM image read in bands differs from the written image");
+
+					WritePnmBands(pcFilename, imgSrc.Format(), 5, [&](CIImage& imgBand, int iY)
+					{
+						for (int iRow = 0; iRow < imgBand.Format().iHeight; ++iRow)
+						{
+							memcpy(Pixel<TValue>(imgBand, 0, iRow), Pixel<TValue>(imgSrc, 0, iY + iRow), nRowBytes);
+						}
+					});
+					ReadPnm(imgTrg, pcFilename);
+					Assert::IsTrue(IsEqual<TValue>(imgTrg, imgSrc), L"PNM image written in bands differs from the source");
+				}
+			}
+
+			remove(pcFilename);
+		}
+
+		TEST_METHOD(PnmRoundtrip)
+		{
+			try
+			{
+				TestPnm<uint8_t>(EPixelType::Lum, EDataType::UInt8, 0.0, 256.0);
+				TestPnm<uint8_t>(EPixelType::RGB, EDataType::UInt8, 0.0, 256.0);
+				TestPnm<uint16_t>(EPixelType::Lum, EDataType::UInt16, 0.0, 65536.0);
+				TestPnm<uint16_t>(EPixelType::RGB, EDataType::UInt16, 0.0, 65536.0);
+				TestPnm<float>(EPixelType::Lum, EDataType::Single, -5.0, 5.0);
+				TestPnm<float>(EPixelType::RGB, EDataType::Single, -5.0, 5.0);
+
+				bool bThrown = false;
+				try
+				{
+					CIImage imgSrc(SImageFormat(4, 4, EPixelType::RGBA, EDataType::UInt8));
+					WritePnm("CluTec.ImgProc.Test.pnm", imgSrc);
+				}
+				catch (Clu::CIException&)
+				{
+					bThrown = true;
+				}
+				Assert::IsTrue(bThrown, L"Writing an RGBA image as PNM did not throw");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(PnmSwapsToBigEndian)
+		{
+			try
+			{
+				// The rows are long enough for the vector loops and have a tail.
+				const char* pcFilename = "CluTec.ImgProc.Test.pnm";
+				const int iWidth = 37, iHeight = 3;
+				std::mt19937 xRandom(3);
+
+				// 16 bit samples are written most significant byte first.
+				CIImage imgSrc(SImageFormat(iWidth, iHeight, EPixelType::RGB, EDataType::UInt16));
+				FillRandom<uint16_t>(imgSrc, xRandom, 0.0, 65536.0);
+				WritePnm(pcFilename, imgSrc);
+
+				std::vector<unsigned char> vecFile;
+				{
+					std::ifstream xFile(pcFilename, std::ios::binary);
+					vecFile.assign(std::istreambuf_iterator<char>(xFile), std::istreambuf_iterator<char>());
+				}
+
+				const size_t nDataBytes = size_t(iWidth * iHeight * 3 * 2);
+				Assert::IsTrue(vecFile.size() > nDataBytes, L"PGM file is too short");
+				const unsigned char* pucData = vecFile.data() + vecFile.size() - nDataBytes;
+
+				for (int iY = 0; iY < iHeight; ++iY)
+				{
+					for (int iIdx = 0; iIdx < 3 * iWidth; ++iIdx, pucData += 2)
+					{
+						const uint16_t uValue = Pixel<uint16_t>(imgSrc, 0, iY)[iIdx];
+						Assert::IsTrue(pucData[0] == (uValue >> 8) && pucData[1] == (uValue & 0xFF), L"PGM sample is not big endian");
+					}
+				}
+
+				// A positive PFM scale denotes big endian floats. The rows are stored bottom up.
+				CIImage imgFloat(SImageFormat(iWidth, iHeight, EPixelType::RGB, EDataType::Single));
+				FillRandom<float>(imgFloat, xRandom, -5.0, 5.0);
+				{
+					std::ofstream xFile(pcFilename, std::ios::binary);
+					xFile << "PF\n" << iWidth << " " << iHeight << "\n1.0\n";
+
+					for (int iY = iHeight - 1; iY >= 0; --iY)
+					{
+						for (int iIdx = 0; iIdx < 3 * iWidth; ++iIdx)
+						{
+							uint32_t uValue;
+							memcpy(&uValue, Pixel<float>(imgFloat, 0, iY) + iIdx, 4);
+							const char pcBytes[4] = { char(uValue >> 24), char(uValue >> 16), char(uValue >> 8), char(uValue) };
+							xFile.write(pcBytes, 4);
+						}
+					}
+				}
+
+				CIImage imgTrg;
+				ReadPnm(imgTrg, pcFilename);
+				Assert::IsTrue(IsEqual<float>(imgTrg, imgFloat), L"Big endian PFM image differs from the source");
+
+				remove(pcFilename);
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
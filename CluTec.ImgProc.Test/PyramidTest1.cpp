@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      PyramidTest1.cpp
+//
+// summary:   Implements the pyramid test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Pyramid.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(PyramidTest1)
+	{
+	public:
+		// The reference value of a pixel of the next pyramid level.
+		template<typename TValue>
+		static double PyramidValue(const CIImage& imgSrc, int iX, int iY, int iC, EPyramidFilter eFilter, int iTrgWidth, int iTrgHeight)
+		{
+			const int iWidth = imgSrc.Format().iWidth;
+			const int iHeight = imgSrc.Format().iHeight;
+			auto S = [&](int iSrcX, int iSrcY) { return double(Pixel<TValue>(imgSrc, iSrcX, iSrcY)[iC]); };
+			auto Mirror = [](int iIdx, int iCount) { iIdx = iIdx < 0 ? -iIdx : iIdx; iIdx = iIdx >= iCount ? 2 * (iCount - 1) - iIdx : iIdx; return std::min(std::max(iIdx, 0), iCount - 1); };
+
+			if (eFilter == EPyramidFilter::Box2x2)
+			{
+				return (S(2 * iX, 2 * iY) + S(2 * iX + 1, 2 * iY) + S(2 * iX, 2 * iY + 1) + S(2 * iX + 1, 2 * iY + 1)) / 4.0;
+			}
+
+			if (eFilter == EPyramidFilter::Gaussian5)
+			{
+				const int piWeight[5] = { 1, 4, 6, 4, 1 };
+				double dSum = 0.0;
+				for (int iJ = 0; iJ < 5; ++iJ)
+				{
+					for (int iI = 0; iI < 5; ++iI)
+					{
+						dSum += piWeight[iI] * piWeight[iJ] * S(Mirror(2 * iX + iI - 2, iWidth), Mirror(2 * iY + iJ - 2, iHeight));
+					}
+				}
+				return dSum / 256.0;
+			}
+
+			// The area filter weighs each source pixel with its overlap with the target pixel.
+			const double dScaleX = double(iWidth) / iTrgWidth;
+			const double dScaleY = double(iHeight) / iTrgHeight;
+			double dSum = 0.0;
+			for (int iSrcY = 0; iSrcY < iHeight; ++iSrcY)
+			{
+				const double dWeightY = std::max(0.0, std::min(iSrcY + 1.0, (iY + 1) * dScaleY) - std::max(double(iSrcY), iY * dScaleY));
+				for (int iSrcX = 0; iSrcX < iWidth && dWeightY > 0.0; ++iSrcX)
+				{
+					const double dWeightX = std::max(0.0, std::min(iSrcX + 1.0, (iX + 1) * dScaleX) - std::max(double(iSrcX), iX * dScaleX));
+					dSum += dWeightX * dWeightY * S(iSrcX, iSrcY);
+				}
+			}
+			return dSum / (dScaleX * dScaleY);
+		}
+
+		template<typename TValue>
+		static void TestPyramid(EPixelType ePixelType, EDataType eDataType, int iWidth, int iHeight, EPyramidFilter eFilter, double dMin, double dMax)
+		{
+			std::mt19937 xRandom(unsigned(iWidth * 7 + iHeight));
+			CIImage imgSrc(SImageFormat(iWidth, iHeight, ePixelType, eDataType));
+			FillRandom<TValue>(imgSrc, xRandom, dMin, dMax);
+
+			CImagePyramid xPyramid;
+			xPyramid.Create(imgSrc, 0, eFilter);
+
+			const int iChannelCount = int(SImageType::DimOf(ePixelType));
+			for (int iLevel = 1; iLevel < xPyramid.LevelCount(); ++iLevel)
+			{
+				const CIImage& imgA = xPyramid.Level(iLevel - 1);
+				const CIImage& imgB = xPyramid.Level(iLevel);
+				Assert::IsTrue(imgB.Format().iWidth == (iWidth >> iLevel) && imgB.Format().iHeight == (iHeight >> iLevel), L"Pyramid level has the wrong size");
+
+				for (int iY = 0; iY < imgB.Format().iHeight; ++iY)
+				{
+					for (int iX = 0; iX < imgB.Format().iWidth; ++iX)
+					{
+						for (int iC = 0; iC < iChannelCount; ++iC)
+						{
+							const double dRef = PyramidValue<TValue>(imgA, iX, iY, iC, eFilter, imgB.Format().iWidth, imgB.Format().iHeight);
+							const double dValue = double(Pixel<TValue>(imgB, iX, iY)[iC]);
+							const double dTolerance = std::is_integral<TValue>::value ? 0.5 + 1e-9 : 1e-4 * std::max(1.0, fabs(dRef));
+							Assert::IsTrue(fabs(dValue - dRef) <= dTolerance, L"Pyramid level differs from the scalar reference");
+						}
+					}
+				}
+			}
+
+			// Updating a changed region has to give the same levels as creating the pyramid again.
+			const int iX0 = iWidth / 3, iY0 = iHeight / 4, iW = std::max(1, iWidth / 3), iH = std::max(1, iHeight / 2);
+			for (int iY = iY0; iY < iY0 + iH; ++iY)
+			{
+				for (int iX = iX0; iX < iX0 + iW; ++iX)
+				{
+					Pixel<TValue>(imgSrc, iX, iY)[0] = TValue(dMin);
+				}
+			}
+
+			xPyramid.Update(iX0, iY0, iW, iH);
+
+			CImagePyramid xCreated;
+			xCreated.Create(imgSrc, 0, eFilter);
+			for (int iLevel = 0; iLevel < xPyramid.LevelCount(); ++iLevel)
+			{
+				Assert::IsTrue(IsEqual<TValue>(xPyramid.Level(iLevel), xCreated.Level(iLevel)), L"Updated pyramid differs from a new pyramid");
+			}
+		}
+
+		TEST_METHOD(PyramidMatchesScalarReference)
+		{
+			try
+			{
+				const int piSize[][2] = { { 64, 48 }, { 37, 23 }, { 5, 3 }, { 2, 2 } };
+
+				for (EPyramidFilter eFilter : { EPyramidFilter::Box2x2, EPyramidFilter::Gaussian5, EPyramidFilter::Area })
+				{
+					for (const auto& piWH : piSize)
+					{
+						TestPyramid<uint8_t>(EPixelType::Lum, EDataType::UInt8, piWH[0], piWH[1], eFilter, 0.0, 256.0);
+						TestPyramid<uint8_t>(EPixelType::RGBA, EDataType::UInt8, piWH[0], piWH[1], eFilter, 0.0, 256.0);
+						TestPyramid<uint8_t>(EPixelType::RGB, EDataType::UInt8, piWH[0], piWH[1], eFilter, 0.0, 256.0);
+						TestPyramid<uint16_t>(EPixelType::LumA, EDataType::UInt16, piWH[0], piWH[1], eFilter, 0.0, 65536.0);
+						TestPyramid<int16_t>(EPixelType::Lum, EDataType::Int16, piWH[0], piWH[1], eFilter, -32768.0, 32768.0);
+						TestPyramid<float>(EPixelType::RGBA, EDataType::Single, piWH[0], piWH[1], eFilter, -1.0, 1.0);
+						TestPyramid<double>(EPixelType::Lum, EDataType::Double, piWH[0], piWH[1], eFilter, -1.0, 1.0);
+					}
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(ReduceKeepsSourceShared)
+		{
+			try
+			{
+				CIImage imgA(SImageFormat(37, 23, EPixelType::RGB, EDataType::UInt8));
+				std::mt19937 xRandom(1);
+				FillRandom<uint8_t>(imgA, xRandom, 0.0, 256.0);
+
+				// Reducing a copy only reads the memory it shares with the original.
+				const CIImage imgB = imgA.Copy();
+				CIImage imgTrg;
+				ReduceImage(imgTrg, imgB, EPyramidFilter::Gaussian5);
+				Assert::IsTrue(!imgA.IsUnique() && ((const CIImage&)imgA).DataPointer() == imgB.DataPointer(), L"Reducing detached the shared source");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
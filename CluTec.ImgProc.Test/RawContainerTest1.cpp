@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      RawContainerTest1.cpp
+//
+// summary:   Implements the raw container test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <stdio.h>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.RawContainer.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(RawContainerTest1)
+	{
+	public:
+		TEST_METHOD(RawContainerRoundtrip)
+		{
+			const char* pcFilename = "CluTec.ImgProc.Test.raw";
+
+			try
+			{
+				const SImageFormat xFormat(37, 23, EPixelType::RGB, EDataType::UInt16);
+				std::mt19937 xRandom(1);
+				std::vector<CIImage> vecFrame;
+
+				{
+					// Append more frames than expected, and one frame from a view.
+					CRawContainerWriter xWriter;
+					xWriter.Create(pcFilename, xFormat, 3, true);
+					for (int iFrame = 0; iFrame < 5; ++iFrame)
+					{
+						CIImage imgFrame(SImageFormat(50, 30, EPixelType::RGB, EDataType::UInt16));
+						FillRandom<uint16_t>(imgFrame, xRandom, 0.0, 65536.0);
+						vecFrame.push_back(iFrame == 2 ? imgFrame.CropView(3, 4, 37, 23) : imgFrame.CropView(0, 0, 37, 23).Copy());
+						xWriter.Append(vecFrame.back(), iFrame * 10);
+					}
+					xWriter.Close();
+				}
+
+				{
+					CRawContainerReader xReader;
+					xReader.Open(pcFilename);
+					Assert::IsTrue(xReader.FrameCount() == 5, L"Wrong frame count");
+
+					for (size_t nFrame = 0; nFrame < 5; ++nFrame)
+					{
+						Assert::IsTrue(xReader.Timestamp(nFrame) == int64_t(nFrame) * 10, L"Wrong timestamp");
+						Assert::IsTrue(IsEqual<uint16_t>(xReader.Frame(nFrame), vecFrame[nFrame]), L"Read frame differs from the appended frame");
+					}
+
+					Assert::IsTrue(xReader.FindFrame(-1) == 5 && xReader.FindFrame(0) == 0 && xReader.FindFrame(15) == 1
+						&& xReader.FindFrame(40) == 4 && xReader.FindFrame(1000) == 4, L"Wrong frame found for timestamp");
+
+					// Writing to a frame changes the private mapping of the reader, but not the file.
+					CIImage imgFrame = xReader.Frame(0);
+					Pixel<uint16_t>(imgFrame, 0, 0)[0] ^= 0xFFFF;
+
+					CRawContainerReader xOtherReader;
+					xOtherReader.Open(pcFilename);
+					Assert::IsTrue(IsEqual<uint16_t>(xOtherReader.Frame(0), vecFrame[0]), L"Writing to a frame changed the container");
+					xOtherReader.Close();
+					xReader.Close();
+				}
+
+				{
+					CRawContainerWriter xWriter;
+					xWriter.Create(pcFilename, xFormat);
+					xWriter.Close();
+
+					CRawContainerReader xReader;
+					xReader.Open(pcFilename);
+					Assert::IsTrue(xReader.FrameCount() == 0 && xReader.FindFrame(5) == 0, L"Empty container has frames");
+					xReader.Close();
+				}
+
+				bool bThrown = false;
+				{
+					CRawContainerWriter xWriter;
+					xWriter.Create(pcFilename, xFormat);
+					xWriter.Append(vecFrame[0], 1);
+
+					try
+					{
+						CRawContainerReader xReader;
+						xReader.Open(pcFilename);
+					}
+					catch (Clu::CIException&)
+					{
+						bThrown = true;
+					}
+				}
+				Assert::IsTrue(bThrown, L"Opening a container that was not closed did not throw");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				remove(pcFilename);
+				Assert::Fail(L"Exception thrown");
+			}
+
+			remove(pcFilename);
+		}
+	};
+}
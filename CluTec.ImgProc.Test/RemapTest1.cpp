@@ -0,0 +1,428 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      RemapTest1.cpp
+//
+// summary:   Implements the remap test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.ImgProc/Image.Remap.h"
+#include "CluTec.ImgProc/Camera.Remap.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(RemapTest1)
+	{
+	public:
+		// The reference of a remapped pixel from the LUT entry, with the fixed point fractions of 5 bit.
+		template<typename TValue>
+		static double RemapValue(const CIImage& imgSrc, const CRemapLut::SEntry& xEntry, int iC, ERemapInterpolation eInterp, EBorderMode eBorder, double dBorderValue)
+		{
+			if (xEntry.uFraction & CRemapLut::InvalidFraction)
+			{
+				return dBorderValue;
+			}
+
+			const int iFracX = xEntry.uFraction & 31;
+			const int iFracY = (xEntry.uFraction >> 5) & 31;
+			auto S = [&](ptrdiff_t iX, ptrdiff_t iY)
+			{
+				const ptrdiff_t iSrcX = BorderIndex(iX, imgSrc.Format().iWidth, eBorder);
+				const ptrdiff_t iSrcY = BorderIndex(iY, imgSrc.Format().iHeight, eBorder);
+				return (iSrcX < 0 || iSrcY < 0) ? dBorderValue : double(Pixel<TValue>(imgSrc, int(iSrcX), int(iSrcY))[iC]);
+			};
+
+			if (eInterp == ERemapInterpolation::Nearest)
+			{
+				return S(xEntry.iX + (iFracX >= 16), xEntry.iY + (iFracY >= 16));
+			}
+
+			auto Weights = [&](double dT, double* pdWeight)
+			{
+				if (eInterp == ERemapInterpolation::Bilinear)
+				{
+					pdWeight[0] = 1.0 - dT;
+					pdWeight[1] = dT;
+				}
+				else
+				{
+					pdWeight[0] = ((-0.5 * dT + 1.0) * dT - 0.5) * dT;
+					pdWeight[1] = (1.5 * dT - 2.5) * dT * dT + 1.0;
+					pdWeight[2] = ((-1.5 * dT + 2.0) * dT + 0.5) * dT;
+					pdWeight[3] = (0.5 * dT - 0.5) * dT * dT;
+				}
+			};
+
+			const int iTaps = eInterp == ERemapInterpolation::Bilinear ? 2 : 4;
+			const int iOffset = iTaps / 2 - 1;
+			double pdWeightX[4], pdWeightY[4];
+			Weights(iFracX / 32.0, pdWeightX);
+			Weights(iFracY / 32.0, pdWeightY);
+
+			double dSum = 0.0;
+			for (int iJ = 0; iJ < iTaps; ++iJ)
+			{
+				for (int iI = 0; iI < iTaps; ++iI)
+				{
+					dSum += pdWeightY[iJ] * pdWeightX[iI] * S(xEntry.iX - iOffset + iI, xEntry.iY - iOffset + iJ);
+				}
+			}
+			return dSum;
+		}
+
+		template<typename TValue>
+		static void TestRemap(EDataType eDataType, double dMin, double dMax)
+		{
+			std::mt19937 xRandom(unsigned(eDataType) * 7 + 1);
+
+			for (EPixelType ePixelType : { EPixelType::Lum, EPixelType::LumA, EPixelType::RGB, EPixelType::RGBA })
+			{
+				const int iChannelCount = int(SImageType::DimOf(ePixelType));
+				for (int iSize : { 3, 17 })
+				{
+					const int iWidth = iSize + 5, iHeight = iSize;
+					CIImage imgSrc(SImageFormat(iWidth, iHeight, ePixelType, eDataType));
+					FillRandom<TValue>(imgSrc, xRandom, dMin, dMax);
+
+					// The identity is exact for all interpolations.
+					CRemapLut xIdentity;
+					xIdentity.Create(iWidth, iHeight, [](double& dX, double& dY, int iX, int iY) { dX = iX; dY = iY; return true; });
+					for (ERemapInterpolation eInterp : { ERemapInterpolation::Nearest, ERemapInterpolation::Bilinear, ERemapInterpolation::Bicubic })
+					{
+						CIImage imgTrg;
+						RemapImage(imgTrg, imgSrc, xIdentity, eInterp, EBorderMode::Mirror);
+						Assert::IsTrue(IsEqual<TValue>(imgTrg, imgSrc), L"Identity remap changed the image");
+					}
+
+					// A map with positions outside of the image and invalid entries, whose target widths
+					// run the SIMD bodies and the scalar tails.
+					for (int iTrgWidth : { 17, 33 })
+					{
+						CRemapLut xLut;
+						xLut.Create(iTrgWidth, 9, [&](double& dX, double& dY, int iX, int iY)
+						{
+							const unsigned uHash = unsigned(iX * 7919 + iY * 104729) * 2654435761u;
+							dX = (iX * 1.37 + iY * 0.21) * iWidth / 30.0 - 3.3 + (uHash % 1000) / 1000.0;
+							dY = (iY * 1.91 - iX * 0.13) * iHeight / 12.0 - 2.1 + (uHash % 777) / 777.0;
+							return uHash % 53 != 0;
+						});
+
+						for (ERemapInterpolation eInterp : { ERemapInterpolation::Nearest, ERemapInterpolation::Bilinear, ERemapInterpolation::Bicubic })
+						{
+							for (EBorderMode eBorder : { EBorderMode::Constant, EBorderMode::Replicate, EBorderMode::Reflect, EBorderMode::Mirror, EBorderMode::Wrap })
+							{
+								const double dBorderValue = std::is_signed<TValue>::value ? -3.0 : 7.0;
+								CIImage imgTrg;
+								RemapImage(imgTrg, imgSrc, xLut, eInterp, eBorder, dBorderValue);
+
+								for (int iY = 0; iY < 9; ++iY)
+								{
+									for (int iX = 0; iX < iTrgWidth; ++iX)
+									{
+										for (int iC = 0; iC < iChannelCount; ++iC)
+										{
+											const double dRef = RemapValue<TValue>(imgSrc, xLut.Row(iY)[iX], iC, eInterp, eBorder, dBorderValue);
+											const double dValue = double(Pixel<TValue>(imgTrg, iX, iY)[iC]);
+											const bool bNear = std::is_integral<TValue>::value ? IsNear<TValue>(dValue, dRef)
+												: fabs(dValue - dRef) <= std::max(fabs(dMin), fabs(dMax)) * (sizeof(TValue) == 4 ? 1e-5 : 1e-12);
+											Assert::IsTrue(bNear, L"Remap differs from the scalar reference");
+										}
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(RemapMatchesScalarReference)
+		{
+			try
+			{
+				TestRemap<uint8_t>(EDataType::UInt8, 0.0, 256.0);
+				TestRemap<int8_t>(EDataType::Int8, -128.0, 128.0);
+				TestRemap<uint16_t>(EDataType::UInt16, 0.0, 65536.0);
+				TestRemap<int16_t>(EDataType::Int16, -32768.0, 32768.0);
+				TestRemap<int32_t>(EDataType::Int32, -2e9, 2e9);
+				TestRemap<float>(EDataType::Single, -1000.0, 1000.0);
+				TestRemap<double>(EDataType::Double, -1e6, 1e6);
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(RemapLutRoundtrip)
+		{
+			try
+			{
+				const std::string sFilename = "CluTec.ImgProc.Test.lut";
+
+				CRemapLut xLut;
+				xLut.Create(33, 21, [](double& dX, double& dY, int iX, int iY) { dX = iX * 0.77 - 1.0; dY = iY * 1.3 + 0.01; return iX != 3; });
+				xLut.Save(sFilename);
+
+				CRemapLut xLoaded;
+				xLoaded.Load(sFilename);
+				remove(sFilename.c_str());
+
+				Assert::IsTrue(xLoaded.Width() == 33 && xLoaded.Height() == 21, L"Loaded LUT has the wrong size");
+				for (int iY = 0; iY < 21; ++iY)
+				{
+					for (int iX = 0; iX < 33; ++iX)
+					{
+						const CRemapLut::SEntry& xA = xLut.Row(iY)[iX];
+						const CRemapLut::SEntry& xB = xLoaded.Row(iY)[iX];
+						Assert::IsTrue(xA.iX == xB.iX && xA.iY == xB.iY && xA.uFraction == xB.uFraction, L"Loaded LUT differs from the saved LUT");
+					}
+				}
+
+				Assert::IsTrue(xLut.Row(0)[3].uFraction == CRemapLut::InvalidFraction, L"Invalid position is not marked");
+
+				// A translation is exact for the linear and the cubic interpolation of a linear image.
+				CIImage imgSrc(SImageFormat(40, 30, EPixelType::Lum, EDataType::Single));
+				for (int iY = 0; iY < 30; ++iY)
+				{
+					for (int iX = 0; iX < 40; ++iX)
+					{
+						Pixel<float>(imgSrc, iX, iY)[0] = float(3 * iX + 5 * iY);
+					}
+				}
+
+				const double pdH[9] = { 1, 0, 2.5, 0, 1, 1.25, 0, 0, 1 };
+				CRemapLut xHomography;
+				xHomography.CreateHomography(30, 20, pdH);
+
+				for (ERemapInterpolation eInterp : { ERemapInterpolation::Bilinear, ERemapInterpolation::Bicubic })
+				{
+					CIImage imgTrg;
+					RemapImage(imgTrg, imgSrc, xHomography, eInterp);
+					for (int iY = 0; iY < 20; ++iY)
+					{
+						for (int iX = 0; iX < 30; ++iX)
+						{
+							Assert::IsTrue(fabs(Pixel<float>(imgTrg, iX, iY)[0] - (3.0 * (iX + 2.5) + 5.0 * (iY + 1.25))) <= 1e-3, L"Translation remap differs from the linear image");
+						}
+					}
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(RemapKeepsSourceShared)
+		{
+			try
+			{
+				std::mt19937 xRandom(1);
+				CIImage imgA(SImageFormat(37, 23, EPixelType::RGB, EDataType::UInt8));
+				FillRandom<uint8_t>(imgA, xRandom, 0.0, 256.0);
+
+				CRemapLut xLut;
+				xLut.Create(30, 20, [](double& dX, double& dY, int iX, int iY) { dX = iX * 0.9 + 0.3; dY = iY * 1.1; return true; });
+
+				// Remapping a copy only reads the memory it shares with the original.
+				const CIImage imgB = imgA.Copy();
+				CIImage imgTrg;
+				RemapImage(imgTrg, imgB, xLut, ERemapInterpolation::Bilinear);
+				Assert::IsTrue(!imgA.IsUnique() && ((const CIImage&)imgA).DataPointer() == imgB.DataPointer(), L"Remapping detached the shared source");
+
+				CILayerImage imgLayerA(SImageFormat(37, 23, EPixelType::RGB, EDataType::UInt8));
+				for (size_t nLayer = 0; nLayer < imgLayerA.LayerCount(); ++nLayer)
+				{
+					memset(imgLayerA.DataPointer(nLayer), int(nLayer), imgLayerA.LayerRowPitch() * 23);
+				}
+
+				const CILayerImage imgLayerB = imgLayerA.Copy();
+				CILayerImage imgLayerTrg;
+				RemapImage(imgLayerTrg, imgLayerB, xLut, ERemapInterpolation::Bilinear);
+				Assert::IsTrue(!imgLayerA.IsUnique() && ((const CILayerImage&)imgLayerA).DataPointer(0) == imgLayerB.DataPointer(0), L"Remapping detached the shared layer source");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		using TPinhole = Clu::Camera::_CPinhole<double>;
+
+		// A camera with a sensor of 320 x 240 pixels, whose corners lie at a normalized radius of about 0.5.
+		static void CreateCamera(TPinhole& camPinhole, const TPinhole::TDistort& xDistort)
+		{
+			TPinhole::TVec3 vT, vPinholeM_s;
+			vT.SetElements(0.01, 0.02, 0.0);
+			vPinholeM_s.SetElements(1e-5, -2e-5, -0.002);
+
+			TPinhole::TFrame3D xFrame;
+			xFrame.Create(vT);
+
+			TPinhole::TUVec2 vResolutionPX;
+			vResolutionPX.SetElements(320u, 240u);
+
+			TPinhole::TVec2 vPixelSizeM;
+			vPixelSizeM.SetElements(5e-6, 5e-6);
+
+			TPinhole::TSensor xSensor;
+			xSensor.Create(xFrame, vResolutionPX, vPixelSizeM);
+
+			camPinhole.Create(xSensor, vPinholeM_s, xDistort);
+		}
+
+		// The source position of a LUT entry.
+		static void LutPosition(double& dX, double& dY, const CRemapLut::SEntry& xEntry)
+		{
+			const int iMask = CRemapLut::FractionCount - 1;
+			dX = double(xEntry.iX) + double(xEntry.uFraction & iMask) / CRemapLut::FractionCount;
+			dY = double(xEntry.iY) + double((xEntry.uFraction >> CRemapLut::FractionBits) & iMask) / CRemapLut::FractionCount;
+		}
+
+		// The distorted pixel of camOrig, onto which camera camView projects the world point seen at its pixel (iX, iY).
+		static void ProjectUnproject(double& dX, double& dY, const TPinhole& camView, const TPinhole& camOrig, int iX, int iY)
+		{
+			TPinhole::TVec3 vPos_w;
+			camView.Project_PixelIX_to_WorldM(vPos_w, double(iX), double(iY), -1.0);
+
+			double dPixX, dPixY, dDepth_s;
+			camOrig.Project_WorldM_to_PixelF(dPixX, dPixY, dDepth_s, vPos_w);
+
+			TPinhole::TVec2 vPos, vDist;
+			vPos.SetElements(dPixX, dPixY);
+			camOrig.Distortion().DistortPX(vDist, vPos, camOrig);
+
+			dX = vDist[0];
+			dY = vDist[1];
+		}
+
+		TEST_METHOD(CameraLutMatchesCameraModel)
+		{
+			try
+			{
+				// Without distortion, undistorting and rectifying to the same camera leave every pixel in place.
+				TPinhole::TDistort xNoDistort;
+				xNoDistort.Reset();
+
+				TPinhole camPinhole;
+				CreateCamera(camPinhole, xNoDistort);
+
+				CRemapLut xUndistortLut, xRectifyLut;
+				Clu::Camera::CreateUndistortLut(xUndistortLut, camPinhole);
+				Clu::Camera::CreateRectifyLut(xRectifyLut, camPinhole, camPinhole);
+				Assert::IsTrue(xUndistortLut.Width() == 320 && xUndistortLut.Height() == 240 && xRectifyLut.Width() == 320 && xRectifyLut.Height() == 240
+					, L"Camera LUT does not have the sensor resolution");
+
+				for (int iY = 0; iY < 240; ++iY)
+				{
+					for (int iX = 0; iX < 320; ++iX)
+					{
+						for (const CRemapLut* pLut : { &xUndistortLut, &xRectifyLut })
+						{
+							const CRemapLut::SEntry& xEntry = pLut->Row(iY)[iX];
+							Assert::IsTrue(xEntry.iX == iX && xEntry.iY == iY && xEntry.uFraction == 0, L"Camera LUT without distortion is not the identity");
+						}
+					}
+				}
+
+				// With distortion, each LUT entry is the distorted projection of the world point seen at its pixel.
+				TPinhole::TDistort xDistort;
+				xDistort.Create(1e-3, -5e-4, -0.1, 0.02, 0.0, 0.0, 0.0, 0.0);
+
+				TPinhole camOrig;
+				CreateCamera(camOrig, xDistort);
+				Clu::Camera::CreateUndistortLut(xUndistortLut, camOrig);
+
+				// The rectified camera looks in a direction rotated by 0.05 rad about the y-axis.
+				const double dAngle = 0.05;
+				TPinhole::TVec3 vDirX_w, vDirY_w, vDirZ_w;
+				vDirX_w.SetElements(cos(dAngle), 0.0, -sin(dAngle));
+				vDirY_w.SetElements(0.0, 1.0, 0.0);
+				vDirZ_w.SetElements(sin(dAngle), 0.0, cos(dAngle));
+
+				TPinhole camRect;
+				camOrig.GetRectified(camRect, vDirX_w, vDirY_w, vDirZ_w, camOrig.FocalLength(), Clu::Camera::ERectifyCropStyle::OuterRectangle);
+				Clu::Camera::CreateRectifyLut(xRectifyLut, camRect, camOrig);
+				Assert::IsTrue(xRectifyLut.Width() == int(camRect.Sensor().ResolutionPX()[0]) && xRectifyLut.Height() == int(camRect.Sensor().ResolutionPX()[1])
+					, L"Rectify LUT does not have the resolution of the rectified camera");
+
+				// The LUT rounds to the fixed point grid.
+				const double dMaxError = 0.5 / CRemapLut::FractionCount + 1e-6;
+				double dMaxShift = 0.0;
+
+				for (int iY = 0; iY < 240; iY += 7)
+				{
+					for (int iX = 0; iX < 320; iX += 13)
+					{
+						double dX, dY, dRefX, dRefY;
+						LutPosition(dX, dY, xUndistortLut.Row(iY)[iX]);
+						ProjectUnproject(dRefX, dRefY, camOrig, camOrig, iX, iY);
+						Assert::IsTrue(fabs(dX - dRefX) <= dMaxError && fabs(dY - dRefY) <= dMaxError, L"Undistort LUT differs from the camera model");
+
+						dMaxShift = std::max(dMaxShift, fabs(dX - iX) + fabs(dY - iY));
+					}
+				}
+
+				// The distortion moves the corners by several pixels, so the comparison is not trivially met.
+				Assert::IsTrue(dMaxShift > 2.0, L"Distortion of the test camera is too small");
+
+				for (int iY = 0; iY < xRectifyLut.Height(); iY += 7)
+				{
+					for (int iX = 0; iX < xRectifyLut.Width(); iX += 13)
+					{
+						const CRemapLut::SEntry& xEntry = xRectifyLut.Row(iY)[iX];
+						Assert::IsTrue(!(xEntry.uFraction & CRemapLut::InvalidFraction), L"Rectified pixel has no source position");
+
+						double dX, dY, dRefX, dRefY;
+						LutPosition(dX, dY, xEntry);
+						ProjectUnproject(dRefX, dRefY, camRect, camOrig, iX, iY);
+						Assert::IsTrue(fabs(dX - dRefX) <= dMaxError && fabs(dY - dRefY) <= dMaxError, L"Rectify LUT differs from the camera model");
+					}
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
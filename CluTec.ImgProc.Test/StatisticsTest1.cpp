@@ -0,0 +1,231 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      StatisticsTest1.cpp
+//
+// summary:   Implements the statistics test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Statistics.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(StatisticsTest1)
+	{
+	public:
+		// Computes the statistics of the masked pixels with a sorted list of the values. Images of at
+		// most 16 bit use the full value range of the data type for the histogram.
+		template<typename TValue>
+		static void StatisticsRef(std::vector<SChannelStatistics>& vecStats, const CIImage& imgSrc, const CIImage* pMask, const SStatisticsConfig& xConfig)
+		{
+			const SImageFormat& xFormat = imgSrc.Format();
+			const int iChannelCount = int(SImageType::DimOf(xFormat.ePixelType));
+			vecStats.assign(iChannelCount, SChannelStatistics());
+
+			for (int iC = 0; iC < iChannelCount; ++iC)
+			{
+				std::vector<double> vecValue;
+				for (int iY = 0; iY < xFormat.iHeight; ++iY)
+				{
+					for (int iX = 0; iX < xFormat.iWidth; ++iX)
+					{
+						const double dValue = double(Pixel<TValue>(imgSrc, iX, iY)[iC]);
+						if ((pMask == nullptr || Pixel<uint8_t>(*pMask, iX, iY)[0] != 0) && dValue == dValue)
+						{
+							vecValue.push_back(dValue);
+						}
+					}
+				}
+
+				SChannelStatistics& xStats = vecStats[iC];
+				xStats.uCount = vecValue.size();
+				if (!vecValue.empty())
+				{
+					long double dSum = 0.0;
+					xStats.dMin = *std::min_element(vecValue.begin(), vecValue.end());
+					xStats.dMax = *std::max_element(vecValue.begin(), vecValue.end());
+					for (double dValue : vecValue)
+					{
+						dSum += dValue;
+					}
+					xStats.dMean = double(dSum / vecValue.size());
+
+					long double dSqSum = 0.0;
+					for (double dValue : vecValue)
+					{
+						dSqSum += (dValue - xStats.dMean) * (dValue - xStats.dMean);
+					}
+					xStats.dVariance = double(dSqSum / vecValue.size());
+				}
+
+				if (xConfig.iBinCount > 0)
+				{
+					double dLow, dHigh;
+					if (xConfig.HasRange())
+					{
+						dLow = xConfig.dRangeMin;
+						dHigh = xConfig.dRangeMax;
+					}
+					else if (sizeof(TValue) <= 2 && std::is_integral<TValue>::value)
+					{
+						dLow = double(std::numeric_limits<TValue>::lowest());
+						dHigh = double(std::numeric_limits<TValue>::max());
+					}
+					else
+					{
+						dLow = vecValue.empty() ? 0.0 : xStats.dMin;
+						dHigh = vecValue.empty() ? 0.0 : xStats.dMax;
+					}
+
+					SHistogram& xHist = xStats.xHistogram;
+					xHist.dMin = dLow;
+					xHist.dMax = dHigh;
+					xHist.vecBin.assign(xConfig.iBinCount, 0);
+
+					const double dScale = dHigh > dLow ? xConfig.iBinCount / (dHigh - dLow) : 0.0;
+					for (double dValue : vecValue)
+					{
+						if (dValue < dLow)
+						{
+							++xHist.uBelowCount;
+						}
+						else if (dValue > dHigh)
+						{
+							++xHist.uAboveCount;
+						}
+						else
+						{
+							++xHist.vecBin[std::min(size_t((dValue - dLow) * dScale), size_t(xConfig.iBinCount - 1))];
+						}
+					}
+				}
+			}
+		}
+
+		static bool IsEqualStatistics(const std::vector<SChannelStatistics>& vecA, const std::vector<SChannelStatistics>& vecB, double dRelTol)
+		{
+			if (vecA.size() != vecB.size())
+			{
+				return false;
+			}
+
+			auto Near = [](double dA, double dB, double dTol) { return fabs(dA - dB) <= dTol * (1.0 + fabs(dA) + fabs(dB)); };
+
+			for (size_t nC = 0; nC < vecA.size(); ++nC)
+			{
+				const SChannelStatistics& xA = vecA[nC];
+				const SChannelStatistics& xB = vecB[nC];
+				if (xA.uCount != xB.uCount || xA.dMin != xB.dMin || xA.dMax != xB.dMax
+					|| !Near(xA.dMean, xB.dMean, dRelTol) || !Near(xA.dVariance, xB.dVariance, 100.0 * dRelTol)
+					|| xA.xHistogram.vecBin != xB.xHistogram.vecBin || xA.xHistogram.dMin != xB.xHistogram.dMin || xA.xHistogram.dMax != xB.xHistogram.dMax
+					|| xA.xHistogram.uBelowCount != xB.xHistogram.uBelowCount || xA.xHistogram.uAboveCount != xB.xHistogram.uAboveCount)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		template<typename TValue>
+		static void TestStatistics(EDataType eDataType, double dMin, double dMax, bool bNaN)
+		{
+			std::mt19937 xRandom(unsigned(eDataType) + 1);
+			const double dRelTol = sizeof(TValue) <= 2 && std::is_integral<TValue>::value ? 1e-12 : 1e-9;
+
+			for (EPixelType ePixelType : { EPixelType::Lum, EPixelType::LumA, EPixelType::RGB, EPixelType::RGBA })
+			{
+				for (int iWidth : c_piOddWidth)
+				{
+					// The view starts one pixel into the row, so that the SIMD loads are not aligned.
+					CIImage imgBig(SImageFormat(iWidth + 2, 6, ePixelType, eDataType));
+					FillRandom<TValue>(imgBig, xRandom, dMin, dMax);
+					if (bNaN)
+					{
+						Pixel<TValue>(imgBig, iWidth / 2, 2)[0] = TValue(NAN);
+					}
+
+					const CIImage imgView = imgBig.CropView(1, 1, iWidth, 5);
+
+					CIImage imgMask(SImageFormat(iWidth, 5, EPixelType::Lum, EDataType::UInt8));
+					for (int iY = 0; iY < 5; ++iY)
+					{
+						for (int iX = 0; iX < iWidth; ++iX)
+						{
+							Pixel<uint8_t>(imgMask, iX, iY)[0] = uint8_t(xRandom() % 3 == 0 ? 0 : 255);
+						}
+					}
+
+					for (const SStatisticsConfig& xConfig : { SStatisticsConfig(), SStatisticsConfig(0), SStatisticsConfig(10, dMin + (dMax - dMin) * 0.25, dMin + (dMax - dMin) * 0.7) })
+					{
+						std::vector<SChannelStatistics> vecStats, vecRef;
+
+						StatisticsRef<TValue>(vecRef, imgView, nullptr, xConfig);
+						ComputeStatistics(vecStats, imgView, xConfig);
+						Assert::IsTrue(IsEqualStatistics(vecStats, vecRef, dRelTol), L"Statistics of a view differ from the scalar reference");
+
+						ComputeStatistics(vecStats, imgBig, 1, 1, iWidth, 5, xConfig);
+						Assert::IsTrue(IsEqualStatistics(vecStats, vecRef, dRelTol), L"Statistics of a region differ from the scalar reference");
+
+						StatisticsRef<TValue>(vecRef, imgView, &imgMask, xConfig);
+						ComputeStatistics(vecStats, imgView, imgMask, xConfig);
+						Assert::IsTrue(IsEqualStatistics(vecStats, vecRef, dRelTol), L"Masked statistics differ from the scalar reference");
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(StatisticsMatchesScalarReference)
+		{
+			try
+			{
+				TestStatistics<uint8_t>(EDataType::UInt8, 0.0, 256.0, false);
+				TestStatistics<int8_t>(EDataType::Int8, -128.0, 128.0, false);
+				TestStatistics<uint16_t>(EDataType::UInt16, 0.0, 65536.0, false);
+				TestStatistics<int16_t>(EDataType::Int16, -32768.0, 32768.0, false);
+				TestStatistics<int32_t>(EDataType::Int32, -2e9, 2e9, false);
+				TestStatistics<uint32_t>(EDataType::UInt32, 0.0, 4e9, false);
+				TestStatistics<float>(EDataType::Single, 1000.0, 1001.0, true);
+				TestStatistics<double>(EDataType::Double, -1e6, 1e6, true);
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      TestImage.h
+//
+// summary:   Declares the pixel access and fill functions shared by the image processing tests
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <type_traits>
+
+#include "CluTec.Types1/IImage.h"
+
+namespace CluTecImgProcTest
+{
+	// Image widths just below, at and above multiples of the SIMD register widths. The SIMD kernels process
+	// whole registers and leave the rest of a row to the scalar code, so comparing these widths against a
+	// scalar reference checks that both paths give the same result.
+	static const int c_piOddWidth[] = { 1, 3, 7, 15, 16, 17, 31, 33, 64, 101 };
+
+	template<typename TValue>
+	TValue* Pixel(Clu::CIImage& imgImage, int iX, int iY)
+	{
+		const Clu::SImageFormat& xFormat = imgImage.Format();
+		unsigned char* pRow = (unsigned char*)imgImage.DataPointer() + size_t(iY) * xFormat.RowPitch();
+		return (TValue*)pRow + size_t(iX) * Clu::SImageType::DimOf(xFormat.ePixelType);
+	}
+
+	template<typename TValue>
+	const TValue* Pixel(const Clu::CIImage& imgImage, int iX, int iY)
+	{
+		const Clu::SImageFormat& xFormat = imgImage.Format();
+		const unsigned char* pRow = (const unsigned char*)imgImage.DataPointer() + size_t(iY) * xFormat.RowPitch();
+		return (const TValue*)pRow + size_t(iX) * Clu::SImageType::DimOf(xFormat.ePixelType);
+	}
+
+	/// <summary>	Fills all channels with uniformly distributed values in [dMin, dMax). </summary>
+	template<typename TValue>
+	void FillRandom(Clu::CIImage& imgImage, std::mt19937& xRandom, double dMin, double dMax)
+	{
+		const Clu::SImageFormat& xFormat = imgImage.Format();
+		const int iValueCount = xFormat.iWidth * int(Clu::SImageType::DimOf(xFormat.ePixelType));
+		std::uniform_real_distribution<double> xDist(dMin, dMax);
+
+		for (int iY = 0; iY < xFormat.iHeight; ++iY)
+		{
+			TValue* pRow = Pixel<TValue>(imgImage, 0, iY);
+			for (int iIdx = 0; iIdx < iValueCount; ++iIdx)
+			{
+				const double dValue = xDist(xRandom);
+				pRow[iIdx] = TValue(std::is_integral<TValue>::value ? floor(dValue) : dValue);
+			}
+		}
+	}
+
+	/// <summary>
+	/// 	Returns true if a result is near the reference value. An integer result has to be within one of the rounded and
+	/// 	clamped reference, a floating point result within a relative tolerance.
+	/// </summary>
+	template<typename TValue>
+	bool IsNear(double dValue, double dRef)
+	{
+		if (std::is_integral<TValue>::value)
+		{
+			dRef = std::min(std::max(floor(dRef + 0.5), double(std::numeric_limits<TValue>::lowest())), double(std::numeric_limits<TValue>::max()));
+			return fabs(dValue - dRef) <= 1.0;
+		}
+
+		return fabs(dValue - dRef) <= 1e-4 * std::max(1.0, fabs(dRef));
+	}
+
+	/// <summary>	Returns true if both images have the same size and the same pixel bytes. </summary>
+	template<typename TValue>
+	bool IsEqual(const Clu::CIImage& imgA, const Clu::CIImage& imgB)
+	{
+		const Clu::SImageFormat& xA = imgA.Format();
+		const Clu::SImageFormat& xB = imgB.Format();
+		if (xA.iWidth != xB.iWidth || xA.iHeight != xB.iHeight || xA.ePixelType != xB.ePixelType)
+		{
+			return false;
+		}
+
+		const size_t nRowBytes = size_t(xA.iWidth) * Clu::SImageType::DimOf(xA.ePixelType) * sizeof(TValue);
+		for (int iY = 0; iY < xA.iHeight; ++iY)
+		{
+			if (memcmp(Pixel<TValue>(imgA, 0, iY), Pixel<TValue>(imgB, 0, iY), nRowBytes) != 0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      TiledImageTest1.cpp
+//
+// summary:   Implements the tiled image test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <stdio.h>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.ImgProc/Image.Tiled.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(TiledImageTest1)
+	{
+	public:
+		TEST_METHOD(TiledImageRoundtrip)
+		{
+			const char* pcFilename = "CluTec.ImgProc.Test.til";
+
+			try
+			{
+				// The cache holds fewer tiles than the image has, so that tiles are written back and read again.
+				const SImageFormat xFormat(300, 217, EPixelType::RGB, EDataType::UInt16);
+				const size_t nTileBytes = 64 * 64 * 6;
+				std::mt19937 xRandom(1);
+
+				CIImage imgSrc(xFormat);
+				FillRandom<uint16_t>(imgSrc, xRandom, 0.0, 65536.0);
+
+				{
+					CTiledImage xTiled;
+					xTiled.Create(pcFilename, xFormat, 64, 5 * nTileBytes);
+					Assert::IsTrue(xTiled.TileCountX() == 5 && xTiled.TileCountY() == 4, L"Wrong tile count");
+
+					xTiled.ForEachTile(true, [&](CIImage& imgTile, int iX, int iY)
+					{
+						for (int iRow = 0; iRow < imgTile.Format().iHeight; ++iRow)
+						{
+							memcpy(Pixel<uint16_t>(imgTile, 0, iRow), Pixel<uint16_t>(imgSrc, iX, iY + iRow), imgTile.Format().RowByteCount());
+						}
+					});
+					xTiled.Close();
+				}
+
+				CTiledImage xTiled;
+				xTiled.Open(pcFilename, 3 * nTileBytes);
+
+				CIImage imgTrg(xFormat);
+				xTiled.ReadRegion(imgTrg, 0, 0);
+				Assert::IsTrue(IsEqual<uint16_t>(imgTrg, imgSrc), L"Tiled image differs from the written tiles");
+
+				for (int iRegion = 0; iRegion < 20; ++iRegion)
+				{
+					const int iX = (iRegion * 37) % 250, iY = (iRegion * 53) % 157;
+					CIImage imgRegion(SImageFormat(50, 60, EPixelType::RGB, EDataType::UInt16));
+					xTiled.ReadRegion(imgRegion, iX, iY);
+					Assert::IsTrue(IsEqual<uint16_t>(imgRegion, imgSrc.CropView(iX, iY, 50, 60)), L"Region differs from the source");
+				}
+
+				CIImage imgPatch(SImageFormat(100, 70, EPixelType::RGB, EDataType::UInt16));
+				FillRandom<uint16_t>(imgPatch, xRandom, 0.0, 65536.0);
+				xTiled.WriteRegion(imgPatch, 150, 120);
+				xTiled.Close();
+
+				xTiled.Open(pcFilename);
+				CIImage imgRegion(imgPatch.Format());
+				xTiled.ReadRegion(imgRegion, 150, 120);
+				Assert::IsTrue(IsEqual<uint16_t>(imgRegion, imgPatch), L"Written region differs from the patch");
+
+				bool bThrown = false;
+				try
+				{
+					xTiled.ReadRegion(imgRegion, 250, 0);
+				}
+				catch (Clu::CIException&)
+				{
+					bThrown = true;
+				}
+				Assert::IsTrue(bThrown, L"Reading a region outside of the tiled image did not throw");
+				xTiled.Close();
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				remove(pcFilename);
+				Assert::Fail(L"Exception thrown");
+			}
+
+			remove(pcFilename);
+		}
+	};
+}
@@ -0,0 +1,372 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc.Test
+// file:      ViewTest1.cpp
+//
+// summary:   Implements the typed image view test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/Pixel.h"
+#include "CluTec.ImgProc/Image.View.h"
+
+#include "TestImage.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Clu;
+using namespace Clu::ImgProc;
+
+namespace CluTecImgProcTest
+{
+	TEST_CLASS(ViewTest1)
+	{
+	public:
+		TEST_METHOD(RowsFollowRowPitch)
+		{
+			try
+			{
+				// The image is large enough for ForEachRow to split it into several blocks.
+				const int iWidth = 203, iHeight = 171;
+				const int iRowPitch = (iWidth + 5) * 3;
+				CIImage imgImage(SImageFormat(iWidth, iHeight, EPixelType::RGB, EDataType::UInt8, iRowPitch));
+				memset(imgImage.DataPointer(), 0xCD, imgImage.Format().ByteCount());
+
+				const CImageView<TPixel_RGB_UInt8> xView(imgImage);
+				Assert::IsTrue(xView.Width() == iWidth && xView.Height() == iHeight && xView.RowPitch() == size_t(iRowPitch), L"View has the wrong layout");
+
+				ForEachRow(xView, [](TPixel_RGB_UInt8* pRow, int iRowWidth, int iY)
+				{
+					for (int iX = 0; iX < iRowWidth; ++iX)
+					{
+						pRow[iX][0] = uint8_t(iX);
+						pRow[iX][1] = uint8_t(iY);
+						pRow[iX][2] = uint8_t(iX + iY);
+					}
+				});
+
+				for (int iY = 0; iY < iHeight; ++iY)
+				{
+					const uint8_t* pRow = Pixel<uint8_t>(imgImage, 0, iY);
+					for (int iX = 0; iX < iWidth; ++iX)
+					{
+						Assert::IsTrue(pRow[3 * iX] == uint8_t(iX) && pRow[3 * iX + 1] == uint8_t(iY) && pRow[3 * iX + 2] == uint8_t(iX + iY), L"ForEachRow wrote the wrong pixel");
+					}
+
+					for (int iIdx = 3 * iWidth; iIdx < iRowPitch; ++iIdx)
+					{
+						Assert::IsTrue(pRow[iIdx] == 0xCD, L"ForEachRow wrote to the row padding");
+					}
+				}
+
+				// The row range steps by the row pitch.
+				int iY = 0;
+				for (const auto& xRow : xView.Rows())
+				{
+					Assert::IsTrue(xRow.Size() == iWidth && xRow.begin() == xView.Row(iY) && xRow[7][1] == uint8_t(iY), L"Row range differs from the rows of the view");
+					++iY;
+				}
+				Assert::IsTrue(iY == iHeight, L"Row range has the wrong number of rows");
+
+				const auto xRows = xView.Rows();
+				Assert::IsTrue(xRows.end() - xRows.begin() == iHeight && xRows.begin()[5].begin() == xView.Row(5)
+					&& (xRows.begin() + 9) - 4 == xRows.begin() + 5, L"Row iterator arithmetic is wrong");
+
+				// A view of a view and a view of an image view have the padding of the parent.
+				const CImageView<TPixel_RGB_UInt8> xCrop = xView.Crop(3, 2, 100, 50);
+				CIImage imgCrop = imgImage.CropView(3, 2, 100, 50);
+				const CImageView<TPixel_RGB_UInt8> xCropView(imgCrop);
+				Assert::IsTrue(xCrop.RowPitch() == size_t(iRowPitch) && xCropView.RowPitch() == size_t(iRowPitch), L"Crop changed the row pitch");
+
+				ForEachPixelPair(xCrop, xCropView, [](TPixel_RGB_UInt8& xA, TPixel_RGB_UInt8& xB)
+				{
+					Assert::IsTrue(&xA == &xB, L"Cropped views refer to different pixels");
+				});
+				Assert::IsTrue(xCrop(0, 0)[0] == 3 && xCrop(0, 0)[1] == 2 && xCrop.At(99, 49)[0] == 102, L"Cropped view has the wrong pixels");
+
+				ForEachPixel(xCrop, [](TPixel_RGB_UInt8& xPixel)
+				{
+					xPixel[2] = 0;
+				});
+
+				for (int iRow = 0; iRow < iHeight; ++iRow)
+				{
+					for (int iX = 0; iX < iWidth; ++iX)
+					{
+						const bool bInside = iX >= 3 && iX < 103 && iRow >= 2 && iRow < 52;
+						Assert::IsTrue(xView(iX, iRow)[2] == (bInside ? 0 : uint8_t(iX + iRow)), L"ForEachPixel changed pixels outside of the cropped view");
+					}
+				}
+
+				bool bThrown = false;
+				try
+				{
+					xView.At(iWidth, 0);
+				}
+				catch (Clu::CIException&)
+				{
+					bThrown = true;
+				}
+				Assert::IsTrue(bThrown, L"Access outside of the view did not throw");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(ConstViewKeepsSourceShared)
+		{
+			try
+			{
+				std::mt19937 xRandom(1);
+				CIImage imgA(SImageFormat(61, 37, EPixelType::Lum, EDataType::UInt16));
+				FillRandom<uint16_t>(imgA, xRandom, 0.0, 65536.0);
+				const void* pData = ((const CIImage&)imgA).DataPointer();
+
+				uint64_t uSum = 0;
+				for (int iY = 0; iY < 37; ++iY)
+				{
+					for (int iX = 0; iX < 61; ++iX)
+					{
+						uSum += Pixel<uint16_t>((const CIImage&)imgA, iX, iY)[0];
+					}
+				}
+
+				// Const views of a mutable and of a const copy only read the shared memory.
+				CIImage imgB = imgA.Copy();
+				const CIImage imgC = imgA.Copy();
+				const CImageView<const TPixel_Lum_UInt16> xViewB(imgB);
+				const CImageView<const TPixel_Lum_UInt16> xViewC(imgC);
+				Assert::IsTrue(!imgA.IsUnique() && ((const CIImage&)imgB).DataPointer() == pData && imgC.DataPointer() == pData
+					&& (const void*)xViewB.Row(0) == pData && (const void*)xViewC.Row(0) == pData, L"Const view detached the shared source");
+
+				uint64_t uViewSum = 0;
+				ForEachRow(xViewB, [&](const TPixel_Lum_UInt16* pRow, int iWidth, int)
+				{
+					uint64_t uRowSum = 0;
+					for (int iX = 0; iX < iWidth; ++iX)
+					{
+						uRowSum += pRow[iX][0];
+					}
+
+					// The image is small enough to be processed in a single block.
+					uViewSum += uRowSum;
+				});
+				Assert::IsTrue(uViewSum == uSum && ((const CIImage&)imgB).DataPointer() == pData, L"Reading a const view changed the source");
+
+				// A view with mutable pixels detaches the shared memory, and a const view of it refers to the new memory.
+				const CImageView<TPixel_Lum_UInt16> xMutable(imgB);
+				const CImageView<const TPixel_Lum_UInt16> xConst(xMutable);
+				Assert::IsTrue(imgB.IsUnique() && (const void*)xMutable.Row(0) != pData && xConst.Row(0) == xMutable.Row(0), L"Mutable view did not detach the shared source");
+
+				xMutable(0, 0)[0] ^= 0xFFFF;
+				Assert::IsTrue(Pixel<uint16_t>(imgC, 0, 0)[0] == Pixel<uint16_t>((const CIImage&)imgA, 0, 0)[0]
+					&& xViewC(0, 0)[0] != xConst(0, 0)[0], L"Writing to the mutable view changed the shared memory");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(TransformBetweenDataTypes)
+		{
+			try
+			{
+				std::mt19937 xRandom(2);
+				for (int iWidth : c_piOddWidth)
+				{
+					// The source is a view one pixel into the row, the target has its default row padding.
+					CIImage imgBig(SImageFormat(iWidth + 1, 24, EPixelType::RGBA, EDataType::UInt8));
+					FillRandom<uint8_t>(imgBig, xRandom, 0.0, 256.0);
+					const CIImage imgSrc = imgBig.CropView(1, 1, iWidth, 23);
+					CIImage imgLum(SImageFormat(iWidth, 23, EPixelType::Lum, EDataType::Single));
+
+					Transform(CImageView<TPixel_Lum_Single>(imgLum), CImageView<const TPixel_RGBA_UInt8>(imgSrc), [](const TPixel_RGBA_UInt8& xPixel)
+					{
+						TPixel_Lum_Single xLum;
+						xLum[0] = 0.25f * float(xPixel[0]) + 0.5f * float(xPixel[1]) + 0.25f * float(xPixel[2]);
+						return xLum;
+					});
+
+					for (int iY = 0; iY < 23; ++iY)
+					{
+						for (int iX = 0; iX < iWidth; ++iX)
+						{
+							const uint8_t* pSrc = Pixel<uint8_t>(imgSrc, iX, iY);
+							const float fRef = 0.25f * float(pSrc[0]) + 0.5f * float(pSrc[1]) + 0.25f * float(pSrc[2]);
+							Assert::IsTrue(Pixel<float>((const CIImage&)imgLum, iX, iY)[0] == fRef, L"Transform to Lum Single differs from the scalar reference");
+						}
+					}
+
+					// UInt16 RGB to Double BGR swaps the color order and scales the values.
+					CIImage imgRGB(SImageFormat(iWidth, 5, EPixelType::RGB, EDataType::UInt16));
+					FillRandom<uint16_t>(imgRGB, xRandom, 0.0, 65536.0);
+					CIImage imgBGR(SImageFormat(iWidth, 5, EPixelType::BGR, EDataType::Double));
+
+					Transform(CImageView<TPixel_BGR_Double>(imgBGR), CImageView<const TPixel_RGB_UInt16>((const CIImage&)imgRGB), [](const TPixel_RGB_UInt16& xPixel)
+					{
+						TPixel_BGR_Double xBGR;
+						xBGR[0] = double(xPixel[2]) / 65535.0;
+						xBGR[1] = double(xPixel[1]) / 65535.0;
+						xBGR[2] = double(xPixel[0]) / 65535.0;
+						return xBGR;
+					});
+
+					for (int iY = 0; iY < 5; ++iY)
+					{
+						for (int iX = 0; iX < iWidth; ++iX)
+						{
+							const uint16_t* pSrc = Pixel<uint16_t>((const CIImage&)imgRGB, iX, iY);
+							const double* pTrg = Pixel<double>((const CIImage&)imgBGR, iX, iY);
+							Assert::IsTrue(pTrg[0] == double(pSrc[2]) / 65535.0 && pTrg[1] == double(pSrc[1]) / 65535.0 && pTrg[2] == double(pSrc[0]) / 65535.0
+								, L"Transform to BGR Double differs from the scalar reference");
+						}
+					}
+
+					// Target and source may be the same view.
+					const CImageView<TPixel_Lum_Single> xLumView(imgLum);
+					Transform(xLumView, xLumView, [](const TPixel_Lum_Single& xPixel)
+					{
+						TPixel_Lum_Single xResult;
+						xResult[0] = 2.0f * xPixel[0] + 1.0f;
+						return xResult;
+					});
+
+					for (int iY = 0; iY < 23; ++iY)
+					{
+						for (int iX = 0; iX < iWidth; ++iX)
+						{
+							const uint8_t* pSrc = Pixel<uint8_t>(imgSrc, iX, iY);
+							const float fRef = 2.0f * (0.25f * float(pSrc[0]) + 0.5f * float(pSrc[1]) + 0.25f * float(pSrc[2])) + 1.0f;
+							Assert::IsTrue(xLumView(iX, iY)[0] == fRef, L"In place transform differs from the scalar reference");
+						}
+					}
+				}
+
+				bool bThrown = false;
+				try
+				{
+					CIImage imgA(SImageFormat(8, 8, EPixelType::Lum, EDataType::UInt8));
+					CIImage imgB(SImageFormat(8, 7, EPixelType::Lum, EDataType::UInt8));
+					ForEachPixelPair(CImageView<TPixel_Lum_UInt8>(imgA), CImageView<TPixel_Lum_UInt8>(imgB), [](TPixel_Lum_UInt8&, TPixel_Lum_UInt8&) {});
+				}
+				catch (Clu::CIException&)
+				{
+					bThrown = true;
+				}
+				Assert::IsTrue(bThrown, L"Views of different size did not throw");
+
+				bThrown = false;
+				try
+				{
+					CIImage imgA(SImageFormat(8, 8, EPixelType::Lum, EDataType::UInt8));
+					CImageView<TPixel_Lum_UInt16> xView(imgA);
+				}
+				catch (Clu::CIException&)
+				{
+					bThrown = true;
+				}
+				Assert::IsTrue(bThrown, L"View of the wrong data type did not throw");
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+
+		TEST_METHOD(DispatchAllPixelTypes)
+		{
+			try
+			{
+				const EPixelType peType[] = { EPixelType::Lum, EPixelType::LumA, EPixelType::RGB, EPixelType::RGBA, EPixelType::BGR, EPixelType::BGRA };
+				const EDataType peData[] = { EDataType::Int8, EDataType::UInt8, EDataType::Int16, EDataType::UInt16
+					, EDataType::Int32, EDataType::UInt32, EDataType::Single, EDataType::Double };
+
+				for (EPixelType ePixelType : peType)
+				{
+					for (EDataType eDataType : peData)
+					{
+						CIImage imgImage(SImageFormat(19, 7, ePixelType, eDataType));
+						int iCallCount = 0;
+
+						DispatchPixelType(ePixelType, eDataType, [&](auto xPixel)
+						{
+							using TPixel = decltype(xPixel);
+							using TData = typename TPixel::TData;
+							++iCallCount;
+
+							Assert::IsTrue(TPixel::PixelTypeId == ePixelType && TPixel::DataTypeId == eDataType, L"Dispatch selected the wrong pixel type");
+
+							const CImageView<TPixel> xView(imgImage);
+							ForEachPixel(xView, [](TPixel& xValue)
+							{
+								for (int iC = 0; iC < int(TPixel::ChannelCount); ++iC)
+								{
+									xValue[iC] = TData(iC + 1);
+								}
+							});
+
+							for (int iY = 0; iY < 7; ++iY)
+							{
+								const TData* pRow = Pixel<TData>((const CIImage&)imgImage, 0, iY);
+								for (int iIdx = 0; iIdx < 19 * int(TPixel::ChannelCount); ++iIdx)
+								{
+									Assert::IsTrue(pRow[iIdx] == TData(iIdx % int(TPixel::ChannelCount) + 1), L"Dispatched view wrote the wrong value");
+								}
+							}
+						});
+
+						Assert::IsTrue(iCallCount == 1, L"Dispatch did not call the operator once");
+					}
+				}
+
+				for (auto xType : { std::make_pair(EPixelType::BayerRG, EDataType::UInt8), std::make_pair(EPixelType::Lum, EDataType::Unknown) })
+				{
+					bool bThrown = false;
+					try
+					{
+						DispatchPixelType(xType.first, xType.second, [](auto) {});
+					}
+					catch (Clu::CIException&)
+					{
+						bThrown = true;
+					}
+					Assert::IsTrue(bThrown, L"Dispatch of an unsupported type did not throw");
+				}
+			}
+			catch (Clu::CIException& xEx)
+			{
+				Logger::WriteMessage(xEx.ToStringComplete().ToCString());
+				Assert::Fail(L"Exception thrown");
+			}
+		}
+	};
+}
@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Camera.Remap.h
+//
+// summary:   Declares the creation of remap LUTs from pinhole cameras
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Camera.Pinhole.h"
+#include "Image.Remap.h"
+
+namespace Clu
+{
+	namespace Camera
+	{
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Creates the LUT that removes the lens distortion of a camera. The target image has the sensor
+		/// 	resolution, and each of its pixels samples the distorted source image at the position
+		/// 	_CDistortion::DistortPX() returns for it.
+		/// </summary>
+		///
+		/// <param name="xLut">		 	[out] The LUT. </param>
+		/// <param name="camPinhole">	The camera with the distortion of the source images. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TValue>
+		void CreateUndistortLut(ImgProc::CRemapLut& xLut, const _CPinhole<TValue>& camPinhole)
+		{
+			using TVec2 = typename _CPinhole<TValue>::TVec2;
+
+			const TVec2& vRes = camPinhole.Sensor().ResolutionPX();
+
+			xLut.Create(int(vRes[0]), int(vRes[1]), [&camPinhole](double& dX, double& dY, int iX, int iY)
+			{
+				TVec2 vPos, vDist;
+				vPos.SetElements(TValue(iX), TValue(iY));
+				camPinhole.Distortion().DistortPX(vDist, vPos, camPinhole);
+
+				dX = double(vDist[0]);
+				dY = double(vDist[1]);
+				return true;
+			});
+		}
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Creates the LUT that rectifies the images of a camera. Each pixel of the rectified camera is projected
+		/// 	through the common optical center onto the sensor of the original camera, whose distortion is then
+		/// 	applied. Pixels that do not project onto the original sensor plane have no source position.
+		/// </summary>
+		///
+		/// <param name="xLut">	  	[out] The LUT. </param>
+		/// <param name="camRect">	The rectified camera, as returned by _CPinhole::GetRectified(). </param>
+		/// <param name="camOrig">	The original camera of the source images. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TValue>
+		void CreateRectifyLut(ImgProc::CRemapLut& xLut, const _CPinhole<TValue>& camRect, const _CPinhole<TValue>& camOrig)
+		{
+			using TVec2 = typename _CPinhole<TValue>::TVec2;
+			using TVec3 = typename _CPinhole<TValue>::TVec3;
+
+			const TVec2& vRes = camRect.Sensor().ResolutionPX();
+			const TValue dPinholeZ = camOrig.PinholeM_s()[2];
+
+			xLut.Create(int(vRes[0]), int(vRes[1]), [&camRect, &camOrig, dPinholeZ](double& dX, double& dY, int iX, int iY)
+			{
+				TVec3 vPos_w;
+				camRect.Map_PixelIX_to_WorldM(vPos_w, TValue(iX), TValue(iY));
+
+				TValue dPixX, dPixY, dDepth_s;
+				camOrig.Project_WorldM_to_PixelF(dPixX, dPixY, dDepth_s, vPos_w);
+
+				// Only points on the sensor side of the pinhole project onto the sensor without a point reflection.
+				if (!(dDepth_s > dPinholeZ))
+				{
+					return false;
+				}
+
+				TVec2 vPos, vDist;
+				vPos.SetElements(dPixX, dPixY);
+				camOrig.Distortion().DistortPX(vDist, vPos, camOrig);
+
+				dX = double(vDist[0]);
+				dY = double(vDist[1]);
+				return true;
+			});
+		}
+	}
+}
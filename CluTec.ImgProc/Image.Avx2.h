@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Avx2.h
+//
+// summary:   Declares the AVX2 kernels of the image functions
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The kernels are implemented in the Image.*.Avx2.cpp files, which the project compiles with /arch:AVX2. They may only
+// be called if Clu::Intrinsics::HasAvx2() returns true. The AVX2 files must not include headers with inline functions
+// or templates that other files use as well, like Image.Simd.h or the standard containers. The linker keeps a single
+// copy of such a function, which could be the AVX2 one. A shared template is fine if each file instantiates it with
+// its own types, like those of Image.Demosaic.Simd.h.
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Simd
+		{
+			struct SLaneMoments;
+		} // namespace Simd
+
+		namespace Avx2
+		{
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Image.Convert.Avx2.cpp. Row functions of nCount values or pixels, like the SSE2 kernels they replace.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			void ConvertUInt8ToSingle(void* pTrg, const void* pSrc, size_t nCount);
+			void ConvertUInt16ToSingle(void* pTrg, const void* pSrc, size_t nCount);
+			void SwapRedBlue4xUInt8(void* pTrg, const void* pSrc, size_t nCount);
+			void SwapRedBlue3xUInt8(void* pTrg, const void* pSrc, size_t nCount);
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Image.Demosaic.Avx2.cpp. Simd::InterpolateBayerRow() with 16 or 32 bit lanes. The planes and the rows
+			// are read and written in whole vectors of 32 bytes.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			void InterpolateBayerRow(int16_t* pRowColor, int16_t* pGreen, int16_t* pOtherColor, const int16_t* const* ppRow
+				, size_t nWidth, int iColorPhase, int iMaxValue, bool bEdgeAware);
+			void InterpolateBayerRow(int32_t* pRowColor, int32_t* pGreen, int32_t* pOtherColor, const int32_t* const* ppRow
+				, size_t nWidth, int iColorPhase, int iMaxValue, bool bEdgeAware);
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Image.Filter.Avx2.cpp. Simd::ConvolveRow() with 8 float lanes.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			size_t ConvolveRow(float* pOut, const float* const* ppRow, size_t nRows, const float* pWeight, size_t nTaps, size_t nStride, size_t nCount);
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Image.Pnm.Avx2.cpp. Swap the bytes of nCount 16 or 32 bit values. The target may be the source.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			void SwapBytes16(void* pTrg, const void* pSrc, size_t nCount);
+			void SwapBytes32(void* pTrg, const void* pSrc, size_t nCount);
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Image.Statistics.Avx2.cpp. Simd::AccumulateMoments() with 4 double lanes and a period of 1 to 3
+			// vectors.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			const size_t MomentLaneWidth = 4;
+
+			size_t AccumulateMoments(Simd::SLaneMoments& xLanes, const int32_t* pRow, size_t nCount, size_t nPeriod);
+			size_t AccumulateMoments(Simd::SLaneMoments& xLanes, const uint32_t* pRow, size_t nCount, size_t nPeriod);
+			size_t AccumulateMoments(Simd::SLaneMoments& xLanes, const float* pRow, size_t nCount, size_t nPeriod);
+			size_t AccumulateMoments(Simd::SLaneMoments& xLanes, const double* pRow, size_t nCount, size_t nPeriod);
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Image.Remap.Avx2.cpp. Simd::InterpolateTaps() with 8 float or 4 double lanes.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			size_t InterpolateTaps(float* pOut, const float* pTap, const float* pWeightX, const float* pWeightY, size_t nTaps, size_t nCount);
+			size_t InterpolateTaps(double* pOut, const double* pTap, const double* pWeightX, const double* pWeightY, size_t nTaps, size_t nCount);
+		} // namespace Avx2
+	} // namespace ImgProc
+} // namespace Clu
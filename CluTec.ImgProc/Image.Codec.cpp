@@ -0,0 +1,826 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Codec.cpp
+//
+// summary:   Implements the lossless in-memory compression of images
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "Image.Codec.h"
+
+#include "CluTec.Types1/ImageType.h"
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	The number of raw bytes of a band, if the band row count is not given. </summary>
+			const size_t DefaultBandByteCount = size_t(1) << 18;
+
+			const size_t BlockSampleCount = size_t(CCompressedImage::BlockSampleCount);
+
+			/// <summary>	The number of 8 x 16 bit vectors of a block. </summary>
+			const int BlockVectorCount = CCompressedImage::BlockSampleCount / 8;
+
+			/// <summary>	The first byte of a band. </summary>
+			const uint8_t BandStored = 0;
+			const uint8_t BandPacked = 1;
+
+			/// <summary>	The arrangement of the samples of a band. </summary>
+			struct SBandLayout
+			{
+				/// <summary>	The number of samples per row. </summary>
+				size_t nSampleCount;
+				size_t nRowPitch;
+
+				/// <summary>	The number of rows between a sample and its upper neighbor of the same color. </summary>
+				int iRowStep;
+
+				ECodecPredictor ePredictor;
+			};
+
+			/// <summary>	Scratch memory of a thread. </summary>
+			struct SScratch
+			{
+				std::vector<uint16_t> vecResidual;
+				std::vector<uint8_t> vecCode;
+			};
+
+			int _BitCount(unsigned uValue)
+			{
+				int iBitCount = 0;
+				if (uValue >= 0x100)
+				{
+					iBitCount += 8;
+					uValue >>= 8;
+				}
+
+				if (uValue >= 0x10)
+				{
+					iBitCount += 4;
+					uValue >>= 4;
+				}
+
+				if (uValue >= 0x4)
+				{
+					iBitCount += 2;
+					uValue >>= 2;
+				}
+
+				if (uValue >= 0x2)
+				{
+					iBitCount += 1;
+					uValue >>= 1;
+				}
+
+				return iBitCount + int(uValue);
+			}
+
+			/// <summary>	Returns the bit count of the largest value of a block. </summary>
+			int _BlockBitCount(const uint16_t* puValue)
+			{
+				__m128i mOr = _mm_setzero_si128();
+				for (int iVec = 0; iVec < BlockVectorCount; ++iVec)
+				{
+					mOr = _mm_or_si128(mOr, _mm_loadu_si128((const __m128i*)(puValue + 8 * iVec)));
+				}
+
+				mOr = _mm_or_si128(mOr, _mm_srli_si128(mOr, 8));
+				mOr = _mm_or_si128(mOr, _mm_srli_si128(mOr, 4));
+				mOr = _mm_or_si128(mOr, _mm_srli_si128(mOr, 2));
+
+				return _BitCount(unsigned(_mm_cvtsi128_si32(mOr)) & 0xFFFFu);
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Packs the values of a block with the given bit count into iBitCount vectors of 16 bytes. Lane j of
+			/// 	the vectors holds the values 8 * i + j one after the other, so that all lanes are shifted alike.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void _PackBlock(uint8_t* pucOut, const uint16_t* puValue, int iBitCount)
+			{
+				__m128i mWord = _mm_setzero_si128();
+				int iFill = 0;
+
+				for (int iVec = 0; iVec < BlockVectorCount; ++iVec)
+				{
+					const __m128i mValue = _mm_loadu_si128((const __m128i*)(puValue + 8 * iVec));
+					mWord = _mm_or_si128(mWord, _mm_sll_epi16(mValue, _mm_cvtsi32_si128(iFill)));
+
+					iFill += iBitCount;
+					if (iFill >= 16)
+					{
+						_mm_storeu_si128((__m128i*)pucOut, mWord);
+						pucOut += 16;
+
+						// The bits of the value that did not fit into the word. Shifts by 16 give zero.
+						iFill -= 16;
+						mWord = _mm_srl_epi16(mValue, _mm_cvtsi32_si128(iBitCount - iFill));
+					}
+				}
+			}
+
+			/// <summary>	Unpacks a block packed by _PackBlock(). </summary>
+			void _UnpackBlock(uint16_t* puValue, const uint8_t* pucIn, int iBitCount)
+			{
+				const __m128i mMask = _mm_set1_epi16(short((1 << iBitCount) - 1));
+
+				__m128i mWord = _mm_loadu_si128((const __m128i*)pucIn);
+				int iUsed = 0;
+
+				for (int iVec = 0; iVec < BlockVectorCount; ++iVec)
+				{
+					__m128i mValue = _mm_srl_epi16(mWord, _mm_cvtsi32_si128(iUsed));
+
+					iUsed += iBitCount;
+					if (iUsed >= 16 && iVec + 1 < BlockVectorCount)
+					{
+						pucIn += 16;
+						mWord = _mm_loadu_si128((const __m128i*)pucIn);
+
+						iUsed -= 16;
+						mValue = _mm_or_si128(mValue, _mm_sll_epi16(mWord, _mm_cvtsi32_si128(iBitCount - iUsed)));
+					}
+
+					_mm_storeu_si128((__m128i*)(puValue + 8 * iVec), _mm_and_si128(mValue, mMask));
+				}
+			}
+
+			/// <summary>	Maps a difference modulo the range of TValue to an unsigned value that is small for small differences. </summary>
+			template<typename TValue>
+			inline uint16_t _ZigZag(TValue uDiff)
+			{
+				using TSigned = typename std::make_signed<TValue>::type;
+
+				const int iDiff = int(TSigned(uDiff));
+				return uint16_t(TValue((unsigned(iDiff) << 1) ^ unsigned(iDiff >> 31)));
+			}
+
+			template<typename TValue>
+			inline TValue _UnZigZag(uint16_t uCode)
+			{
+				return TValue((unsigned(uCode) >> 1) ^ (0u - (unsigned(uCode) & 1u)));
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	The median edge detector of LOCO-I from the left, upper and upper left values. Written as selections
+			/// 	that compile to conditional moves, since branches on noisy image data are not predictable.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TValue>
+			inline TValue _Med(TValue uLeft, TValue uUp, TValue uUpLeft)
+			{
+				const int iLeft = int(uLeft);
+				const int iUp = int(uUp);
+				const int iMin = (iLeft < iUp ? iLeft : iUp);
+				const int iMax = (iLeft < iUp ? iUp : iLeft);
+
+				int iPred = iLeft + iUp - int(uUpLeft);
+				iPred = (iPred > iMax ? iMax : iPred);
+				iPred = (iPred < iMin ? iMin : iPred);
+				return TValue(iPred);
+			}
+
+			/// <summary>	SSE2 prediction residuals of 8 samples in 16 bit lanes. </summary>
+			template<typename TValue>
+			struct SLane;
+
+			template<>
+			struct SLane<uint8_t>
+			{
+				static __m128i Load(const uint8_t* pValue)
+				{
+					return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)pValue), _mm_setzero_si128());
+				}
+
+				static void Store(uint8_t* pValue, __m128i mValue)
+				{
+					_mm_storel_epi64((__m128i*)pValue, _mm_packus_epi16(_mm_and_si128(mValue, _mm_set1_epi16(0xFF)), _mm_setzero_si128()));
+				}
+
+				/// <summary>	Zigzag codes differences modulo 256. </summary>
+				static __m128i ZigZag(__m128i mDiff)
+				{
+					const __m128i mSigned = _mm_srai_epi16(_mm_slli_epi16(mDiff, 8), 8);
+					return _mm_and_si128(_mm_xor_si128(_mm_slli_epi16(mSigned, 1), _mm_srai_epi16(mSigned, 15)), _mm_set1_epi16(0xFF));
+				}
+
+				/// <summary>	The values are small enough for signed 16 bit arithmetic. </summary>
+				static __m128i Med(__m128i mLeft, __m128i mUp, __m128i mUpLeft)
+				{
+					const __m128i mMin = _mm_min_epi16(mLeft, mUp);
+					const __m128i mMax = _mm_max_epi16(mLeft, mUp);
+					return _mm_max_epi16(mMin, _mm_min_epi16(mMax, _mm_sub_epi16(_mm_add_epi16(mLeft, mUp), mUpLeft)));
+				}
+			};
+
+			template<>
+			struct SLane<uint16_t>
+			{
+				static __m128i Load(const uint16_t* pValue)
+				{
+					return _mm_loadu_si128((const __m128i*)pValue);
+				}
+
+				static void Store(uint16_t* pValue, __m128i mValue)
+				{
+					_mm_storeu_si128((__m128i*)pValue, mValue);
+				}
+
+				static __m128i ZigZag(__m128i mDiff)
+				{
+					return _mm_xor_si128(_mm_slli_epi16(mDiff, 1), _mm_srai_epi16(mDiff, 15));
+				}
+
+				////////////////////////////////////////////////////////////////////////////////////////////////////
+				/// <summary>
+				/// 	Unsigned comparisons are signed comparisons of the values with flipped sign bits. If the upper left
+				/// 	value lies between the others, left + up - upper left lies between them as well and is exact modulo
+				/// 	2^16.
+				/// </summary>
+				////////////////////////////////////////////////////////////////////////////////////////////////////
+				static __m128i Med(__m128i mLeft, __m128i mUp, __m128i mUpLeft)
+				{
+					const __m128i mSign = _mm_set1_epi16(short(0x8000));
+					const __m128i mLeftS = _mm_xor_si128(mLeft, mSign);
+					const __m128i mUpS = _mm_xor_si128(mUp, mSign);
+					const __m128i mUpLeftS = _mm_xor_si128(mUpLeft, mSign);
+
+					const __m128i mMinS = _mm_min_epi16(mLeftS, mUpS);
+					const __m128i mMaxS = _mm_max_epi16(mLeftS, mUpS);
+					const __m128i mAboveMax = _mm_cmpeq_epi16(_mm_max_epi16(mUpLeftS, mMaxS), mUpLeftS);
+					const __m128i mBelowMin = _mm_cmpeq_epi16(_mm_min_epi16(mUpLeftS, mMinS), mUpLeftS);
+
+					__m128i mPred = _mm_sub_epi16(_mm_add_epi16(mLeft, mUp), mUpLeft);
+					mPred = _Select(mBelowMin, _mm_xor_si128(mMaxS, mSign), mPred);
+					mPred = _Select(mAboveMax, _mm_xor_si128(mMinS, mSign), mPred);
+					return mPred;
+				}
+
+			protected:
+				static __m128i _Select(__m128i mMask, __m128i mTrue, __m128i mFalse)
+				{
+					return _mm_or_si128(_mm_and_si128(mMask, mTrue), _mm_andnot_si128(mMask, mFalse));
+				}
+			};
+
+			inline __m128i _UnZigZag(__m128i mCode)
+			{
+				return _mm_xor_si128(_mm_srli_epi16(mCode, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(mCode, _mm_set1_epi16(1))));
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Writes the zigzag coded prediction residuals of a row. The first Step samples are predicted from the
+			/// 	row above, and all samples of the first rows of a band, which have no upper row, from the left.
+			/// </summary>
+			///
+			/// <typeparam name="Step">	The number of samples between neighbors of the same channel or color. </typeparam>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TValue, int Step>
+			void _ResidualRow(uint16_t* puRes, const TValue* pRow, const TValue* pUp, size_t nCount, ECodecPredictor ePredictor)
+			{
+				using TLane = SLane<TValue>;
+
+				const size_t nHead = std::min(size_t(Step), nCount);
+				for (size_t nIdx = 0; nIdx < nHead; ++nIdx)
+				{
+					puRes[nIdx] = _ZigZag<TValue>(TValue(pRow[nIdx] - (pUp ? pUp[nIdx] : TValue(0))));
+				}
+
+				size_t nIdx = nHead;
+				if (pUp == nullptr || ePredictor == ECodecPredictor::Left)
+				{
+					for (; nIdx + 8 <= nCount; nIdx += 8)
+					{
+						const __m128i mDiff = _mm_sub_epi16(TLane::Load(pRow + nIdx), TLane::Load(pRow + nIdx - Step));
+						_mm_storeu_si128((__m128i*)(puRes + nIdx), TLane::ZigZag(mDiff));
+					}
+
+					for (; nIdx < nCount; ++nIdx)
+					{
+						puRes[nIdx] = _ZigZag<TValue>(TValue(pRow[nIdx] - pRow[nIdx - Step]));
+					}
+				}
+				else if (ePredictor == ECodecPredictor::Up)
+				{
+					for (; nIdx + 8 <= nCount; nIdx += 8)
+					{
+						const __m128i mDiff = _mm_sub_epi16(TLane::Load(pRow + nIdx), TLane::Load(pUp + nIdx));
+						_mm_storeu_si128((__m128i*)(puRes + nIdx), TLane::ZigZag(mDiff));
+					}
+
+					for (; nIdx < nCount; ++nIdx)
+					{
+						puRes[nIdx] = _ZigZag<TValue>(TValue(pRow[nIdx] - pUp[nIdx]));
+					}
+				}
+				else
+				{
+					for (; nIdx + 8 <= nCount; nIdx += 8)
+					{
+						const __m128i mPred = TLane::Med(TLane::Load(pRow + nIdx - Step), TLane::Load(pUp + nIdx), TLane::Load(pUp + nIdx - Step));
+						_mm_storeu_si128((__m128i*)(puRes + nIdx), TLane::ZigZag(_mm_sub_epi16(TLane::Load(pRow + nIdx), mPred)));
+					}
+
+					for (; nIdx < nCount; ++nIdx)
+					{
+						puRes[nIdx] = _ZigZag<TValue>(TValue(pRow[nIdx] - _Med(pRow[nIdx - Step], pUp[nIdx], pUp[nIdx - Step])));
+					}
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Inverts _ResidualRow(). The left and median predictions depend on the sample just decoded, so they are
+			/// 	reconstructed sequentially with the left neighbors of the Step channels kept in registers. The upper
+			/// 	prediction is reconstructed with SIMD.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TValue, int Step>
+			void _ReconstructRow(TValue* pRow, const TValue* pUp, const uint16_t* puRes, size_t nCount, ECodecPredictor ePredictor)
+			{
+				using TLane = SLane<TValue>;
+
+				const size_t nHead = std::min(size_t(Step), nCount);
+				for (size_t nIdx = 0; nIdx < nHead; ++nIdx)
+				{
+					pRow[nIdx] = TValue((pUp ? pUp[nIdx] : TValue(0)) + _UnZigZag<TValue>(puRes[nIdx]));
+				}
+
+				if (nCount <= nHead)
+				{
+					return;
+				}
+
+				if (ePredictor == ECodecPredictor::Up && pUp != nullptr)
+				{
+					size_t nIdx = nHead;
+					for (; nIdx + 8 <= nCount; nIdx += 8)
+					{
+						const __m128i mDiff = _UnZigZag(_mm_loadu_si128((const __m128i*)(puRes + nIdx)));
+						TLane::Store(pRow + nIdx, _mm_add_epi16(TLane::Load(pUp + nIdx), mDiff));
+					}
+
+					for (; nIdx < nCount; ++nIdx)
+					{
+						pRow[nIdx] = TValue(pUp[nIdx] + _UnZigZag<TValue>(puRes[nIdx]));
+					}
+
+					return;
+				}
+
+				TValue pLeft[Step];
+				for (int iCh = 0; iCh < Step; ++iCh)
+				{
+					pLeft[iCh] = pRow[iCh];
+				}
+
+				size_t nIdx = Step;
+				if (ePredictor == ECodecPredictor::Med && pUp != nullptr)
+				{
+					for (; nIdx + Step <= nCount; nIdx += Step)
+					{
+						for (int iCh = 0; iCh < Step; ++iCh)
+						{
+							const size_t nPos = nIdx + size_t(iCh);
+							pLeft[iCh] = TValue(_Med(pLeft[iCh], pUp[nPos], pUp[nPos - Step]) + _UnZigZag<TValue>(puRes[nPos]));
+							pRow[nPos] = pLeft[iCh];
+						}
+					}
+
+					// Bayer rows of odd width end with a partial group.
+					for (int iCh = 0; nIdx < nCount; ++nIdx, ++iCh)
+					{
+						pRow[nIdx] = TValue(_Med(pLeft[iCh], pUp[nIdx], pUp[nIdx - Step]) + _UnZigZag<TValue>(puRes[nIdx]));
+					}
+				}
+				else
+				{
+					for (; nIdx + Step <= nCount; nIdx += Step)
+					{
+						for (int iCh = 0; iCh < Step; ++iCh)
+						{
+							const size_t nPos = nIdx + size_t(iCh);
+							pLeft[iCh] = TValue(pLeft[iCh] + _UnZigZag<TValue>(puRes[nPos]));
+							pRow[nPos] = pLeft[iCh];
+						}
+					}
+
+					for (int iCh = 0; nIdx < nCount; ++nIdx, ++iCh)
+					{
+						pRow[nIdx] = TValue(pLeft[iCh] + _UnZigZag<TValue>(puRes[nIdx]));
+					}
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Resizes the memory of a band. The memory of a previous image is kept, unless it is clearly larger
+			/// 	than needed, since the compressed size is what matters.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			uint8_t* _ResizeBand(std::vector<uint8_t>& vecBand, size_t nByteCount)
+			{
+				if (vecBand.capacity() > nByteCount + nByteCount / 8)
+				{
+					std::vector<uint8_t>().swap(vecBand);
+				}
+
+				vecBand.resize(nByteCount);
+				return vecBand.data();
+			}
+
+			void _StoreBand(std::vector<uint8_t>& vecBand, const uint8_t* pucData, const SBandLayout& xLayout, size_t nRowByteCount, int iRowCount)
+			{
+				uint8_t* pucBand = _ResizeBand(vecBand, 1 + nRowByteCount * size_t(iRowCount));
+				*pucBand++ = BandStored;
+
+				for (int iRow = 0; iRow < iRowCount; ++iRow, pucBand += nRowByteCount)
+				{
+					memcpy(pucBand, pucData + size_t(iRow) * xLayout.nRowPitch, nRowByteCount);
+				}
+			}
+
+			void _LoadStoredBand(uint8_t* pucData, const std::vector<uint8_t>& vecBand, const SBandLayout& xLayout, size_t nRowByteCount, int iRowCount)
+			{
+				if (vecBand.size() != 1 + nRowByteCount * size_t(iRowCount))
+				{
+					throw CLU_EXCEPTION("Invalid size of stored band");
+				}
+
+				const uint8_t* pucBand = vecBand.data() + 1;
+				for (int iRow = 0; iRow < iRowCount; ++iRow, pucBand += nRowByteCount)
+				{
+					memcpy(pucData + size_t(iRow) * xLayout.nRowPitch, pucBand, nRowByteCount);
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Codes a band as the band mode byte, the bit count of each block and the packed blocks. The residuals
+			/// 	of all rows form one sequence, so that only the last block of a band is padded.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TValue, int Step>
+			void _EncodeBand(std::vector<uint8_t>& vecBand, SScratch& xScratch, const uint8_t* pucData, const SBandLayout& xLayout, int iRowCount)
+			{
+				const size_t nSampleCount = xLayout.nSampleCount;
+				const size_t nTotalCount = nSampleCount * size_t(iRowCount);
+				const size_t nBlockCount = (nTotalCount + BlockSampleCount - 1) / BlockSampleCount;
+
+				xScratch.vecResidual.resize(nBlockCount * BlockSampleCount);
+				uint16_t* puRes = xScratch.vecResidual.data();
+
+				for (int iRow = 0; iRow < iRowCount; ++iRow)
+				{
+					const TValue* pRow = (const TValue*)(pucData + size_t(iRow) * xLayout.nRowPitch);
+					const TValue* pUp = (iRow >= xLayout.iRowStep ? (const TValue*)(pucData + size_t(iRow - xLayout.iRowStep) * xLayout.nRowPitch) : nullptr);
+
+					_ResidualRow<TValue, Step>(puRes + size_t(iRow) * nSampleCount, pRow, pUp, nSampleCount, xLayout.ePredictor);
+				}
+
+				std::fill(puRes + nTotalCount, puRes + nBlockCount * BlockSampleCount, uint16_t(0));
+
+				xScratch.vecCode.resize(1 + nBlockCount + nBlockCount * BlockSampleCount * sizeof(uint16_t));
+				uint8_t* pucCode = xScratch.vecCode.data();
+				uint8_t* pucBitCount = pucCode + 1;
+				uint8_t* pucOut = pucBitCount + nBlockCount;
+
+				for (size_t nBlock = 0; nBlock < nBlockCount; ++nBlock)
+				{
+					const uint16_t* puBlock = puRes + nBlock * BlockSampleCount;
+					const int iBitCount = _BlockBitCount(puBlock);
+
+					pucBitCount[nBlock] = uint8_t(iBitCount);
+					if (iBitCount > 0)
+					{
+						_PackBlock(pucOut, puBlock, iBitCount);
+						pucOut += 16 * iBitCount;
+					}
+				}
+
+				const size_t nCodeByteCount = size_t(pucOut - pucCode);
+				const size_t nRowByteCount = nSampleCount * sizeof(TValue);
+				if (nCodeByteCount >= 1 + nRowByteCount * size_t(iRowCount))
+				{
+					_StoreBand(vecBand, pucData, xLayout, nRowByteCount, iRowCount);
+					return;
+				}
+
+				pucCode[0] = BandPacked;
+				memcpy(_ResizeBand(vecBand, nCodeByteCount), pucCode, nCodeByteCount);
+			}
+
+			template<typename TValue, int Step>
+			void _DecodeBand(uint8_t* pucData, SScratch& xScratch, const std::vector<uint8_t>& vecBand, const SBandLayout& xLayout, int iRowCount)
+			{
+				const size_t nSampleCount = xLayout.nSampleCount;
+				const size_t nRowByteCount = nSampleCount * sizeof(TValue);
+
+				if (vecBand.empty())
+				{
+					throw CLU_EXCEPTION("Empty band");
+				}
+
+				if (vecBand[0] == BandStored)
+				{
+					_LoadStoredBand(pucData, vecBand, xLayout, nRowByteCount, iRowCount);
+					return;
+				}
+
+				const size_t nTotalCount = nSampleCount * size_t(iRowCount);
+				const size_t nBlockCount = (nTotalCount + BlockSampleCount - 1) / BlockSampleCount;
+
+				if (vecBand[0] != BandPacked || vecBand.size() < 1 + nBlockCount)
+				{
+					throw CLU_EXCEPTION("Invalid band");
+				}
+
+				xScratch.vecResidual.resize(nBlockCount * BlockSampleCount);
+				uint16_t* puRes = xScratch.vecResidual.data();
+
+				const uint8_t* pucBitCount = vecBand.data() + 1;
+				const uint8_t* pucIn = pucBitCount + nBlockCount;
+				const uint8_t* pucEnd = vecBand.data() + vecBand.size();
+
+				for (size_t nBlock = 0; nBlock < nBlockCount; ++nBlock)
+				{
+					uint16_t* puBlock = puRes + nBlock * BlockSampleCount;
+					const int iBitCount = int(pucBitCount[nBlock]);
+
+					if (iBitCount > 16 || size_t(pucEnd - pucIn) < size_t(16 * iBitCount))
+					{
+						throw CLU_EXCEPTION("Invalid packed block");
+					}
+
+					if (iBitCount == 0)
+					{
+						memset(puBlock, 0, BlockSampleCount * sizeof(uint16_t));
+					}
+					else
+					{
+						_UnpackBlock(puBlock, pucIn, iBitCount);
+						pucIn += 16 * iBitCount;
+					}
+				}
+
+				for (int iRow = 0; iRow < iRowCount; ++iRow)
+				{
+					TValue* pRow = (TValue*)(pucData + size_t(iRow) * xLayout.nRowPitch);
+					const TValue* pUp = (iRow >= xLayout.iRowStep ? (const TValue*)(pucData + size_t(iRow - xLayout.iRowStep) * xLayout.nRowPitch) : nullptr);
+
+					_ReconstructRow<TValue, Step>(pRow, pUp, puRes + size_t(iRow) * nSampleCount, nSampleCount, xLayout.ePredictor);
+				}
+			}
+
+			using TEncodeBand = void(*)(std::vector<uint8_t>&, SScratch&, const uint8_t*, const SBandLayout&, int);
+			using TDecodeBand = void(*)(uint8_t*, SScratch&, const std::vector<uint8_t>&, const SBandLayout&, int);
+
+			template<typename TValue>
+			void _SelectBandCoder(TEncodeBand& pEncode, TDecodeBand& pDecode, size_t nStep)
+			{
+				switch (nStep)
+				{
+				case 1:
+					pEncode = &_EncodeBand<TValue, 1>;
+					pDecode = &_DecodeBand<TValue, 1>;
+					break;
+				case 2:
+					pEncode = &_EncodeBand<TValue, 2>;
+					pDecode = &_DecodeBand<TValue, 2>;
+					break;
+				case 3:
+					pEncode = &_EncodeBand<TValue, 3>;
+					pDecode = &_DecodeBand<TValue, 3>;
+					break;
+				case 4:
+					pEncode = &_EncodeBand<TValue, 4>;
+					pDecode = &_DecodeBand<TValue, 4>;
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported pixel type");
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Selects the band coder of a format. Formats of other than 8 and 16 bit integers have no coder and are
+			/// 	stored. Bayer samples are predicted from the samples of the same color, two columns and rows away.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void _SelectBandCoder(TEncodeBand& pEncode, TDecodeBand& pDecode, int& iRowStep, const SImageFormat& xFormat)
+			{
+				const bool bBayer = SImageType::IsBayerPixelType(xFormat.ePixelType);
+				const size_t nStep = (bBayer ? 2 : SImageType::DimOf(xFormat.ePixelType));
+				iRowStep = (bBayer ? 2 : 1);
+
+				pEncode = nullptr;
+				pDecode = nullptr;
+
+				switch (xFormat.eDataType)
+				{
+				case EDataType::Int8:
+				case EDataType::UInt8:
+					_SelectBandCoder<uint8_t>(pEncode, pDecode, nStep);
+					break;
+				case EDataType::Int16:
+				case EDataType::UInt16:
+					_SelectBandCoder<uint16_t>(pEncode, pDecode, nStep);
+					break;
+				default:
+					break;
+				}
+			}
+		} // namespace
+
+		CCompressedImage::CCompressedImage()
+		{
+			m_ePredictor = ECodecPredictor::Med;
+			m_iBandRowCount = 0;
+		}
+
+		size_t CCompressedImage::ByteCount() const
+		{
+			size_t nByteCount = 0;
+			for (const std::vector<uint8_t>& vecBand : m_vecBand)
+			{
+				nByteCount += vecBand.size();
+			}
+
+			return nByteCount;
+		}
+
+		void CCompressedImage::Compress(const void* pData, const SImageFormat& xFormat, ECodecPredictor ePredictor, int iBandRowCount)
+		{
+			try
+			{
+				if (pData == nullptr || !xFormat.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid image data");
+				}
+
+				if (iBandRowCount < 0)
+				{
+					throw CLU_EXCEPTION("Invalid band row count");
+				}
+
+				TEncodeBand pEncode;
+				TDecodeBand pDecode;
+				int iRowStep;
+				_SelectBandCoder(pEncode, pDecode, iRowStep, xFormat);
+
+				const size_t nRowByteCount = xFormat.RowByteCount();
+				if (iBandRowCount == 0)
+				{
+					iBandRowCount = int(std::max<size_t>(DefaultBandByteCount / nRowByteCount, 1));
+				}
+
+				// Bands start at rows of the same Bayer phase.
+				iBandRowCount = std::min(std::max(iBandRowCount + iBandRowCount % iRowStep, iRowStep), xFormat.iHeight);
+
+				SBandLayout xLayout;
+				xLayout.nSampleCount = size_t(xFormat.iWidth) * SImageType::DimOf(xFormat.ePixelType);
+				xLayout.nRowPitch = xFormat.RowPitch();
+				xLayout.iRowStep = iRowStep;
+				xLayout.ePredictor = ePredictor;
+
+				const size_t nBandCount = (size_t(xFormat.iHeight) + size_t(iBandRowCount) - 1) / size_t(iBandRowCount);
+				m_vecBand.resize(nBandCount);
+
+				m_xFormat.Clear();
+
+				Clu::Parallel::ForEachBlock(nBandCount, 1, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					SScratch xScratch;
+					for (size_t nBand = nBegin; nBand < nEnd; ++nBand)
+					{
+						const int iFirstRow = int(nBand) * iBandRowCount;
+						const int iRowCount = std::min(iBandRowCount, xFormat.iHeight - iFirstRow);
+						const uint8_t* pucBand = (const uint8_t*)pData + size_t(iFirstRow) * xLayout.nRowPitch;
+
+						if (pEncode)
+						{
+							pEncode(m_vecBand[nBand], xScratch, pucBand, xLayout, iRowCount);
+						}
+						else
+						{
+							_StoreBand(m_vecBand[nBand], pucBand, xLayout, nRowByteCount, iRowCount);
+						}
+					}
+				});
+
+				m_xFormat = xFormat;
+				m_ePredictor = ePredictor;
+				m_iBandRowCount = iBandRowCount;
+			}
+			CLU_CATCH_RETHROW_ALL("Error compressing image")
+		}
+
+		void CCompressedImage::Compress(const CIImage& imgSrc, ECodecPredictor ePredictor, int iBandRowCount)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				Compress(imgSrc.DataPointer(), imgSrc.Format(), ePredictor, iBandRowCount);
+			}
+			CLU_CATCH_RETHROW_ALL("Error compressing image")
+		}
+
+		void CCompressedImage::Decompress(void* pData, const SImageFormat& xFormat) const
+		{
+			try
+			{
+				if (!IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid compressed image");
+				}
+
+				if (pData == nullptr || !xFormat.IsValid() || xFormat != m_xFormat)
+				{
+					throw CLU_EXCEPTION("Target format differs from the format of the compressed image");
+				}
+
+				TEncodeBand pEncode;
+				TDecodeBand pDecode;
+				int iRowStep;
+				_SelectBandCoder(pEncode, pDecode, iRowStep, m_xFormat);
+
+				SBandLayout xLayout;
+				xLayout.nSampleCount = size_t(m_xFormat.iWidth) * SImageType::DimOf(m_xFormat.ePixelType);
+				xLayout.nRowPitch = xFormat.RowPitch();
+				xLayout.iRowStep = iRowStep;
+				xLayout.ePredictor = m_ePredictor;
+
+				const size_t nRowByteCount = m_xFormat.RowByteCount();
+				const int iBandRowCount = m_iBandRowCount;
+
+				Clu::Parallel::ForEachBlock(m_vecBand.size(), 1, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					SScratch xScratch;
+					for (size_t nBand = nBegin; nBand < nEnd; ++nBand)
+					{
+						const int iFirstRow = int(nBand) * iBandRowCount;
+						const int iRowCount = std::min(iBandRowCount, m_xFormat.iHeight - iFirstRow);
+						uint8_t* pucBand = (uint8_t*)pData + size_t(iFirstRow) * xLayout.nRowPitch;
+
+						if (pDecode)
+						{
+							pDecode(pucBand, xScratch, m_vecBand[nBand], xLayout, iRowCount);
+						}
+						else
+						{
+							_LoadStoredBand(pucBand, m_vecBand[nBand], xLayout, nRowByteCount, iRowCount);
+						}
+					}
+				});
+			}
+			CLU_CATCH_RETHROW_ALL("Error decompressing image")
+		}
+
+		void CCompressedImage::Decompress(CIImage& imgTrg) const
+		{
+			try
+			{
+				if (!IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid compressed image");
+				}
+
+				imgTrg.Create(m_xFormat);
+				Decompress(imgTrg.DataPointer(), imgTrg.Format());
+			}
+			CLU_CATCH_RETHROW_ALL("Error decompressing image")
+		}
+
+		void CCompressedImage::Destroy()
+		{
+			m_xFormat.Clear();
+			m_ePredictor = ECodecPredictor::Med;
+			m_iBandRowCount = 0;
+			std::vector<std::vector<uint8_t>>().swap(m_vecBand);
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Codec.h
+//
+// summary:   Declares the lossless in-memory compression of images
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		/// <summary>	The prediction of each sample from its already coded neighbors of the same channel or Bayer color. </summary>
+		enum class ECodecPredictor
+		{
+			/// <summary>	The left neighbor. Fastest to compress and decompress. </summary>
+			Left = 0,
+
+			/// <summary>	The upper neighbor. Decompression of a row is not sequential and thus the fastest. </summary>
+			Up,
+
+			/// <summary>	The median edge detector of LOCO-I / JPEG-LS from the left, upper and upper left neighbors. </summary>
+			Med,
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	An image compressed losslessly in memory, for example for the frames of a ring buffer. Each sample is
+		/// 	replaced by the zigzag coded difference to its prediction, and the differences are bit packed in
+		/// 	blocks of BlockSampleCount samples with the bit count of the largest difference of the block. The
+		/// 	image is split into bands of rows that are coded independently and in parallel. Bands that would not
+		/// 	get smaller, and images of data types other than 8 and 16 bit integers, are stored uncompressed.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CCompressedImage
+		{
+		public:
+			static const int BlockSampleCount = 128;
+
+		public:
+			CCompressedImage();
+
+			bool IsValid() const
+			{
+				return m_xFormat.IsValid();
+			}
+
+			/// <summary>	The format of the decompressed image. </summary>
+			const SImageFormat& Format() const
+			{
+				return m_xFormat;
+			}
+
+			ECodecPredictor Predictor() const
+			{
+				return m_ePredictor;
+			}
+
+			int BandRowCount() const
+			{
+				return m_iBandRowCount;
+			}
+
+			/// <summary>	The number of bytes of the compressed data. </summary>
+			size_t ByteCount() const;
+
+			/// <summary>	The number of bytes of the pixels of the image, without row padding. </summary>
+			size_t RawByteCount() const
+			{
+				return m_xFormat.RowByteCount() * size_t(m_xFormat.iHeight);
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Compresses image memory. The memory of a previous image is reused where possible. </summary>
+			///
+			/// <param name="pData">		The image memory. </param>
+			/// <param name="xFormat">		The image format. </param>
+			/// <param name="ePredictor">	The prediction of the samples. </param>
+			/// <param name="iBandRowCount">	The number of rows per band, or zero for bands of about 256 KB. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void Compress(const void* pData, const SImageFormat& xFormat, ECodecPredictor ePredictor = ECodecPredictor::Med
+				, int iBandRowCount = 0);
+
+			void Compress(const CIImage& imgSrc, ECodecPredictor ePredictor = ECodecPredictor::Med, int iBandRowCount = 0);
+
+			/// <summary>	Decompresses into memory of the width, height and type of Format(). The row pitch may differ. </summary>
+			void Decompress(void* pData, const SImageFormat& xFormat) const;
+
+			/// <summary>
+			/// 	Creates the image with Format() and decompresses into it. With CIImageMemoryPool enabled, the memory of
+			/// 	the image is taken from the pool.
+			/// </summary>
+			void Decompress(CIImage& imgTrg) const;
+
+			void Destroy();
+
+		protected:
+			SImageFormat m_xFormat;
+			ECodecPredictor m_ePredictor;
+			int m_iBandRowCount;
+
+			/// <summary>	The coded bands. The first byte of each band gives whether it is stored or packed. </summary>
+			std::vector<std::vector<uint8_t>> m_vecBand;
+		};
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Convert.Avx2.cpp
+//
+// summary:   Implements the AVX2 kernels of the image conversion functions
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+
+#include <immintrin.h>
+
+#include "Image.Avx2.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Avx2
+		{
+			void ConvertUInt8ToSingle(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				float* pfTrg = (float*)pTrg;
+				const uint8_t* puSrc = (const uint8_t*)pSrc;
+				size_t nIdx = 0;
+
+				const __m256 mMax = _mm256_set1_ps(255.0f);
+				for (; nIdx + 16 <= nCount; nIdx += 16)
+				{
+					const __m128i mV = _mm_loadu_si128((const __m128i*)(puSrc + nIdx));
+					_mm256_storeu_ps(pfTrg + nIdx, _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(mV)), mMax));
+					_mm256_storeu_ps(pfTrg + nIdx + 8, _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(mV, 8))), mMax));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pfTrg[nIdx] = float(puSrc[nIdx]) / 255.0f;
+				}
+			}
+
+			void ConvertUInt16ToSingle(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				float* pfTrg = (float*)pTrg;
+				const uint16_t* puSrc = (const uint16_t*)pSrc;
+				size_t nIdx = 0;
+
+				const __m256 mMax = _mm256_set1_ps(65535.0f);
+				for (; nIdx + 8 <= nCount; nIdx += 8)
+				{
+					const __m128i mV = _mm_loadu_si128((const __m128i*)(puSrc + nIdx));
+					_mm256_storeu_ps(pfTrg + nIdx, _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(mV)), mMax));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pfTrg[nIdx] = float(puSrc[nIdx]) / 65535.0f;
+				}
+			}
+
+			void SwapRedBlue4xUInt8(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				uint32_t* puTrg = (uint32_t*)pTrg;
+				const uint32_t* puSrc = (const uint32_t*)pSrc;
+				size_t nIdx = 0;
+
+				const __m256i mKeep = _mm256_set1_epi32(int(0xFF00FF00));
+				const __m256i mByte = _mm256_set1_epi32(0xFF);
+				for (; nIdx + 8 <= nCount; nIdx += 8)
+				{
+					const __m256i mV = _mm256_loadu_si256((const __m256i*)(puSrc + nIdx));
+					__m256i mR = _mm256_and_si256(mV, mKeep);
+					mR = _mm256_or_si256(mR, _mm256_and_si256(_mm256_srli_epi32(mV, 16), mByte));
+					mR = _mm256_or_si256(mR, _mm256_slli_epi32(_mm256_and_si256(mV, mByte), 16));
+					_mm256_storeu_si256((__m256i*)(puTrg + nIdx), mR);
+				}
+
+				const uint8_t* pucSrc = (const uint8_t*)pSrc;
+				uint8_t* pucTrg = (uint8_t*)pTrg;
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pucTrg[4 * nIdx + 0] = pucSrc[4 * nIdx + 2];
+					pucTrg[4 * nIdx + 1] = pucSrc[4 * nIdx + 1];
+					pucTrg[4 * nIdx + 2] = pucSrc[4 * nIdx + 0];
+					pucTrg[4 * nIdx + 3] = pucSrc[4 * nIdx + 3];
+				}
+			}
+
+			void SwapRedBlue3xUInt8(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				uint8_t* pucTrg = (uint8_t*)pTrg;
+				const uint8_t* pucSrc = (const uint8_t*)pSrc;
+				size_t nIdx = 0;
+
+				// Ten pixels per step, five in each 128 bit lane. The 16th byte of a lane is written unchanged and
+				// overwritten by the next lane, the next step or the tail.
+				const __m256i mShuffle = _mm256_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15
+					, 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+				for (; 3 * nIdx + 31 <= 3 * nCount; nIdx += 10)
+				{
+					const __m128i mLo = _mm_loadu_si128((const __m128i*)(pucSrc + 3 * nIdx));
+					const __m128i mHi = _mm_loadu_si128((const __m128i*)(pucSrc + 3 * nIdx + 15));
+					const __m256i mR = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(mLo), mHi, 1), mShuffle);
+
+					// The lanes overlap by one byte, so they are stored one after the other.
+					_mm_storeu_si128((__m128i*)(pucTrg + 3 * nIdx), _mm256_castsi256_si128(mR));
+					_mm_storeu_si128((__m128i*)(pucTrg + 3 * nIdx + 15), _mm256_extracti128_si256(mR, 1));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pucTrg[3 * nIdx + 0] = pucSrc[3 * nIdx + 2];
+					pucTrg[3 * nIdx + 1] = pucSrc[3 * nIdx + 1];
+					pucTrg[3 * nIdx + 2] = pucSrc[3 * nIdx + 0];
+				}
+			}
+		} // namespace Avx2
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,745 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Convert.cpp
+//
+// summary:   Implements the image conversion functions
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "Image.Convert.h"
+#include "Image.Avx2.h"
+
+#include "CluTec.Types1/Pixel.h"
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/IntrinsicFunctions.h"
+#include "CluTec.Base/Parallel.h"
+#include "CluTec.Math/MapPixelValue.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	Converts nCount elements from pSrc to pTrg. Elements are values or pixels, depending on the function. </summary>
+			using TRowFunc = void(*)(void* pTrg, const void* pSrc, size_t nCount);
+
+			/// <summary>	Minimal number of bytes per thread. </summary>
+			const size_t ConvertMinBlockBytes = size_t(1) << 16;
+
+			// Luminance weights 0.299, 0.587 and 0.114 in units of 2^-15, shared by all code paths, so that the SIMD
+			// kernels give the same result as the generic conversion.
+			const int LumWeightRed = 9798;
+			const int LumWeightGreen = 19235;
+			const int LumWeightBlue = 3735;
+			const int LumShift = 15;
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Generic conversion
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename TValue>
+			TValue _Luminance(TValue xR, TValue xG, TValue xB, std::true_type /* integral */)
+			{
+				const int64_t iSum = int64_t(LumWeightRed) * int64_t(xR) + int64_t(LumWeightGreen) * int64_t(xG)
+					+ int64_t(LumWeightBlue) * int64_t(xB);
+
+				return TValue((iSum + (int64_t(1) << (LumShift - 1))) >> LumShift);
+			}
+
+			template<typename TValue>
+			TValue _Luminance(TValue xR, TValue xG, TValue xB, std::false_type /* floating point */)
+			{
+				return (TValue(LumWeightRed) * xR + TValue(LumWeightGreen) * xG + TValue(LumWeightBlue) * xB) / TValue(1 << LumShift);
+			}
+
+			template<typename TValue>
+			TValue _AlphaOpaque(std::true_type /* integral */)
+			{
+				return std::numeric_limits<TValue>::max();
+			}
+
+			template<typename TValue>
+			TValue _AlphaOpaque(std::false_type /* floating point */)
+			{
+				return TValue(1);
+			}
+
+			template<typename TPixelTrg, typename TPixelSrc>
+			void _SetColor(TPixelTrg& pixTrg, const TPixelSrc& pixSrc, std::integral_constant<int, 3>, std::integral_constant<int, 3>)
+			{
+				pixTrg.r() = pixSrc.r();
+				pixTrg.g() = pixSrc.g();
+				pixTrg.b() = pixSrc.b();
+			}
+
+			template<typename TPixelTrg, typename TPixelSrc>
+			void _SetColor(TPixelTrg& pixTrg, const TPixelSrc& pixSrc, std::integral_constant<int, 1>, std::integral_constant<int, 3>)
+			{
+				using TData = typename TPixelTrg::TData;
+				pixTrg.r() = _Luminance(pixSrc.r(), pixSrc.g(), pixSrc.b(), std::is_integral<TData>());
+			}
+
+			template<typename TPixelTrg, typename TPixelSrc>
+			void _SetColor(TPixelTrg& pixTrg, const TPixelSrc& pixSrc, std::integral_constant<int, 3>, std::integral_constant<int, 1>)
+			{
+				pixTrg.r() = pixSrc.r();
+				pixTrg.g() = pixSrc.r();
+				pixTrg.b() = pixSrc.r();
+			}
+
+			template<typename TPixelTrg, typename TPixelSrc>
+			void _SetColor(TPixelTrg& pixTrg, const TPixelSrc& pixSrc, std::integral_constant<int, 1>, std::integral_constant<int, 1>)
+			{
+				pixTrg.r() = pixSrc.r();
+			}
+
+			template<typename TPixelTrg, typename TPixelSrc>
+			void _SetAlpha(TPixelTrg& pixTrg, const TPixelSrc& pixSrc, std::true_type /* target alpha */, std::true_type /* source alpha */)
+			{
+				pixTrg.a() = pixSrc.a();
+			}
+
+			template<typename TPixelTrg, typename TPixelSrc>
+			void _SetAlpha(TPixelTrg& pixTrg, const TPixelSrc& /*pixSrc*/, std::true_type /* target alpha */, std::false_type /* source alpha */)
+			{
+				using TData = typename TPixelTrg::TData;
+				pixTrg.a() = _AlphaOpaque<TData>(std::is_integral<TData>());
+			}
+
+			template<typename TPixelTrg, typename TPixelSrc, typename TSrcAlpha>
+			void _SetAlpha(TPixelTrg& /*pixTrg*/, const TPixelSrc& /*pixSrc*/, std::false_type /* target alpha */, TSrcAlpha)
+			{
+			}
+
+			/// <summary>	Converts the channel layout of nCount pixels of the same data type. </summary>
+			template<typename TPixelTrg, typename TPixelSrc>
+			void _ConvertLayout(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				static_assert(std::is_same<typename TPixelTrg::TData, typename TPixelSrc::TData>::value, "Layout conversion requires equal data types");
+
+				TPixelTrg* pPixTrg = (TPixelTrg*)pTrg;
+				const TPixelSrc* pPixSrc = (const TPixelSrc*)pSrc;
+
+				for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+				{
+					_SetColor(pPixTrg[nIdx], pPixSrc[nIdx]
+						, std::integral_constant<int, int(TPixelTrg::ColorCount)>()
+						, std::integral_constant<int, int(TPixelSrc::ColorCount)>());
+
+					_SetAlpha(pPixTrg[nIdx], pPixSrc[nIdx]
+						, std::integral_constant<bool, (TPixelTrg::AlphaCount > 0)>()
+						, std::integral_constant<bool, (TPixelSrc::AlphaCount > 0)>());
+				}
+			}
+
+			/// <summary>	Maps nCount values between data types. </summary>
+			template<typename TTrg, typename TSrc>
+			void _MapValues(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				TTrg* pValTrg = (TTrg*)pTrg;
+				const TSrc* pValSrc = (const TSrc*)pSrc;
+
+				for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+				{
+					pValTrg[nIdx] = Clu::MapPixelValue<TTrg>(pValSrc[nIdx]);
+				}
+			}
+
+			void _CopyValues(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				memcpy(pTrg, pSrc, nCount);
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// SIMD kernels. They use SSE2. _SelectKernel() takes the AVX2 kernels of Image.Convert.Avx2.cpp
+			// instead where there are some and the processor supports them.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			/// <summary>	uint8 to normalized float. Divides like ToNormFloat(), so the results are identical. </summary>
+			void _KernelUInt8ToSingle(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				float* pfTrg = (float*)pTrg;
+				const uint8_t* puSrc = (const uint8_t*)pSrc;
+				size_t nIdx = 0;
+
+				const __m128 mMax = _mm_set1_ps(255.0f);
+				const __m128i mZero = _mm_setzero_si128();
+				for (; nIdx + 16 <= nCount; nIdx += 16)
+				{
+					const __m128i mV = _mm_loadu_si128((const __m128i*)(puSrc + nIdx));
+					const __m128i mLo = _mm_unpacklo_epi8(mV, mZero);
+					const __m128i mHi = _mm_unpackhi_epi8(mV, mZero);
+
+					_mm_storeu_ps(pfTrg + nIdx, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(mLo, mZero)), mMax));
+					_mm_storeu_ps(pfTrg + nIdx + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(mLo, mZero)), mMax));
+					_mm_storeu_ps(pfTrg + nIdx + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(mHi, mZero)), mMax));
+					_mm_storeu_ps(pfTrg + nIdx + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(mHi, mZero)), mMax));
+				}
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pfTrg[nIdx] = float(puSrc[nIdx]) / 255.0f;
+				}
+			}
+
+			/// <summary>	uint16 to normalized float. </summary>
+			void _KernelUInt16ToSingle(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				float* pfTrg = (float*)pTrg;
+				const uint16_t* puSrc = (const uint16_t*)pSrc;
+				size_t nIdx = 0;
+
+				const __m128 mMax = _mm_set1_ps(65535.0f);
+				const __m128i mZero = _mm_setzero_si128();
+				for (; nIdx + 8 <= nCount; nIdx += 8)
+				{
+					const __m128i mV = _mm_loadu_si128((const __m128i*)(puSrc + nIdx));
+					_mm_storeu_ps(pfTrg + nIdx, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(mV, mZero)), mMax));
+					_mm_storeu_ps(pfTrg + nIdx + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(mV, mZero)), mMax));
+				}
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pfTrg[nIdx] = float(puSrc[nIdx]) / 65535.0f;
+				}
+			}
+
+			/// <summary>
+			/// 	Normalized float to uint8. Rounds and clamps like NormFloatTo(). Clamping before the truncating
+			/// 	conversion makes truncation equal to the floor of NormFloatTo().
+			/// </summary>
+			void _KernelSingleToUInt8(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				uint8_t* puTrg = (uint8_t*)pTrg;
+				const float* pfSrc = (const float*)pSrc;
+				size_t nIdx = 0;
+
+				const __m128 mMax = _mm_set1_ps(255.0f);
+				const __m128 mHalf = _mm_set1_ps(0.5f);
+				const __m128 mZero = _mm_setzero_ps();
+
+				for (; nIdx + 16 <= nCount; nIdx += 16)
+				{
+					__m128i pmI[4];
+					for (int iPart = 0; iPart < 4; ++iPart)
+					{
+						__m128 mV = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pfSrc + nIdx + 4 * iPart), mMax), mHalf);
+						mV = _mm_min_ps(_mm_max_ps(mV, mZero), mMax);
+						pmI[iPart] = _mm_cvttps_epi32(mV);
+					}
+
+					const __m128i mLo = _mm_packs_epi32(pmI[0], pmI[1]);
+					const __m128i mHi = _mm_packs_epi32(pmI[2], pmI[3]);
+					_mm_storeu_si128((__m128i*)(puTrg + nIdx), _mm_packus_epi16(mLo, mHi));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					puTrg[nIdx] = Clu::MapPixelValue<uint8_t>(pfSrc[nIdx]);
+				}
+			}
+
+			/// <summary>	Swaps red and blue of 4 channel uint8 pixels, i.e. RGBA to BGRA and vice versa. </summary>
+			void _KernelSwapRedBlue4xUInt8(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				uint32_t* puTrg = (uint32_t*)pTrg;
+				const uint32_t* puSrc = (const uint32_t*)pSrc;
+				size_t nIdx = 0;
+
+				const __m128i mKeep = _mm_set1_epi32(int(0xFF00FF00));
+				const __m128i mByte = _mm_set1_epi32(0xFF);
+				for (; nIdx + 4 <= nCount; nIdx += 4)
+				{
+					const __m128i mV = _mm_loadu_si128((const __m128i*)(puSrc + nIdx));
+					__m128i mR = _mm_and_si128(mV, mKeep);
+					mR = _mm_or_si128(mR, _mm_and_si128(_mm_srli_epi32(mV, 16), mByte));
+					mR = _mm_or_si128(mR, _mm_slli_epi32(_mm_and_si128(mV, mByte), 16));
+					_mm_storeu_si128((__m128i*)(puTrg + nIdx), mR);
+				}
+				const uint8_t* pucSrc = (const uint8_t*)pSrc;
+				uint8_t* pucTrg = (uint8_t*)pTrg;
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pucTrg[4 * nIdx + 0] = pucSrc[4 * nIdx + 2];
+					pucTrg[4 * nIdx + 1] = pucSrc[4 * nIdx + 1];
+					pucTrg[4 * nIdx + 2] = pucSrc[4 * nIdx + 0];
+					pucTrg[4 * nIdx + 3] = pucSrc[4 * nIdx + 3];
+				}
+			}
+
+			/// <summary>	Swaps red and blue of 3 channel uint8 pixels, i.e. RGB to BGR and vice versa. </summary>
+			void _KernelSwapRedBlue3xUInt8(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				uint8_t* pucTrg = (uint8_t*)pTrg;
+				const uint8_t* pucSrc = (const uint8_t*)pSrc;
+				size_t nIdx = 0;
+
+				// Five pixels per step, moving red and blue by two bytes. The 16th byte is written unchanged and
+				// overwritten by the next step or the tail.
+				const __m128i mKeep = _mm_setr_epi8(0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, -1);
+				const __m128i mRed = _mm_setr_epi8(-1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, 0);
+				const __m128i mBlue = _mm_setr_epi8(0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0);
+				for (; 3 * nIdx + 16 <= 3 * nCount; nIdx += 5)
+				{
+					const __m128i mV = _mm_loadu_si128((const __m128i*)(pucSrc + 3 * nIdx));
+					__m128i mR = _mm_and_si128(mV, mKeep);
+					mR = _mm_or_si128(mR, _mm_and_si128(_mm_srli_si128(mV, 2), mRed));
+					mR = _mm_or_si128(mR, _mm_and_si128(_mm_slli_si128(mV, 2), mBlue));
+					_mm_storeu_si128((__m128i*)(pucTrg + 3 * nIdx), mR);
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pucTrg[3 * nIdx + 0] = pucSrc[3 * nIdx + 2];
+					pucTrg[3 * nIdx + 1] = pucSrc[3 * nIdx + 1];
+					pucTrg[3 * nIdx + 2] = pucSrc[3 * nIdx + 0];
+				}
+			}
+
+			/// <summary>	Loads four 3 or 4 channel uint8 pixels into the 32 bit lanes of a register. </summary>
+			template<int t_iChannelCount>
+			__m128i _LoadPixels4xUInt8(const uint8_t* pucSrc);
+
+			template<>
+			inline __m128i _LoadPixels4xUInt8<4>(const uint8_t* pucSrc)
+			{
+				return _mm_loadu_si128((const __m128i*)pucSrc);
+			}
+
+			/// <summary>	The fourth byte of each lane is that of the next pixel. Reads 16 bytes. </summary>
+			template<>
+			inline __m128i _LoadPixels4xUInt8<3>(const uint8_t* pucSrc)
+			{
+				const __m128i mV = _mm_loadu_si128((const __m128i*)pucSrc);
+				const __m128i mP01 = _mm_unpacklo_epi32(mV, _mm_srli_si128(mV, 3));
+				const __m128i mP23 = _mm_unpacklo_epi32(_mm_srli_si128(mV, 6), _mm_srli_si128(mV, 9));
+				return _mm_unpacklo_epi64(mP01, mP23);
+			}
+
+			/// <summary>
+			/// 	Luminance of 3 or 4 channel uint8 pixels, whose red channel is at index t_iRedIdx (0 or 2). The
+			/// 	fourth channel has weight zero, so 3 channel pixels are loaded like 4 channel pixels.
+			/// </summary>
+			template<int t_iChannelCount, int t_iRedIdx>
+			void _KernelLumUInt8(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				uint8_t* pucTrg = (uint8_t*)pTrg;
+				const uint8_t* pucSrc = (const uint8_t*)pSrc;
+				size_t nIdx = 0;
+
+				const int iW0 = (t_iRedIdx == 0 ? LumWeightRed : LumWeightBlue);
+				const int iW2 = (t_iRedIdx == 0 ? LumWeightBlue : LumWeightRed);
+
+				const __m128i mWeight = _mm_setr_epi16(short(iW0), short(LumWeightGreen), short(iW2), 0, short(iW0), short(LumWeightGreen), short(iW2), 0);
+				const __m128i mRound = _mm_set1_epi32(1 << (LumShift - 1));
+				const __m128i mZero = _mm_setzero_si128();
+
+				// The last load of 3 channel pixels reads 4 bytes beyond the 16 pixels of a step.
+				const size_t nOverread = (t_iChannelCount == 3 ? 4 : 0);
+				for (; t_iChannelCount * (nIdx + 16) + nOverread <= t_iChannelCount * nCount; nIdx += 16)
+				{
+					__m128i pmSum[4];
+					for (int iPart = 0; iPart < 4; ++iPart)
+					{
+						const __m128i mV = _LoadPixels4xUInt8<t_iChannelCount>(pucSrc + t_iChannelCount * (nIdx + 4 * iPart));
+
+						// Per pixel the sums of the first two and of the last two channels
+						const __m128 mLo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(mV, mZero), mWeight));
+						const __m128 mHi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(mV, mZero), mWeight));
+
+						const __m128i mEven = _mm_castps_si128(_mm_shuffle_ps(mLo, mHi, _MM_SHUFFLE(2, 0, 2, 0)));
+						const __m128i mOdd = _mm_castps_si128(_mm_shuffle_ps(mLo, mHi, _MM_SHUFFLE(3, 1, 3, 1)));
+
+						pmSum[iPart] = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(mEven, mOdd), mRound), LumShift);
+					}
+
+					const __m128i mLo = _mm_packs_epi32(pmSum[0], pmSum[1]);
+					const __m128i mHi = _mm_packs_epi32(pmSum[2], pmSum[3]);
+					_mm_storeu_si128((__m128i*)(pucTrg + nIdx), _mm_packus_epi16(mLo, mHi));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					const uint8_t* pucPix = pucSrc + t_iChannelCount * nIdx;
+					pucTrg[nIdx] = uint8_t((iW0 * pucPix[0] + LumWeightGreen * pucPix[1] + iW2 * pucPix[2] + (1 << (LumShift - 1))) >> LumShift);
+				}
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Type dispatch
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename TOp>
+			void _DispatchDataType(EDataType eDataType, TOp& xOp)
+			{
+				switch (eDataType)
+				{
+				case EDataType::Int8: xOp.template Apply<T_Int8>(); break;
+				case EDataType::Int16: xOp.template Apply<T_Int16>(); break;
+				case EDataType::Int32: xOp.template Apply<T_Int32>(); break;
+				case EDataType::UInt8: xOp.template Apply<T_UInt8>(); break;
+				case EDataType::UInt16: xOp.template Apply<T_UInt16>(); break;
+				case EDataType::UInt32: xOp.template Apply<T_UInt32>(); break;
+				case EDataType::Single: xOp.template Apply<T_Single>(); break;
+				case EDataType::Double: xOp.template Apply<T_Double>(); break;
+				default:
+					throw CLU_EXCEPTION("Unsupported image data type");
+				}
+			}
+
+			template<typename TOp>
+			void _DispatchPixelType(EPixelType ePixelType, TOp& xOp)
+			{
+				switch (ePixelType)
+				{
+				case EPixelType::Lum: xOp.template Apply<T_Lum>(); break;
+				case EPixelType::LumA: xOp.template Apply<T_LumA>(); break;
+				case EPixelType::RGB: xOp.template Apply<T_RGB>(); break;
+				case EPixelType::RGBA: xOp.template Apply<T_RGBA>(); break;
+				case EPixelType::BGR: xOp.template Apply<T_BGR>(); break;
+				case EPixelType::BGRA: xOp.template Apply<T_BGRA>(); break;
+				default:
+					throw CLU_EXCEPTION("Unsupported image pixel type");
+				}
+			}
+
+			template<typename TSrcData>
+			struct SSelectMapValuesTrg
+			{
+				TRowFunc pFunc;
+
+				template<typename TTrgData>
+				void Apply()
+				{
+					pFunc = &_MapValues<typename TTrgData::TData, typename TSrcData::TData>;
+				}
+			};
+
+			struct SSelectMapValues
+			{
+				EDataType eTrgDataType;
+				TRowFunc pFunc;
+
+				template<typename TSrcData>
+				void Apply()
+				{
+					SSelectMapValuesTrg<TSrcData> xOp;
+					_DispatchDataType(eTrgDataType, xOp);
+					pFunc = xOp.pFunc;
+				}
+			};
+
+			template<typename TSrcPixel, typename TData>
+			struct SSelectLayoutTrg
+			{
+				TRowFunc pFunc;
+
+				template<typename TTrgPixel>
+				void Apply()
+				{
+					pFunc = &_ConvertLayout<SPixel<TTrgPixel, TData>, SPixel<TSrcPixel, TData>>;
+				}
+			};
+
+			template<typename TData>
+			struct SSelectLayoutSrc
+			{
+				EPixelType eTrgPixelType;
+				TRowFunc pFunc;
+
+				template<typename TSrcPixel>
+				void Apply()
+				{
+					SSelectLayoutTrg<TSrcPixel, TData> xOp;
+					_DispatchPixelType(eTrgPixelType, xOp);
+					pFunc = xOp.pFunc;
+				}
+			};
+
+			struct SSelectLayout
+			{
+				EPixelType eTrgPixelType;
+				EPixelType eSrcPixelType;
+				TRowFunc pFunc;
+
+				template<typename TData>
+				void Apply()
+				{
+					SSelectLayoutSrc<TData> xOp;
+					xOp.eTrgPixelType = eTrgPixelType;
+					_DispatchPixelType(eSrcPixelType, xOp);
+					pFunc = xOp.pFunc;
+				}
+			};
+
+			TRowFunc _SelectMapValues(EDataType eTrgDataType, EDataType eSrcDataType)
+			{
+				SSelectMapValues xOp;
+				xOp.eTrgDataType = eTrgDataType;
+				_DispatchDataType(eSrcDataType, xOp);
+				return xOp.pFunc;
+			}
+
+			TRowFunc _SelectLayout(EPixelType eTrgPixelType, EPixelType eSrcPixelType, EDataType eDataType)
+			{
+				SSelectLayout xOp;
+				xOp.eTrgPixelType = eTrgPixelType;
+				xOp.eSrcPixelType = eSrcPixelType;
+				_DispatchDataType(eDataType, xOp);
+				return xOp.pFunc;
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Conversion plan
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			struct SConvertStep
+			{
+				TRowFunc pFunc;
+				// Number of elements pFunc processes per pixel.
+				size_t nCountPerPixel;
+			};
+
+			/// <summary>	One or two steps that convert a row. Two steps pass through a row buffer of nTempBytesPerPixel. </summary>
+			struct SConvertPlan
+			{
+				SConvertStep pStep[2];
+				size_t nStepCount;
+				size_t nTempBytesPerPixel;
+			};
+
+			/// <summary>	Returns a SIMD kernel for the conversion, or null if there is none. </summary>
+			bool _SelectKernel(SConvertStep& xStep, const _SImageType& xTrg, const _SImageType& xSrc)
+			{
+				const size_t nChannelCount = SImageType::DimOf(xSrc.ePixelType);
+				const bool bAvx2 = Clu::Intrinsics::HasAvx2();
+
+				if (xTrg.ePixelType == xSrc.ePixelType)
+				{
+					xStep.nCountPerPixel = nChannelCount;
+
+					if (xTrg.eDataType == EDataType::Single && xSrc.eDataType == EDataType::UInt8)
+						xStep.pFunc = bAvx2 ? &Avx2::ConvertUInt8ToSingle : &_KernelUInt8ToSingle;
+					else if (xTrg.eDataType == EDataType::Single && xSrc.eDataType == EDataType::UInt16)
+						xStep.pFunc = bAvx2 ? &Avx2::ConvertUInt16ToSingle : &_KernelUInt16ToSingle;
+					else if (xTrg.eDataType == EDataType::UInt8 && xSrc.eDataType == EDataType::Single)
+						xStep.pFunc = &_KernelSingleToUInt8;
+					else
+						return false;
+
+					return true;
+				}
+
+				if (xTrg.eDataType != EDataType::UInt8 || xSrc.eDataType != EDataType::UInt8)
+				{
+					return false;
+				}
+
+				const EPixelType eTrg = xTrg.ePixelType;
+				const EPixelType eSrc = xSrc.ePixelType;
+				xStep.nCountPerPixel = 1;
+
+				if ((eTrg == EPixelType::RGBA && eSrc == EPixelType::BGRA) || (eTrg == EPixelType::BGRA && eSrc == EPixelType::RGBA))
+					xStep.pFunc = bAvx2 ? &Avx2::SwapRedBlue4xUInt8 : &_KernelSwapRedBlue4xUInt8;
+				else if ((eTrg == EPixelType::RGB && eSrc == EPixelType::BGR) || (eTrg == EPixelType::BGR && eSrc == EPixelType::RGB))
+					xStep.pFunc = bAvx2 ? &Avx2::SwapRedBlue3xUInt8 : &_KernelSwapRedBlue3xUInt8;
+				else if (eTrg == EPixelType::Lum && eSrc == EPixelType::RGBA)
+					xStep.pFunc = &_KernelLumUInt8<4, 0>;
+				else if (eTrg == EPixelType::Lum && eSrc == EPixelType::BGRA)
+					xStep.pFunc = &_KernelLumUInt8<4, 2>;
+				else if (eTrg == EPixelType::Lum && eSrc == EPixelType::RGB)
+					xStep.pFunc = &_KernelLumUInt8<3, 0>;
+				else if (eTrg == EPixelType::Lum && eSrc == EPixelType::BGR)
+					xStep.pFunc = &_KernelLumUInt8<3, 2>;
+				else
+					return false;
+
+				return true;
+			}
+
+			SConvertPlan _CreatePlan(const _SImageType& xTrgType, const _SImageType& xSrcType)
+			{
+				SConvertPlan xPlan;
+				xPlan.nStepCount = 1;
+				xPlan.nTempBytesPerPixel = 0;
+
+				_SImageType xTrg = xTrgType;
+				_SImageType xSrc = xSrcType;
+
+				// Bayer images are converted like luminance images of the same data type.
+				if (SImageType::IsBayerPixelType(xSrc.ePixelType))
+				{
+					xTrg.ePixelType = EPixelType::Lum;
+					xSrc.ePixelType = EPixelType::Lum;
+				}
+
+				if (xTrg == xSrc)
+				{
+					xPlan.pStep[0].pFunc = &_CopyValues;
+					xPlan.pStep[0].nCountPerPixel = xSrc.BytesPerPixel();
+					return xPlan;
+				}
+
+				if (_SelectKernel(xPlan.pStep[0], xTrg, xSrc))
+				{
+					return xPlan;
+				}
+
+				const size_t nTrgChannelCount = SImageType::DimOf(xTrg.ePixelType);
+				const size_t nSrcChannelCount = SImageType::DimOf(xSrc.ePixelType);
+
+				if (xTrg.eDataType == xSrc.eDataType)
+				{
+					xPlan.pStep[0].pFunc = _SelectLayout(xTrg.ePixelType, xSrc.ePixelType, xSrc.eDataType);
+					xPlan.pStep[0].nCountPerPixel = 1;
+				}
+				else if (xTrg.ePixelType == xSrc.ePixelType)
+				{
+					xPlan.pStep[0].pFunc = _SelectMapValues(xTrg.eDataType, xSrc.eDataType);
+					xPlan.pStep[0].nCountPerPixel = nSrcChannelCount;
+				}
+				else if (nTrgChannelCount < nSrcChannelCount)
+				{
+					// Reduce the channels first, so that luminance is evaluated with the precision of the source.
+					xPlan.nStepCount = 2;
+					xPlan.nTempBytesPerPixel = nTrgChannelCount * SImageType::SizeOf(xSrc.eDataType);
+
+					xPlan.pStep[0].pFunc = _SelectLayout(xTrg.ePixelType, xSrc.ePixelType, xSrc.eDataType);
+					xPlan.pStep[0].nCountPerPixel = 1;
+					xPlan.pStep[1].pFunc = _SelectMapValues(xTrg.eDataType, xSrc.eDataType);
+					xPlan.pStep[1].nCountPerPixel = nTrgChannelCount;
+				}
+				else
+				{
+					xPlan.nStepCount = 2;
+					xPlan.nTempBytesPerPixel = nSrcChannelCount * SImageType::SizeOf(xTrg.eDataType);
+
+					xPlan.pStep[0].pFunc = _SelectMapValues(xTrg.eDataType, xSrc.eDataType);
+					xPlan.pStep[0].nCountPerPixel = nSrcChannelCount;
+					xPlan.pStep[1].pFunc = _SelectLayout(xTrg.ePixelType, xSrc.ePixelType, xTrg.eDataType);
+					xPlan.pStep[1].nCountPerPixel = 1;
+				}
+
+				return xPlan;
+			}
+
+		} // namespace
+
+
+		bool IsConvertible(const _SImageType& xTrgType, const _SImageType& xSrcType)
+		{
+			if (!xTrgType.IsValid() || !xSrcType.IsValid())
+			{
+				return false;
+			}
+
+			const bool bTrgBayer = SImageType::IsBayerPixelType(xTrgType.ePixelType);
+			const bool bSrcBayer = SImageType::IsBayerPixelType(xSrcType.ePixelType);
+
+			if (bTrgBayer || bSrcBayer)
+			{
+				return xTrgType.ePixelType == xSrcType.ePixelType;
+			}
+
+			return true;
+		}
+
+		void ConvertImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat)
+		{
+			if (pTrgData == nullptr || pSrcData == nullptr)
+			{
+				throw CLU_EXCEPTION("Invalid image data");
+			}
+
+			if (xTrgFormat.iWidth != xSrcFormat.iWidth || xTrgFormat.iHeight != xSrcFormat.iHeight)
+			{
+				throw CLU_EXCEPTION("Source and target image have to be of the same size");
+			}
+
+			if (!IsConvertible(xTrgFormat, xSrcFormat))
+			{
+				throw CLU_EXCEPTION("Image type cannot be converted to the target type");
+			}
+
+			const SConvertPlan xPlan = _CreatePlan(xTrgFormat, xSrcFormat);
+			const size_t nWidth = size_t(xTrgFormat.iWidth);
+			const size_t nTrgPitch = xTrgFormat.RowPitch();
+			const size_t nSrcPitch = xSrcFormat.RowPitch();
+
+			const size_t nRowBytes = std::max(xTrgFormat.RowByteCount(), xSrcFormat.RowByteCount());
+			const size_t nMinRows = std::max<size_t>(ConvertMinBlockBytes / std::max<size_t>(nRowBytes, 1), 1);
+
+			Clu::Parallel::ForEachBlock(size_t(xTrgFormat.iHeight), nMinRows, [&](size_t nBegin, size_t nEnd, unsigned)
+			{
+				std::vector<unsigned char> vecTemp(nWidth * xPlan.nTempBytesPerPixel);
+
+				for (size_t nRow = nBegin; nRow < nEnd; ++nRow)
+				{
+					void* pTrg = (unsigned char*)pTrgData + nRow * nTrgPitch;
+					const void* pSrc = (const unsigned char*)pSrcData + nRow * nSrcPitch;
+
+					if (xPlan.nStepCount == 1)
+					{
+						xPlan.pStep[0].pFunc(pTrg, pSrc, nWidth * xPlan.pStep[0].nCountPerPixel);
+					}
+					else
+					{
+						xPlan.pStep[0].pFunc(vecTemp.data(), pSrc, nWidth * xPlan.pStep[0].nCountPerPixel);
+						xPlan.pStep[1].pFunc(pTrg, vecTemp.data(), nWidth * xPlan.pStep[1].nCountPerPixel);
+					}
+				}
+			});
+		}
+
+		void ConvertImage(CIImage& imgTrg, const CIImage& imgSrc)
+		{
+			try
+			{
+				if (!imgTrg.IsValid())
+				{
+					throw CLU_EXCEPTION("Target image has to be valid to define the target type");
+				}
+
+				const SImageFormat& xTrgFormat = imgTrg.Format();
+				ConvertImage(imgTrg, imgSrc, xTrgFormat.ePixelType, xTrgFormat.eDataType);
+			}
+			CLU_CATCH_RETHROW_ALL("Error converting image")
+		}
+
+		void ConvertImage(CIImage& imgTrg, const CIImage& imgSrc, EPixelType ePixelType, EDataType eDataType)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				// The target may refer to the memory of the source. Then convert from a copy, which shares the memory
+				// with the source until the target is written to.
+				CIImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CIImage&)imgTrg).DataPointer() == imgSrc.DataPointer())
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				imgTrg.Create(SImageFormat(imgSource.Width(), imgSource.Height(), ePixelType, eDataType));
+
+				ConvertImageData(imgTrg.DataPointer(), imgTrg.Format(), ((const CIImage&)imgSource).DataPointer(), imgSource.Format());
+			}
+			CLU_CATCH_RETHROW_ALL("Error converting image")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
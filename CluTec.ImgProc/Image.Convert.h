@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Convert.h
+//
+// summary:   Declares the image conversion functions
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Tests whether images of the source type can be converted to the target type. All combinations of
+		/// 	the RGB, RGBA, BGR, BGRA, Lum and LumA pixel types with all data types are supported. Bayer images
+		/// 	can only change their data type; use demosaicing to obtain color images from them.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		bool IsConvertible(const _SImageType& xTrgType, const _SImageType& xSrcType);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Converts the pixels of an image memory block to another pixel and data type. Values are mapped
+		/// 	between data types as by MapPixelValue(), color is reduced to luminance with the weights 0.299,
+		/// 	0.587 and 0.114, luminance is replicated to all colors and a missing alpha channel is set to fully
+		/// 	opaque. The rows are converted in parallel, and common conversions use SIMD kernels.
+		/// </summary>
+		///
+		/// <param name="pTrgData">  	The target memory. </param>
+		/// <param name="xTrgFormat">	The target format. </param>
+		/// <param name="pSrcData">  	The source memory. </param>
+		/// <param name="xSrcFormat">	The source format. Has to have the same size as the target format. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void ConvertImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Converts the source image to the type of the target image. The target image is recreated with the
+		/// 	size of the source image if necessary.
+		/// </summary>
+		///
+		/// <param name="imgTrg">	[in,out] The target image. Has to be valid, as its type defines the conversion. </param>
+		/// <param name="imgSrc">	The source image. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void ConvertImage(CIImage& imgTrg, const CIImage& imgSrc);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Creates the target image with the given type and the size of the source image and converts the source image into it. </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void ConvertImage(CIImage& imgTrg, const CIImage& imgSrc, EPixelType ePixelType, EDataType eDataType);
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Demosaic.Avx2.cpp
+//
+// summary:   Implements the AVX2 lanes of the demosaicing
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+
+#include <immintrin.h>
+
+#include "Image.Avx2.h"
+#include "Image.Demosaic.Simd.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Avx2
+		{
+			namespace
+			{
+				struct SLaneInt16
+				{
+					using TValue = int16_t;
+					using TReg = __m256i;
+					static const size_t Width = 16;
+
+					static TReg Load(const TValue* pValue) { return _mm256_loadu_si256((const __m256i*)pValue); }
+					static void Store(TValue* pValue, TReg mV) { _mm256_storeu_si256((__m256i*)pValue, mV); }
+					static TReg Set1(int iValue) { return _mm256_set1_epi16(short(iValue)); }
+					static TReg Add(TReg mA, TReg mB) { return _mm256_add_epi16(mA, mB); }
+					static TReg Sub(TReg mA, TReg mB) { return _mm256_sub_epi16(mA, mB); }
+					template<int t_iShift> static TReg Shl(TReg mA) { return _mm256_slli_epi16(mA, t_iShift); }
+					template<int t_iShift> static TReg Sra(TReg mA) { return _mm256_srai_epi16(mA, t_iShift); }
+					static TReg Clamp(TReg mA, TReg mMax) { return _mm256_min_epi16(_mm256_max_epi16(mA, _mm256_setzero_si256()), mMax); }
+					static TReg Blend(TReg mMask, TReg mA, TReg mB) { return _mm256_blendv_epi8(mB, mA, mMask); }
+
+					/// <summary>	Mask of the lanes of a vector starting at an even x, whose x has parity iPhase. </summary>
+					static TReg PhaseMask(int iPhase) { return _mm256_set1_epi32(iPhase == 0 ? 0x0000FFFF : int(0xFFFF0000)); }
+				};
+
+				struct SLaneInt32
+				{
+					using TValue = int32_t;
+					using TReg = __m256i;
+					static const size_t Width = 8;
+
+					static TReg Load(const TValue* pValue) { return _mm256_loadu_si256((const __m256i*)pValue); }
+					static void Store(TValue* pValue, TReg mV) { _mm256_storeu_si256((__m256i*)pValue, mV); }
+					static TReg Set1(int iValue) { return _mm256_set1_epi32(iValue); }
+					static TReg Add(TReg mA, TReg mB) { return _mm256_add_epi32(mA, mB); }
+					static TReg Sub(TReg mA, TReg mB) { return _mm256_sub_epi32(mA, mB); }
+					template<int t_iShift> static TReg Shl(TReg mA) { return _mm256_slli_epi32(mA, t_iShift); }
+					template<int t_iShift> static TReg Sra(TReg mA) { return _mm256_srai_epi32(mA, t_iShift); }
+					static TReg Clamp(TReg mA, TReg mMax) { return _mm256_min_epi32(_mm256_max_epi32(mA, _mm256_setzero_si256()), mMax); }
+					static TReg Blend(TReg mMask, TReg mA, TReg mB) { return _mm256_blendv_epi8(mB, mA, mMask); }
+					static TReg PhaseMask(int iPhase) { return _mm256_set1_epi64x(iPhase == 0 ? int64_t(0x00000000FFFFFFFFll) : int64_t(0xFFFFFFFF00000000ull)); }
+				};
+
+				template<typename TLane>
+				void _InterpolateRow(typename TLane::TValue* pRowColor, typename TLane::TValue* pGreen, typename TLane::TValue* pOtherColor
+					, const typename TLane::TValue* const* ppRow, size_t nWidth, int iColorPhase, int iMaxValue, bool bEdgeAware)
+				{
+					if (bEdgeAware)
+					{
+						Simd::InterpolateBayerRow<TLane, true>(pRowColor, pGreen, pOtherColor, ppRow, nWidth, iColorPhase, iMaxValue);
+					}
+					else
+					{
+						Simd::InterpolateBayerRow<TLane, false>(pRowColor, pGreen, pOtherColor, ppRow, nWidth, iColorPhase, iMaxValue);
+					}
+				}
+			} // namespace
+
+			void InterpolateBayerRow(int16_t* pRowColor, int16_t* pGreen, int16_t* pOtherColor, const int16_t* const* ppRow
+				, size_t nWidth, int iColorPhase, int iMaxValue, bool bEdgeAware)
+			{
+				_InterpolateRow<SLaneInt16>(pRowColor, pGreen, pOtherColor, ppRow, nWidth, iColorPhase, iMaxValue, bEdgeAware);
+			}
+
+			void InterpolateBayerRow(int32_t* pRowColor, int32_t* pGreen, int32_t* pOtherColor, const int32_t* const* ppRow
+				, size_t nWidth, int iColorPhase, int iMaxValue, bool bEdgeAware)
+			{
+				_InterpolateRow<SLaneInt32>(pRowColor, pGreen, pOtherColor, ppRow, nWidth, iColorPhase, iMaxValue, bEdgeAware);
+			}
+		} // namespace Avx2
+	} // namespace ImgProc
+} // namespace Clu
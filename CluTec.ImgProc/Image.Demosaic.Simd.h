@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Demosaic.Simd.h
+//
+// summary:   Declares the Bayer interpolation shared by the SSE2 and the AVX2 demosaicing
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stddef.h>
+
+// Image.Demosaic.cpp and Image.Demosaic.Avx2.cpp instantiate the interpolation with their own lane types, so the
+// instances compiled for different instruction sets are different functions.
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Simd
+		{
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Interpolates the three color planes of one row. Every vector of lanes is interpolated as if all
+			/// 	pixels had the phase of the red or blue sample, and as if all had the phase of a green sample. The
+			/// 	phase mask selects the appropriate result per lane.
+			/// </summary>
+			///
+			/// <param name="pRowColor">  	[out] The plane of the color sampled in this row, red or blue. </param>
+			/// <param name="pGreen">	  	[out] The green plane. </param>
+			/// <param name="pOtherColor">	[out] The plane of the color not sampled in this row. </param>
+			/// <param name="ppRow">	  	The buffered rows y-2 to y+2. </param>
+			/// <param name="nWidth">	  	The row width. </param>
+			/// <param name="iColorPhase">	The parity of the x coordinates of the red or blue samples in this row. </param>
+			/// <param name="iMaxValue">  	The maximal sample value. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TLane, bool t_bEdgeAware>
+			void InterpolateBayerRow(typename TLane::TValue* pRowColor, typename TLane::TValue* pGreen, typename TLane::TValue* pOtherColor
+				, const typename TLane::TValue* const* ppRow, size_t nWidth, int iColorPhase, int iMaxValue)
+			{
+				using TL = TLane;
+				using TReg = typename TLane::TReg;
+
+				const TReg mMask = TL::PhaseMask(iColorPhase);
+				const TReg mMax = TL::Set1(iMaxValue);
+				const TReg mOne = TL::Set1(1);
+				const TReg mTwo = TL::Set1(2);
+				const TReg mFour = TL::Set1(4);
+				const TReg mEight = TL::Set1(8);
+
+				const auto* pN2 = ppRow[0];
+				const auto* pN = ppRow[1];
+				const auto* pC = ppRow[2];
+				const auto* pS = ppRow[3];
+				const auto* pS2 = ppRow[4];
+
+				for (size_t nX = 0; nX < nWidth; nX += TL::Width)
+				{
+					const TReg mC = TL::Load(pC + nX);
+					const TReg mHorz = TL::Add(TL::Load(pC + nX - 1), TL::Load(pC + nX + 1));
+					const TReg mVert = TL::Add(TL::Load(pN + nX), TL::Load(pS + nX));
+					const TReg mDiag = TL::Add(TL::Add(TL::Load(pN + nX - 1), TL::Load(pN + nX + 1))
+						, TL::Add(TL::Load(pS + nX - 1), TL::Load(pS + nX + 1)));
+
+					// Green, and the other color at a red or blue sample, and the row and column color at a green sample.
+					TReg mGreen, mDiagColor, mRowColor, mColColor;
+
+					if (t_bEdgeAware)
+					{
+						// Malvar, He and Cutler: the bilinear estimate plus a scaled Laplacian of the sampled color.
+						const TReg mFarH = TL::Add(TL::Load(pC + nX - 2), TL::Load(pC + nX + 2));
+						const TReg mFarV = TL::Add(TL::Load(pN2 + nX), TL::Load(pS2 + nX));
+						const TReg mFar = TL::Add(mFarH, mFarV);
+						const TReg mC10 = TL::Add(TL::template Shl<3>(mC), TL::template Shl<1>(mC));
+						const TReg mDiag2 = TL::template Shl<1>(mDiag);
+
+						// (4 C + 2 Cross - Far) / 8
+						mGreen = TL::Add(TL::template Shl<2>(mC), TL::template Shl<1>(TL::Add(mHorz, mVert)));
+						mGreen = TL::template Sra<3>(TL::Add(TL::Sub(mGreen, mFar), mFour));
+
+						// (12 C + 4 Diag - 3 Far) / 16
+						mDiagColor = TL::Add(TL::Add(TL::template Shl<3>(mC), TL::template Shl<2>(mC)), TL::template Shl<2>(mDiag));
+						mDiagColor = TL::Sub(mDiagColor, TL::Add(TL::template Shl<1>(mFar), mFar));
+						mDiagColor = TL::template Sra<4>(TL::Add(mDiagColor, mEight));
+
+						// (10 C + 8 Horz - 2 Diag - 2 FarH + FarV) / 16 and transposed.
+						mRowColor = TL::Sub(TL::Add(mC10, TL::template Shl<3>(mHorz)), TL::Add(mDiag2, TL::template Shl<1>(mFarH)));
+						mRowColor = TL::template Sra<4>(TL::Add(TL::Add(mRowColor, mFarV), mEight));
+
+						mColColor = TL::Sub(TL::Add(mC10, TL::template Shl<3>(mVert)), TL::Add(mDiag2, TL::template Shl<1>(mFarV)));
+						mColColor = TL::template Sra<4>(TL::Add(TL::Add(mColColor, mFarH), mEight));
+
+						mGreen = TL::Clamp(mGreen, mMax);
+						mDiagColor = TL::Clamp(mDiagColor, mMax);
+						mRowColor = TL::Clamp(mRowColor, mMax);
+						mColColor = TL::Clamp(mColColor, mMax);
+					}
+					else
+					{
+						mGreen = TL::template Sra<2>(TL::Add(TL::Add(mHorz, mVert), mTwo));
+						mDiagColor = TL::template Sra<2>(TL::Add(mDiag, mTwo));
+						mRowColor = TL::template Sra<1>(TL::Add(mHorz, mOne));
+						mColColor = TL::template Sra<1>(TL::Add(mVert, mOne));
+					}
+
+					TL::Store(pRowColor + nX, TL::Blend(mMask, mC, mRowColor));
+					TL::Store(pGreen + nX, TL::Blend(mMask, mGreen, mC));
+					TL::Store(pOtherColor + nX, TL::Blend(mMask, mDiagColor, mColColor));
+				}
+			}
+		} // namespace Simd
+	} // namespace ImgProc
+} // namespace Clu
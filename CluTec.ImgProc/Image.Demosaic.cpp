@@ -0,0 +1,525 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Demosaic.cpp
+//
+// summary:   Implements the Bayer demosaicing functions
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "Image.Demosaic.h"
+#include "Image.Demosaic.Simd.h"
+#include "Image.Avx2.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/IntrinsicFunctions.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	Minimal number of target bytes per thread. </summary>
+			const size_t DemosaicMinBlockBytes = size_t(1) << 16;
+
+			/// <summary>	Number of mirrored pixels at each side of a buffered source row. </summary>
+			const size_t RowPad = 2;
+
+			/// <summary>	Number of buffered source rows, the extent of the edge-aware filters. </summary>
+			const size_t RowWindow = 5;
+
+			/// <summary>	Position of the red sample within a 2x2 Bayer cell. Blue is diagonally opposite. </summary>
+			struct SBayerCell
+			{
+				int iRedX;
+				int iRedY;
+			};
+
+			/// <summary>	Channel layout of the target pixels. Green is always at index 1 and alpha at index 3. </summary>
+			struct SPixelLayout
+			{
+				size_t nChannelCount;
+				int iRed;
+				int iBlue;
+			};
+
+			SBayerCell _GetBayerCell(EPixelType ePixelType)
+			{
+				switch (ePixelType)
+				{
+				case EPixelType::BayerRG:
+					return SBayerCell{ 0, 0 };
+				case EPixelType::BayerBG:
+					return SBayerCell{ 1, 1 };
+				case EPixelType::BayerGR:
+					return SBayerCell{ 1, 0 };
+				case EPixelType::BayerGB:
+					return SBayerCell{ 0, 1 };
+				default:
+					throw CLU_EXCEPTION("Source image is not a Bayer image");
+				}
+			}
+
+			bool _TryGetPixelLayout(SPixelLayout& xLayout, EPixelType ePixelType)
+			{
+				switch (ePixelType)
+				{
+				case EPixelType::RGB:
+					xLayout = SPixelLayout{ 3, 0, 2 };
+					return true;
+				case EPixelType::BGR:
+					xLayout = SPixelLayout{ 3, 2, 0 };
+					return true;
+				case EPixelType::RGBA:
+					xLayout = SPixelLayout{ 4, 0, 2 };
+					return true;
+				case EPixelType::BGRA:
+					xLayout = SPixelLayout{ 4, 2, 0 };
+					return true;
+				default:
+					return false;
+				}
+			}
+
+			/// <summary>	Mirrors an index at the borders without repeating the border, which preserves the Bayer phase. </summary>
+			size_t _Mirror(ptrdiff_t iIdx, size_t nCount)
+			{
+				if (iIdx < 0)
+				{
+					return size_t(-iIdx);
+				}
+
+				if (iIdx >= ptrdiff_t(nCount))
+				{
+					return size_t(2 * ptrdiff_t(nCount) - 2 - iIdx);
+				}
+
+				return size_t(iIdx);
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// SIMD lanes
+			//
+			// The interpolation works on signed lanes wide enough for all intermediate sums: 16 bit for 8 bit
+			// samples and 32 bit for 16 bit samples. Each lane type provides the few operations the filters need with
+			// SSE2, which all x64 processors support. Image.Demosaic.Avx2.cpp has the AVX2 lanes.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			struct SLaneInt16
+			{
+				using TValue = int16_t;
+				using TReg = __m128i;
+				static const size_t Width = 8;
+
+				static TReg Load(const TValue* pValue) { return _mm_loadu_si128((const __m128i*)pValue); }
+				static void Store(TValue* pValue, TReg mV) { _mm_storeu_si128((__m128i*)pValue, mV); }
+				static TReg Set1(int iValue) { return _mm_set1_epi16(short(iValue)); }
+				static TReg Add(TReg mA, TReg mB) { return _mm_add_epi16(mA, mB); }
+				static TReg Sub(TReg mA, TReg mB) { return _mm_sub_epi16(mA, mB); }
+				template<int t_iShift> static TReg Shl(TReg mA) { return _mm_slli_epi16(mA, t_iShift); }
+				template<int t_iShift> static TReg Sra(TReg mA) { return _mm_srai_epi16(mA, t_iShift); }
+				static TReg Clamp(TReg mA, TReg mMax) { return _mm_min_epi16(_mm_max_epi16(mA, _mm_setzero_si128()), mMax); }
+				static TReg Blend(TReg mMask, TReg mA, TReg mB) { return _mm_or_si128(_mm_and_si128(mMask, mA), _mm_andnot_si128(mMask, mB)); }
+
+				/// <summary>	Mask of the lanes of a vector starting at an even x, whose x has parity iPhase. </summary>
+				static TReg PhaseMask(int iPhase) { return _mm_set1_epi32(iPhase == 0 ? 0x0000FFFF : int(0xFFFF0000)); }
+			};
+
+			struct SLaneInt32
+			{
+				using TValue = int32_t;
+				using TReg = __m128i;
+				static const size_t Width = 4;
+
+				static TReg Load(const TValue* pValue) { return _mm_loadu_si128((const __m128i*)pValue); }
+				static void Store(TValue* pValue, TReg mV) { _mm_storeu_si128((__m128i*)pValue, mV); }
+				static TReg Set1(int iValue) { return _mm_set1_epi32(iValue); }
+				static TReg Add(TReg mA, TReg mB) { return _mm_add_epi32(mA, mB); }
+				static TReg Sub(TReg mA, TReg mB) { return _mm_sub_epi32(mA, mB); }
+				template<int t_iShift> static TReg Shl(TReg mA) { return _mm_slli_epi32(mA, t_iShift); }
+				template<int t_iShift> static TReg Sra(TReg mA) { return _mm_srai_epi32(mA, t_iShift); }
+				static TReg Blend(TReg mMask, TReg mA, TReg mB) { return _mm_or_si128(_mm_and_si128(mMask, mA), _mm_andnot_si128(mMask, mB)); }
+
+				// SSE2 has no 32 bit min and max.
+				static TReg Clamp(TReg mA, TReg mMax)
+				{
+					mA = _mm_and_si128(mA, _mm_cmpgt_epi32(mA, _mm_setzero_si128()));
+					return Blend(_mm_cmpgt_epi32(mA, mMax), mMax, mA);
+				}
+
+				static TReg PhaseMask(int iPhase) { return iPhase == 0 ? _mm_set_epi32(0, -1, 0, -1) : _mm_set_epi32(-1, 0, -1, 0); }
+			};
+
+			template<typename TIn> struct SDemosaicLane;
+			template<> struct SDemosaicLane<uint8_t> { using Type = SLaneInt16; };
+			template<> struct SDemosaicLane<uint16_t> { using Type = SLaneInt32; };
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Full resolution interpolation. The rows are interpolated by Simd::InterpolateBayerRow().
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			/// <summary>	Widens a source row into a buffer row and mirrors RowPad pixels at both ends. </summary>
+			template<typename TValue, typename TIn>
+			void _LoadRow(TValue* pRow, const TIn* pSrc, size_t nWidth)
+			{
+				for (size_t nX = 0; nX < nWidth; ++nX)
+				{
+					pRow[nX] = TValue(pSrc[nX]);
+				}
+
+				for (size_t nX = 1; nX <= RowPad; ++nX)
+				{
+					pRow[-ptrdiff_t(nX)] = pRow[nX];
+					pRow[nWidth - 1 + nX] = pRow[nWidth - 1 - nX];
+				}
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Half resolution binning
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			/// <summary>	Splits 16 samples into the 8 samples at even and the 8 at odd positions, as 16 bit lanes. </summary>
+			void _LoadPairs(__m128i& mEven, __m128i& mOdd, const uint8_t* puSrc)
+			{
+				const __m128i mV = _mm_loadu_si128((const __m128i*)puSrc);
+				mEven = _mm_and_si128(mV, _mm_set1_epi16(0x00FF));
+				mOdd = _mm_srli_epi16(mV, 8);
+			}
+
+			void _LoadPairs(__m128i& mEven, __m128i& mOdd, const uint16_t* puSrc)
+			{
+				// Gathers the even samples in the lower and the odd samples in the upper half of each vector.
+				__m128i mA = _mm_loadu_si128((const __m128i*)puSrc);
+				__m128i mB = _mm_loadu_si128((const __m128i*)(puSrc + 8));
+
+				mA = _mm_shuffle_epi32(_mm_shufflehi_epi16(_mm_shufflelo_epi16(mA, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+				mB = _mm_shuffle_epi32(_mm_shufflehi_epi16(_mm_shufflelo_epi16(mB, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+
+				mEven = _mm_unpacklo_epi64(mA, mB);
+				mOdd = _mm_unpackhi_epi64(mA, mB);
+			}
+
+			/// <summary>	Bins a pair of source rows to the color planes of one target row. Green is the rounded mean of both green samples. </summary>
+			template<typename TIn>
+			void _BinRow(uint16_t* pRed, uint16_t* pGreen, uint16_t* pBlue, const TIn* pRow0, const TIn* pRow1, size_t nWidth, const SBayerCell& xCell)
+			{
+				const TIn* const ppRow[2] = { pRow0, pRow1 };
+				const int iRX = xCell.iRedX;
+				const int iRY = xCell.iRedY;
+				size_t nX = 0;
+
+				for (; nX + 8 <= nWidth; nX += 8)
+				{
+					__m128i pmCell[2][2];
+					_LoadPairs(pmCell[0][0], pmCell[0][1], pRow0 + 2 * nX);
+					_LoadPairs(pmCell[1][0], pmCell[1][1], pRow1 + 2 * nX);
+
+					_mm_storeu_si128((__m128i*)(pRed + nX), pmCell[iRY][iRX]);
+					_mm_storeu_si128((__m128i*)(pBlue + nX), pmCell[1 - iRY][1 - iRX]);
+					_mm_storeu_si128((__m128i*)(pGreen + nX), _mm_avg_epu16(pmCell[iRY][1 - iRX], pmCell[1 - iRY][iRX]));
+				}
+
+				for (; nX < nWidth; ++nX)
+				{
+					pRed[nX] = uint16_t(ppRow[iRY][2 * nX + iRX]);
+					pBlue[nX] = uint16_t(ppRow[1 - iRY][2 * nX + 1 - iRX]);
+					pGreen[nX] = uint16_t((unsigned(ppRow[iRY][2 * nX + 1 - iRX]) + unsigned(ppRow[1 - iRY][2 * nX + iRX]) + 1) >> 1);
+				}
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Pixel output
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename TOut, typename TValue>
+			size_t _WriteRowSimd(TOut* /*pTrg*/, const TValue* /*pRed*/, const TValue* /*pGreen*/, const TValue* /*pBlue*/
+				, size_t /*nWidth*/, const SPixelLayout& /*xLayout*/)
+			{
+				return 0;
+			}
+
+			/// <summary>	Interleaves 8 bit planes, that are stored as 16 bit values, to four channel pixels. Returns the number of pixels written. </summary>
+			template<typename TValue>
+			size_t _WriteRowSimd(uint8_t* pTrg, const TValue* pRed, const TValue* pGreen, const TValue* pBlue, size_t nWidth, const SPixelLayout& xLayout)
+			{
+				static_assert(sizeof(TValue) == 2, "Planes of 8 bit samples are expected to have 16 bit values");
+
+				if (xLayout.nChannelCount != 4)
+				{
+					return 0;
+				}
+
+				const TValue* pFirst = (xLayout.iRed == 0 ? pRed : pBlue);
+				const TValue* pThird = (xLayout.iRed == 0 ? pBlue : pRed);
+				const __m128i mAlpha = _mm_set1_epi8(-1);
+				size_t nX = 0;
+
+				for (; nX + 16 <= nWidth; nX += 16)
+				{
+					const __m128i mC0 = _mm_packus_epi16(_mm_loadu_si128((const __m128i*)(pFirst + nX)), _mm_loadu_si128((const __m128i*)(pFirst + nX + 8)));
+					const __m128i mC1 = _mm_packus_epi16(_mm_loadu_si128((const __m128i*)(pGreen + nX)), _mm_loadu_si128((const __m128i*)(pGreen + nX + 8)));
+					const __m128i mC2 = _mm_packus_epi16(_mm_loadu_si128((const __m128i*)(pThird + nX)), _mm_loadu_si128((const __m128i*)(pThird + nX + 8)));
+
+					const __m128i m01Lo = _mm_unpacklo_epi8(mC0, mC1);
+					const __m128i m01Hi = _mm_unpackhi_epi8(mC0, mC1);
+					const __m128i m23Lo = _mm_unpacklo_epi8(mC2, mAlpha);
+					const __m128i m23Hi = _mm_unpackhi_epi8(mC2, mAlpha);
+
+					__m128i* pmTrg = (__m128i*)(pTrg + 4 * nX);
+					_mm_storeu_si128(pmTrg, _mm_unpacklo_epi16(m01Lo, m23Lo));
+					_mm_storeu_si128(pmTrg + 1, _mm_unpackhi_epi16(m01Lo, m23Lo));
+					_mm_storeu_si128(pmTrg + 2, _mm_unpacklo_epi16(m01Hi, m23Hi));
+					_mm_storeu_si128(pmTrg + 3, _mm_unpackhi_epi16(m01Hi, m23Hi));
+				}
+
+				return nX;
+			}
+
+			/// <summary>	Interleaves the color planes of a row to the target pixels. The plane values are within the range of TOut. </summary>
+			template<typename TOut, typename TValue>
+			void _WriteRow(TOut* pTrg, const TValue* pRed, const TValue* pGreen, const TValue* pBlue, size_t nWidth, const SPixelLayout& xLayout)
+			{
+				const size_t nChannelCount = xLayout.nChannelCount;
+				const TOut xAlpha = std::numeric_limits<TOut>::max();
+
+				size_t nX = _WriteRowSimd(pTrg, pRed, pGreen, pBlue, nWidth, xLayout);
+				TOut* pPixel = pTrg + nX * nChannelCount;
+
+				for (; nX < nWidth; ++nX, pPixel += nChannelCount)
+				{
+					pPixel[xLayout.iRed] = TOut(pRed[nX]);
+					pPixel[1] = TOut(pGreen[nX]);
+					pPixel[xLayout.iBlue] = TOut(pBlue[nX]);
+
+					if (nChannelCount == 4)
+					{
+						pPixel[3] = xAlpha;
+					}
+				}
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Drivers
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			size_t _MinRowsPerBlock(const SImageFormat& xTrgFormat)
+			{
+				return std::max<size_t>(DemosaicMinBlockBytes / std::max<size_t>(xTrgFormat.RowByteCount(), 1), 1);
+			}
+
+			template<typename TIn, bool t_bEdgeAware>
+			void _DemosaicFull(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+				, const SBayerCell& xCell, const SPixelLayout& xLayout)
+			{
+				using TLane = typename SDemosaicLane<TIn>::Type;
+				using TValue = typename TLane::TValue;
+
+				const size_t nWidth = size_t(xSrcFormat.iWidth);
+				const size_t nHeight = size_t(xSrcFormat.iHeight);
+				const size_t nTrgPitch = xTrgFormat.RowPitch();
+				const size_t nSrcPitch = xSrcFormat.RowPitch();
+				const int iMaxValue = int(std::numeric_limits<TIn>::max());
+
+				// The vector loops run over whole vectors of up to 32 bytes, the AVX2 width. The buffered rows are zero
+				// beyond the mirrored border.
+				const bool bAvx2 = Clu::Intrinsics::HasAvx2();
+				const size_t nVectorLen = 32 / sizeof(TValue);
+				const size_t nPlaneLen = (nWidth + nVectorLen - 1) / nVectorLen * nVectorLen;
+				const size_t nRowLen = nPlaneLen + 2 * RowPad;
+
+				Clu::Parallel::ForEachBlock(nHeight, _MinRowsPerBlock(xTrgFormat), [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					std::vector<TValue> vecBuffer(RowWindow * nRowLen + 3 * nPlaneLen, TValue(0));
+
+					// The source rows are kept in a ring indexed by row modulo RowWindow, so each row is widened once per band.
+					TValue* ppRing[RowWindow];
+					size_t pnRingRow[RowWindow];
+					for (size_t nSlot = 0; nSlot < RowWindow; ++nSlot)
+					{
+						ppRing[nSlot] = vecBuffer.data() + nSlot * nRowLen + RowPad;
+						pnRingRow[nSlot] = size_t(-1);
+					}
+
+					TValue* pRed = vecBuffer.data() + RowWindow * nRowLen;
+					TValue* pGreen = pRed + nPlaneLen;
+					TValue* pBlue = pGreen + nPlaneLen;
+
+					for (size_t nRow = nBegin; nRow < nEnd; ++nRow)
+					{
+						const TValue* ppRow[RowWindow];
+						for (size_t nOff = 0; nOff < RowWindow; ++nOff)
+						{
+							const size_t nSrcRow = _Mirror(ptrdiff_t(nRow + nOff) - ptrdiff_t(RowWindow / 2), nHeight);
+							const size_t nSlot = nSrcRow % RowWindow;
+
+							if (pnRingRow[nSlot] != nSrcRow)
+							{
+								_LoadRow(ppRing[nSlot], (const TIn*)((const unsigned char*)pSrcData + nSrcRow * nSrcPitch), nWidth);
+								pnRingRow[nSlot] = nSrcRow;
+							}
+
+							ppRow[nOff] = ppRing[nSlot];
+						}
+
+						const bool bRedRow = (int(nRow & 1) == xCell.iRedY);
+						const int iColorPhase = (bRedRow ? xCell.iRedX : 1 - xCell.iRedX);
+						TValue* pRowColor = (bRedRow ? pRed : pBlue);
+						TValue* pOtherColor = (bRedRow ? pBlue : pRed);
+
+						if (bAvx2)
+						{
+							Avx2::InterpolateBayerRow(pRowColor, pGreen, pOtherColor, ppRow, nWidth, iColorPhase, iMaxValue, t_bEdgeAware);
+						}
+						else
+						{
+							Simd::InterpolateBayerRow<TLane, t_bEdgeAware>(pRowColor, pGreen, pOtherColor, ppRow, nWidth, iColorPhase, iMaxValue);
+						}
+
+						_WriteRow((TIn*)((unsigned char*)pTrgData + nRow * nTrgPitch), pRed, pGreen, pBlue, nWidth, xLayout);
+					}
+				});
+			}
+
+			template<typename TIn>
+			void _DemosaicHalf(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+				, const SBayerCell& xCell, const SPixelLayout& xLayout)
+			{
+				const size_t nWidth = size_t(xTrgFormat.iWidth);
+				const size_t nTrgPitch = xTrgFormat.RowPitch();
+				const size_t nSrcPitch = xSrcFormat.RowPitch();
+
+				Clu::Parallel::ForEachBlock(size_t(xTrgFormat.iHeight), _MinRowsPerBlock(xTrgFormat), [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					std::vector<uint16_t> vecPlane(3 * nWidth);
+					uint16_t* pRed = vecPlane.data();
+					uint16_t* pGreen = pRed + nWidth;
+					uint16_t* pBlue = pGreen + nWidth;
+
+					for (size_t nRow = nBegin; nRow < nEnd; ++nRow)
+					{
+						const unsigned char* pSrc = (const unsigned char*)pSrcData + 2 * nRow * nSrcPitch;
+
+						_BinRow(pRed, pGreen, pBlue, (const TIn*)pSrc, (const TIn*)(pSrc + nSrcPitch), nWidth, xCell);
+						_WriteRow((TIn*)((unsigned char*)pTrgData + nRow * nTrgPitch), pRed, pGreen, pBlue, nWidth, xLayout);
+					}
+				});
+			}
+
+			template<typename TIn>
+			void _Demosaic(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+				, EDemosaicMethod eMethod, const SBayerCell& xCell, const SPixelLayout& xLayout)
+			{
+				switch (eMethod)
+				{
+				case EDemosaicMethod::Bilinear:
+					_DemosaicFull<TIn, false>(pTrgData, xTrgFormat, pSrcData, xSrcFormat, xCell, xLayout);
+					break;
+				case EDemosaicMethod::EdgeAware:
+					_DemosaicFull<TIn, true>(pTrgData, xTrgFormat, pSrcData, xSrcFormat, xCell, xLayout);
+					break;
+				case EDemosaicMethod::HalfResolution:
+					_DemosaicHalf<TIn>(pTrgData, xTrgFormat, pSrcData, xSrcFormat, xCell, xLayout);
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported demosaicing method");
+				}
+			}
+		} // namespace
+
+		SImageFormat DemosaicFormat(const SImageFormat& xSrcFormat, EDemosaicMethod eMethod, EPixelType ePixelType)
+		{
+			if (!SImageType::IsBayerPixelType(xSrcFormat.ePixelType))
+			{
+				throw CLU_EXCEPTION("Source image is not a Bayer image");
+			}
+
+			if (xSrcFormat.eDataType != EDataType::UInt8 && xSrcFormat.eDataType != EDataType::UInt16)
+			{
+				throw CLU_EXCEPTION("Bayer images can only be demosaiced for data types UInt8 and UInt16");
+			}
+
+			SPixelLayout xLayout;
+			if (!_TryGetPixelLayout(xLayout, ePixelType))
+			{
+				throw CLU_EXCEPTION("Demosaicing target pixel type has to be one of RGB, BGR, RGBA or BGRA");
+			}
+
+			if (eMethod == EDemosaicMethod::HalfResolution)
+			{
+				return SImageFormat(xSrcFormat.iWidth / 2, xSrcFormat.iHeight / 2, ePixelType, xSrcFormat.eDataType);
+			}
+
+			return SImageFormat(xSrcFormat.iWidth, xSrcFormat.iHeight, ePixelType, xSrcFormat.eDataType);
+		}
+
+		void DemosaicData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, EDemosaicMethod eMethod)
+		{
+			if (pTrgData == nullptr || pSrcData == nullptr)
+			{
+				throw CLU_EXCEPTION("Invalid image data");
+			}
+
+			const SImageFormat xFormat = DemosaicFormat(xSrcFormat, eMethod, xTrgFormat.ePixelType);
+			if (xTrgFormat.iWidth != xFormat.iWidth || xTrgFormat.iHeight != xFormat.iHeight || xTrgFormat.eDataType != xFormat.eDataType)
+			{
+				throw CLU_EXCEPTION("Target image format does not match the demosaicing result");
+			}
+
+			const int iMinSize = (eMethod == EDemosaicMethod::HalfResolution ? 2 : 3);
+			if (xSrcFormat.iWidth < iMinSize || xSrcFormat.iHeight < iMinSize)
+			{
+				throw CLU_EXCEPTION("Bayer image is too small to be demosaiced");
+			}
+
+			const SBayerCell xCell = _GetBayerCell(xSrcFormat.ePixelType);
+			SPixelLayout xLayout;
+			_TryGetPixelLayout(xLayout, xTrgFormat.ePixelType);
+
+			if (xSrcFormat.eDataType == EDataType::UInt8)
+			{
+				_Demosaic<uint8_t>(pTrgData, xTrgFormat, pSrcData, xSrcFormat, eMethod, xCell, xLayout);
+			}
+			else
+			{
+				_Demosaic<uint16_t>(pTrgData, xTrgFormat, pSrcData, xSrcFormat, eMethod, xCell, xLayout);
+			}
+		}
+
+		void Demosaic(CIImage& imgTrg, const CIImage& imgSrc, EDemosaicMethod eMethod, EPixelType ePixelType)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				// The target may refer to the memory of the source, which recreating the target would release.
+				CIImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CIImage&)imgTrg).DataPointer() == imgSrc.DataPointer())
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				const SImageFormat xSrcFormat = imgSource.Format();
+				imgTrg.Create(DemosaicFormat(xSrcFormat, eMethod, ePixelType));
+
+				DemosaicData(imgTrg.DataPointer(), imgTrg.Format(), ((const CIImage&)imgSource).DataPointer(), xSrcFormat, eMethod);
+			}
+			CLU_CATCH_RETHROW_ALL("Error demosaicing image")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Demosaic.h
+//
+// summary:   Declares the Bayer demosaicing functions
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		/// <summary>	Interpolation methods of the demosaicing. </summary>
+		enum class EDemosaicMethod
+		{
+			/// <summary>	Averages the nearest samples of each color. </summary>
+			Bilinear = 0,
+
+			/// <summary>
+			/// 	Gradient corrected linear interpolation of Malvar, He and Cutler. Uses the samples of the other colors
+			/// 	to correct the bilinear estimate, which strongly reduces color fringes at edges.
+			/// </summary>
+			EdgeAware,
+
+			/// <summary>	Combines each 2x2 Bayer cell to one color pixel. The result has half the width and height of the source. </summary>
+			HalfResolution,
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Returns the format of the image that demosaicing an image of the given format results in.
+		/// </summary>
+		///
+		/// <param name="xSrcFormat">	The format of the Bayer image. </param>
+		/// <param name="eMethod">   	The demosaicing method. </param>
+		/// <param name="ePixelType">	The target pixel type. One of RGB, BGR, RGBA or BGRA. </param>
+		///
+		/// <returns>	The target format, which has the data type of the source. </returns>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		SImageFormat DemosaicFormat(const SImageFormat& xSrcFormat, EDemosaicMethod eMethod, EPixelType ePixelType);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Demosaics a Bayer image memory block of data type UInt8 or UInt16. The image borders are mirrored.
+		/// 	The rows are processed in parallel bands with SIMD inner loops. An alpha channel of the target is
+		/// 	set to fully opaque.
+		/// </summary>
+		///
+		/// <param name="pTrgData">  	The target memory. </param>
+		/// <param name="xTrgFormat">	The target format, as returned by DemosaicFormat(). </param>
+		/// <param name="pSrcData">  	The source memory. </param>
+		/// <param name="xSrcFormat">	The source format. Has to have at least 3 pixels in each direction. </param>
+		/// <param name="eMethod">   	The demosaicing method. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void DemosaicData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, EDemosaicMethod eMethod);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Demosaics a Bayer image. The target image is recreated with the format returned by DemosaicFormat() if
+		/// 	necessary.
+		/// </summary>
+		///
+		/// <param name="imgTrg">	 	[in,out] The target image. </param>
+		/// <param name="imgSrc">	 	The Bayer image of data type UInt8 or UInt16. </param>
+		/// <param name="eMethod">   	The demosaicing method. </param>
+		/// <param name="ePixelType">	The target pixel type. One of RGB, BGR, RGBA or BGRA. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void Demosaic(CIImage& imgTrg, const CIImage& imgSrc, EDemosaicMethod eMethod = EDemosaicMethod::EdgeAware
+			, EPixelType ePixelType = EPixelType::RGB);
+
+	} // namespace ImgProc
+} // namespace Clu
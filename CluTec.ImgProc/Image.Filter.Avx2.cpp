@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Filter.Avx2.cpp
+//
+// summary:   Implements the AVX2 lane of the convolution
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+
+#include <immintrin.h>
+
+#include "Image.Avx2.h"
+#include "Image.Filter.Simd.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Avx2
+		{
+			namespace
+			{
+				struct SLaneFloat
+				{
+					using TVec = __m256;
+					static const size_t Width = 8;
+
+					static TVec Zero() { return _mm256_setzero_ps(); }
+					static TVec Set1(float fValue) { return _mm256_set1_ps(fValue); }
+					static TVec Load(const float* pData) { return _mm256_loadu_ps(pData); }
+					static void Store(float* pData, TVec mV) { _mm256_storeu_ps(pData, mV); }
+
+					// No fused multiply-add, which would round differently from the scalar code.
+					static TVec MulAdd(TVec mAcc, TVec mA, TVec mB) { return _mm256_add_ps(mAcc, _mm256_mul_ps(mA, mB)); }
+				};
+			} // namespace
+
+			size_t ConvolveRow(float* pOut, const float* const* ppRow, size_t nRows, const float* pWeight, size_t nTaps, size_t nStride, size_t nCount)
+			{
+				return Simd::ConvolveRow<SLaneFloat>(pOut, ppRow, nRows, pWeight, nTaps, nStride, nCount);
+			}
+		} // namespace Avx2
+	} // namespace ImgProc
+} // namespace Clu
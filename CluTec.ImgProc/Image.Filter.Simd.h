@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Filter.Simd.h
+//
+// summary:   Declares the row convolution shared by the SSE2 and the AVX2 filters
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stddef.h>
+
+// Image.Filter.cpp and Image.Filter.Avx2.cpp instantiate the convolution with their own lane types, so the instances
+// compiled for different instruction sets are different functions.
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Simd
+		{
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Convolves the rows in whole vectors of TLane::Width floats, two vectors at a time while possible.
+			/// 	The products are added in the order of the scalar convolution.
+			/// </summary>
+			///
+			/// <returns>	The number of values written, the rest is left to the caller. </returns>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TLane>
+			size_t ConvolveRow(float* pOut, const float* const* ppRow, size_t nRows, const float* pWeight, size_t nTaps, size_t nStride, size_t nCount)
+			{
+				using TVec = typename TLane::TVec;
+				const size_t nWidth = TLane::Width;
+
+				size_t nIdx = 0;
+				for (; nIdx + 2 * nWidth <= nCount; nIdx += 2 * nWidth)
+				{
+					TVec mA = TLane::Zero();
+					TVec mB = TLane::Zero();
+					const float* pW = pWeight;
+
+					for (size_t nRow = 0; nRow < nRows; ++nRow)
+					{
+						const float* pIn = ppRow[nRow] + nIdx;
+						for (size_t nTap = 0; nTap < nTaps; ++nTap, ++pW, pIn += nStride)
+						{
+							const TVec mW = TLane::Set1(*pW);
+							mA = TLane::MulAdd(mA, mW, TLane::Load(pIn));
+							mB = TLane::MulAdd(mB, mW, TLane::Load(pIn + nWidth));
+						}
+					}
+
+					TLane::Store(pOut + nIdx, mA);
+					TLane::Store(pOut + nIdx + nWidth, mB);
+				}
+
+				for (; nIdx + nWidth <= nCount; nIdx += nWidth)
+				{
+					TVec mA = TLane::Zero();
+					const float* pW = pWeight;
+
+					for (size_t nRow = 0; nRow < nRows; ++nRow)
+					{
+						const float* pIn = ppRow[nRow] + nIdx;
+						for (size_t nTap = 0; nTap < nTaps; ++nTap, ++pW, pIn += nStride)
+						{
+							mA = TLane::MulAdd(mA, TLane::Set1(*pW), TLane::Load(pIn));
+						}
+					}
+
+					TLane::Store(pOut + nIdx, mA);
+				}
+
+				return nIdx;
+			}
+		} // namespace Simd
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,691 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Filter.cpp
+//
+// summary:   Implements the linear image filters
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "Image.Filter.h"
+#include "Image.Simd.h"
+#include "Image.Filter.Simd.h"
+#include "Image.Avx2.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/IntrinsicFunctions.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	Bytes of the row buffers of one tile, which should stay in the L2 cache. </summary>
+			const size_t FilterTileBytes = size_t(1) << 18;
+
+			/// <summary>	Minimal number of pixels per tile row. </summary>
+			const size_t FilterMinTileWidth = 64;
+
+			/// <summary>	Minimal number of rows per tile, in multiples of the kernel height. </summary>
+			const size_t FilterMinTileKernels = 8;
+
+			const size_t FilterMinTileHeight = 64;
+
+
+			/// <summary>	One memory plane of an image: all channels of a CIImage or one layer of a CILayerImage. </summary>
+			struct SPlane
+			{
+				unsigned char* pucData;
+				size_t nRowPitch;
+				EDataType eDataType;
+			};
+
+			/// <summary>	Converts nCount values to the accumulation type. </summary>
+			template<typename TAcc>
+			using TLoadFunc = void(*)(TAcc* pTrg, const void* pSrc, size_t nCount);
+
+			/// <summary>	Rounds and saturates nCount accumulated values to the target type. </summary>
+			template<typename TAcc>
+			using TStoreFunc = void(*)(void* pTrg, const TAcc* pSrc, size_t nCount);
+
+			using Simd::SConvert;
+
+			template<typename T, typename TAcc>
+			void _LoadRow(TAcc* pTrg, const void* pSrc, size_t nCount)
+			{
+				SConvert<T, TAcc>::Load(pTrg, (const T*)pSrc, nCount);
+			}
+
+			template<typename T, typename TAcc>
+			void _StoreRow(void* pTrg, const TAcc* pSrc, size_t nCount)
+			{
+				SConvert<T, TAcc>::Store((T*)pTrg, pSrc, nCount);
+			}
+
+			template<typename TAcc>
+			void _SelectRowFuncs(TLoadFunc<TAcc>& pLoad, TStoreFunc<TAcc>& pStore, EDataType eSrcDataType, EDataType eTrgDataType)
+			{
+				switch (eSrcDataType)
+				{
+				case EDataType::Int8:
+					pLoad = _LoadRow<int8_t, TAcc>;
+					break;
+				case EDataType::UInt8:
+					pLoad = _LoadRow<uint8_t, TAcc>;
+					break;
+				case EDataType::Int16:
+					pLoad = _LoadRow<int16_t, TAcc>;
+					break;
+				case EDataType::UInt16:
+					pLoad = _LoadRow<uint16_t, TAcc>;
+					break;
+				case EDataType::Int32:
+					pLoad = _LoadRow<int32_t, TAcc>;
+					break;
+				case EDataType::UInt32:
+					pLoad = _LoadRow<uint32_t, TAcc>;
+					break;
+				case EDataType::Single:
+					pLoad = _LoadRow<float, TAcc>;
+					break;
+				case EDataType::Double:
+					pLoad = _LoadRow<double, TAcc>;
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported source data type");
+				}
+
+				switch (eTrgDataType)
+				{
+				case EDataType::Int8:
+					pStore = _StoreRow<int8_t, TAcc>;
+					break;
+				case EDataType::UInt8:
+					pStore = _StoreRow<uint8_t, TAcc>;
+					break;
+				case EDataType::Int16:
+					pStore = _StoreRow<int16_t, TAcc>;
+					break;
+				case EDataType::UInt16:
+					pStore = _StoreRow<uint16_t, TAcc>;
+					break;
+				case EDataType::Int32:
+					pStore = _StoreRow<int32_t, TAcc>;
+					break;
+				case EDataType::UInt32:
+					pStore = _StoreRow<uint32_t, TAcc>;
+					break;
+				case EDataType::Single:
+					pStore = _StoreRow<float, TAcc>;
+					break;
+				case EDataType::Double:
+					pStore = _StoreRow<double, TAcc>;
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported target data type");
+				}
+			}
+
+			/// <summary>	True if the values of the data type are exact in single precision sums. </summary>
+			bool _IsSinglePrecision(EDataType eDataType)
+			{
+				switch (eDataType)
+				{
+				case EDataType::Int8:
+				case EDataType::UInt8:
+				case EDataType::Int16:
+				case EDataType::UInt16:
+				case EDataType::Single:
+					return true;
+				default:
+					return false;
+				}
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Convolution of rows. All passes are of the form
+			//     pOut[i] = sum_r sum_k pWeight[r * nTaps + k] * ppRow[r][i + k * nStride],
+			// with the horizontal pass on one row, the vertical pass with one tap per row and general kernels with
+			// both. The SIMD and the scalar code add the products in the same order. The SIMD code uses AVX2 where
+			// the processor supports it and SSE2 otherwise.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			struct SLaneFloat
+			{
+				using TVec = __m128;
+				static const size_t Width = 4;
+
+				static TVec Zero() { return _mm_setzero_ps(); }
+				static TVec Set1(float fValue) { return _mm_set1_ps(fValue); }
+				static TVec Load(const float* pData) { return _mm_loadu_ps(pData); }
+				static void Store(float* pData, TVec mV) { _mm_storeu_ps(pData, mV); }
+				static TVec MulAdd(TVec mAcc, TVec mA, TVec mB) { return _mm_add_ps(mAcc, _mm_mul_ps(mA, mB)); }
+			};
+
+			template<typename TAcc>
+			struct SConvolveSimd
+			{
+				static size_t Run(TAcc*, const TAcc* const*, size_t, const TAcc*, size_t, size_t, size_t)
+				{
+					return 0;
+				}
+			};
+
+			template<>
+			struct SConvolveSimd<float>
+			{
+				static size_t Run(float* pOut, const float* const* ppRow, size_t nRows, const float* pWeight, size_t nTaps, size_t nStride, size_t nCount)
+				{
+					if (Clu::Intrinsics::HasAvx2())
+					{
+						return Avx2::ConvolveRow(pOut, ppRow, nRows, pWeight, nTaps, nStride, nCount);
+					}
+
+					return Simd::ConvolveRow<SLaneFloat>(pOut, ppRow, nRows, pWeight, nTaps, nStride, nCount);
+				}
+			};
+
+			template<typename TAcc>
+			void _Convolve(TAcc* pOut, const TAcc* const* ppRow, size_t nRows, const TAcc* pWeight, size_t nTaps, size_t nStride, size_t nCount)
+			{
+				for (size_t nIdx = SConvolveSimd<TAcc>::Run(pOut, ppRow, nRows, pWeight, nTaps, nStride, nCount); nIdx < nCount; ++nIdx)
+				{
+					TAcc tSum = TAcc(0);
+					const TAcc* pW = pWeight;
+
+					for (size_t nRow = 0; nRow < nRows; ++nRow)
+					{
+						const TAcc* pIn = ppRow[nRow] + nIdx;
+						for (size_t nTap = 0; nTap < nTaps; ++nTap, ++pW, pIn += nStride)
+						{
+							tSum = tSum + *pW * *pIn;
+						}
+					}
+
+					pOut[nIdx] = tSum;
+				}
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Tiled filter pass over one plane
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename TAcc>
+			class CFilterPass
+			{
+			public:
+				CFilterPass(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nChannels
+					, const SFilterKernel& xKernel, EBorderMode eBorderMode, double dBorderValue)
+					: m_xTrg(xTrg), m_xSrc(xSrc)
+				{
+					m_nWidth = nWidth;
+					m_nHeight = nHeight;
+					m_nChannels = nChannels;
+
+					m_nKernelWidth = size_t(xKernel.iWidth);
+					m_nKernelHeight = size_t(xKernel.iHeight);
+					m_bSeparable = xKernel.bSeparable;
+					m_vecX.assign(xKernel.vecX.begin(), xKernel.vecX.end());
+					m_vecY.assign(xKernel.vecY.begin(), xKernel.vecY.end());
+					m_vecXY.assign(xKernel.vecXY.begin(), xKernel.vecXY.end());
+
+					m_eBorderMode = eBorderMode;
+					m_tBorderValue = TAcc(dBorderValue);
+
+					m_nSrcPixelBytes = SImageType::SizeOf(xSrc.eDataType) * nChannels;
+					m_nTrgPixelBytes = SImageType::SizeOf(xTrg.eDataType) * nChannels;
+					_SelectRowFuncs<TAcc>(m_pLoad, m_pStore, xSrc.eDataType, xTrg.eDataType);
+				}
+
+				void Run() const
+				{
+					// The ring, the padded source row and the output row of a tile should fit into FilterTileBytes.
+					const size_t nRowsPerTile = m_nKernelHeight + 2;
+					const size_t nTileWidth = std::min(std::max(FilterTileBytes / (nRowsPerTile * m_nChannels * sizeof(TAcc)), FilterMinTileWidth), m_nWidth);
+					const size_t nTileHeight = std::min(std::max(FilterMinTileKernels * m_nKernelHeight, FilterMinTileHeight), m_nHeight);
+
+					const size_t nTileCols = (m_nWidth + nTileWidth - 1) / nTileWidth;
+					const size_t nTileRows = (m_nHeight + nTileHeight - 1) / nTileHeight;
+
+					Clu::Parallel::ForEachBlock(nTileCols * nTileRows, 1, [&](size_t nBegin, size_t nEnd, unsigned)
+					{
+						SBuffers xBuffers;
+						_Allocate(xBuffers, nTileWidth);
+
+						for (size_t nTile = nBegin; nTile < nEnd; ++nTile)
+						{
+							const size_t nX0 = (nTile % nTileCols) * nTileWidth;
+							const size_t nY0 = (nTile / nTileCols) * nTileHeight;
+
+							_Tile(xBuffers, nX0, std::min(nX0 + nTileWidth, m_nWidth), nY0, std::min(nY0 + nTileHeight, m_nHeight));
+						}
+					});
+				}
+
+			protected:
+				struct SBuffers
+				{
+					/// <summary>	The source row with the kernel radius on both sides. </summary>
+					std::vector<TAcc> vecPadded;
+
+					/// <summary>	The kernel height last rows, filtered horizontally for separable kernels. </summary>
+					std::vector<TAcc> vecRing;
+
+					std::vector<TAcc> vecOut;
+
+					std::vector<const TAcc*> vecRowPtr;
+				};
+
+				size_t _PaddedCount(size_t nTileWidth) const
+				{
+					return (nTileWidth + m_nKernelWidth - 1) * m_nChannels;
+				}
+
+				size_t _RingRowCount(size_t nTileWidth) const
+				{
+					return (m_bSeparable ? nTileWidth * m_nChannels : _PaddedCount(nTileWidth));
+				}
+
+				void _Allocate(SBuffers& xBuffers, size_t nTileWidth) const
+				{
+					xBuffers.vecPadded.resize(_PaddedCount(nTileWidth));
+					xBuffers.vecRing.resize(_RingRowCount(nTileWidth) * m_nKernelHeight);
+					xBuffers.vecOut.resize(nTileWidth * m_nChannels);
+					xBuffers.vecRowPtr.resize(m_nKernelHeight);
+				}
+
+				/// <summary>	Reads the source pixels [nX0 - radius, nX1 + radius) of a row, applying the border mode. </summary>
+				void _FetchRow(TAcc* pPadded, ptrdiff_t iRow, size_t nX0, size_t nX1) const
+				{
+					const ptrdiff_t iRadius = ptrdiff_t(m_nKernelWidth / 2);
+					const ptrdiff_t iBegin = ptrdiff_t(nX0) - iRadius;
+					const ptrdiff_t iEnd = ptrdiff_t(nX1) + iRadius;
+					const size_t nChannels = m_nChannels;
+
+					const ptrdiff_t iSrcRow = BorderIndex(iRow, ptrdiff_t(m_nHeight), m_eBorderMode);
+					if (iSrcRow < 0)
+					{
+						std::fill(pPadded, pPadded + size_t(iEnd - iBegin) * nChannels, m_tBorderValue);
+						return;
+					}
+
+					const unsigned char* pucRow = m_xSrc.pucData + size_t(iSrcRow) * m_xSrc.nRowPitch;
+					const ptrdiff_t iInner0 = std::max(iBegin, ptrdiff_t(0));
+					const ptrdiff_t iInner1 = std::min(iEnd, ptrdiff_t(m_nWidth));
+
+					m_pLoad(pPadded + size_t(iInner0 - iBegin) * nChannels, pucRow + size_t(iInner0) * m_nSrcPixelBytes, size_t(iInner1 - iInner0) * nChannels);
+
+					auto funcBorderPixel = [&](ptrdiff_t iX)
+					{
+						TAcc* pPixel = pPadded + size_t(iX - iBegin) * nChannels;
+						const ptrdiff_t iSrcX = BorderIndex(iX, ptrdiff_t(m_nWidth), m_eBorderMode);
+						if (iSrcX < 0)
+						{
+							std::fill(pPixel, pPixel + nChannels, m_tBorderValue);
+						}
+						else
+						{
+							m_pLoad(pPixel, pucRow + size_t(iSrcX) * m_nSrcPixelBytes, nChannels);
+						}
+					};
+
+					for (ptrdiff_t iX = iBegin; iX < iInner0; ++iX)
+					{
+						funcBorderPixel(iX);
+					}
+
+					for (ptrdiff_t iX = iInner1; iX < iEnd; ++iX)
+					{
+						funcBorderPixel(iX);
+					}
+				}
+
+				void _Tile(SBuffers& xBuffers, size_t nX0, size_t nX1, size_t nY0, size_t nY1) const
+				{
+					const size_t nOutCount = (nX1 - nX0) * m_nChannels;
+					const size_t nRingRow = _RingRowCount(nX1 - nX0);
+					const ptrdiff_t iRadius = ptrdiff_t(m_nKernelHeight / 2);
+
+					// The first source row of the tile goes to ring row zero.
+					const ptrdiff_t iFirstRow = ptrdiff_t(nY0) - iRadius;
+					auto funcRingRow = [&](ptrdiff_t iRow)
+					{
+						return xBuffers.vecRing.data() + (size_t(iRow - iFirstRow) % m_nKernelHeight) * nRingRow;
+					};
+
+					auto funcAddRow = [&](ptrdiff_t iRow)
+					{
+						TAcc* pRing = funcRingRow(iRow);
+						if (m_bSeparable)
+						{
+							const TAcc* pPadded = xBuffers.vecPadded.data();
+							_FetchRow(xBuffers.vecPadded.data(), iRow, nX0, nX1);
+							_Convolve(pRing, &pPadded, 1, m_vecX.data(), m_nKernelWidth, m_nChannels, nOutCount);
+						}
+						else
+						{
+							_FetchRow(pRing, iRow, nX0, nX1);
+						}
+					};
+
+					for (ptrdiff_t iRow = iFirstRow; iRow < ptrdiff_t(nY0) + iRadius; ++iRow)
+					{
+						funcAddRow(iRow);
+					}
+
+					for (size_t nY = nY0; nY < nY1; ++nY)
+					{
+						funcAddRow(ptrdiff_t(nY) + iRadius);
+
+						for (size_t nRow = 0; nRow < m_nKernelHeight; ++nRow)
+						{
+							xBuffers.vecRowPtr[nRow] = funcRingRow(ptrdiff_t(nY) - iRadius + ptrdiff_t(nRow));
+						}
+
+						if (m_bSeparable)
+						{
+							_Convolve(xBuffers.vecOut.data(), xBuffers.vecRowPtr.data(), m_nKernelHeight, m_vecY.data(), 1, 0, nOutCount);
+						}
+						else
+						{
+							_Convolve(xBuffers.vecOut.data(), xBuffers.vecRowPtr.data(), m_nKernelHeight, m_vecXY.data(), m_nKernelWidth, m_nChannels, nOutCount);
+						}
+
+						m_pStore(m_xTrg.pucData + nY * m_xTrg.nRowPitch + nX0 * m_nTrgPixelBytes, xBuffers.vecOut.data(), nOutCount);
+					}
+				}
+
+			protected:
+				SPlane m_xTrg;
+				SPlane m_xSrc;
+				size_t m_nWidth;
+				size_t m_nHeight;
+				size_t m_nChannels;
+
+				size_t m_nKernelWidth;
+				size_t m_nKernelHeight;
+				bool m_bSeparable;
+				std::vector<TAcc> m_vecX;
+				std::vector<TAcc> m_vecY;
+				std::vector<TAcc> m_vecXY;
+
+				EBorderMode m_eBorderMode;
+				TAcc m_tBorderValue;
+
+				size_t m_nSrcPixelBytes;
+				size_t m_nTrgPixelBytes;
+				TLoadFunc<TAcc> m_pLoad;
+				TStoreFunc<TAcc> m_pStore;
+			};
+
+			void _FilterPlane(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nChannels
+				, const SFilterKernel& xKernel, EBorderMode eBorderMode, double dBorderValue)
+			{
+				if (_IsSinglePrecision(xSrc.eDataType) && _IsSinglePrecision(xTrg.eDataType))
+				{
+					CFilterPass<float>(xTrg, xSrc, nWidth, nHeight, nChannels, xKernel, eBorderMode, dBorderValue).Run();
+				}
+				else
+				{
+					CFilterPass<double>(xTrg, xSrc, nWidth, nHeight, nChannels, xKernel, eBorderMode, dBorderValue).Run();
+				}
+			}
+
+			void _CheckKernel(const SFilterKernel& xKernel)
+			{
+				if (!xKernel.IsValid() || xKernel.iWidth % 2 == 0 || xKernel.iHeight % 2 == 0)
+				{
+					throw CLU_EXCEPTION("Filter kernels have to have an odd width and height");
+				}
+
+				if (xKernel.bSeparable
+					? (xKernel.vecX.size() != size_t(xKernel.iWidth) || xKernel.vecY.size() != size_t(xKernel.iHeight))
+					: (xKernel.vecXY.size() != size_t(xKernel.iWidth) * size_t(xKernel.iHeight)))
+				{
+					throw CLU_EXCEPTION("Filter kernel values do not match the kernel size");
+				}
+			}
+
+			SImageFormat _TargetFormat(const SImageFormat& xSrcFormat, EDataType eDataType)
+			{
+				return SImageFormat(xSrcFormat.iWidth, xSrcFormat.iHeight, xSrcFormat.ePixelType
+					, (eDataType == EDataType::Unknown ? xSrcFormat.eDataType : eDataType));
+			}
+		} // namespace
+
+		ptrdiff_t BorderIndex(ptrdiff_t iIdx, ptrdiff_t iSize, EBorderMode eBorderMode)
+		{
+			if (iIdx >= 0 && iIdx < iSize)
+			{
+				return iIdx;
+			}
+
+			switch (eBorderMode)
+			{
+			case EBorderMode::Constant:
+				return -1;
+
+			case EBorderMode::Replicate:
+				return std::min(std::max(iIdx, ptrdiff_t(0)), iSize - 1);
+
+			case EBorderMode::Reflect:
+			{
+				const ptrdiff_t iPeriod = 2 * iSize;
+				iIdx = ((iIdx % iPeriod) + iPeriod) % iPeriod;
+				return (iIdx < iSize ? iIdx : iPeriod - 1 - iIdx);
+			}
+
+			case EBorderMode::Mirror:
+			{
+				if (iSize == 1)
+				{
+					return 0;
+				}
+
+				const ptrdiff_t iPeriod = 2 * iSize - 2;
+				iIdx = ((iIdx % iPeriod) + iPeriod) % iPeriod;
+				return (iIdx < iSize ? iIdx : iPeriod - iIdx);
+			}
+
+			case EBorderMode::Wrap:
+				return ((iIdx % iSize) + iSize) % iSize;
+
+			default:
+				throw CLU_EXCEPTION("Unsupported border mode");
+			}
+		}
+
+		SFilterKernel SeparableKernel(const std::vector<float>& vecX, const std::vector<float>& vecY)
+		{
+			SFilterKernel xKernel;
+			xKernel.iWidth = int(vecX.size());
+			xKernel.iHeight = int(vecY.size());
+			xKernel.bSeparable = true;
+			xKernel.vecX = vecX;
+			xKernel.vecY = vecY;
+
+			_CheckKernel(xKernel);
+			return xKernel;
+		}
+
+		SFilterKernel GeneralKernel(int iWidth, int iHeight, const std::vector<float>& vecXY)
+		{
+			SFilterKernel xKernel;
+			xKernel.iWidth = iWidth;
+			xKernel.iHeight = iHeight;
+			xKernel.bSeparable = false;
+			xKernel.vecXY = vecXY;
+
+			_CheckKernel(xKernel);
+			return xKernel;
+		}
+
+		SFilterKernel GaussianKernel(double dSigma, int iRadius)
+		{
+			if (dSigma <= 0.0)
+			{
+				throw CLU_EXCEPTION("Invalid Gaussian sigma");
+			}
+
+			if (iRadius <= 0)
+			{
+				iRadius = std::max(int(ceil(3.0 * dSigma)), 1);
+			}
+
+			std::vector<double> vecWeight(size_t(2 * iRadius + 1));
+			double dSum = 0.0;
+			for (int iIdx = -iRadius; iIdx <= iRadius; ++iIdx)
+			{
+				const double dWeight = exp(-0.5 * double(iIdx * iIdx) / (dSigma * dSigma));
+				vecWeight[size_t(iIdx + iRadius)] = dWeight;
+				dSum += dWeight;
+			}
+
+			std::vector<float> vecKernel(vecWeight.size());
+			for (size_t nIdx = 0; nIdx < vecWeight.size(); ++nIdx)
+			{
+				vecKernel[nIdx] = float(vecWeight[nIdx] / dSum);
+			}
+
+			return SeparableKernel(vecKernel, vecKernel);
+		}
+
+		SFilterKernel BoxKernel(int iRadius)
+		{
+			if (iRadius < 0)
+			{
+				throw CLU_EXCEPTION("Invalid box filter radius");
+			}
+
+			const std::vector<float> vecKernel(size_t(2 * iRadius + 1), float(1.0 / double(2 * iRadius + 1)));
+			return SeparableKernel(vecKernel, vecKernel);
+		}
+
+		SFilterKernel SobelKernel(int iOrderX, int iOrderY)
+		{
+			const std::vector<float> vecDerivative = { -1.0f, 0.0f, 1.0f };
+			const std::vector<float> vecSmooth = { 1.0f, 2.0f, 1.0f };
+
+			if (iOrderX == 1 && iOrderY == 0)
+			{
+				return SeparableKernel(vecDerivative, vecSmooth);
+			}
+			else if (iOrderX == 0 && iOrderY == 1)
+			{
+				return SeparableKernel(vecSmooth, vecDerivative);
+			}
+
+			throw CLU_EXCEPTION("Sobel kernels are available for the first derivative along x or y");
+		}
+
+		void FilterImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, const SFilterKernel& xKernel, EBorderMode eBorderMode, double dBorderValue)
+		{
+			if (pTrgData == nullptr || pSrcData == nullptr)
+			{
+				throw CLU_EXCEPTION("Invalid image data");
+			}
+
+			if (xTrgFormat.iWidth != xSrcFormat.iWidth || xTrgFormat.iHeight != xSrcFormat.iHeight || xTrgFormat.ePixelType != xSrcFormat.ePixelType)
+			{
+				throw CLU_EXCEPTION("Target and source images differ in size or pixel type");
+			}
+
+			if (SImageType::IsBayerPixelType(xSrcFormat.ePixelType))
+			{
+				throw CLU_EXCEPTION("Bayer images cannot be filtered");
+			}
+
+			_CheckKernel(xKernel);
+
+			if (xSrcFormat.iWidth <= 0 || xSrcFormat.iHeight <= 0)
+			{
+				return;
+			}
+
+			const SPlane xTrg{ (unsigned char*)pTrgData, xTrgFormat.RowPitch(), xTrgFormat.eDataType };
+			const SPlane xSrc{ (unsigned char*)pSrcData, xSrcFormat.RowPitch(), xSrcFormat.eDataType };
+
+			_FilterPlane(xTrg, xSrc, size_t(xSrcFormat.iWidth), size_t(xSrcFormat.iHeight), SImageType::DimOf(xSrcFormat.ePixelType)
+				, xKernel, eBorderMode, dBorderValue);
+		}
+
+		void FilterImage(CIImage& imgTrg, const CIImage& imgSrc, const SFilterKernel& xKernel, EBorderMode eBorderMode
+			, EDataType eDataType, double dBorderValue)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				// The target may share the memory of the source.
+				CIImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CIImage&)imgTrg).DataPointer() == imgSrc.DataPointer())
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				imgTrg.Create(_TargetFormat(imgSource.Format(), eDataType));
+
+				FilterImageData(imgTrg.DataPointer(), imgTrg.Format(), ((const CIImage&)imgSource).DataPointer(), imgSource.Format(), xKernel, eBorderMode, dBorderValue);
+			}
+			CLU_CATCH_RETHROW_ALL("Error filtering image")
+		}
+
+		void FilterImage(CILayerImage& imgTrg, const CILayerImage& imgSrc, const SFilterKernel& xKernel, EBorderMode eBorderMode
+			, EDataType eDataType, double dBorderValue)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				if (SImageType::IsBayerPixelType(imgSrc.Format().ePixelType))
+				{
+					throw CLU_EXCEPTION("Bayer images cannot be filtered");
+				}
+
+				_CheckKernel(xKernel);
+
+				// The target may share the memory of the source.
+				CILayerImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CILayerImage&)imgTrg).DataPointer(0) == imgSrc.DataPointer(0))
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				const SImageFormat& xSrcFormat = imgSource.Format();
+				imgTrg.Create(_TargetFormat(xSrcFormat, eDataType));
+
+				const EDataType eTrgDataType = imgTrg.Format().eDataType;
+				for (size_t nLayer = 0; nLayer < imgSource.LayerCount(); ++nLayer)
+				{
+					const SPlane xTrg{ (unsigned char*)imgTrg.DataPointer(nLayer), imgTrg.LayerRowPitch(), eTrgDataType };
+					const SPlane xSrc{ (unsigned char*)((const CILayerImage&)imgSource).DataPointer(nLayer), imgSource.LayerRowPitch(), xSrcFormat.eDataType };
+
+					_FilterPlane(xTrg, xSrc, size_t(xSrcFormat.iWidth), size_t(xSrcFormat.iHeight), 1, xKernel, eBorderMode, dBorderValue);
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error filtering layer image")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Filter.h
+//
+// summary:   Declares the linear image filters
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		/// <summary>	Values the filters read outside of the image, shown for the image abcd. </summary>
+		enum class EBorderMode
+		{
+			/// <summary>	A constant value: vv|abcd|vv </summary>
+			Constant = 0,
+
+			/// <summary>	The border pixel: aa|abcd|dd </summary>
+			Replicate,
+
+			/// <summary>	Mirrored including the border pixel: ba|abcd|dc </summary>
+			Reflect,
+
+			/// <summary>	Mirrored at the border pixel: cb|abcd|cb </summary>
+			Mirror,
+
+			/// <summary>	Periodic continuation: cd|abcd|ab </summary>
+			Wrap,
+		};
+
+		/// <summary>	Maps an index outside of [0, iSize) to the index the border mode reads, or -1 for a constant. </summary>
+		ptrdiff_t BorderIndex(ptrdiff_t iIdx, ptrdiff_t iSize, EBorderMode eBorderMode);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	A convolution kernel with odd width and height, centered on the target pixel. A separable kernel is
+		/// 	stored as its column and row factors, a general kernel as its row major values.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		struct SFilterKernel
+		{
+			int iWidth;
+			int iHeight;
+			bool bSeparable;
+
+			/// <summary>	The horizontal factor of a separable kernel, with iWidth values. </summary>
+			std::vector<float> vecX;
+
+			/// <summary>	The vertical factor of a separable kernel, with iHeight values. </summary>
+			std::vector<float> vecY;
+
+			/// <summary>	The values of a general kernel, iWidth * iHeight values in rows. </summary>
+			std::vector<float> vecXY;
+
+			SFilterKernel()
+			{
+				iWidth = 0;
+				iHeight = 0;
+				bSeparable = false;
+			}
+
+			bool IsValid() const
+			{
+				return iWidth > 0 && iHeight > 0;
+			}
+		};
+
+		/// <summary>	Returns the separable kernel with the given horizontal and vertical factors. </summary>
+		SFilterKernel SeparableKernel(const std::vector<float>& vecX, const std::vector<float>& vecY);
+
+		/// <summary>	Returns a general kernel from iWidth * iHeight values in rows. </summary>
+		SFilterKernel GeneralKernel(int iWidth, int iHeight, const std::vector<float>& vecXY);
+
+		/// <summary>	Returns a normalized Gaussian kernel. A radius of zero uses three times sigma, rounded up. </summary>
+		SFilterKernel GaussianKernel(double dSigma, int iRadius = 0);
+
+		/// <summary>	Returns the kernel of the mean over (2 * iRadius + 1)^2 pixels. </summary>
+		SFilterKernel BoxKernel(int iRadius);
+
+		/// <summary>	Returns the 3x3 Sobel kernel of the first derivative along x (1, 0) or along y (0, 1). </summary>
+		SFilterKernel SobelKernel(int iOrderX, int iOrderY);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Convolves an image memory block with a kernel. The image is processed in tiles whose intermediate rows
+		/// 	fit into the cache, in parallel. Each tile keeps a ring of the source rows the kernel covers, after the
+		/// 	horizontal pass for separable kernels, so no intermediate image is created. Sums are formed in single
+		/// 	precision with SIMD kernels, or in double precision if source or target have 32 bit integer or double
+		/// 	values. Integer targets are rounded and saturated.
+		/// </summary>
+		///
+		/// <param name="pTrgData">	   	The target memory. It must not overlap the source memory. </param>
+		/// <param name="xTrgFormat">  	The target format. Size and pixel type have to be those of the source. </param>
+		/// <param name="pSrcData">	   	The source memory. </param>
+		/// <param name="xSrcFormat">  	The source format. Each channel is filtered separately. </param>
+		/// <param name="xKernel">	   	The kernel. </param>
+		/// <param name="eBorderMode"> 	The values read outside of the source. </param>
+		/// <param name="dBorderValue">	The value of EBorderMode::Constant. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void FilterImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, const SFilterKernel& xKernel, EBorderMode eBorderMode, double dBorderValue = 0.0);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Creates the target image and convolves the source image with the kernel. </summary>
+		///
+		/// <param name="imgTrg">	   	[in,out] The target image. </param>
+		/// <param name="imgSrc">	   	The source image. </param>
+		/// <param name="xKernel">	   	The kernel. </param>
+		/// <param name="eBorderMode"> 	The values read outside of the source. </param>
+		/// <param name="eDataType">   	The target data type. EDataType::Unknown keeps the source data type. </param>
+		/// <param name="dBorderValue">	The value of EBorderMode::Constant. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void FilterImage(CIImage& imgTrg, const CIImage& imgSrc, const SFilterKernel& xKernel, EBorderMode eBorderMode = EBorderMode::Mirror
+			, EDataType eDataType = EDataType::Unknown, double dBorderValue = 0.0);
+
+		/// <summary>	Creates the target layer image and convolves each layer of the source with the kernel. </summary>
+		void FilterImage(CILayerImage& imgTrg, const CILayerImage& imgSrc, const SFilterKernel& xKernel, EBorderMode eBorderMode = EBorderMode::Mirror
+			, EDataType eDataType = EDataType::Unknown, double dBorderValue = 0.0);
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,881 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Integral.cpp
+//
+// summary:   Implements integral images and constant time box statistics
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+
+#include <immintrin.h>
+
+#include "Image.Integral.h"
+
+#include "CluTec.Types1/ImageType.h"
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	The minimal number of pixels per parallel block. </summary>
+			const size_t MinBlockPixelCount = size_t(1) << 16;
+
+			/// <summary>	The minimal number of row elements per parallel column stripe. </summary>
+			const size_t MinStripeElementCount = 256;
+
+			/// <summary>	The accumulator of the sums of a source type. 8 bit sums wrap around in 32 bit. </summary>
+			template<typename TSrc> struct SSumType { using Type = double; static const EDataType DataType = EDataType::Double; };
+			template<> struct SSumType<uint8_t> { using Type = uint32_t; static const EDataType DataType = EDataType::UInt32; };
+			template<> struct SSumType<int8_t> { using Type = uint32_t; static const EDataType DataType = EDataType::Int32; };
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Writes the zero first element and the running sums of a row of the integral image. The channels
+			/// 	of a pixel are independent chains of additions whose latencies overlap, so that only rows of one
+			/// 	channel need SIMD.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TSrc, typename TAcc, bool Squared, int Channels>
+			struct SPrefixRow
+			{
+				static void Run(TAcc* pTrg, const TSrc* pSrc, int iWidth)
+				{
+					TAcc pSum[Channels];
+					for (int iCh = 0; iCh < Channels; ++iCh)
+					{
+						pSum[iCh] = TAcc(0);
+						pTrg[iCh] = TAcc(0);
+					}
+
+					pTrg += Channels;
+					for (int iX = 0; iX < iWidth; ++iX, pSrc += Channels, pTrg += Channels)
+					{
+						for (int iCh = 0; iCh < Channels; ++iCh)
+						{
+							const TAcc xValue = TAcc(pSrc[iCh]);
+							pSum[iCh] += (Squared ? xValue * xValue : xValue);
+							pTrg[iCh] = pSum[iCh];
+						}
+					}
+				}
+			};
+
+			/// <summary>	Widens 8 bit values to 32 bit with the sign extension of the source. </summary>
+			template<typename TSrc> struct SWiden8;
+
+			template<> struct SWiden8<uint8_t>
+			{
+				static void Run(__m128i* pmOut, __m128i mIn)
+				{
+					const __m128i mZero = _mm_setzero_si128();
+					const __m128i mLo = _mm_unpacklo_epi8(mIn, mZero);
+					const __m128i mHi = _mm_unpackhi_epi8(mIn, mZero);
+
+					pmOut[0] = _mm_unpacklo_epi16(mLo, mZero);
+					pmOut[1] = _mm_unpackhi_epi16(mLo, mZero);
+					pmOut[2] = _mm_unpacklo_epi16(mHi, mZero);
+					pmOut[3] = _mm_unpackhi_epi16(mHi, mZero);
+				}
+			};
+
+			template<> struct SWiden8<int8_t>
+			{
+				static void Run(__m128i* pmOut, __m128i mIn)
+				{
+					const __m128i mLo = _mm_srai_epi16(_mm_unpacklo_epi8(mIn, mIn), 8);
+					const __m128i mHi = _mm_srai_epi16(_mm_unpackhi_epi8(mIn, mIn), 8);
+
+					pmOut[0] = _mm_srai_epi32(_mm_unpacklo_epi16(mLo, mLo), 16);
+					pmOut[1] = _mm_srai_epi32(_mm_unpackhi_epi16(mLo, mLo), 16);
+					pmOut[2] = _mm_srai_epi32(_mm_unpacklo_epi16(mHi, mHi), 16);
+					pmOut[3] = _mm_srai_epi32(_mm_unpackhi_epi16(mHi, mHi), 16);
+				}
+			};
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	The running sums of a row of 8 bit values in 32 bit. Each vector of four values is summed with two
+			/// 	shifted additions, and the sum of all previous values is added from the last lane of the previous
+			/// 	vector.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TSrc>
+			struct SPrefixRow<TSrc, uint32_t, false, 1>
+			{
+				static void Run(uint32_t* pTrg, const TSrc* pSrc, int iWidth)
+				{
+					*pTrg++ = 0;
+
+					__m128i mCarry = _mm_setzero_si128();
+					__m128i pmValue[4];
+
+					int iX = 0;
+					for (; iX + 16 <= iWidth; iX += 16)
+					{
+						SWiden8<TSrc>::Run(pmValue, _mm_loadu_si128((const __m128i*)(pSrc + iX)));
+
+						for (int iVec = 0; iVec < 4; ++iVec)
+						{
+							__m128i mSum = pmValue[iVec];
+							mSum = _mm_add_epi32(mSum, _mm_slli_si128(mSum, 4));
+							mSum = _mm_add_epi32(mSum, _mm_slli_si128(mSum, 8));
+							mSum = _mm_add_epi32(mSum, mCarry);
+
+							_mm_storeu_si128((__m128i*)(pTrg + iX + 4 * iVec), mSum);
+							mCarry = _mm_shuffle_epi32(mSum, 0xFF);
+						}
+					}
+
+					uint32_t uSum = uint32_t(_mm_cvtsi128_si32(mCarry));
+					for (; iX < iWidth; ++iX)
+					{
+						uSum += uint32_t(pSrc[iX]);
+						pTrg[iX] = uSum;
+					}
+				}
+			};
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	The running sums of a row of values in doubles. Four values are summed in two vectors, so that the
+			/// 	sum of all previous values is a single addition of latency per four values.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TSrc, bool Squared>
+			struct SPrefixRow<TSrc, double, Squared, 1>
+			{
+				static void Run(double* pTrg, const TSrc* pSrc, int iWidth)
+				{
+					*pTrg++ = 0.0;
+
+					const __m128d mZero = _mm_setzero_pd();
+					__m128d mCarry = mZero;
+
+					int iX = 0;
+					for (; iX + 4 <= iWidth; iX += 4)
+					{
+						__m128d mSum0 = _mm_set_pd(double(pSrc[iX + 1]), double(pSrc[iX]));
+						__m128d mSum1 = _mm_set_pd(double(pSrc[iX + 3]), double(pSrc[iX + 2]));
+						if (Squared)
+						{
+							mSum0 = _mm_mul_pd(mSum0, mSum0);
+							mSum1 = _mm_mul_pd(mSum1, mSum1);
+						}
+
+						mSum0 = _mm_add_pd(mSum0, _mm_unpacklo_pd(mZero, mSum0));
+						mSum1 = _mm_add_pd(mSum1, _mm_unpacklo_pd(mZero, mSum1));
+						mSum1 = _mm_add_pd(mSum1, _mm_unpackhi_pd(mSum0, mSum0));
+
+						mSum0 = _mm_add_pd(mSum0, mCarry);
+						mSum1 = _mm_add_pd(mSum1, mCarry);
+
+						_mm_storeu_pd(pTrg + iX, mSum0);
+						_mm_storeu_pd(pTrg + iX + 2, mSum1);
+						mCarry = _mm_unpackhi_pd(mSum1, mSum1);
+					}
+
+					double dSum = _mm_cvtsd_f64(mCarry);
+					for (; iX < iWidth; ++iX)
+					{
+						const double dValue = double(pSrc[iX]);
+						dSum += (Squared ? dValue * dValue : dValue);
+						pTrg[iX] = dSum;
+					}
+				}
+			};
+
+			template<typename TSrc, typename TAcc, bool Squared>
+			void _PrefixRow(TAcc* pTrg, const TSrc* pSrc, int iWidth, int iChannelCount)
+			{
+				switch (iChannelCount)
+				{
+				case 1:
+					SPrefixRow<TSrc, TAcc, Squared, 1>::Run(pTrg, pSrc, iWidth);
+					break;
+
+				case 2:
+					SPrefixRow<TSrc, TAcc, Squared, 2>::Run(pTrg, pSrc, iWidth);
+					break;
+
+				case 3:
+					SPrefixRow<TSrc, TAcc, Squared, 3>::Run(pTrg, pSrc, iWidth);
+					break;
+
+				case 4:
+					SPrefixRow<TSrc, TAcc, Squared, 4>::Run(pTrg, pSrc, iWidth);
+					break;
+
+				default:
+					throw CLU_EXCEPTION("Unsupported number of channels");
+				}
+			}
+
+			/// <summary>	Adds the previous row to a row of an integral image. </summary>
+			inline void _AddRow(uint32_t* pRow, const uint32_t* pPrev, size_t nCount)
+			{
+				size_t nIdx = 0;
+				for (; nIdx + 4 <= nCount; nIdx += 4)
+				{
+					const __m128i mSum = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(pRow + nIdx))
+						, _mm_loadu_si128((const __m128i*)(pPrev + nIdx)));
+					_mm_storeu_si128((__m128i*)(pRow + nIdx), mSum);
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pRow[nIdx] += pPrev[nIdx];
+				}
+			}
+
+			inline void _AddRow(double* pRow, const double* pPrev, size_t nCount)
+			{
+				size_t nIdx = 0;
+				for (; nIdx + 2 <= nCount; nIdx += 2)
+				{
+					_mm_storeu_pd(pRow + nIdx, _mm_add_pd(_mm_loadu_pd(pRow + nIdx), _mm_loadu_pd(pPrev + nIdx)));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					pRow[nIdx] += pPrev[nIdx];
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Accumulates the rows of running sums vertically. The rows depend on each other, so that the image is
+			/// 	split into column stripes instead, which each thread runs down.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TAcc>
+			void _AccumulateColumns(CIImage& imgSum)
+			{
+				const SImageFormat& xFormat = imgSum.Format();
+				const size_t nPitch = size_t(xFormat.RowPitch());
+				const size_t nElementCount = size_t(xFormat.iWidth) * size_t(SImageType::DimOf(xFormat.ePixelType));
+				uint8_t* pucData = (uint8_t*)imgSum.DataPointer();
+
+				Clu::Parallel::ForEachBlock(nElementCount, MinStripeElementCount, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					for (int iY = 2; iY < xFormat.iHeight; ++iY)
+					{
+						TAcc* pRow = (TAcc*)(pucData + size_t(iY) * nPitch);
+						const TAcc* pPrev = (const TAcc*)(pucData + size_t(iY - 1) * nPitch);
+
+						_AddRow(pRow + nBegin, pPrev + nBegin, nEnd - nBegin);
+					}
+				});
+			}
+
+			SImageFormat _IntegralFormat(const SImageFormat& xSrcFormat, EDataType eDataType)
+			{
+				const EPixelType ePixelType = (SImageType::IsBayerPixelType(xSrcFormat.ePixelType)
+					? EPixelType::Lum : xSrcFormat.ePixelType);
+
+				return SImageFormat(xSrcFormat.iWidth + 1, xSrcFormat.iHeight + 1, ePixelType, eDataType);
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Creates the integral images. The running sums of the rows are calculated in parallel, with the
+			/// 	source row read once for both images, and then accumulated vertically.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TSrc>
+			void _IntegralImage(CIImage* pimgSum, CIImage* pimgSquaredSum, const CIImage& imgSrc)
+			{
+				using TSum = typename SSumType<TSrc>::Type;
+
+				const SImageFormat& xSrcFormat = imgSrc.Format();
+				const int iWidth = xSrcFormat.iWidth;
+				const int iChannelCount = int(SImageType::DimOf(xSrcFormat.ePixelType));
+				const size_t nSrcPitch = size_t(xSrcFormat.RowPitch());
+				const uint8_t* pucSrc = (const uint8_t*)imgSrc.DataPointer();
+
+				uint8_t* pucSum = nullptr;
+				uint8_t* pucSquaredSum = nullptr;
+				size_t nSumPitch = 0;
+				size_t nSquaredSumPitch = 0;
+
+				if (pimgSum)
+				{
+					pimgSum->Create(_IntegralFormat(xSrcFormat, SSumType<TSrc>::DataType));
+					pucSum = (uint8_t*)pimgSum->DataPointer();
+					nSumPitch = size_t(pimgSum->Format().RowPitch());
+					memset(pucSum, 0, pimgSum->Format().RowByteCount());
+				}
+
+				if (pimgSquaredSum)
+				{
+					pimgSquaredSum->Create(_IntegralFormat(xSrcFormat, EDataType::Double));
+					pucSquaredSum = (uint8_t*)pimgSquaredSum->DataPointer();
+					nSquaredSumPitch = size_t(pimgSquaredSum->Format().RowPitch());
+					memset(pucSquaredSum, 0, pimgSquaredSum->Format().RowByteCount());
+				}
+
+				const size_t nRowCount = size_t(xSrcFormat.iHeight);
+				const size_t nMinRows = std::max<size_t>(MinBlockPixelCount / size_t(iWidth), 1);
+
+				Clu::Parallel::ForEachBlock(nRowCount, nMinRows, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					for (size_t nY = nBegin; nY < nEnd; ++nY)
+					{
+						const TSrc* pSrc = (const TSrc*)(pucSrc + nY * nSrcPitch);
+
+						if (pucSum)
+						{
+							_PrefixRow<TSrc, TSum, false>((TSum*)(pucSum + (nY + 1) * nSumPitch), pSrc, iWidth, iChannelCount);
+						}
+
+						if (pucSquaredSum)
+						{
+							_PrefixRow<TSrc, double, true>((double*)(pucSquaredSum + (nY + 1) * nSquaredSumPitch), pSrc, iWidth, iChannelCount);
+						}
+					}
+				});
+
+				if (pimgSum)
+				{
+					_AccumulateColumns<TSum>(*pimgSum);
+				}
+
+				if (pimgSquaredSum)
+				{
+					_AccumulateColumns<double>(*pimgSquaredSum);
+				}
+			}
+
+			void _IntegralImage(CIImage* pimgSum, CIImage* pimgSquaredSum, const CIImage& imgSrc)
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid image");
+				}
+
+				switch (imgSrc.Format().eDataType)
+				{
+				case EDataType::Int8:
+					_IntegralImage<int8_t>(pimgSum, pimgSquaredSum, imgSrc);
+					break;
+
+				case EDataType::UInt8:
+					_IntegralImage<uint8_t>(pimgSum, pimgSquaredSum, imgSrc);
+					break;
+
+				case EDataType::Int16:
+					_IntegralImage<int16_t>(pimgSum, pimgSquaredSum, imgSrc);
+					break;
+
+				case EDataType::UInt16:
+					_IntegralImage<uint16_t>(pimgSum, pimgSquaredSum, imgSrc);
+					break;
+
+				case EDataType::Int32:
+					_IntegralImage<int32_t>(pimgSum, pimgSquaredSum, imgSrc);
+					break;
+
+				case EDataType::UInt32:
+					_IntegralImage<uint32_t>(pimgSum, pimgSquaredSum, imgSrc);
+					break;
+
+				case EDataType::Single:
+					_IntegralImage<float>(pimgSum, pimgSquaredSum, imgSrc);
+					break;
+
+				case EDataType::Double:
+					_IntegralImage<double>(pimgSum, pimgSquaredSum, imgSrc);
+					break;
+
+				default:
+					throw CLU_EXCEPTION("Unsupported image data type");
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Calculates box sums from the four corners of the boxes in an integral image, as doubles. The 32 bit
+			/// 	sums are differenced with modular arithmetic before the conversion, which makes them exact.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TAcc> struct SBoxLane;
+
+			template<> struct SBoxLane<double>
+			{
+				using TData = double;
+
+				static double Sum(const double* pA0, const double* pA1, const double* pB0, const double* pB1)
+				{
+					return (*pB1 - *pB0) - (*pA1 - *pA0);
+				}
+
+				static __m128d Sum2(const double* pA0, const double* pA1, const double* pB0, const double* pB1)
+				{
+					return _mm_sub_pd(_mm_sub_pd(_mm_loadu_pd(pB1), _mm_loadu_pd(pB0)), _mm_sub_pd(_mm_loadu_pd(pA1), _mm_loadu_pd(pA0)));
+				}
+			};
+
+			template<> struct SBoxLane<uint32_t>
+			{
+				using TData = uint32_t;
+
+				static double Sum(const uint32_t* pA0, const uint32_t* pA1, const uint32_t* pB0, const uint32_t* pB1)
+				{
+					return double(uint32_t((*pB1 - *pB0) - (*pA1 - *pA0)));
+				}
+
+				static __m128d Sum2(const uint32_t* pA0, const uint32_t* pA1, const uint32_t* pB0, const uint32_t* pB1)
+				{
+					const __m128i mSum = _Sum2(pA0, pA1, pB0, pB1);
+
+					// Unsigned to double through the signed conversion of the value offset by 2^31.
+					const __m128d mValue = _mm_cvtepi32_pd(_mm_xor_si128(mSum, _mm_set1_epi32(int(0x80000000u))));
+					return _mm_add_pd(mValue, _mm_set1_pd(2147483648.0));
+				}
+
+				static __m128i _Sum2(const uint32_t* pA0, const uint32_t* pA1, const uint32_t* pB0, const uint32_t* pB1)
+				{
+					const __m128i mB = _mm_sub_epi32(_mm_loadl_epi64((const __m128i*)pB1), _mm_loadl_epi64((const __m128i*)pB0));
+					const __m128i mA = _mm_sub_epi32(_mm_loadl_epi64((const __m128i*)pA1), _mm_loadl_epi64((const __m128i*)pA0));
+					return _mm_sub_epi32(mB, mA);
+				}
+			};
+
+			/// <summary>	The signed 32 bit sums of Int8 images, which are stored like the unsigned ones. </summary>
+			struct SBoxLaneInt32
+			{
+				using TData = uint32_t;
+
+				static double Sum(const uint32_t* pA0, const uint32_t* pA1, const uint32_t* pB0, const uint32_t* pB1)
+				{
+					return double(int32_t((*pB1 - *pB0) - (*pA1 - *pA0)));
+				}
+
+				static __m128d Sum2(const uint32_t* pA0, const uint32_t* pA1, const uint32_t* pB0, const uint32_t* pB1)
+				{
+					return _mm_cvtepi32_pd(SBoxLane<uint32_t>::_Sum2(pA0, pA1, pB0, pB1));
+				}
+			};
+
+			/// <summary>	Writes the box sums. </summary>
+			struct SBoxSumOp
+			{
+				using TTrg = double;
+				static const bool NeedSquaredSum = false;
+
+				static double Value(double dSum, double, double)
+				{
+					return dSum;
+				}
+
+				static void Store2(double* pTrg, __m128d mSum, __m128d, __m128d)
+				{
+					_mm_storeu_pd(pTrg, mSum);
+				}
+			};
+
+			/// <summary>	Writes the box means. </summary>
+			struct SBoxMeanOp
+			{
+				using TTrg = float;
+				static const bool NeedSquaredSum = false;
+
+				static float Value(double dSum, double, double dInvCount)
+				{
+					return float(dSum * dInvCount);
+				}
+
+				static void Store2(float* pTrg, __m128d mSum, __m128d, __m128d mInvCount)
+				{
+					_mm_storel_epi64((__m128i*)pTrg, _mm_castps_si128(_mm_cvtpd_ps(_mm_mul_pd(mSum, mInvCount))));
+				}
+			};
+
+			/// <summary>	Writes the box population variances, which are clamped at zero against rounding. </summary>
+			struct SBoxVarianceOp
+			{
+				using TTrg = float;
+				static const bool NeedSquaredSum = true;
+
+				static float Value(double dSum, double dSquaredSum, double dInvCount)
+				{
+					const double dMean = dSum * dInvCount;
+					return float(std::max(dSquaredSum * dInvCount - dMean * dMean, 0.0));
+				}
+
+				static void Store2(float* pTrg, __m128d mSum, __m128d mSquaredSum, __m128d mInvCount)
+				{
+					const __m128d mMean = _mm_mul_pd(mSum, mInvCount);
+					__m128d mVar = _mm_sub_pd(_mm_mul_pd(mSquaredSum, mInvCount), _mm_mul_pd(mMean, mMean));
+					mVar = _mm_max_pd(mVar, _mm_setzero_pd());
+
+					_mm_storel_epi64((__m128i*)pTrg, _mm_castps_si128(_mm_cvtpd_ps(mVar)));
+				}
+			};
+
+			/// <summary>	The rows of the integral images at the upper and lower edges of the boxes of a target row. </summary>
+			template<typename TData>
+			struct SBoxRows
+			{
+				const TData* pSumA;
+				const TData* pSumB;
+				const double* pSquaredSumA;
+				const double* pSquaredSumB;
+			};
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Filters a row. The boxes of the pixels at least the radius away from the left and right border are
+			/// 	not clipped, so that their corners are at fixed offsets from the target element for all channels
+			/// 	and two elements are calculated at once. The pixels at the borders calculate their clipped boxes.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TLane, typename TOp>
+			void _BoxRow(typename TOp::TTrg* pTrg, const SBoxRows<typename TLane::TData>& xRows
+				, int iWidth, int iChannelCount, int iRadiusX, int iBoxHeight)
+			{
+				const int iInnerBegin = std::min(iRadiusX, iWidth);
+				const int iInnerEnd = std::max(iWidth - iRadiusX, iInnerBegin);
+
+				auto funcBorder = [&](int iX)
+				{
+					const int iX0 = std::max(iX - iRadiusX, 0) * iChannelCount;
+					const int iX1 = std::min(iX + iRadiusX + 1, iWidth) * iChannelCount;
+					const double dInvCount = 1.0 / (double((iX1 - iX0) / iChannelCount) * double(iBoxHeight));
+
+					for (int iCh = 0; iCh < iChannelCount; ++iCh)
+					{
+						const double dSum = TLane::Sum(xRows.pSumA + iX0 + iCh, xRows.pSumA + iX1 + iCh
+							, xRows.pSumB + iX0 + iCh, xRows.pSumB + iX1 + iCh);
+						const double dSquaredSum = (TOp::NeedSquaredSum
+							? SBoxLane<double>::Sum(xRows.pSquaredSumA + iX0 + iCh, xRows.pSquaredSumA + iX1 + iCh
+								, xRows.pSquaredSumB + iX0 + iCh, xRows.pSquaredSumB + iX1 + iCh)
+							: 0.0);
+
+						pTrg[iX * iChannelCount + iCh] = TOp::Value(dSum, dSquaredSum, dInvCount);
+					}
+				};
+
+				for (int iX = 0; iX < iInnerBegin; ++iX)
+				{
+					funcBorder(iX);
+				}
+
+				// Offsets of the box corners from the integral element of the target element.
+				const int iOff0 = -iRadiusX * iChannelCount;
+				const int iOff1 = (iRadiusX + 1) * iChannelCount;
+				const double dInvCount = 1.0 / (double(2 * iRadiusX + 1) * double(iBoxHeight));
+				const __m128d mInvCount = _mm_set1_pd(dInvCount);
+				const __m128d mZero = _mm_setzero_pd();
+
+				int iIdx = iInnerBegin * iChannelCount;
+				const int iEnd = iInnerEnd * iChannelCount;
+				for (; iIdx + 2 <= iEnd; iIdx += 2)
+				{
+					const __m128d mSum = TLane::Sum2(xRows.pSumA + iIdx + iOff0, xRows.pSumA + iIdx + iOff1
+						, xRows.pSumB + iIdx + iOff0, xRows.pSumB + iIdx + iOff1);
+					const __m128d mSquaredSum = (TOp::NeedSquaredSum
+						? SBoxLane<double>::Sum2(xRows.pSquaredSumA + iIdx + iOff0, xRows.pSquaredSumA + iIdx + iOff1
+							, xRows.pSquaredSumB + iIdx + iOff0, xRows.pSquaredSumB + iIdx + iOff1)
+						: mZero);
+
+					TOp::Store2(pTrg + iIdx, mSum, mSquaredSum, mInvCount);
+				}
+
+				for (; iIdx < iEnd; ++iIdx)
+				{
+					const double dSum = TLane::Sum(xRows.pSumA + iIdx + iOff0, xRows.pSumA + iIdx + iOff1
+						, xRows.pSumB + iIdx + iOff0, xRows.pSumB + iIdx + iOff1);
+					const double dSquaredSum = (TOp::NeedSquaredSum
+						? SBoxLane<double>::Sum(xRows.pSquaredSumA + iIdx + iOff0, xRows.pSquaredSumA + iIdx + iOff1
+							, xRows.pSquaredSumB + iIdx + iOff0, xRows.pSquaredSumB + iIdx + iOff1)
+						: 0.0);
+
+					pTrg[iIdx] = TOp::Value(dSum, dSquaredSum, dInvCount);
+				}
+
+				for (int iX = iInnerEnd; iX < iWidth; ++iX)
+				{
+					funcBorder(iX);
+				}
+			}
+
+			template<typename TLane, typename TOp>
+			void _BoxFilter(CIImage& imgTrg, const CIntegralImage& xIntegral, int iRadiusX, int iRadiusY)
+			{
+				using TData = typename TLane::TData;
+				using TTrg = typename TOp::TTrg;
+
+				const int iWidth = xIntegral.Width();
+				const int iHeight = xIntegral.Height();
+				const int iChannelCount = xIntegral.ChannelCount();
+
+				const CIImage& imgSum = xIntegral.SumImage();
+				const SImageFormat& xSumFormat = imgSum.Format();
+				const size_t nSumPitch = size_t(xSumFormat.RowPitch());
+				const uint8_t* pucSum = (const uint8_t*)imgSum.DataPointer();
+
+				const uint8_t* pucSquaredSum = nullptr;
+				size_t nSquaredSumPitch = 0;
+				if (TOp::NeedSquaredSum)
+				{
+					pucSquaredSum = (const uint8_t*)xIntegral.SquaredSumImage().DataPointer();
+					nSquaredSumPitch = size_t(xIntegral.SquaredSumImage().Format().RowPitch());
+				}
+
+				imgTrg.Create(SImageFormat(iWidth, iHeight, xSumFormat.ePixelType
+					, std::is_same<TTrg, double>::value ? EDataType::Double : EDataType::Single));
+
+				const size_t nTrgPitch = size_t(imgTrg.Format().RowPitch());
+				uint8_t* pucTrg = (uint8_t*)imgTrg.DataPointer();
+
+				const size_t nMinRows = std::max<size_t>(MinBlockPixelCount / size_t(iWidth), 1);
+
+				Clu::Parallel::ForEachBlock(size_t(iHeight), nMinRows, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					for (size_t nY = nBegin; nY < nEnd; ++nY)
+					{
+						const size_t nY0 = size_t(std::max(int(nY) - iRadiusY, 0));
+						const size_t nY1 = size_t(std::min(int(nY) + iRadiusY + 1, iHeight));
+
+						SBoxRows<TData> xRows;
+						xRows.pSumA = (const TData*)(pucSum + nY0 * nSumPitch);
+						xRows.pSumB = (const TData*)(pucSum + nY1 * nSumPitch);
+						xRows.pSquaredSumA = (const double*)(pucSquaredSum + nY0 * nSquaredSumPitch);
+						xRows.pSquaredSumB = (const double*)(pucSquaredSum + nY1 * nSquaredSumPitch);
+
+						_BoxRow<TLane, TOp>((TTrg*)(pucTrg + nY * nTrgPitch), xRows, iWidth, iChannelCount, iRadiusX, int(nY1 - nY0));
+					}
+				});
+			}
+
+			template<typename TOp>
+			void _BoxFilter(CIImage& imgTrg, const CIntegralImage& xIntegral, int iRadiusX, int iRadiusY)
+			{
+				if (!xIntegral.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid integral image");
+				}
+
+				if (TOp::NeedSquaredSum && !xIntegral.HasSquaredSum())
+				{
+					throw CLU_EXCEPTION("Integral image has no squared sum");
+				}
+
+				if (iRadiusX < 0 || iRadiusY < 0)
+				{
+					throw CLU_EXCEPTION("Invalid box radius");
+				}
+
+				switch (xIntegral.SumImage().Format().eDataType)
+				{
+				case EDataType::UInt32:
+					_BoxFilter<SBoxLane<uint32_t>, TOp>(imgTrg, xIntegral, iRadiusX, iRadiusY);
+					break;
+
+				case EDataType::Int32:
+					_BoxFilter<SBoxLaneInt32, TOp>(imgTrg, xIntegral, iRadiusX, iRadiusY);
+					break;
+
+				case EDataType::Double:
+					_BoxFilter<SBoxLane<double>, TOp>(imgTrg, xIntegral, iRadiusX, iRadiusY);
+					break;
+
+				default:
+					throw CLU_EXCEPTION("Unsupported integral image data type");
+				}
+			}
+
+			/// <summary>	Looks up the sum of a channel over a box, which has been checked. </summary>
+			template<typename TLane>
+			double _BoxSum(const CIImage& imgSum, int iX, int iY, int iWidth, int iHeight, int iChannel)
+			{
+				using TData = typename TLane::TData;
+
+				const SImageFormat& xFormat = imgSum.Format();
+				const int iChannelCount = int(SImageType::DimOf(xFormat.ePixelType));
+				const size_t nPitch = size_t(xFormat.RowPitch());
+				const uint8_t* pucData = (const uint8_t*)imgSum.DataPointer();
+
+				const TData* pA = (const TData*)(pucData + size_t(iY) * nPitch);
+				const TData* pB = (const TData*)(pucData + size_t(iY + iHeight) * nPitch);
+				const int iX0 = iX * iChannelCount + iChannel;
+				const int iX1 = (iX + iWidth) * iChannelCount + iChannel;
+
+				return TLane::Sum(pA + iX0, pA + iX1, pB + iX0, pB + iX1);
+			}
+
+			double _BoxSum(const CIImage& imgSum, int iX, int iY, int iWidth, int iHeight, int iChannel)
+			{
+				switch (imgSum.Format().eDataType)
+				{
+				case EDataType::UInt32:
+					return _BoxSum<SBoxLane<uint32_t>>(imgSum, iX, iY, iWidth, iHeight, iChannel);
+
+				case EDataType::Int32:
+					return _BoxSum<SBoxLaneInt32>(imgSum, iX, iY, iWidth, iHeight, iChannel);
+
+				case EDataType::Double:
+					return _BoxSum<SBoxLane<double>>(imgSum, iX, iY, iWidth, iHeight, iChannel);
+
+				default:
+					throw CLU_EXCEPTION("Unsupported integral image data type");
+				}
+			}
+		} // namespace
+
+		void IntegralImage(CIImage& imgSum, const CIImage& imgSrc)
+		{
+			try
+			{
+				_IntegralImage(&imgSum, nullptr, imgSrc);
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating integral image")
+		}
+
+		void IntegralImage(CIImage& imgSum, CIImage& imgSquaredSum, const CIImage& imgSrc)
+		{
+			try
+			{
+				_IntegralImage(&imgSum, &imgSquaredSum, imgSrc);
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating integral images")
+		}
+
+		CIntegralImage::CIntegralImage()
+			: m_iWidth(0)
+			, m_iHeight(0)
+			, m_iChannelCount(0)
+		{
+		}
+
+		void CIntegralImage::Create(const CIImage& imgSrc, bool bSquaredSum)
+		{
+			try
+			{
+				if (bSquaredSum)
+				{
+					_IntegralImage(&m_imgSum, &m_imgSquaredSum, imgSrc);
+				}
+				else
+				{
+					_IntegralImage(&m_imgSum, nullptr, imgSrc);
+
+					if (m_imgSquaredSum.IsValid())
+					{
+						m_imgSquaredSum.Destroy();
+					}
+				}
+
+				m_iWidth = imgSrc.Format().iWidth;
+				m_iHeight = imgSrc.Format().iHeight;
+				m_iChannelCount = int(SImageType::DimOf(m_imgSum.Format().ePixelType));
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating integral image")
+		}
+
+		void CIntegralImage::Destroy()
+		{
+			if (m_imgSum.IsValid())
+			{
+				m_imgSum.Destroy();
+			}
+
+			if (m_imgSquaredSum.IsValid())
+			{
+				m_imgSquaredSum.Destroy();
+			}
+
+			m_iWidth = 0;
+			m_iHeight = 0;
+			m_iChannelCount = 0;
+		}
+
+		void CIntegralImage::_CheckBox(int iX, int iY, int iWidth, int iHeight, int iChannel) const
+		{
+			if (!IsValid())
+			{
+				throw CLU_EXCEPTION("Invalid integral image");
+			}
+
+			if (iX < 0 || iY < 0 || iWidth <= 0 || iHeight <= 0 || iWidth > m_iWidth - iX || iHeight > m_iHeight - iY)
+			{
+				throw CLU_EXCEPTION("Box is not inside the image");
+			}
+
+			if (iChannel < 0 || iChannel >= m_iChannelCount)
+			{
+				throw CLU_EXCEPTION("Invalid channel");
+			}
+		}
+
+		double CIntegralImage::Sum(int iX, int iY, int iWidth, int iHeight, int iChannel) const
+		{
+			_CheckBox(iX, iY, iWidth, iHeight, iChannel);
+			return _BoxSum(m_imgSum, iX, iY, iWidth, iHeight, iChannel);
+		}
+
+		double CIntegralImage::SquaredSum(int iX, int iY, int iWidth, int iHeight, int iChannel) const
+		{
+			_CheckBox(iX, iY, iWidth, iHeight, iChannel);
+			if (!HasSquaredSum())
+			{
+				throw CLU_EXCEPTION("Integral image has no squared sum");
+			}
+
+			return _BoxSum<SBoxLane<double>>(m_imgSquaredSum, iX, iY, iWidth, iHeight, iChannel);
+		}
+
+		double CIntegralImage::Mean(int iX, int iY, int iWidth, int iHeight, int iChannel) const
+		{
+			return Sum(iX, iY, iWidth, iHeight, iChannel) / (double(iWidth) * double(iHeight));
+		}
+
+		double CIntegralImage::Variance(int iX, int iY, int iWidth, int iHeight, int iChannel) const
+		{
+			const double dInvCount = 1.0 / (double(iWidth) * double(iHeight));
+			const double dMean = Sum(iX, iY, iWidth, iHeight, iChannel) * dInvCount;
+			const double dSquaredSum = SquaredSum(iX, iY, iWidth, iHeight, iChannel);
+
+			return std::max(dSquaredSum * dInvCount - dMean * dMean, 0.0);
+		}
+
+		void BoxSum(CIImage& imgTrg, const CIntegralImage& xIntegral, int iRadiusX, int iRadiusY)
+		{
+			try
+			{
+				_BoxFilter<SBoxSumOp>(imgTrg, xIntegral, iRadiusX, iRadiusY);
+			}
+			CLU_CATCH_RETHROW_ALL("Error calculating box sums")
+		}
+
+		void BoxMean(CIImage& imgTrg, const CIntegralImage& xIntegral, int iRadiusX, int iRadiusY)
+		{
+			try
+			{
+				_BoxFilter<SBoxMeanOp>(imgTrg, xIntegral, iRadiusX, iRadiusY);
+			}
+			CLU_CATCH_RETHROW_ALL("Error calculating box means")
+		}
+
+		void BoxVariance(CIImage& imgTrg, const CIntegralImage& xIntegral, int iRadiusX, int iRadiusY)
+		{
+			try
+			{
+				_BoxFilter<SBoxVarianceOp>(imgTrg, xIntegral, iRadiusX, iRadiusY);
+			}
+			CLU_CATCH_RETHROW_ALL("Error calculating box variances")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
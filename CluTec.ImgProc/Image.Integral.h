@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Integral.h
+//
+// summary:   Declares integral images and constant time box statistics
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Creates the integral image of an image. Its element (x, y) is the sum of all source pixels (i, j) with
+		/// 	i &lt; x and j &lt; y, so that it has one row and column more than the source, which are zero. It has
+		/// 	the channels of the source, and a single channel for Bayer images.
+		///
+		/// 	Sums of 8 bit images are accumulated in 32 bit integers of the signedness of the source. They may
+		/// 	wrap around, but the box sums calculated from them with 32 bit modular arithmetic are exact for boxes
+		/// 	of up to 2^24 pixels. All other images are accumulated in doubles, which are exact for integer sums
+		/// 	below 2^53.
+		/// </summary>
+		///
+		/// <param name="imgSum">	[out] The integral image. </param>
+		/// <param name="imgSrc">	The source image. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void IntegralImage(CIImage& imgSum, const CIImage& imgSrc);
+
+		/// <summary>	Creates the integral image and the integral image of the squared values, which is always of doubles. </summary>
+		void IntegralImage(CIImage& imgSum, CIImage& imgSquaredSum, const CIImage& imgSrc);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	The integral images of an image, from which the sum, mean and variance of the values of any box of
+		/// 	pixels are calculated with four look ups each.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CIntegralImage
+		{
+		public:
+			CIntegralImage();
+
+			bool IsValid() const
+			{
+				return m_imgSum.IsValid();
+			}
+
+			bool HasSquaredSum() const
+			{
+				return m_imgSquaredSum.IsValid();
+			}
+
+			/// <summary>	The width of the source image. </summary>
+			int Width() const
+			{
+				return m_iWidth;
+			}
+
+			/// <summary>	The height of the source image. </summary>
+			int Height() const
+			{
+				return m_iHeight;
+			}
+
+			int ChannelCount() const
+			{
+				return m_iChannelCount;
+			}
+
+			const CIImage& SumImage() const
+			{
+				return m_imgSum;
+			}
+
+			const CIImage& SquaredSumImage() const
+			{
+				return m_imgSquaredSum;
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Creates the integral images of an image. </summary>
+			///
+			/// <param name="imgSrc">			The source image. </param>
+			/// <param name="bSquaredSum">	True to also create the integral image of the squared values, which
+			/// 							the variance needs. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void Create(const CIImage& imgSrc, bool bSquaredSum = true);
+
+			void Destroy();
+
+			/// <summary>	The sum of a channel over the box of source pixels, which has to be inside the image. </summary>
+			double Sum(int iX, int iY, int iWidth, int iHeight, int iChannel = 0) const;
+
+			double SquaredSum(int iX, int iY, int iWidth, int iHeight, int iChannel = 0) const;
+
+			double Mean(int iX, int iY, int iWidth, int iHeight, int iChannel = 0) const;
+
+			/// <summary>	The population variance of a channel over the box of source pixels. </summary>
+			double Variance(int iX, int iY, int iWidth, int iHeight, int iChannel = 0) const;
+
+		protected:
+			void _CheckBox(int iX, int iY, int iWidth, int iHeight, int iChannel) const;
+
+		protected:
+			CIImage m_imgSum;
+			CIImage m_imgSquaredSum;
+
+			int m_iWidth;
+			int m_iHeight;
+			int m_iChannelCount;
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Calculates the sum over the box of (2 * iRadiusX + 1) x (2 * iRadiusY + 1) pixels about each pixel,
+		/// 	clipped at the image border. The target is a Double image of the size and channels of the source.
+		/// </summary>
+		///
+		/// <param name="imgTrg">   	[out] The target image. </param>
+		/// <param name="xIntegral">	The integral images of the source. </param>
+		/// <param name="iRadiusX"> 	The horizontal radius of the box. </param>
+		/// <param name="iRadiusY"> 	The vertical radius of the box. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void BoxSum(CIImage& imgTrg, const CIntegralImage& xIntegral, int iRadiusX, int iRadiusY);
+
+		/// <summary>	Calculates the mean over the clipped box about each pixel into a Single image. </summary>
+		void BoxMean(CIImage& imgTrg, const CIntegralImage& xIntegral, int iRadiusX, int iRadiusY);
+
+		/// <summary>
+		/// 	Calculates the population variance over the clipped box about each pixel into a Single image. The
+		/// 	integral images need the squared sum.
+		/// </summary>
+		void BoxVariance(CIImage& imgTrg, const CIntegralImage& xIntegral, int iRadiusX, int iRadiusY);
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,632 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Interleave.cpp
+//
+// summary:   Implements the conversions between interleaved and planar images
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#include "Image.Interleave.h"
+#include "Image.Simd.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	Interleaves nCount pixels from the layer rows ppSrc to pTrg. </summary>
+			using TInterleaveFunc = void(*)(void* pTrg, const void* const* ppSrc, size_t nCount);
+
+			/// <summary>	Splits nCount pixels from pSrc into the layer rows ppTrg. </summary>
+			using TDeinterleaveFunc = void(*)(void* const* ppTrg, const void* pSrc, size_t nCount);
+
+			/// <summary>	Minimal number of bytes per thread. </summary>
+			const size_t InterleaveMinBlockBytes = size_t(1) << 16;
+
+			const size_t MaxChannelCount = 4;
+
+			using Simd::SZip;
+			using Simd::Load;
+			using Simd::Store;
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Three channel shuffles by element size. Interleave maps one vector per channel to three consecutive
+			// vectors, Deinterleave is the inverse.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<size_t t_nSize> struct STriple
+			{
+				static const bool IsAvailable = false;
+
+				static void Interleave(__m128i*, const __m128i*) { }
+				static void Deinterleave(__m128i*, const __m128i*) { }
+			};
+
+			/// <summary>	Moves the pixels of 1 and 2 byte elements between 4 channel slots and 6 bytes per 64 bit lane. </summary>
+			template<size_t t_nSize> struct SLanes;
+
+			template<> struct SLanes<1>
+			{
+				// Each 64 bit lane holds two pixels in 4 byte slots, whose fourth byte is zero.
+				static __m128i Pack(__m128i mPixels)
+				{
+					const __m128i mLow = _mm_set_epi32(0, -1, 0, -1);
+					return _mm_or_si128(_mm_and_si128(mPixels, mLow), _mm_srli_epi64(_mm_andnot_si128(mLow, mPixels), 8));
+				}
+
+				// The fourth byte of each slot is undefined.
+				static __m128i Unpack(__m128i mLanes)
+				{
+					const __m128i mLow = _mm_set_epi32(0, -1, 0, -1);
+					return _mm_or_si128(_mm_and_si128(mLanes, mLow), _mm_andnot_si128(mLow, _mm_slli_epi64(mLanes, 8)));
+				}
+			};
+
+			template<> struct SLanes<2>
+			{
+				// A pixel fills a 64 bit lane already.
+				static __m128i Pack(__m128i mPixels)
+				{
+					return mPixels;
+				}
+
+				static __m128i Unpack(__m128i mLanes)
+				{
+					return mLanes;
+				}
+			};
+
+			/// <summary>
+			/// 	The SSE2 variant of a byte shuffle for 1 and 2 byte elements. The channels are zipped to four channel
+			/// 	pixels with a zero fourth channel, whose slots are then squeezed out with shifts. Deinterleave widens the
+			/// 	pixels to four channels and unzips them.
+			/// </summary>
+			template<size_t t_nSize> struct STripleZip
+			{
+				using TZip = SZip<t_nSize>;
+
+				static const bool IsAvailable = true;
+
+				static void Interleave(__m128i* pmTrg, const __m128i* pmSrc)
+				{
+					__m128i m02Lo, m02Hi, m13Lo, m13Hi, pmPixel[4];
+					TZip::Zip(pmSrc[0], pmSrc[2], m02Lo, m02Hi);
+					TZip::Zip(pmSrc[1], _mm_setzero_si128(), m13Lo, m13Hi);
+					TZip::Zip(m02Lo, m13Lo, pmPixel[0], pmPixel[1]);
+					TZip::Zip(m02Hi, m13Hi, pmPixel[2], pmPixel[3]);
+
+					// Each part holds the pixels of one vector in its low 12 bytes.
+					__m128i pmPart[4];
+					for (size_t nIdx = 0; nIdx < 4; ++nIdx)
+					{
+						const __m128i mLanes = SLanes<t_nSize>::Pack(pmPixel[nIdx]);
+						pmPart[nIdx] = _mm_or_si128(_mm_move_epi64(mLanes), _mm_srli_si128(_mm_unpackhi_epi64(_mm_setzero_si128(), mLanes), 2));
+					}
+
+					pmTrg[0] = _mm_or_si128(pmPart[0], _mm_slli_si128(pmPart[1], 12));
+					pmTrg[1] = _mm_or_si128(_mm_srli_si128(pmPart[1], 4), _mm_slli_si128(pmPart[2], 8));
+					pmTrg[2] = _mm_or_si128(_mm_srli_si128(pmPart[2], 8), _mm_slli_si128(pmPart[3], 4));
+				}
+
+				static void Deinterleave(__m128i* pmTrg, const __m128i* pmSrc)
+				{
+					const __m128i pmPart[4] = { pmSrc[0]
+						, _mm_or_si128(_mm_srli_si128(pmSrc[0], 12), _mm_slli_si128(pmSrc[1], 4))
+						, _mm_or_si128(_mm_srli_si128(pmSrc[1], 8), _mm_slli_si128(pmSrc[2], 8))
+						, _mm_srli_si128(pmSrc[2], 4) };
+
+					__m128i pmPixel[4];
+					for (size_t nIdx = 0; nIdx < 4; ++nIdx)
+					{
+						pmPixel[nIdx] = SLanes<t_nSize>::Unpack(_mm_unpacklo_epi64(pmPart[nIdx], _mm_srli_si128(pmPart[nIdx], 6)));
+					}
+
+					__m128i mEven01, mOdd01, mEven23, mOdd23, mC3;
+					TZip::Unzip(pmPixel[0], pmPixel[1], mEven01, mOdd01);
+					TZip::Unzip(pmPixel[2], pmPixel[3], mEven23, mOdd23);
+					TZip::Unzip(mEven01, mEven23, pmTrg[0], pmTrg[2]);
+					TZip::Unzip(mOdd01, mOdd23, pmTrg[1], mC3);
+				}
+			};
+
+			template<> struct STriple<1> : public STripleZip<1> { };
+			template<> struct STriple<2> : public STripleZip<2> { };
+
+			template<> struct STriple<4>
+			{
+				static const bool IsAvailable = true;
+
+				static void Interleave(__m128i* pmTrg, const __m128i* pmSrc)
+				{
+					const __m128 mA = _mm_castsi128_ps(pmSrc[0]);
+					const __m128 mB = _mm_castsi128_ps(pmSrc[1]);
+					const __m128 mC = _mm_castsi128_ps(pmSrc[2]);
+
+					const __m128 mABLo = _mm_unpacklo_ps(mA, mB);
+					const __m128 mABHi = _mm_unpackhi_ps(mA, mB);
+					const __m128 mBCLo = _mm_unpacklo_ps(mB, mC);
+					const __m128 mBCHi = _mm_unpackhi_ps(mB, mC);
+					const __m128 mCALo = _mm_unpacklo_ps(mC, mA);
+					const __m128 mCAHi = _mm_unpackhi_ps(mC, mA);
+
+					// a0 b0 c0 a1 | b1 c1 a2 b2 | c2 a3 b3 c3
+					pmTrg[0] = _mm_castps_si128(_mm_shuffle_ps(mABLo, mCALo, _MM_SHUFFLE(3, 0, 1, 0)));
+					pmTrg[1] = _mm_castps_si128(_mm_shuffle_ps(mBCLo, mABHi, _MM_SHUFFLE(1, 0, 3, 2)));
+					pmTrg[2] = _mm_castps_si128(_mm_shuffle_ps(mCAHi, mBCHi, _MM_SHUFFLE(3, 2, 3, 0)));
+				}
+
+				static void Deinterleave(__m128i* pmTrg, const __m128i* pmSrc)
+				{
+					const __m128 mV0 = _mm_castsi128_ps(pmSrc[0]);
+					const __m128 mV1 = _mm_castsi128_ps(pmSrc[1]);
+					const __m128 mV2 = _mm_castsi128_ps(pmSrc[2]);
+
+					const __m128 mA23 = _mm_shuffle_ps(mV1, mV2, _MM_SHUFFLE(0, 1, 0, 2));
+					pmTrg[0] = _mm_castps_si128(_mm_shuffle_ps(mV0, mA23, _MM_SHUFFLE(2, 0, 3, 0)));
+
+					const __m128 mB01 = _mm_shuffle_ps(mV0, mV1, _MM_SHUFFLE(0, 0, 1, 1));
+					const __m128 mB23 = _mm_shuffle_ps(mV1, mV2, _MM_SHUFFLE(2, 2, 3, 3));
+					pmTrg[1] = _mm_castps_si128(_mm_shuffle_ps(mB01, mB23, _MM_SHUFFLE(2, 0, 2, 0)));
+
+					const __m128 mC01 = _mm_shuffle_ps(mV0, mV1, _MM_SHUFFLE(1, 1, 2, 2));
+					pmTrg[2] = _mm_castps_si128(_mm_shuffle_ps(mC01, mV2, _MM_SHUFFLE(3, 0, 2, 0)));
+				}
+			};
+
+			template<> struct STriple<8>
+			{
+				static const bool IsAvailable = true;
+
+				static void Interleave(__m128i* pmTrg, const __m128i* pmSrc)
+				{
+					// a0 b0 | c0 a1 | b1 c1
+					pmTrg[0] = _mm_unpacklo_epi64(pmSrc[0], pmSrc[1]);
+					pmTrg[1] = _mm_castpd_si128(_mm_move_sd(_mm_castsi128_pd(pmSrc[0]), _mm_castsi128_pd(pmSrc[2])));
+					pmTrg[2] = _mm_unpackhi_epi64(pmSrc[1], pmSrc[2]);
+				}
+
+				static void Deinterleave(__m128i* pmTrg, const __m128i* pmSrc)
+				{
+					const __m128d mV0 = _mm_castsi128_pd(pmSrc[0]);
+					const __m128d mV1 = _mm_castsi128_pd(pmSrc[1]);
+					const __m128d mV2 = _mm_castsi128_pd(pmSrc[2]);
+
+					pmTrg[0] = _mm_castpd_si128(_mm_move_sd(mV1, mV0));
+					pmTrg[1] = _mm_castpd_si128(_mm_shuffle_pd(mV0, mV2, 1));
+					pmTrg[2] = _mm_castpd_si128(_mm_move_sd(mV2, mV1));
+				}
+			};
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Row kernels. Each processes whole vectors and returns the number of pixels done.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename TElem, size_t t_nChannels> struct SKernel;
+
+			template<typename TElem> struct SKernel<TElem, 1>
+			{
+				static size_t Interleave(TElem* pTrg, const TElem* const* ppSrc, size_t nCount)
+				{
+					memcpy(pTrg, ppSrc[0], nCount * sizeof(TElem));
+					return nCount;
+				}
+
+				static size_t Deinterleave(TElem* const* ppTrg, const TElem* pSrc, size_t nCount)
+				{
+					memcpy(ppTrg[0], pSrc, nCount * sizeof(TElem));
+					return nCount;
+				}
+			};
+
+			template<typename TElem> struct SKernel<TElem, 2>
+			{
+				using TZip = SZip<sizeof(TElem)>;
+				static const size_t Step = 16 / sizeof(TElem);
+
+				static size_t Interleave(TElem* pTrg, const TElem* const* ppSrc, size_t nCount)
+				{
+					size_t nX = 0;
+					for (; nX + Step <= nCount; nX += Step)
+					{
+						__m128i mLo, mHi;
+						TZip::Zip(Load(ppSrc[0] + nX), Load(ppSrc[1] + nX), mLo, mHi);
+
+						Store(pTrg + 2 * nX, mLo);
+						Store(pTrg + 2 * nX + Step, mHi);
+					}
+
+					return nX;
+				}
+
+				static size_t Deinterleave(TElem* const* ppTrg, const TElem* pSrc, size_t nCount)
+				{
+					size_t nX = 0;
+					for (; nX + Step <= nCount; nX += Step)
+					{
+						__m128i mEven, mOdd;
+						TZip::Unzip(Load(pSrc + 2 * nX), Load(pSrc + 2 * nX + Step), mEven, mOdd);
+
+						Store(ppTrg[0] + nX, mEven);
+						Store(ppTrg[1] + nX, mOdd);
+					}
+
+					return nX;
+				}
+			};
+
+			template<typename TElem> struct SKernel<TElem, 3>
+			{
+				using TTriple = STriple<sizeof(TElem)>;
+				static const size_t Step = 16 / sizeof(TElem);
+
+				static size_t Interleave(TElem* pTrg, const TElem* const* ppSrc, size_t nCount)
+				{
+					size_t nX = 0;
+					if (!TTriple::IsAvailable)
+					{
+						return nX;
+					}
+
+					for (; nX + Step <= nCount; nX += Step)
+					{
+						const __m128i pmSrc[3] = { Load(ppSrc[0] + nX), Load(ppSrc[1] + nX), Load(ppSrc[2] + nX) };
+						__m128i pmTrg[3];
+						TTriple::Interleave(pmTrg, pmSrc);
+
+						TElem* pPixel = pTrg + 3 * nX;
+						Store(pPixel, pmTrg[0]);
+						Store(pPixel + Step, pmTrg[1]);
+						Store(pPixel + 2 * Step, pmTrg[2]);
+					}
+
+					return nX;
+				}
+
+				static size_t Deinterleave(TElem* const* ppTrg, const TElem* pSrc, size_t nCount)
+				{
+					size_t nX = 0;
+					if (!TTriple::IsAvailable)
+					{
+						return nX;
+					}
+
+					for (; nX + Step <= nCount; nX += Step)
+					{
+						const TElem* pPixel = pSrc + 3 * nX;
+						const __m128i pmSrc[3] = { Load(pPixel), Load(pPixel + Step), Load(pPixel + 2 * Step) };
+						__m128i pmTrg[3];
+						TTriple::Deinterleave(pmTrg, pmSrc);
+
+						Store(ppTrg[0] + nX, pmTrg[0]);
+						Store(ppTrg[1] + nX, pmTrg[1]);
+						Store(ppTrg[2] + nX, pmTrg[2]);
+					}
+
+					return nX;
+				}
+			};
+
+			template<typename TElem> struct SKernel<TElem, 4>
+			{
+				using TZip = SZip<sizeof(TElem)>;
+				static const size_t Step = 16 / sizeof(TElem);
+
+				static size_t Interleave(TElem* pTrg, const TElem* const* ppSrc, size_t nCount)
+				{
+					size_t nX = 0;
+					for (; nX + Step <= nCount; nX += Step)
+					{
+						// Zipping channels 0 with 2 and 1 with 3 and then the results gives the pixel order 0 1 2 3.
+						__m128i m02Lo, m02Hi, m13Lo, m13Hi, mV0, mV1, mV2, mV3;
+						TZip::Zip(Load(ppSrc[0] + nX), Load(ppSrc[2] + nX), m02Lo, m02Hi);
+						TZip::Zip(Load(ppSrc[1] + nX), Load(ppSrc[3] + nX), m13Lo, m13Hi);
+						TZip::Zip(m02Lo, m13Lo, mV0, mV1);
+						TZip::Zip(m02Hi, m13Hi, mV2, mV3);
+
+						TElem* pPixel = pTrg + 4 * nX;
+						Store(pPixel, mV0);
+						Store(pPixel + Step, mV1);
+						Store(pPixel + 2 * Step, mV2);
+						Store(pPixel + 3 * Step, mV3);
+					}
+
+					return nX;
+				}
+
+				static size_t Deinterleave(TElem* const* ppTrg, const TElem* pSrc, size_t nCount)
+				{
+					size_t nX = 0;
+					for (; nX + Step <= nCount; nX += Step)
+					{
+						const TElem* pPixel = pSrc + 4 * nX;
+						__m128i mEven01, mOdd01, mEven23, mOdd23, mC0, mC1, mC2, mC3;
+						TZip::Unzip(Load(pPixel), Load(pPixel + Step), mEven01, mOdd01);
+						TZip::Unzip(Load(pPixel + 2 * Step), Load(pPixel + 3 * Step), mEven23, mOdd23);
+						TZip::Unzip(mEven01, mEven23, mC0, mC2);
+						TZip::Unzip(mOdd01, mOdd23, mC1, mC3);
+
+						Store(ppTrg[0] + nX, mC0);
+						Store(ppTrg[1] + nX, mC1);
+						Store(ppTrg[2] + nX, mC2);
+						Store(ppTrg[3] + nX, mC3);
+					}
+
+					return nX;
+				}
+			};
+
+			template<typename TElem, size_t t_nChannels>
+			void _InterleaveRow(void* pTrg, const void* const* ppSrc, size_t nCount)
+			{
+				TElem* pTrgElem = (TElem*)pTrg;
+				const TElem* const* ppSrcElem = (const TElem* const*)ppSrc;
+
+				for (size_t nX = SKernel<TElem, t_nChannels>::Interleave(pTrgElem, ppSrcElem, nCount); nX < nCount; ++nX)
+				{
+					for (size_t nChannel = 0; nChannel < t_nChannels; ++nChannel)
+					{
+						pTrgElem[nX * t_nChannels + nChannel] = ppSrcElem[nChannel][nX];
+					}
+				}
+			}
+
+			template<typename TElem, size_t t_nChannels>
+			void _DeinterleaveRow(void* const* ppTrg, const void* pSrc, size_t nCount)
+			{
+				TElem* const* ppTrgElem = (TElem* const*)ppTrg;
+				const TElem* pSrcElem = (const TElem*)pSrc;
+
+				for (size_t nX = SKernel<TElem, t_nChannels>::Deinterleave(ppTrgElem, pSrcElem, nCount); nX < nCount; ++nX)
+				{
+					for (size_t nChannel = 0; nChannel < t_nChannels; ++nChannel)
+					{
+						ppTrgElem[nChannel][nX] = pSrcElem[nX * t_nChannels + nChannel];
+					}
+				}
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Dispatch. The shuffles only depend on the size of the values, so all data types map to four element types.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename TElem>
+			void _SelectRowFuncs(TInterleaveFunc& pInterleave, TDeinterleaveFunc& pDeinterleave, size_t nChannelCount)
+			{
+				switch (nChannelCount)
+				{
+				case 1:
+					pInterleave = &_InterleaveRow<TElem, 1>;
+					pDeinterleave = &_DeinterleaveRow<TElem, 1>;
+					break;
+				case 2:
+					pInterleave = &_InterleaveRow<TElem, 2>;
+					pDeinterleave = &_DeinterleaveRow<TElem, 2>;
+					break;
+				case 3:
+					pInterleave = &_InterleaveRow<TElem, 3>;
+					pDeinterleave = &_DeinterleaveRow<TElem, 3>;
+					break;
+				case 4:
+					pInterleave = &_InterleaveRow<TElem, 4>;
+					pDeinterleave = &_DeinterleaveRow<TElem, 4>;
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported number of image channels");
+				}
+			}
+
+			void _SelectRowFuncs(TInterleaveFunc& pInterleave, TDeinterleaveFunc& pDeinterleave, const SImageFormat& xFormat)
+			{
+				const size_t nChannelCount = SImageType::DimOf(xFormat.ePixelType);
+
+				switch (SImageType::SizeOf(xFormat.eDataType))
+				{
+				case 1:
+					_SelectRowFuncs<uint8_t>(pInterleave, pDeinterleave, nChannelCount);
+					break;
+				case 2:
+					_SelectRowFuncs<uint16_t>(pInterleave, pDeinterleave, nChannelCount);
+					break;
+				case 4:
+					_SelectRowFuncs<uint32_t>(pInterleave, pDeinterleave, nChannelCount);
+					break;
+				case 8:
+					_SelectRowFuncs<uint64_t>(pInterleave, pDeinterleave, nChannelCount);
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported image data type");
+				}
+			}
+
+			/// <summary>	Calls funcRow(nRow) for all rows, in parallel bands for large images. </summary>
+			template<typename FuncRow>
+			void _ForEachRow(const SImageFormat& xFormat, FuncRow funcRow)
+			{
+				const size_t nMinRows = std::max<size_t>(InterleaveMinBlockBytes / std::max<size_t>(xFormat.RowByteCount(), 1), 1);
+
+				Clu::Parallel::ForEachBlock(size_t(xFormat.iHeight), nMinRows, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					for (size_t nRow = nBegin; nRow < nEnd; ++nRow)
+					{
+						funcRow(nRow);
+					}
+				});
+			}
+
+			SImageFormat _PackedFormat(const SImageFormat& xFormat)
+			{
+				return SImageFormat(xFormat.iWidth, xFormat.iHeight, xFormat.ePixelType, xFormat.eDataType);
+			}
+		} // namespace
+
+		void InterleaveData(void* pTrgData, const SImageFormat& xFormat, const void* const* ppLayerData, size_t nLayerRowPitch)
+		{
+			if (pTrgData == nullptr || ppLayerData == nullptr)
+			{
+				throw CLU_EXCEPTION("Invalid image data");
+			}
+
+			TInterleaveFunc pInterleave;
+			TDeinterleaveFunc pDeinterleave;
+			_SelectRowFuncs(pInterleave, pDeinterleave, xFormat);
+
+			const size_t nChannelCount = SImageType::DimOf(xFormat.ePixelType);
+			for (size_t nChannel = 0; nChannel < nChannelCount; ++nChannel)
+			{
+				if (ppLayerData[nChannel] == nullptr)
+				{
+					throw CLU_EXCEPTION("Invalid image layer data");
+				}
+			}
+
+			const size_t nWidth = size_t(xFormat.iWidth);
+			const size_t nTrgPitch = xFormat.RowPitch();
+			const size_t nSrcPitch = (nLayerRowPitch > 0 ? nLayerRowPitch : nWidth * SImageType::SizeOf(xFormat.eDataType));
+
+			_ForEachRow(xFormat, [&](size_t nRow)
+			{
+				const void* ppSrc[MaxChannelCount];
+				for (size_t nChannel = 0; nChannel < nChannelCount; ++nChannel)
+				{
+					ppSrc[nChannel] = (const unsigned char*)ppLayerData[nChannel] + nRow * nSrcPitch;
+				}
+
+				pInterleave((unsigned char*)pTrgData + nRow * nTrgPitch, ppSrc, nWidth);
+			});
+		}
+
+		void DeinterleaveData(void* const* ppLayerData, size_t nLayerRowPitch, const void* pSrcData, const SImageFormat& xFormat)
+		{
+			if (pSrcData == nullptr || ppLayerData == nullptr)
+			{
+				throw CLU_EXCEPTION("Invalid image data");
+			}
+
+			TInterleaveFunc pInterleave;
+			TDeinterleaveFunc pDeinterleave;
+			_SelectRowFuncs(pInterleave, pDeinterleave, xFormat);
+
+			const size_t nChannelCount = SImageType::DimOf(xFormat.ePixelType);
+			for (size_t nChannel = 0; nChannel < nChannelCount; ++nChannel)
+			{
+				if (ppLayerData[nChannel] == nullptr)
+				{
+					throw CLU_EXCEPTION("Invalid image layer data");
+				}
+			}
+
+			const size_t nWidth = size_t(xFormat.iWidth);
+			const size_t nSrcPitch = xFormat.RowPitch();
+			const size_t nTrgPitch = (nLayerRowPitch > 0 ? nLayerRowPitch : nWidth * SImageType::SizeOf(xFormat.eDataType));
+
+			_ForEachRow(xFormat, [&](size_t nRow)
+			{
+				void* ppTrg[MaxChannelCount];
+				for (size_t nChannel = 0; nChannel < nChannelCount; ++nChannel)
+				{
+					ppTrg[nChannel] = (unsigned char*)ppLayerData[nChannel] + nRow * nTrgPitch;
+				}
+
+				pDeinterleave(ppTrg, (const unsigned char*)pSrcData + nRow * nSrcPitch, nWidth);
+			});
+		}
+
+		void Interleave(CIImage& imgTrg, const CILayerImage& imgSrc)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				const size_t nLayerCount = imgSrc.LayerCount();
+				if (nLayerCount > MaxChannelCount)
+				{
+					throw CLU_EXCEPTION("Unsupported number of image channels");
+				}
+
+				const void* ppLayer[MaxChannelCount];
+				for (size_t nLayer = 0; nLayer < nLayerCount; ++nLayer)
+				{
+					ppLayer[nLayer] = imgSrc.DataPointer(nLayer);
+				}
+
+				imgTrg.Create(_PackedFormat(imgSrc.Format()));
+
+				InterleaveData(imgTrg.DataPointer(), imgTrg.Format(), ppLayer, imgSrc.LayerRowPitch());
+			}
+			CLU_CATCH_RETHROW_ALL("Error interleaving image")
+		}
+
+		void Deinterleave(CILayerImage& imgTrg, const CIImage& imgSrc)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				imgTrg.Create(_PackedFormat(imgSrc.Format()));
+
+				const size_t nLayerCount = imgTrg.LayerCount();
+				if (nLayerCount > MaxChannelCount)
+				{
+					throw CLU_EXCEPTION("Unsupported number of image channels");
+				}
+
+				void* ppLayer[MaxChannelCount];
+				for (size_t nLayer = 0; nLayer < nLayerCount; ++nLayer)
+				{
+					ppLayer[nLayer] = imgTrg.DataPointer(nLayer);
+				}
+
+				DeinterleaveData(ppLayer, imgTrg.LayerRowPitch(), imgSrc.DataPointer(), imgSrc.Format());
+			}
+			CLU_CATCH_RETHROW_ALL("Error deinterleaving image")
+		}
+
+		CIImage InterleavedView(CILayerImage& imgSrc)
+		{
+			try
+			{
+				if (!imgSrc.IsValid() || imgSrc.LayerCount() != 1)
+				{
+					throw CLU_EXCEPTION("Only valid single layer images can be viewed as interleaved images");
+				}
+
+				return imgSrc.InterleavedView();
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating interleaved image view")
+		}
+
+		CILayerImage LayerView(CIImage& imgSrc)
+		{
+			try
+			{
+				if (!imgSrc.IsValid() || SImageType::DimOf(imgSrc.Format().ePixelType) != 1)
+				{
+					throw CLU_EXCEPTION("Only valid single channel images can be viewed as layer images");
+				}
+
+				return imgSrc.LayerView();
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating layer image view")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Interleave.h
+//
+// summary:   Declares the conversions between interleaved and planar images
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Interleaves the layers of a planar image memory block. Images with 2, 3 or 4 channels use SIMD shuffle
+		/// 	kernels for all data types, single channel images are copied row by row. Large images are processed in
+		/// 	parallel row bands.
+		/// </summary>
+		///
+		/// <param name="pTrgData">		  	The interleaved target memory. </param>
+		/// <param name="xFormat">		  	The format of the interleaved target, which may have a row pitch. </param>
+		/// <param name="ppLayerData">	  	The source layers, one per channel of the pixel type. </param>
+		/// <param name="nLayerRowPitch">	Bytes between the rows of the source layers. Zero denotes packed rows. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void InterleaveData(void* pTrgData, const SImageFormat& xFormat, const void* const* ppLayerData, size_t nLayerRowPitch);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Splits an interleaved image memory block into layers. The inverse of InterleaveData(). </summary>
+		///
+		/// <param name="ppLayerData">	  	The target layers, one per channel of the pixel type. </param>
+		/// <param name="nLayerRowPitch">	Bytes between the rows of the target layers. Zero denotes packed rows. </param>
+		/// <param name="pSrcData">		  	The interleaved source memory. </param>
+		/// <param name="xFormat">		  	The format of the interleaved source, which may have a row pitch. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void DeinterleaveData(void* const* ppLayerData, size_t nLayerRowPitch, const void* pSrcData, const SImageFormat& xFormat);
+
+		/// <summary>	Creates the target image with the type and size of the layer image and interleaves the layers into it. </summary>
+		void Interleave(CIImage& imgTrg, const CILayerImage& imgSrc);
+
+		/// <summary>	Creates the target layer image with the type and size of the source image and splits the source into it. </summary>
+		void Deinterleave(CILayerImage& imgTrg, const CIImage& imgSrc);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Returns an image that refers to the memory of a single layer image without copying it. This is possible
+		/// 	since interleaved and planar layouts coincide for a single channel. Writing to the view writes to the
+		/// 	source. As for CropView(), the source first receives its own memory if it shares it with copies, and
+		/// 	its memory is marked as viewed, so that later copies do not share it. The view keeps the memory of the
+		/// 	source alive.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		CIImage InterleavedView(CILayerImage& imgSrc);
+
+		/// <summary>
+		/// 	Returns a layer image that refers to the memory of a single channel image without copying it, with the
+		/// 	same write semantics as InterleavedView().
+		/// </summary>
+		CILayerImage LayerView(CIImage& imgSrc);
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,575 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Label.cpp
+//
+// summary:   Implements the connected components labeling and the speckle filter
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "Image.Label.h"
+
+#include "CluTec.Types1/ImageType.h"
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	The minimal number of pixels per parallel block. </summary>
+			const size_t MinBlockPixelCount = size_t(1) << 16;
+
+			/// <summary>	One memory plane of an image. </summary>
+			struct SPlane
+			{
+				unsigned char* pucData;
+				size_t nRowPitch;
+
+				template<typename TValue>
+				TValue* Row(size_t nY) const
+				{
+					return (TValue*)(pucData + nY * nRowPitch);
+				}
+			};
+
+			/// <summary>	The statistics of the pixels of a provisional label. </summary>
+			struct SLabelStats
+			{
+				uint32_t uArea;
+				int iMinX;
+				int iMinY;
+				int iMaxX;
+				int iMaxY;
+				uint64_t uSumX;
+				uint64_t uSumY;
+
+				SLabelStats(int iX, int iY)
+					: uArea(1)
+					, iMinX(iX)
+					, iMinY(iY)
+					, iMaxX(iX)
+					, iMaxY(iY)
+					, uSumX(uint64_t(iX))
+					, uSumY(uint64_t(iY))
+				{
+				}
+
+				void Add(int iX, int iY)
+				{
+					++uArea;
+					iMinX = std::min(iMinX, iX);
+					iMaxX = std::max(iMaxX, iX);
+					iMaxY = iY;
+					uSumX += uint64_t(iX);
+					uSumY += uint64_t(iY);
+				}
+
+				void Add(const SLabelStats& xStats)
+				{
+					uArea += xStats.uArea;
+					iMinX = std::min(iMinX, xStats.iMinX);
+					iMinY = std::min(iMinY, xStats.iMinY);
+					iMaxX = std::max(iMaxX, xStats.iMaxX);
+					iMaxY = std::max(iMaxY, xStats.iMaxY);
+					uSumX += xStats.uSumX;
+					uSumY += xStats.uSumY;
+				}
+			};
+
+			/// <summary>	The provisional labels of a band of rows. Label zero is unused, so that it marks ignored pixels. </summary>
+			struct SBand
+			{
+				size_t nY0;
+				size_t nY1;
+
+				/// <summary>	The union-find parent of each label, which is never larger than the label. </summary>
+				std::vector<uint32_t> vecParent;
+				std::vector<SLabelStats> vecStats;
+
+				/// <summary>	The offset of the labels of the band in the labels of all bands. </summary>
+				uint32_t uOffset;
+			};
+
+			uint32_t _FindRoot(uint32_t* puParent, uint32_t uLabel)
+			{
+				while (puParent[uLabel] != uLabel)
+				{
+					// Path halving
+					puParent[uLabel] = puParent[puParent[uLabel]];
+					uLabel = puParent[uLabel];
+				}
+
+				return uLabel;
+			}
+
+			/// <summary>	Joins the sets of two labels under the smaller root, which is returned. </summary>
+			uint32_t _Unite(uint32_t* puParent, uint32_t uLabelA, uint32_t uLabelB)
+			{
+				uint32_t uRootA = _FindRoot(puParent, uLabelA);
+				uint32_t uRootB = _FindRoot(puParent, uLabelB);
+
+				if (uRootA > uRootB)
+				{
+					std::swap(uRootA, uRootB);
+				}
+
+				puParent[uRootB] = uRootA;
+				return uRootA;
+			}
+
+			/// <summary>	The signed type that holds the difference of two values. </summary>
+			template<typename TValue> struct SDifference { using Type = int32_t; };
+			template<> struct SDifference<int32_t> { using Type = int64_t; };
+			template<> struct SDifference<uint32_t> { using Type = int64_t; };
+			template<> struct SDifference<float> { using Type = double; };
+
+			/// <summary>	Decides which pixels are labeled and which neighbors are in the same component. </summary>
+			template<typename TValue>
+			struct SSimilarity
+			{
+				using TDiff = typename SDifference<TValue>::Type;
+
+				TDiff xMaxDifference;
+				bool bIgnoreInvalid;
+				TValue xInvalid;
+
+				SSimilarity(const SLabelConfig& xConfig)
+				{
+					if (!(xConfig.dMaxDifference >= 0.0))
+					{
+						throw CLU_EXCEPTION("Invalid maximal difference of neighbors");
+					}
+
+					// Integer differences up to the largest one of the type.
+					const double dMaxDifference = (std::numeric_limits<TDiff>::is_integer ? floor(std::min(xConfig.dMaxDifference
+						, double(std::numeric_limits<TDiff>::max() / 2))) : xConfig.dMaxDifference);
+
+					xMaxDifference = TDiff(dMaxDifference);
+					bIgnoreInvalid = xConfig.bIgnoreInvalid;
+					xInvalid = TValue(xConfig.bIgnoreInvalid ? xConfig.dInvalidValue : 0.0);
+
+					if (bIgnoreInvalid && double(xInvalid) != xConfig.dInvalidValue)
+					{
+						throw CLU_EXCEPTION("Invalid value is not a value of the image data type");
+					}
+				}
+
+				bool IsValid(TValue xValue) const
+				{
+					return !(bIgnoreInvalid && xValue == xInvalid);
+				}
+
+				bool IsSimilar(TValue xA, TValue xB) const
+				{
+					return (xA > xB ? TDiff(xA) - TDiff(xB) : TDiff(xB) - TDiff(xA)) <= xMaxDifference;
+				}
+			};
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	The first pass over a band. Each valid pixel joins the labels of its similar neighbors in the
+			/// 	current and the previous row of the band, or starts a new label. As the similarity of neighbors
+			/// 	is not transitive, all neighbors are joined and not only the first one.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TValue>
+			void _LabelBand(SBand& xBand, const SPlane& xLabel, const SPlane& xSrc, size_t nWidth
+				, const SSimilarity<TValue>& xSimilarity, bool bEight)
+			{
+				xBand.vecParent.assign(1, 0u);
+				xBand.vecStats.assign(1, SLabelStats(0, 0));
+
+				for (size_t nY = xBand.nY0; nY < xBand.nY1; ++nY)
+				{
+					const TValue* pSrc = xSrc.Row<const TValue>(nY);
+					uint32_t* puLabel = xLabel.Row<uint32_t>(nY);
+
+					const bool bUp = (nY > xBand.nY0);
+					const TValue* pUpSrc = (bUp ? xSrc.Row<const TValue>(nY - 1) : nullptr);
+					const uint32_t* puUpLabel = (bUp ? xLabel.Row<const uint32_t>(nY - 1) : nullptr);
+
+					for (size_t nX = 0; nX < nWidth; ++nX)
+					{
+						const TValue xValue = pSrc[nX];
+						if (!xSimilarity.IsValid(xValue))
+						{
+							puLabel[nX] = 0;
+							continue;
+						}
+
+						uint32_t uLabel = 0;
+						auto funcJoin = [&](uint32_t uNeighborLabel, TValue xNeighborValue)
+						{
+							if (uNeighborLabel == 0 || !xSimilarity.IsSimilar(xValue, xNeighborValue))
+							{
+								return;
+							}
+
+							if (uLabel == 0)
+							{
+								uLabel = uNeighborLabel;
+							}
+							else if (uLabel != uNeighborLabel)
+							{
+								uLabel = _Unite(xBand.vecParent.data(), uLabel, uNeighborLabel);
+							}
+						};
+
+						if (nX > 0)
+						{
+							funcJoin(puLabel[nX - 1], pSrc[nX - 1]);
+						}
+
+						if (bUp)
+						{
+							funcJoin(puUpLabel[nX], pUpSrc[nX]);
+
+							if (bEight)
+							{
+								if (nX > 0)
+								{
+									funcJoin(puUpLabel[nX - 1], pUpSrc[nX - 1]);
+								}
+
+								if (nX + 1 < nWidth)
+								{
+									funcJoin(puUpLabel[nX + 1], pUpSrc[nX + 1]);
+								}
+							}
+						}
+
+						if (uLabel == 0)
+						{
+							uLabel = uint32_t(xBand.vecParent.size());
+							xBand.vecParent.push_back(uLabel);
+							xBand.vecStats.push_back(SLabelStats(int(nX), int(nY)));
+						}
+						else
+						{
+							xBand.vecStats[uLabel].Add(int(nX), int(nY));
+						}
+
+						puLabel[nX] = uLabel;
+					}
+				}
+			}
+
+			/// <summary>	Joins the labels of the first row of a band with those of the last row of the band above. </summary>
+			template<typename TValue>
+			void _MergeBands(uint32_t* puParent, const SBand& xBand, const SBand& xUpBand, const SPlane& xLabel, const SPlane& xSrc
+				, size_t nWidth, const SSimilarity<TValue>& xSimilarity, bool bEight)
+			{
+				const TValue* pSrc = xSrc.Row<const TValue>(xBand.nY0);
+				const TValue* pUpSrc = xSrc.Row<const TValue>(xBand.nY0 - 1);
+				const uint32_t* puLabel = xLabel.Row<const uint32_t>(xBand.nY0);
+				const uint32_t* puUpLabel = xLabel.Row<const uint32_t>(xBand.nY0 - 1);
+
+				const size_t nReach = (bEight ? 1 : 0);
+
+				for (size_t nX = 0; nX < nWidth; ++nX)
+				{
+					if (puLabel[nX] == 0)
+					{
+						continue;
+					}
+
+					const size_t nUpX0 = (nX > nReach ? nX - nReach : 0);
+					const size_t nUpX1 = std::min(nX + nReach + 1, nWidth);
+					for (size_t nUpX = nUpX0; nUpX < nUpX1; ++nUpX)
+					{
+						if (puUpLabel[nUpX] != 0 && xSimilarity.IsSimilar(pSrc[nX], pUpSrc[nUpX]))
+						{
+							_Unite(puParent, xBand.uOffset + puLabel[nX], xUpBand.uOffset + puUpLabel[nUpX]);
+						}
+					}
+				}
+			}
+
+			template<typename TValue>
+			size_t _LabelPlane(const SPlane& xLabel, std::vector<SComponent>& vecComponent, const SPlane& xSrc
+				, size_t nWidth, size_t nHeight, const SLabelConfig& xConfig)
+			{
+				const SSimilarity<TValue> xSimilarity(xConfig);
+				const bool bEight = (xConfig.eConnectivity == EConnectivity::Eight);
+
+				const size_t nMinRows = std::max<size_t>(MinBlockPixelCount / nWidth, 1);
+				std::vector<SBand> vecBand(Clu::Parallel::BlockCount(nHeight, nMinRows));
+
+				Clu::Parallel::ForEachBlock(nHeight, nMinRows, [&](size_t nBegin, size_t nEnd, unsigned uBlockIdx)
+				{
+					SBand& xBand = vecBand[uBlockIdx];
+					xBand.nY0 = nBegin;
+					xBand.nY1 = nEnd;
+
+					_LabelBand(xBand, xLabel, xSrc, nWidth, xSimilarity, bEight);
+				});
+
+				// Concatenate the labels of the bands, which keeps the parents below their labels.
+				size_t nLabelCount = 1;
+				for (SBand& xBand : vecBand)
+				{
+					xBand.uOffset = uint32_t(nLabelCount - 1);
+					nLabelCount += xBand.vecParent.size() - 1;
+				}
+
+				std::vector<uint32_t> vecParent(nLabelCount);
+				vecParent[0] = 0;
+				for (const SBand& xBand : vecBand)
+				{
+					for (size_t nLabel = 1; nLabel < xBand.vecParent.size(); ++nLabel)
+					{
+						vecParent[xBand.uOffset + nLabel] = xBand.uOffset + xBand.vecParent[nLabel];
+					}
+				}
+
+				for (size_t nBand = 1; nBand < vecBand.size(); ++nBand)
+				{
+					_MergeBands(vecParent.data(), vecBand[nBand], vecBand[nBand - 1], xLabel, xSrc, nWidth, xSimilarity, bEight);
+				}
+
+				// Number the roots in increasing order and map every label to the number of its root, which has been
+				// numbered before, as the parent of a label is smaller than the label.
+				std::vector<SLabelStats> vecStats;
+				for (const SBand& xBand : vecBand)
+				{
+					for (size_t nLabel = 1; nLabel < xBand.vecParent.size(); ++nLabel)
+					{
+						const uint32_t uLabel = xBand.uOffset + uint32_t(nLabel);
+						const SLabelStats& xLabelStats = xBand.vecStats[nLabel];
+
+						if (vecParent[uLabel] == uLabel)
+						{
+							vecStats.push_back(xLabelStats);
+							vecParent[uLabel] = uint32_t(vecStats.size());
+						}
+						else
+						{
+							vecParent[uLabel] = vecParent[vecParent[uLabel]];
+							vecStats[vecParent[uLabel] - 1].Add(xLabelStats);
+						}
+					}
+				}
+
+				Clu::Parallel::ForEachBlock(nHeight, nMinRows, [&](size_t nBegin, size_t nEnd, unsigned uBlockIdx)
+				{
+					const uint32_t uOffset = vecBand[uBlockIdx].uOffset;
+
+					for (size_t nY = nBegin; nY < nEnd; ++nY)
+					{
+						uint32_t* puLabel = xLabel.Row<uint32_t>(nY);
+						for (size_t nX = 0; nX < nWidth; ++nX)
+						{
+							if (puLabel[nX] != 0)
+							{
+								puLabel[nX] = vecParent[uOffset + puLabel[nX]];
+							}
+						}
+					}
+				});
+
+				vecComponent.resize(vecStats.size());
+				for (size_t nComponent = 0; nComponent < vecStats.size(); ++nComponent)
+				{
+					const SLabelStats& xStats = vecStats[nComponent];
+					SComponent& xComponent = vecComponent[nComponent];
+
+					xComponent.uArea = xStats.uArea;
+					xComponent.iMinX = xStats.iMinX;
+					xComponent.iMinY = xStats.iMinY;
+					xComponent.iMaxX = xStats.iMaxX;
+					xComponent.iMaxY = xStats.iMaxY;
+					xComponent.dCentroidX = double(xStats.uSumX) / double(xStats.uArea);
+					xComponent.dCentroidY = double(xStats.uSumY) / double(xStats.uArea);
+				}
+
+				return vecComponent.size();
+			}
+
+			/// <summary>	Sets the pixels of the speckle labels to the invalid value and returns their number. </summary>
+			template<typename TValue>
+			size_t _RemoveSpeckles(const SPlane& xImage, const SPlane& xLabel, size_t nWidth, size_t nHeight
+				, const std::vector<uint8_t>& vecIsSpeckle, double dInvalidValue)
+			{
+				const TValue xInvalid = TValue(dInvalidValue);
+				const size_t nMinRows = std::max<size_t>(MinBlockPixelCount / nWidth, 1);
+				std::vector<size_t> vecRemoved(Clu::Parallel::BlockCount(nHeight, nMinRows), 0);
+
+				Clu::Parallel::ForEachBlock(nHeight, nMinRows, [&](size_t nBegin, size_t nEnd, unsigned uBlockIdx)
+				{
+					size_t nRemoved = 0;
+					for (size_t nY = nBegin; nY < nEnd; ++nY)
+					{
+						TValue* pValue = xImage.Row<TValue>(nY);
+						const uint32_t* puLabel = xLabel.Row<const uint32_t>(nY);
+
+						for (size_t nX = 0; nX < nWidth; ++nX)
+						{
+							if (vecIsSpeckle[puLabel[nX]])
+							{
+								pValue[nX] = xInvalid;
+								++nRemoved;
+							}
+						}
+					}
+
+					vecRemoved[uBlockIdx] = nRemoved;
+				});
+
+				size_t nRemoved = 0;
+				for (size_t nBlockRemoved : vecRemoved)
+				{
+					nRemoved += nBlockRemoved;
+				}
+
+				return nRemoved;
+			}
+		} // namespace
+
+		size_t LabelImage(CIImage& imgLabel, std::vector<SComponent>& vecComponent, const CIImage& imgSrc, const SLabelConfig& xConfig)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				const SImageFormat& xSrcFormat = imgSrc.Format();
+				if (SImageType::DimOf(xSrcFormat.ePixelType) != 1 || SImageType::IsBayerPixelType(xSrcFormat.ePixelType))
+				{
+					throw CLU_EXCEPTION("Labeling supports single channel images");
+				}
+
+				// The provisional labels of all pixels have to fit into 32 bit.
+				if (uint64_t(xSrcFormat.iWidth) * uint64_t(xSrcFormat.iHeight) >= uint64_t(std::numeric_limits<uint32_t>::max()))
+				{
+					throw CLU_EXCEPTION("Image is too large to be labeled");
+				}
+
+				if (imgLabel.IsValid() && ((const CIImage&)imgLabel).DataPointer() == imgSrc.DataPointer())
+				{
+					throw CLU_EXCEPTION("Label image must not be the source image");
+				}
+
+				imgLabel.Create(SImageFormat(xSrcFormat.iWidth, xSrcFormat.iHeight, EPixelType::Lum, EDataType::UInt32));
+				vecComponent.clear();
+
+				if (xSrcFormat.iWidth <= 0 || xSrcFormat.iHeight <= 0)
+				{
+					return 0;
+				}
+
+				const SPlane xLabel{ (unsigned char*)imgLabel.DataPointer(), imgLabel.Format().RowPitch() };
+				const SPlane xSrc{ (unsigned char*)imgSrc.DataPointer(), xSrcFormat.RowPitch() };
+				const size_t nWidth = size_t(xSrcFormat.iWidth);
+				const size_t nHeight = size_t(xSrcFormat.iHeight);
+
+				switch (xSrcFormat.eDataType)
+				{
+				case EDataType::Int8:
+					return _LabelPlane<int8_t>(xLabel, vecComponent, xSrc, nWidth, nHeight, xConfig);
+
+				case EDataType::UInt8:
+					return _LabelPlane<uint8_t>(xLabel, vecComponent, xSrc, nWidth, nHeight, xConfig);
+
+				case EDataType::Int16:
+					return _LabelPlane<int16_t>(xLabel, vecComponent, xSrc, nWidth, nHeight, xConfig);
+
+				case EDataType::UInt16:
+					return _LabelPlane<uint16_t>(xLabel, vecComponent, xSrc, nWidth, nHeight, xConfig);
+
+				case EDataType::Int32:
+					return _LabelPlane<int32_t>(xLabel, vecComponent, xSrc, nWidth, nHeight, xConfig);
+
+				case EDataType::UInt32:
+					return _LabelPlane<uint32_t>(xLabel, vecComponent, xSrc, nWidth, nHeight, xConfig);
+
+				case EDataType::Single:
+					return _LabelPlane<float>(xLabel, vecComponent, xSrc, nWidth, nHeight, xConfig);
+
+				default:
+					throw CLU_EXCEPTION("Unsupported image data type");
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error labeling image")
+		}
+
+		size_t RemoveSpeckles(CIImage& imgImage, const SLabelConfig& xConfig, size_t nMaxSpeckleArea)
+		{
+			try
+			{
+				if (!xConfig.bIgnoreInvalid)
+				{
+					throw CLU_EXCEPTION("Speckle removal needs an invalid value");
+				}
+
+				CIImage imgLabel;
+				std::vector<SComponent> vecComponent;
+				LabelImage(imgLabel, vecComponent, imgImage, xConfig);
+
+				// Label zero marks the invalid pixels, which stay as they are.
+				std::vector<uint8_t> vecIsSpeckle(vecComponent.size() + 1, 0);
+				bool bHasSpeckle = false;
+				for (size_t nComponent = 0; nComponent < vecComponent.size(); ++nComponent)
+				{
+					if (vecComponent[nComponent].uArea <= nMaxSpeckleArea)
+					{
+						vecIsSpeckle[nComponent + 1] = 1;
+						bHasSpeckle = true;
+					}
+				}
+
+				if (!bHasSpeckle)
+				{
+					return 0;
+				}
+
+				const SImageFormat& xFormat = imgImage.Format();
+				const SPlane xImage{ (unsigned char*)imgImage.DataPointer(), xFormat.RowPitch() };
+				const SPlane xLabel{ (unsigned char*)imgLabel.DataPointer(), imgLabel.Format().RowPitch() };
+				const size_t nWidth = size_t(xFormat.iWidth);
+				const size_t nHeight = size_t(xFormat.iHeight);
+
+				switch (xFormat.eDataType)
+				{
+				case EDataType::Int8:
+					return _RemoveSpeckles<int8_t>(xImage, xLabel, nWidth, nHeight, vecIsSpeckle, xConfig.dInvalidValue);
+
+				case EDataType::UInt8:
+					return _RemoveSpeckles<uint8_t>(xImage, xLabel, nWidth, nHeight, vecIsSpeckle, xConfig.dInvalidValue);
+
+				case EDataType::Int16:
+					return _RemoveSpeckles<int16_t>(xImage, xLabel, nWidth, nHeight, vecIsSpeckle, xConfig.dInvalidValue);
+
+				case EDataType::UInt16:
+					return _RemoveSpeckles<uint16_t>(xImage, xLabel, nWidth, nHeight, vecIsSpeckle, xConfig.dInvalidValue);
+
+				case EDataType::Int32:
+					return _RemoveSpeckles<int32_t>(xImage, xLabel, nWidth, nHeight, vecIsSpeckle, xConfig.dInvalidValue);
+
+				case EDataType::UInt32:
+					return _RemoveSpeckles<uint32_t>(xImage, xLabel, nWidth, nHeight, vecIsSpeckle, xConfig.dInvalidValue);
+
+				case EDataType::Single:
+					return _RemoveSpeckles<float>(xImage, xLabel, nWidth, nHeight, vecIsSpeckle, xConfig.dInvalidValue);
+
+				default:
+					throw CLU_EXCEPTION("Unsupported image data type");
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error removing speckles")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Label.h
+//
+// summary:   Declares the connected components labeling and the speckle filter
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "CluTec.Types1/IImage.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		/// <summary>	The neighbors a pixel is connected to. </summary>
+		enum class EConnectivity
+		{
+			/// <summary>	The left, right, upper and lower neighbor. </summary>
+			Four = 0,
+
+			/// <summary>	The four neighbors and the four diagonal neighbors. </summary>
+			Eight,
+		};
+
+		/// <summary>	Configures the connected components labeling. </summary>
+		struct SLabelConfig
+		{
+			EConnectivity eConnectivity;
+
+			/// <summary>
+			/// 	Neighbors are in the same component if their values differ by at most dMaxDifference. With zero
+			/// 	only equal values are joined. For disparity images a small difference joins the pixels of a
+			/// 	surface, whose disparities change smoothly.
+			/// </summary>
+			double dMaxDifference;
+
+			/// <summary>	True to leave out the pixels of dInvalidValue, which get the label zero. </summary>
+			bool bIgnoreInvalid;
+			double dInvalidValue;
+
+			SLabelConfig(EConnectivity _eConnectivity = EConnectivity::Four, double _dMaxDifference = 0.0)
+				: eConnectivity(_eConnectivity)
+				, dMaxDifference(_dMaxDifference)
+				, bIgnoreInvalid(false)
+				, dInvalidValue(0.0)
+			{
+			}
+
+			SLabelConfig(EConnectivity _eConnectivity, double _dMaxDifference, double _dInvalidValue)
+				: eConnectivity(_eConnectivity)
+				, dMaxDifference(_dMaxDifference)
+				, bIgnoreInvalid(true)
+				, dInvalidValue(_dInvalidValue)
+			{
+			}
+		};
+
+		/// <summary>	The statistics of a connected component. </summary>
+		struct SComponent
+		{
+			/// <summary>	The number of pixels. </summary>
+			uint64_t uArea;
+
+			/// <summary>	The bounding box, including the maximal coordinates. </summary>
+			int iMinX;
+			int iMinY;
+			int iMaxX;
+			int iMaxY;
+
+			double dCentroidX;
+			double dCentroidY;
+
+			SComponent()
+				: uArea(0)
+				, iMinX(0)
+				, iMinY(0)
+				, iMaxX(0)
+				, iMaxY(0)
+				, dCentroidX(0.0)
+				, dCentroidY(0.0)
+			{
+			}
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Labels the connected components of a single channel image with two passes and union-find. Bands of
+		/// 	rows are labeled in parallel, each with its own provisional labels, equivalences and component
+		/// 	statistics. The equivalences across the band borders are merged afterwards, and a second parallel
+		/// 	pass writes the final labels. The components are numbered from 1 in the order of their first pixel
+		/// 	in row order. Int8, UInt8, Int16, UInt16, Int32, UInt32 and Single images are supported.
+		/// </summary>
+		///
+		/// <param name="imgLabel">	   	The label image, which is created as Lum UInt32 image of the size of the
+		/// 							source. Ignored pixels have the label zero. </param>
+		/// <param name="vecComponent">	The statistics of the components, where entry i belongs to label i + 1. </param>
+		/// <param name="imgSrc">	   	The image. </param>
+		/// <param name="xConfig">	   	The labeling configuration. </param>
+		///
+		/// <returns>	The number of components. </returns>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		size_t LabelImage(CIImage& imgLabel, std::vector<SComponent>& vecComponent, const CIImage& imgSrc, const SLabelConfig& xConfig);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Removes speckles in place, that is components of at most nMaxSpeckleArea pixels, by setting their
+		/// 	pixels to the invalid value of the configuration. Pixels of the invalid value are no part of any
+		/// 	component. This is the usual post processing of disparity images, with a maximal difference of
+		/// 	about one disparity.
+		/// </summary>
+		///
+		/// <param name="imgImage">		  	The image, which is changed in place. </param>
+		/// <param name="xConfig">		  	The labeling configuration. It has to define an invalid value. </param>
+		/// <param name="nMaxSpeckleArea">	The maximal area of a speckle in pixels. </param>
+		///
+		/// <returns>	The number of removed pixels. </returns>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		size_t RemoveSpeckles(CIImage& imgImage, const SLabelConfig& xConfig, size_t nMaxSpeckleArea);
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,862 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Median.cpp
+//
+// summary:   Implements the median filter
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "Image.Median.h"
+
+#include "CluTec.Types1/ImageMemory.h"
+#include "CluTec.Types1/ImageType.h"
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	The width of the column strips of the sorting network and selection paths. </summary>
+			const size_t StripWidth = 256;
+
+			/// <summary>	The bytes of the column histograms of one strip of the histogram path. </summary>
+			const size_t HistogramStripBytes = size_t(8) << 20;
+
+			/// <summary>	The minimal width of the column strips of the histogram path. </summary>
+			const size_t MinHistogramStripWidth = 32;
+
+			/// <summary>
+			/// 	The counts added to each column histogram, so that the histograms of neighboring columns do not
+			/// 	start at the same offset of a 4 KB page, which makes loads wait for unrelated stores.
+			/// </summary>
+			const size_t ColumnPadding = 32;
+
+			/// <summary>	Marks a part of a fine histogram that has to be rebuilt. </summary>
+			const ptrdiff_t NoFineX = -1;
+
+			/// <summary>	One memory plane of an image. </summary>
+			struct SPlane
+			{
+				unsigned char* pucData;
+				size_t nRowPitch;
+			};
+
+			template<typename TValue>
+			const TValue* _SrcRow(const SPlane& xPlane, size_t nY)
+			{
+				return (const TValue*)(xPlane.pucData + nY * xPlane.nRowPitch);
+			}
+
+			template<typename TValue>
+			TValue* _TrgRow(const SPlane& xPlane, size_t nY)
+			{
+				return (TValue*)(xPlane.pucData + nY * xPlane.nRowPitch);
+			}
+
+			/// <summary>	The value of the pixels to leave out. </summary>
+			template<typename TValue>
+			struct SInvalid
+			{
+				bool bIgnore;
+				TValue xValue;
+
+				bool IsInvalid(TValue xPixel) const
+				{
+					return bIgnore && xPixel == xValue;
+				}
+			};
+
+			/// <summary>	The SSE2 operations of the sorting networks on vectors of a value type. </summary>
+			template<typename TValue> struct SMedianLane;
+
+			template<> struct SMedianLane<uint8_t>
+			{
+				using TValue = uint8_t;
+				using TVec = __m128i;
+				static const size_t Count = 16;
+
+				static TVec Load(const TValue* pSrc)
+				{
+					return _mm_loadu_si128((const __m128i*)pSrc);
+				}
+
+				static void Store(TValue* pTrg, TVec mValue)
+				{
+					_mm_storeu_si128((__m128i*)pTrg, mValue);
+				}
+
+				static TVec Min(TVec mA, TVec mB)
+				{
+					return _mm_min_epu8(mA, mB);
+				}
+
+				static TVec Max(TVec mA, TVec mB)
+				{
+					return _mm_max_epu8(mA, mB);
+				}
+
+				static TVec Equal(TVec mA, TVec mB)
+				{
+					return _mm_cmpeq_epi8(mA, mB);
+				}
+
+				static TVec Select(TVec mMask, TVec mA, TVec mB)
+				{
+					return _mm_or_si128(_mm_and_si128(mMask, mA), _mm_andnot_si128(mMask, mB));
+				}
+
+				static TVec Xor(TVec mA, TVec mB)
+				{
+					return _mm_xor_si128(mA, mB);
+				}
+
+				static TVec Set(TValue xValue)
+				{
+					return _mm_set1_epi8(char(xValue));
+				}
+			};
+
+			/// <summary>	The values are kept with the sign bit flipped, as SSE2 only compares signed 16 bit values. </summary>
+			template<> struct SMedianLane<uint16_t>
+			{
+				using TValue = uint16_t;
+				using TVec = __m128i;
+				static const size_t Count = 8;
+
+				static TVec Load(const TValue* pSrc)
+				{
+					return _mm_xor_si128(_mm_loadu_si128((const __m128i*)pSrc), _mm_set1_epi16(short(0x8000)));
+				}
+
+				static void Store(TValue* pTrg, TVec mValue)
+				{
+					_mm_storeu_si128((__m128i*)pTrg, _mm_xor_si128(mValue, _mm_set1_epi16(short(0x8000))));
+				}
+
+				static TVec Min(TVec mA, TVec mB)
+				{
+					return _mm_min_epi16(mA, mB);
+				}
+
+				static TVec Max(TVec mA, TVec mB)
+				{
+					return _mm_max_epi16(mA, mB);
+				}
+
+				static TVec Equal(TVec mA, TVec mB)
+				{
+					return _mm_cmpeq_epi16(mA, mB);
+				}
+
+				static TVec Select(TVec mMask, TVec mA, TVec mB)
+				{
+					return _mm_or_si128(_mm_and_si128(mMask, mA), _mm_andnot_si128(mMask, mB));
+				}
+
+				static TVec Xor(TVec mA, TVec mB)
+				{
+					return _mm_xor_si128(mA, mB);
+				}
+
+				static TVec Set(TValue xValue)
+				{
+					return _mm_set1_epi16(short(xValue ^ 0x8000));
+				}
+			};
+
+			template<> struct SMedianLane<float>
+			{
+				using TValue = float;
+				using TVec = __m128;
+				static const size_t Count = 4;
+
+				static TVec Load(const TValue* pSrc)
+				{
+					return _mm_loadu_ps(pSrc);
+				}
+
+				static void Store(TValue* pTrg, TVec mValue)
+				{
+					_mm_storeu_ps(pTrg, mValue);
+				}
+
+				static TVec Min(TVec mA, TVec mB)
+				{
+					return _mm_min_ps(mA, mB);
+				}
+
+				static TVec Max(TVec mA, TVec mB)
+				{
+					return _mm_max_ps(mA, mB);
+				}
+
+				static TVec Equal(TVec mA, TVec mB)
+				{
+					return _mm_cmpeq_ps(mA, mB);
+				}
+
+				static TVec Select(TVec mMask, TVec mA, TVec mB)
+				{
+					return _mm_or_ps(_mm_and_ps(mMask, mA), _mm_andnot_ps(mMask, mB));
+				}
+
+				static TVec Xor(TVec mA, TVec mB)
+				{
+					return _mm_xor_ps(mA, mB);
+				}
+
+				static TVec Set(TValue xValue)
+				{
+					return _mm_set1_ps(xValue);
+				}
+			};
+
+			/// <summary>	The comparators of the median of 9 values, which ends up in value 4 (Paeth / Devillard). </summary>
+			const uint8_t Median9Network[][2] =
+			{
+				{ 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 1 }, { 3, 4 }, { 6, 7 }, { 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 3 },
+				{ 5, 8 }, { 4, 7 }, { 3, 6 }, { 1, 4 }, { 2, 5 }, { 4, 7 }, { 4, 2 }, { 6, 4 }, { 4, 2 },
+			};
+
+			/// <summary>	The comparators of the median of 25 values, which ends up in value 12 (Devillard). </summary>
+			const uint8_t Median25Network[][2] =
+			{
+				{ 0, 1 }, { 3, 4 }, { 2, 4 }, { 2, 3 }, { 6, 7 }, { 5, 7 }, { 5, 6 }, { 9, 10 }, { 8, 10 }, { 8, 9 },
+				{ 12, 13 }, { 11, 13 }, { 11, 12 }, { 15, 16 }, { 14, 16 }, { 14, 15 }, { 18, 19 }, { 17, 19 }, { 17, 18 }, { 21, 22 },
+				{ 20, 22 }, { 20, 21 }, { 23, 24 }, { 2, 5 }, { 3, 6 }, { 0, 6 }, { 0, 3 }, { 4, 7 }, { 1, 7 }, { 1, 4 },
+				{ 11, 14 }, { 8, 14 }, { 8, 11 }, { 12, 15 }, { 9, 15 }, { 9, 12 }, { 13, 16 }, { 10, 16 }, { 10, 13 }, { 20, 23 },
+				{ 17, 23 }, { 17, 20 }, { 21, 24 }, { 18, 24 }, { 18, 21 }, { 19, 22 }, { 8, 17 }, { 9, 18 }, { 0, 18 }, { 0, 9 },
+				{ 10, 19 }, { 1, 19 }, { 1, 10 }, { 11, 20 }, { 2, 20 }, { 2, 11 }, { 12, 21 }, { 3, 21 }, { 3, 12 }, { 13, 22 },
+				{ 4, 22 }, { 4, 13 }, { 14, 23 }, { 5, 23 }, { 5, 14 }, { 15, 24 }, { 6, 24 }, { 6, 15 }, { 7, 16 }, { 7, 19 },
+				{ 13, 21 }, { 15, 23 }, { 7, 13 }, { 7, 15 }, { 1, 9 }, { 3, 11 }, { 5, 17 }, { 11, 17 }, { 9, 17 }, { 4, 10 },
+				{ 6, 12 }, { 7, 14 }, { 4, 6 }, { 4, 7 }, { 12, 14 }, { 10, 14 }, { 6, 7 }, { 10, 12 }, { 6, 10 }, { 6, 17 },
+				{ 12, 17 }, { 7, 17 }, { 7, 10 }, { 12, 18 }, { 7, 12 }, { 10, 18 }, { 12, 20 }, { 10, 20 }, { 10, 12 },
+			};
+
+			/// <summary>	Applies the comparators of a network, which move the smaller value to the first index. </summary>
+			template<typename TLane, size_t PairCount>
+			void _SortNetwork(typename TLane::TVec* pmValue, const uint8_t (&pPair)[PairCount][2])
+			{
+				using TVec = typename TLane::TVec;
+
+				for (size_t nPair = 0; nPair < PairCount; ++nPair)
+				{
+					TVec& mA = pmValue[pPair[nPair][0]];
+					TVec& mB = pmValue[pPair[nPair][1]];
+
+					const TVec mMin = TLane::Min(mA, mB);
+					mB = TLane::Max(mA, mB);
+					mA = mMin;
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Selects the median of the valid values of the window of a pixel, clipped at the image border.
+			/// 	pBuffer takes the values of a whole window.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TValue>
+			TValue _SelectMedian(TValue* pBuffer, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nX, size_t nY
+				, size_t nRadius, const SInvalid<TValue>& xInvalid)
+			{
+				if (xInvalid.IsInvalid(_SrcRow<TValue>(xSrc, nY)[nX]))
+				{
+					return xInvalid.xValue;
+				}
+
+				const size_t nX0 = (nX > nRadius ? nX - nRadius : 0);
+				const size_t nX1 = std::min(nX + nRadius + 1, nWidth);
+				const size_t nY0 = (nY > nRadius ? nY - nRadius : 0);
+				const size_t nY1 = std::min(nY + nRadius + 1, nHeight);
+
+				size_t nCount = 0;
+				for (size_t nWinY = nY0; nWinY < nY1; ++nWinY)
+				{
+					const TValue* pSrc = _SrcRow<TValue>(xSrc, nWinY);
+					for (size_t nWinX = nX0; nWinX < nX1; ++nWinX)
+					{
+						if (!xInvalid.IsInvalid(pSrc[nWinX]))
+						{
+							pBuffer[nCount++] = pSrc[nWinX];
+						}
+					}
+				}
+
+				if (nCount == 0)
+				{
+					return xInvalid.xValue;
+				}
+
+				TValue* pMedian = pBuffer + (nCount - 1) / 2;
+				std::nth_element(pBuffer, pMedian, pBuffer + nCount);
+				return *pMedian;
+			}
+
+			/// <summary>	Filters a column strip by selecting the median of each pixel. </summary>
+			template<typename TValue>
+			void _SelectionStrip(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nRadius
+				, const SInvalid<TValue>& xInvalid, size_t nX0, size_t nX1, TValue* pBuffer)
+			{
+				for (size_t nY = 0; nY < nHeight; ++nY)
+				{
+					TValue* pTrg = _TrgRow<TValue>(xTrg, nY);
+					for (size_t nX = nX0; nX < nX1; ++nX)
+					{
+						pTrg[nX] = _SelectMedian(pBuffer, xSrc, nWidth, nHeight, nX, nY, nRadius, xInvalid);
+					}
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Filters a column strip with the sorting network of the radius 1 or 2. The windows of TLane::Count
+			/// 	neighboring pixels are loaded as vectors and sorted at once. Pixels whose window is clipped select
+			/// 	their median.
+			///
+			/// 	Of k invalid values of a window, the first (k + 1) / 2 are replaced by the smallest value of the
+			/// 	type and the others by the largest. The lower median of the valid values is then at the center of
+			/// 	the sorted window, and pixels with a valid center always have a valid value in their window.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TLane>
+			void _NetworkStrip(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nRadius
+				, const SInvalid<typename TLane::TValue>& xInvalid, size_t nX0, size_t nX1, typename TLane::TValue* pBuffer)
+			{
+				using TValue = typename TLane::TValue;
+				using TVec = typename TLane::TVec;
+				const size_t nLaneCount = TLane::Count;
+				const size_t nSize = 2 * nRadius + 1;
+
+				const TVec mInvalid = TLane::Set(xInvalid.xValue);
+				const TVec mLowest = TLane::Set(std::numeric_limits<TValue>::lowest());
+				const TVec mHighest = TLane::Set(std::numeric_limits<TValue>::max());
+
+				const size_t nInnerBegin = std::max(nX0, nRadius);
+				const size_t nInnerEnd = (nWidth > 2 * nRadius ? std::min(nX1, nWidth - nRadius) : 0);
+
+				for (size_t nY = 0; nY < nHeight; ++nY)
+				{
+					TValue* pTrg = _TrgRow<TValue>(xTrg, nY);
+					size_t nX = nX0;
+
+					if (nY >= nRadius && nY + nRadius < nHeight && nInnerBegin < nInnerEnd)
+					{
+						for (; nX < nInnerBegin; ++nX)
+						{
+							pTrg[nX] = _SelectMedian(pBuffer, xSrc, nWidth, nHeight, nX, nY, nRadius, xInvalid);
+						}
+
+						for (; nX + nLaneCount <= nInnerEnd; nX += nLaneCount)
+						{
+							TVec pmValue[25];
+							for (size_t nWinY = 0; nWinY < nSize; ++nWinY)
+							{
+								const TValue* pSrc = _SrcRow<TValue>(xSrc, nY + nWinY - nRadius) + nX - nRadius;
+								for (size_t nWinX = 0; nWinX < nSize; ++nWinX)
+								{
+									pmValue[nWinY * nSize + nWinX] = TLane::Load(pSrc + nWinX);
+								}
+							}
+
+							const size_t nCenter = nSize * nSize / 2;
+							const TVec mCenterInvalid = TLane::Equal(pmValue[nCenter], mInvalid);
+
+							if (xInvalid.bIgnore)
+							{
+								TVec mHigh = TLane::Xor(mInvalid, mInvalid);
+								for (size_t nIdx = 0; nIdx < nSize * nSize; ++nIdx)
+								{
+									const TVec mIsInvalid = TLane::Equal(pmValue[nIdx], mInvalid);
+									pmValue[nIdx] = TLane::Select(mIsInvalid, TLane::Select(mHigh, mHighest, mLowest), pmValue[nIdx]);
+									mHigh = TLane::Xor(mHigh, mIsInvalid);
+								}
+							}
+
+							if (nRadius == 1)
+							{
+								_SortNetwork<TLane>(pmValue, Median9Network);
+							}
+							else
+							{
+								_SortNetwork<TLane>(pmValue, Median25Network);
+							}
+
+							TLane::Store(pTrg + nX, (xInvalid.bIgnore ? TLane::Select(mCenterInvalid, mInvalid, pmValue[nCenter]) : pmValue[nCenter]));
+						}
+					}
+
+					for (; nX < nX1; ++nX)
+					{
+						pTrg[nX] = _SelectMedian(pBuffer, xSrc, nWidth, nHeight, nX, nY, nRadius, xInvalid);
+					}
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	The constant time median of Perreault and Hebert. Each column of a strip keeps the histogram of
+			/// 	its pixels in the rows of the window, which moves down by adding one row and removing another.
+			/// 	The histogram of the window moves right by adding one column histogram and removing another.
+			///
+			/// 	The histograms have two levels. The coarse level counts the values by their upper bits and is
+			/// 	kept up to date. The fine level counts all values, and the part of it that belongs to a coarse bin
+			/// 	is only brought up to date when the median is searched in this coarse bin, which for smooth
+			/// 	images are only a few bins.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TValue>
+			class CHistogramMedian
+			{
+			public:
+				CHistogramMedian(size_t nWidth, size_t nHeight, size_t nRadius, unsigned uBitCount, size_t nStripWidth
+					, const SInvalid<TValue>& xInvalid)
+					: m_nWidth(nWidth)
+					, m_nHeight(nHeight)
+					, m_nRadius(nRadius)
+					, m_uFineBits(uBitCount - uBitCount / 2)
+					, m_nFineCount(size_t(1) << (uBitCount - uBitCount / 2))
+					, m_nCoarseCount(size_t(1) << (uBitCount / 2))
+					, m_nColumnStride((size_t(1) << uBitCount) + ColumnPadding)
+					, m_xInvalid(xInvalid)
+				{
+					const size_t nColumnCount = std::min(nStripWidth + 2 * nRadius, nWidth);
+
+					m_vecColumnFine.resize(nColumnCount * m_nColumnStride);
+					m_vecColumnCoarse.resize(nColumnCount * m_nCoarseCount);
+					m_vecColumnCount.resize(nColumnCount);
+					m_vecFine.resize(m_nCoarseCount * m_nFineCount);
+					m_vecCoarse.resize(m_nCoarseCount);
+					m_vecFineX.resize(m_nCoarseCount);
+				}
+
+				/// <summary>	Filters the columns [nX0, nX1). </summary>
+				void Run(const SPlane& xTrg, const SPlane& xSrc, size_t nX0, size_t nX1)
+				{
+					m_nColumn0 = (nX0 > m_nRadius ? nX0 - m_nRadius : 0);
+					m_nColumn1 = std::min(nX1 + m_nRadius, m_nWidth);
+
+					std::fill(m_vecColumnFine.begin(), m_vecColumnFine.end(), uint16_t(0));
+					std::fill(m_vecColumnCoarse.begin(), m_vecColumnCoarse.end(), uint16_t(0));
+					std::fill(m_vecColumnCount.begin(), m_vecColumnCount.end(), 0u);
+
+					for (size_t nY = 0; nY < std::min(m_nRadius, m_nHeight); ++nY)
+					{
+						_AddRow(_SrcRow<TValue>(xSrc, nY), 1);
+					}
+
+					for (size_t nY = 0; nY < m_nHeight; ++nY)
+					{
+						if (nY + m_nRadius < m_nHeight)
+						{
+							_AddRow(_SrcRow<TValue>(xSrc, nY + m_nRadius), 1);
+						}
+
+						if (nY > m_nRadius)
+						{
+							_AddRow(_SrcRow<TValue>(xSrc, nY - m_nRadius - 1), -1);
+						}
+
+						_FilterRow(_TrgRow<TValue>(xTrg, nY), _SrcRow<TValue>(xSrc, nY), nX0, nX1);
+					}
+				}
+
+			protected:
+				void _AddRow(const TValue* pSrc, int iDelta)
+				{
+					const uint16_t uDelta = uint16_t(iDelta);
+					for (size_t nColumn = m_nColumn0; nColumn < m_nColumn1; ++nColumn)
+					{
+						const TValue xValue = pSrc[nColumn];
+						if (m_xInvalid.IsInvalid(xValue))
+						{
+							continue;
+						}
+
+						const size_t nLocal = nColumn - m_nColumn0;
+						m_vecColumnFine[nLocal * m_nColumnStride + size_t(xValue)] += uDelta;
+						m_vecColumnCoarse[nLocal * m_nCoarseCount + (size_t(xValue) >> m_uFineBits)] += uDelta;
+						m_vecColumnCount[nLocal] += unsigned(iDelta);
+					}
+				}
+
+				/// <summary>	Adds or subtracts nCount counts, a multiple of 8. </summary>
+				static void _AddCounts(uint16_t* pTrg, const uint16_t* pSrc, size_t nCount, bool bAdd)
+				{
+					for (size_t nIdx = 0; nIdx < nCount; nIdx += 8)
+					{
+						const __m128i mTrg = _mm_loadu_si128((const __m128i*)(pTrg + nIdx));
+						const __m128i mSrc = _mm_loadu_si128((const __m128i*)(pSrc + nIdx));
+						_mm_storeu_si128((__m128i*)(pTrg + nIdx), (bAdd ? _mm_add_epi16(mTrg, mSrc) : _mm_sub_epi16(mTrg, mSrc)));
+					}
+				}
+
+				////////////////////////////////////////////////////////////////////////////////////////////////////
+				/// <summary>
+				/// 	Finds the bin of the value of rank nRank, where nBelow counts the values below pCount. Blocks of
+				/// 	8 bins are skipped by their sum, which the histogram is a multiple of.
+				/// </summary>
+				////////////////////////////////////////////////////////////////////////////////////////////////////
+				static size_t _FindRank(const uint16_t* pCount, size_t nRank, size_t& nBelow)
+				{
+					size_t nBin = 0;
+					for (;; nBin += 8)
+					{
+						const __m128i mCount = _mm_loadu_si128((const __m128i*)(pCount + nBin));
+						__m128i mSum = _mm_add_epi32(_mm_unpacklo_epi16(mCount, _mm_setzero_si128()), _mm_unpackhi_epi16(mCount, _mm_setzero_si128()));
+						mSum = _mm_add_epi32(mSum, _mm_shuffle_epi32(mSum, _MM_SHUFFLE(1, 0, 3, 2)));
+						mSum = _mm_add_epi32(mSum, _mm_shuffle_epi32(mSum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+						const size_t nSum = size_t(_mm_cvtsi128_si32(mSum));
+						if (nBelow + nSum > nRank)
+						{
+							break;
+						}
+
+						nBelow += nSum;
+					}
+
+					while (nBelow + pCount[nBin] <= nRank)
+					{
+						nBelow += pCount[nBin++];
+					}
+
+					return nBin;
+				}
+
+				void _AddColumnCoarse(size_t nColumn, bool bAdd)
+				{
+					const size_t nLocal = nColumn - m_nColumn0;
+					_AddCounts(m_vecCoarse.data(), m_vecColumnCoarse.data() + nLocal * m_nCoarseCount, m_nCoarseCount, bAdd);
+
+					m_nCount = (bAdd ? m_nCount + m_vecColumnCount[nLocal] : m_nCount - m_vecColumnCount[nLocal]);
+				}
+
+				void _AddColumnFine(size_t nColumn, size_t nCoarse, bool bAdd)
+				{
+					const size_t nLocal = nColumn - m_nColumn0;
+					_AddCounts(m_vecFine.data() + nCoarse * m_nFineCount
+						, m_vecColumnFine.data() + nLocal * m_nColumnStride + nCoarse * m_nFineCount, m_nFineCount, bAdd);
+				}
+
+				/// <summary>	Brings the fine histogram of a coarse bin to the window of column nX. </summary>
+				void _UpdateFine(size_t nCoarse, size_t nX)
+				{
+					const ptrdiff_t iFineX = m_vecFineX[nCoarse];
+					const size_t nSize = 2 * m_nRadius + 1;
+
+					if (iFineX == NoFineX || 2 * (nX - size_t(iFineX)) > nSize)
+					{
+						std::fill(m_vecFine.begin() + nCoarse * m_nFineCount, m_vecFine.begin() + (nCoarse + 1) * m_nFineCount, uint16_t(0));
+
+						const size_t nBegin = (nX > m_nRadius ? nX - m_nRadius : 0);
+						const size_t nEnd = std::min(nX + m_nRadius + 1, m_nWidth);
+						for (size_t nColumn = nBegin; nColumn < nEnd; ++nColumn)
+						{
+							_AddColumnFine(nColumn, nCoarse, true);
+						}
+					}
+					else
+					{
+						for (size_t nStep = size_t(iFineX) + 1; nStep <= nX; ++nStep)
+						{
+							if (nStep + m_nRadius < m_nWidth)
+							{
+								_AddColumnFine(nStep + m_nRadius, nCoarse, true);
+							}
+
+							if (nStep > m_nRadius)
+							{
+								_AddColumnFine(nStep - m_nRadius - 1, nCoarse, false);
+							}
+						}
+					}
+
+					m_vecFineX[nCoarse] = ptrdiff_t(nX);
+				}
+
+				void _FilterRow(TValue* pTrg, const TValue* pSrc, size_t nX0, size_t nX1)
+				{
+					std::fill(m_vecCoarse.begin(), m_vecCoarse.end(), uint16_t(0));
+					std::fill(m_vecFineX.begin(), m_vecFineX.end(), NoFineX);
+					m_nCount = 0;
+
+					const size_t nBegin = (nX0 > m_nRadius ? nX0 - m_nRadius : 0);
+					const size_t nEnd = std::min(nX0 + m_nRadius + 1, m_nWidth);
+					for (size_t nColumn = nBegin; nColumn < nEnd; ++nColumn)
+					{
+						_AddColumnCoarse(nColumn, true);
+					}
+
+					for (size_t nX = nX0; nX < nX1; ++nX)
+					{
+						if (nX > nX0)
+						{
+							if (nX + m_nRadius < m_nWidth)
+							{
+								_AddColumnCoarse(nX + m_nRadius, true);
+							}
+
+							if (nX > m_nRadius)
+							{
+								_AddColumnCoarse(nX - m_nRadius - 1, false);
+							}
+						}
+
+						if (m_nCount == 0 || m_xInvalid.IsInvalid(pSrc[nX]))
+						{
+							pTrg[nX] = m_xInvalid.xValue;
+							continue;
+						}
+
+						const size_t nRank = (m_nCount - 1) / 2;
+						size_t nBelow = 0;
+						const size_t nCoarse = _FindRank(m_vecCoarse.data(), nRank, nBelow);
+
+						_UpdateFine(nCoarse, nX);
+
+						const size_t nFine = _FindRank(m_vecFine.data() + nCoarse * m_nFineCount, nRank, nBelow);
+
+						pTrg[nX] = TValue((nCoarse << m_uFineBits) | nFine);
+					}
+				}
+
+			protected:
+				size_t m_nWidth;
+				size_t m_nHeight;
+				size_t m_nRadius;
+				unsigned m_uFineBits;
+				size_t m_nFineCount;
+				size_t m_nCoarseCount;
+				size_t m_nColumnStride;
+				SInvalid<TValue> m_xInvalid;
+
+				/// <summary>	The columns [m_nColumn0, m_nColumn1) of the current strip. </summary>
+				size_t m_nColumn0;
+				size_t m_nColumn1;
+
+				std::vector<uint16_t> m_vecColumnFine;
+				std::vector<uint16_t> m_vecColumnCoarse;
+				std::vector<unsigned> m_vecColumnCount;
+
+				/// <summary>	The histograms of the window, and the column each part of the fine one is up to date for. </summary>
+				std::vector<uint16_t> m_vecFine;
+				std::vector<uint16_t> m_vecCoarse;
+				std::vector<ptrdiff_t> m_vecFineX;
+				size_t m_nCount;
+			};
+
+			/// <summary>	The number of bits of the largest valid value, at least 8. </summary>
+			template<typename TValue>
+			unsigned _BitCount(const SPlane& xSrc, size_t nWidth, size_t nHeight, const SInvalid<TValue>& xInvalid)
+			{
+				unsigned uMax = 0;
+				for (size_t nY = 0; nY < nHeight; ++nY)
+				{
+					const TValue* pSrc = _SrcRow<TValue>(xSrc, nY);
+					for (size_t nX = 0; nX < nWidth; ++nX)
+					{
+						if (!xInvalid.IsInvalid(pSrc[nX]))
+						{
+							uMax = std::max(uMax, unsigned(pSrc[nX]));
+						}
+					}
+				}
+
+				unsigned uBitCount = 8;
+				while ((uMax >> uBitCount) != 0)
+				{
+					++uBitCount;
+				}
+
+				return uBitCount;
+			}
+
+			template<typename TValue>
+			void _MedianHistogram(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nRadius
+				, const SInvalid<TValue>& xInvalid)
+			{
+				const unsigned uBitCount = _BitCount(xSrc, nWidth, nHeight, xInvalid);
+
+				// Strips as wide as the memory of the column histograms allows, but at least one per thread.
+				const size_t nColumnBytes = (size_t(1) << uBitCount) * sizeof(uint16_t);
+				size_t nStripWidth = HistogramStripBytes / nColumnBytes;
+				nStripWidth = std::max(nStripWidth > 2 * nRadius ? nStripWidth - 2 * nRadius : 0, MinHistogramStripWidth);
+				nStripWidth = std::min(nStripWidth, (nWidth + Clu::Parallel::ThreadCount() - 1) / Clu::Parallel::ThreadCount());
+
+				const size_t nStripCount = (nWidth + nStripWidth - 1) / nStripWidth;
+
+				Clu::Parallel::ForEachBlock(nStripCount, 1, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					CHistogramMedian<TValue> xMedian(nWidth, nHeight, nRadius, uBitCount, nStripWidth, xInvalid);
+
+					for (size_t nStrip = nBegin; nStrip < nEnd; ++nStrip)
+					{
+						xMedian.Run(xTrg, xSrc, nStrip * nStripWidth, std::min((nStrip + 1) * nStripWidth, nWidth));
+					}
+				});
+			}
+
+			/// <summary>	Single images have no histogram path. </summary>
+			template<>
+			void _MedianHistogram<float>(const SPlane&, const SPlane&, size_t, size_t, size_t, const SInvalid<float>&)
+			{
+				throw CLU_EXCEPTION("Single images have no histogram median");
+			}
+
+			/// <summary>	Filters with the sorting networks if possible, or by selection. </summary>
+			template<typename TValue>
+			void _MedianSmall(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nRadius
+				, const SInvalid<TValue>& xInvalid)
+			{
+				const size_t nStripCount = (nWidth + StripWidth - 1) / StripWidth;
+				const size_t nSize = 2 * nRadius + 1;
+
+				Clu::Parallel::ForEachBlock(nStripCount, 1, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					std::vector<TValue> vecBuffer(nSize * nSize);
+
+					for (size_t nStrip = nBegin; nStrip < nEnd; ++nStrip)
+					{
+						const size_t nX0 = nStrip * StripWidth;
+						const size_t nX1 = std::min(nX0 + StripWidth, nWidth);
+
+						if (nRadius <= 2)
+						{
+							_NetworkStrip<SMedianLane<TValue>>(xTrg, xSrc, nWidth, nHeight, nRadius, xInvalid, nX0, nX1, vecBuffer.data());
+						}
+						else
+						{
+							_SelectionStrip(xTrg, xSrc, nWidth, nHeight, nRadius, xInvalid, nX0, nX1, vecBuffer.data());
+						}
+					}
+				});
+			}
+
+			template<typename TValue>
+			SInvalid<TValue> _Invalid(const SMedianConfig& xConfig)
+			{
+				const SInvalid<TValue> xInvalid{ xConfig.bIgnoreInvalid, TValue(xConfig.bIgnoreInvalid ? xConfig.dInvalidValue : 0.0) };
+
+				if (xConfig.bIgnoreInvalid && double(xInvalid.xValue) != xConfig.dInvalidValue)
+				{
+					throw CLU_EXCEPTION("Invalid value is not a value of the image data type");
+				}
+
+				return xInvalid;
+			}
+
+			template<typename TValue>
+			void _MedianPlane(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, const SMedianConfig& xConfig
+				, bool bHistogram)
+			{
+				const SInvalid<TValue> xInvalid = _Invalid<TValue>(xConfig);
+				const size_t nRadius = size_t(xConfig.iRadius);
+
+				if (nRadius == 0)
+				{
+					CopyImageRows(xTrg.pucData, xTrg.nRowPitch, xSrc.pucData, xSrc.nRowPitch, nWidth * sizeof(TValue), nHeight);
+				}
+				else if (bHistogram && nRadius > 2)
+				{
+					_MedianHistogram(xTrg, xSrc, nWidth, nHeight, nRadius, xInvalid);
+				}
+				else
+				{
+					_MedianSmall(xTrg, xSrc, nWidth, nHeight, nRadius, xInvalid);
+				}
+			}
+		} // namespace
+
+		void MedianImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, const SMedianConfig& xConfig)
+		{
+			if (pTrgData == nullptr || pSrcData == nullptr)
+			{
+				throw CLU_EXCEPTION("Invalid image data");
+			}
+
+			if (xTrgFormat.iWidth != xSrcFormat.iWidth || xTrgFormat.iHeight != xSrcFormat.iHeight
+				|| !xTrgFormat.IsEqualType(xSrcFormat.ePixelType, xSrcFormat.eDataType))
+			{
+				throw CLU_EXCEPTION("Target and source images differ in size or type");
+			}
+
+			if (SImageType::DimOf(xSrcFormat.ePixelType) != 1 || SImageType::IsBayerPixelType(xSrcFormat.ePixelType))
+			{
+				throw CLU_EXCEPTION("Median filter supports single channel images");
+			}
+
+			if (xConfig.iRadius < 0 || xConfig.iRadius > SMedianConfig::MaxRadius)
+			{
+				throw CLU_EXCEPTION("Invalid median filter radius");
+			}
+
+			if (xSrcFormat.iWidth <= 0 || xSrcFormat.iHeight <= 0)
+			{
+				return;
+			}
+
+			const SPlane xTrg{ (unsigned char*)pTrgData, xTrgFormat.RowPitch() };
+			const SPlane xSrc{ (unsigned char*)pSrcData, xSrcFormat.RowPitch() };
+			const size_t nWidth = size_t(xSrcFormat.iWidth);
+			const size_t nHeight = size_t(xSrcFormat.iHeight);
+
+			switch (xSrcFormat.eDataType)
+			{
+			case EDataType::UInt8:
+				_MedianPlane<uint8_t>(xTrg, xSrc, nWidth, nHeight, xConfig, true);
+				break;
+
+			case EDataType::UInt16:
+				_MedianPlane<uint16_t>(xTrg, xSrc, nWidth, nHeight, xConfig, true);
+				break;
+
+			case EDataType::Single:
+				_MedianPlane<float>(xTrg, xSrc, nWidth, nHeight, xConfig, false);
+				break;
+
+			default:
+				throw CLU_EXCEPTION("Unsupported image data type");
+			}
+		}
+
+		void MedianImage(CIImage& imgTrg, const CIImage& imgSrc, const SMedianConfig& xConfig)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				// The target may share the memory of the source.
+				CIImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CIImage&)imgTrg).DataPointer() == imgSrc.DataPointer())
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				const SImageFormat& xSrcFormat = imgSource.Format();
+				imgTrg.Create(SImageFormat(xSrcFormat.iWidth, xSrcFormat.iHeight, xSrcFormat.ePixelType, xSrcFormat.eDataType));
+
+				MedianImageData(imgTrg.DataPointer(), imgTrg.Format(), ((const CIImage&)imgSource).DataPointer(), xSrcFormat, xConfig);
+			}
+			CLU_CATCH_RETHROW_ALL("Error median filtering image")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Median.h
+//
+// summary:   Declares the median filter
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		/// <summary>	Configures the median filter. </summary>
+		struct SMedianConfig
+		{
+			static const int MaxRadius = 127;
+
+			/// <summary>	The radius of the square window of (2 * iRadius + 1)^2 pixels, at most MaxRadius. </summary>
+			int iRadius;
+
+			/// <summary>
+			/// 	True to leave out pixels of dInvalidValue, for example invalid disparities. Invalid pixels stay
+			/// 	invalid, as do pixels whose window has no valid pixel.
+			/// </summary>
+			bool bIgnoreInvalid;
+			double dInvalidValue;
+
+			SMedianConfig(int _iRadius = 1)
+				: iRadius(_iRadius)
+				, bIgnoreInvalid(false)
+				, dInvalidValue(0.0)
+			{
+			}
+
+			SMedianConfig(int _iRadius, double _dInvalidValue)
+				: iRadius(_iRadius)
+				, bIgnoreInvalid(true)
+				, dInvalidValue(_dInvalidValue)
+			{
+			}
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Median filters a single channel image memory block. The window is clipped at the image border, and
+		/// 	of an even number of values the lower median is taken. Windows of 3x3 and 5x5 pixels use SIMD
+		/// 	sorting networks. Larger windows of UInt8 and UInt16 images use the constant time algorithm of
+		/// 	Perreault and Hebert with two level histograms, whose size follows from the largest value of the
+		/// 	image. Larger windows of Single images select the median per pixel. The image is split into column
+		/// 	strips, which are filtered in parallel.
+		/// </summary>
+		///
+		/// <param name="pTrgData">  	The target memory. It must not overlap the source memory. </param>
+		/// <param name="xTrgFormat">	The target format. It has to be the source format, apart from the row pitch. </param>
+		/// <param name="pSrcData">  	The source memory. </param>
+		/// <param name="xSrcFormat">	The source format. UInt8, UInt16 and Single images with one channel are supported. </param>
+		/// <param name="xConfig">   	The filter configuration. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void MedianImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, const SMedianConfig& xConfig);
+
+		/// <summary>	Creates the target image with the format of the source and median filters the source into it. </summary>
+		void MedianImage(CIImage& imgTrg, const CIImage& imgSrc, const SMedianConfig& xConfig);
+
+	} // namespace ImgProc
+} // namespace Clu
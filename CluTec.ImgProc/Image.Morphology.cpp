@@ -0,0 +1,778 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Morphology.cpp
+//
+// summary:   Implements the morphological image filters with rectangular structuring elements
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <limits>
+
+#include <immintrin.h>
+
+#include "Image.Morphology.h"
+
+#include "CluTec.Types1/ImageMemory.h"
+#include "CluTec.Types1/ImageType.h"
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	The minimal number of pixels per parallel block. </summary>
+			const size_t MinBlockPixelCount = size_t(1) << 16;
+
+			/// <summary>	The number of vectors side by side in a column stripe of the vertical pass, one cache line. </summary>
+			const size_t StripeVectorCount = 4;
+
+			/// <summary>	One memory plane of an image: all channels of a CIImage or one layer of a CILayerImage. </summary>
+			struct SPlane
+			{
+				unsigned char* pucData;
+				size_t nRowPitch;
+			};
+
+			/// <summary>
+			/// 	A buffer of the vectors of a lane type, aligned for them. It takes the lane type rather than the vector
+			/// 	type, since the attributes of vector types like __m128i are dropped from template arguments.
+			/// </summary>
+			template<typename TLane>
+			class CVectorBuffer
+			{
+			public:
+				using TVec = typename TLane::TVec;
+
+				explicit CVectorBuffer(size_t nCount)
+					: m_pmData((TVec*)AlignedAlloc(nCount * sizeof(TVec), sizeof(TVec)))
+				{
+				}
+
+				~CVectorBuffer()
+				{
+					AlignedFree(m_pmData);
+				}
+
+				CVectorBuffer(const CVectorBuffer&) = delete;
+				CVectorBuffer& operator= (const CVectorBuffer&) = delete;
+
+				TVec* Data()
+				{
+					return m_pmData;
+				}
+
+			private:
+				TVec* m_pmData;
+			};
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Transposes a square block of vectors in place by interleaving the first with the second half of the
+			/// 	vectors log2(Count) times.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TVec, size_t Count, typename FuncLo, typename FuncHi>
+			void _Transpose(TVec* pmBlock, FuncLo funcLo, FuncHi funcHi)
+			{
+				const size_t nHalf = Count / 2;
+
+				for (size_t nStride = 1; nStride < Count; nStride *= 2)
+				{
+					TVec pmTemp[Count];
+					for (size_t nIdx = 0; nIdx < nHalf; ++nIdx)
+					{
+						pmTemp[2 * nIdx] = funcLo(pmBlock[nIdx], pmBlock[nIdx + nHalf]);
+						pmTemp[2 * nIdx + 1] = funcHi(pmBlock[nIdx], pmBlock[nIdx + nHalf]);
+					}
+
+					for (size_t nIdx = 0; nIdx < Count; ++nIdx)
+					{
+						pmBlock[nIdx] = pmTemp[nIdx];
+					}
+				}
+			}
+
+			/// <summary>	The SSE2 operations on vectors of a value type. </summary>
+			template<typename TValue> struct SMorphLane;
+
+			template<> struct SMorphLane<uint8_t>
+			{
+				using TValue = uint8_t;
+				using TVec = __m128i;
+				static const size_t Count = 16;
+
+				static TVec Load(const TValue* pSrc)
+				{
+					return _mm_loadu_si128((const __m128i*)pSrc);
+				}
+
+				static void Store(TValue* pTrg, TVec mValue)
+				{
+					_mm_storeu_si128((__m128i*)pTrg, mValue);
+				}
+
+				static TVec Min(TVec mA, TVec mB)
+				{
+					return _mm_min_epu8(mA, mB);
+				}
+
+				static TVec Max(TVec mA, TVec mB)
+				{
+					return _mm_max_epu8(mA, mB);
+				}
+
+				static TVec Lowest()
+				{
+					return _mm_setzero_si128();
+				}
+
+				static TVec Highest()
+				{
+					return _mm_set1_epi8(char(0xFF));
+				}
+
+				static void Transpose(TVec* pmBlock)
+				{
+					_Transpose<TVec, Count>(pmBlock
+						, [](TVec mA, TVec mB) { return _mm_unpacklo_epi8(mA, mB); }
+						, [](TVec mA, TVec mB) { return _mm_unpackhi_epi8(mA, mB); });
+				}
+			};
+
+			/// <summary>
+			/// 	SSE2 has no unsigned 16 bit minimum and maximum, so that the values are kept in the vectors with the
+			/// 	sign bit flipped and compared as signed values.
+			/// </summary>
+			template<> struct SMorphLane<uint16_t>
+			{
+				using TValue = uint16_t;
+				using TVec = __m128i;
+				static const size_t Count = 8;
+
+				static TVec Load(const TValue* pSrc)
+				{
+					return _mm_xor_si128(_mm_loadu_si128((const __m128i*)pSrc), _mm_set1_epi16(short(0x8000)));
+				}
+
+				static void Store(TValue* pTrg, TVec mValue)
+				{
+					_mm_storeu_si128((__m128i*)pTrg, _mm_xor_si128(mValue, _mm_set1_epi16(short(0x8000))));
+				}
+
+				static TVec Min(TVec mA, TVec mB)
+				{
+					return _mm_min_epi16(mA, mB);
+				}
+
+				static TVec Max(TVec mA, TVec mB)
+				{
+					return _mm_max_epi16(mA, mB);
+				}
+
+				static TVec Lowest()
+				{
+					return _mm_set1_epi16(short(0x8000));
+				}
+
+				static TVec Highest()
+				{
+					return _mm_set1_epi16(0x7FFF);
+				}
+
+				static void Transpose(TVec* pmBlock)
+				{
+					_Transpose<TVec, Count>(pmBlock
+						, [](TVec mA, TVec mB) { return _mm_unpacklo_epi16(mA, mB); }
+						, [](TVec mA, TVec mB) { return _mm_unpackhi_epi16(mA, mB); });
+				}
+			};
+
+			template<> struct SMorphLane<float>
+			{
+				using TValue = float;
+				using TVec = __m128;
+				static const size_t Count = 4;
+
+				static TVec Load(const TValue* pSrc)
+				{
+					return _mm_loadu_ps(pSrc);
+				}
+
+				static void Store(TValue* pTrg, TVec mValue)
+				{
+					_mm_storeu_ps(pTrg, mValue);
+				}
+
+				static TVec Min(TVec mA, TVec mB)
+				{
+					return _mm_min_ps(mA, mB);
+				}
+
+				static TVec Max(TVec mA, TVec mB)
+				{
+					return _mm_max_ps(mA, mB);
+				}
+
+				static TVec Lowest()
+				{
+					return _mm_set1_ps(-std::numeric_limits<float>::infinity());
+				}
+
+				static TVec Highest()
+				{
+					return _mm_set1_ps(std::numeric_limits<float>::infinity());
+				}
+
+				static void Transpose(TVec* pmBlock)
+				{
+					_Transpose<TVec, Count>(pmBlock
+						, [](TVec mA, TVec mB) { return _mm_unpacklo_ps(mA, mB); }
+						, [](TVec mA, TVec mB) { return _mm_unpackhi_ps(mA, mB); });
+				}
+			};
+
+			/// <summary>	Loads the first nCount values of a vector. The others are undefined. </summary>
+			template<typename TLane>
+			typename TLane::TVec _LoadPartial(const typename TLane::TValue* pSrc, size_t nCount)
+			{
+				typename TLane::TValue pValue[TLane::Count] = {};
+				memcpy(pValue, pSrc, nCount * sizeof(typename TLane::TValue));
+				return TLane::Load(pValue);
+			}
+
+			template<typename TLane>
+			void _StorePartial(typename TLane::TValue* pTrg, typename TLane::TVec mValue, size_t nCount)
+			{
+				typename TLane::TValue pValue[TLane::Count];
+				TLane::Store(pValue, mValue);
+				memcpy(pTrg, pValue, nCount * sizeof(typename TLane::TValue));
+			}
+
+			/// <summary>	Erosion with the maximal value outside of the image, which clips the rectangle. </summary>
+			template<typename TLane>
+			struct SErodeOp
+			{
+				using TVec = typename TLane::TVec;
+
+				static TVec Apply(TVec mA, TVec mB)
+				{
+					return TLane::Min(mA, mB);
+				}
+
+				static TVec Identity()
+				{
+					return TLane::Highest();
+				}
+			};
+
+			template<typename TLane>
+			struct SDilateOp
+			{
+				using TVec = typename TLane::TVec;
+
+				static TVec Apply(TVec mA, TVec mB)
+				{
+					return TLane::Max(mA, mB);
+				}
+
+				static TVec Identity()
+				{
+					return TLane::Lowest();
+				}
+			};
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Filters a line of nStepCount steps of Group vectors with the van Herk / Gil-Werman algorithm. The line
+			/// 	is split into blocks of the window size nSize. The suffix extremes of the blocks are calculated
+			/// 	backwards into pmSuffix, and the prefix extremes forwards. The window starting at a step covers the
+			/// 	end of one block and the start of the next, so that its extreme is that of the suffix at its first
+			/// 	and the prefix at its last step. The result of the window starting at step s is written to step s of
+			/// 	pmLine, whose value has already been read by then.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TLane, typename TOp, size_t Group>
+			void _VhgwLine(typename TLane::TVec* pmLine, typename TLane::TVec* pmSuffix, size_t nStepCount, size_t nSize)
+			{
+				using TVec = typename TLane::TVec;
+
+				// The position of the step in its block, counted down. The last block may be partial.
+				size_t nInBlock = (nStepCount - 1) % nSize;
+				for (size_t nStep = nStepCount; nStep-- > 0;)
+				{
+					const TVec* pmValue = pmLine + nStep * Group;
+					TVec* pmTrg = pmSuffix + nStep * Group;
+
+					if (nInBlock == nSize - 1 || nStep == nStepCount - 1)
+					{
+						for (size_t nIdx = 0; nIdx < Group; ++nIdx)
+						{
+							pmTrg[nIdx] = pmValue[nIdx];
+						}
+					}
+					else
+					{
+						for (size_t nIdx = 0; nIdx < Group; ++nIdx)
+						{
+							pmTrg[nIdx] = TOp::Apply(pmValue[nIdx], pmTrg[nIdx + Group]);
+						}
+					}
+
+					nInBlock = (nInBlock == 0 ? nSize - 1 : nInBlock - 1);
+				}
+
+				TVec pmPrefix[Group];
+				nInBlock = 0;
+				for (size_t nStep = 0; nStep < nStepCount; ++nStep)
+				{
+					const TVec* pmValue = pmLine + nStep * Group;
+					if (nInBlock == 0)
+					{
+						for (size_t nIdx = 0; nIdx < Group; ++nIdx)
+						{
+							pmPrefix[nIdx] = pmValue[nIdx];
+						}
+					}
+					else
+					{
+						for (size_t nIdx = 0; nIdx < Group; ++nIdx)
+						{
+							pmPrefix[nIdx] = TOp::Apply(pmPrefix[nIdx], pmValue[nIdx]);
+						}
+					}
+
+					if (++nInBlock == nSize)
+					{
+						nInBlock = 0;
+					}
+
+					if (nStep + 1 >= nSize)
+					{
+						const size_t nFirst = (nStep + 1 - nSize) * Group;
+						for (size_t nIdx = 0; nIdx < Group; ++nIdx)
+						{
+							pmLine[nFirst + nIdx] = TOp::Apply(pmSuffix[nFirst + nIdx], pmPrefix[nIdx]);
+						}
+					}
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	The horizontal pass. The extremes run along the rows, so that bands of TLane::Count rows are
+			/// 	transposed block by block into a line with one vector per row element, whose lanes are the rows.
+			/// 	The line is padded by the radius with the identity of the operation on both sides, filtered and
+			/// 	transposed back. The bands are processed in parallel.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TLane, typename TOp, size_t Channels>
+			void _MorphRows(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nRadius)
+			{
+				using TValue = typename TLane::TValue;
+				using TVec = typename TLane::TVec;
+				const size_t nLaneCount = TLane::Count;
+
+				const size_t nElementCount = nWidth * Channels;
+				const size_t nStepCount = nWidth + 2 * nRadius;
+				const size_t nBandCount = (nHeight + nLaneCount - 1) / nLaneCount;
+				const size_t nMinBands = std::max<size_t>(MinBlockPixelCount / (nWidth * nLaneCount), 1);
+
+				Clu::Parallel::ForEachBlock(nBandCount, nMinBands, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					CVectorBuffer<TLane> xLine(nStepCount * Channels);
+					CVectorBuffer<TLane> xSuffix(nStepCount * Channels);
+					TVec* pmLine = xLine.Data();
+					TVec* pmInner = pmLine + nRadius * Channels;
+
+					const TVec mIdentity = TOp::Identity();
+
+					for (size_t nBand = nBegin; nBand < nEnd; ++nBand)
+					{
+						// The results of the previous band overwrite the left padding.
+						for (size_t nIdx = 0; nIdx < nRadius * Channels; ++nIdx)
+						{
+							pmLine[nIdx] = mIdentity;
+							pmInner[nElementCount + nIdx] = mIdentity;
+						}
+
+						const size_t nY0 = nBand * nLaneCount;
+						const size_t nRowCount = std::min(nLaneCount, nHeight - nY0);
+
+						// The lanes of the rows below the image repeat the last row and are not stored.
+						const TValue* ppSrcRow[nLaneCount];
+						TValue* ppTrgRow[nLaneCount];
+						for (size_t nRow = 0; nRow < nLaneCount; ++nRow)
+						{
+							const size_t nY = nY0 + std::min(nRow, nRowCount - 1);
+							ppSrcRow[nRow] = (const TValue*)(xSrc.pucData + nY * xSrc.nRowPitch);
+							ppTrgRow[nRow] = (TValue*)(xTrg.pucData + nY * xTrg.nRowPitch);
+						}
+
+						TVec pmBlock[nLaneCount];
+						for (size_t nElement = 0; nElement < nElementCount; nElement += nLaneCount)
+						{
+							const size_t nCount = std::min(nLaneCount, nElementCount - nElement);
+							for (size_t nRow = 0; nRow < nLaneCount; ++nRow)
+							{
+								pmBlock[nRow] = (nCount == nLaneCount ? TLane::Load(ppSrcRow[nRow] + nElement)
+									: _LoadPartial<TLane>(ppSrcRow[nRow] + nElement, nCount));
+							}
+
+							TLane::Transpose(pmBlock);
+
+							for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+							{
+								pmInner[nElement + nIdx] = pmBlock[nIdx];
+							}
+						}
+
+						_VhgwLine<TLane, TOp, Channels>(pmLine, xSuffix.Data(), nStepCount, 2 * nRadius + 1);
+
+						for (size_t nElement = 0; nElement < nElementCount; nElement += nLaneCount)
+						{
+							const size_t nCount = std::min(nLaneCount, nElementCount - nElement);
+							for (size_t nIdx = 0; nIdx < nLaneCount; ++nIdx)
+							{
+								pmBlock[nIdx] = (nIdx < nCount ? pmLine[nElement + nIdx] : mIdentity);
+							}
+
+							TLane::Transpose(pmBlock);
+
+							for (size_t nRow = 0; nRow < nRowCount; ++nRow)
+							{
+								if (nCount == nLaneCount)
+								{
+									TLane::Store(ppTrgRow[nRow] + nElement, pmBlock[nRow]);
+								}
+								else
+								{
+									_StorePartial<TLane>(ppTrgRow[nRow] + nElement, pmBlock[nRow], nCount);
+								}
+							}
+						}
+					}
+				});
+			}
+
+			/// <summary>	Filters a column stripe of Group vectors per row in place. The last vector may be partial. </summary>
+			template<typename TLane, typename TOp, size_t Group>
+			void _MorphStripe(typename TLane::TVec* pmLine, typename TLane::TVec* pmSuffix, const SPlane& xImg
+				, size_t nElement, size_t nCount, size_t nHeight, size_t nRadius)
+			{
+				using TValue = typename TLane::TValue;
+				using TVec = typename TLane::TVec;
+				const size_t nLaneCount = TLane::Count;
+				const size_t nLastCount = nCount - (Group - 1) * nLaneCount;
+
+				TVec* pmInner = pmLine + nRadius * Group;
+				for (size_t nY = 0; nY < nHeight; ++nY)
+				{
+					const TValue* pSrc = (const TValue*)(xImg.pucData + nY * xImg.nRowPitch) + nElement;
+					TVec* pmTrg = pmInner + nY * Group;
+
+					for (size_t nIdx = 0; nIdx + 1 < Group; ++nIdx)
+					{
+						pmTrg[nIdx] = TLane::Load(pSrc + nIdx * nLaneCount);
+					}
+
+					pmTrg[Group - 1] = (nLastCount == nLaneCount ? TLane::Load(pSrc + (Group - 1) * nLaneCount)
+						: _LoadPartial<TLane>(pSrc + (Group - 1) * nLaneCount, nLastCount));
+				}
+
+				_VhgwLine<TLane, TOp, Group>(pmLine, pmSuffix, nHeight + 2 * nRadius, 2 * nRadius + 1);
+
+				for (size_t nY = 0; nY < nHeight; ++nY)
+				{
+					TValue* pTrg = (TValue*)(xImg.pucData + nY * xImg.nRowPitch) + nElement;
+					const TVec* pmSrc = pmLine + nY * Group;
+
+					for (size_t nIdx = 0; nIdx + 1 < Group; ++nIdx)
+					{
+						TLane::Store(pTrg + nIdx * nLaneCount, pmSrc[nIdx]);
+					}
+
+					if (nLastCount == nLaneCount)
+					{
+						TLane::Store(pTrg + (Group - 1) * nLaneCount, pmSrc[Group - 1]);
+					}
+					else
+					{
+						_StorePartial<TLane>(pTrg + (Group - 1) * nLaneCount, pmSrc[Group - 1], nLastCount);
+					}
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	The vertical pass in place. The extremes run along the columns, which are side by side in the
+			/// 	vectors of the rows, so that no transposition is needed. The image is split into column stripes of
+			/// 	StripeVectorCount vectors, which are processed in parallel.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TLane, typename TOp>
+			void _MorphColumns(const SPlane& xImg, size_t nElementCount, size_t nHeight, size_t nRadius)
+			{
+				using TVec = typename TLane::TVec;
+				const size_t nLaneCount = TLane::Count;
+
+				const size_t nStripeElementCount = StripeVectorCount * nLaneCount;
+				const size_t nStripeCount = (nElementCount + nStripeElementCount - 1) / nStripeElementCount;
+				const size_t nStepCount = nHeight + 2 * nRadius;
+				const size_t nMinStripes = std::max<size_t>(MinBlockPixelCount / (nHeight * nStripeElementCount), 1);
+
+				Clu::Parallel::ForEachBlock(nStripeCount, nMinStripes, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					CVectorBuffer<TLane> xLine(nStepCount * StripeVectorCount);
+					CVectorBuffer<TLane> xSuffix(nStepCount * StripeVectorCount);
+					TVec* pmLine = xLine.Data();
+					TVec* pmSuffix = xSuffix.Data();
+
+					for (size_t nStripe = nBegin; nStripe < nEnd; ++nStripe)
+					{
+						const size_t nElement = nStripe * nStripeElementCount;
+						const size_t nCount = std::min(nStripeElementCount, nElementCount - nElement);
+						const size_t nGroup = (nCount + nLaneCount - 1) / nLaneCount;
+
+						const TVec mIdentity = TOp::Identity();
+						for (size_t nIdx = 0; nIdx < nRadius * nGroup; ++nIdx)
+						{
+							pmLine[nIdx] = mIdentity;
+							pmLine[(nRadius + nHeight) * nGroup + nIdx] = mIdentity;
+						}
+
+						switch (nGroup)
+						{
+						case 1:
+							_MorphStripe<TLane, TOp, 1>(pmLine, pmSuffix, xImg, nElement, nCount, nHeight, nRadius);
+							break;
+
+						case 2:
+							_MorphStripe<TLane, TOp, 2>(pmLine, pmSuffix, xImg, nElement, nCount, nHeight, nRadius);
+							break;
+
+						case 3:
+							_MorphStripe<TLane, TOp, 3>(pmLine, pmSuffix, xImg, nElement, nCount, nHeight, nRadius);
+							break;
+
+						default:
+							_MorphStripe<TLane, TOp, 4>(pmLine, pmSuffix, xImg, nElement, nCount, nHeight, nRadius);
+							break;
+						}
+					}
+				});
+			}
+
+			/// <summary>	Erodes or dilates with the horizontal pass from the source to the target and the vertical pass in place. </summary>
+			template<typename TLane, typename TOp>
+			void _MorphPlane(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nChannels
+				, size_t nRadiusX, size_t nRadiusY)
+			{
+				if (nRadiusX > 0)
+				{
+					switch (nChannels)
+					{
+					case 1:
+						_MorphRows<TLane, TOp, 1>(xTrg, xSrc, nWidth, nHeight, nRadiusX);
+						break;
+
+					case 2:
+						_MorphRows<TLane, TOp, 2>(xTrg, xSrc, nWidth, nHeight, nRadiusX);
+						break;
+
+					case 3:
+						_MorphRows<TLane, TOp, 3>(xTrg, xSrc, nWidth, nHeight, nRadiusX);
+						break;
+
+					case 4:
+						_MorphRows<TLane, TOp, 4>(xTrg, xSrc, nWidth, nHeight, nRadiusX);
+						break;
+
+					default:
+						throw CLU_EXCEPTION("Unsupported number of channels");
+					}
+				}
+				else if (xTrg.pucData != xSrc.pucData)
+				{
+					CopyImageRows(xTrg.pucData, xTrg.nRowPitch, xSrc.pucData, xSrc.nRowPitch
+						, nWidth * nChannels * sizeof(typename TLane::TValue), nHeight);
+				}
+
+				if (nRadiusY > 0)
+				{
+					_MorphColumns<TLane, TOp>(xTrg, nWidth * nChannels, nHeight, nRadiusY);
+				}
+			}
+
+			template<typename TLane>
+			void _MorphPlane(const SPlane& xTrg, const SPlane& xSrc, size_t nWidth, size_t nHeight, size_t nChannels
+				, EMorphOp eOp, size_t nRadiusX, size_t nRadiusY)
+			{
+				using TErode = SErodeOp<TLane>;
+				using TDilate = SDilateOp<TLane>;
+
+				switch (eOp)
+				{
+				case EMorphOp::Erode:
+					_MorphPlane<TLane, TErode>(xTrg, xSrc, nWidth, nHeight, nChannels, nRadiusX, nRadiusY);
+					break;
+
+				case EMorphOp::Dilate:
+					_MorphPlane<TLane, TDilate>(xTrg, xSrc, nWidth, nHeight, nChannels, nRadiusX, nRadiusY);
+					break;
+
+				case EMorphOp::Open:
+					_MorphPlane<TLane, TErode>(xTrg, xSrc, nWidth, nHeight, nChannels, nRadiusX, nRadiusY);
+					_MorphPlane<TLane, TDilate>(xTrg, xTrg, nWidth, nHeight, nChannels, nRadiusX, nRadiusY);
+					break;
+
+				case EMorphOp::Close:
+					_MorphPlane<TLane, TDilate>(xTrg, xSrc, nWidth, nHeight, nChannels, nRadiusX, nRadiusY);
+					_MorphPlane<TLane, TErode>(xTrg, xTrg, nWidth, nHeight, nChannels, nRadiusX, nRadiusY);
+					break;
+
+				default:
+					throw CLU_EXCEPTION("Invalid morphological operation");
+				}
+			}
+
+			/// <summary>	Dispatches on the data type. Radii beyond the image size give the same result as the image size. </summary>
+			void _MorphPlane(const SPlane& xTrg, const SPlane& xSrc, const SImageFormat& xFormat, size_t nChannels
+				, EMorphOp eOp, int iRadiusX, int iRadiusY)
+			{
+				const size_t nWidth = size_t(xFormat.iWidth);
+				const size_t nHeight = size_t(xFormat.iHeight);
+				const size_t nRadiusX = std::min(size_t(iRadiusX), nWidth - 1);
+				const size_t nRadiusY = std::min(size_t(iRadiusY), nHeight - 1);
+
+				switch (xFormat.eDataType)
+				{
+				case EDataType::UInt8:
+					_MorphPlane<SMorphLane<uint8_t>>(xTrg, xSrc, nWidth, nHeight, nChannels, eOp, nRadiusX, nRadiusY);
+					break;
+
+				case EDataType::UInt16:
+					_MorphPlane<SMorphLane<uint16_t>>(xTrg, xSrc, nWidth, nHeight, nChannels, eOp, nRadiusX, nRadiusY);
+					break;
+
+				case EDataType::Single:
+					_MorphPlane<SMorphLane<float>>(xTrg, xSrc, nWidth, nHeight, nChannels, eOp, nRadiusX, nRadiusY);
+					break;
+
+				default:
+					throw CLU_EXCEPTION("Unsupported image data type");
+				}
+			}
+
+			void _CheckArguments(const SImageFormat& xFormat, int iRadiusX, int iRadiusY)
+			{
+				if (SImageType::IsBayerPixelType(xFormat.ePixelType))
+				{
+					throw CLU_EXCEPTION("Bayer images cannot be filtered");
+				}
+
+				if (iRadiusX < 0 || iRadiusY < 0)
+				{
+					throw CLU_EXCEPTION("Invalid radius of the structuring element");
+				}
+			}
+		} // namespace
+
+		void MorphImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, EMorphOp eOp, int iRadiusX, int iRadiusY)
+		{
+			if (pTrgData == nullptr || pSrcData == nullptr)
+			{
+				throw CLU_EXCEPTION("Invalid image data");
+			}
+
+			if (xTrgFormat.iWidth != xSrcFormat.iWidth || xTrgFormat.iHeight != xSrcFormat.iHeight
+				|| !xTrgFormat.IsEqualType(xSrcFormat.ePixelType, xSrcFormat.eDataType))
+			{
+				throw CLU_EXCEPTION("Target and source images differ in size or type");
+			}
+
+			_CheckArguments(xSrcFormat, iRadiusX, iRadiusY);
+
+			if (xSrcFormat.iWidth <= 0 || xSrcFormat.iHeight <= 0)
+			{
+				return;
+			}
+
+			const SPlane xTrg{ (unsigned char*)pTrgData, xTrgFormat.RowPitch() };
+			const SPlane xSrc{ (unsigned char*)pSrcData, xSrcFormat.RowPitch() };
+
+			_MorphPlane(xTrg, xSrc, xSrcFormat, SImageType::DimOf(xSrcFormat.ePixelType), eOp, iRadiusX, iRadiusY);
+		}
+
+		void MorphImage(CIImage& imgTrg, const CIImage& imgSrc, EMorphOp eOp, int iRadiusX, int iRadiusY)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				// The target may share the memory of the source.
+				CIImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CIImage&)imgTrg).DataPointer() == imgSrc.DataPointer())
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				const SImageFormat& xSrcFormat = imgSource.Format();
+				imgTrg.Create(SImageFormat(xSrcFormat.iWidth, xSrcFormat.iHeight, xSrcFormat.ePixelType, xSrcFormat.eDataType));
+
+				MorphImageData(imgTrg.DataPointer(), imgTrg.Format(), ((const CIImage&)imgSource).DataPointer(), xSrcFormat, eOp, iRadiusX, iRadiusY);
+			}
+			CLU_CATCH_RETHROW_ALL("Error applying morphological operation to image")
+		}
+
+		void MorphImage(CILayerImage& imgTrg, const CILayerImage& imgSrc, EMorphOp eOp, int iRadiusX, int iRadiusY)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				_CheckArguments(imgSrc.Format(), iRadiusX, iRadiusY);
+
+				// The target may share the memory of the source.
+				CILayerImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CILayerImage&)imgTrg).DataPointer(0) == imgSrc.DataPointer(0))
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				const SImageFormat& xSrcFormat = imgSource.Format();
+				imgTrg.Create(SImageFormat(xSrcFormat.iWidth, xSrcFormat.iHeight, xSrcFormat.ePixelType, xSrcFormat.eDataType));
+
+				if (xSrcFormat.iWidth <= 0 || xSrcFormat.iHeight <= 0)
+				{
+					return;
+				}
+
+				for (size_t nLayer = 0; nLayer < imgSource.LayerCount(); ++nLayer)
+				{
+					const SPlane xTrg{ (unsigned char*)imgTrg.DataPointer(nLayer), imgTrg.LayerRowPitch() };
+					const SPlane xSrc{ (unsigned char*)((const CILayerImage&)imgSource).DataPointer(nLayer), imgSource.LayerRowPitch() };
+
+					_MorphPlane(xTrg, xSrc, xSrcFormat, 1, eOp, iRadiusX, iRadiusY);
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error applying morphological operation to layer image")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
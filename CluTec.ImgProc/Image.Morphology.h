@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Morphology.h
+//
+// summary:   Declares the morphological image filters with rectangular structuring elements
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		/// <summary>	The morphological operations. </summary>
+		enum class EMorphOp
+		{
+			/// <summary>	The minimum over the structuring element. </summary>
+			Erode = 0,
+
+			/// <summary>	The maximum over the structuring element. </summary>
+			Dilate,
+
+			/// <summary>	Erosion followed by dilation, which removes bright structures smaller than the element. </summary>
+			Open,
+
+			/// <summary>	Dilation followed by erosion, which fills dark structures smaller than the element. </summary>
+			Close,
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Applies a morphological operation with the rectangle of (2 * iRadiusX + 1) x (2 * iRadiusY + 1)
+		/// 	pixels centered on each pixel to an image memory block. The rectangle is clipped at the image border.
+		/// 	The minimum and maximum are separated into a horizontal and a vertical pass with the algorithm of van
+		/// 	Herk and Gil-Werman, which takes three comparisons per pixel and pass for any radius. Each channel is
+		/// 	filtered separately. UInt8, UInt16 and Single images are supported.
+		/// </summary>
+		///
+		/// <param name="pTrgData">  	The target memory. It may be the source memory. </param>
+		/// <param name="xTrgFormat">	The target format. It has to be the source format, apart from the row pitch. </param>
+		/// <param name="pSrcData">  	The source memory. </param>
+		/// <param name="xSrcFormat">	The source format. </param>
+		/// <param name="eOp">		 	The operation. </param>
+		/// <param name="iRadiusX">  	The horizontal radius of the rectangle. </param>
+		/// <param name="iRadiusY">  	The vertical radius of the rectangle. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void MorphImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, EMorphOp eOp, int iRadiusX, int iRadiusY);
+
+		/// <summary>	Creates the target image with the format of the source and applies the morphological operation. </summary>
+		void MorphImage(CIImage& imgTrg, const CIImage& imgSrc, EMorphOp eOp, int iRadiusX, int iRadiusY);
+
+		/// <summary>	Creates the target layer image and applies the morphological operation to each layer of the source. </summary>
+		void MorphImage(CILayerImage& imgTrg, const CILayerImage& imgSrc, EMorphOp eOp, int iRadiusX, int iRadiusY);
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Pnm.Avx2.cpp
+//
+// summary:   Implements the AVX2 byte swaps of the PNM reader and writer
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+#include "Image.Avx2.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Avx2
+		{
+			void SwapBytes16(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				unsigned char* pucTrg = static_cast<unsigned char*>(pTrg);
+				const unsigned char* pucSrc = static_cast<const unsigned char*>(pSrc);
+				size_t nIdx = 0;
+
+				const __m256i mShuffle = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14
+					, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+				for (; nIdx + 16 <= nCount; nIdx += 16)
+				{
+					__m256i mV = _mm256_loadu_si256((const __m256i*)(pucSrc + 2 * nIdx));
+					_mm256_storeu_si256((__m256i*)(pucTrg + 2 * nIdx), _mm256_shuffle_epi8(mV, mShuffle));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					const unsigned char ucLo = pucSrc[2 * nIdx];
+					pucTrg[2 * nIdx] = pucSrc[2 * nIdx + 1];
+					pucTrg[2 * nIdx + 1] = ucLo;
+				}
+			}
+
+			void SwapBytes32(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				unsigned char* pucTrg = static_cast<unsigned char*>(pTrg);
+				const unsigned char* pucSrc = static_cast<const unsigned char*>(pSrc);
+				size_t nIdx = 0;
+
+				const __m256i mShuffle = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+					, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+				for (; nIdx + 8 <= nCount; nIdx += 8)
+				{
+					__m256i mV = _mm256_loadu_si256((const __m256i*)(pucSrc + 4 * nIdx));
+					_mm256_storeu_si256((__m256i*)(pucTrg + 4 * nIdx), _mm256_shuffle_epi8(mV, mShuffle));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					const unsigned char* pucS = pucSrc + 4 * nIdx;
+					unsigned char pucV[4] = { pucS[3], pucS[2], pucS[1], pucS[0] };
+					memcpy(pucTrg + 4 * nIdx, pucV, 4);
+				}
+			}
+		} // namespace Avx2
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,518 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Pnm.cpp
+//
+// summary:   Implements reading and writing of PGM, PPM and PFM image files
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "Image.Pnm.h"
+#include "Image.Simd.h"
+#include "Image.Avx2.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/IntrinsicFunctions.h"
+#include "CluTec.Types1/ExceptionTypes.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			struct SPnmHeader
+			{
+				SImageFormat xFormat;
+
+				/// <summary>	True if the file stores the bottom row first, as PFM does. </summary>
+				bool bBottomUp;
+
+				/// <summary>	True if the values in the file have to be byte swapped. </summary>
+				bool bSwap;
+
+				SPnmHeader()
+					: bBottomUp(false)
+					, bSwap(false)
+				{
+				}
+			};
+
+			bool _IsLittleEndian()
+			{
+				const uint16_t uValue = 1;
+				unsigned char ucFirst;
+				memcpy(&ucFirst, &uValue, 1);
+				return ucFirst == 1;
+			}
+
+			/// <summary>	Swaps the bytes of 16 bit values. The target may be the source. </summary>
+			void _SwapBytes16(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				unsigned char* pucTrg = static_cast<unsigned char*>(pTrg);
+				const unsigned char* pucSrc = static_cast<const unsigned char*>(pSrc);
+				size_t nIdx = 0;
+
+				for (; nIdx + 8 <= nCount; nIdx += 8)
+				{
+					__m128i mV = Simd::Load(pucSrc + 2 * nIdx);
+					Simd::Store(pucTrg + 2 * nIdx, _mm_or_si128(_mm_slli_epi16(mV, 8), _mm_srli_epi16(mV, 8)));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					const unsigned char ucLo = pucSrc[2 * nIdx];
+					pucTrg[2 * nIdx] = pucSrc[2 * nIdx + 1];
+					pucTrg[2 * nIdx + 1] = ucLo;
+				}
+			}
+
+			/// <summary>	Swaps the bytes of 32 bit values. The target may be the source. </summary>
+			void _SwapBytes32(void* pTrg, const void* pSrc, size_t nCount)
+			{
+				unsigned char* pucTrg = static_cast<unsigned char*>(pTrg);
+				const unsigned char* pucSrc = static_cast<const unsigned char*>(pSrc);
+				size_t nIdx = 0;
+
+				for (; nIdx + 4 <= nCount; nIdx += 4)
+				{
+					// Swap the 16 bit halves, then the bytes within them.
+					__m128i mV = Simd::Load(pucSrc + 4 * nIdx);
+					mV = _mm_shufflehi_epi16(_mm_shufflelo_epi16(mV, 0xB1), 0xB1);
+					Simd::Store(pucTrg + 4 * nIdx, _mm_or_si128(_mm_slli_epi16(mV, 8), _mm_srli_epi16(mV, 8)));
+				}
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					const unsigned char* pucS = pucSrc + 4 * nIdx;
+					unsigned char pucV[4] = { pucS[3], pucS[2], pucS[1], pucS[0] };
+					memcpy(pucTrg + 4 * nIdx, pucV, 4);
+				}
+			}
+
+			void _SwapBytes(const SImageFormat& xFormat, void* pTrg, const void* pSrc, size_t nPixelCount)
+			{
+				const size_t nCount = nPixelCount * SImageType::DimOf(xFormat.ePixelType);
+
+				const bool bAvx2 = Clu::Intrinsics::HasAvx2();
+
+				if (SImageType::SizeOf(xFormat.eDataType) == 2)
+				{
+					(bAvx2 ? &Avx2::SwapBytes16 : &_SwapBytes16)(pTrg, pSrc, nCount);
+				}
+				else
+				{
+					(bAvx2 ? &Avx2::SwapBytes32 : &_SwapBytes32)(pTrg, pSrc, nCount);
+				}
+			}
+
+			/// <summary>	Reads the next header token, skipping white space and comments. </summary>
+			std::string _ReadToken(std::istream& xStream)
+			{
+				std::string sToken;
+				int iChar = xStream.get();
+
+				while (true)
+				{
+					if (iChar == '#')
+					{
+						while (iChar != '\n' && iChar != '\r' && iChar != EOF)
+						{
+							iChar = xStream.get();
+						}
+					}
+					else if (iChar != EOF && isspace(iChar))
+					{
+						iChar = xStream.get();
+					}
+					else
+					{
+						break;
+					}
+				}
+
+				// The single white space character that ends the token is consumed, which for the last token of the
+				// header is the separator before the pixel data.
+				while (iChar != EOF && !isspace(iChar) && sToken.size() < 32)
+				{
+					sToken += char(iChar);
+					iChar = xStream.get();
+				}
+
+				return sToken;
+			}
+
+			bool _ToInt(const std::string& sToken, long& lValue)
+			{
+				char* pcEnd = nullptr;
+				lValue = strtol(sToken.c_str(), &pcEnd, 10);
+				return !sToken.empty() && *pcEnd == 0;
+			}
+
+			bool _ToDouble(const std::string& sToken, double& dValue)
+			{
+				char* pcEnd = nullptr;
+				dValue = strtod(sToken.c_str(), &pcEnd);
+				return !sToken.empty() && *pcEnd == 0;
+			}
+
+			SPnmHeader _ReadHeader(std::istream& xStream, const std::string& sFilename)
+			{
+				const std::string sMagic = _ReadToken(xStream);
+				const bool bPfm = (sMagic == "Pf" || sMagic == "PF");
+
+				if (!bPfm && sMagic != "P5" && sMagic != "P6")
+				{
+					throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' is not a binary PGM, PPM or PFM image");
+				}
+
+				long lWidth = 0, lHeight = 0;
+				if (!_ToInt(_ReadToken(xStream), lWidth) || !_ToInt(_ReadToken(xStream), lHeight)
+					|| lWidth <= 0 || lHeight <= 0 || lWidth > 0x7FFFFFFFL / 16 || lHeight > 0x7FFFFFFFL)
+				{
+					throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' has an invalid image size");
+				}
+
+				SPnmHeader xHeader;
+				EPixelType ePixelType = ((sMagic == "P5" || sMagic == "Pf") ? EPixelType::Lum : EPixelType::RGB);
+				EDataType eDataType;
+
+				if (bPfm)
+				{
+					double dScale = 0.0;
+					if (!_ToDouble(_ReadToken(xStream), dScale) || dScale == 0.0)
+					{
+						throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' has an invalid scale");
+					}
+
+					// A negative scale denotes little endian values.
+					eDataType = EDataType::Single;
+					xHeader.bBottomUp = true;
+					xHeader.bSwap = ((dScale < 0.0) != _IsLittleEndian());
+				}
+				else
+				{
+					long lMaxValue = 0;
+					if (!_ToInt(_ReadToken(xStream), lMaxValue) || lMaxValue <= 0 || lMaxValue > 65535)
+					{
+						throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' has an invalid maximal value");
+					}
+
+					// Values larger than one byte are stored big endian.
+					eDataType = (lMaxValue < 256 ? EDataType::UInt8 : EDataType::UInt16);
+					xHeader.bSwap = (eDataType == EDataType::UInt16 && _IsLittleEndian());
+				}
+
+				if (!xStream.good())
+				{
+					throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' has an incomplete header");
+				}
+
+				xHeader.xFormat = SImageFormat(int(lWidth), int(lHeight), ePixelType, eDataType);
+				return xHeader;
+			}
+
+			SPnmHeader _HeaderOf(const SImageFormat& xFormat)
+			{
+				if ((xFormat.ePixelType != EPixelType::Lum && xFormat.ePixelType != EPixelType::RGB)
+					|| (xFormat.eDataType != EDataType::UInt8 && xFormat.eDataType != EDataType::UInt16
+						&& xFormat.eDataType != EDataType::Single))
+				{
+					throw CLU_EXCEPTION("Only Lum and RGB images of type UInt8, UInt16 or Single can be written as PGM, PPM or PFM");
+				}
+
+				SPnmHeader xHeader;
+				xHeader.xFormat = SImageFormat(xFormat.iWidth, xFormat.iHeight, xFormat.ePixelType, xFormat.eDataType);
+				xHeader.bBottomUp = (xFormat.eDataType == EDataType::Single);
+				xHeader.bSwap = (xFormat.eDataType == EDataType::UInt16 && _IsLittleEndian());
+				return xHeader;
+			}
+
+			void _WriteHeader(std::ostream& xStream, const SPnmHeader& xHeader)
+			{
+				const SImageFormat& xFormat = xHeader.xFormat;
+				const bool bLum = (xFormat.ePixelType == EPixelType::Lum);
+
+				std::ostringstream xText;
+				if (xFormat.eDataType == EDataType::Single)
+				{
+					xText << (bLum ? "Pf" : "PF") << "\n" << xFormat.iWidth << " " << xFormat.iHeight << "\n"
+						<< (_IsLittleEndian() ? "-1.0" : "1.0") << "\n";
+				}
+				else
+				{
+					xText << (bLum ? "P5" : "P6") << "\n" << xFormat.iWidth << " " << xFormat.iHeight << "\n"
+						<< (xFormat.eDataType == EDataType::UInt8 ? 255 : 65535) << "\n";
+				}
+
+				const std::string sText = xText.str();
+				xStream.write(sText.c_str(), std::streamsize(sText.size()));
+			}
+
+			void _OpenRead(std::ifstream& xStream, SPnmHeader& xHeader, const std::string& sFilename)
+			{
+				xStream.open(sFilename, std::ios::in | std::ios::binary);
+				if (!xStream.is_open())
+				{
+					throw CLU_EXCEPT_TYPE(FileNotFound, CLU_S "File '" << sFilename.c_str() << "' could not be opened");
+				}
+
+				xHeader = _ReadHeader(xStream, sFilename);
+			}
+
+			void _OpenWrite(std::ofstream& xStream, const SPnmHeader& xHeader, const std::string& sFilename)
+			{
+				xStream.open(sFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+				if (!xStream.is_open())
+				{
+					throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' could not be created");
+				}
+
+				_WriteHeader(xStream, xHeader);
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Reads the next iRowCount rows of the file into memory whose rows are nPitch bytes apart. For bottom
+			/// 	up files the first row read goes to the last row of the memory.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void _ReadRows(std::istream& xStream, const SPnmHeader& xHeader, unsigned char* pucData, size_t nPitch, int iRowCount)
+			{
+				const SImageFormat& xFormat = xHeader.xFormat;
+				const size_t nRowBytes = xFormat.RowByteCount();
+
+				if (!xHeader.bBottomUp && nPitch == nRowBytes)
+				{
+					xStream.read((char*)pucData, std::streamsize(nRowBytes * size_t(iRowCount)));
+				}
+				else
+				{
+					for (int iRow = 0; iRow < iRowCount; ++iRow)
+					{
+						const int iY = (xHeader.bBottomUp ? iRowCount - 1 - iRow : iRow);
+						xStream.read((char*)(pucData + size_t(iY) * nPitch), std::streamsize(nRowBytes));
+					}
+				}
+
+				if (!xStream.good())
+				{
+					throw CLU_EXCEPTION("Image file ended before all pixel data was read");
+				}
+
+				if (xHeader.bSwap)
+				{
+					for (int iY = 0; iY < iRowCount; ++iY)
+					{
+						unsigned char* pucRow = pucData + size_t(iY) * nPitch;
+						_SwapBytes(xFormat, pucRow, pucRow, size_t(xFormat.iWidth));
+					}
+				}
+			}
+
+			/// <summary>	Writes rows in file order, the reverse of _ReadRows(). </summary>
+			void _WriteRows(std::ostream& xStream, const SPnmHeader& xHeader, const unsigned char* pucData, size_t nPitch, int iRowCount
+				, std::vector<unsigned char>& vecRow)
+			{
+				const SImageFormat& xFormat = xHeader.xFormat;
+				const size_t nRowBytes = xFormat.RowByteCount();
+
+				if (!xHeader.bBottomUp && !xHeader.bSwap && nPitch == nRowBytes)
+				{
+					xStream.write((const char*)pucData, std::streamsize(nRowBytes * size_t(iRowCount)));
+				}
+				else
+				{
+					vecRow.resize(nRowBytes);
+
+					for (int iRow = 0; iRow < iRowCount; ++iRow)
+					{
+						const int iY = (xHeader.bBottomUp ? iRowCount - 1 - iRow : iRow);
+						const unsigned char* pucRow = pucData + size_t(iY) * nPitch;
+
+						if (xHeader.bSwap)
+						{
+							_SwapBytes(xFormat, vecRow.data(), pucRow, size_t(xFormat.iWidth));
+							pucRow = vecRow.data();
+						}
+
+						xStream.write((const char*)pucRow, std::streamsize(nRowBytes));
+					}
+				}
+
+				if (!xStream.good())
+				{
+					throw CLU_EXCEPTION("Error writing pixel data");
+				}
+			}
+		} // namespace
+
+		SImageFormat ReadPnmFormat(const std::string& sFilename)
+		{
+			try
+			{
+				std::ifstream xStream;
+				SPnmHeader xHeader;
+				_OpenRead(xStream, xHeader, sFilename);
+
+				return xHeader.xFormat;
+			}
+			CLU_CATCH_RETHROW_ALL("Error reading image file header")
+		}
+
+		void ReadPnm(CIImage& imgTrg, const std::string& sFilename)
+		{
+			try
+			{
+				std::ifstream xStream;
+				SPnmHeader xHeader;
+				_OpenRead(xStream, xHeader, sFilename);
+
+				const SImageFormat& xFormat = xHeader.xFormat;
+				if (!imgTrg.IsValid())
+				{
+					imgTrg.Create(xFormat);
+				}
+				else if (imgTrg.Format() != xFormat)
+				{
+					throw CLU_EXCEPTION(CLU_S "Image format differs from that of file '" << sFilename.c_str() << "'");
+				}
+
+				_ReadRows(xStream, xHeader, (unsigned char*)imgTrg.DataPointer(), imgTrg.Format().RowPitch(), xFormat.iHeight);
+			}
+			CLU_CATCH_RETHROW_ALL("Error reading image file")
+		}
+
+		void ReadPnmBands(const std::string& sFilename, int iBandHeight
+			, const std::function<void(const CIImage& imgBand, int iY)>& fnBand)
+		{
+			try
+			{
+				if (iBandHeight <= 0)
+				{
+					throw CLU_EXCEPTION("Invalid band height");
+				}
+
+				std::ifstream xStream;
+				SPnmHeader xHeader;
+				_OpenRead(xStream, xHeader, sFilename);
+
+				const SImageFormat& xFormat = xHeader.xFormat;
+				const int iHeight = xFormat.iHeight;
+				iBandHeight = std::min(iBandHeight, iHeight);
+
+				CIImage imgBand(SImageFormat(xFormat.iWidth, iBandHeight, xFormat.ePixelType, xFormat.eDataType));
+				const size_t nPitch = imgBand.Format().RowPitch();
+
+				for (int iFileRow = 0; iFileRow < iHeight; iFileRow += iBandHeight)
+				{
+					const int iRowCount = std::min(iBandHeight, iHeight - iFileRow);
+					const int iY = (xHeader.bBottomUp ? iHeight - iFileRow - iRowCount : iFileRow);
+
+					_ReadRows(xStream, xHeader, (unsigned char*)imgBand.DataPointer(), nPitch, iRowCount);
+
+					if (iRowCount == iBandHeight)
+					{
+						fnBand(imgBand, iY);
+					}
+					else
+					{
+						// A read-only view, which leaves the band image as it is, like the full bands passed above.
+						const CIImage& imgFullBand = imgBand;
+						fnBand(imgFullBand.CropView(0, 0, xFormat.iWidth, iRowCount), iY);
+					}
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error reading image file in bands")
+		}
+
+		void WritePnm(const std::string& sFilename, const CIImage& imgSrc)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid image");
+				}
+
+				const SImageFormat& xFormat = imgSrc.Format();
+				const SPnmHeader xHeader = _HeaderOf(xFormat);
+
+				std::ofstream xStream;
+				_OpenWrite(xStream, xHeader, sFilename);
+
+				std::vector<unsigned char> vecRow;
+				_WriteRows(xStream, xHeader, (const unsigned char*)imgSrc.DataPointer(), xFormat.RowPitch(), xFormat.iHeight, vecRow);
+
+				xStream.close();
+				if (xStream.fail())
+				{
+					throw CLU_EXCEPTION(CLU_S "Error closing file '" << sFilename.c_str() << "'");
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error writing image file")
+		}
+
+		void WritePnmBands(const std::string& sFilename, const SImageFormat& xFormat, int iBandHeight
+			, const std::function<void(CIImage& imgBand, int iY)>& fnBand)
+		{
+			try
+			{
+				if (!xFormat.IsValid() || iBandHeight <= 0)
+				{
+					throw CLU_EXCEPTION("Invalid image format or band height");
+				}
+
+				const SPnmHeader xHeader = _HeaderOf(xFormat);
+				const int iHeight = xFormat.iHeight;
+				iBandHeight = std::min(iBandHeight, iHeight);
+
+				std::ofstream xStream;
+				_OpenWrite(xStream, xHeader, sFilename);
+
+				CIImage imgBand(SImageFormat(xFormat.iWidth, iBandHeight, xFormat.ePixelType, xFormat.eDataType));
+				const size_t nPitch = imgBand.Format().RowPitch();
+				std::vector<unsigned char> vecRow;
+
+				for (int iFileRow = 0; iFileRow < iHeight; iFileRow += iBandHeight)
+				{
+					const int iRowCount = std::min(iBandHeight, iHeight - iFileRow);
+					const int iY = (xHeader.bBottomUp ? iHeight - iFileRow - iRowCount : iFileRow);
+
+					if (iRowCount == iBandHeight)
+					{
+						fnBand(imgBand, iY);
+					}
+					else
+					{
+						CIImage imgPart = imgBand.CropView(0, 0, xFormat.iWidth, iRowCount);
+						fnBand(imgPart, iY);
+					}
+
+					_WriteRows(xStream, xHeader, (const unsigned char*)((const CIImage&)imgBand).DataPointer(), nPitch, iRowCount, vecRow);
+				}
+
+				xStream.close();
+				if (xStream.fail())
+				{
+					throw CLU_EXCEPTION(CLU_S "Error closing file '" << sFilename.c_str() << "'");
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error writing image file in bands")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Pnm.h
+//
+// summary:   Declares reading and writing of PGM, PPM and PFM image files
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Returns the image format stored in the header of a binary PGM (P5), PPM (P6) or PFM (Pf, PF) file.
+		/// 	PGM and PPM files with a maximal value up to 255 give UInt8 images, larger ones UInt16 images. The
+		/// 	values are not rescaled to the maximal value. PFM files give Single images. PGM and Pf files are
+		/// 	Lum, PPM and PF files RGB.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		SImageFormat ReadPnmFormat(const std::string& sFilename);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Reads a PGM, PPM or PFM file. The rows are read directly into the image memory and are byte swapped in
+		/// 	place with SIMD where the file byte order differs from that of the machine.
+		/// </summary>
+		///
+		/// <param name="imgTrg">   	The target image. If it is valid, its size and type have to be those of the
+		/// 							file, and it is filled without reallocation. Otherwise it is created. </param>
+		/// <param name="sFilename">	The file name. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void ReadPnm(CIImage& imgTrg, const std::string& sFilename);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Reads a PGM, PPM or PFM file in bands of rows, so that only one band is held in memory. The bands are
+		/// 	passed to the callback in file order, which is top to bottom for PGM and PPM and bottom to top for
+		/// 	PFM. Within a band the rows are always ordered top to bottom.
+		/// </summary>
+		///
+		/// <param name="sFilename">  	The file name. </param>
+		/// <param name="iBandHeight">	The number of rows per band. The last band in file order may have fewer rows. </param>
+		/// <param name="fnBand">	  	Called with each band and the image row of its top row. The band memory is
+		/// 							reused for the next band. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void ReadPnmBands(const std::string& sFilename, int iBandHeight
+			, const std::function<void(const CIImage& imgBand, int iY)>& fnBand);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Writes a Lum or RGB image of type UInt8, UInt16 or Single as binary PGM, PPM or PFM file. UInt8 images
+		/// 	are written with a maximal value of 255, UInt16 images with 65535. PFM files are written in little
+		/// 	endian byte order.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void WritePnm(const std::string& sFilename, const CIImage& imgSrc);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Writes a PGM, PPM or PFM file in bands of rows. The callback fills each band, which is then written.
+		/// 	The bands are requested in file order, as for ReadPnmBands().
+		/// </summary>
+		///
+		/// <param name="sFilename">  	The file name. </param>
+		/// <param name="xFormat">	  	The format of the whole image. </param>
+		/// <param name="iBandHeight">	The number of rows per band. </param>
+		/// <param name="fnBand">	  	Called with the band to fill and the image row of its top row. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void WritePnmBands(const std::string& sFilename, const SImageFormat& xFormat, int iBandHeight
+			, const std::function<void(CIImage& imgBand, int iY)>& fnBand);
+
+	} // namespace ImgProc
+} // namespace Clu
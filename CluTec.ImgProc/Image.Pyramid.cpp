@@ -0,0 +1,798 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Pyramid.cpp
+//
+// summary:   Implements the image pyramid
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "Image.Pyramid.h"
+#include "Image.Simd.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	Minimal number of target bytes per thread. </summary>
+			const size_t PyramidMinBlockBytes = size_t(1) << 16;
+
+			/// <summary>	The maximal number of source pixels an area filter tap spans along one axis. </summary>
+			const size_t AreaMaxTapCount = 4;
+
+			using Simd::SZip;
+			using Simd::Load;
+			using Simd::Store;
+
+			/// <summary>	One memory plane of an image: all channels of a CIImage or one layer of a CILayerImage. </summary>
+			struct SPlane
+			{
+				unsigned char* pucData;
+				size_t nRowPitch;
+				size_t nWidth;
+				size_t nHeight;
+			};
+
+			/// <summary>	A half open rectangle of target pixels. </summary>
+			struct SRect
+			{
+				size_t nX0, nY0;
+				size_t nX1, nY1;
+			};
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Accumulation types. Integer sums are exact and rounded when they are normalized. Floating point sums
+			// are scaled.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename T, bool t_bFloat = std::is_floating_point<T>::value>
+			struct SAccum
+			{
+				using TAcc = typename std::conditional<(sizeof(T) < 4), int32_t, int64_t>::type;
+
+				static T Normalize(TAcc tSum, int iShift)
+				{
+					return T((tSum + (TAcc(1) << (iShift - 1))) >> iShift);
+				}
+
+				static T FromDouble(double dValue)
+				{
+					const double dMin = double(std::numeric_limits<T>::lowest());
+					const double dMax = double(std::numeric_limits<T>::max());
+					return T(std::min(std::max(floor(dValue + 0.5), dMin), dMax));
+				}
+			};
+
+			template<typename T>
+			struct SAccum<T, true>
+			{
+				using TAcc = T;
+
+				static T Normalize(TAcc tSum, int iShift)
+				{
+					return tSum * (T(1) / T(1 << iShift));
+				}
+
+				static T FromDouble(double dValue)
+				{
+					return T(dValue);
+				}
+			};
+
+			template<typename T>
+			const T* _Row(const SPlane& xPlane, size_t nRow)
+			{
+				return (const T*)(xPlane.pucData + nRow * xPlane.nRowPitch);
+			}
+
+			template<typename T>
+			T* _TrgRow(const SPlane& xPlane, size_t nRow)
+			{
+				return (T*)(xPlane.pucData + nRow * xPlane.nRowPitch);
+			}
+
+			/// <summary>	Mirrors an index at the borders without repeating the border, and clamps it for tiny sizes. </summary>
+			ptrdiff_t _Mirror(ptrdiff_t iIdx, ptrdiff_t iSize)
+			{
+				if (iIdx < 0)
+				{
+					iIdx = -iIdx;
+				}
+
+				if (iIdx >= iSize)
+				{
+					iIdx = 2 * (iSize - 1) - iIdx;
+				}
+
+				return std::min(std::max(iIdx, ptrdiff_t(0)), iSize - 1);
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Box 2x2 kernels. All of them first add the two source rows and then the two neighboring columns, so
+			// that the SIMD and the scalar floating point results agree. Each SIMD step reads 32 bytes of each
+			// source row. Returns the number of target pixels written.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename T, size_t t_nChannels, typename TEnable = void>
+			struct SBoxSimd
+			{
+				static size_t Row(T*, const T*, const T*, size_t)
+				{
+					return 0;
+				}
+			};
+
+			template<size_t t_nChannels>
+			struct SBoxSimd<uint8_t, t_nChannels, typename std::enable_if<t_nChannels != 3>::type>
+			{
+				static const size_t Step = 16 / t_nChannels;
+
+				static __m128i _Half(const uint8_t* pS0, const uint8_t* pS1)
+				{
+					const __m128i mZero = _mm_setzero_si128();
+					const __m128i mR0 = Load(pS0);
+					const __m128i mR1 = Load(pS1);
+
+					const __m128i mLo = _mm_add_epi16(_mm_unpacklo_epi8(mR0, mZero), _mm_unpacklo_epi8(mR1, mZero));
+					const __m128i mHi = _mm_add_epi16(_mm_unpackhi_epi8(mR0, mZero), _mm_unpackhi_epi8(mR1, mZero));
+
+					__m128i mEven, mOdd;
+					SZip<2 * t_nChannels>::Unzip(mLo, mHi, mEven, mOdd);
+
+					return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(mEven, mOdd), _mm_set1_epi16(2)), 2);
+				}
+
+				static size_t Row(uint8_t* pTrg, const uint8_t* pS0, const uint8_t* pS1, size_t nCount)
+				{
+					size_t nX = 0;
+					for (; nX + Step <= nCount; nX += Step)
+					{
+						const size_t nSrc = 2 * nX * t_nChannels;
+						const __m128i mA = _Half(pS0 + nSrc, pS1 + nSrc);
+						const __m128i mB = _Half(pS0 + nSrc + 16, pS1 + nSrc + 16);
+						Store(pTrg + nX * t_nChannels, _mm_packus_epi16(mA, mB));
+					}
+
+					return nX;
+				}
+			};
+
+			template<size_t t_nChannels>
+			struct SBoxSimd<uint16_t, t_nChannels, typename std::enable_if<t_nChannels != 3>::type>
+			{
+				static const size_t Step = 8 / t_nChannels;
+
+				static __m128i _Half(const uint16_t* pS0, const uint16_t* pS1)
+				{
+					const __m128i mZero = _mm_setzero_si128();
+					const __m128i mR0 = Load(pS0);
+					const __m128i mR1 = Load(pS1);
+
+					const __m128i mLo = _mm_add_epi32(_mm_unpacklo_epi16(mR0, mZero), _mm_unpacklo_epi16(mR1, mZero));
+					const __m128i mHi = _mm_add_epi32(_mm_unpackhi_epi16(mR0, mZero), _mm_unpackhi_epi16(mR1, mZero));
+
+					__m128i mEven, mOdd;
+					SZip<4 * t_nChannels>::Unzip(mLo, mHi, mEven, mOdd);
+
+					return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(mEven, mOdd), _mm_set1_epi32(2)), 2);
+				}
+
+				static size_t Row(uint16_t* pTrg, const uint16_t* pS0, const uint16_t* pS1, size_t nCount)
+				{
+					// SSE2 has no unsigned 32 to 16 bit pack. Shift the values into the signed range and back.
+					const __m128i mBias32 = _mm_set1_epi32(0x8000);
+					const __m128i mBias16 = _mm_set1_epi16(short(0x8000));
+
+					size_t nX = 0;
+					for (; nX + Step <= nCount; nX += Step)
+					{
+						const size_t nSrc = 2 * nX * t_nChannels;
+						const __m128i mA = _mm_sub_epi32(_Half(pS0 + nSrc, pS1 + nSrc), mBias32);
+						const __m128i mB = _mm_sub_epi32(_Half(pS0 + nSrc + 8, pS1 + nSrc + 8), mBias32);
+						Store(pTrg + nX * t_nChannels, _mm_xor_si128(_mm_packs_epi32(mA, mB), mBias16));
+					}
+
+					return nX;
+				}
+			};
+
+			template<size_t t_nChannels>
+			struct SBoxSimd<float, t_nChannels, typename std::enable_if<t_nChannels != 3>::type>
+			{
+				static const size_t Step = 4 / t_nChannels;
+
+				static size_t Row(float* pTrg, const float* pS0, const float* pS1, size_t nCount)
+				{
+					const __m128 mQuarter = _mm_set1_ps(0.25f);
+
+					size_t nX = 0;
+					for (; nX + Step <= nCount; nX += Step)
+					{
+						const size_t nSrc = 2 * nX * t_nChannels;
+						const __m128 mLo = _mm_add_ps(_mm_loadu_ps(pS0 + nSrc), _mm_loadu_ps(pS1 + nSrc));
+						const __m128 mHi = _mm_add_ps(_mm_loadu_ps(pS0 + nSrc + 4), _mm_loadu_ps(pS1 + nSrc + 4));
+
+						__m128i mEven, mOdd;
+						SZip<4 * t_nChannels>::Unzip(_mm_castps_si128(mLo), _mm_castps_si128(mHi), mEven, mOdd);
+
+						_mm_storeu_ps(pTrg + nX * t_nChannels
+							, _mm_mul_ps(_mm_add_ps(_mm_castsi128_ps(mEven), _mm_castsi128_ps(mOdd)), mQuarter));
+					}
+
+					return nX;
+				}
+			};
+
+			template<typename T, size_t t_nChannels>
+			void _BoxRow(T* pTrg, const T* pS0, const T* pS1, size_t nX0, size_t nX1)
+			{
+				using TAccum = SAccum<T>;
+				using TAcc = typename TAccum::TAcc;
+
+				const size_t nDone = SBoxSimd<T, t_nChannels>::Row(pTrg + nX0 * t_nChannels
+					, pS0 + 2 * nX0 * t_nChannels, pS1 + 2 * nX0 * t_nChannels, nX1 - nX0);
+
+				for (size_t nX = nX0 + nDone; nX < nX1; ++nX)
+				{
+					for (size_t nC = 0; nC < t_nChannels; ++nC)
+					{
+						const size_t nEven = 2 * nX * t_nChannels + nC;
+						const size_t nOdd = nEven + t_nChannels;
+						const TAcc tSum = (TAcc(pS0[nEven]) + TAcc(pS1[nEven])) + (TAcc(pS0[nOdd]) + TAcc(pS1[nOdd]));
+						pTrg[nX * t_nChannels + nC] = TAccum::Normalize(tSum, 2);
+					}
+				}
+			}
+
+			template<typename T, size_t t_nChannels>
+			void _ReduceBox(const SPlane& xTrg, const SPlane& xSrc, const SRect& xRect)
+			{
+				const size_t nMinRows = std::max<size_t>(PyramidMinBlockBytes / std::max<size_t>((xRect.nX1 - xRect.nX0) * sizeof(T) * t_nChannels, 1), 1);
+
+				Clu::Parallel::ForEachBlock(xRect.nY1 - xRect.nY0, nMinRows, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					for (size_t nY = xRect.nY0 + nBegin; nY < xRect.nY0 + nEnd; ++nY)
+					{
+						_BoxRow<T, t_nChannels>(_TrgRow<T>(xTrg, nY), _Row<T>(xSrc, 2 * nY), _Row<T>(xSrc, 2 * nY + 1), xRect.nX0, xRect.nX1);
+					}
+				});
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Gaussian 5 tap kernel. Each band first sums the source rows of a target row vertically into a buffer
+			// and then filters the buffer horizontally.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename T>
+			void _ReduceGaussian(const SPlane& xTrg, const SPlane& xSrc, size_t nChannels, const SRect& xRect)
+			{
+				using TAccum = SAccum<T>;
+				using TAcc = typename TAccum::TAcc;
+
+				static const TAcc pWeight[5] = { 1, 4, 6, 4, 1 };
+
+				const ptrdiff_t iSrcWidth = ptrdiff_t(xSrc.nWidth);
+				const ptrdiff_t iSrcHeight = ptrdiff_t(xSrc.nHeight);
+
+				// The source columns the target columns read, after mirroring.
+				const size_t nCol0 = size_t(std::max<ptrdiff_t>(2 * ptrdiff_t(xRect.nX0) - 2, 0));
+				const size_t nCol1 = std::min<size_t>(2 * xRect.nX1 + 1, xSrc.nWidth);
+
+				const size_t nMinRows = std::max<size_t>(PyramidMinBlockBytes / std::max<size_t>((xRect.nX1 - xRect.nX0) * sizeof(T) * nChannels, 1), 1);
+
+				Clu::Parallel::ForEachBlock(xRect.nY1 - xRect.nY0, nMinRows, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					std::vector<TAcc> vecSum((nCol1 - nCol0) * nChannels);
+
+					for (size_t nY = xRect.nY0 + nBegin; nY < xRect.nY0 + nEnd; ++nY)
+					{
+						const T* ppSrc[5];
+						for (ptrdiff_t iTap = 0; iTap < 5; ++iTap)
+						{
+							ppSrc[iTap] = _Row<T>(xSrc, size_t(_Mirror(2 * ptrdiff_t(nY) + iTap - 2, iSrcHeight)));
+						}
+
+						for (size_t nIdx = nCol0 * nChannels, nSum = 0; nIdx < nCol1 * nChannels; ++nIdx, ++nSum)
+						{
+							vecSum[nSum] = (TAcc(ppSrc[0][nIdx]) + TAcc(ppSrc[4][nIdx])) + TAcc(4) * (TAcc(ppSrc[1][nIdx]) + TAcc(ppSrc[3][nIdx]))
+								+ TAcc(6) * TAcc(ppSrc[2][nIdx]);
+						}
+
+						T* pTrg = _TrgRow<T>(xTrg, nY);
+						for (size_t nX = xRect.nX0; nX < xRect.nX1; ++nX)
+						{
+							size_t pnCol[5];
+							for (ptrdiff_t iTap = 0; iTap < 5; ++iTap)
+							{
+								pnCol[iTap] = (size_t(_Mirror(2 * ptrdiff_t(nX) + iTap - 2, iSrcWidth)) - nCol0) * nChannels;
+							}
+
+							for (size_t nC = 0; nC < nChannels; ++nC)
+							{
+								TAcc tSum = TAcc(0);
+								for (size_t nTap = 0; nTap < 5; ++nTap)
+								{
+									tSum += pWeight[nTap] * vecSum[pnCol[nTap] + nC];
+								}
+
+								pTrg[nX * nChannels + nC] = TAccum::Normalize(tSum, 8);
+							}
+						}
+					}
+				});
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Area kernel. A target pixel averages the source pixels it covers, weighted by their coverage.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			/// <summary>	The first source pixel and the weights of the source pixels a target pixel covers along one axis. </summary>
+			struct SAreaTaps
+			{
+				size_t nFirst;
+				size_t nCount;
+				double pdWeight[AreaMaxTapCount];
+			};
+
+			SAreaTaps _AreaTaps(size_t nTrgIdx, size_t nSrcSize, size_t nTrgSize)
+			{
+				const double dScale = double(nSrcSize) / double(nTrgSize);
+				const double dBegin = double(nTrgIdx) * dScale;
+				const double dEnd = std::min(double(nTrgIdx + 1) * dScale, double(nSrcSize));
+
+				SAreaTaps xTaps;
+				xTaps.nFirst = size_t(floor(dBegin));
+				xTaps.nCount = std::min(size_t(ceil(dEnd)) - xTaps.nFirst, AreaMaxTapCount);
+
+				for (size_t nTap = 0; nTap < xTaps.nCount; ++nTap)
+				{
+					const double dPixel = double(xTaps.nFirst + nTap);
+					xTaps.pdWeight[nTap] = (std::min(dPixel + 1.0, dEnd) - std::max(dPixel, dBegin)) / dScale;
+				}
+
+				return xTaps;
+			}
+
+			template<typename T>
+			void _ReduceArea(const SPlane& xTrg, const SPlane& xSrc, size_t nChannels, const SRect& xRect)
+			{
+				using TAccum = SAccum<T>;
+
+				std::vector<SAreaTaps> vecColTaps(xRect.nX1 - xRect.nX0);
+				for (size_t nX = xRect.nX0; nX < xRect.nX1; ++nX)
+				{
+					vecColTaps[nX - xRect.nX0] = _AreaTaps(nX, xSrc.nWidth, xTrg.nWidth);
+				}
+
+				const size_t nCol0 = vecColTaps.front().nFirst;
+				const size_t nCol1 = vecColTaps.back().nFirst + vecColTaps.back().nCount;
+
+				const size_t nMinRows = std::max<size_t>(PyramidMinBlockBytes / std::max<size_t>((xRect.nX1 - xRect.nX0) * sizeof(T) * nChannels, 1), 1);
+
+				Clu::Parallel::ForEachBlock(xRect.nY1 - xRect.nY0, nMinRows, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					std::vector<double> vecSum((nCol1 - nCol0) * nChannels);
+
+					for (size_t nY = xRect.nY0 + nBegin; nY < xRect.nY0 + nEnd; ++nY)
+					{
+						const SAreaTaps xRowTaps = _AreaTaps(nY, xSrc.nHeight, xTrg.nHeight);
+
+						std::fill(vecSum.begin(), vecSum.end(), 0.0);
+						for (size_t nTap = 0; nTap < xRowTaps.nCount; ++nTap)
+						{
+							const T* pSrc = _Row<T>(xSrc, xRowTaps.nFirst + nTap) + nCol0 * nChannels;
+							const double dWeight = xRowTaps.pdWeight[nTap];
+
+							for (size_t nIdx = 0; nIdx < vecSum.size(); ++nIdx)
+							{
+								vecSum[nIdx] += dWeight * double(pSrc[nIdx]);
+							}
+						}
+
+						T* pTrg = _TrgRow<T>(xTrg, nY);
+						for (size_t nX = xRect.nX0; nX < xRect.nX1; ++nX)
+						{
+							const SAreaTaps& xColTaps = vecColTaps[nX - xRect.nX0];
+							const double* pdSum = vecSum.data() + (xColTaps.nFirst - nCol0) * nChannels;
+
+							for (size_t nC = 0; nC < nChannels; ++nC)
+							{
+								double dValue = 0.0;
+								for (size_t nTap = 0; nTap < xColTaps.nCount; ++nTap)
+								{
+									dValue += xColTaps.pdWeight[nTap] * pdSum[nTap * nChannels + nC];
+								}
+
+								pTrg[nX * nChannels + nC] = TAccum::FromDouble(dValue);
+							}
+						}
+					}
+				});
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Dispatch
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename T>
+			void _ReducePlane(const SPlane& xTrg, const SPlane& xSrc, size_t nChannels, EPyramidFilter eFilter, const SRect& xRect)
+			{
+				switch (eFilter)
+				{
+				case EPyramidFilter::Box2x2:
+					switch (nChannels)
+					{
+					case 1:
+						_ReduceBox<T, 1>(xTrg, xSrc, xRect);
+						break;
+					case 2:
+						_ReduceBox<T, 2>(xTrg, xSrc, xRect);
+						break;
+					case 3:
+						_ReduceBox<T, 3>(xTrg, xSrc, xRect);
+						break;
+					case 4:
+						_ReduceBox<T, 4>(xTrg, xSrc, xRect);
+						break;
+					default:
+						throw CLU_EXCEPTION("Unsupported number of image channels");
+					}
+					break;
+
+				case EPyramidFilter::Gaussian5:
+					_ReduceGaussian<T>(xTrg, xSrc, nChannels, xRect);
+					break;
+
+				case EPyramidFilter::Area:
+					_ReduceArea<T>(xTrg, xSrc, nChannels, xRect);
+					break;
+
+				default:
+					throw CLU_EXCEPTION("Unsupported pyramid filter");
+				}
+			}
+
+			void _ReducePlane(const SPlane& xTrg, const SPlane& xSrc, EDataType eDataType, size_t nChannels, EPyramidFilter eFilter, const SRect& xRect)
+			{
+				if (xRect.nX0 >= xRect.nX1 || xRect.nY0 >= xRect.nY1)
+				{
+					return;
+				}
+
+				switch (eDataType)
+				{
+				case EDataType::Int8:
+					_ReducePlane<int8_t>(xTrg, xSrc, nChannels, eFilter, xRect);
+					break;
+				case EDataType::UInt8:
+					_ReducePlane<uint8_t>(xTrg, xSrc, nChannels, eFilter, xRect);
+					break;
+				case EDataType::Int16:
+					_ReducePlane<int16_t>(xTrg, xSrc, nChannels, eFilter, xRect);
+					break;
+				case EDataType::UInt16:
+					_ReducePlane<uint16_t>(xTrg, xSrc, nChannels, eFilter, xRect);
+					break;
+				case EDataType::Int32:
+					_ReducePlane<int32_t>(xTrg, xSrc, nChannels, eFilter, xRect);
+					break;
+				case EDataType::UInt32:
+					_ReducePlane<uint32_t>(xTrg, xSrc, nChannels, eFilter, xRect);
+					break;
+				case EDataType::Single:
+					_ReducePlane<float>(xTrg, xSrc, nChannels, eFilter, xRect);
+					break;
+				case EDataType::Double:
+					_ReducePlane<double>(xTrg, xSrc, nChannels, eFilter, xRect);
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported image data type");
+				}
+			}
+
+			/// <summary>	Checks the formats and returns the target rectangle clipped to the target image. </summary>
+			SRect _ClipRect(const SImageFormat& xTrgFormat, const SImageFormat& xSrcFormat, int iX, int iY, int iWidth, int iHeight)
+			{
+				const SImageFormat xLevelFormat = PyramidLevelFormat(xSrcFormat, 1);
+				if (xTrgFormat.iWidth != xLevelFormat.iWidth || xTrgFormat.iHeight != xLevelFormat.iHeight
+					|| xTrgFormat.ePixelType != xSrcFormat.ePixelType || xTrgFormat.eDataType != xSrcFormat.eDataType)
+				{
+					throw CLU_EXCEPTION("Target image format does not match the next pyramid level of the source");
+				}
+
+				SRect xRect;
+				xRect.nX0 = size_t(std::min(std::max(iX, 0), xTrgFormat.iWidth));
+				xRect.nY0 = size_t(std::min(std::max(iY, 0), xTrgFormat.iHeight));
+				xRect.nX1 = std::max(size_t(std::min(std::max(iX + iWidth, 0), xTrgFormat.iWidth)), xRect.nX0);
+				xRect.nY1 = std::max(size_t(std::min(std::max(iY + iHeight, 0), xTrgFormat.iHeight)), xRect.nY0);
+				return xRect;
+			}
+
+			/// <summary>	Returns the range of target pixels that depend on the source range [iBegin, iEnd). </summary>
+			void _TargetRange(int& iBegin, int& iEnd, EPyramidFilter eFilter, int iSrcSize, int iTrgSize)
+			{
+				switch (eFilter)
+				{
+				case EPyramidFilter::Box2x2:
+					iBegin = iBegin / 2;
+					iEnd = (iEnd + 1) / 2;
+					break;
+
+				case EPyramidFilter::Gaussian5:
+					iBegin = std::max(iBegin - 3, 0) / 2;
+					iEnd = iEnd / 2 + 2;
+					break;
+
+				case EPyramidFilter::Area:
+				{
+					const double dScale = double(iSrcSize) / double(iTrgSize);
+					iBegin = int(floor(double(iBegin) / dScale)) - 1;
+					iEnd = int(ceil(double(iEnd) / dScale)) + 1;
+					break;
+				}
+
+				default:
+					throw CLU_EXCEPTION("Unsupported pyramid filter");
+				}
+
+				iBegin = std::min(std::max(iBegin, 0), iTrgSize);
+				iEnd = std::min(std::max(iEnd, iBegin), iTrgSize);
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Reduction of the level images. The target levels are views, so that writing to them does not detach them.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			void _ReduceLevel(CIImage& imgTrg, const CIImage& imgSrc, EPyramidFilter eFilter, int iX, int iY, int iWidth, int iHeight)
+			{
+				ReduceImageData(imgTrg.DataPointer(), imgTrg.Format(), imgSrc.DataPointer(), imgSrc.Format()
+					, eFilter, iX, iY, iWidth, iHeight);
+			}
+
+			void _ReduceLevel(CILayerImage& imgTrg, const CILayerImage& imgSrc, EPyramidFilter eFilter, int iX, int iY, int iWidth, int iHeight)
+			{
+				const SImageFormat& xTrgFormat = imgTrg.Format();
+				const SImageFormat& xSrcFormat = imgSrc.Format();
+				const SRect xRect = _ClipRect(xTrgFormat, xSrcFormat, iX, iY, iWidth, iHeight);
+
+				for (size_t nLayer = 0; nLayer < imgSrc.LayerCount(); ++nLayer)
+				{
+					const SPlane xTrg{ (unsigned char*)imgTrg.DataPointer(nLayer), imgTrg.LayerRowPitch()
+						, size_t(xTrgFormat.iWidth), size_t(xTrgFormat.iHeight) };
+					const SPlane xSrc{ (unsigned char*)imgSrc.DataPointer(nLayer), imgSrc.LayerRowPitch()
+						, size_t(xSrcFormat.iWidth), size_t(xSrcFormat.iHeight) };
+
+					_ReducePlane(xTrg, xSrc, xSrcFormat.eDataType, 1, eFilter, xRect);
+				}
+			}
+		} // namespace
+
+		SImageFormat PyramidLevelFormat(const SImageFormat& xBaseFormat, int iLevel)
+		{
+			if (iLevel < 0 || iLevel >= 31)
+			{
+				throw CLU_EXCEPTION("Invalid pyramid level");
+			}
+
+			return SImageFormat(xBaseFormat.iWidth >> iLevel, xBaseFormat.iHeight >> iLevel, xBaseFormat.ePixelType, xBaseFormat.eDataType);
+		}
+
+		int PyramidMaxLevelCount(const SImageFormat& xBaseFormat)
+		{
+			int iLevelCount = 0;
+			while ((xBaseFormat.iWidth >> iLevelCount) > 0 && (xBaseFormat.iHeight >> iLevelCount) > 0)
+			{
+				++iLevelCount;
+			}
+
+			return iLevelCount;
+		}
+
+		void ReduceImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, EPyramidFilter eFilter, int iX, int iY, int iWidth, int iHeight)
+		{
+			if (pTrgData == nullptr || pSrcData == nullptr)
+			{
+				throw CLU_EXCEPTION("Invalid image data");
+			}
+
+			if (SImageType::IsBayerPixelType(xSrcFormat.ePixelType))
+			{
+				throw CLU_EXCEPTION("Bayer images cannot be reduced");
+			}
+
+			const SRect xRect = _ClipRect(xTrgFormat, xSrcFormat, iX, iY, iWidth, iHeight);
+
+			const SPlane xTrg{ (unsigned char*)pTrgData, xTrgFormat.RowPitch(), size_t(xTrgFormat.iWidth), size_t(xTrgFormat.iHeight) };
+			const SPlane xSrc{ (unsigned char*)pSrcData, xSrcFormat.RowPitch(), size_t(xSrcFormat.iWidth), size_t(xSrcFormat.iHeight) };
+
+			_ReducePlane(xTrg, xSrc, xSrcFormat.eDataType, SImageType::DimOf(xSrcFormat.ePixelType), eFilter, xRect);
+		}
+
+		void ReduceImage(CIImage& imgTrg, const CIImage& imgSrc, EPyramidFilter eFilter)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				// The target may share the memory of the source.
+				CIImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CIImage&)imgTrg).DataPointer() == imgSrc.DataPointer())
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				const SImageFormat xFormat = PyramidLevelFormat(imgSource.Format(), 1);
+				imgTrg.Create(xFormat);
+
+				ReduceImageData(imgTrg.DataPointer(), imgTrg.Format(), ((const CIImage&)imgSource).DataPointer(), imgSource.Format()
+					, eFilter, 0, 0, xFormat.iWidth, xFormat.iHeight);
+			}
+			CLU_CATCH_RETHROW_ALL("Error reducing image")
+		}
+
+		template<typename TImage>
+		_CImagePyramid<TImage>::_CImagePyramid()
+		{
+			m_eFilter = EPyramidFilter::Box2x2;
+		}
+
+		template<typename TImage>
+		void _CImagePyramid<TImage>::Create(TImage& imgBase, int iLevelCount, EPyramidFilter eFilter)
+		{
+			try
+			{
+				if (!imgBase.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid base image");
+				}
+
+				const SImageFormat& xBaseFormat = imgBase.Format();
+				if (SImageType::IsBayerPixelType(xBaseFormat.ePixelType))
+				{
+					throw CLU_EXCEPTION("Bayer images cannot be reduced");
+				}
+
+				const int iMaxLevelCount = PyramidMaxLevelCount(xBaseFormat);
+				if (iLevelCount <= 0 || iLevelCount > iMaxLevelCount)
+				{
+					iLevelCount = iMaxLevelCount;
+				}
+
+				Destroy();
+				m_eFilter = eFilter;
+
+				// A view of the base image, so that writing to the base image later does not detach it from the pyramid.
+				m_vecLevel.reserve(size_t(iLevelCount));
+				m_vecLevel.push_back(imgBase.CropView(0, 0, xBaseFormat.iWidth, xBaseFormat.iHeight));
+
+				if (iLevelCount > 1)
+				{
+					// All reduced levels are stacked below each other in one block with the width of level 1.
+					int iBlockHeight = 0;
+					for (int iLevel = 1; iLevel < iLevelCount; ++iLevel)
+					{
+						iBlockHeight += PyramidLevelFormat(xBaseFormat, iLevel).iHeight;
+					}
+
+					const SImageFormat xLevel1Format = PyramidLevelFormat(xBaseFormat, 1);
+					m_imgBlock.Create(SImageFormat(xLevel1Format.iWidth, iBlockHeight, xBaseFormat.ePixelType, xBaseFormat.eDataType));
+
+					int iY = 0;
+					for (int iLevel = 1; iLevel < iLevelCount; ++iLevel)
+					{
+						const SImageFormat xFormat = PyramidLevelFormat(xBaseFormat, iLevel);
+						m_vecLevel.push_back(m_imgBlock.CropView(0, iY, xFormat.iWidth, xFormat.iHeight));
+						iY += xFormat.iHeight;
+					}
+				}
+
+				Update();
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating image pyramid")
+		}
+
+		template<typename TImage>
+		void _CImagePyramid<TImage>::Destroy()
+		{
+			m_vecLevel.clear();
+			m_imgBlock = TImage();
+		}
+
+		template<typename TImage>
+		void _CImagePyramid<TImage>::Update()
+		{
+			try
+			{
+				if (!IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid image pyramid");
+				}
+
+				for (int iLevel = 1; iLevel < LevelCount(); ++iLevel)
+				{
+					const TImage& imgLevel = m_vecLevel[size_t(iLevel)];
+					_Reduce(iLevel, 0, 0, imgLevel.Width(), imgLevel.Height());
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error updating image pyramid")
+		}
+
+		template<typename TImage>
+		void _CImagePyramid<TImage>::Update(int iX, int iY, int iWidth, int iHeight)
+		{
+			try
+			{
+				if (!IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid image pyramid");
+				}
+
+				int iX0 = iX, iX1 = iX + iWidth;
+				int iY0 = iY, iY1 = iY + iHeight;
+
+				for (int iLevel = 1; iLevel < LevelCount(); ++iLevel)
+				{
+					const TImage& imgSrc = m_vecLevel[size_t(iLevel - 1)];
+					const TImage& imgTrg = m_vecLevel[size_t(iLevel)];
+
+					iX0 = std::min(std::max(iX0, 0), imgSrc.Width());
+					iY0 = std::min(std::max(iY0, 0), imgSrc.Height());
+					iX1 = std::min(std::max(iX1, iX0), imgSrc.Width());
+					iY1 = std::min(std::max(iY1, iY0), imgSrc.Height());
+
+					_TargetRange(iX0, iX1, m_eFilter, imgSrc.Width(), imgTrg.Width());
+					_TargetRange(iY0, iY1, m_eFilter, imgSrc.Height(), imgTrg.Height());
+
+					if (iX0 >= iX1 || iY0 >= iY1)
+					{
+						break;
+					}
+
+					_Reduce(iLevel, iX0, iY0, iX1 - iX0, iY1 - iY0);
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error updating image pyramid")
+		}
+
+		template<typename TImage>
+		const TImage& _CImagePyramid<TImage>::Level(int iLevel) const
+		{
+			if (iLevel < 0 || iLevel >= LevelCount())
+			{
+				throw CLU_EXCEPTION("Invalid pyramid level");
+			}
+
+			return m_vecLevel[size_t(iLevel)];
+		}
+
+		template<typename TImage>
+		void _CImagePyramid<TImage>::_Reduce(int iLevel, int iX, int iY, int iWidth, int iHeight)
+		{
+			_ReduceLevel(m_vecLevel[size_t(iLevel)], m_vecLevel[size_t(iLevel - 1)], m_eFilter, iX, iY, iWidth, iHeight);
+		}
+
+		template class _CImagePyramid<CIImage>;
+		template class _CImagePyramid<CILayerImage>;
+
+	} // namespace ImgProc
+} // namespace Clu
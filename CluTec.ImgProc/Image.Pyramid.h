@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Pyramid.h
+//
+// summary:   Declares the image pyramid
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <vector>
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		/// <summary>	Filters that reduce a pyramid level to the next one. </summary>
+		enum class EPyramidFilter
+		{
+			/// <summary>	The mean of each 2x2 block. A trailing odd row or column is dropped. </summary>
+			Box2x2 = 0,
+
+			/// <summary>	The separable binomial filter 1 4 6 4 1 at every second pixel, with mirrored borders. </summary>
+			Gaussian5,
+
+			/// <summary>	Averages the exact source area of each target pixel, so odd sizes use all source pixels. </summary>
+			Area,
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Returns the format of a pyramid level. The size of level i is the base size shifted right by i, as for
+		/// 	_CStereoPinhole::InfinityOffset(). It is the resolution to pass to _CPinhole::AdjustSensorResolutionPX()
+		/// 	for a camera at this level. The format has packed rows.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		SImageFormat PyramidLevelFormat(const SImageFormat& xBaseFormat, int iLevel);
+
+		/// <summary>	Returns the number of levels including the base, until one side would become zero. </summary>
+		int PyramidMaxLevelCount(const SImageFormat& xBaseFormat);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Reduces an image memory block to the next pyramid level, restricted to a rectangle of the target.
+		/// 	Box reductions of UInt8, UInt16 and Single images with 1, 2 or 4 channels use SIMD kernels. The target
+		/// 	rows are processed in parallel bands.
+		/// </summary>
+		///
+		/// <param name="pTrgData">  	The target memory. </param>
+		/// <param name="xTrgFormat">	The target format. Its size has to be that of PyramidLevelFormat(xSrcFormat, 1). </param>
+		/// <param name="pSrcData">  	The source memory. </param>
+		/// <param name="xSrcFormat">	The source format, of the same type as the target. </param>
+		/// <param name="eFilter">   	The reduction filter. </param>
+		/// <param name="iX">			The left column of the target rectangle. </param>
+		/// <param name="iY">			The top row of the target rectangle. </param>
+		/// <param name="iWidth">		The width of the target rectangle. </param>
+		/// <param name="iHeight">   	The height of the target rectangle. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void ReduceImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, EPyramidFilter eFilter, int iX, int iY, int iWidth, int iHeight);
+
+		/// <summary>	Creates the target image with the next pyramid level format of the source and reduces the source into it. </summary>
+		void ReduceImage(CIImage& imgTrg, const CIImage& imgSrc, EPyramidFilter eFilter = EPyramidFilter::Box2x2);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	An image pyramid of CIImage or CILayerImage levels. Level 0 refers to the base image itself. All other
+		/// 	levels are views into a single image block, which is allocated once. After parts of the base image have
+		/// 	changed, Update() with the changed rectangle only recomputes the affected pixels of each level.
+		/// </summary>
+		///
+		/// <typeparam name="TImage">	CIImage or CILayerImage. </typeparam>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TImage>
+		class _CImagePyramid
+		{
+		public:
+			_CImagePyramid();
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Creates the pyramid and computes all levels. </summary>
+			///
+			/// <param name="imgBase">	  	The base image, which level 0 is a writable view of, so that writes to the
+			/// 							base show in level 0. It must not be a Bayer image. </param>
+			/// <param name="iLevelCount">	The number of levels including the base. Values below one or above
+			/// 							PyramidMaxLevelCount() give the maximal number of levels. </param>
+			/// <param name="eFilter">	  	The reduction filter. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void Create(TImage& imgBase, int iLevelCount, EPyramidFilter eFilter = EPyramidFilter::Box2x2);
+
+			/// <summary>	Releases the levels. </summary>
+			void Destroy();
+
+			/// <summary>	Recomputes all levels from the base image. </summary>
+			void Update();
+
+			/// <summary>	Recomputes the parts of all levels that depend on the given rectangle of the base image. </summary>
+			void Update(int iX, int iY, int iWidth, int iHeight);
+
+			bool IsValid() const
+			{
+				return !m_vecLevel.empty();
+			}
+
+			int LevelCount() const
+			{
+				return int(m_vecLevel.size());
+			}
+
+			EPyramidFilter Filter() const
+			{
+				return m_eFilter;
+			}
+
+			const TImage& Level(int iLevel) const;
+
+		protected:
+			void _Reduce(int iLevel, int iX, int iY, int iWidth, int iHeight);
+
+		protected:
+			EPyramidFilter m_eFilter;
+
+			/// <summary>	The memory of all levels but the base. </summary>
+			TImage m_imgBlock;
+
+			std::vector<TImage> m_vecLevel;
+		};
+
+		using CImagePyramid = _CImagePyramid<CIImage>;
+		using CLayerImagePyramid = _CImagePyramid<CILayerImage>;
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,337 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.RawContainer.cpp
+//
+// summary:   Implements the raw image sequence container
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+
+#include "Image.RawContainer.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Types1/ExceptionTypes.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			const char RawContainerMagic[8] = { 'C', 'L', 'U', 'R', 'A', 'W', 'I', 'M' };
+			const uint32_t RawContainerVersion = 1;
+			const uint64_t RawContainerHeaderSize = CDirectFileWriter::BlockSize;
+
+			static_assert(sizeof(SRawContainerHeader) == 64, "Unexpected raw container header layout");
+			static_assert(sizeof(SRawFrameEntry) == 16, "Unexpected raw container index layout");
+
+			uint64_t _FrameStride(const SImageFormat& xFormat)
+			{
+				const uint64_t uBlock = CDirectFileWriter::BlockSize;
+				return ((uint64_t(xFormat.ByteCount()) + uBlock - 1) / uBlock) * uBlock;
+			}
+
+			SRawContainerHeader _Header(const SImageFormat& xFormat, uint64_t uFrameStride, uint64_t uFrameCount, uint64_t uIndexOffset)
+			{
+				SRawContainerHeader xHeader;
+				memset(&xHeader, 0, sizeof(xHeader));
+				memcpy(xHeader.pcMagic, RawContainerMagic, sizeof(RawContainerMagic));
+				xHeader.uVersion = RawContainerVersion;
+				xHeader.uHeaderSize = uint32_t(RawContainerHeaderSize);
+				xHeader.iWidth = xFormat.iWidth;
+				xHeader.iHeight = xFormat.iHeight;
+				xHeader.uPixelType = uint32_t(xFormat.ePixelType);
+				xHeader.uDataType = uint32_t(xFormat.eDataType);
+				xHeader.uRowPitch = uint64_t(xFormat.RowPitch());
+				xHeader.uFrameStride = uFrameStride;
+				xHeader.uFrameCount = uFrameCount;
+				xHeader.uIndexOffset = uIndexOffset;
+				return xHeader;
+			}
+		} // namespace
+
+		CRawContainerWriter::CRawContainerWriter()
+			: m_uFrameStride(0)
+		{
+		}
+
+		CRawContainerWriter::~CRawContainerWriter()
+		{
+			try
+			{
+				Close();
+			}
+			catch (...)
+			{
+			}
+		}
+
+		void CRawContainerWriter::Create(const std::string& sFilename, const SImageFormat& xFormat, uint64_t uExpectedFrameCount, bool bUnbuffered)
+		{
+			try
+			{
+				if (!xFormat.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid frame format");
+				}
+
+				Close();
+
+				m_xFormat = SImageFormat(xFormat.iWidth, xFormat.iHeight, xFormat.ePixelType, xFormat.eDataType);
+				m_xFormat = SImageFormat(m_xFormat.AlignedLayout());
+				m_uFrameStride = _FrameStride(m_xFormat);
+				m_vecIndex.clear();
+				m_vecIndex.reserve(size_t(uExpectedFrameCount));
+
+				uint64_t uPreallocate = 0;
+				if (uExpectedFrameCount > 0)
+				{
+					uPreallocate = RawContainerHeaderSize + uExpectedFrameCount * (m_uFrameStride + sizeof(SRawFrameEntry));
+				}
+
+				m_xFile.Create(sFilename, uPreallocate, bUnbuffered);
+				m_sFilename = sFilename;
+
+				// The header is completed by Close(). Until then a reader rejects the file.
+				SRawContainerHeader xHeader = _Header(m_xFormat, m_uFrameStride, 0, 0);
+				m_xFile.Append(&xHeader, sizeof(xHeader));
+				m_xFile.Pad(size_t(RawContainerHeaderSize));
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating raw container")
+		}
+
+		void CRawContainerWriter::Append(const CIImage& imgFrame, int64_t iTimestamp)
+		{
+			try
+			{
+				if (!imgFrame.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid frame");
+				}
+
+				const SImageFormat& xFormat = imgFrame.Format();
+				if (xFormat != m_xFormat)
+				{
+					throw CLU_EXCEPTION("Frame format differs from the format of the container");
+				}
+
+				AppendData(imgFrame.DataPointer(), xFormat.RowPitch(), iTimestamp);
+			}
+			CLU_CATCH_RETHROW_ALL("Error appending frame to raw container")
+		}
+
+		void CRawContainerWriter::AppendData(const void* pData, size_t nRowPitch, int64_t iTimestamp)
+		{
+			try
+			{
+				if (!IsOpen())
+				{
+					throw CLU_EXCEPTION("Raw container is not open");
+				}
+
+				if (pData == nullptr || nRowPitch < m_xFormat.RowByteCount())
+				{
+					throw CLU_EXCEPTION("Invalid frame data");
+				}
+
+				if (!m_vecIndex.empty() && iTimestamp < m_vecIndex.back().iTimestamp)
+				{
+					throw CLU_EXCEPTION("Frame time stamps must not decrease");
+				}
+
+				SRawFrameEntry xEntry;
+				xEntry.uOffset = m_xFile.Size();
+				xEntry.iTimestamp = iTimestamp;
+
+				const size_t nContainerPitch = m_xFormat.RowPitch();
+				if (nRowPitch == nContainerPitch)
+				{
+					m_xFile.Append(pData, m_xFormat.ByteCount());
+				}
+				else
+				{
+					static const unsigned char pucZero[SImageFormat::RowAlignment * 16] = {};
+
+					const unsigned char* pucRow = static_cast<const unsigned char*>(pData);
+					const size_t nRowBytes = m_xFormat.RowByteCount();
+
+					for (int iY = 0; iY < m_xFormat.iHeight; ++iY, pucRow += nRowPitch)
+					{
+						m_xFile.Append(pucRow, nRowBytes);
+
+						for (size_t nPad = nContainerPitch - nRowBytes; nPad > 0; )
+						{
+							const size_t nCount = std::min(nPad, sizeof(pucZero));
+							m_xFile.Append(pucZero, nCount);
+							nPad -= nCount;
+						}
+					}
+				}
+
+				m_xFile.Pad(CDirectFileWriter::BlockSize);
+				m_vecIndex.push_back(xEntry);
+			}
+			CLU_CATCH_RETHROW_ALL("Error appending frame to raw container")
+		}
+
+		void CRawContainerWriter::Close()
+		{
+			try
+			{
+				if (!IsOpen())
+				{
+					return;
+				}
+
+				const uint64_t uIndexOffset = m_xFile.Size();
+				if (!m_vecIndex.empty())
+				{
+					m_xFile.Append(m_vecIndex.data(), m_vecIndex.size() * sizeof(SRawFrameEntry));
+				}
+				m_xFile.Close();
+
+				// The header is rewritten through the page cache, since the writer only appends.
+				SRawContainerHeader xHeader = _Header(m_xFormat, m_uFrameStride, uint64_t(m_vecIndex.size()), uIndexOffset);
+
+				std::fstream xStream(m_sFilename, std::ios::in | std::ios::out | std::ios::binary);
+				if (!xStream.is_open())
+				{
+					throw CLU_EXCEPT_TYPE(FileNotFound, CLU_S "File '" << m_sFilename.c_str() << "' could not be opened to write the header");
+				}
+
+				xStream.seekp(0);
+				xStream.write(reinterpret_cast<const char*>(&xHeader), sizeof(xHeader));
+				xStream.close();
+
+				if (xStream.fail())
+				{
+					throw CLU_EXCEPTION(CLU_S "Error writing header of file '" << m_sFilename.c_str() << "'");
+				}
+
+				m_vecIndex.clear();
+			}
+			CLU_CATCH_RETHROW_ALL("Error closing raw container")
+		}
+
+		CRawContainerReader::CRawContainerReader()
+			: m_pIndex(nullptr)
+			, m_nFrameCount(0)
+		{
+		}
+
+		void CRawContainerReader::Open(const std::string& sFilename)
+		{
+			try
+			{
+				Close();
+				m_xFile.Open(sFilename);
+
+				try
+				{
+					_ReadHeader(sFilename);
+				}
+				catch (...)
+				{
+					m_xFile.Close();
+					throw;
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error opening raw container")
+		}
+
+		void CRawContainerReader::_ReadHeader(const std::string& sFilename)
+		{
+			if (m_xFile.Size() < RawContainerHeaderSize)
+			{
+				throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' is not a raw container");
+			}
+
+			const SRawContainerHeader& xHeader = *reinterpret_cast<const SRawContainerHeader*>(m_xFile.Data());
+			if (memcmp(xHeader.pcMagic, RawContainerMagic, sizeof(RawContainerMagic)) != 0)
+			{
+				throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' is not a raw container");
+			}
+
+			if (xHeader.uVersion != RawContainerVersion)
+			{
+				throw CLU_EXCEPTION(CLU_S "Raw container '" << sFilename.c_str() << "' has unsupported version " << xHeader.uVersion);
+			}
+
+			if (xHeader.uIndexOffset == 0)
+			{
+				throw CLU_EXCEPTION(CLU_S "Raw container '" << sFilename.c_str() << "' has not been closed by its writer");
+			}
+
+			SImageFormat xFormat(xHeader.iWidth, xHeader.iHeight, EPixelType(xHeader.uPixelType), EDataType(xHeader.uDataType), int(xHeader.uRowPitch));
+			const uint64_t uSize = m_xFile.Size();
+
+			if (!xFormat.IsValid() || xHeader.uFrameStride < uint64_t(xFormat.ByteCount())
+				|| xHeader.uIndexOffset > uSize
+				|| xHeader.uFrameCount > (uSize - xHeader.uIndexOffset) / sizeof(SRawFrameEntry))
+			{
+				throw CLU_EXCEPTION(CLU_S "Raw container '" << sFilename.c_str() << "' is corrupt");
+			}
+
+			const SRawFrameEntry* pIndex = reinterpret_cast<const SRawFrameEntry*>(m_xFile.Data() + xHeader.uIndexOffset);
+			for (uint64_t uFrame = 0; uFrame < xHeader.uFrameCount; ++uFrame)
+			{
+				if (pIndex[uFrame].uOffset < xHeader.uHeaderSize || pIndex[uFrame].uOffset > xHeader.uIndexOffset
+					|| xHeader.uIndexOffset - pIndex[uFrame].uOffset < uint64_t(xFormat.ByteCount()))
+				{
+					throw CLU_EXCEPTION(CLU_S "Raw container '" << sFilename.c_str() << "' has an invalid index entry for frame " << uFrame);
+				}
+			}
+
+			m_xFormat = xFormat;
+			m_pIndex = pIndex;
+			m_nFrameCount = size_t(xHeader.uFrameCount);
+		}
+
+		void CRawContainerReader::Close()
+		{
+			m_xFile.Close();
+			m_xFormat.Clear();
+			m_pIndex = nullptr;
+			m_nFrameCount = 0;
+		}
+
+		int64_t CRawContainerReader::Timestamp(size_t nFrame) const
+		{
+			if (nFrame >= m_nFrameCount)
+			{
+				throw CLU_EXCEPTION("Frame index out of range");
+			}
+
+			return m_pIndex[nFrame].iTimestamp;
+		}
+
+		CIImage CRawContainerReader::Frame(size_t nFrame) const
+		{
+			if (nFrame >= m_nFrameCount)
+			{
+				throw CLU_EXCEPTION("Frame index out of range");
+			}
+
+			return CIImage(m_xFormat, m_xFile.Data() + m_pIndex[nFrame].uOffset, false);
+		}
+
+		size_t CRawContainerReader::FindFrame(int64_t iTimestamp) const
+		{
+			const SRawFrameEntry* pEnd = m_pIndex + m_nFrameCount;
+			const SRawFrameEntry* pNext = std::upper_bound(m_pIndex, pEnd, iTimestamp
+				, [](int64_t iValue, const SRawFrameEntry& xEntry)
+			{
+				return iValue < xEntry.iTimestamp;
+			});
+
+			return (pNext == m_pIndex ? m_nFrameCount : size_t(pNext - m_pIndex) - 1);
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
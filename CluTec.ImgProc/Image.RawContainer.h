@@ -0,0 +1,176 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.RawContainer.h
+//
+// summary:   Declares the raw image sequence container
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+#include "CluTec.System/MappedFile.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	The header at the start of a raw container file. A container stores a sequence of frames of the same
+		/// 	format in little endian byte order:
+		/// 	- The header, padded to uHeaderSize bytes.
+		/// 	- The frames. Each frame takes uFrameStride bytes, a multiple of the block size, and its rows are
+		/// 	  uRowPitch bytes apart.
+		/// 	- The index table at uIndexOffset, with one SRawFrameEntry per frame.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		struct SRawContainerHeader
+		{
+			char pcMagic[8];
+			uint32_t uVersion;
+			uint32_t uHeaderSize;
+
+			int32_t iWidth;
+			int32_t iHeight;
+			uint32_t uPixelType;
+			uint32_t uDataType;
+			uint64_t uRowPitch;
+
+			uint64_t uFrameStride;
+			uint64_t uFrameCount;
+
+			/// <summary>	The offset of the index table. Zero while the writer has not been closed. </summary>
+			uint64_t uIndexOffset;
+		};
+
+		/// <summary>	An entry of the index table of a raw container. </summary>
+		struct SRawFrameEntry
+		{
+			/// <summary>	The file offset of the frame. </summary>
+			uint64_t uOffset;
+
+			/// <summary>	The time stamp of the frame in units chosen by the writer. </summary>
+			int64_t iTimestamp;
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Records image frames into a raw container file. The disk space for the expected number of frames is
+		/// 	preallocated, and the frames are appended with unbuffered writes where the file system supports them.
+		/// 	Close() writes the index table and completes the header.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CRawContainerWriter
+		{
+		public:
+			CRawContainerWriter();
+			~CRawContainerWriter();
+
+			CRawContainerWriter(const CRawContainerWriter&) = delete;
+			CRawContainerWriter& operator= (const CRawContainerWriter&) = delete;
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Creates the container file. </summary>
+			///
+			/// <param name="sFilename">		 	The file name. </param>
+			/// <param name="xFormat">			 	The format of all frames. The row pitch of the file is the aligned
+			/// 								 	row pitch of this format. </param>
+			/// <param name="uExpectedFrameCount">	The number of frames to preallocate disk space for. </param>
+			/// <param name="bUnbuffered">		 	True to bypass the page cache if possible. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void Create(const std::string& sFilename, const SImageFormat& xFormat, uint64_t uExpectedFrameCount = 0, bool bUnbuffered = true);
+
+			/// <summary>	Appends a frame with the format of the container. Time stamps must not decrease. </summary>
+			void Append(const CIImage& imgFrame, int64_t iTimestamp);
+
+			/// <summary>	Appends a frame from memory whose rows are nRowPitch bytes apart. </summary>
+			void AppendData(const void* pData, size_t nRowPitch, int64_t iTimestamp);
+
+			/// <summary>	Writes the index table and the header and closes the file. </summary>
+			void Close();
+
+			bool IsOpen() const
+			{
+				return m_xFile.IsOpen();
+			}
+
+			size_t FrameCount() const
+			{
+				return m_vecIndex.size();
+			}
+
+			/// <summary>	The format of the frames in the file, including its row pitch. </summary>
+			const SImageFormat& Format() const
+			{
+				return m_xFormat;
+			}
+
+		protected:
+			std::string m_sFilename;
+			CDirectFileWriter m_xFile;
+			SImageFormat m_xFormat;
+			uint64_t m_uFrameStride;
+			std::vector<SRawFrameEntry> m_vecIndex;
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Reads a raw container file by mapping it into memory. The header and the index table are used in
+		/// 	place, and the frames are images that refer to the mapped memory without copying it. They are valid
+		/// 	until the reader is closed. The mapping is copy on write, so writing to a frame does not change the
+		/// 	file.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CRawContainerReader
+		{
+		public:
+			CRawContainerReader();
+
+			void Open(const std::string& sFilename);
+			void Close();
+
+			bool IsOpen() const
+			{
+				return m_xFile.IsOpen();
+			}
+
+			const SImageFormat& Format() const
+			{
+				return m_xFormat;
+			}
+
+			size_t FrameCount() const
+			{
+				return m_nFrameCount;
+			}
+
+			int64_t Timestamp(size_t nFrame) const;
+
+			/// <summary>	Returns an image that refers to the frame in the mapped file. </summary>
+			CIImage Frame(size_t nFrame) const;
+
+			/// <summary>	Returns the index of the last frame whose time stamp is not larger than the given one, or FrameCount() if there is none. </summary>
+			size_t FindFrame(int64_t iTimestamp) const;
+
+		protected:
+			/// <summary>	Validates the header and the index table of the mapped file. </summary>
+			void _ReadHeader(const std::string& sFilename);
+
+		protected:
+			CMappedFile m_xFile;
+			SImageFormat m_xFormat;
+			const SRawFrameEntry* m_pIndex;
+			size_t m_nFrameCount;
+		};
+
+	} // namespace ImgProc
+} // namespace Clu
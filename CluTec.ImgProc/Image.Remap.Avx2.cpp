@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Remap.Avx2.cpp
+//
+// summary:   Implements the AVX2 lanes of the remap interpolation
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+
+#include <immintrin.h>
+
+#include "Image.Avx2.h"
+#include "Image.Remap.Simd.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Avx2
+		{
+			namespace
+			{
+				// No fused multiply-add, which would round differently from the scalar code.
+				struct SLaneFloat
+				{
+					using TVec = __m256;
+					static const size_t Width = 8;
+
+					static TVec Zero() { return _mm256_setzero_ps(); }
+					static TVec Load(const float* pData) { return _mm256_loadu_ps(pData); }
+					static void Store(float* pData, TVec mV) { _mm256_storeu_ps(pData, mV); }
+					static TVec MulAdd(TVec mAcc, TVec mA, TVec mB) { return _mm256_add_ps(mAcc, _mm256_mul_ps(mA, mB)); }
+				};
+
+				struct SLaneDouble
+				{
+					using TVec = __m256d;
+					static const size_t Width = 4;
+
+					static TVec Zero() { return _mm256_setzero_pd(); }
+					static TVec Load(const double* pData) { return _mm256_loadu_pd(pData); }
+					static void Store(double* pData, TVec mV) { _mm256_storeu_pd(pData, mV); }
+					static TVec MulAdd(TVec mAcc, TVec mA, TVec mB) { return _mm256_add_pd(mAcc, _mm256_mul_pd(mA, mB)); }
+				};
+			} // namespace
+
+			size_t InterpolateTaps(float* pOut, const float* pTap, const float* pWeightX, const float* pWeightY, size_t nTaps, size_t nCount)
+			{
+				return Simd::InterpolateTaps<SLaneFloat>(pOut, pTap, pWeightX, pWeightY, nTaps, nCount);
+			}
+
+			size_t InterpolateTaps(double* pOut, const double* pTap, const double* pWeightX, const double* pWeightY, size_t nTaps, size_t nCount)
+			{
+				return Simd::InterpolateTaps<SLaneDouble>(pOut, pTap, pWeightX, pWeightY, nTaps, nCount);
+			}
+		} // namespace Avx2
+	} // namespace ImgProc
+} // namespace Clu
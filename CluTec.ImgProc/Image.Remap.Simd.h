@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Remap.Simd.h
+//
+// summary:   Declares the tap interpolation shared by the SSE2 and the AVX2 remap
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stddef.h>
+
+// Image.Remap.cpp and Image.Remap.Avx2.cpp instantiate the interpolation with their own lane types, so the instances
+// compiled for different instruction sets are different functions.
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Simd
+		{
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Interpolates gathered taps in whole vectors of TLane::Width values. For nTaps x nTaps taps per
+			/// 	position the buffers hold blocks of nCount values: the taps in rows, then the horizontal and the
+			/// 	vertical weights. The products are added in the order of the scalar interpolation.
+			/// </summary>
+			///
+			/// <returns>	The number of values written, the rest is left to the caller. </returns>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TLane, typename TAcc>
+			size_t InterpolateTaps(TAcc* pOut, const TAcc* pTap, const TAcc* pWeightX, const TAcc* pWeightY, size_t nTaps, size_t nCount)
+			{
+				using TVec = typename TLane::TVec;
+				const size_t nWidth = TLane::Width;
+
+				size_t nIdx = 0;
+				for (; nIdx + nWidth <= nCount; nIdx += nWidth)
+				{
+					TVec mSum = TLane::Zero();
+					for (size_t nRow = 0; nRow < nTaps; ++nRow)
+					{
+						const TAcc* pRowTap = pTap + nRow * nTaps * nCount + nIdx;
+
+						TVec mRow = TLane::Zero();
+						for (size_t nTap = 0; nTap < nTaps; ++nTap)
+						{
+							mRow = TLane::MulAdd(mRow, TLane::Load(pWeightX + nTap * nCount + nIdx), TLane::Load(pRowTap + nTap * nCount));
+						}
+
+						mSum = TLane::MulAdd(mSum, TLane::Load(pWeightY + nRow * nCount + nIdx), mRow);
+					}
+
+					TLane::Store(pOut + nIdx, mSum);
+				}
+
+				return nIdx;
+			}
+		} // namespace Simd
+	} // namespace ImgProc
+} // namespace Clu
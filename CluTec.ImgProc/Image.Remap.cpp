@@ -0,0 +1,781 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Remap.cpp
+//
+// summary:   Implements the remapping of images through a precomputed lookup table
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "Image.Remap.h"
+#include "Image.Simd.h"
+#include "Image.Remap.Simd.h"
+#include "Image.Avx2.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/IntrinsicFunctions.h"
+#include "CluTec.Base/Parallel.h"
+#include "CluTec.Types1/ExceptionTypes.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			using Simd::SConvert;
+			using Simd::SConvertScalar;
+			using TEntry = CRemapLut::SEntry;
+
+			static_assert(sizeof(TEntry) == 6, "LUT entries are written to files as they are");
+
+			/// <summary>	The header at the start of a LUT file. The entries follow in rows. </summary>
+			struct SRemapLutHeader
+			{
+				char pcMagic[8];
+				uint32_t uVersion;
+				uint32_t uFractionBits;
+				int32_t iWidth;
+				int32_t iHeight;
+			};
+
+			const char RemapLutMagic[8] = { 'C', 'L', 'U', 'R', 'E', 'M', 'A', 'P' };
+			const uint32_t RemapLutVersion = 1;
+
+			/// <summary>	Size of the target tiles. A tile of a smooth map reads a source region of similar size. </summary>
+			const size_t RemapTileWidth = 64;
+			const size_t RemapTileHeight = 32;
+
+			/// <summary>	The largest source width and height the 16 bit integer parts can address. </summary>
+			const int RemapMaxSourceSize = 32767;
+
+			const int FractionMask = CRemapLut::FractionCount - 1;
+
+			TEntry _InvalidEntry()
+			{
+				TEntry xEntry;
+				xEntry.iX = 0;
+				xEntry.iY = 0;
+				xEntry.uFraction = CRemapLut::InvalidFraction;
+				return xEntry;
+			}
+
+			/// <summary>	Rounds a position to the fixed point grid. Positions beyond the 16 bit range are clamped. </summary>
+			TEntry _Encode(double dX, double dY)
+			{
+				if (dX != dX || dY != dY)
+				{
+					return _InvalidEntry();
+				}
+
+				const double dScale = double(CRemapLut::FractionCount);
+				const double dMin = double(INT16_MIN) * dScale;
+				const double dMax = double(INT16_MAX) * dScale + double(FractionMask);
+
+				const int64_t iFixX = llrint(std::min(std::max(dX * dScale, dMin), dMax));
+				const int64_t iFixY = llrint(std::min(std::max(dY * dScale, dMin), dMax));
+
+				TEntry xEntry;
+				xEntry.iX = int16_t((iFixX - (iFixX & FractionMask)) / CRemapLut::FractionCount);
+				xEntry.iY = int16_t((iFixY - (iFixY & FractionMask)) / CRemapLut::FractionCount);
+				xEntry.uFraction = uint16_t((iFixX & FractionMask) | ((iFixY & FractionMask) << CRemapLut::FractionBits));
+				return xEntry;
+			}
+
+			/// <summary>	One memory plane of an image: all channels of a CIImage or one layer of a CILayerImage. </summary>
+			struct SPlane
+			{
+				unsigned char* pucData;
+				size_t nRowPitch;
+				EDataType eDataType;
+			};
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Interpolation of gathered taps. For nTaps x nTaps taps per position the buffers hold blocks of nCount
+			// values: the taps in rows, then the horizontal and the vertical weights. The SIMD and the scalar code
+			// add the products in the same order. The SIMD code uses AVX2 where the processor supports it and SSE2
+			// otherwise.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename TAcc> struct SLane;
+
+			template<> struct SLane<float>
+			{
+				using TVec = __m128;
+				static const size_t Width = 4;
+
+				static TVec Zero() { return _mm_setzero_ps(); }
+				static TVec Load(const float* pData) { return _mm_loadu_ps(pData); }
+				static void Store(float* pData, TVec mV) { _mm_storeu_ps(pData, mV); }
+				static TVec MulAdd(TVec mAcc, TVec mA, TVec mB) { return _mm_add_ps(mAcc, _mm_mul_ps(mA, mB)); }
+			};
+
+			template<> struct SLane<double>
+			{
+				using TVec = __m128d;
+				static const size_t Width = 2;
+
+				static TVec Zero() { return _mm_setzero_pd(); }
+				static TVec Load(const double* pData) { return _mm_loadu_pd(pData); }
+				static void Store(double* pData, TVec mV) { _mm_storeu_pd(pData, mV); }
+				static TVec MulAdd(TVec mAcc, TVec mA, TVec mB) { return _mm_add_pd(mAcc, _mm_mul_pd(mA, mB)); }
+			};
+
+			template<typename TAcc>
+			void _Interpolate(TAcc* pOut, const TAcc* pTap, const TAcc* pWeightX, const TAcc* pWeightY, size_t nTaps, size_t nCount)
+			{
+				size_t nIdx = (Clu::Intrinsics::HasAvx2() ? Avx2::InterpolateTaps(pOut, pTap, pWeightX, pWeightY, nTaps, nCount)
+					: Simd::InterpolateTaps<SLane<TAcc>>(pOut, pTap, pWeightX, pWeightY, nTaps, nCount));
+
+				for (; nIdx < nCount; ++nIdx)
+				{
+					TAcc tSum = TAcc(0);
+					for (size_t nRow = 0; nRow < nTaps; ++nRow)
+					{
+						const TAcc* pRowTap = pTap + nRow * nTaps * nCount + nIdx;
+
+						TAcc tRow = TAcc(0);
+						for (size_t nTap = 0; nTap < nTaps; ++nTap)
+						{
+							tRow = tRow + pWeightX[nTap * nCount + nIdx] * pRowTap[nTap * nCount];
+						}
+
+						tSum = tSum + pWeightY[nRow * nCount + nIdx] * tRow;
+					}
+
+					pOut[nIdx] = tSum;
+				}
+			}
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Tiled remap pass over one plane
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename T>
+			class CRemapPass
+			{
+			public:
+				/// <summary>	Values up to 16 bit and single precision values are interpolated in single precision. </summary>
+				using TAcc = typename std::conditional<(sizeof(T) <= 2 || std::is_same<T, float>::value), float, double>::type;
+
+				CRemapPass(const SPlane& xTrg, const SPlane& xSrc, size_t nSrcWidth, size_t nSrcHeight, size_t nChannels
+					, const CRemapLut& xLut, ERemapInterpolation eInterpolation, EBorderMode eBorderMode, double dBorderValue)
+					: m_xTrg(xTrg), m_xSrc(xSrc), m_xLut(xLut)
+				{
+					m_nSrcWidth = nSrcWidth;
+					m_nSrcHeight = nSrcHeight;
+					m_nChannels = nChannels;
+
+					m_eInterpolation = eInterpolation;
+					m_eBorderMode = eBorderMode;
+					m_tBorderValue = TAcc(dBorderValue);
+					SConvertScalar<T, double>::Store(&m_tBorderPixelValue, &dBorderValue, 1);
+
+					switch (eInterpolation)
+					{
+					case ERemapInterpolation::Nearest:
+						m_nTaps = 1;
+						break;
+					case ERemapInterpolation::Bilinear:
+						m_nTaps = 2;
+						break;
+					case ERemapInterpolation::Bicubic:
+						m_nTaps = 4;
+						break;
+					default:
+						throw CLU_EXCEPTION("Unsupported interpolation");
+					}
+
+					_CreateWeights();
+				}
+
+				void Run() const
+				{
+					const size_t nWidth = size_t(m_xLut.Width());
+					const size_t nHeight = size_t(m_xLut.Height());
+					const size_t nTileCols = (nWidth + RemapTileWidth - 1) / RemapTileWidth;
+					const size_t nTileRows = (nHeight + RemapTileHeight - 1) / RemapTileHeight;
+
+					Clu::Parallel::ForEachBlock(nTileCols * nTileRows, 1, [&](size_t nBegin, size_t nEnd, unsigned)
+					{
+						SBuffers xBuffers;
+						_Allocate(xBuffers);
+
+						for (size_t nTile = nBegin; nTile < nEnd; ++nTile)
+						{
+							const size_t nX0 = (nTile % nTileCols) * RemapTileWidth;
+							const size_t nY0 = (nTile / nTileCols) * RemapTileHeight;
+							const size_t nX1 = std::min(nX0 + RemapTileWidth, nWidth);
+							const size_t nY1 = std::min(nY0 + RemapTileHeight, nHeight);
+
+							for (size_t nY = nY0; nY < nY1; ++nY)
+							{
+								const TEntry* pEntry = m_xLut.Row(int(nY)) + nX0;
+								T* pTrg = (T*)(m_xTrg.pucData + nY * m_xTrg.nRowPitch) + nX0 * m_nChannels;
+
+								if (m_nTaps == 1)
+								{
+									_NearestRow(pTrg, pEntry, nX1 - nX0);
+								}
+								else
+								{
+									_InterpolateRow(xBuffers, pTrg, pEntry, nX1 - nX0);
+								}
+							}
+						}
+					});
+				}
+
+			protected:
+				struct SBuffers
+				{
+					std::vector<TAcc> vecTap;
+					std::vector<TAcc> vecWeightX;
+					std::vector<TAcc> vecWeightY;
+					std::vector<TAcc> vecOut;
+				};
+
+				void _Allocate(SBuffers& xBuffers) const
+				{
+					const size_t nCount = RemapTileWidth * m_nChannels;
+					xBuffers.vecTap.resize(m_nTaps * m_nTaps * nCount);
+					xBuffers.vecWeightX.resize(m_nTaps * nCount);
+					xBuffers.vecWeightY.resize(m_nTaps * nCount);
+					xBuffers.vecOut.resize(nCount);
+				}
+
+				/// <summary>	Creates the interpolation weights of the taps for each fraction. </summary>
+				void _CreateWeights()
+				{
+					m_vecWeight.resize(size_t(CRemapLut::FractionCount) * m_nTaps);
+
+					for (int iFraction = 0; iFraction < CRemapLut::FractionCount; ++iFraction)
+					{
+						const double dT = double(iFraction) / double(CRemapLut::FractionCount);
+						TAcc* pWeight = m_vecWeight.data() + size_t(iFraction) * m_nTaps;
+
+						if (m_nTaps == 2)
+						{
+							pWeight[0] = TAcc(1.0 - dT);
+							pWeight[1] = TAcc(dT);
+						}
+						else if (m_nTaps == 4)
+						{
+							pWeight[0] = TAcc(((-0.5 * dT + 1.0) * dT - 0.5) * dT);
+							pWeight[1] = TAcc((1.5 * dT - 2.5) * dT * dT + 1.0);
+							pWeight[2] = TAcc(((-1.5 * dT + 2.0) * dT + 0.5) * dT);
+							pWeight[3] = TAcc((0.5 * dT - 0.5) * dT * dT);
+						}
+						else
+						{
+							pWeight[0] = TAcc(1);
+						}
+					}
+				}
+
+				/// <summary>	Returns the source pixel at the given position, applying the border mode, or nullptr for a constant. </summary>
+				const T* _Pixel(ptrdiff_t iX, ptrdiff_t iY) const
+				{
+					if (size_t(iX) >= m_nSrcWidth || size_t(iY) >= m_nSrcHeight)
+					{
+						iX = BorderIndex(iX, ptrdiff_t(m_nSrcWidth), m_eBorderMode);
+						iY = BorderIndex(iY, ptrdiff_t(m_nSrcHeight), m_eBorderMode);
+						if (iX < 0 || iY < 0)
+						{
+							return nullptr;
+						}
+					}
+
+					return (const T*)(m_xSrc.pucData + size_t(iY) * m_xSrc.nRowPitch) + size_t(iX) * m_nChannels;
+				}
+
+				void _NearestRow(T* pTrg, const TEntry* pEntry, size_t nCount) const
+				{
+					const size_t nChannels = m_nChannels;
+					const int iHalf = CRemapLut::FractionCount / 2;
+
+					for (size_t nPix = 0; nPix < nCount; ++nPix, pTrg += nChannels)
+					{
+						const TEntry& xEntry = pEntry[nPix];
+
+						const T* pSrc = nullptr;
+						if ((xEntry.uFraction & CRemapLut::InvalidFraction) == 0)
+						{
+							const ptrdiff_t iX = ptrdiff_t(xEntry.iX) + ((xEntry.uFraction & FractionMask) >= iHalf ? 1 : 0);
+							const ptrdiff_t iY = ptrdiff_t(xEntry.iY) + (((xEntry.uFraction >> CRemapLut::FractionBits) & FractionMask) >= iHalf ? 1 : 0);
+							pSrc = _Pixel(iX, iY);
+						}
+
+						if (pSrc != nullptr)
+						{
+							for (size_t nChannel = 0; nChannel < nChannels; ++nChannel)
+							{
+								pTrg[nChannel] = pSrc[nChannel];
+							}
+						}
+						else
+						{
+							std::fill(pTrg, pTrg + nChannels, m_tBorderPixelValue);
+						}
+					}
+				}
+
+				////////////////////////////////////////////////////////////////////////////////////////////////////
+				/// <summary>
+				/// 	Gathers the taps and weights of a row of positions, interpolates them with SIMD kernels and stores
+				/// 	the row. Positions whose taps all lie inside the source are read directly, the others through the
+				/// 	border mode. Positions without a source position read the border value with unit weights.
+				/// </summary>
+				////////////////////////////////////////////////////////////////////////////////////////////////////
+				void _InterpolateRow(SBuffers& xBuffers, T* pTrg, const TEntry* pEntry, size_t nCount) const
+				{
+					const size_t nChannels = m_nChannels;
+					const size_t nTaps = m_nTaps;
+					const size_t nValues = nCount * nChannels;
+					const ptrdiff_t iRadius = ptrdiff_t(nTaps / 2) - 1;
+					const size_t nPitch = m_xSrc.nRowPitch;
+
+					TAcc* pTap = xBuffers.vecTap.data();
+					TAcc* pWeightX = xBuffers.vecWeightX.data();
+					TAcc* pWeightY = xBuffers.vecWeightY.data();
+
+					for (size_t nPix = 0; nPix < nCount; ++nPix)
+					{
+						const TEntry& xEntry = pEntry[nPix];
+						const size_t nValue = nPix * nChannels;
+						const bool bValid = ((xEntry.uFraction & CRemapLut::InvalidFraction) == 0);
+
+						const int iFracX = (bValid ? xEntry.uFraction & FractionMask : 0);
+						const int iFracY = (bValid ? (xEntry.uFraction >> CRemapLut::FractionBits) & FractionMask : 0);
+						const TAcc* pWX = m_vecWeight.data() + size_t(iFracX) * nTaps;
+						const TAcc* pWY = m_vecWeight.data() + size_t(iFracY) * nTaps;
+
+						for (size_t nTap = 0; nTap < nTaps; ++nTap)
+						{
+							std::fill(pWeightX + nTap * nValues + nValue, pWeightX + nTap * nValues + nValue + nChannels, pWX[nTap]);
+							std::fill(pWeightY + nTap * nValues + nValue, pWeightY + nTap * nValues + nValue + nChannels, pWY[nTap]);
+						}
+
+						const ptrdiff_t iX0 = ptrdiff_t(xEntry.iX) - iRadius;
+						const ptrdiff_t iY0 = ptrdiff_t(xEntry.iY) - iRadius;
+
+						if (!bValid)
+						{
+							for (size_t nTap = 0; nTap < nTaps * nTaps; ++nTap)
+							{
+								std::fill(pTap + nTap * nValues + nValue, pTap + nTap * nValues + nValue + nChannels, m_tBorderValue);
+							}
+						}
+						else if (iX0 >= 0 && iY0 >= 0 && size_t(iX0) + nTaps <= m_nSrcWidth && size_t(iY0) + nTaps <= m_nSrcHeight)
+						{
+							const unsigned char* pucBase = m_xSrc.pucData + size_t(iY0) * nPitch + size_t(iX0) * nChannels * sizeof(T);
+
+							for (size_t nRow = 0; nRow < nTaps; ++nRow)
+							{
+								const T* pSrc = (const T*)(pucBase + nRow * nPitch);
+								TAcc* pRowTap = pTap + nRow * nTaps * nValues + nValue;
+
+								for (size_t nTap = 0; nTap < nTaps; ++nTap, pSrc += nChannels)
+								{
+									for (size_t nChannel = 0; nChannel < nChannels; ++nChannel)
+									{
+										pRowTap[nTap * nValues + nChannel] = TAcc(pSrc[nChannel]);
+									}
+								}
+							}
+						}
+						else
+						{
+							for (size_t nRow = 0; nRow < nTaps; ++nRow)
+							{
+								TAcc* pRowTap = pTap + nRow * nTaps * nValues + nValue;
+
+								for (size_t nTap = 0; nTap < nTaps; ++nTap)
+								{
+									const T* pSrc = _Pixel(iX0 + ptrdiff_t(nTap), iY0 + ptrdiff_t(nRow));
+									for (size_t nChannel = 0; nChannel < nChannels; ++nChannel)
+									{
+										pRowTap[nTap * nValues + nChannel] = (pSrc != nullptr ? TAcc(pSrc[nChannel]) : m_tBorderValue);
+									}
+								}
+							}
+						}
+					}
+
+					_Interpolate(xBuffers.vecOut.data(), pTap, pWeightX, pWeightY, nTaps, nValues);
+					SConvert<T, TAcc>::Store(pTrg, xBuffers.vecOut.data(), nValues);
+				}
+
+			protected:
+				SPlane m_xTrg;
+				SPlane m_xSrc;
+				const CRemapLut& m_xLut;
+				size_t m_nSrcWidth;
+				size_t m_nSrcHeight;
+				size_t m_nChannels;
+
+				ERemapInterpolation m_eInterpolation;
+				size_t m_nTaps;
+
+				/// <summary>	The nTaps weights of each fraction. </summary>
+				std::vector<TAcc> m_vecWeight;
+
+				EBorderMode m_eBorderMode;
+				TAcc m_tBorderValue;
+				T m_tBorderPixelValue;
+			};
+
+			template<typename T>
+			void _RemapPlane(const SPlane& xTrg, const SPlane& xSrc, size_t nSrcWidth, size_t nSrcHeight, size_t nChannels
+				, const CRemapLut& xLut, ERemapInterpolation eInterpolation, EBorderMode eBorderMode, double dBorderValue)
+			{
+				CRemapPass<T>(xTrg, xSrc, nSrcWidth, nSrcHeight, nChannels, xLut, eInterpolation, eBorderMode, dBorderValue).Run();
+			}
+
+			void _RemapPlane(const SPlane& xTrg, const SPlane& xSrc, size_t nSrcWidth, size_t nSrcHeight, size_t nChannels
+				, const CRemapLut& xLut, ERemapInterpolation eInterpolation, EBorderMode eBorderMode, double dBorderValue)
+			{
+				switch (xSrc.eDataType)
+				{
+				case EDataType::Int8:
+					_RemapPlane<int8_t>(xTrg, xSrc, nSrcWidth, nSrcHeight, nChannels, xLut, eInterpolation, eBorderMode, dBorderValue);
+					break;
+				case EDataType::UInt8:
+					_RemapPlane<uint8_t>(xTrg, xSrc, nSrcWidth, nSrcHeight, nChannels, xLut, eInterpolation, eBorderMode, dBorderValue);
+					break;
+				case EDataType::Int16:
+					_RemapPlane<int16_t>(xTrg, xSrc, nSrcWidth, nSrcHeight, nChannels, xLut, eInterpolation, eBorderMode, dBorderValue);
+					break;
+				case EDataType::UInt16:
+					_RemapPlane<uint16_t>(xTrg, xSrc, nSrcWidth, nSrcHeight, nChannels, xLut, eInterpolation, eBorderMode, dBorderValue);
+					break;
+				case EDataType::Int32:
+					_RemapPlane<int32_t>(xTrg, xSrc, nSrcWidth, nSrcHeight, nChannels, xLut, eInterpolation, eBorderMode, dBorderValue);
+					break;
+				case EDataType::UInt32:
+					_RemapPlane<uint32_t>(xTrg, xSrc, nSrcWidth, nSrcHeight, nChannels, xLut, eInterpolation, eBorderMode, dBorderValue);
+					break;
+				case EDataType::Single:
+					_RemapPlane<float>(xTrg, xSrc, nSrcWidth, nSrcHeight, nChannels, xLut, eInterpolation, eBorderMode, dBorderValue);
+					break;
+				case EDataType::Double:
+					_RemapPlane<double>(xTrg, xSrc, nSrcWidth, nSrcHeight, nChannels, xLut, eInterpolation, eBorderMode, dBorderValue);
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported data type");
+				}
+			}
+
+			void _CheckSource(const SImageFormat& xSrcFormat)
+			{
+				if (SImageType::IsBayerPixelType(xSrcFormat.ePixelType))
+				{
+					throw CLU_EXCEPTION("Bayer images cannot be remapped");
+				}
+
+				if (xSrcFormat.iWidth <= 0 || xSrcFormat.iHeight <= 0
+					|| xSrcFormat.iWidth > RemapMaxSourceSize || xSrcFormat.iHeight > RemapMaxSourceSize)
+				{
+					throw CLU_EXCEPTION(CLU_S "Remap sources have to be between 1 and " << RemapMaxSourceSize << " pixels wide and high");
+				}
+			}
+
+			SImageFormat _TargetFormat(const SImageFormat& xSrcFormat, const CRemapLut& xLut)
+			{
+				return SImageFormat(xLut.Width(), xLut.Height(), xSrcFormat.ePixelType, xSrcFormat.eDataType);
+			}
+		} // namespace
+
+		CRemapLut::CRemapLut()
+		{
+			m_iWidth = 0;
+			m_iHeight = 0;
+		}
+
+		void CRemapLut::Create(int iWidth, int iHeight, const TMapFunc& funcMap)
+		{
+			try
+			{
+				if (iWidth <= 0 || iHeight <= 0)
+				{
+					throw CLU_EXCEPTION("Invalid LUT size");
+				}
+
+				if (!funcMap)
+				{
+					throw CLU_EXCEPTION("Invalid map function");
+				}
+
+				std::vector<SEntry> vecEntry(size_t(iWidth) * size_t(iHeight));
+
+				Clu::Parallel::ForEachBlock(size_t(iHeight), 1, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					for (size_t nY = nBegin; nY < nEnd; ++nY)
+					{
+						SEntry* pEntry = vecEntry.data() + nY * size_t(iWidth);
+						for (int iX = 0; iX < iWidth; ++iX)
+						{
+							double dX = 0.0;
+							double dY = 0.0;
+							pEntry[iX] = (funcMap(dX, dY, iX, int(nY)) ? _Encode(dX, dY) : _InvalidEntry());
+						}
+					}
+				});
+
+				m_iWidth = iWidth;
+				m_iHeight = iHeight;
+				m_vecEntry.swap(vecEntry);
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating remap LUT")
+		}
+
+		void CRemapLut::CreateHomography(int iWidth, int iHeight, const double pdH[9])
+		{
+			const std::vector<double> vecH(pdH, pdH + 9);
+
+			Create(iWidth, iHeight, [&vecH](double& dX, double& dY, int iX, int iY)
+			{
+				const double* pdRow = vecH.data();
+				const double dW = pdRow[6] * double(iX) + pdRow[7] * double(iY) + pdRow[8];
+				if (!(dW > 0.0))
+				{
+					return false;
+				}
+
+				dX = (pdRow[0] * double(iX) + pdRow[1] * double(iY) + pdRow[2]) / dW;
+				dY = (pdRow[3] * double(iX) + pdRow[4] * double(iY) + pdRow[5]) / dW;
+				return true;
+			});
+		}
+
+		void CRemapLut::CreateFromMaps(const CIImage& imgMapX, const CIImage& imgMapY)
+		{
+			try
+			{
+				if (!imgMapX.IsValid() || !imgMapY.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid map images");
+				}
+
+				const SImageFormat& xFormat = imgMapX.Format();
+				const SImageFormat& xFormatY = imgMapY.Format();
+				if (xFormat.ePixelType != EPixelType::Lum || (xFormat.eDataType != EDataType::Single && xFormat.eDataType != EDataType::Double))
+				{
+					throw CLU_EXCEPTION("Map images have to be Lum images of Single or Double values");
+				}
+
+				if (xFormatY.iWidth != xFormat.iWidth || xFormatY.iHeight != xFormat.iHeight
+					|| xFormatY.ePixelType != xFormat.ePixelType || xFormatY.eDataType != xFormat.eDataType)
+				{
+					throw CLU_EXCEPTION("Map images differ in format");
+				}
+
+				const unsigned char* pucMapX = (const unsigned char*)imgMapX.DataPointer();
+				const unsigned char* pucMapY = (const unsigned char*)imgMapY.DataPointer();
+				const size_t nPitchX = xFormat.RowPitch();
+				const size_t nPitchY = xFormatY.RowPitch();
+				const bool bDouble = (xFormat.eDataType == EDataType::Double);
+
+				Create(xFormat.iWidth, xFormat.iHeight, [&](double& dX, double& dY, int iX, int iY)
+				{
+					const unsigned char* pucX = pucMapX + size_t(iY) * nPitchX;
+					const unsigned char* pucY = pucMapY + size_t(iY) * nPitchY;
+
+					dX = (bDouble ? ((const double*)pucX)[iX] : double(((const float*)pucX)[iX]));
+					dY = (bDouble ? ((const double*)pucY)[iX] : double(((const float*)pucY)[iX]));
+					return true;
+				});
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating remap LUT from maps")
+		}
+
+		void CRemapLut::Destroy()
+		{
+			m_iWidth = 0;
+			m_iHeight = 0;
+			std::vector<SEntry>().swap(m_vecEntry);
+		}
+
+		void CRemapLut::Save(const std::string& sFilename) const
+		{
+			try
+			{
+				if (!IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid remap LUT");
+				}
+
+				std::ofstream xFile(sFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+				if (!xFile.is_open())
+				{
+					throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' could not be created");
+				}
+
+				SRemapLutHeader xHeader;
+				memset(&xHeader, 0, sizeof(xHeader));
+				memcpy(xHeader.pcMagic, RemapLutMagic, sizeof(RemapLutMagic));
+				xHeader.uVersion = RemapLutVersion;
+				xHeader.uFractionBits = uint32_t(FractionBits);
+				xHeader.iWidth = m_iWidth;
+				xHeader.iHeight = m_iHeight;
+
+				xFile.write((const char*)&xHeader, sizeof(xHeader));
+				xFile.write((const char*)m_vecEntry.data(), std::streamsize(m_vecEntry.size() * sizeof(SEntry)));
+
+				if (!xFile.good())
+				{
+					throw CLU_EXCEPTION(CLU_S "Error writing file '" << sFilename.c_str() << "'");
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error saving remap LUT")
+		}
+
+		void CRemapLut::Load(const std::string& sFilename)
+		{
+			try
+			{
+				std::ifstream xFile(sFilename, std::ios::in | std::ios::binary);
+				if (!xFile.is_open())
+				{
+					throw CLU_EXCEPT_TYPE(FileNotFound, CLU_S "File '" << sFilename.c_str() << "' could not be opened");
+				}
+
+				SRemapLutHeader xHeader;
+				xFile.read((char*)&xHeader, sizeof(xHeader));
+
+				if (!xFile.good() || memcmp(xHeader.pcMagic, RemapLutMagic, sizeof(RemapLutMagic)) != 0
+					|| xHeader.uVersion != RemapLutVersion || xHeader.uFractionBits != uint32_t(FractionBits)
+					|| xHeader.iWidth <= 0 || xHeader.iHeight <= 0)
+				{
+					throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' is not a remap LUT");
+				}
+
+				std::vector<SEntry> vecEntry(size_t(xHeader.iWidth) * size_t(xHeader.iHeight));
+				xFile.read((char*)vecEntry.data(), std::streamsize(vecEntry.size() * sizeof(SEntry)));
+
+				if (!xFile.good())
+				{
+					throw CLU_EXCEPTION(CLU_S "Remap LUT '" << sFilename.c_str() << "' is truncated");
+				}
+
+				m_iWidth = xHeader.iWidth;
+				m_iHeight = xHeader.iHeight;
+				m_vecEntry.swap(vecEntry);
+			}
+			CLU_CATCH_RETHROW_ALL("Error loading remap LUT")
+		}
+
+		void RemapImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, const CRemapLut& xLut, ERemapInterpolation eInterpolation, EBorderMode eBorderMode, double dBorderValue)
+		{
+			if (pTrgData == nullptr || pSrcData == nullptr)
+			{
+				throw CLU_EXCEPTION("Invalid image data");
+			}
+
+			if (!xLut.IsValid())
+			{
+				throw CLU_EXCEPTION("Invalid remap LUT");
+			}
+
+			if (xTrgFormat.iWidth != xLut.Width() || xTrgFormat.iHeight != xLut.Height())
+			{
+				throw CLU_EXCEPTION("Target size differs from the LUT size");
+			}
+
+			if (xTrgFormat.ePixelType != xSrcFormat.ePixelType || xTrgFormat.eDataType != xSrcFormat.eDataType)
+			{
+				throw CLU_EXCEPTION("Target and source images differ in type");
+			}
+
+			_CheckSource(xSrcFormat);
+
+			const SPlane xTrg{ (unsigned char*)pTrgData, xTrgFormat.RowPitch(), xTrgFormat.eDataType };
+			const SPlane xSrc{ (unsigned char*)pSrcData, xSrcFormat.RowPitch(), xSrcFormat.eDataType };
+
+			_RemapPlane(xTrg, xSrc, size_t(xSrcFormat.iWidth), size_t(xSrcFormat.iHeight), SImageType::DimOf(xSrcFormat.ePixelType)
+				, xLut, eInterpolation, eBorderMode, dBorderValue);
+		}
+
+		void RemapImage(CIImage& imgTrg, const CIImage& imgSrc, const CRemapLut& xLut
+			, ERemapInterpolation eInterpolation, EBorderMode eBorderMode, double dBorderValue)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				if (!xLut.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid remap LUT");
+				}
+
+				// The target may share the memory of the source.
+				CIImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CIImage&)imgTrg).DataPointer() == imgSrc.DataPointer())
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				imgTrg.Create(_TargetFormat(imgSource.Format(), xLut));
+
+				RemapImageData(imgTrg.DataPointer(), imgTrg.Format(), ((const CIImage&)imgSource).DataPointer(), imgSource.Format(), xLut
+					, eInterpolation, eBorderMode, dBorderValue);
+			}
+			CLU_CATCH_RETHROW_ALL("Error remapping image")
+		}
+
+		void RemapImage(CILayerImage& imgTrg, const CILayerImage& imgSrc, const CRemapLut& xLut
+			, ERemapInterpolation eInterpolation, EBorderMode eBorderMode, double dBorderValue)
+		{
+			try
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid source image");
+				}
+
+				if (!xLut.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid remap LUT");
+				}
+
+				_CheckSource(imgSrc.Format());
+
+				// The target may share the memory of the source.
+				CILayerImage imgSource = imgSrc;
+				if (imgTrg.IsValid() && ((const CILayerImage&)imgTrg).DataPointer(0) == imgSrc.DataPointer(0))
+				{
+					imgSource = imgSrc.Copy();
+				}
+
+				const SImageFormat& xSrcFormat = imgSource.Format();
+				imgTrg.Create(_TargetFormat(xSrcFormat, xLut));
+
+				for (size_t nLayer = 0; nLayer < imgSource.LayerCount(); ++nLayer)
+				{
+					const SPlane xTrg{ (unsigned char*)imgTrg.DataPointer(nLayer), imgTrg.LayerRowPitch(), xSrcFormat.eDataType };
+					const SPlane xSrc{ (unsigned char*)((const CILayerImage&)imgSource).DataPointer(nLayer), imgSource.LayerRowPitch(), xSrcFormat.eDataType };
+
+					_RemapPlane(xTrg, xSrc, size_t(xSrcFormat.iWidth), size_t(xSrcFormat.iHeight), 1, xLut, eInterpolation, eBorderMode, dBorderValue);
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error remapping layer image")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Remap.h
+//
+// summary:   Declares the remapping of images through a precomputed lookup table
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+#include "Image.Filter.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		/// <summary>	The sampling of the source image at the positions of a remap LUT. </summary>
+		enum class ERemapInterpolation
+		{
+			/// <summary>	The value of the nearest pixel. </summary>
+			Nearest = 0,
+
+			/// <summary>	Linear interpolation between the 2x2 surrounding pixels. </summary>
+			Bilinear,
+
+			/// <summary>	Catmull-Rom cubic interpolation between the 4x4 surrounding pixels. </summary>
+			Bicubic,
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	A lookup table that gives for each pixel of a target image the position in a source image to sample.
+		/// 	Positions are in source pixels with the pixel centers at integer coordinates, as returned by
+		/// 	_CSensor::Map_SensorM_to_PixelF(). They are stored in fixed point with 16 bit integer parts and
+		/// 	FractionBits fractional bits, so the map is evaluated once and applied to any number of frames.
+		/// 	Target pixels without a source position, for example behind the camera, take the border value.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CRemapLut
+		{
+		public:
+			static const int FractionBits = 5;
+			static const int FractionCount = 1 << FractionBits;
+
+			/// <summary>	Marks an entry without a source position. </summary>
+			static const uint16_t InvalidFraction = 0x8000;
+
+			/// <summary>	The source position of one target pixel. </summary>
+			struct SEntry
+			{
+				int16_t iX;
+				int16_t iY;
+
+				/// <summary>	The fraction of x in the low FractionBits bits, the fraction of y above it. </summary>
+				uint16_t uFraction;
+			};
+
+			/// <summary>
+			/// 	Maps the target pixel (iX, iY) to the source position (dX, dY). Return false if the pixel has no
+			/// 	source position. The function is called from several threads at once.
+			/// </summary>
+			using TMapFunc = std::function<bool(double& dX, double& dY, int iX, int iY)>;
+
+		public:
+			CRemapLut();
+
+			bool IsValid() const
+			{
+				return m_iWidth > 0 && m_iHeight > 0;
+			}
+
+			int Width() const
+			{
+				return m_iWidth;
+			}
+
+			int Height() const
+			{
+				return m_iHeight;
+			}
+
+			const SEntry* Row(int iY) const
+			{
+				return m_vecEntry.data() + size_t(iY) * size_t(m_iWidth);
+			}
+
+			/// <summary>	Evaluates the map for every pixel of a target image of the given size, in parallel. </summary>
+			void Create(int iWidth, int iHeight, const TMapFunc& funcMap);
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Creates the LUT from the projective map (x, y, 1) -> (u, v, w) of target to source pixels, with the
+			/// 	source position (u / w, v / w). Pixels with w <= 0 have no source position.
+			/// </summary>
+			///
+			/// <param name="iWidth"> 	The target width. </param>
+			/// <param name="iHeight">	The target height. </param>
+			/// <param name="pdH">		The 3x3 matrix in rows. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void CreateHomography(int iWidth, int iHeight, const double pdH[9]);
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Creates the LUT from the x and y source positions stored in two Lum images. </summary>
+			///
+			/// <param name="imgMapX">	The x positions as Single or Double. NaN marks pixels without a position. </param>
+			/// <param name="imgMapY">	The y positions, of the same format. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void CreateFromMaps(const CIImage& imgMapX, const CIImage& imgMapY);
+
+			void Destroy();
+
+			/// <summary>	Writes the LUT to a binary file. </summary>
+			void Save(const std::string& sFilename) const;
+
+			/// <summary>	Reads a LUT written by Save(). </summary>
+			void Load(const std::string& sFilename);
+
+		protected:
+			int m_iWidth;
+			int m_iHeight;
+			std::vector<SEntry> m_vecEntry;
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Remaps an image memory block with a LUT. The target is processed in tiles of a few thousand pixels in
+		/// 	parallel, so that the source pixels a tile reads stay in the cache. The interpolation weights of each
+		/// 	position are taken from tables and applied with SIMD kernels in single precision, or in double
+		/// 	precision for 32 bit integer and double values. Integer targets are rounded and saturated.
+		/// </summary>
+		///
+		/// <param name="pTrgData">	   	The target memory. It must not overlap the source memory. </param>
+		/// <param name="xTrgFormat">  	The target format, of the LUT size and the source type. </param>
+		/// <param name="pSrcData">	   	The source memory. </param>
+		/// <param name="xSrcFormat">  	The source format. Width and height may not exceed 32767. </param>
+		/// <param name="xLut">		   	The LUT. </param>
+		/// <param name="eInterpolation">	The sampling of the source. </param>
+		/// <param name="eBorderMode"> 	The values read outside of the source. </param>
+		/// <param name="dBorderValue">	The value of EBorderMode::Constant and of pixels without a source position. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void RemapImageData(void* pTrgData, const SImageFormat& xTrgFormat, const void* pSrcData, const SImageFormat& xSrcFormat
+			, const CRemapLut& xLut, ERemapInterpolation eInterpolation, EBorderMode eBorderMode, double dBorderValue = 0.0);
+
+		/// <summary>	Creates the target image with the LUT size and the source type and remaps the source into it. </summary>
+		void RemapImage(CIImage& imgTrg, const CIImage& imgSrc, const CRemapLut& xLut
+			, ERemapInterpolation eInterpolation = ERemapInterpolation::Bilinear, EBorderMode eBorderMode = EBorderMode::Constant
+			, double dBorderValue = 0.0);
+
+		/// <summary>	Creates the target layer image and remaps each layer of the source. </summary>
+		void RemapImage(CILayerImage& imgTrg, const CILayerImage& imgSrc, const CRemapLut& xLut
+			, ERemapInterpolation eInterpolation = ERemapInterpolation::Bilinear, EBorderMode eBorderMode = EBorderMode::Constant
+			, double dBorderValue = 0.0);
+
+	} // namespace ImgProc
+} // namespace Clu
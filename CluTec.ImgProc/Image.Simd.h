@@ -0,0 +1,308 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Simd.h
+//
+// summary:   Declares SSE2 helpers shared by the image kernels
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include <immintrin.h>
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Simd
+		{
+			inline __m128i Load(const void* pData)
+			{
+				return _mm_loadu_si128((const __m128i*)pData);
+			}
+
+			inline void Store(void* pData, __m128i mV)
+			{
+				_mm_storeu_si128((__m128i*)pData, mV);
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Two way shuffles by element size in bytes. Zip interleaves the elements of two vectors, Unzip splits
+			/// 	two consecutive vectors into their even and odd elements. An element size of 16 bytes is the identity.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<size_t t_nSize> struct SZip;
+
+			template<> struct SZip<1>
+			{
+				static void Zip(__m128i mA, __m128i mB, __m128i& mLo, __m128i& mHi)
+				{
+					mLo = _mm_unpacklo_epi8(mA, mB);
+					mHi = _mm_unpackhi_epi8(mA, mB);
+				}
+
+				static void Unzip(__m128i mX0, __m128i mX1, __m128i& mEven, __m128i& mOdd)
+				{
+					const __m128i mMask = _mm_set1_epi16(0x00FF);
+					mEven = _mm_packus_epi16(_mm_and_si128(mX0, mMask), _mm_and_si128(mX1, mMask));
+					mOdd = _mm_packus_epi16(_mm_srli_epi16(mX0, 8), _mm_srli_epi16(mX1, 8));
+				}
+			};
+
+			template<> struct SZip<2>
+			{
+				static void Zip(__m128i mA, __m128i mB, __m128i& mLo, __m128i& mHi)
+				{
+					mLo = _mm_unpacklo_epi16(mA, mB);
+					mHi = _mm_unpackhi_epi16(mA, mB);
+				}
+
+				static void Unzip(__m128i mX0, __m128i mX1, __m128i& mEven, __m128i& mOdd)
+				{
+					// Sign extended 16 bit values pass the signed saturation of the pack unchanged.
+					mEven = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(mX0, 16), 16), _mm_srai_epi32(_mm_slli_epi32(mX1, 16), 16));
+					mOdd = _mm_packs_epi32(_mm_srai_epi32(mX0, 16), _mm_srai_epi32(mX1, 16));
+				}
+			};
+
+			template<> struct SZip<4>
+			{
+				static void Zip(__m128i mA, __m128i mB, __m128i& mLo, __m128i& mHi)
+				{
+					mLo = _mm_unpacklo_epi32(mA, mB);
+					mHi = _mm_unpackhi_epi32(mA, mB);
+				}
+
+				static void Unzip(__m128i mX0, __m128i mX1, __m128i& mEven, __m128i& mOdd)
+				{
+					const __m128 mF0 = _mm_castsi128_ps(mX0);
+					const __m128 mF1 = _mm_castsi128_ps(mX1);
+					mEven = _mm_castps_si128(_mm_shuffle_ps(mF0, mF1, _MM_SHUFFLE(2, 0, 2, 0)));
+					mOdd = _mm_castps_si128(_mm_shuffle_ps(mF0, mF1, _MM_SHUFFLE(3, 1, 3, 1)));
+				}
+			};
+
+			template<> struct SZip<8>
+			{
+				static void Zip(__m128i mA, __m128i mB, __m128i& mLo, __m128i& mHi)
+				{
+					mLo = _mm_unpacklo_epi64(mA, mB);
+					mHi = _mm_unpackhi_epi64(mA, mB);
+				}
+
+				static void Unzip(__m128i mX0, __m128i mX1, __m128i& mEven, __m128i& mOdd)
+				{
+					mEven = _mm_unpacklo_epi64(mX0, mX1);
+					mOdd = _mm_unpackhi_epi64(mX0, mX1);
+				}
+			};
+
+			template<> struct SZip<16>
+			{
+				static void Zip(__m128i mA, __m128i mB, __m128i& mLo, __m128i& mHi)
+				{
+					mLo = mA;
+					mHi = mB;
+				}
+
+				static void Unzip(__m128i mX0, __m128i mX1, __m128i& mEven, __m128i& mOdd)
+				{
+					mEven = mX0;
+					mOdd = mX1;
+				}
+			};
+
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Conversions between the data types and the accumulation type. The SIMD conversions round as the
+			// scalar ones, to the nearest value with ties to even.
+			// ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename T, typename TAcc, bool t_bFloat = std::is_floating_point<T>::value>
+			struct SConvertScalar
+			{
+				static void Load(TAcc* pTrg, const T* pSrc, size_t nCount)
+				{
+					for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+					{
+						pTrg[nIdx] = TAcc(pSrc[nIdx]);
+					}
+				}
+
+				static void Store(T* pTrg, const TAcc* pSrc, size_t nCount)
+				{
+					const double dMin = double(std::numeric_limits<T>::lowest());
+					const double dMax = double(std::numeric_limits<T>::max());
+
+					for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+					{
+						pTrg[nIdx] = T(llrint(std::min(std::max(double(pSrc[nIdx]), dMin), dMax)));
+					}
+				}
+			};
+
+			template<typename T, typename TAcc>
+			struct SConvertScalar<T, TAcc, true>
+			{
+				static void Load(TAcc* pTrg, const T* pSrc, size_t nCount)
+				{
+					for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+					{
+						pTrg[nIdx] = TAcc(pSrc[nIdx]);
+					}
+				}
+
+				static void Store(T* pTrg, const TAcc* pSrc, size_t nCount)
+				{
+					for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+					{
+						pTrg[nIdx] = T(pSrc[nIdx]);
+					}
+				}
+			};
+
+			template<typename T, typename TAcc>
+			struct SConvert : public SConvertScalar<T, TAcc>
+			{
+			};
+
+			template<>
+			struct SConvert<uint8_t, float>
+			{
+				static void Load(float* pTrg, const uint8_t* pSrc, size_t nCount)
+				{
+					const __m128i mZero = _mm_setzero_si128();
+
+					size_t nIdx = 0;
+					for (; nIdx + 16 <= nCount; nIdx += 16)
+					{
+						const __m128i mV = Simd::Load(pSrc + nIdx);
+						const __m128i mLo = _mm_unpacklo_epi8(mV, mZero);
+						const __m128i mHi = _mm_unpackhi_epi8(mV, mZero);
+
+						_mm_storeu_ps(pTrg + nIdx, _mm_cvtepi32_ps(_mm_unpacklo_epi16(mLo, mZero)));
+						_mm_storeu_ps(pTrg + nIdx + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(mLo, mZero)));
+						_mm_storeu_ps(pTrg + nIdx + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(mHi, mZero)));
+						_mm_storeu_ps(pTrg + nIdx + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(mHi, mZero)));
+					}
+
+					SConvertScalar<uint8_t, float>::Load(pTrg + nIdx, pSrc + nIdx, nCount - nIdx);
+				}
+
+				static void Store(uint8_t* pTrg, const float* pSrc, size_t nCount)
+				{
+					const __m128 mMin = _mm_setzero_ps();
+					const __m128 mMax = _mm_set1_ps(255.0f);
+
+					size_t nIdx = 0;
+					for (; nIdx + 16 <= nCount; nIdx += 16)
+					{
+						__m128i pmV[4];
+						for (size_t nPart = 0; nPart < 4; ++nPart)
+						{
+							pmV[nPart] = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + nIdx + 4 * nPart), mMin), mMax));
+						}
+
+						Simd::Store(pTrg + nIdx, _mm_packus_epi16(_mm_packs_epi32(pmV[0], pmV[1]), _mm_packs_epi32(pmV[2], pmV[3])));
+					}
+
+					SConvertScalar<uint8_t, float>::Store(pTrg + nIdx, pSrc + nIdx, nCount - nIdx);
+				}
+			};
+
+			template<>
+			struct SConvert<uint16_t, float>
+			{
+				static void Load(float* pTrg, const uint16_t* pSrc, size_t nCount)
+				{
+					const __m128i mZero = _mm_setzero_si128();
+
+					size_t nIdx = 0;
+					for (; nIdx + 8 <= nCount; nIdx += 8)
+					{
+						const __m128i mV = Simd::Load(pSrc + nIdx);
+						_mm_storeu_ps(pTrg + nIdx, _mm_cvtepi32_ps(_mm_unpacklo_epi16(mV, mZero)));
+						_mm_storeu_ps(pTrg + nIdx + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(mV, mZero)));
+					}
+
+					SConvertScalar<uint16_t, float>::Load(pTrg + nIdx, pSrc + nIdx, nCount - nIdx);
+				}
+
+				static void Store(uint16_t* pTrg, const float* pSrc, size_t nCount)
+				{
+					// SSE2 has no unsigned 32 to 16 bit pack. Shift the values into the signed range and back.
+					const __m128 mMin = _mm_setzero_ps();
+					const __m128 mMax = _mm_set1_ps(65535.0f);
+					const __m128i mBias32 = _mm_set1_epi32(0x8000);
+					const __m128i mBias16 = _mm_set1_epi16(short(0x8000));
+
+					size_t nIdx = 0;
+					for (; nIdx + 8 <= nCount; nIdx += 8)
+					{
+						const __m128i mA = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + nIdx), mMin), mMax));
+						const __m128i mB = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + nIdx + 4), mMin), mMax));
+						Simd::Store(pTrg + nIdx, _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(mA, mBias32), _mm_sub_epi32(mB, mBias32)), mBias16));
+					}
+
+					SConvertScalar<uint16_t, float>::Store(pTrg + nIdx, pSrc + nIdx, nCount - nIdx);
+				}
+			};
+
+			template<>
+			struct SConvert<int16_t, float>
+			{
+				static void Load(float* pTrg, const int16_t* pSrc, size_t nCount)
+				{
+					size_t nIdx = 0;
+					for (; nIdx + 8 <= nCount; nIdx += 8)
+					{
+						const __m128i mV = Simd::Load(pSrc + nIdx);
+						_mm_storeu_ps(pTrg + nIdx, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(mV, mV), 16)));
+						_mm_storeu_ps(pTrg + nIdx + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(mV, mV), 16)));
+					}
+
+					SConvertScalar<int16_t, float>::Load(pTrg + nIdx, pSrc + nIdx, nCount - nIdx);
+				}
+
+				static void Store(int16_t* pTrg, const float* pSrc, size_t nCount)
+				{
+					const __m128 mMin = _mm_set1_ps(-32768.0f);
+					const __m128 mMax = _mm_set1_ps(32767.0f);
+
+					size_t nIdx = 0;
+					for (; nIdx + 8 <= nCount; nIdx += 8)
+					{
+						const __m128i mA = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + nIdx), mMin), mMax));
+						const __m128i mB = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + nIdx + 4), mMin), mMax));
+						Simd::Store(pTrg + nIdx, _mm_packs_epi32(mA, mB));
+					}
+
+					SConvertScalar<int16_t, float>::Store(pTrg + nIdx, pSrc + nIdx, nCount - nIdx);
+				}
+			};
+
+			template<>
+			struct SConvert<float, float>
+			{
+				static void Load(float* pTrg, const float* pSrc, size_t nCount)
+				{
+					memcpy(pTrg, pSrc, nCount * sizeof(float));
+				}
+
+				static void Store(float* pTrg, const float* pSrc, size_t nCount)
+				{
+					memcpy(pTrg, pSrc, nCount * sizeof(float));
+				}
+			};
+		} // namespace Simd
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Statistics.Avx2.cpp
+//
+// summary:   Implements the AVX2 lane of the image statistics
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+
+#include <immintrin.h>
+
+#include "Image.Avx2.h"
+#include "Image.Statistics.Simd.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Avx2
+		{
+			namespace
+			{
+				struct SLaneDouble
+				{
+					using TVec = __m256d;
+					static const size_t Width = MomentLaneWidth;
+
+					static TVec Zero() { return _mm256_setzero_pd(); }
+					static TVec Set1(double dValue) { return _mm256_set1_pd(dValue); }
+					static TVec Load(const double* pData) { return _mm256_loadu_pd(pData); }
+					static TVec Load(const float* pData) { return _mm256_cvtps_pd(_mm_loadu_ps(pData)); }
+					static TVec Load(const int32_t* pData) { return _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)pData)); }
+
+					static TVec Load(const uint32_t* pData)
+					{
+						// Convert with flipped sign bit as signed value and add the offset back.
+						const __m128i mV = _mm_xor_si128(_mm_loadu_si128((const __m128i*)pData), _mm_set1_epi32(INT32_MIN));
+						return _mm256_add_pd(_mm256_cvtepi32_pd(mV), _mm256_set1_pd(2147483648.0));
+					}
+
+					static void Store(double* pData, TVec mV) { _mm256_storeu_pd(pData, mV); }
+					static TVec Add(TVec mA, TVec mB) { return _mm256_add_pd(mA, mB); }
+					static TVec Sub(TVec mA, TVec mB) { return _mm256_sub_pd(mA, mB); }
+					static TVec Mul(TVec mA, TVec mB) { return _mm256_mul_pd(mA, mB); }
+					static TVec Min(TVec mA, TVec mB) { return _mm256_min_pd(mA, mB); }
+					static TVec Max(TVec mA, TVec mB) { return _mm256_max_pd(mA, mB); }
+					static TVec And(TVec mA, TVec mB) { return _mm256_and_pd(mA, mB); }
+					static TVec Ordered(TVec mV) { return _mm256_cmp_pd(mV, mV, _CMP_ORD_Q); }
+				};
+
+				template<typename TValue>
+				size_t _AccumulateMoments(Simd::SLaneMoments& xLanes, const TValue* pRow, size_t nCount, size_t nPeriod)
+				{
+					switch (nPeriod)
+					{
+					case 1:
+						return Simd::AccumulateMoments<SLaneDouble, 1>(xLanes, pRow, nCount);
+					case 2:
+						return Simd::AccumulateMoments<SLaneDouble, 2>(xLanes, pRow, nCount);
+					case 3:
+						return Simd::AccumulateMoments<SLaneDouble, 3>(xLanes, pRow, nCount);
+					default:
+						return 0;
+					}
+				}
+			} // namespace
+
+			size_t AccumulateMoments(Simd::SLaneMoments& xLanes, const int32_t* pRow, size_t nCount, size_t nPeriod)
+			{
+				return _AccumulateMoments(xLanes, pRow, nCount, nPeriod);
+			}
+
+			size_t AccumulateMoments(Simd::SLaneMoments& xLanes, const uint32_t* pRow, size_t nCount, size_t nPeriod)
+			{
+				return _AccumulateMoments(xLanes, pRow, nCount, nPeriod);
+			}
+
+			size_t AccumulateMoments(Simd::SLaneMoments& xLanes, const float* pRow, size_t nCount, size_t nPeriod)
+			{
+				return _AccumulateMoments(xLanes, pRow, nCount, nPeriod);
+			}
+
+			size_t AccumulateMoments(Simd::SLaneMoments& xLanes, const double* pRow, size_t nCount, size_t nPeriod)
+			{
+				return _AccumulateMoments(xLanes, pRow, nCount, nPeriod);
+			}
+		} // namespace Avx2
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Statistics.Simd.h
+//
+// summary:   Declares the moment accumulation shared by the SSE2 and the AVX2 image statistics
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stddef.h>
+
+// Image.Statistics.cpp and Image.Statistics.Avx2.cpp instantiate the accumulation with their own lane types, so the
+// instances compiled for different instruction sets are different functions.
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace Simd
+		{
+			/// <summary>
+			/// 	The moment sums of the SIMD lanes. They are kept in memory between the rows, so that the SSE2 and the
+			/// 	AVX2 code share them. Lane i sees channel i modulo the channel count.
+			/// </summary>
+			struct SLaneMoments
+			{
+				/// <summary>	The maximal number of lanes, three vectors of four doubles. </summary>
+				static const size_t MaxLaneCount = 12;
+
+				double pdShift[MaxLaneCount];
+				double pdMin[MaxLaneCount];
+				double pdMax[MaxLaneCount];
+				double pdSum[MaxLaneCount];
+				double pdSumSq[MaxLaneCount];
+				double pdCount[MaxLaneCount];
+			};
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Accumulates the moments of interleaved channels in SIMD lanes. A step of t_nPeriod vectors covers a
+			/// 	whole number of pixels, so every lane always sees the same channel.
+			/// </summary>
+			///
+			/// <returns>	The number of values processed, the leading whole steps of the row. </returns>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename TLane, size_t t_nPeriod, typename TValue>
+			size_t AccumulateMoments(SLaneMoments& xLanes, const TValue* pRow, size_t nCount)
+			{
+				using TVec = typename TLane::TVec;
+				const size_t nWidth = TLane::Width;
+				const size_t nStep = t_nPeriod * nWidth;
+				const TVec mOne = TLane::Set1(1.0);
+
+				TVec pmShift[t_nPeriod], pmMin[t_nPeriod], pmMax[t_nPeriod], pmSum[t_nPeriod], pmSumSq[t_nPeriod], pmCount[t_nPeriod];
+				for (size_t nVec = 0; nVec < t_nPeriod; ++nVec)
+				{
+					pmShift[nVec] = TLane::Load(xLanes.pdShift + nVec * nWidth);
+					pmMin[nVec] = TLane::Load(xLanes.pdMin + nVec * nWidth);
+					pmMax[nVec] = TLane::Load(xLanes.pdMax + nVec * nWidth);
+					pmSum[nVec] = TLane::Load(xLanes.pdSum + nVec * nWidth);
+					pmSumSq[nVec] = TLane::Load(xLanes.pdSumSq + nVec * nWidth);
+					pmCount[nVec] = TLane::Load(xLanes.pdCount + nVec * nWidth);
+				}
+
+				size_t nIdx = 0;
+				for (; nIdx + nStep <= nCount; nIdx += nStep)
+				{
+					for (size_t nVec = 0; nVec < t_nPeriod; ++nVec)
+					{
+						const TVec mV = TLane::Load(pRow + nIdx + nVec * nWidth);
+
+						// Min and max return their second operand if the first is NaN.
+						pmMin[nVec] = TLane::Min(mV, pmMin[nVec]);
+						pmMax[nVec] = TLane::Max(mV, pmMax[nVec]);
+
+						const TVec mValid = TLane::Ordered(mV);
+						const TVec mDiff = TLane::And(mValid, TLane::Sub(mV, pmShift[nVec]));
+						pmSum[nVec] = TLane::Add(pmSum[nVec], mDiff);
+						pmSumSq[nVec] = TLane::Add(pmSumSq[nVec], TLane::Mul(mDiff, mDiff));
+						pmCount[nVec] = TLane::Add(pmCount[nVec], TLane::And(mValid, mOne));
+					}
+				}
+
+				for (size_t nVec = 0; nVec < t_nPeriod; ++nVec)
+				{
+					TLane::Store(xLanes.pdMin + nVec * nWidth, pmMin[nVec]);
+					TLane::Store(xLanes.pdMax + nVec * nWidth, pmMax[nVec]);
+					TLane::Store(xLanes.pdSum + nVec * nWidth, pmSum[nVec]);
+					TLane::Store(xLanes.pdSumSq + nVec * nWidth, pmSumSq[nVec]);
+					TLane::Store(xLanes.pdCount + nVec * nWidth, pmCount[nVec]);
+				}
+
+				return nIdx;
+			}
+		} // namespace Simd
+	} // namespace ImgProc
+} // namespace Clu
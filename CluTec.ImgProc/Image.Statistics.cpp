@@ -0,0 +1,773 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Statistics.cpp
+//
+// summary:   Implements per channel image statistics
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "Image.Statistics.h"
+#include "Image.Statistics.Simd.h"
+#include "Image.Avx2.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/IntrinsicFunctions.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	The minimal number of pixels per parallel block. </summary>
+			const size_t MinBlockPixelCount = size_t(1) << 16;
+
+			/// <summary>	The minimal number of pixels per parallel block when counting 16 bit values, whose per thread histograms are large. </summary>
+			const size_t MinBlockPixelCount16 = size_t(1) << 20;
+
+			/// <summary>	Maps values of a closed range to histogram bins. </summary>
+			struct SBinning
+			{
+				double dMin;
+				double dMax;
+				double dScale;
+				size_t nBinCount;
+
+				SBinning()
+					: dMin(0.0)
+					, dMax(0.0)
+					, dScale(0.0)
+					, nBinCount(0)
+				{
+				}
+
+				SBinning(double _dMin, double _dMax, size_t _nBinCount)
+					: dMin(_dMin)
+					, dMax(_dMax)
+					, dScale(_dMax > _dMin ? double(_nBinCount) / (_dMax - _dMin) : 0.0)
+					, nBinCount(_nBinCount)
+				{
+				}
+
+				/// <summary>	Adds a count to the bin of a value, or to the below or above count. NaN values are ignored. </summary>
+				void Add(uint64_t* puBin, uint64_t& uBelow, uint64_t& uAbove, double dValue, uint64_t uCount) const
+				{
+					if (dValue < dMin)
+					{
+						uBelow += uCount;
+					}
+					else if (dValue > dMax)
+					{
+						uAbove += uCount;
+					}
+					else if (dValue == dValue)
+					{
+						// The maximum of the range belongs to the last bin.
+						puBin[std::min(size_t((dValue - dMin) * dScale), nBinCount - 1)] += uCount;
+					}
+				}
+			};
+
+			void _SetHistogram(SHistogram& xHistogram, const SBinning& xBinning, const uint64_t* puBin, uint64_t uBelow, uint64_t uAbove)
+			{
+				xHistogram.dMin = xBinning.dMin;
+				xHistogram.dMax = xBinning.dMax;
+				xHistogram.uBelowCount = uBelow;
+				xHistogram.uAboveCount = uAbove;
+				xHistogram.vecBin.assign(puBin, puBin + xBinning.nBinCount);
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			// Integer types up to 16 bit: every value has its own counter.
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			template<typename TValue> struct SCountTraits;
+
+			template<> struct SCountTraits<uint8_t>
+			{
+				static const int Offset = 0;
+				static const size_t Size = 256;
+			};
+
+			template<> struct SCountTraits<int8_t>
+			{
+				static const int Offset = 128;
+				static const size_t Size = 256;
+			};
+
+			template<> struct SCountTraits<uint16_t>
+			{
+				static const int Offset = 0;
+				static const size_t Size = 65536;
+			};
+
+			template<> struct SCountTraits<int16_t>
+			{
+				static const int Offset = 32768;
+				static const size_t Size = 65536;
+			};
+
+			/// <summary>	Counts the values of a row, where value i goes to counter array i modulo t_nArrays. </summary>
+			template<typename TValue, size_t t_nArrays>
+			void _CountRow(uint32_t* puCount, const TValue* pRow, size_t nCount)
+			{
+				using TTraits = SCountTraits<TValue>;
+
+				size_t nIdx = 0;
+				for (; nIdx + t_nArrays <= nCount; nIdx += t_nArrays)
+				{
+					for (size_t nArray = 0; nArray < t_nArrays; ++nArray)
+					{
+						++puCount[nArray * TTraits::Size + size_t(int(pRow[nIdx + nArray]) + TTraits::Offset)];
+					}
+				}
+
+				for (size_t nArray = 0; nIdx < nCount; ++nIdx, ++nArray)
+				{
+					++puCount[nArray * TTraits::Size + size_t(int(pRow[nIdx]) + TTraits::Offset)];
+				}
+			}
+
+			template<typename TValue>
+			void _CountRow(uint32_t* puCount, const TValue* pRow, size_t nCount, size_t nArrays)
+			{
+				using TTraits = SCountTraits<TValue>;
+
+				switch (nArrays)
+				{
+				case 1:
+					_CountRow<TValue, 1>(puCount, pRow, nCount);
+					break;
+				case 2:
+					_CountRow<TValue, 2>(puCount, pRow, nCount);
+					break;
+				case 3:
+					_CountRow<TValue, 3>(puCount, pRow, nCount);
+					break;
+				case 4:
+					_CountRow<TValue, 4>(puCount, pRow, nCount);
+					break;
+				default:
+					for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+					{
+						++puCount[(nIdx % nArrays) * TTraits::Size + size_t(int(pRow[nIdx]) + TTraits::Offset)];
+					}
+					break;
+				}
+			}
+
+			template<typename TValue>
+			void _CountRowMasked(uint32_t* puCount, const TValue* pRow, const uint8_t* pucMask, size_t nWidth, size_t nChannels)
+			{
+				using TTraits = SCountTraits<TValue>;
+
+				for (size_t nX = 0; nX < nWidth; ++nX, pRow += nChannels)
+				{
+					if (pucMask[nX] != 0)
+					{
+						for (size_t nChannel = 0; nChannel < nChannels; ++nChannel)
+						{
+							++puCount[nChannel * TTraits::Size + size_t(int(pRow[nChannel]) + TTraits::Offset)];
+						}
+					}
+				}
+			}
+
+			/// <summary>	Derives the statistics of a channel from the counts of all values. </summary>
+			void _StatisticsFromCounts(SChannelStatistics& xStats, const uint64_t* puCount, size_t nSize, int iOffset
+				, const SStatisticsConfig& xConfig)
+			{
+				xStats = SChannelStatistics();
+
+				uint64_t uCount = 0;
+				double dSum = 0.0;
+				size_t nFirst = nSize;
+				size_t nLast = 0;
+
+				for (size_t nValue = 0; nValue < nSize; ++nValue)
+				{
+					if (puCount[nValue] != 0)
+					{
+						uCount += puCount[nValue];
+						dSum += double(puCount[nValue]) * double(int(nValue) - iOffset);
+						nFirst = std::min(nFirst, nValue);
+						nLast = nValue;
+					}
+				}
+
+				if (uCount > 0)
+				{
+					const double dMean = dSum / double(uCount);
+					double dSumSq = 0.0;
+
+					for (size_t nValue = nFirst; nValue <= nLast; ++nValue)
+					{
+						const double dDiff = double(int(nValue) - iOffset) - dMean;
+						dSumSq += double(puCount[nValue]) * dDiff * dDiff;
+					}
+
+					xStats.uCount = uCount;
+					xStats.dMin = double(int(nFirst) - iOffset);
+					xStats.dMax = double(int(nLast) - iOffset);
+					xStats.dMean = dMean;
+					xStats.dVariance = dSumSq / double(uCount);
+				}
+
+				if (xConfig.iBinCount > 0)
+				{
+					const SBinning xBinning = (xConfig.HasRange()
+						? SBinning(xConfig.dRangeMin, xConfig.dRangeMax, size_t(xConfig.iBinCount))
+						: SBinning(double(-iOffset), double(int(nSize) - 1 - iOffset), size_t(xConfig.iBinCount)));
+
+					std::vector<uint64_t> vecBin(xBinning.nBinCount, 0);
+					uint64_t uBelow = 0, uAbove = 0;
+
+					for (size_t nValue = 0; nValue < nSize; ++nValue)
+					{
+						if (puCount[nValue] != 0)
+						{
+							xBinning.Add(vecBin.data(), uBelow, uAbove, double(int(nValue) - iOffset), puCount[nValue]);
+						}
+					}
+
+					_SetHistogram(xStats.xHistogram, xBinning, vecBin.data(), uBelow, uAbove);
+				}
+			}
+
+			template<typename TValue>
+			void _CountStatistics(std::vector<SChannelStatistics>& vecStats, const CIImage& imgSrc, const CIImage* pimgMask
+				, const SStatisticsConfig& xConfig)
+			{
+				using TTraits = SCountTraits<TValue>;
+
+				const SImageFormat& xFormat = imgSrc.Format();
+				const size_t nChannels = SImageType::DimOf(xFormat.ePixelType);
+				const size_t nWidth = size_t(xFormat.iWidth);
+				const size_t nPitch = xFormat.RowPitch();
+				const unsigned char* pucSrc = (const unsigned char*)imgSrc.DataPointer();
+
+				// Several counter arrays per channel keep increments of equal neighboring values independent.
+				size_t nArrays = nChannels;
+				if (pimgMask == nullptr && sizeof(TValue) == 1)
+				{
+					while (nArrays < 4)
+					{
+						nArrays += nChannels;
+					}
+				}
+
+				std::vector<uint64_t> vecTotal(nChannels * TTraits::Size, 0);
+				std::mutex mxTotal;
+
+				const size_t nMinBlockPixels = (sizeof(TValue) == 1 ? MinBlockPixelCount : MinBlockPixelCount16);
+
+				Clu::Parallel::ForEachBlock(size_t(xFormat.iHeight), std::max<size_t>(nMinBlockPixels / nWidth, 1)
+					, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					std::vector<uint32_t> vecCount(nArrays * TTraits::Size, 0);
+
+					auto funcFlush = [&]()
+					{
+						std::lock_guard<std::mutex> xLock(mxTotal);
+						for (size_t nArray = 0; nArray < nArrays; ++nArray)
+						{
+							uint64_t* puTotal = &vecTotal[(nArray % nChannels) * TTraits::Size];
+							uint32_t* puCount = &vecCount[nArray * TTraits::Size];
+
+							for (size_t nValue = 0; nValue < TTraits::Size; ++nValue)
+							{
+								puTotal[nValue] += puCount[nValue];
+								puCount[nValue] = 0;
+							}
+						}
+					};
+
+					// Each row adds at most nWidth to a counter, so the counters are flushed before they can overflow.
+					uint64_t uPending = 0;
+
+					for (size_t nY = nBegin; nY < nEnd; ++nY)
+					{
+						const TValue* pRow = (const TValue*)(pucSrc + nY * nPitch);
+
+						if (pimgMask != nullptr)
+						{
+							const uint8_t* pucMask = (const uint8_t*)pimgMask->DataPointer() + nY * pimgMask->Format().RowPitch();
+							_CountRowMasked(vecCount.data(), pRow, pucMask, nWidth, nChannels);
+						}
+						else
+						{
+							_CountRow(vecCount.data(), pRow, nWidth * nChannels, nArrays);
+						}
+
+						uPending += nWidth;
+						if (uPending > uint64_t(std::numeric_limits<uint32_t>::max()) - nWidth)
+						{
+							funcFlush();
+							uPending = 0;
+						}
+					}
+
+					funcFlush();
+				});
+
+				vecStats.resize(nChannels);
+				for (size_t nChannel = 0; nChannel < nChannels; ++nChannel)
+				{
+					_StatisticsFromCounts(vecStats[nChannel], &vecTotal[nChannel * TTraits::Size], TTraits::Size, TTraits::Offset, xConfig);
+				}
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			// 32 bit integer and floating point types: SIMD moments in double precision, with AVX2 where the
+			// processor supports it and SSE2 otherwise.
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+
+			struct SLaneDouble
+			{
+				using TVec = __m128d;
+				static const size_t Width = 2;
+
+				static TVec Zero() { return _mm_setzero_pd(); }
+				static TVec Set1(double dValue) { return _mm_set1_pd(dValue); }
+				static TVec Load(const double* pData) { return _mm_loadu_pd(pData); }
+				static TVec Load(const float* pData) { return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)pData))); }
+				static TVec Load(const int32_t* pData) { return _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)pData)); }
+
+				static TVec Load(const uint32_t* pData)
+				{
+					// Convert with flipped sign bit as signed value and add the offset back.
+					const __m128i mV = _mm_xor_si128(_mm_loadl_epi64((const __m128i*)pData), _mm_set1_epi32(INT32_MIN));
+					return _mm_add_pd(_mm_cvtepi32_pd(mV), _mm_set1_pd(2147483648.0));
+				}
+
+				static void Store(double* pData, TVec mV) { _mm_storeu_pd(pData, mV); }
+				static TVec Add(TVec mA, TVec mB) { return _mm_add_pd(mA, mB); }
+				static TVec Sub(TVec mA, TVec mB) { return _mm_sub_pd(mA, mB); }
+				static TVec Mul(TVec mA, TVec mB) { return _mm_mul_pd(mA, mB); }
+				static TVec Min(TVec mA, TVec mB) { return _mm_min_pd(mA, mB); }
+				static TVec Max(TVec mA, TVec mB) { return _mm_max_pd(mA, mB); }
+				static TVec And(TVec mA, TVec mB) { return _mm_and_pd(mA, mB); }
+				static TVec Ordered(TVec mV) { return _mm_cmpord_pd(mV, mV); }
+			};
+
+			/// <summary>	The moments of a channel. The sums are of the values minus a shift close to the mean, which keeps the variance accurate. </summary>
+			struct SMoments
+			{
+				double dMin;
+				double dMax;
+				double dSum;
+				double dSumSq;
+				uint64_t uCount;
+
+				SMoments()
+					: dMin(std::numeric_limits<double>::infinity())
+					, dMax(-std::numeric_limits<double>::infinity())
+					, dSum(0.0)
+					, dSumSq(0.0)
+					, uCount(0)
+				{
+				}
+
+				void Add(double dValue, double dShift)
+				{
+					if (dValue == dValue)
+					{
+						const double dDiff = dValue - dShift;
+						dMin = std::min(dMin, dValue);
+						dMax = std::max(dMax, dValue);
+						dSum += dDiff;
+						dSumSq += dDiff * dDiff;
+						++uCount;
+					}
+				}
+
+				void Merge(const SMoments& xMoments)
+				{
+					dMin = std::min(dMin, xMoments.dMin);
+					dMax = std::max(dMax, xMoments.dMax);
+					dSum += xMoments.dSum;
+					dSumSq += xMoments.dSumSq;
+					uCount += xMoments.uCount;
+				}
+			};
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Accumulates the moments of interleaved channels in SIMD lanes with Simd::AccumulateMoments(). The
+			/// 	period is the number of vectors after which the lanes map to the same channels again. Without a
+			/// 	period the scalar code accumulates all values.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			class CLaneMoments
+			{
+			public:
+				CLaneMoments(const double* pdShift, size_t nChannels, bool bEnabled)
+					: m_nChannels(nChannels)
+				{
+					m_bAvx2 = Clu::Intrinsics::HasAvx2();
+					const size_t nWidth = (m_bAvx2 ? Avx2::MomentLaneWidth : SLaneDouble::Width);
+
+					m_nPeriod = 1;
+					while ((m_nPeriod * nWidth) % nChannels != 0)
+					{
+						++m_nPeriod;
+					}
+
+					// The accumulation is instantiated for periods of up to three vectors.
+					if (!bEnabled || m_nPeriod > 3)
+					{
+						m_nPeriod = 0;
+					}
+
+					m_nLaneCount = m_nPeriod * nWidth;
+					for (size_t nLane = 0; nLane < m_nLaneCount; ++nLane)
+					{
+						m_xLanes.pdShift[nLane] = pdShift[nLane % nChannels];
+						m_xLanes.pdMin[nLane] = std::numeric_limits<double>::infinity();
+						m_xLanes.pdMax[nLane] = -std::numeric_limits<double>::infinity();
+						m_xLanes.pdSum[nLane] = 0.0;
+						m_xLanes.pdSumSq[nLane] = 0.0;
+						m_xLanes.pdCount[nLane] = 0.0;
+					}
+				}
+
+				/// <summary>	Accumulates the leading whole steps of a row and returns the number of values processed. </summary>
+				template<typename TValue>
+				size_t Row(const TValue* pRow, size_t nCount)
+				{
+					if (m_bAvx2 && m_nPeriod > 0)
+					{
+						return Avx2::AccumulateMoments(m_xLanes, pRow, nCount, m_nPeriod);
+					}
+
+					switch (m_nPeriod)
+					{
+					case 1:
+						return Simd::AccumulateMoments<SLaneDouble, 1>(m_xLanes, pRow, nCount);
+					case 2:
+						return Simd::AccumulateMoments<SLaneDouble, 2>(m_xLanes, pRow, nCount);
+					case 3:
+						return Simd::AccumulateMoments<SLaneDouble, 3>(m_xLanes, pRow, nCount);
+					default:
+						return 0;
+					}
+				}
+
+				void Reduce(SMoments* pMoments) const
+				{
+					for (size_t nLane = 0; nLane < m_nLaneCount; ++nLane)
+					{
+						SMoments& xMoments = pMoments[nLane % m_nChannels];
+						xMoments.dMin = std::min(xMoments.dMin, m_xLanes.pdMin[nLane]);
+						xMoments.dMax = std::max(xMoments.dMax, m_xLanes.pdMax[nLane]);
+						xMoments.dSum += m_xLanes.pdSum[nLane];
+						xMoments.dSumSq += m_xLanes.pdSumSq[nLane];
+						xMoments.uCount += uint64_t(m_xLanes.pdCount[nLane]);
+					}
+				}
+
+			protected:
+				size_t m_nChannels;
+				size_t m_nPeriod;
+				size_t m_nLaneCount;
+				bool m_bAvx2;
+				Simd::SLaneMoments m_xLanes;
+			};
+
+			/// <summary>	The accumulators of one parallel block. </summary>
+			struct SBlockAccumulator
+			{
+				std::vector<SMoments> vecMoments;
+				std::vector<uint64_t> vecBin;
+				std::vector<uint64_t> vecBelow;
+				std::vector<uint64_t> vecAbove;
+			};
+
+			template<typename TValue>
+			class CMomentStatistics
+			{
+			public:
+				CMomentStatistics(const CIImage& imgSrc, const CIImage* pimgMask)
+					: m_imgSrc(imgSrc)
+					, m_pimgMask(pimgMask)
+					, m_xFormat(imgSrc.Format())
+					, m_nChannels(SImageType::DimOf(imgSrc.Format().ePixelType))
+				{
+					// The first pixel of each channel is close enough to the mean to shift the sums.
+					const TValue* pFirst = (const TValue*)m_imgSrc.DataPointer();
+					m_vecShift.resize(m_nChannels);
+
+					for (size_t nChannel = 0; nChannel < m_nChannels; ++nChannel)
+					{
+						const double dValue = double(pFirst[nChannel]);
+						m_vecShift[nChannel] = (fabs(dValue) <= std::numeric_limits<double>::max() ? dValue : 0.0);
+					}
+				}
+
+				void Run(std::vector<SChannelStatistics>& vecStats, const SStatisticsConfig& xConfig)
+				{
+					const size_t nBinCount = size_t(std::max(xConfig.iBinCount, 0));
+
+					// With a configured range the histogram is counted in the same pass as the moments.
+					std::vector<SBinning> vecBinning;
+					if (nBinCount > 0 && xConfig.HasRange())
+					{
+						vecBinning.assign(m_nChannels, SBinning(xConfig.dRangeMin, xConfig.dRangeMax, nBinCount));
+					}
+
+					std::vector<SMoments> vecMoments(m_nChannels);
+					std::vector<uint64_t> vecBin, vecBelow, vecAbove;
+					_Pass(vecMoments, vecBin, vecBelow, vecAbove, true, vecBinning);
+
+					if (nBinCount > 0 && !xConfig.HasRange())
+					{
+						vecBinning.resize(m_nChannels);
+						for (size_t nChannel = 0; nChannel < m_nChannels; ++nChannel)
+						{
+							const SMoments& xMoments = vecMoments[nChannel];
+							vecBinning[nChannel] = (xMoments.uCount > 0 ? SBinning(xMoments.dMin, xMoments.dMax, nBinCount) : SBinning(0.0, 0.0, nBinCount));
+						}
+
+						std::vector<SMoments> vecUnused(m_nChannels);
+						_Pass(vecUnused, vecBin, vecBelow, vecAbove, false, vecBinning);
+					}
+
+					vecStats.assign(m_nChannels, SChannelStatistics());
+					for (size_t nChannel = 0; nChannel < m_nChannels; ++nChannel)
+					{
+						const SMoments& xMoments = vecMoments[nChannel];
+						SChannelStatistics& xStats = vecStats[nChannel];
+
+						if (xMoments.uCount > 0)
+						{
+							const double dCount = double(xMoments.uCount);
+							xStats.uCount = xMoments.uCount;
+							xStats.dMin = xMoments.dMin;
+							xStats.dMax = xMoments.dMax;
+							xStats.dMean = m_vecShift[nChannel] + xMoments.dSum / dCount;
+							xStats.dVariance = std::max((xMoments.dSumSq - xMoments.dSum * xMoments.dSum / dCount) / dCount, 0.0);
+						}
+
+						if (nBinCount > 0)
+						{
+							_SetHistogram(xStats.xHistogram, vecBinning[nChannel], &vecBin[nChannel * nBinCount], vecBelow[nChannel], vecAbove[nChannel]);
+						}
+					}
+				}
+
+			protected:
+				void _Pass(std::vector<SMoments>& vecMoments, std::vector<uint64_t>& vecBin, std::vector<uint64_t>& vecBelow
+					, std::vector<uint64_t>& vecAbove, bool bMoments, const std::vector<SBinning>& vecBinning)
+				{
+					const size_t nBinCount = (vecBinning.empty() ? 0 : vecBinning[0].nBinCount);
+					const size_t nHeight = size_t(m_xFormat.iHeight);
+					const size_t nMinRows = std::max<size_t>(MinBlockPixelCount / size_t(m_xFormat.iWidth), 1);
+
+					std::vector<SBlockAccumulator> vecBlock(Clu::Parallel::BlockCount(nHeight, nMinRows));
+
+					Clu::Parallel::ForEachBlock(nHeight, nMinRows, [&](size_t nBegin, size_t nEnd, unsigned uBlockIdx)
+					{
+						SBlockAccumulator& xAcc = vecBlock[uBlockIdx];
+						xAcc.vecMoments.assign(m_nChannels, SMoments());
+						xAcc.vecBin.assign(m_nChannels * nBinCount, 0);
+						xAcc.vecBelow.assign(m_nChannels, 0);
+						xAcc.vecAbove.assign(m_nChannels, 0);
+
+						_Block(xAcc, nBegin, nEnd, bMoments, vecBinning);
+					});
+
+					vecBin.assign(m_nChannels * nBinCount, 0);
+					vecBelow.assign(m_nChannels, 0);
+					vecAbove.assign(m_nChannels, 0);
+
+					for (const SBlockAccumulator& xAcc : vecBlock)
+					{
+						for (size_t nChannel = 0; nChannel < m_nChannels; ++nChannel)
+						{
+							vecMoments[nChannel].Merge(xAcc.vecMoments[nChannel]);
+							vecBelow[nChannel] += xAcc.vecBelow[nChannel];
+							vecAbove[nChannel] += xAcc.vecAbove[nChannel];
+						}
+
+						for (size_t nBin = 0; nBin < vecBin.size(); ++nBin)
+						{
+							vecBin[nBin] += xAcc.vecBin[nBin];
+						}
+					}
+				}
+
+				void _Block(SBlockAccumulator& xAcc, size_t nBegin, size_t nEnd, bool bMoments, const std::vector<SBinning>& vecBinning)
+				{
+					const size_t nWidth = size_t(m_xFormat.iWidth);
+					const size_t nCount = nWidth * m_nChannels;
+					const size_t nPitch = m_xFormat.RowPitch();
+					const size_t nBinCount = (vecBinning.empty() ? 0 : vecBinning[0].nBinCount);
+					const unsigned char* pucSrc = (const unsigned char*)m_imgSrc.DataPointer();
+					const double* pdShift = m_vecShift.data();
+
+					SMoments* pMoments = xAcc.vecMoments.data();
+					// Masked rows are accumulated by the scalar code.
+					CLaneMoments xLanes(pdShift, m_nChannels, bMoments && m_pimgMask == nullptr);
+
+					for (size_t nY = nBegin; nY < nEnd; ++nY)
+					{
+						const TValue* pRow = (const TValue*)(pucSrc + nY * nPitch);
+						const uint8_t* pucMask = (m_pimgMask == nullptr ? nullptr
+							: (const uint8_t*)m_pimgMask->DataPointer() + nY * m_pimgMask->Format().RowPitch());
+
+						if (bMoments)
+						{
+							if (pucMask != nullptr)
+							{
+								for (size_t nX = 0; nX < nWidth; ++nX)
+								{
+									if (pucMask[nX] != 0)
+									{
+										for (size_t nChannel = 0; nChannel < m_nChannels; ++nChannel)
+										{
+											pMoments[nChannel].Add(double(pRow[nX * m_nChannels + nChannel]), pdShift[nChannel]);
+										}
+									}
+								}
+							}
+							else
+							{
+								// The scalar tail starts at a pixel boundary, since a lane step covers whole pixels.
+								for (size_t nIdx = xLanes.Row(pRow, nCount); nIdx < nCount; ++nIdx)
+								{
+									const size_t nChannel = nIdx % m_nChannels;
+									pMoments[nChannel].Add(double(pRow[nIdx]), pdShift[nChannel]);
+								}
+							}
+						}
+
+						// The histogram is counted while the row is still in the cache.
+						if (nBinCount > 0)
+						{
+							for (size_t nX = 0; nX < nWidth; ++nX)
+							{
+								if (pucMask != nullptr && pucMask[nX] == 0)
+								{
+									continue;
+								}
+
+								for (size_t nChannel = 0; nChannel < m_nChannels; ++nChannel)
+								{
+									vecBinning[nChannel].Add(&xAcc.vecBin[nChannel * nBinCount], xAcc.vecBelow[nChannel], xAcc.vecAbove[nChannel]
+										, double(pRow[nX * m_nChannels + nChannel]), 1);
+								}
+							}
+						}
+					}
+
+					xLanes.Reduce(pMoments);
+				}
+
+			protected:
+				const CIImage& m_imgSrc;
+				const CIImage* m_pimgMask;
+				const SImageFormat& m_xFormat;
+				size_t m_nChannels;
+				std::vector<double> m_vecShift;
+			};
+
+			void _ComputeStatistics(std::vector<SChannelStatistics>& vecStats, const CIImage& imgSrc, const CIImage* pimgMask
+				, const SStatisticsConfig& xConfig)
+			{
+				if (!imgSrc.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid image");
+				}
+
+				if (xConfig.iBinCount < 0)
+				{
+					throw CLU_EXCEPTION("Invalid histogram bin count");
+				}
+
+				switch (imgSrc.Format().eDataType)
+				{
+				case EDataType::Int8:
+					_CountStatistics<int8_t>(vecStats, imgSrc, pimgMask, xConfig);
+					break;
+				case EDataType::UInt8:
+					_CountStatistics<uint8_t>(vecStats, imgSrc, pimgMask, xConfig);
+					break;
+				case EDataType::Int16:
+					_CountStatistics<int16_t>(vecStats, imgSrc, pimgMask, xConfig);
+					break;
+				case EDataType::UInt16:
+					_CountStatistics<uint16_t>(vecStats, imgSrc, pimgMask, xConfig);
+					break;
+				case EDataType::Int32:
+					CMomentStatistics<int32_t>(imgSrc, pimgMask).Run(vecStats, xConfig);
+					break;
+				case EDataType::UInt32:
+					CMomentStatistics<uint32_t>(imgSrc, pimgMask).Run(vecStats, xConfig);
+					break;
+				case EDataType::Single:
+					CMomentStatistics<float>(imgSrc, pimgMask).Run(vecStats, xConfig);
+					break;
+				case EDataType::Double:
+					CMomentStatistics<double>(imgSrc, pimgMask).Run(vecStats, xConfig);
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported image data type");
+				}
+			}
+		} // namespace
+
+		void ComputeStatistics(std::vector<SChannelStatistics>& vecStats, const CIImage& imgSrc, const SStatisticsConfig& xConfig)
+		{
+			try
+			{
+				_ComputeStatistics(vecStats, imgSrc, nullptr, xConfig);
+			}
+			CLU_CATCH_RETHROW_ALL("Error computing image statistics")
+		}
+
+		void ComputeStatistics(std::vector<SChannelStatistics>& vecStats, const CIImage& imgSrc
+			, int iX, int iY, int iWidth, int iHeight, const SStatisticsConfig& xConfig)
+		{
+			try
+			{
+				if (!imgSrc.IsValid() || iWidth <= 0 || iHeight <= 0 || !imgSrc.Format().IsRectInside(iX, iY, iWidth, iHeight))
+				{
+					throw CLU_EXCEPTION("Region is not inside the image");
+				}
+
+				_ComputeStatistics(vecStats, imgSrc.CropView(iX, iY, iWidth, iHeight), nullptr, xConfig);
+			}
+			CLU_CATCH_RETHROW_ALL("Error computing image statistics of region")
+		}
+
+		void ComputeStatistics(std::vector<SChannelStatistics>& vecStats, const CIImage& imgSrc, const CIImage& imgMask
+			, const SStatisticsConfig& xConfig)
+		{
+			try
+			{
+				if (!imgMask.IsValid() || !imgMask.Format().IsEqualType(EPixelType::Lum, EDataType::UInt8)
+					|| !imgSrc.IsValid() || !imgMask.Format().IsEqualSize(imgSrc.Format()))
+				{
+					throw CLU_EXCEPTION("Mask has to be a Lum UInt8 image of the size of the image");
+				}
+
+				_ComputeStatistics(vecStats, imgSrc, &imgMask, xConfig);
+			}
+			CLU_CATCH_RETHROW_ALL("Error computing masked image statistics")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
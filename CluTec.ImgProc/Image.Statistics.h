@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Statistics.h
+//
+// summary:   Declares per channel image statistics
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		/// <summary>	A histogram of equally wide bins over a closed value range. </summary>
+		struct SHistogram
+		{
+			double dMin;
+			double dMax;
+
+			/// <summary>	The number of values below dMin and above dMax, which are in no bin. </summary>
+			uint64_t uBelowCount;
+			uint64_t uAboveCount;
+
+			std::vector<uint64_t> vecBin;
+
+			SHistogram()
+				: dMin(0.0)
+				, dMax(0.0)
+				, uBelowCount(0)
+				, uAboveCount(0)
+			{
+			}
+		};
+
+		/// <summary>	The statistics of one channel of an image. </summary>
+		struct SChannelStatistics
+		{
+			/// <summary>	The number of values, without masked pixels and NaN values. If it is zero, the other values are zero. </summary>
+			uint64_t uCount;
+
+			double dMin;
+			double dMax;
+			double dMean;
+
+			/// <summary>	The population variance. </summary>
+			double dVariance;
+
+			SHistogram xHistogram;
+
+			SChannelStatistics()
+				: uCount(0)
+				, dMin(0.0)
+				, dMax(0.0)
+				, dMean(0.0)
+				, dVariance(0.0)
+			{
+			}
+
+			double StdDev() const
+			{
+				return sqrt(dVariance);
+			}
+		};
+
+		/// <summary>	Configures the histograms computed with the statistics. </summary>
+		struct SStatisticsConfig
+		{
+			/// <summary>	The number of histogram bins. Zero computes no histogram. </summary>
+			int iBinCount;
+
+			/// <summary>
+			/// 	The histogram value range. If dRangeMin is not below dRangeMax, the range of the data type is used for
+			/// 	integer types up to 16 bit, and the range of the channel values otherwise.
+			/// </summary>
+			double dRangeMin;
+			double dRangeMax;
+
+			SStatisticsConfig(int _iBinCount = 256, double _dRangeMin = 0.0, double _dRangeMax = 0.0)
+				: iBinCount(_iBinCount)
+				, dRangeMin(_dRangeMin)
+				, dRangeMax(_dRangeMax)
+			{
+			}
+
+			bool HasRange() const
+			{
+				return dRangeMin < dRangeMax;
+			}
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Computes the minimum, maximum, mean, variance and histogram of each channel of an image. Bands of rows
+		/// 	are processed in parallel with per thread accumulators that are merged at the end.
+		/// 	- For 8 and 16 bit integer types each thread counts all values in a histogram over the whole type
+		/// 	  range, from which all statistics are derived exactly, so the pixels are read once.
+		/// 	- For 32 bit integer and floating point types the moments are accumulated with SIMD and the histogram
+		/// 	  is counted in the same pass over each row. If the histogram range is not configured, the channel
+		/// 	  ranges are determined first, which needs a second pass. NaN values are skipped.
+		/// </summary>
+		///
+		/// <param name="vecStats">	The statistics of each channel. </param>
+		/// <param name="imgSrc">  	The image. A region of interest is passed as a CropView(). </param>
+		/// <param name="xConfig"> 	The histogram configuration. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void ComputeStatistics(std::vector<SChannelStatistics>& vecStats, const CIImage& imgSrc
+			, const SStatisticsConfig& xConfig = SStatisticsConfig());
+
+		/// <summary>	Computes the statistics of the pixels in a rectangle of the image. </summary>
+		void ComputeStatistics(std::vector<SChannelStatistics>& vecStats, const CIImage& imgSrc
+			, int iX, int iY, int iWidth, int iHeight, const SStatisticsConfig& xConfig = SStatisticsConfig());
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Computes the statistics of the pixels whose mask value is not zero. </summary>
+		///
+		/// <param name="vecStats">	The statistics of each channel. </param>
+		/// <param name="imgSrc">  	The image. </param>
+		/// <param name="imgMask"> 	A Lum UInt8 image of the size of imgSrc. </param>
+		/// <param name="xConfig"> 	The histogram configuration. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void ComputeStatistics(std::vector<SChannelStatistics>& vecStats, const CIImage& imgSrc, const CIImage& imgMask
+			, const SStatisticsConfig& xConfig = SStatisticsConfig());
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,684 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Tiled.cpp
+//
+// summary:   Implements an image that is stored in tiles in a file and cached in memory
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <string.h>
+#include <algorithm>
+
+#include "Image.Tiled.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Types1/ExceptionTypes.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		namespace
+		{
+			/// <summary>	The header at the start of a tiled image file. The tiles follow in row order, each with packed rows. </summary>
+			struct STiledImageHeader
+			{
+				char pcMagic[8];
+				uint32_t uVersion;
+				uint32_t uHeaderSize;
+				int32_t iWidth;
+				int32_t iHeight;
+				uint32_t uPixelType;
+				uint32_t uDataType;
+				int32_t iTileSize;
+				uint32_t uReserved;
+			};
+
+			const char TiledImageMagic[8] = { 'C', 'L', 'U', 'T', 'I', 'L', 'E', 'D' };
+			const uint32_t TiledImageVersion = 1;
+			const uint64_t TiledImageHeaderSize = 4096;
+
+			/// <summary>	The maximal number of tiles waiting to be prefetched. Older requests are dropped. </summary>
+			const size_t MaxPrefetchQueue = 16;
+
+			/// <summary>	Copies a rectangle of nRowBytes x iRows between memory blocks with the given row pitches. </summary>
+			void _CopyRows(unsigned char* pucTrg, size_t nTrgPitch, const unsigned char* pucSrc, size_t nSrcPitch, size_t nRowBytes, int iRows)
+			{
+				for (int iRow = 0; iRow < iRows; ++iRow)
+				{
+					memcpy(pucTrg + size_t(iRow) * nTrgPitch, pucSrc + size_t(iRow) * nSrcPitch, nRowBytes);
+				}
+			}
+		} // namespace
+
+		CTiledImage::CTile::CTile()
+			: m_pOwner(nullptr)
+			, m_nTileIdx(0)
+			, m_iX(0)
+			, m_iY(0)
+		{
+		}
+
+		CTiledImage::CTile::CTile(CTile&& xTile)
+			: m_pOwner(xTile.m_pOwner)
+			, m_nTileIdx(xTile.m_nTileIdx)
+			, m_imgTile(std::move(xTile.m_imgTile))
+			, m_iX(xTile.m_iX)
+			, m_iY(xTile.m_iY)
+		{
+			xTile.m_pOwner = nullptr;
+		}
+
+		CTiledImage::CTile::~CTile()
+		{
+			Release();
+		}
+
+		CTiledImage::CTile& CTiledImage::CTile::operator= (CTile&& xTile)
+		{
+			if (this != &xTile)
+			{
+				Release();
+				m_pOwner = xTile.m_pOwner;
+				m_nTileIdx = xTile.m_nTileIdx;
+				m_imgTile = std::move(xTile.m_imgTile);
+				m_iX = xTile.m_iX;
+				m_iY = xTile.m_iY;
+				xTile.m_pOwner = nullptr;
+			}
+
+			return *this;
+		}
+
+		void CTiledImage::CTile::Release()
+		{
+			if (m_pOwner != nullptr)
+			{
+				m_imgTile = CIImage();
+				m_pOwner->_Unlock(m_nTileIdx);
+				m_pOwner = nullptr;
+			}
+		}
+
+		CTiledImage::CTiledImage()
+			: m_iTileSize(0)
+			, m_iTileCountX(0)
+			, m_iTileCountY(0)
+			, m_nTileByteCount(0)
+			, m_nMaxTileCount(0)
+			, m_bPrefetch(true)
+			, m_uFileSize(0)
+			, m_nCachedCount(0)
+			, m_bStop(false)
+		{
+		}
+
+		CTiledImage::~CTiledImage()
+		{
+			try
+			{
+				Close();
+			}
+			catch (...)
+			{
+				_StopPrefetch();
+			}
+		}
+
+		void CTiledImage::Create(const std::string& sFilename, const SImageFormat& xFormat, int iTileSize, size_t nCacheBytes)
+		{
+			try
+			{
+				if (!xFormat.IsValid() || iTileSize <= 0)
+				{
+					throw CLU_EXCEPTION("Invalid image format or tile size");
+				}
+
+				Close();
+
+				m_xFile.open(sFilename, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+				if (!m_xFile.is_open())
+				{
+					throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' could not be created");
+				}
+
+				m_xFormat = SImageFormat(xFormat.iWidth, xFormat.iHeight, xFormat.ePixelType, xFormat.eDataType);
+				m_iTileSize = iTileSize;
+
+				STiledImageHeader xHeader;
+				memset(&xHeader, 0, sizeof(xHeader));
+				memcpy(xHeader.pcMagic, TiledImageMagic, sizeof(TiledImageMagic));
+				xHeader.uVersion = TiledImageVersion;
+				xHeader.uHeaderSize = uint32_t(TiledImageHeaderSize);
+				xHeader.iWidth = m_xFormat.iWidth;
+				xHeader.iHeight = m_xFormat.iHeight;
+				xHeader.uPixelType = uint32_t(m_xFormat.ePixelType);
+				xHeader.uDataType = uint32_t(m_xFormat.eDataType);
+				xHeader.iTileSize = iTileSize;
+
+				std::vector<char> vecHeader(size_t(TiledImageHeaderSize), 0);
+				memcpy(vecHeader.data(), &xHeader, sizeof(xHeader));
+				m_xFile.write(vecHeader.data(), std::streamsize(vecHeader.size()));
+
+				if (!m_xFile.good())
+				{
+					m_xFile.close();
+					throw CLU_EXCEPTION(CLU_S "Error writing header of file '" << sFilename.c_str() << "'");
+				}
+
+				m_uFileSize = TiledImageHeaderSize;
+				_Start(nCacheBytes);
+			}
+			CLU_CATCH_RETHROW_ALL("Error creating tiled image")
+		}
+
+		void CTiledImage::Open(const std::string& sFilename, size_t nCacheBytes)
+		{
+			try
+			{
+				Close();
+
+				m_xFile.open(sFilename, std::ios::in | std::ios::out | std::ios::binary);
+				if (!m_xFile.is_open())
+				{
+					throw CLU_EXCEPT_TYPE(FileNotFound, CLU_S "File '" << sFilename.c_str() << "' could not be opened");
+				}
+
+				STiledImageHeader xHeader;
+				m_xFile.read((char*)&xHeader, sizeof(xHeader));
+
+				SImageFormat xFormat;
+				if (m_xFile.good())
+				{
+					xFormat = SImageFormat(xHeader.iWidth, xHeader.iHeight, EPixelType(xHeader.uPixelType), EDataType(xHeader.uDataType));
+				}
+
+				if (!m_xFile.good() || memcmp(xHeader.pcMagic, TiledImageMagic, sizeof(TiledImageMagic)) != 0
+					|| xHeader.uVersion != TiledImageVersion || xHeader.uHeaderSize != TiledImageHeaderSize
+					|| !xFormat.IsValid() || xHeader.iTileSize <= 0)
+				{
+					m_xFile.close();
+					throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' is not a tiled image");
+				}
+
+				m_xFile.seekg(0, std::ios::end);
+				m_uFileSize = uint64_t(m_xFile.tellg());
+
+				m_xFormat = xFormat;
+				m_iTileSize = xHeader.iTileSize;
+				_Start(nCacheBytes);
+			}
+			CLU_CATCH_RETHROW_ALL("Error opening tiled image")
+		}
+
+		void CTiledImage::_Start(size_t nCacheBytes)
+		{
+			m_iTileCountX = (m_xFormat.iWidth + m_iTileSize - 1) / m_iTileSize;
+			m_iTileCountY = (m_xFormat.iHeight + m_iTileSize - 1) / m_iTileSize;
+			m_nTileByteCount = size_t(m_iTileSize) * size_t(m_iTileSize) * m_xFormat.BytesPerPixel();
+			m_nMaxTileCount = std::max<size_t>(nCacheBytes / m_nTileByteCount, 1);
+
+			m_vecTile.clear();
+			m_vecTile.resize(size_t(m_iTileCountX) * size_t(m_iTileCountY));
+			m_nCachedCount = 0;
+			m_lstLru.clear();
+			m_deqPrefetch.clear();
+
+			m_bStop = false;
+			m_thPrefetch = std::thread(&CTiledImage::_PrefetchLoop, this);
+		}
+
+		void CTiledImage::_StopPrefetch()
+		{
+			if (m_thPrefetch.joinable())
+			{
+				{
+					std::lock_guard<std::mutex> xLock(m_mxCache);
+					m_bStop = true;
+					m_deqPrefetch.clear();
+				}
+
+				m_cvPrefetch.notify_all();
+				m_thPrefetch.join();
+			}
+		}
+
+		void CTiledImage::Close()
+		{
+			try
+			{
+				if (!IsValid())
+				{
+					return;
+				}
+
+				_StopPrefetch();
+
+				{
+					std::lock_guard<std::mutex> xLock(m_mxCache);
+					for (const std::unique_ptr<STileEntry>& pEntry : m_vecTile)
+					{
+						if (pEntry && pEntry->iLockCount > 0)
+						{
+							throw CLU_EXCEPTION("A tile is still locked");
+						}
+					}
+				}
+
+				Flush();
+
+				m_vecTile.clear();
+				m_lstLru.clear();
+				m_nCachedCount = 0;
+				m_xFile.close();
+				m_xFormat.Clear();
+				m_iTileCountX = m_iTileCountY = 0;
+			}
+			CLU_CATCH_RETHROW_ALL("Error closing tiled image")
+		}
+
+		void CTiledImage::Flush()
+		{
+			try
+			{
+				std::lock_guard<std::mutex> xLock(m_mxCache);
+
+				for (size_t nTileIdx = 0; nTileIdx < m_vecTile.size(); ++nTileIdx)
+				{
+					STileEntry* pEntry = m_vecTile[nTileIdx].get();
+					if (pEntry == nullptr || pEntry->bLoading || !pEntry->bDirty)
+					{
+						continue;
+					}
+
+					_WriteTile(nTileIdx, pEntry->imgData);
+
+					// A locked tile may still be modified, so it stays dirty.
+					if (pEntry->iLockCount == 0)
+					{
+						pEntry->bDirty = false;
+					}
+				}
+
+				std::lock_guard<std::mutex> xFileLock(m_mxFile);
+				m_xFile.flush();
+			}
+			CLU_CATCH_RETHROW_ALL("Error writing back tiles")
+		}
+
+		CTiledImage::CTile CTiledImage::LockTile(int iTileX, int iTileY, bool bWrite)
+		{
+			try
+			{
+				if (!IsValid())
+				{
+					throw CLU_EXCEPTION("Tiled image is not open");
+				}
+
+				if (iTileX < 0 || iTileX >= m_iTileCountX || iTileY < 0 || iTileY >= m_iTileCountY)
+				{
+					throw CLU_EXCEPTION("Tile index out of range");
+				}
+
+				const size_t nTileIdx = size_t(iTileY) * size_t(m_iTileCountX) + size_t(iTileX);
+				CTile xTile;
+
+				{
+					std::unique_lock<std::mutex> xLock(m_mxCache);
+
+					while (true)
+					{
+						STileEntry* pEntry = m_vecTile[nTileIdx].get();
+
+						if (pEntry == nullptr)
+						{
+							STileEntry& xEntry = _AddEntry(nTileIdx, 1);
+							xLock.unlock();
+
+							try
+							{
+								_ReadTile(nTileIdx, xEntry.imgData);
+							}
+							catch (...)
+							{
+								xLock.lock();
+								m_vecTile[nTileIdx].reset();
+								--m_nCachedCount;
+								m_cvLoaded.notify_all();
+								throw;
+							}
+
+							xLock.lock();
+							xEntry.bLoading = false;
+							m_cvLoaded.notify_all();
+							break;
+						}
+
+						if (pEntry->bLoading)
+						{
+							m_cvLoaded.wait(xLock);
+							continue;
+						}
+
+						if (pEntry->iLockCount++ == 0)
+						{
+							m_lstLru.erase(pEntry->itLru);
+						}
+						break;
+					}
+
+					STileEntry& xEntry = *m_vecTile[nTileIdx];
+					xEntry.bDirty = xEntry.bDirty || bWrite;
+
+					// The tile is handed out as view, so that writes go to the cached memory.
+					xTile.m_pOwner = this;
+					xTile.m_nTileIdx = nTileIdx;
+					xTile.m_iX = iTileX * m_iTileSize;
+					xTile.m_iY = iTileY * m_iTileSize;
+					xTile.m_imgTile = xEntry.imgData.CropView(0, 0
+						, std::min(m_iTileSize, m_xFormat.iWidth - xTile.m_iX)
+						, std::min(m_iTileSize, m_xFormat.iHeight - xTile.m_iY));
+				}
+
+				if (m_bPrefetch)
+				{
+					Prefetch(iTileX + 1, iTileY);
+					Prefetch(iTileX, iTileY + 1);
+					Prefetch(iTileX - 1, iTileY);
+					Prefetch(iTileX, iTileY - 1);
+				}
+
+				return xTile;
+			}
+			CLU_CATCH_RETHROW_ALL("Error locking tile")
+		}
+
+		void CTiledImage::_Unlock(size_t nTileIdx)
+		{
+			std::lock_guard<std::mutex> xLock(m_mxCache);
+
+			STileEntry& xEntry = *m_vecTile[nTileIdx];
+			if (--xEntry.iLockCount == 0)
+			{
+				m_lstLru.push_front(nTileIdx);
+				xEntry.itLru = m_lstLru.begin();
+			}
+		}
+
+		void CTiledImage::_MakeRoom()
+		{
+			while (m_nCachedCount >= m_nMaxTileCount && !m_lstLru.empty())
+			{
+				const size_t nTileIdx = m_lstLru.back();
+				STileEntry& xEntry = *m_vecTile[nTileIdx];
+
+				if (xEntry.bDirty)
+				{
+					_WriteTile(nTileIdx, xEntry.imgData);
+				}
+
+				m_lstLru.pop_back();
+				m_vecTile[nTileIdx].reset();
+				--m_nCachedCount;
+			}
+		}
+
+		CTiledImage::STileEntry& CTiledImage::_AddEntry(size_t nTileIdx, int iLockCount)
+		{
+			_MakeRoom();
+
+			std::unique_ptr<STileEntry> pEntry(new STileEntry());
+			pEntry->imgData.Create(SImageFormat(m_iTileSize, m_iTileSize, m_xFormat.ePixelType, m_xFormat.eDataType));
+			pEntry->iLockCount = iLockCount;
+			pEntry->bDirty = false;
+			pEntry->bLoading = true;
+
+			STileEntry& xEntry = *pEntry;
+			m_vecTile[nTileIdx] = std::move(pEntry);
+			++m_nCachedCount;
+
+			return xEntry;
+		}
+
+		void CTiledImage::_ReadTile(size_t nTileIdx, CIImage& imgTile)
+		{
+			const SImageFormat& xFormat = imgTile.Format();
+			const uint64_t uOffset = TiledImageHeaderSize + uint64_t(nTileIdx) * uint64_t(m_nTileByteCount);
+			unsigned char* pucData = (unsigned char*)imgTile.DataPointer();
+
+			std::lock_guard<std::mutex> xLock(m_mxFile);
+
+			// Tiles that have never been written lie beyond the end of the file.
+			if (uOffset >= m_uFileSize)
+			{
+				memset(pucData, 0, xFormat.ByteCount());
+				return;
+			}
+
+			m_xFile.seekg(std::streamoff(uOffset));
+
+			if (xFormat.IsPacked())
+			{
+				m_xFile.read((char*)pucData, std::streamsize(m_nTileByteCount));
+			}
+			else
+			{
+				for (int iY = 0; iY < xFormat.iHeight; ++iY)
+				{
+					m_xFile.read((char*)(pucData + size_t(iY) * xFormat.RowPitch()), std::streamsize(xFormat.RowByteCount()));
+				}
+			}
+
+			if (!m_xFile.good())
+			{
+				m_xFile.clear();
+				throw CLU_EXCEPTION(CLU_S "Error reading tile " << nTileIdx);
+			}
+		}
+
+		void CTiledImage::_WriteTile(size_t nTileIdx, const CIImage& imgTile)
+		{
+			const SImageFormat& xFormat = imgTile.Format();
+			const uint64_t uOffset = TiledImageHeaderSize + uint64_t(nTileIdx) * uint64_t(m_nTileByteCount);
+			const unsigned char* pucData = (const unsigned char*)imgTile.DataPointer();
+
+			std::lock_guard<std::mutex> xLock(m_mxFile);
+
+			m_xFile.seekp(std::streamoff(uOffset));
+
+			if (xFormat.IsPacked())
+			{
+				m_xFile.write((const char*)pucData, std::streamsize(m_nTileByteCount));
+			}
+			else
+			{
+				for (int iY = 0; iY < xFormat.iHeight; ++iY)
+				{
+					m_xFile.write((const char*)(pucData + size_t(iY) * xFormat.RowPitch()), std::streamsize(xFormat.RowByteCount()));
+				}
+			}
+
+			if (!m_xFile.good())
+			{
+				m_xFile.clear();
+				throw CLU_EXCEPTION(CLU_S "Error writing tile " << nTileIdx);
+			}
+
+			m_uFileSize = std::max(m_uFileSize, uOffset + uint64_t(m_nTileByteCount));
+		}
+
+		void CTiledImage::Prefetch(int iTileX, int iTileY)
+		{
+			if (iTileX < 0 || iTileX >= m_iTileCountX || iTileY < 0 || iTileY >= m_iTileCountY)
+			{
+				return;
+			}
+
+			const size_t nTileIdx = size_t(iTileY) * size_t(m_iTileCountX) + size_t(iTileX);
+
+			{
+				std::lock_guard<std::mutex> xLock(m_mxCache);
+
+				if (m_bStop || m_vecTile[nTileIdx]
+					|| std::find(m_deqPrefetch.begin(), m_deqPrefetch.end(), nTileIdx) != m_deqPrefetch.end())
+				{
+					return;
+				}
+
+				if (m_deqPrefetch.size() >= MaxPrefetchQueue)
+				{
+					m_deqPrefetch.pop_front();
+				}
+
+				m_deqPrefetch.push_back(nTileIdx);
+			}
+
+			m_cvPrefetch.notify_one();
+		}
+
+		void CTiledImage::_PrefetchLoop()
+		{
+			std::unique_lock<std::mutex> xLock(m_mxCache);
+
+			while (true)
+			{
+				m_cvPrefetch.wait(xLock, [this]() { return m_bStop || !m_deqPrefetch.empty(); });
+
+				if (m_bStop)
+				{
+					return;
+				}
+
+				const size_t nTileIdx = m_deqPrefetch.front();
+				m_deqPrefetch.pop_front();
+
+				// Prefetching never waits for locked tiles to be released.
+				if (m_vecTile[nTileIdx] || (m_nCachedCount >= m_nMaxTileCount && m_lstLru.empty()))
+				{
+					continue;
+				}
+
+				STileEntry* pEntry = nullptr;
+				try
+				{
+					pEntry = &_AddEntry(nTileIdx, 0);
+				}
+				catch (...)
+				{
+					continue;
+				}
+
+				xLock.unlock();
+
+				bool bLoaded = true;
+				try
+				{
+					_ReadTile(nTileIdx, pEntry->imgData);
+				}
+				catch (...)
+				{
+					bLoaded = false;
+				}
+
+				xLock.lock();
+
+				// A failed tile is dropped, so that locking it reports the error.
+				if (bLoaded)
+				{
+					pEntry->bLoading = false;
+					m_lstLru.push_front(nTileIdx);
+					pEntry->itLru = m_lstLru.begin();
+				}
+				else
+				{
+					m_vecTile[nTileIdx].reset();
+					--m_nCachedCount;
+				}
+
+				m_cvLoaded.notify_all();
+			}
+		}
+
+		void CTiledImage::ReadRegion(CIImage& imgTrg, int iX, int iY)
+		{
+			try
+			{
+				if (!imgTrg.IsValid() || !imgTrg.Format().IsEqualType(m_xFormat))
+				{
+					throw CLU_EXCEPTION("Target image has to be valid and of the type of the tiled image");
+				}
+
+				const SImageFormat& xTrgFormat = imgTrg.Format();
+				if (!m_xFormat.IsRectInside(iX, iY, xTrgFormat.iWidth, xTrgFormat.iHeight))
+				{
+					throw CLU_EXCEPTION("Region is not inside the tiled image");
+				}
+
+				unsigned char* pucTrg = (unsigned char*)imgTrg.DataPointer();
+				const size_t nBytesPerPixel = m_xFormat.BytesPerPixel();
+
+				for (int iTileY = iY / m_iTileSize; iTileY <= (iY + xTrgFormat.iHeight - 1) / m_iTileSize; ++iTileY)
+				{
+					for (int iTileX = iX / m_iTileSize; iTileX <= (iX + xTrgFormat.iWidth - 1) / m_iTileSize; ++iTileX)
+					{
+						CTile xTile = LockTile(iTileX, iTileY, false);
+						const SImageFormat& xTileFormat = xTile.Image().Format();
+
+						const int iX0 = std::max(iX, xTile.X());
+						const int iY0 = std::max(iY, xTile.Y());
+						const int iX1 = std::min(iX + xTrgFormat.iWidth, xTile.X() + xTileFormat.iWidth);
+						const int iY1 = std::min(iY + xTrgFormat.iHeight, xTile.Y() + xTileFormat.iHeight);
+
+						_CopyRows(pucTrg + xTrgFormat.GetByteOffset(iX0 - iX, iY0 - iY), xTrgFormat.RowPitch()
+							, (const unsigned char*)((const CIImage&)xTile.Image()).DataPointer() + xTileFormat.GetByteOffset(iX0 - xTile.X(), iY0 - xTile.Y())
+							, xTileFormat.RowPitch(), size_t(iX1 - iX0) * nBytesPerPixel, iY1 - iY0);
+					}
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error reading region of tiled image")
+		}
+
+		void CTiledImage::WriteRegion(const CIImage& imgSrc, int iX, int iY)
+		{
+			try
+			{
+				if (!imgSrc.IsValid() || !imgSrc.Format().IsEqualType(m_xFormat))
+				{
+					throw CLU_EXCEPTION("Source image has to be valid and of the type of the tiled image");
+				}
+
+				const SImageFormat& xSrcFormat = imgSrc.Format();
+				if (!m_xFormat.IsRectInside(iX, iY, xSrcFormat.iWidth, xSrcFormat.iHeight))
+				{
+					throw CLU_EXCEPTION("Region is not inside the tiled image");
+				}
+
+				const unsigned char* pucSrc = (const unsigned char*)imgSrc.DataPointer();
+				const size_t nBytesPerPixel = m_xFormat.BytesPerPixel();
+
+				for (int iTileY = iY / m_iTileSize; iTileY <= (iY + xSrcFormat.iHeight - 1) / m_iTileSize; ++iTileY)
+				{
+					for (int iTileX = iX / m_iTileSize; iTileX <= (iX + xSrcFormat.iWidth - 1) / m_iTileSize; ++iTileX)
+					{
+						CTile xTile = LockTile(iTileX, iTileY, true);
+						const SImageFormat& xTileFormat = xTile.Image().Format();
+
+						const int iX0 = std::max(iX, xTile.X());
+						const int iY0 = std::max(iY, xTile.Y());
+						const int iX1 = std::min(iX + xSrcFormat.iWidth, xTile.X() + xTileFormat.iWidth);
+						const int iY1 = std::min(iY + xSrcFormat.iHeight, xTile.Y() + xTileFormat.iHeight);
+
+						_CopyRows((unsigned char*)xTile.Image().DataPointer() + xTileFormat.GetByteOffset(iX0 - xTile.X(), iY0 - xTile.Y())
+							, xTileFormat.RowPitch(), pucSrc + xSrcFormat.GetByteOffset(iX0 - iX, iY0 - iY)
+							, xSrcFormat.RowPitch(), size_t(iX1 - iX0) * nBytesPerPixel, iY1 - iY0);
+					}
+				}
+			}
+			CLU_CATCH_RETHROW_ALL("Error writing region of tiled image")
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,254 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.Tiled.h
+//
+// summary:   Declares an image that is stored in tiles in a file and cached in memory
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	An image that is stored in square tiles in a file and of which only a limited number of tiles is held
+		/// 	in memory. Tiles are locked to access them as CIImage, so that code written for images runs tile by
+		/// 	tile. Unlocked tiles stay in a cache with least recently used eviction, modified tiles are written back
+		/// 	when they are evicted, on Flush() and on Close(). Locking a tile prefetches its four neighbors in a
+		/// 	background thread. Tiles may be locked from several threads at once.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		class CTiledImage
+		{
+		public:
+			static const int DefaultTileSize = 256;
+			static const size_t DefaultCacheBytes = size_t(256) << 20;
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	A locked tile. The tile stays in memory until the lock is released or destroyed. Its image refers
+			/// 	to the cached tile memory and must not be used after the release.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			class CTile
+			{
+			public:
+				CTile();
+				CTile(CTile&& xTile);
+				~CTile();
+
+				CTile(const CTile&) = delete;
+				CTile& operator= (const CTile&) = delete;
+				CTile& operator= (CTile&& xTile);
+
+				bool IsValid() const
+				{
+					return m_pOwner != nullptr;
+				}
+
+				/// <summary>	The tile image, cropped to the image border for the last tile of a row or column. </summary>
+				CIImage& Image()
+				{
+					return m_imgTile;
+				}
+
+				const CIImage& Image() const
+				{
+					return m_imgTile;
+				}
+
+				/// <summary>	The horizontal image position of the top left pixel of the tile. </summary>
+				int X() const
+				{
+					return m_iX;
+				}
+
+				/// <summary>	The vertical image position of the top left pixel of the tile. </summary>
+				int Y() const
+				{
+					return m_iY;
+				}
+
+				void Release();
+
+			protected:
+				friend class CTiledImage;
+
+				CTiledImage* m_pOwner;
+				size_t m_nTileIdx;
+				CIImage m_imgTile;
+				int m_iX;
+				int m_iY;
+			};
+
+		public:
+			CTiledImage();
+			~CTiledImage();
+
+			CTiledImage(const CTiledImage&) = delete;
+			CTiledImage& operator= (const CTiledImage&) = delete;
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Creates a tiled image file. All pixels are initially zero. </summary>
+			///
+			/// <param name="sFilename">  	The file name. </param>
+			/// <param name="xFormat">	  	The size and type of the whole image. </param>
+			/// <param name="iTileSize">  	The width and height of the tiles. </param>
+			/// <param name="nCacheBytes">	The memory budget of the tile cache. At least one tile per thread that
+			/// 							locks tiles is kept in memory regardless of the budget. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			void Create(const std::string& sFilename, const SImageFormat& xFormat, int iTileSize = DefaultTileSize
+				, size_t nCacheBytes = DefaultCacheBytes);
+
+			/// <summary>	Opens a tiled image file that was written by Create(). </summary>
+			void Open(const std::string& sFilename, size_t nCacheBytes = DefaultCacheBytes);
+
+			/// <summary>	Writes back all modified tiles and closes the file. All tiles have to be released. </summary>
+			void Close();
+
+			/// <summary>	Writes back all modified tiles. </summary>
+			void Flush();
+
+			bool IsValid() const
+			{
+				return m_xFile.is_open();
+			}
+
+			/// <summary>	The size and type of the whole image. </summary>
+			const SImageFormat& Format() const
+			{
+				return m_xFormat;
+			}
+
+			int TileSize() const
+			{
+				return m_iTileSize;
+			}
+
+			int TileCountX() const
+			{
+				return m_iTileCountX;
+			}
+
+			int TileCountY() const
+			{
+				return m_iTileCountY;
+			}
+
+			/// <summary>	Enables or disables prefetching the neighbors of locked tiles. It is enabled by default. </summary>
+			void EnablePrefetch(bool bEnable)
+			{
+				m_bPrefetch = bEnable;
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Locks a tile, loading it if it is not in the cache. </summary>
+			///
+			/// <param name="iTileX">	The tile column. </param>
+			/// <param name="iTileY">	The tile row. </param>
+			/// <param name="bWrite">	True if the tile is modified and has to be written back. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			CTile LockTile(int iTileX, int iTileY, bool bWrite);
+
+			/// <summary>	Starts loading a tile in the background if it is not in the cache. </summary>
+			void Prefetch(int iTileX, int iTileY);
+
+			/// <summary>	Copies the region of the image at the given position and with the size of imgTrg into imgTrg, which has to be of the image type. </summary>
+			void ReadRegion(CIImage& imgTrg, int iX, int iY);
+
+			/// <summary>	Copies imgSrc, which has to be of the image type, into the image at the given position. </summary>
+			void WriteRegion(const CIImage& imgSrc, int iX, int iY);
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Calls funcOp(imgTile, iX, iY) for all tiles in row order, where iX and iY are the image position of
+			/// 	the tile. The neighbor prefetching loads the next tiles while a tile is processed.
+			/// </summary>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename FuncOp>
+			void ForEachTile(bool bWrite, FuncOp funcOp)
+			{
+				for (int iTileY = 0; iTileY < m_iTileCountY; ++iTileY)
+				{
+					for (int iTileX = 0; iTileX < m_iTileCountX; ++iTileX)
+					{
+						CTile xTile = LockTile(iTileX, iTileY, bWrite);
+						funcOp(xTile.Image(), xTile.X(), xTile.Y());
+					}
+				}
+			}
+
+		protected:
+			struct STileEntry
+			{
+				CIImage imgData;
+				int iLockCount;
+				bool bDirty;
+				bool bLoading;
+				std::list<size_t>::iterator itLru;
+			};
+
+			/// <summary>	Sets up the cache and starts the prefetch thread once the format and the file are set. </summary>
+			void _Start(size_t nCacheBytes);
+			void _StopPrefetch();
+			void _Unlock(size_t nTileIdx);
+
+			/// <summary>	Evicts unlocked tiles until there is room for another one. The cache lock has to be held. </summary>
+			void _MakeRoom();
+
+			/// <summary>	Creates the entry of a tile that is about to be loaded. The cache lock has to be held. </summary>
+			STileEntry& _AddEntry(size_t nTileIdx, int iLockCount);
+
+			void _ReadTile(size_t nTileIdx, CIImage& imgTile);
+			void _WriteTile(size_t nTileIdx, const CIImage& imgTile);
+			void _PrefetchLoop();
+
+		protected:
+			SImageFormat m_xFormat;
+			int m_iTileSize;
+			int m_iTileCountX;
+			int m_iTileCountY;
+			size_t m_nTileByteCount;
+			size_t m_nMaxTileCount;
+			bool m_bPrefetch;
+
+			std::mutex m_mxFile;
+			std::fstream m_xFile;
+			uint64_t m_uFileSize;
+
+			std::mutex m_mxCache;
+			std::condition_variable m_cvLoaded;
+			std::vector<std::unique_ptr<STileEntry>> m_vecTile;
+			size_t m_nCachedCount;
+
+			/// <summary>	The unlocked loaded tiles, the most recently used first. </summary>
+			std::list<size_t> m_lstLru;
+
+			std::thread m_thPrefetch;
+			std::condition_variable m_cvPrefetch;
+			std::deque<size_t> m_deqPrefetch;
+			bool m_bStop;
+		};
+
+	} // namespace ImgProc
+} // namespace Clu
@@ -0,0 +1,516 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.ImgProc
+// file:      Image.View.h
+//
+// summary:   Declares typed views of image memory and parallel pixel algorithms
+//
+//            Copyright (c) 2016 CluTec. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stddef.h>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ImageFormat.h"
+#include "CluTec.Types1/Pixel.h"
+
+#include "CluTec.Base/Exception.h"
+#include "CluTec.Base/Parallel.h"
+
+namespace Clu
+{
+	namespace ImgProc
+	{
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	A typed view of the pixels of an image. The pixel and data type of the image are checked once when
+		/// 	the view is created, after which pixels are accessed as TPixel without casts or checks. A view with
+		/// 	a const pixel type gives read only access. The view does not keep the image memory alive.
+		/// </summary>
+		///
+		/// <typeparam name="TPixel">	An SPixel type, such as TPixel_RGBA_UInt8, or its const version. </typeparam>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TPixel>
+		class CImageView
+		{
+		public:
+			using TPixelValue = typename std::remove_const<TPixel>::type;
+			using TData = typename TPixelValue::TData;
+			using TByte = typename std::conditional<std::is_const<TPixel>::value, const unsigned char, unsigned char>::type;
+			using TVoid = typename std::conditional<std::is_const<TPixel>::value, const void, void>::type;
+
+			static const EPixelType PixelTypeId = TPixelValue::PixelTypeId;
+			static const EDataType DataTypeId = TPixelValue::DataTypeId;
+
+			static_assert(sizeof(TPixelValue) == sizeof(TData) * size_t(TPixelValue::ChannelCount), "Pixels have to be packed");
+
+			/// <summary>	The pixels of one row as a range. </summary>
+			class CRow
+			{
+			public:
+				CRow(TPixel* pBegin, int iWidth)
+					: m_pBegin(pBegin), m_pEnd(pBegin + iWidth)
+				{}
+
+				TPixel* begin() const
+				{
+					return m_pBegin;
+				}
+
+				TPixel* end() const
+				{
+					return m_pEnd;
+				}
+
+				int Size() const
+				{
+					return int(m_pEnd - m_pBegin);
+				}
+
+				TPixel& operator[](int iX) const
+				{
+					return m_pBegin[iX];
+				}
+
+			protected:
+				TPixel* m_pBegin;
+				TPixel* m_pEnd;
+			};
+
+			/// <summary>	A random access iterator over the rows of a view. </summary>
+			class CRowIterator
+			{
+			public:
+				using iterator_category = std::random_access_iterator_tag;
+				using value_type = CRow;
+				using difference_type = ptrdiff_t;
+				using pointer = void;
+				using reference = CRow;
+
+				CRowIterator(TByte* pucRow, size_t nRowPitch, int iWidth)
+					: m_pucRow(pucRow), m_nRowPitch(nRowPitch), m_iWidth(iWidth)
+				{}
+
+				CRow operator*() const
+				{
+					return CRow((TPixel*)m_pucRow, m_iWidth);
+				}
+
+				CRow operator[](ptrdiff_t iOffset) const
+				{
+					return *(*this + iOffset);
+				}
+
+				CRowIterator& operator++()
+				{
+					m_pucRow += m_nRowPitch;
+					return *this;
+				}
+
+				CRowIterator operator++(int)
+				{
+					CRowIterator itThis = *this;
+					m_pucRow += m_nRowPitch;
+					return itThis;
+				}
+
+				CRowIterator& operator--()
+				{
+					m_pucRow -= m_nRowPitch;
+					return *this;
+				}
+
+				CRowIterator operator--(int)
+				{
+					CRowIterator itThis = *this;
+					m_pucRow -= m_nRowPitch;
+					return itThis;
+				}
+
+				CRowIterator& operator+=(ptrdiff_t iOffset)
+				{
+					m_pucRow += iOffset * ptrdiff_t(m_nRowPitch);
+					return *this;
+				}
+
+				CRowIterator& operator-=(ptrdiff_t iOffset)
+				{
+					m_pucRow -= iOffset * ptrdiff_t(m_nRowPitch);
+					return *this;
+				}
+
+				CRowIterator operator+(ptrdiff_t iOffset) const
+				{
+					CRowIterator itResult = *this;
+					return itResult += iOffset;
+				}
+
+				CRowIterator operator-(ptrdiff_t iOffset) const
+				{
+					CRowIterator itResult = *this;
+					return itResult -= iOffset;
+				}
+
+				ptrdiff_t operator-(const CRowIterator& itOther) const
+				{
+					return (m_pucRow - itOther.m_pucRow) / ptrdiff_t(m_nRowPitch);
+				}
+
+				bool operator==(const CRowIterator& itOther) const
+				{
+					return m_pucRow == itOther.m_pucRow;
+				}
+
+				bool operator!=(const CRowIterator& itOther) const
+				{
+					return m_pucRow != itOther.m_pucRow;
+				}
+
+				bool operator<(const CRowIterator& itOther) const
+				{
+					return m_pucRow < itOther.m_pucRow;
+				}
+
+			protected:
+				TByte* m_pucRow;
+				size_t m_nRowPitch;
+				int m_iWidth;
+			};
+
+			/// <summary>	The rows of a view as a range. </summary>
+			class CRows
+			{
+			public:
+				CRows(const CRowIterator& itBegin, const CRowIterator& itEnd)
+					: m_itBegin(itBegin), m_itEnd(itEnd)
+				{}
+
+				CRowIterator begin() const
+				{
+					return m_itBegin;
+				}
+
+				CRowIterator end() const
+				{
+					return m_itEnd;
+				}
+
+			protected:
+				CRowIterator m_itBegin;
+				CRowIterator m_itEnd;
+			};
+
+		public:
+			CImageView()
+			{
+				m_pucData = nullptr;
+				m_nRowPitch = 0;
+				m_iWidth = 0;
+				m_iHeight = 0;
+			}
+
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Creates a view of image memory. </summary>
+			///
+			/// <param name="pData">  	The image memory. </param>
+			/// <param name="xFormat">	The image format. Its pixel and data type have to be those of TPixel. </param>
+			////////////////////////////////////////////////////////////////////////////////////////////////////
+			CImageView(TByte* pData, const SImageFormat& xFormat)
+			{
+				if (pData == nullptr || !xFormat.IsValid())
+				{
+					throw CLU_EXCEPTION("Invalid image data");
+				}
+
+				if (xFormat.ePixelType != PixelTypeId || xFormat.eDataType != DataTypeId)
+				{
+					throw CLU_EXCEPTION("Image type differs from the type of the view");
+				}
+
+				m_pucData = pData;
+				m_nRowPitch = xFormat.RowPitch();
+				m_iWidth = xFormat.iWidth;
+				m_iHeight = xFormat.iHeight;
+			}
+
+			CImageView(TVoid* pData, const SImageFormat& xFormat)
+				: CImageView((TByte*)pData, xFormat)
+			{}
+
+			/// <summary>	Creates a view of an image. A view with mutable pixels detaches the image memory if it is shared. </summary>
+			CImageView(CIImage& imgSrc)
+				: CImageView((TByte*)_DataPointer(imgSrc), imgSrc.Format())
+			{}
+
+			/// <summary>	Creates a read only view of an image. </summary>
+			template<typename TPixel2 = TPixel, typename = typename std::enable_if<std::is_const<TPixel2>::value>::type>
+			CImageView(const CIImage& imgSrc)
+				: CImageView((TByte*)_DataPointer(imgSrc), imgSrc.Format())
+			{}
+
+			/// <summary>	A view with const pixels is created from a view with the same, mutable pixels. </summary>
+			template<typename TPixel2, typename = typename std::enable_if<std::is_same<const TPixel2, TPixel>::value
+				&& !std::is_same<TPixel2, TPixel>::value>::type>
+			CImageView(const CImageView<TPixel2>& xView)
+			{
+				m_pucData = (TByte*)xView.Row(0);
+				m_nRowPitch = xView.RowPitch();
+				m_iWidth = xView.Width();
+				m_iHeight = xView.Height();
+			}
+
+			bool IsValid() const
+			{
+				return m_pucData != nullptr;
+			}
+
+			int Width() const
+			{
+				return m_iWidth;
+			}
+
+			int Height() const
+			{
+				return m_iHeight;
+			}
+
+			size_t RowPitch() const
+			{
+				return m_nRowPitch;
+			}
+
+			TPixel* Row(int iY) const
+			{
+				return (TPixel*)(m_pucData + size_t(iY) * m_nRowPitch);
+			}
+
+			/// <summary>	Returns the pixel at (iX, iY) without checking the position. </summary>
+			TPixel& operator()(int iX, int iY) const
+			{
+				return Row(iY)[iX];
+			}
+
+			/// <summary>	Returns the pixel at (iX, iY). Throws if the position lies outside of the view. </summary>
+			TPixel& At(int iX, int iY) const
+			{
+				if (iX < 0 || iX >= m_iWidth || iY < 0 || iY >= m_iHeight)
+				{
+					throw CLU_EXCEPTION("Pixel position outside of image view");
+				}
+
+				return Row(iY)[iX];
+			}
+
+			CRows Rows() const
+			{
+				return CRows(CRowIterator(m_pucData, m_nRowPitch, m_iWidth), CRowIterator(m_pucData + size_t(m_iHeight) * m_nRowPitch, m_nRowPitch, m_iWidth));
+			}
+
+			/// <summary>	Returns a view of a rectangle of this view, which refers to the same memory. </summary>
+			CImageView Crop(int iX, int iY, int iWidth, int iHeight) const
+			{
+				if (iX < 0 || iY < 0 || iWidth <= 0 || iHeight <= 0 || iX + iWidth > m_iWidth || iY + iHeight > m_iHeight)
+				{
+					throw CLU_EXCEPTION("Crop rectangle outside of image view");
+				}
+
+				CImageView xView(*this);
+				xView.m_pucData = (TByte*)(Row(iY) + iX);
+				xView.m_iWidth = iWidth;
+				xView.m_iHeight = iHeight;
+				return xView;
+			}
+
+		protected:
+			static TByte* _DataPointer(CIImage& imgSrc)
+			{
+				return _DataPointer(imgSrc, std::is_const<TPixel>());
+			}
+
+			static TByte* _DataPointer(CIImage& imgSrc, std::false_type)
+			{
+				return (TByte*)imgSrc.DataPointer();
+			}
+
+			// A view with const pixels must not detach an image whose memory is shared.
+			static TByte* _DataPointer(CIImage& imgSrc, std::true_type)
+			{
+				return (TByte*)((const CIImage&)imgSrc).DataPointer();
+			}
+
+			static TByte* _DataPointer(const CIImage& imgSrc)
+			{
+				return (TByte*)imgSrc.DataPointer();
+			}
+
+		protected:
+			TByte* m_pucData;
+			size_t m_nRowPitch;
+			int m_iWidth;
+			int m_iHeight;
+		};
+
+		/// <summary>	The minimal number of pixels a thread processes in the view algorithms. </summary>
+		const size_t ViewMinBlockPixels = size_t(1) << 14;
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Calls funcOp(pRow, iWidth, iY) for each row of a view. Blocks of rows are processed in parallel.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TPixel, typename FuncOp>
+		void ForEachRow(const CImageView<TPixel>& xView, FuncOp funcOp)
+		{
+			const int iWidth = xView.Width();
+			const size_t nMinRows = std::max<size_t>(ViewMinBlockPixels / std::max<size_t>(size_t(iWidth), 1), 1);
+
+			Clu::Parallel::ForEachBlock(size_t(xView.Height()), nMinRows, [&](size_t nBegin, size_t nEnd, unsigned)
+			{
+				for (size_t nY = nBegin; nY < nEnd; ++nY)
+				{
+					funcOp(xView.Row(int(nY)), iWidth, int(nY));
+				}
+			});
+		}
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Calls funcOp(xPixel) for each pixel of a view, with rows processed in parallel. The inner loop runs
+		/// 	over a plain pointer range, so that the compiler can vectorize simple operators.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TPixel, typename FuncOp>
+		void ForEachPixel(const CImageView<TPixel>& xView, FuncOp funcOp)
+		{
+			ForEachRow(xView, [&](TPixel* pRow, int iWidth, int)
+			{
+				for (TPixel* pPixel = pRow, *pEnd = pRow + iWidth; pPixel != pEnd; ++pPixel)
+				{
+					funcOp(*pPixel);
+				}
+			});
+		}
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Calls funcOp(xPixelA, xPixelB) for the pixels at the same position of two views of equal size, with
+		/// 	rows processed in parallel.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TPixelA, typename TPixelB, typename FuncOp>
+		void ForEachPixelPair(const CImageView<TPixelA>& xViewA, const CImageView<TPixelB>& xViewB, FuncOp funcOp)
+		{
+			if (xViewA.Width() != xViewB.Width() || xViewA.Height() != xViewB.Height())
+			{
+				throw CLU_EXCEPTION("Image views differ in size");
+			}
+
+			ForEachRow(xViewA, [&](TPixelA* pRowA, int iWidth, int iY)
+			{
+				TPixelB* pRowB = xViewB.Row(iY);
+				for (int iX = 0; iX < iWidth; ++iX)
+				{
+					funcOp(pRowA[iX], pRowB[iX]);
+				}
+			});
+		}
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Sets each target pixel to funcOp(xSrcPixel) of the source pixel at the same position, with rows
+		/// 	processed in parallel. Target and source may be the same view.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TTrgPixel, typename TSrcPixel, typename FuncOp>
+		void Transform(const CImageView<TTrgPixel>& xTrgView, const CImageView<TSrcPixel>& xSrcView, FuncOp funcOp)
+		{
+			static_assert(!std::is_const<TTrgPixel>::value, "The target view has to be writable");
+
+			ForEachPixelPair(xTrgView, xSrcView, [&](TTrgPixel& xTrg, TSrcPixel& xSrc)
+			{
+				xTrg = funcOp(xSrc);
+			});
+		}
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Calls funcOp(TPixel()) with the SPixel type of the given pixel and data type. This is the one type
+		/// 	switch needed to run a generic lambda, which creates a CImageView<decltype(xPixel)>, on any image.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename FuncOp>
+		void DispatchPixelType(EPixelType ePixelType, EDataType eDataType, FuncOp funcOp);
+
+		namespace _View
+		{
+			template<typename TPixelTypeInfo, typename FuncOp>
+			void _DispatchDataType(EDataType eDataType, FuncOp& funcOp)
+			{
+				switch (eDataType)
+				{
+				case EDataType::Int8:
+					funcOp(SPixel<TPixelTypeInfo, T_Int8>());
+					break;
+				case EDataType::UInt8:
+					funcOp(SPixel<TPixelTypeInfo, T_UInt8>());
+					break;
+				case EDataType::Int16:
+					funcOp(SPixel<TPixelTypeInfo, T_Int16>());
+					break;
+				case EDataType::UInt16:
+					funcOp(SPixel<TPixelTypeInfo, T_UInt16>());
+					break;
+				case EDataType::Int32:
+					funcOp(SPixel<TPixelTypeInfo, T_Int32>());
+					break;
+				case EDataType::UInt32:
+					funcOp(SPixel<TPixelTypeInfo, T_UInt32>());
+					break;
+				case EDataType::Single:
+					funcOp(SPixel<TPixelTypeInfo, T_Single>());
+					break;
+				case EDataType::Double:
+					funcOp(SPixel<TPixelTypeInfo, T_Double>());
+					break;
+				default:
+					throw CLU_EXCEPTION("Unsupported data type");
+				}
+			}
+		} // namespace _View
+
+		template<typename FuncOp>
+		void DispatchPixelType(EPixelType ePixelType, EDataType eDataType, FuncOp funcOp)
+		{
+			switch (ePixelType)
+			{
+			case EPixelType::Lum:
+				_View::_DispatchDataType<T_Lum>(eDataType, funcOp);
+				break;
+			case EPixelType::LumA:
+				_View::_DispatchDataType<T_LumA>(eDataType, funcOp);
+				break;
+			case EPixelType::RGB:
+				_View::_DispatchDataType<T_RGB>(eDataType, funcOp);
+				break;
+			case EPixelType::RGBA:
+				_View::_DispatchDataType<T_RGBA>(eDataType, funcOp);
+				break;
+			case EPixelType::BGR:
+				_View::_DispatchDataType<T_BGR>(eDataType, funcOp);
+				break;
+			case EPixelType::BGRA:
+				_View::_DispatchDataType<T_BGRA>(eDataType, funcOp);
+				break;
+			default:
+				throw CLU_EXCEPTION("Unsupported pixel type");
+			}
+		}
+
+	} // namespace ImgProc
+} // namespace Clu
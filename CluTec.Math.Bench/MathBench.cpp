@@ -0,0 +1,319 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Math.Bench
+// file:      MathBench.cpp
+//
+// summary:   Benchmarks of the CluTec.Math matrix and vector kernels
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "stdafx.h"
+
+#include <string>
+#include <vector>
+
+#include "CluTec.Base/Benchmark.h"
+
+#include "CluTec.Math/Matrix.h"
+#include "CluTec.Math/Matrix.Operators.h"
+#include "CluTec.Math/Matrix.Algo.GE.h"
+#include "CluTec.Math/Matrix.Algo.SVD.h"
+#include "CluTec.Math/Congruence.h"
+#include "CluTec.Math/Static.Vector.h"
+#include "CluTec.Math/Static.Vector.Math.h"
+#include "CluTec.Math/Static.Matrix.h"
+#include "CluTec.Math/Static.Matrix.Math.h"
+
+CLU_BENCHMARK_TRACK_ALLOCATIONS()
+
+namespace
+{
+	using Clu::Benchmark::CRunner;
+	using Clu::Benchmark::DoNotOptimize;
+
+	// Number of small static operations performed per benchmark call.
+	const size_t StaticBatchSize = 1024;
+
+	template<typename TValue> const char* TypeName();
+	template<> const char* TypeName<float>() { return "float"; }
+	template<> const char* TypeName<double>() { return "double"; }
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>	Fills a matrix with reproducible values that make it well conditioned. </summary>
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	template<typename TValue>
+	Clu::CMatrix<TValue> MakeMatrix(size_t nRowCnt, size_t nColCnt, unsigned uSeed)
+	{
+		Clu::CMatrix<TValue> matA(nRowCnt, nColCnt);
+
+		unsigned uState = uSeed * 2654435761u + 1u;
+		for (size_t nRow = 0; nRow < nRowCnt; ++nRow)
+		{
+			for (size_t nCol = 0; nCol < nColCnt; ++nCol)
+			{
+				uState = uState * 1664525u + 1013904223u;
+				matA(nRow, nCol) = TValue(double(uState >> 8) / double(1u << 24) - 0.5);
+			}
+
+			if (nRow < nColCnt)
+			{
+				matA(nRow, nRow) += TValue(nColCnt);
+			}
+		}
+
+		return matA;
+	}
+
+	template<typename TValue>
+	void BenchDynamicProduct(CRunner& xRunner)
+	{
+		for (size_t nDim : { 8, 32, 128, 256 })
+		{
+			for (int iTrans = 0; iTrans < 4; ++iTrans)
+			{
+				const bool bTransA = (iTrans & 1) != 0;
+				const bool bTransB = (iTrans & 2) != 0;
+
+				Clu::CMatrix<TValue> matA = MakeMatrix<TValue>(nDim, nDim, 1);
+				Clu::CMatrix<TValue> matB = MakeMatrix<TValue>(nDim, nDim, 2);
+				if (bTransA)
+				{
+					matA.Transpose();
+				}
+				if (bTransB)
+				{
+					matB.Transpose();
+				}
+
+				const std::string sName = std::string("CMatrix.operator*/") + TypeName<TValue>() + "/" + std::to_string(nDim)
+					+ (bTransA ? "/At" : "/A") + (bTransB ? "Bt" : "B");
+
+				xRunner.Run(sName, 2.0 * double(nDim) * double(nDim) * double(nDim), [&]()
+				{
+					Clu::CMatrix<TValue> matC = matA * matB;
+					DoNotOptimize(matC);
+				});
+			}
+		}
+	}
+
+	template<typename TValue>
+	void BenchBlockProduct(CRunner& xRunner)
+	{
+		for (size_t nDim : { 32, 128 })
+		{
+			for (size_t nBlockCnt : { 1, 4, 16 })
+			{
+				// A consists of nBlockCnt row blocks of nDim/nBlockCnt x nDim, each multiplied with a nDim x nDim block of B.
+				Clu::CMatrix<TValue> matA = MakeMatrix<TValue>(nDim, nDim, 3);
+				Clu::CMatrix<TValue> matB = MakeMatrix<TValue>(nBlockCnt * nDim, nDim, 4);
+				Clu::CMatrix<TValue> matC;
+
+				const std::string sName = std::string("MatrixBlockProduct/") + TypeName<TValue>() + "/" + std::to_string(nDim)
+					+ "/blocks" + std::to_string(nBlockCnt);
+
+				xRunner.Run(sName, 2.0 * double(nDim) * double(nDim) * double(nDim), [&]()
+				{
+					Clu::MatrixBlockProduct(matC, matA, matB, nBlockCnt);
+					DoNotOptimize(matC);
+				});
+			}
+		}
+	}
+
+	template<typename TValue>
+	void BenchApplyToMemory(CRunner& xRunner)
+	{
+		for (size_t nDim : { 32, 256, 1024 })
+		{
+			const Clu::CMatrix<TValue> matSrc = MakeMatrix<TValue>(nDim, nDim, 5);
+			Clu::CMatrix<TValue> matA;
+
+			const std::string sName = std::string("CMatrix.ApplyToMemory/") + TypeName<TValue>() + "/" + std::to_string(nDim);
+
+			xRunner.Run(sName, 0.0, [&]()
+			{
+				matA = matSrc;
+				matA.Transpose();
+				matA.ApplyToMemory();
+				DoNotOptimize(matA);
+			});
+		}
+	}
+
+	template<typename TValue>
+	void BenchSVD(CRunner& xRunner)
+	{
+		for (size_t nDim : { 8, 32, 64 })
+		{
+			const Clu::CMatrix<TValue> matA = MakeMatrix<TValue>(nDim, nDim, 6);
+			Clu::CMatrix<TValue> matU, matD, matV;
+
+			const std::string sName = std::string("CMatrixAlgoSVD.SVD/") + TypeName<TValue>() + "/" + std::to_string(nDim);
+
+			// Nominal flop count of the Golub-Reinsch SVD with accumulation of U and V, 4m^2n + 8mn^2 + 9n^3 for m = n.
+			const double dN = double(nDim);
+			xRunner.Run(sName, 21.0 * dN * dN * dN, [&]()
+			{
+				Clu::CMatrixAlgoSVD<TValue>::SVD(matU, matD, matV, matA);
+				DoNotOptimize(matD);
+			});
+		}
+	}
+
+	template<typename TValue>
+	void BenchGaussInverse(CRunner& xRunner)
+	{
+		for (size_t nDim : { 8, 32, 128 })
+		{
+			const Clu::CMatrix<TValue> matA = MakeMatrix<TValue>(nDim, nDim, 7);
+			Clu::CMatrix<TValue> matInv;
+			const Clu::CCongruence_Float<TValue> xCongruence;
+
+			const std::string sName = std::string("CMatrixAlgoGE.Inverse/") + TypeName<TValue>() + "/" + std::to_string(nDim);
+
+			const double dN = double(nDim);
+			xRunner.Run(sName, 2.0 * dN * dN * dN, [&]()
+			{
+				Clu::CMatrixAlgoGE<TValue>::Inverse(matInv, matA, xCongruence);
+				DoNotOptimize(matInv);
+			});
+		}
+	}
+
+	template<typename TValue, uint32_t t_nDim, uint32_t t_nTransA, uint32_t t_nTransB>
+	void BenchStaticProduct(CRunner& xRunner)
+	{
+		using TMat = Clu::_SMatrix<TValue, t_nDim>;
+
+		std::vector<TMat> vecA(StaticBatchSize), vecB(StaticBatchSize), vecC(StaticBatchSize);
+		for (size_t nIdx = 0; nIdx < StaticBatchSize; ++nIdx)
+		{
+			for (uint32_t uRow = 0; uRow < t_nDim; ++uRow)
+			{
+				for (uint32_t uCol = 0; uCol < t_nDim; ++uCol)
+				{
+					vecA[nIdx](uRow, uCol) = TValue(1) / TValue(1 + nIdx + uRow + uCol);
+					vecB[nIdx](uRow, uCol) = TValue(uRow == uCol ? 1 : 0) + TValue(0.01) * TValue(uCol);
+				}
+			}
+		}
+
+		const std::string sName = std::string("_SMatrix.MatrixProduct/") + TypeName<TValue>() + "/" + std::to_string(t_nDim)
+			+ (t_nTransA ? "/At" : "/A") + (t_nTransB ? "Bt" : "B");
+
+		const double dN = double(t_nDim);
+		xRunner.Run(sName, 2.0 * dN * dN * dN, [&]()
+		{
+			for (size_t nIdx = 0; nIdx < StaticBatchSize; ++nIdx)
+			{
+				Clu::MatrixProduct<t_nTransA, t_nTransB>(vecC[nIdx], vecA[nIdx], vecB[nIdx]);
+			}
+			DoNotOptimize(vecC.front());
+		}, StaticBatchSize);
+	}
+
+	template<typename TValue, uint32_t t_nDim>
+	void BenchStaticVector(CRunner& xRunner)
+	{
+		using TMat = Clu::_SMatrix<TValue, t_nDim>;
+		using TVec = Clu::_SVector<TValue, t_nDim>;
+
+		TMat matA;
+		matA.SetIdentity();
+		matA(0, t_nDim - 1) = TValue(0.5);
+
+		std::vector<TVec> vecA(StaticBatchSize), vecB(StaticBatchSize);
+		for (size_t nIdx = 0; nIdx < StaticBatchSize; ++nIdx)
+		{
+			for (uint32_t uIdx = 0; uIdx < t_nDim; ++uIdx)
+			{
+				vecA[nIdx][uIdx] = TValue(nIdx % 17) + TValue(uIdx);
+			}
+		}
+
+		const std::string sType = std::string(TypeName<TValue>()) + "/" + std::to_string(t_nDim);
+		const double dN = double(t_nDim);
+
+		xRunner.Run("_SMatrix.operator*(vector)/" + sType, 2.0 * dN * dN, [&]()
+		{
+			for (size_t nIdx = 0; nIdx < StaticBatchSize; ++nIdx)
+			{
+				vecB[nIdx] = matA * vecA[nIdx];
+			}
+			DoNotOptimize(vecB.front());
+		}, StaticBatchSize);
+
+		xRunner.Run("_SVector.Dot/" + sType, 2.0 * dN, [&]()
+		{
+			TValue xSum = TValue(0);
+			for (size_t nIdx = 0; nIdx < StaticBatchSize; ++nIdx)
+			{
+				xSum += Clu::Dot(vecA[nIdx], vecB[nIdx]);
+			}
+			DoNotOptimize(xSum);
+		}, StaticBatchSize);
+
+		xRunner.Run("_SVector.Normalize/" + sType, 4.0 * dN, [&]()
+		{
+			for (size_t nIdx = 0; nIdx < StaticBatchSize; ++nIdx)
+			{
+				vecB[nIdx] = Clu::Normalize(vecA[nIdx]);
+			}
+			DoNotOptimize(vecB.front());
+		}, StaticBatchSize);
+	}
+
+	template<typename TValue>
+	void BenchStatic(CRunner& xRunner)
+	{
+		BenchStaticProduct<TValue, 3, 0, 0>(xRunner);
+		BenchStaticProduct<TValue, 3, 1, 0>(xRunner);
+		BenchStaticProduct<TValue, 3, 0, 1>(xRunner);
+		BenchStaticProduct<TValue, 4, 0, 0>(xRunner);
+		BenchStaticProduct<TValue, 4, 1, 0>(xRunner);
+		BenchStaticProduct<TValue, 4, 0, 1>(xRunner);
+
+		BenchStaticVector<TValue, 3>(xRunner);
+		BenchStaticVector<TValue, 4>(xRunner);
+	}
+} // namespace
+
+int main(int iArgCnt, char* ppcArg[])
+{
+	return Clu::Benchmark::Main(iArgCnt, ppcArg, "CluTec.Math", [](CRunner& xRunner)
+	{
+		BenchStatic<float>(xRunner);
+		BenchStatic<double>(xRunner);
+
+		BenchDynamicProduct<float>(xRunner);
+		BenchDynamicProduct<double>(xRunner);
+
+		BenchBlockProduct<float>(xRunner);
+		BenchBlockProduct<double>(xRunner);
+
+		BenchApplyToMemory<float>(xRunner);
+		BenchApplyToMemory<double>(xRunner);
+
+		BenchSVD<double>(xRunner);
+		BenchGaussInverse<double>(xRunner);
+	});
+}
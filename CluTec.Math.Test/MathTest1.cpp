@@ -36,11 +36,18 @@
 #include "CluTec.Math/Static.Matrix.h"
 #include "CluTec.Math/Static.Matrix.IO.h"
 #include "CluTec.Math/Static.Polynomial.h"
+#include "CluTec.Math/Static.Polynomial.Algo.h"
 #include "CluTec.Math/Static.Geometry.h"
 #include "CluTec.Math/Conversion.h"
 #include "CluTec.Math/Frame3D.h"
 #include "CluTec.Math/Constants.h"
 #include "CluTec.Math/MapPixelValue.h"
+#include "CluTec.Math/SpatialIndex.KdTree.h"
+#include "CluTec.Math/SpatialIndex.VoxelHash.h"
+#include "CluTec.Math/Registration.ICP.h"
+#include "CluTec.Math/AutoDiff.h"
+
+#include "CluTec.ImgProc/Camera.Pinhole.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -319,5 +326,346 @@ namespace CluTecMathTest
 			Test_MapPixelValue<int8_t>(float(-1.0));
 
 		}
+
+		TEST_METHOD(ImplementSpatialIndex)
+		{
+			using TVec3 = Clu::_SVector<double, 3>;
+			using TIdx = Clu::SpatialIndex::TIdx;
+
+			std::vector<TVec3> vecPoint;
+			for (int iZ = 0; iZ < 10; ++iZ)
+			{
+				for (int iY = 0; iY < 20; ++iY)
+				{
+					for (int iX = 0; iX < 30; ++iX)
+					{
+						TVec3 vX;
+						vX.SetElements(0.1 * iX, 0.1 * iY + 0.01 * iX, 0.1 * iZ);
+						vecPoint.push_back(vX);
+					}
+				}
+			}
+
+			Clu::SpatialIndex::CKdTree3D<double> xTree;
+			Clu::SpatialIndex::CKdTree3D<double, Clu::SpatialIndex::CPointStoreSoAFloat<double>> xTreeF;
+			Clu::SpatialIndex::CVoxelHashGrid3D<double> xGrid;
+
+			xTree.Create(vecPoint, 8);
+			xTreeF.Create(vecPoint, 8);
+			xGrid.Create(vecPoint, 0.25);
+
+			const uint32_t nK = 5;
+			for (int iQuery = 0; iQuery < 50; ++iQuery)
+			{
+				TVec3 vQuery;
+				vQuery.SetElements(0.063 * iQuery - 0.2, 0.031 * iQuery, 0.55);
+
+				std::vector<double> vecDistSq;
+				for (const TVec3& vX : vecPoint)
+				{
+					vecDistSq.push_back(Clu::DistanceSquare(vX, vQuery));
+				}
+				std::sort(vecDistSq.begin(), vecDistSq.end());
+
+				TIdx pIdx[nK], pIdxF[nK], pIdxG[nK];
+				double pDistSq[nK], pDistSqF[nK], pDistSqG[nK];
+
+				Assert::IsTrue(xTree.FindKNearest(vQuery, nK, pIdx, pDistSq) == nK, L"k-d tree neighbor count");
+				Assert::IsTrue(xTreeF.FindKNearest(vQuery, nK, pIdxF, pDistSqF) == nK, L"k-d tree float neighbor count");
+				Assert::IsTrue(xGrid.FindKNearest(vQuery, nK, pIdxG, pDistSqG) == nK, L"Voxel grid neighbor count");
+
+				for (uint32_t i = 0; i < nK; ++i)
+				{
+					Assert::IsTrue(abs(pDistSq[i] - vecDistSq[i]) < 1e-12, L"k-d tree neighbor distance");
+					Assert::IsTrue(abs(pDistSqF[i] - vecDistSq[i]) < 1e-5, L"k-d tree float neighbor distance");
+					Assert::IsTrue(abs(pDistSqG[i] - vecDistSq[i]) < 1e-12, L"Voxel grid neighbor distance");
+					Assert::IsTrue(abs(Clu::DistanceSquare(vecPoint[pIdx[i]], vQuery) - pDistSq[i]) < 1e-12, L"k-d tree neighbor index");
+				}
+
+				size_t nInRadius = 0, nInRadiusG = 0;
+				const size_t nExpected = size_t(std::count_if(vecDistSq.begin(), vecDistSq.end(), [](double dDistSq) { return dDistSq <= 0.2 * 0.2; }));
+				xTree.ForEachInRadius(vQuery, 0.2, [&nInRadius](TIdx, double) { ++nInRadius; });
+				xGrid.ForEachInRadius(vQuery, 0.2, [&nInRadiusG](TIdx, double) { ++nInRadiusG; });
+
+				Assert::IsTrue(nInRadius == nExpected, L"k-d tree radius search");
+				Assert::IsTrue(nInRadiusG == nExpected, L"Voxel grid radius search");
+			}
+		}
+
+		TEST_METHOD(ImplementIcp)
+		{
+			using TVec3 = Clu::_SVector<double, 3>;
+			using TIcp = Clu::Registration::CIcp<double>;
+
+			// Target: a curved surface patch. Source: the same points mapped by the inverse of a known frame.
+			std::vector<TVec3> vecTarget;
+			for (int iY = 0; iY < 60; ++iY)
+			{
+				for (int iX = 0; iX < 60; ++iX)
+				{
+					// Irregular sampling avoids local minima of the point to point metric on a regular grid.
+					const double dX = iX / 30.0 - 1.0 + 0.01 * sin(12.9898 * iX + 78.233 * iY);
+					const double dY = iY / 30.0 - 1.0 + 0.01 * cos(39.3468 * iX + 11.135 * iY);
+
+					TVec3 vX;
+					vX.SetElements(dX, dY, 0.3 * sin(3.0 * dX) * cos(2.0 * dY) + 0.2 * dX * dY);
+					vecTarget.push_back(vX);
+				}
+			}
+
+			TVec3 vOmega, vT;
+			vOmega.SetElements(0.03, -0.02, 0.05);
+			vT.SetElements(0.05, -0.03, 0.02);
+
+			Clu::CFrame3D<double> xTrue;
+			xTrue.Create(TIcp::RotationFromAxisAngle(vOmega), vT);
+
+			std::vector<TVec3> vecSource;
+			for (const TVec3& vX : vecTarget)
+			{
+				vecSource.push_back(xTrue.MapIntoFrame(vX));
+			}
+
+			Clu::SpatialIndex::CKdTree3D<double> xTree;
+			xTree.Create(vecTarget);
+
+			std::vector<TVec3> vecNormal(vecTarget.size());
+			Clu::Registration::EstimateNormals(xTree, vecTarget.data(), vecTarget.size(), 9, vecNormal.data());
+
+			TIcp xIcp;
+			xIcp.Create(xTree, vecTarget.data(), vecNormal.data());
+
+			Clu::Registration::SIcpParameters<double> xParams;
+			xParams.uMaxIterationCount = 100;
+
+			for (auto eMetric : { Clu::Registration::EIcpMetric::PointToPoint, Clu::Registration::EIcpMetric::PointToPlane })
+			{
+				xParams.eMetric = eMetric;
+
+				Clu::CFrame3D<double> xFrame;
+				xFrame.Reset();
+
+				auto xResult = xIcp.Align(vecSource.data(), vecSource.size(), xFrame, xParams);
+
+				Assert::IsTrue(xResult.bConverged, L"ICP converged");
+				Assert::IsTrue(xResult.dRmsError < 1e-6, L"ICP residual");
+				Assert::IsTrue(Clu::Length(xFrame.Translation_l_r() - vT) < 1e-6, L"ICP translation");
+
+				for (uint32_t i = 0; i < 3; ++i)
+				{
+					for (uint32_t j = 0; j < 3; ++j)
+					{
+						Assert::IsTrue(abs(xFrame.Basis_l_r()(i, j) - xTrue.Basis_l_r()(i, j)) < 1e-6, L"ICP rotation");
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(ImplementPolynomialAlgo)
+		{
+			// p(x) = (x + 2)(x - 0.5)(x - 1)^2 (x - 3)
+			Clu::_SPolynomial<double, 5> yA;
+			yA.vtParameter.SetElements(3.0, -11.5, 12.5, -1.5, -3.5, 1.0);
+
+			double pdRoot[5];
+			const unsigned uRootCount = Clu::PolyRealRoots(yA, pdRoot);
+			const double pdExpected[] = { -2.0, 0.5, 1.0, 3.0 };
+
+			Assert::IsTrue(uRootCount == 4, L"Real root count");
+			for (unsigned uIdx = 0; uIdx < uRootCount; ++uIdx)
+			{
+				Assert::IsTrue(abs(pdRoot[uIdx] - pdExpected[uIdx]) < 1e-6, L"Real root value");
+			}
+
+			std::vector<double> vecX, vecY(101), vecDY(101);
+			for (int iIdx = 0; iIdx <= 100; ++iIdx)
+			{
+				vecX.push_back(-2.0 + 0.05 * iIdx);
+			}
+
+			Clu::PolyEvaluate(yA, vecX.data(), vecY.data(), vecDY.data(), vecX.size());
+
+			Clu::CPolyFitLSStream<double, 5> xFit(0.5, 2.5);
+			const auto yDA = yA.Derivative();
+			for (size_t nIdx = 0; nIdx < vecX.size(); ++nIdx)
+			{
+				Assert::IsTrue(abs(vecY[nIdx] - yA(vecX[nIdx])) < 1e-10, L"Batch evaluation");
+				Assert::IsTrue(abs(vecDY[nIdx] - yDA(vecX[nIdx])) < 1e-10, L"Batch derivative");
+
+				xFit.Add(vecX[nIdx], vecY[nIdx]);
+			}
+
+			Clu::_SPolynomial<double, 5> yFit;
+			double dRmsDev;
+			Assert::IsTrue(xFit.Solve(yFit, dRmsDev), L"Streaming fit");
+			Assert::IsTrue(dRmsDev < 1e-8, L"Streaming fit deviation");
+
+			for (int iIdx = 0; iIdx <= 5; ++iIdx)
+			{
+				Assert::IsTrue(abs(yFit[iIdx] - yA[iIdx]) < 1e-8, L"Streaming fit parameter");
+			}
+		}
+
+		TEST_METHOD(ImplementAutoDiff)
+		{
+			using TDual = Clu::AutoDiff::SDual<double, 6>;
+
+			// f(phi, t) = |F(phi, t) * p|^2 + atan2(y, x), with the frame rotation angles and translation as variables
+			const double pdVar[] = { 0.3, -0.2, 0.7, 1.0, -2.0, 0.5 };
+			auto funcF = [](const auto* pVar)
+			{
+				using TValue = typename std::decay<decltype(pVar[0])>::type;
+
+				Clu::_SVector<TValue, 3> vT, vP;
+				vT.SetElements(pVar[3], pVar[4], pVar[5]);
+				vP.SetElements(TValue(0.5), TValue(-1.5), TValue(2.0));
+
+				Clu::CFrame3D<TValue> xFrame;
+				xFrame.Create(pVar[0], pVar[1], pVar[2], vT);
+
+				Clu::_SVector<TValue, 3> vX = xFrame.MapOutOfFrame(vP);
+				return Clu::LengthSquare(vX) + atan2(vX[1], vX[0]) + exp(vX[2] / TValue(4));
+			};
+
+			TDual pxVar[6];
+			for (uint32_t uIdx = 0; uIdx < 6; ++uIdx)
+			{
+				pxVar[uIdx] = TDual::Variable(pdVar[uIdx], uIdx);
+			}
+
+			const TDual xF = funcF(pxVar);
+			Assert::IsTrue(abs(xF.Value() - funcF(pdVar)) < 1e-12, L"Dual value");
+
+			for (uint32_t uIdx = 0; uIdx < 6; ++uIdx)
+			{
+				double pdP[6], pdM[6];
+				std::copy(pdVar, pdVar + 6, pdP);
+				std::copy(pdVar, pdVar + 6, pdM);
+				pdP[uIdx] += 1e-6;
+				pdM[uIdx] -= 1e-6;
+
+				const double dNumGrad = (funcF(pdP) - funcF(pdM)) / 2e-6;
+				Assert::IsTrue(abs(xF.Grad(uIdx) - dNumGrad) < 1e-6, L"Dual gradient");
+			}
+
+			// Gradient padding stays zero
+			for (uint32_t uIdx = TDual::VarCount; uIdx < TDual::GradSize; ++uIdx)
+			{
+				Assert::IsTrue(xF.pGrad[uIdx] == 0.0, L"Dual gradient padding");
+			}
+		}
+
+		TEST_METHOD(ImplementAutoDiffRotation)
+		{
+			using TDual = Clu::AutoDiff::SDual<double, 3>;
+
+			// f(phi) = angle + axis x - axis z of the rotation of a frame, with the frame rotation angles as variables
+			const double pdVar[] = { 0.3, -0.2, 0.7 };
+			auto funcF = [](const auto* pVar)
+			{
+				using TValue = typename std::decay<decltype(pVar[0])>::type;
+
+				Clu::_SVector<TValue, 3> vT;
+				vT.SetZero();
+
+				Clu::CFrame3D<TValue> xFrame;
+				xFrame.Create(pVar[0], pVar[1], pVar[2], vT);
+
+				Clu::_SVector4<TValue> vAxisAngle = Clu::AxisAndAngleFromRotMat3(xFrame.Basis_l_r());
+				return vAxisAngle.w() + vAxisAngle.x() - vAxisAngle.z();
+			};
+
+			TDual pxVar[3];
+			for (uint32_t uIdx = 0; uIdx < 3; ++uIdx)
+			{
+				pxVar[uIdx] = TDual::Variable(pdVar[uIdx], uIdx);
+			}
+
+			const TDual xF = funcF(pxVar);
+			Assert::IsTrue(abs(xF.Value() - funcF(pdVar)) < 1e-12, L"Dual value of axis and angle");
+
+			for (uint32_t uIdx = 0; uIdx < 3; ++uIdx)
+			{
+				double pdP[3], pdM[3];
+				std::copy(pdVar, pdVar + 3, pdP);
+				std::copy(pdVar, pdVar + 3, pdM);
+				pdP[uIdx] += 1e-6;
+				pdM[uIdx] -= 1e-6;
+
+				const double dNumGrad = (funcF(pdP) - funcF(pdM)) / 2e-6;
+				Assert::IsTrue(abs(xF.Grad(uIdx) - dNumGrad) < 1e-6, L"Dual gradient of axis and angle");
+			}
+		}
+
+		TEST_METHOD(ImplementAutoDiffPinhole)
+		{
+			using TDual = Clu::AutoDiff::SDual<double, 3>;
+
+			// The distorted pixel position of a world point, with the world point as variables
+			const double pdVar[] = { 0.1, -0.05, -2.0 };
+			auto funcF = [](const auto* pVar)
+			{
+				using TValue = typename std::decay<decltype(pVar[0])>::type;
+				using TPinhole = Clu::Camera::_CPinhole<TValue>;
+
+				typename TPinhole::TVec3 vT, vPinholeM_s, vPos_w;
+				vT.SetElements(TValue(0.01), TValue(0.02), TValue(0.0));
+				vPinholeM_s.SetElements(TValue(1e-5), TValue(-2e-5), TValue(-0.004));
+				vPos_w.SetElements(pVar[0], pVar[1], pVar[2]);
+
+				typename TPinhole::TFrame3D xFrame;
+				xFrame.Create(TValue(0.05), TValue(-0.03), TValue(0.1), vT);
+
+				typename TPinhole::TUVec2 vResolutionPX;
+				vResolutionPX.SetElements(640u, 480u);
+
+				typename TPinhole::TVec2 vPixelSizeM;
+				vPixelSizeM.SetElements(TValue(5e-6), TValue(5e-6));
+
+				typename TPinhole::TSensor xSensor;
+				xSensor.Create(xFrame, vResolutionPX, vPixelSizeM);
+
+				typename TPinhole::TDistort xDistort;
+				xDistort.Create(TValue(1e-3), TValue(-5e-4), TValue(-0.1), TValue(0.02), TValue(0), TValue(0), TValue(0), TValue(0));
+
+				TPinhole camPinhole;
+				camPinhole.Create(xSensor, vPinholeM_s, xDistort);
+
+				TValue dX, dY, dDepth_s;
+				camPinhole.Project_WorldM_to_PixelF(dX, dY, dDepth_s, vPos_w);
+
+				typename TPinhole::TVec2 vPosPX, vDistPX;
+				vPosPX.SetElements(dX, dY);
+				camPinhole.Distortion().DistortPX(vDistPX, vPosPX, camPinhole);
+
+				return vDistPX;
+			};
+
+			TDual pxVar[3];
+			for (uint32_t uIdx = 0; uIdx < 3; ++uIdx)
+			{
+				pxVar[uIdx] = TDual::Variable(pdVar[uIdx], uIdx);
+			}
+
+			const Clu::_SVector<TDual, 2> vxF = funcF(pxVar);
+			const Clu::_SVector<double, 2> vdF = funcF(pdVar);
+
+			for (uint32_t uDim = 0; uDim < 2; ++uDim)
+			{
+				Assert::IsTrue(abs(vxF[uDim].Value() - vdF[uDim]) < 1e-9, L"Dual value of the pixel position");
+
+				for (uint32_t uIdx = 0; uIdx < 3; ++uIdx)
+				{
+					double pdP[3], pdM[3];
+					std::copy(pdVar, pdVar + 3, pdP);
+					std::copy(pdVar, pdVar + 3, pdM);
+					pdP[uIdx] += 1e-6;
+					pdM[uIdx] -= 1e-6;
+
+					const double dNumGrad = (funcF(pdP)[uDim] - funcF(pdM)[uDim]) / 2e-6;
+					Assert::IsTrue(abs(vxF[uDim].Grad(uIdx) - dNumGrad) < 1e-5 * (1.0 + abs(dNumGrad)), L"Dual gradient of the pixel position");
+				}
+			}
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,466 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Math
+// file:      AutoDiff.h
+//
+// summary:   Declares the forward mode automatic differentiation dual number class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+// Include definition of sqrt if standard C compiler compiles this code
+#if !defined(__NVCC__)
+	#include <math.h>
+#endif
+
+#include <stdint.h>
+#include <type_traits>
+
+#include "CluTec.Base/Defines.h"
+#include "Static.Vector.h"
+
+namespace Clu
+{
+	namespace AutoDiff
+	{
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Forward mode automatic differentiation scalar. Stores a value together with its gradient with respect to
+		/// 	t_nVarCount independent variables. Every arithmetic operation and every math function declared in this
+		/// 	file updates the gradient by the chain rule, so that instantiating templates like _SVector, _SMatrix,
+		/// 	_CFrame3D or the camera models with SDual as value type evaluates their Jacobians alongside their values.
+		///
+		/// 	The gradient is stored in an aligned array padded to a multiple of the SIMD register width, with the
+		/// 	padding kept at zero. All gradient loops therefore have a fixed trip count over aligned memory and are
+		/// 	vectorized by the compiler.
+		/// </summary>
+		///
+		/// <typeparam name="_TValue">	   Type of the value and gradient components. </typeparam>
+		/// <typeparam name="t_nVarCount"> Number of independent variables. </typeparam>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename _TValue, uint32_t t_nVarCount>
+		struct SDual
+		{
+		public:
+			using TValue = _TValue;
+			using TThis = SDual<TValue, t_nVarCount>;
+			using TIdx = uint32_t;
+
+			static const uint32_t VarCount = t_nVarCount;
+
+			// The gradient is padded to the width of an AVX register and aligned to that of an SSE2 register. The layout
+			// is thus the same whether a file is compiled for AVX2 or not, and the objects need no over-aligned heap
+			// memory. Code compiled for AVX2 reads the gradient with unaligned loads, which cost little on such processors.
+			static const uint32_t SimdBytes = 32;
+			static const uint32_t SimdAlign = 16;
+			static const uint32_t SimdWidth = (sizeof(TValue) >= SimdBytes ? 1 : uint32_t(SimdBytes / sizeof(TValue)));
+			static const uint32_t GradSize = ((t_nVarCount + SimdWidth - 1) / SimdWidth) * SimdWidth;
+
+			/// <summary>	The gradient. Elements from VarCount to GradSize - 1 are always zero. </summary>
+			alignas(SimdAlign) TValue pGrad[GradSize];
+
+			/// <summary>	The value. </summary>
+			TValue xValue;
+
+		public:
+			SDual() = default;
+
+			__CUDA_HDI__ SDual(const TValue& xVal)
+			{
+				xValue = xVal;
+				SetGradZero();
+			}
+
+			template<typename TScalar, typename = typename std::enable_if<std::is_arithmetic<TScalar>::value>::type>
+			__CUDA_HDI__ SDual(const TScalar& xVal)
+			{
+				xValue = TValue(xVal);
+				SetGradZero();
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Creates the independent variable with the given index and value. </summary>
+			///
+			/// <param name="xVal">	   The value. </param>
+			/// <param name="uVarIdx"> Zero-based index of the variable. </param>
+			///
+			/// <returns> A dual number with unit gradient in the direction of the variable. </returns>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			__CUDA_HDI__ static TThis Variable(const TValue& xVal, TIdx uVarIdx)
+			{
+				TThis xVar(xVal);
+				xVar.pGrad[uVarIdx] = TValue(1);
+				return xVar;
+			}
+
+			__CUDA_HDI__ void SetGradZero()
+			{
+				for (TIdx i = 0; i < GradSize; ++i)
+				{
+					pGrad[i] = TValue(0);
+				}
+			}
+
+			__CUDA_HDI__ const TValue& Value() const
+			{
+				return xValue;
+			}
+
+			__CUDA_HDI__ const TValue& Grad(TIdx uVarIdx) const
+			{
+				return pGrad[uVarIdx];
+			}
+
+			template<typename TScalar, typename = typename std::enable_if<std::is_arithmetic<TScalar>::value>::type>
+			__CUDA_HDI__ explicit operator TScalar() const
+			{
+				return TScalar(xValue);
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Returns a dual number with the given value and the gradient of this number scaled by the derivative
+			/// 	of the outer function. This is the common chain rule step of all unary functions.
+			/// </summary>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			__CUDA_HDI__ TThis Chain(const TValue& xResult, const TValue& xDerivative) const
+			{
+				TThis xR;
+				xR.xValue = xResult;
+				for (TIdx i = 0; i < GradSize; ++i)
+				{
+					xR.pGrad[i] = xDerivative * pGrad[i];
+				}
+				return xR;
+			}
+
+			__CUDA_HDI__ TThis operator-() const
+			{
+				return Chain(-xValue, TValue(-1));
+			}
+
+			__CUDA_HDI__ TThis operator+() const
+			{
+				return *this;
+			}
+
+			__CUDA_HDI__ TThis& operator+=(const TThis& xB)
+			{
+				xValue += xB.xValue;
+				for (TIdx i = 0; i < GradSize; ++i)
+				{
+					pGrad[i] += xB.pGrad[i];
+				}
+				return *this;
+			}
+
+			__CUDA_HDI__ TThis& operator-=(const TThis& xB)
+			{
+				xValue -= xB.xValue;
+				for (TIdx i = 0; i < GradSize; ++i)
+				{
+					pGrad[i] -= xB.pGrad[i];
+				}
+				return *this;
+			}
+
+			__CUDA_HDI__ TThis& operator*=(const TThis& xB)
+			{
+				for (TIdx i = 0; i < GradSize; ++i)
+				{
+					pGrad[i] = pGrad[i] * xB.xValue + xValue * xB.pGrad[i];
+				}
+				xValue *= xB.xValue;
+				return *this;
+			}
+
+			__CUDA_HDI__ TThis& operator/=(const TThis& xB)
+			{
+				const TValue xInv = TValue(1) / xB.xValue;
+				xValue *= xInv;
+				for (TIdx i = 0; i < GradSize; ++i)
+				{
+					pGrad[i] = (pGrad[i] - xValue * xB.pGrad[i]) * xInv;
+				}
+				return *this;
+			}
+
+			template<typename TScalar, typename = typename std::enable_if<std::is_arithmetic<TScalar>::value>::type>
+			__CUDA_HDI__ TThis& operator+=(const TScalar& xB)
+			{
+				xValue += TValue(xB);
+				return *this;
+			}
+
+			template<typename TScalar, typename = typename std::enable_if<std::is_arithmetic<TScalar>::value>::type>
+			__CUDA_HDI__ TThis& operator-=(const TScalar& xB)
+			{
+				xValue -= TValue(xB);
+				return *this;
+			}
+
+			template<typename TScalar, typename = typename std::enable_if<std::is_arithmetic<TScalar>::value>::type>
+			__CUDA_HDI__ TThis& operator*=(const TScalar& xB)
+			{
+				*this = Chain(xValue * TValue(xB), TValue(xB));
+				return *this;
+			}
+
+			template<typename TScalar, typename = typename std::enable_if<std::is_arithmetic<TScalar>::value>::type>
+			__CUDA_HDI__ TThis& operator/=(const TScalar& xB)
+			{
+				const TValue xInv = TValue(1) / TValue(xB);
+				*this = Chain(xValue * xInv, xInv);
+				return *this;
+			}
+		};
+
+		/// <summary>	True for the scalar types that mix with SDual in arithmetic expressions. </summary>
+		template<typename TScalar>
+		using TEnableIfScalar = typename std::enable_if<std::is_arithmetic<TScalar>::value>::type;
+
+#pragma region Arithmetic
+#define CLU_AUTODIFF_BINARY_OPERATORS(theOp) \
+		template<typename TValue, uint32_t t_nVarCount> \
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> operator theOp(const SDual<TValue, t_nVarCount>& xA, const SDual<TValue, t_nVarCount>& xB) \
+		{ \
+			SDual<TValue, t_nVarCount> xR(xA); \
+			xR theOp##= xB; \
+			return xR; \
+		} \
+		template<typename TValue, uint32_t t_nVarCount, typename TScalar, typename = TEnableIfScalar<TScalar>> \
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> operator theOp(const SDual<TValue, t_nVarCount>& xA, const TScalar& xB) \
+		{ \
+			SDual<TValue, t_nVarCount> xR(xA); \
+			xR theOp##= xB; \
+			return xR; \
+		} \
+		template<typename TValue, uint32_t t_nVarCount, typename TScalar, typename = TEnableIfScalar<TScalar>> \
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> operator theOp(const TScalar& xA, const SDual<TValue, t_nVarCount>& xB) \
+		{ \
+			SDual<TValue, t_nVarCount> xR(xA); \
+			xR theOp##= xB; \
+			return xR; \
+		}
+
+		CLU_AUTODIFF_BINARY_OPERATORS(+)
+		CLU_AUTODIFF_BINARY_OPERATORS(-)
+		CLU_AUTODIFF_BINARY_OPERATORS(*)
+		CLU_AUTODIFF_BINARY_OPERATORS(/)
+
+#undef CLU_AUTODIFF_BINARY_OPERATORS
+#pragma endregion
+
+#pragma region Comparison
+		// Comparisons only consider the value, so that branches in templated code follow the value.
+#define CLU_AUTODIFF_COMPARISON_OPERATORS(theOp) \
+		template<typename TValue, uint32_t t_nVarCount> \
+		__CUDA_HDI__ bool operator theOp(const SDual<TValue, t_nVarCount>& xA, const SDual<TValue, t_nVarCount>& xB) \
+		{ \
+			return xA.xValue theOp xB.xValue; \
+		} \
+		template<typename TValue, uint32_t t_nVarCount, typename TScalar, typename = TEnableIfScalar<TScalar>> \
+		__CUDA_HDI__ bool operator theOp(const SDual<TValue, t_nVarCount>& xA, const TScalar& xB) \
+		{ \
+			return xA.xValue theOp TValue(xB); \
+		} \
+		template<typename TValue, uint32_t t_nVarCount, typename TScalar, typename = TEnableIfScalar<TScalar>> \
+		__CUDA_HDI__ bool operator theOp(const TScalar& xA, const SDual<TValue, t_nVarCount>& xB) \
+		{ \
+			return TValue(xA) theOp xB.xValue; \
+		}
+
+		CLU_AUTODIFF_COMPARISON_OPERATORS(<)
+		CLU_AUTODIFF_COMPARISON_OPERATORS(<=)
+		CLU_AUTODIFF_COMPARISON_OPERATORS(>)
+		CLU_AUTODIFF_COMPARISON_OPERATORS(>=)
+		CLU_AUTODIFF_COMPARISON_OPERATORS(==)
+		CLU_AUTODIFF_COMPARISON_OPERATORS(!=)
+
+#undef CLU_AUTODIFF_COMPARISON_OPERATORS
+#pragma endregion
+
+#pragma region Functions
+		// The functions are found by argument dependent lookup, so unqualified calls like sqrt(x) in templated code
+		// work for both, built-in types and SDual.
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> sqrt(const SDual<TValue, t_nVarCount>& xA)
+		{
+			const TValue xR = ::sqrt(xA.xValue);
+			return xA.Chain(xR, TValue(0.5) / xR);
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> abs(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return (xA.xValue < TValue(0) ? -xA : xA);
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> fabs(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return abs(xA);
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> floor(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return SDual<TValue, t_nVarCount>(TValue(::floor(xA.xValue)));
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> ceil(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return SDual<TValue, t_nVarCount>(TValue(::ceil(xA.xValue)));
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> sin(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return xA.Chain(::sin(xA.xValue), ::cos(xA.xValue));
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> cos(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return xA.Chain(::cos(xA.xValue), -::sin(xA.xValue));
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> tan(const SDual<TValue, t_nVarCount>& xA)
+		{
+			const TValue xR = ::tan(xA.xValue);
+			return xA.Chain(xR, TValue(1) + xR * xR);
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> asin(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return xA.Chain(::asin(xA.xValue), TValue(1) / ::sqrt(TValue(1) - xA.xValue * xA.xValue));
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> acos(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return xA.Chain(::acos(xA.xValue), TValue(-1) / ::sqrt(TValue(1) - xA.xValue * xA.xValue));
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> atan(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return xA.Chain(::atan(xA.xValue), TValue(1) / (TValue(1) + xA.xValue * xA.xValue));
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> atan2(const SDual<TValue, t_nVarCount>& xY, const SDual<TValue, t_nVarCount>& xX)
+		{
+			// d atan2(y, x) = (x dy - y dx) / (x^2 + y^2)
+			const TValue xInvSq = TValue(1) / (xX.xValue * xX.xValue + xY.xValue * xY.xValue);
+			SDual<TValue, t_nVarCount> xR;
+			xR.xValue = ::atan2(xY.xValue, xX.xValue);
+			for (uint32_t i = 0; i < SDual<TValue, t_nVarCount>::GradSize; ++i)
+			{
+				xR.pGrad[i] = (xX.xValue * xY.pGrad[i] - xY.xValue * xX.pGrad[i]) * xInvSq;
+			}
+			return xR;
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> exp(const SDual<TValue, t_nVarCount>& xA)
+		{
+			const TValue xR = ::exp(xA.xValue);
+			return xA.Chain(xR, xR);
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> log(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return xA.Chain(::log(xA.xValue), TValue(1) / xA.xValue);
+		}
+
+		template<typename TValue, uint32_t t_nVarCount, typename TScalar, typename = TEnableIfScalar<TScalar>>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> pow(const SDual<TValue, t_nVarCount>& xA, const TScalar& xExp)
+		{
+			const TValue xR = ::pow(xA.xValue, TValue(xExp));
+			return xA.Chain(xR, TValue(xExp) * ::pow(xA.xValue, TValue(xExp) - TValue(1)));
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ SDual<TValue, t_nVarCount> pow(const SDual<TValue, t_nVarCount>& xA, const SDual<TValue, t_nVarCount>& xExp)
+		{
+			return exp(xExp * log(xA));
+		}
+#pragma endregion
+
+#pragma region Helper
+		/// <summary>	Returns the value of a dual number or a built-in scalar, for code templated on either. </summary>
+		template<typename TScalar, typename = TEnableIfScalar<TScalar>>
+		__CUDA_HDI__ TScalar ValueOf(const TScalar& xA)
+		{
+			return xA;
+		}
+
+		template<typename TValue, uint32_t t_nVarCount>
+		__CUDA_HDI__ TValue ValueOf(const SDual<TValue, t_nVarCount>& xA)
+		{
+			return xA.xValue;
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Makes the components of a vector independent variables with indices starting at uFirstVarIdx.
+		/// </summary>
+		///
+		/// <param name="vX">			[out] The dual vector. </param>
+		/// <param name="vValue">		The values of the variables. </param>
+		/// <param name="uFirstVarIdx"> The variable index of the first component. </param>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TValue, uint32_t t_nVarCount, uint32_t t_nDim>
+		__CUDA_HDI__ void SetVariables(_SVector<SDual<TValue, t_nVarCount>, t_nDim>& vX, const _SVector<TValue, t_nDim>& vValue, uint32_t uFirstVarIdx = 0)
+		{
+			for (uint32_t i = 0; i < t_nDim; ++i)
+			{
+				vX[i] = SDual<TValue, t_nVarCount>::Variable(vValue[i], uFirstVarIdx + i);
+			}
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Extracts values and Jacobian of a dual vector. pJacobian is a row major t_nDim x t_nVarCount matrix.
+		/// </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TValue, uint32_t t_nVarCount, uint32_t t_nDim>
+		__CUDA_HDI__ void GetJacobian(_SVector<TValue, t_nDim>& vValue, TValue* pJacobian, const _SVector<SDual<TValue, t_nVarCount>, t_nDim>& vX)
+		{
+			for (uint32_t i = 0; i < t_nDim; ++i)
+			{
+				vValue[i] = vX[i].xValue;
+				for (uint32_t j = 0; j < t_nVarCount; ++j)
+				{
+					pJacobian[i * t_nVarCount + j] = vX[i].pGrad[j];
+				}
+			}
+		}
+#pragma endregion
+	} // namespace AutoDiff
+} // namespace Clu
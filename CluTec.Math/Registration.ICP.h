@@ -0,0 +1,608 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Math
+// file:      Registration.ICP.h
+//
+// summary:   Declares the iterative closest point registration of 3D point clouds
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "CluTec.Base/Defines.h"
+#include "CluTec.Base/Parallel.h"
+
+#include "Static.Vector.h"
+#include "Static.Matrix.h"
+#include "Frame3D.h"
+#include "SpatialIndex.KdTree.h"
+
+namespace Clu
+{
+	namespace Registration
+	{
+		/// <summary>	The error metric minimized by the ICP. </summary>
+		enum class EIcpMetric
+		{
+			/// <summary>	Squared distance between corresponding points. </summary>
+			PointToPoint = 0,
+
+			/// <summary>	Squared distance of the source point to the tangent plane of the target point. Needs target normals. </summary>
+			PointToPlane,
+		};
+
+		template<typename TValue>
+		struct SIcpParameters
+		{
+			EIcpMetric eMetric;
+
+			/// <summary>	The maximal number of iterations. </summary>
+			uint32_t uMaxIterationCount;
+
+			/// <summary>	Correspondences further apart than this distance are rejected. </summary>
+			TValue dMaxCorrespondenceDist;
+
+			/// <summary>	The iteration stops when the rotation step in radians and the translation step fall below these values. </summary>
+			TValue dMinRotationStep;
+			TValue dMinTranslationStep;
+
+			SIcpParameters()
+			{
+				eMetric = EIcpMetric::PointToPoint;
+				uMaxIterationCount = 30;
+				dMaxCorrespondenceDist = (std::numeric_limits<TValue>::max)();
+				dMinRotationStep = TValue(1e-6);
+				dMinTranslationStep = TValue(1e-6);
+			}
+		};
+
+		template<typename TValue>
+		struct SIcpResult
+		{
+			/// <summary>	The number of iterations performed. </summary>
+			uint32_t uIterationCount;
+
+			/// <summary>	The number of correspondences used in the last iteration. </summary>
+			size_t nCorrespondenceCount;
+
+			/// <summary>	The root mean square residual of the last iteration. </summary>
+			TValue dRmsError;
+
+			/// <summary>	True if the step size fell below the thresholds before the maximal iteration count was reached. </summary>
+			bool bConverged;
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Iterative closest point registration of a source point cloud to a target point cloud.
+		///
+		/// 	Each iteration finds the closest target point for every source point with the spatial index of the target
+		/// 	cloud and linearizes the selected error metric in a small rotation and translation update. The 6x6 normal
+		/// 	equations are accumulated in parallel over blocks of source points with one accumulator per thread and are
+		/// 	solved in closed form by a Cholesky decomposition. Apart from the accumulators, which are allocated once
+		/// 	per call of Align(), no memory is allocated.
+		/// </summary>
+		///
+		/// <typeparam name="_TValue"> Type of the point coordinates. </typeparam>
+		/// <typeparam name="_TIndex"> The spatial index type of the target points, e.g. SpatialIndex::CVoxelHashGrid3D. </typeparam>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename _TValue, typename _TIndex = SpatialIndex::CKdTree3D<_TValue>>
+		class CIcp
+		{
+		public:
+			using TValue = _TValue;
+			using TIndex = _TIndex;
+			using TVec3 = _SVector<TValue, 3>;
+			using TMat3 = _SMatrix<TValue, 3>;
+			using TFrame = _CFrame3D<TValue>;
+			using TParameters = SIcpParameters<TValue>;
+			using TResult = SIcpResult<TValue>;
+
+		protected:
+			/// <summary>	Minimal number of source points per thread. </summary>
+			static const size_t MinParallelPoints = 1024;
+
+			/// <summary>	Per thread sums of the normal equations. Aligned to a cache line to avoid false sharing. </summary>
+			struct alignas(64) SAccumulator
+			{
+				TValue pJtJ[6][6];
+				TValue pJtr[6];
+				TValue dSumSqErr;
+				size_t nCount;
+
+				void Reset()
+				{
+					for (int iR = 0; iR < 6; ++iR)
+					{
+						for (int iC = 0; iC < 6; ++iC)
+						{
+							pJtJ[iR][iC] = TValue(0);
+						}
+						pJtr[iR] = TValue(0);
+					}
+
+					dSumSqErr = TValue(0);
+					nCount = 0;
+				}
+
+				void AddRow(const TValue pJ[6], TValue dR)
+				{
+					for (int iR = 0; iR < 6; ++iR)
+					{
+						for (int iC = iR; iC < 6; ++iC)
+						{
+							pJtJ[iR][iC] += pJ[iR] * pJ[iC];
+						}
+						pJtr[iR] += pJ[iR] * dR;
+					}
+
+					dSumSqErr += dR * dR;
+				}
+
+				void Add(const SAccumulator& xA)
+				{
+					for (int iR = 0; iR < 6; ++iR)
+					{
+						for (int iC = iR; iC < 6; ++iC)
+						{
+							pJtJ[iR][iC] += xA.pJtJ[iR][iC];
+						}
+						pJtr[iR] += xA.pJtr[iR];
+					}
+
+					dSumSqErr += xA.dSumSqErr;
+					nCount += xA.nCount;
+				}
+			};
+
+		protected:
+			const TIndex* m_pIndex;
+			const TVec3* m_pTarget;
+			const TVec3* m_pTargetNormal;
+
+			std::vector<SAccumulator> m_vecAccum;
+
+		public:
+			CIcp()
+			{
+				Reset();
+			}
+
+			void Reset()
+			{
+				m_pIndex = nullptr;
+				m_pTarget = nullptr;
+				m_pTargetNormal = nullptr;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Sets the target point cloud. The index and the arrays are not copied and have to stay valid while Align()
+			/// 	is used.
+			/// </summary>
+			///
+			/// <param name="xIndex">		 The spatial index created from pTarget. </param>
+			/// <param name="pTarget">		 The target points. </param>
+			/// <param name="pTargetNormal"> The unit normals of the target points. Only needed for EIcpMetric::PointToPlane. </param>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			void Create(const TIndex& xIndex, const TVec3* pTarget, const TVec3* pTargetNormal = nullptr)
+			{
+				if (pTarget == nullptr)
+				{
+					throw CLU_EXCEPTION("Invalid target point array");
+				}
+
+				m_pIndex = &xIndex;
+				m_pTarget = pTarget;
+				m_pTargetNormal = pTargetNormal;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Estimates the frame that maps the source points onto the target points. The frame maps points of the
+			/// 	source (local) frame into the target (reference) frame, i.e. x_t = R_l_r * x_s + T_l_r.
+			/// </summary>
+			///
+			/// <param name="pSource">		The source points. </param>
+			/// <param name="nSourceCount"> Number of source points. </param>
+			/// <param name="xFrame">		[in,out] On input the initial estimate, on output the result. </param>
+			/// <param name="xParams">		The parameters. </param>
+			///
+			/// <returns> The statistics of the registration. </returns>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			TResult Align(const TVec3* pSource, size_t nSourceCount, TFrame& xFrame, const TParameters& xParams = TParameters())
+			{
+				if (m_pIndex == nullptr)
+				{
+					throw CLU_EXCEPTION("ICP target not set");
+				}
+
+				if (xParams.eMetric == EIcpMetric::PointToPlane && m_pTargetNormal == nullptr)
+				{
+					throw CLU_EXCEPTION("Point to plane metric needs target normals");
+				}
+
+				TResult xResult;
+				xResult.uIterationCount = 0;
+				xResult.nCorrespondenceCount = 0;
+				xResult.dRmsError = TValue(0);
+				xResult.bConverged = false;
+
+				const unsigned uBlockCount = Clu::Parallel::BlockCount(nSourceCount, MinParallelPoints);
+				m_vecAccum.resize((std::max)(uBlockCount, 1u));
+
+				const TValue dMaxDistSq = (xParams.dMaxCorrespondenceDist < sqrt((std::numeric_limits<TValue>::max)())
+					? xParams.dMaxCorrespondenceDist * xParams.dMaxCorrespondenceDist
+					: (std::numeric_limits<TValue>::max)());
+
+				for (uint32_t uIter = 0; uIter < xParams.uMaxIterationCount; ++uIter)
+				{
+					const TMat3 mR = xFrame.m_mR_l_r;
+					const TVec3 vT = xFrame.m_vT_l_r;
+
+					for (SAccumulator& xAccum : m_vecAccum)
+					{
+						xAccum.Reset();
+					}
+
+					Clu::Parallel::ForEachBlock(nSourceCount, MinParallelPoints, [&](size_t nBegin, size_t nEnd, unsigned uBlockIdx)
+					{
+						_Accumulate(m_vecAccum[uBlockIdx], pSource, nBegin, nEnd, mR, vT, dMaxDistSq, xParams.eMetric);
+					});
+
+					SAccumulator& xSum = m_vecAccum[0];
+					for (size_t nBlockIdx = 1; nBlockIdx < m_vecAccum.size(); ++nBlockIdx)
+					{
+						xSum.Add(m_vecAccum[nBlockIdx]);
+					}
+
+					xResult.uIterationCount = uIter + 1;
+					xResult.nCorrespondenceCount = xSum.nCount;
+					xResult.dRmsError = (xSum.nCount > 0 ? sqrt(xSum.dSumSqErr / TValue(xSum.nCount)) : TValue(0));
+
+					// Need at least enough residuals to constrain all six parameters.
+					const size_t nRowsPerMatch = (xParams.eMetric == EIcpMetric::PointToPoint ? 3 : 1);
+					if (xSum.nCount * nRowsPerMatch < 6)
+					{
+						break;
+					}
+
+					TValue pX[6];
+					if (!SolveNormalEquations(xSum.pJtJ, xSum.pJtr, pX))
+					{
+						break;
+					}
+
+					TVec3 vOmega, vTau;
+					vOmega.SetElements(pX[0], pX[1], pX[2]);
+					vTau.SetElements(pX[3], pX[4], pX[5]);
+
+					// Apply the update x' = dR * x + tau to the current frame.
+					const TMat3 mDR = RotationFromAxisAngle(vOmega);
+					xFrame.SetBasis_l_r(mDR * mR);
+					xFrame.SetTranslation_r_l(mDR * vT + vTau);
+
+					if (Length(vOmega) < xParams.dMinRotationStep && Length(vTau) < xParams.dMinTranslationStep)
+					{
+						xResult.bConverged = true;
+						break;
+					}
+				}
+
+				return xResult;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Returns the rotation matrix for a rotation about the axis vOmega by the angle |vOmega|. </summary>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			static TMat3 RotationFromAxisAngle(const TVec3& vOmega)
+			{
+				const TValue dAngle = Length(vOmega);
+
+				TValue dSin, dOneMinusCos;
+				if (dAngle < TValue(1e-8))
+				{
+					dSin = TValue(1);
+					dOneMinusCos = TValue(0.5) * dAngle;
+				}
+				else
+				{
+					dSin = sin(dAngle) / dAngle;
+					dOneMinusCos = (TValue(1) - cos(dAngle)) / (dAngle * dAngle);
+				}
+
+				const TValue dX = vOmega[0], dY = vOmega[1], dZ = vOmega[2];
+
+				// R = I + sin(a)/a [w]x + (1 - cos(a))/a^2 [w]x^2
+				TMat3 mR;
+				mR(0, 0) = TValue(1) - dOneMinusCos * (dY * dY + dZ * dZ);
+				mR(0, 1) = -dSin * dZ + dOneMinusCos * dX * dY;
+				mR(0, 2) = dSin * dY + dOneMinusCos * dX * dZ;
+				mR(1, 0) = dSin * dZ + dOneMinusCos * dX * dY;
+				mR(1, 1) = TValue(1) - dOneMinusCos * (dX * dX + dZ * dZ);
+				mR(1, 2) = -dSin * dX + dOneMinusCos * dY * dZ;
+				mR(2, 0) = -dSin * dY + dOneMinusCos * dX * dZ;
+				mR(2, 1) = dSin * dX + dOneMinusCos * dY * dZ;
+				mR(2, 2) = TValue(1) - dOneMinusCos * (dX * dX + dY * dY);
+
+				return mR;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Solves JtJ * x = -Jtr with a Cholesky decomposition. Only the upper triangle of pJtJ is used.
+			/// </summary>
+			///
+			/// <returns> False if the system is singular. </returns>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			static bool SolveNormalEquations(const TValue pJtJ[6][6], const TValue pJtr[6], TValue pX[6])
+			{
+				TValue pL[6][6];
+
+				TValue dTrace = TValue(0);
+				for (int i = 0; i < 6; ++i)
+				{
+					dTrace += pJtJ[i][i];
+				}
+
+				const TValue dMinPivot = dTrace * std::numeric_limits<TValue>::epsilon();
+
+				for (int iC = 0; iC < 6; ++iC)
+				{
+					TValue dDiag = pJtJ[iC][iC];
+					for (int k = 0; k < iC; ++k)
+					{
+						dDiag -= pL[iC][k] * pL[iC][k];
+					}
+
+					if (!(dDiag > dMinPivot))
+					{
+						return false;
+					}
+
+					pL[iC][iC] = sqrt(dDiag);
+					const TValue dInvDiag = TValue(1) / pL[iC][iC];
+
+					for (int iR = iC + 1; iR < 6; ++iR)
+					{
+						TValue dVal = pJtJ[iC][iR];
+						for (int k = 0; k < iC; ++k)
+						{
+							dVal -= pL[iR][k] * pL[iC][k];
+						}
+
+						pL[iR][iC] = dVal * dInvDiag;
+					}
+				}
+
+				// Forward substitution L y = -Jtr
+				TValue pY[6];
+				for (int iR = 0; iR < 6; ++iR)
+				{
+					TValue dVal = -pJtr[iR];
+					for (int k = 0; k < iR; ++k)
+					{
+						dVal -= pL[iR][k] * pY[k];
+					}
+					pY[iR] = dVal / pL[iR][iR];
+				}
+
+				// Back substitution L^T x = y
+				for (int iR = 5; iR >= 0; --iR)
+				{
+					TValue dVal = pY[iR];
+					for (int k = iR + 1; k < 6; ++k)
+					{
+						dVal -= pL[k][iR] * pX[k];
+					}
+					pX[iR] = dVal / pL[iR][iR];
+				}
+
+				return true;
+			}
+
+		protected:
+			void _Accumulate(SAccumulator& xAccum, const TVec3* pSource, size_t nBegin, size_t nEnd
+				, const TMat3& mR, const TVec3& vT, TValue dMaxDistSq, EIcpMetric eMetric) const
+			{
+				TValue pJ[6];
+
+				for (size_t nIdx = nBegin; nIdx < nEnd; ++nIdx)
+				{
+					const TVec3 vY = mR * pSource[nIdx] + vT;
+
+					TValue dDistSq;
+					const SpatialIndex::TIdx nMatch = m_pIndex->FindNearest(vY, dDistSq);
+					if (nMatch == SpatialIndex::InvalidIdx || dDistSq > dMaxDistSq)
+					{
+						continue;
+					}
+
+					const TVec3 vD = vY - m_pTarget[nMatch];
+					++xAccum.nCount;
+
+					if (eMetric == EIcpMetric::PointToPlane)
+					{
+						// r = n.(y - q), dr/dw = y x n, dr/dt = n
+						const TVec3& vN = m_pTargetNormal[nMatch];
+						pJ[0] = vY[1] * vN[2] - vY[2] * vN[1];
+						pJ[1] = vY[2] * vN[0] - vY[0] * vN[2];
+						pJ[2] = vY[0] * vN[1] - vY[1] * vN[0];
+						pJ[3] = vN[0];
+						pJ[4] = vN[1];
+						pJ[5] = vN[2];
+
+						xAccum.AddRow(pJ, vD[0] * vN[0] + vD[1] * vN[1] + vD[2] * vN[2]);
+					}
+					else
+					{
+						// r_k = (y - q)_k, dr_k/dw = y x e_k, dr_k/dt = e_k
+						pJ[0] = 0;		pJ[1] = vY[2];	pJ[2] = -vY[1];
+						pJ[3] = 1;		pJ[4] = 0;		pJ[5] = 0;
+						xAccum.AddRow(pJ, vD[0]);
+
+						pJ[0] = -vY[2];	pJ[1] = 0;		pJ[2] = vY[0];
+						pJ[3] = 0;		pJ[4] = 1;		pJ[5] = 0;
+						xAccum.AddRow(pJ, vD[1]);
+
+						pJ[0] = vY[1];	pJ[1] = -vY[0];	pJ[2] = 0;
+						pJ[3] = 0;		pJ[4] = 0;		pJ[5] = 1;
+						xAccum.AddRow(pJ, vD[2]);
+					}
+				}
+			}
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Estimates the unit normals of a point cloud as the direction of least variance of the nK nearest
+		/// 	neighbors of each point. The orientation of the normals is arbitrary. Runs in parallel.
+		/// </summary>
+		///
+		/// <param name="xIndex">   The spatial index created from pPoints. </param>
+		/// <param name="pPoints">  The points. </param>
+		/// <param name="nCount">   Number of points. </param>
+		/// <param name="nK">	    The number of neighbors to use, at most 64. </param>
+		/// <param name="pNormals"> [out] The normals. Points with less than three neighbors get a zero normal. </param>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TIndex, typename TValue>
+		void EstimateNormals(const TIndex& xIndex, const _SVector<TValue, 3>* pPoints, size_t nCount, uint32_t nK
+			, _SVector<TValue, 3>* pNormals)
+		{
+			using TVec3 = _SVector<TValue, 3>;
+			static const uint32_t MaxK = 64;
+
+			if (nK > MaxK)
+			{
+				throw CLU_EXCEPTION("Too many neighbors for normal estimation");
+			}
+
+			Clu::Parallel::ForEachIndex(nCount, 1024, [&](size_t nIdx)
+			{
+				SpatialIndex::TIdx pIdx[MaxK];
+				TValue pDistSq[MaxK];
+
+				TVec3& vNormal = pNormals[nIdx];
+				vNormal.SetZero();
+
+				const uint32_t nFound = xIndex.FindKNearest(pPoints[nIdx], nK, pIdx, pDistSq);
+				if (nFound < 3)
+				{
+					return;
+				}
+
+				TVec3 vMean;
+				vMean.SetZero();
+				for (uint32_t i = 0; i < nFound; ++i)
+				{
+					vMean = vMean + pPoints[pIdx[i]];
+				}
+				vMean = vMean * (TValue(1) / TValue(nFound));
+
+				// Covariance matrix
+				TValue pC[3][3] = {};
+				for (uint32_t i = 0; i < nFound; ++i)
+				{
+					const TVec3 vD = pPoints[pIdx[i]] - vMean;
+					for (int iR = 0; iR < 3; ++iR)
+					{
+						for (int iC = iR; iC < 3; ++iC)
+						{
+							pC[iR][iC] += vD[iR] * vD[iC];
+						}
+					}
+				}
+
+				pC[1][0] = pC[0][1];
+				pC[2][0] = pC[0][2];
+				pC[2][1] = pC[1][2];
+
+				// Cyclic Jacobi rotations diagonalize the symmetric 3x3 matrix; the columns of pV converge to the eigenvectors.
+				TValue pV[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+				for (int iSweep = 0; iSweep < 16; ++iSweep)
+				{
+					const TValue dOff = abs(pC[0][1]) + abs(pC[0][2]) + abs(pC[1][2]);
+					if (dOff <= std::numeric_limits<TValue>::epsilon() * (abs(pC[0][0]) + abs(pC[1][1]) + abs(pC[2][2])))
+					{
+						break;
+					}
+
+					for (int iP = 0; iP < 2; ++iP)
+					{
+						for (int iQ = iP + 1; iQ < 3; ++iQ)
+						{
+							if (pC[iP][iQ] == TValue(0))
+							{
+								continue;
+							}
+
+							const TValue dTheta = (pC[iQ][iQ] - pC[iP][iP]) / (TValue(2) * pC[iP][iQ]);
+							const TValue dT = (dTheta >= TValue(0) ? TValue(1) : TValue(-1)) / (abs(dTheta) + sqrt(dTheta * dTheta + TValue(1)));
+							const TValue dCos = TValue(1) / sqrt(dT * dT + TValue(1));
+							const TValue dSin = dT * dCos;
+
+							for (int k = 0; k < 3; ++k)
+							{
+								const TValue dKP = pC[k][iP];
+								const TValue dKQ = pC[k][iQ];
+								pC[k][iP] = dCos * dKP - dSin * dKQ;
+								pC[k][iQ] = dSin * dKP + dCos * dKQ;
+							}
+
+							for (int k = 0; k < 3; ++k)
+							{
+								const TValue dPK = pC[iP][k];
+								const TValue dQK = pC[iQ][k];
+								pC[iP][k] = dCos * dPK - dSin * dQK;
+								pC[iQ][k] = dSin * dPK + dCos * dQK;
+							}
+
+							for (int k = 0; k < 3; ++k)
+							{
+								const TValue dKP = pV[k][iP];
+								const TValue dKQ = pV[k][iQ];
+								pV[k][iP] = dCos * dKP - dSin * dKQ;
+								pV[k][iQ] = dSin * dKP + dCos * dKQ;
+							}
+						}
+					}
+				}
+
+				int iMin = 0;
+				for (int i = 1; i < 3; ++i)
+				{
+					if (pC[i][i] < pC[iMin][iMin])
+					{
+						iMin = i;
+					}
+				}
+
+				vNormal.SetElements(pV[0][iMin], pV[1][iMin], pV[2][iMin]);
+			});
+		}
+	} // namespace Registration
+} // namespace Clu
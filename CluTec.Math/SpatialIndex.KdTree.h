@@ -0,0 +1,438 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Math
+// file:      SpatialIndex.KdTree.h
+//
+// summary:   Declares the k-d tree spatial index for 3D point clouds
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "CluTec.Base/Defines.h"
+#include "CluTec.Base/Parallel.h"
+
+#include "Static.Vector.h"
+#include "SpatialIndex.Points.h"
+
+namespace Clu
+{
+	namespace SpatialIndex
+	{
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	A balanced k-d tree over a 3D point cloud.
+		///
+		/// 	The tree is stored in flat arrays: the nodes form an implicit complete binary tree (children of node i are
+		/// 	2i+1 and 2i+2) and the points are reordered, so that every node covers a contiguous range of the point
+		/// 	store. All leaves lie on the last level. The tree levels are built in parallel and the batched queries
+		/// 	distribute the query points over all hardware threads. Query results refer to the indices of the points
+		/// 	passed to Create().
+		/// </summary>
+		///
+		/// <typeparam name="_TValue"> Type of the point coordinates. </typeparam>
+		/// <typeparam name="_TStore"> The point store layout. Use CPointStoreSoAFloat for the float32 SoA layout. </typeparam>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename _TValue, typename _TStore = CPointStoreAoS<_TValue>>
+		class CKdTree3D
+		{
+		public:
+			using TValue = _TValue;
+			using TVec3 = _SVector<TValue, 3>;
+			using TStore = _TStore;
+
+			struct SNode
+			{
+				TValue dSplit;
+				uint32_t uDim;
+				TIdx nBegin;
+				TIdx nEnd;
+			};
+
+		protected:
+			struct SBuildPoint
+			{
+				TVec3 vX;
+				TIdx nIdx;
+			};
+
+			/// <summary>	Maximal tree depth. Limits the size of the traversal stack. </summary>
+			static const uint32_t MaxDepth = 32;
+
+			/// <summary>	Minimal number of nodes or points per thread when building or querying in parallel. </summary>
+			static const size_t MinParallelNodes = 1;
+			static const size_t MinParallelPoints = 4096;
+
+		protected:
+			std::vector<SNode> m_vecNode;
+			std::vector<TIdx> m_vecOrigIdx;
+			TStore m_xStore;
+			uint32_t m_nInnerNodeCount;
+			uint32_t m_nDepth;
+
+		public:
+			CKdTree3D()
+			{
+				Destroy();
+			}
+
+			void Destroy()
+			{
+				m_vecNode.clear();
+				m_vecOrigIdx.clear();
+				m_xStore.Clear();
+				m_nInnerNodeCount = 0;
+				m_nDepth = 0;
+			}
+
+			bool IsValid() const
+			{
+				return !m_vecNode.empty();
+			}
+
+			size_t PointCount() const
+			{
+				return m_vecOrigIdx.size();
+			}
+
+			uint32_t Depth() const
+			{
+				return m_nDepth;
+			}
+
+			const TStore& Store() const
+			{
+				return m_xStore;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Creates the tree from the given points. The points are copied into the tree.
+			/// </summary>
+			///
+			/// <param name="pPoints">   The points. </param>
+			/// <param name="nCount">    Number of points. </param>
+			/// <param name="nLeafSize"> The maximal number of points per leaf. </param>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			void Create(const TVec3* pPoints, size_t nCount, uint32_t nLeafSize = 16)
+			{
+				Destroy();
+
+				if (nCount == 0)
+				{
+					return;
+				}
+
+				if (pPoints == nullptr)
+				{
+					throw CLU_EXCEPTION("Invalid point array");
+				}
+
+				if (nCount >= size_t(InvalidIdx))
+				{
+					throw CLU_EXCEPTION("Too many points for k-d tree");
+				}
+
+				nLeafSize = (std::max)(nLeafSize, 1u);
+
+				// Choose the depth such that all leaves hold at most nLeafSize points.
+				m_nDepth = 0;
+				while ((nCount >> m_nDepth) > nLeafSize && m_nDepth < MaxDepth - 1)
+				{
+					++m_nDepth;
+				}
+
+				// Leaves on the last level may still hold one point more than nCount >> m_nDepth.
+				if (((nCount + (size_t(1) << m_nDepth) - 1) >> m_nDepth) > nLeafSize && m_nDepth < MaxDepth - 1)
+				{
+					++m_nDepth;
+				}
+
+				m_nInnerNodeCount = (1u << m_nDepth) - 1;
+				m_vecNode.resize(size_t(2) * m_nInnerNodeCount + 1);
+
+				std::vector<SBuildPoint> vecBuild(nCount);
+				Clu::Parallel::ForEachIndex(nCount, MinParallelPoints, [&](size_t nIdx)
+				{
+					vecBuild[nIdx].vX = pPoints[nIdx];
+					vecBuild[nIdx].nIdx = TIdx(nIdx);
+				});
+
+				m_vecNode[0].nBegin = 0;
+				m_vecNode[0].nEnd = TIdx(nCount);
+
+				for (uint32_t uLevel = 0; uLevel < m_nDepth; ++uLevel)
+				{
+					const size_t nFirst = (size_t(1) << uLevel) - 1;
+					const size_t nLevelCount = size_t(1) << uLevel;
+
+					Clu::Parallel::ForEachIndex(nLevelCount, MinParallelNodes, [&](size_t nLevelIdx)
+					{
+						_SplitNode(nFirst + nLevelIdx, vecBuild.data());
+					});
+				}
+
+				m_xStore.Resize(nCount);
+				m_vecOrigIdx.resize(nCount);
+				Clu::Parallel::ForEachIndex(nCount, MinParallelPoints, [&](size_t nIdx)
+				{
+					m_xStore.Set(nIdx, vecBuild[nIdx].vX);
+					m_vecOrigIdx[nIdx] = vecBuild[nIdx].nIdx;
+				});
+			}
+
+			void Create(const std::vector<TVec3>& vecPoints, uint32_t nLeafSize = 16)
+			{
+				Create(vecPoints.data(), vecPoints.size(), nLeafSize);
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Finds the k nearest points of the given query point. Does not allocate memory.
+			/// </summary>
+			///
+			/// <param name="vQuery">  The query point. </param>
+			/// <param name="nK">	   The number of neighbors to find. </param>
+			/// <param name="pIdx">    [out] Array of nK point indices, sorted by ascending distance. Unused entries are set
+			/// 					   to InvalidIdx. </param>
+			/// <param name="pDistSq"> [out] Array of nK squared distances. </param>
+			///
+			/// <returns> The number of neighbors found. </returns>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			uint32_t FindKNearest(const TVec3& vQuery, uint32_t nK, TIdx* pIdx, TValue* pDistSq) const
+			{
+				CNearestSet<TValue> xSet(pIdx, pDistSq, nK);
+				if (IsValid() && nK > 0)
+				{
+					_Search(vQuery, [&xSet]() { return xSet.WorstDistSq(); },
+						[&xSet](TIdx nIdx, TValue dDistSq) { xSet.Insert(nIdx, dDistSq); });
+				}
+
+				return xSet.Finalize();
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Finds the nearest point of the given query point. </summary>
+			///
+			/// <param name="vQuery">  The query point. </param>
+			/// <param name="dDistSq"> [out] The squared distance to the nearest point. </param>
+			///
+			/// <returns> The index of the nearest point or InvalidIdx if the tree is empty. </returns>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			TIdx FindNearest(const TVec3& vQuery, TValue& dDistSq) const
+			{
+				TIdx nIdx;
+				FindKNearest(vQuery, 1, &nIdx, &dDistSq);
+				return nIdx;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Calls funcOp(nIdx, dDistSq) for each point within the given radius of the query point. Points are
+			/// 	visited in tree order.
+			/// </summary>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename FuncOp>
+			void ForEachInRadius(const TVec3& vQuery, TValue dRadius, FuncOp funcOp) const
+			{
+				if (!IsValid())
+				{
+					return;
+				}
+
+				const TValue dRadiusSq = dRadius * dRadius;
+				_Search(vQuery, [dRadiusSq]() { return dRadiusSq; }, funcOp);
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Finds the k nearest points for each of the given query points in parallel.
+			/// </summary>
+			///
+			/// <param name="pQuery">	   The query points. </param>
+			/// <param name="nQueryCount"> Number of query points. </param>
+			/// <param name="nK">		   The number of neighbors per query point. </param>
+			/// <param name="pIdx">		   [out] Array of nQueryCount * nK point indices, stored row by row. </param>
+			/// <param name="pDistSq">	   [out] Array of nQueryCount * nK squared distances. </param>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			void FindKNearest(const TVec3* pQuery, size_t nQueryCount, uint32_t nK, TIdx* pIdx, TValue* pDistSq) const
+			{
+				Clu::Parallel::ForEachIndex(nQueryCount, MinParallelQueryCount, [&](size_t nQueryIdx)
+				{
+					FindKNearest(pQuery[nQueryIdx], nK, pIdx + nQueryIdx * nK, pDistSq + nQueryIdx * nK);
+				});
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Finds all points within the given radius for each of the given query points in parallel. The result is
+			/// 	returned in compressed row form: the neighbors of query i are vecIdx[vecOffset[i]] to
+			/// 	vecIdx[vecOffset[i+1] - 1].
+			/// </summary>
+			///
+			/// <param name="pQuery">	   The query points. </param>
+			/// <param name="nQueryCount"> Number of query points. </param>
+			/// <param name="dRadius">	   The search radius. </param>
+			/// <param name="vecOffset">   [out] The offsets of the neighbor lists. Has nQueryCount + 1 elements. </param>
+			/// <param name="vecIdx">	   [out] The point indices. </param>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			void FindInRadius(const TVec3* pQuery, size_t nQueryCount, TValue dRadius
+				, std::vector<size_t>& vecOffset, std::vector<TIdx>& vecIdx) const
+			{
+				BatchFindInRadius(*this, pQuery, nQueryCount, dRadius, vecOffset, vecIdx);
+			}
+
+		protected:
+			void _SplitNode(size_t nNodeIdx, SBuildPoint* pBuild)
+			{
+				SNode& xNode = m_vecNode[nNodeIdx];
+				const TIdx nBegin = xNode.nBegin;
+				const TIdx nEnd = xNode.nEnd;
+				const TIdx nMid = nBegin + (nEnd - nBegin) / 2;
+
+				// Split along the dimension of largest extent.
+				uint32_t uDim = 0;
+				if (nEnd > nBegin)
+				{
+					TVec3 vMin = pBuild[nBegin].vX;
+					TVec3 vMax = vMin;
+					for (TIdx nIdx = nBegin + 1; nIdx < nEnd; ++nIdx)
+					{
+						const TVec3& vX = pBuild[nIdx].vX;
+						for (uint32_t uD = 0; uD < 3; ++uD)
+						{
+							vMin[uD] = (std::min)(vMin[uD], vX[uD]);
+							vMax[uD] = (std::max)(vMax[uD], vX[uD]);
+						}
+					}
+
+					TValue dMaxExt = vMax[0] - vMin[0];
+					for (uint32_t uD = 1; uD < 3; ++uD)
+					{
+						if (vMax[uD] - vMin[uD] > dMaxExt)
+						{
+							dMaxExt = vMax[uD] - vMin[uD];
+							uDim = uD;
+						}
+					}
+				}
+
+				xNode.uDim = uDim;
+				if (nMid < nEnd)
+				{
+					std::nth_element(pBuild + nBegin, pBuild + nMid, pBuild + nEnd,
+						[uDim](const SBuildPoint& xA, const SBuildPoint& xB)
+					{
+						return xA.vX[uDim] < xB.vX[uDim];
+					});
+
+					xNode.dSplit = pBuild[nMid].vX[uDim];
+				}
+				else
+				{
+					xNode.dSplit = TValue(0);
+				}
+
+				SNode& xLeft = m_vecNode[2 * nNodeIdx + 1];
+				SNode& xRight = m_vecNode[2 * nNodeIdx + 2];
+
+				xLeft.nBegin = nBegin;
+				xLeft.nEnd = nMid;
+				xRight.nBegin = nMid;
+				xRight.nEnd = nEnd;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Depth first traversal with an explicit stack. funcBound() returns the current squared search radius and
+			/// 	funcOp(nIdx, dDistSq) is called for all points within that radius.
+			/// </summary>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename FuncBound, typename FuncOp>
+			void _Search(const TVec3& vQuery, FuncBound funcBound, FuncOp funcOp) const
+			{
+				struct SEntry
+				{
+					uint32_t nNodeIdx;
+					TValue dMinDistSq;
+				};
+
+				SEntry pStack[MaxDepth + 1];
+				uint32_t nStackSize = 0;
+
+				pStack[nStackSize++] = { 0, TValue(0) };
+
+				while (nStackSize > 0)
+				{
+					const SEntry xEntry = pStack[--nStackSize];
+					if (xEntry.dMinDistSq > funcBound())
+					{
+						continue;
+					}
+
+					uint32_t nNodeIdx = xEntry.nNodeIdx;
+					while (nNodeIdx < m_nInnerNodeCount)
+					{
+						const SNode& xNode = m_vecNode[nNodeIdx];
+						const TValue dDiff = vQuery[xNode.uDim] - xNode.dSplit;
+						const uint32_t nLeft = 2 * nNodeIdx + 1;
+
+						uint32_t nNear, nFar;
+						if (dDiff < TValue(0))
+						{
+							nNear = nLeft;
+							nFar = nLeft + 1;
+						}
+						else
+						{
+							nNear = nLeft + 1;
+							nFar = nLeft;
+						}
+
+						const TValue dPlaneDistSq = (std::max)(dDiff * dDiff, xEntry.dMinDistSq);
+						if (dPlaneDistSq <= funcBound())
+						{
+							pStack[nStackSize++] = { nFar, dPlaneDistSq };
+						}
+
+						nNodeIdx = nNear;
+					}
+
+					const SNode& xLeaf = m_vecNode[nNodeIdx];
+					TValue dBound = funcBound();
+					m_xStore.ForEachInRange(xLeaf.nBegin, xLeaf.nEnd, vQuery, dBound,
+						[&](size_t nIdx, TValue dDistSq)
+					{
+						funcOp(m_vecOrigIdx[nIdx], dDistSq);
+						dBound = funcBound();
+					});
+				}
+			}
+
+		};
+	} // namespace SpatialIndex
+} // namespace Clu
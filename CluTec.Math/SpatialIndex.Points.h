@@ -0,0 +1,444 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Math
+// file:      SpatialIndex.Points.h
+//
+// summary:   Declares the point storage layouts and the nearest neighbor set used by the spatial indices
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "CluTec.Base/Defines.h"
+#include "CluTec.Base/Parallel.h"
+#include "Static.Vector.h"
+
+namespace Clu
+{
+	namespace SpatialIndex
+	{
+		using TIdx = uint32_t;
+
+		/// <summary>	Index value marking an empty result entry. </summary>
+		static const TIdx InvalidIdx = TIdx(~0u);
+
+		/// <summary>	Minimal number of query points per thread for the batched queries. </summary>
+		static const size_t MinParallelQueryCount = 256;
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Keeps the k nearest candidates found so far as a max-heap in memory provided by the caller, so that
+		/// 	queries do not allocate memory.
+		/// </summary>
+		///
+		/// <typeparam name="_TValue"> Type of the distance values. </typeparam>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename _TValue>
+		class CNearestSet
+		{
+		public:
+			using TValue = _TValue;
+
+		protected:
+			TIdx* m_pIdx;
+			TValue* m_pDistSq;
+			uint32_t m_nMaxCount;
+			uint32_t m_nCount;
+
+		public:
+			CNearestSet(TIdx* pIdx, TValue* pDistSq, uint32_t nMaxCount)
+				: m_pIdx(pIdx), m_pDistSq(pDistSq), m_nMaxCount(nMaxCount), m_nCount(0)
+			{}
+
+			uint32_t Count() const
+			{
+				return m_nCount;
+			}
+
+			bool IsFull() const
+			{
+				return m_nCount == m_nMaxCount;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>	Returns the squared distance a new candidate has to be below to be inserted. </summary>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			TValue WorstDistSq() const
+			{
+				return (IsFull() ? m_pDistSq[0] : (std::numeric_limits<TValue>::max)());
+			}
+
+			void Insert(TIdx nIdx, TValue dDistSq)
+			{
+				if (m_nMaxCount == 0)
+				{
+					return;
+				}
+
+				if (!IsFull())
+				{
+					// Sift up
+					uint32_t nPos = m_nCount++;
+					while (nPos > 0)
+					{
+						uint32_t nParent = (nPos - 1) >> 1;
+						if (m_pDistSq[nParent] >= dDistSq)
+						{
+							break;
+						}
+
+						m_pIdx[nPos] = m_pIdx[nParent];
+						m_pDistSq[nPos] = m_pDistSq[nParent];
+						nPos = nParent;
+					}
+
+					m_pIdx[nPos] = nIdx;
+					m_pDistSq[nPos] = dDistSq;
+					return;
+				}
+
+				if (dDistSq >= m_pDistSq[0])
+				{
+					return;
+				}
+
+				// Replace root and sift down
+				uint32_t nPos = 0;
+				while (true)
+				{
+					uint32_t nChild = 2 * nPos + 1;
+					if (nChild >= m_nCount)
+					{
+						break;
+					}
+
+					if (nChild + 1 < m_nCount && m_pDistSq[nChild + 1] > m_pDistSq[nChild])
+					{
+						++nChild;
+					}
+
+					if (m_pDistSq[nChild] <= dDistSq)
+					{
+						break;
+					}
+
+					m_pIdx[nPos] = m_pIdx[nChild];
+					m_pDistSq[nPos] = m_pDistSq[nChild];
+					nPos = nChild;
+				}
+
+				m_pIdx[nPos] = nIdx;
+				m_pDistSq[nPos] = dDistSq;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Sorts the result by ascending distance and fills unused entries with InvalidIdx and the maximal
+			/// 	distance value.
+			/// </summary>
+			///
+			/// <returns> The number of valid entries. </returns>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			uint32_t Finalize()
+			{
+				// Heap sort in place: repeatedly move the largest element to the end.
+				for (uint32_t nEnd = m_nCount; nEnd > 1; --nEnd)
+				{
+					TIdx nIdx = m_pIdx[nEnd - 1];
+					TValue dDistSq = m_pDistSq[nEnd - 1];
+					m_pIdx[nEnd - 1] = m_pIdx[0];
+					m_pDistSq[nEnd - 1] = m_pDistSq[0];
+
+					uint32_t nCount = nEnd - 1;
+					uint32_t nPos = 0;
+					while (true)
+					{
+						uint32_t nChild = 2 * nPos + 1;
+						if (nChild >= nCount)
+						{
+							break;
+						}
+
+						if (nChild + 1 < nCount && m_pDistSq[nChild + 1] > m_pDistSq[nChild])
+						{
+							++nChild;
+						}
+
+						if (m_pDistSq[nChild] <= dDistSq)
+						{
+							break;
+						}
+
+						m_pIdx[nPos] = m_pIdx[nChild];
+						m_pDistSq[nPos] = m_pDistSq[nChild];
+						nPos = nChild;
+					}
+
+					m_pIdx[nPos] = nIdx;
+					m_pDistSq[nPos] = dDistSq;
+				}
+
+				for (uint32_t nPos = m_nCount; nPos < m_nMaxCount; ++nPos)
+				{
+					m_pIdx[nPos] = InvalidIdx;
+					m_pDistSq[nPos] = (std::numeric_limits<TValue>::max)();
+				}
+
+				return m_nCount;
+			}
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Stores the points of a spatial index as array of _SVector<TValue, 3> (array of structures).
+		/// </summary>
+		///
+		/// <typeparam name="_TValue"> Type of the coordinates. </typeparam>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename _TValue>
+		class CPointStoreAoS
+		{
+		public:
+			using TValue = _TValue;
+			using TVec3 = _SVector<TValue, 3>;
+
+		protected:
+			std::vector<TVec3> m_vecPoint;
+
+		public:
+			void Resize(size_t nCount)
+			{
+				m_vecPoint.resize(nCount);
+			}
+
+			void Clear()
+			{
+				m_vecPoint.clear();
+				m_vecPoint.shrink_to_fit();
+			}
+
+			size_t Count() const
+			{
+				return m_vecPoint.size();
+			}
+
+			void Set(size_t nIdx, const TVec3& vX)
+			{
+				m_vecPoint[nIdx] = vX;
+			}
+
+			TVec3 Get(size_t nIdx) const
+			{
+				return m_vecPoint[nIdx];
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Calls funcOp(nIdx, dDistSq) for all points in [nBegin, nEnd) whose squared distance to vQuery is not
+			/// 	larger than dMaxDistSq. The operator may lower dMaxDistSq while the range is processed.
+			/// </summary>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename FuncOp>
+			void ForEachInRange(size_t nBegin, size_t nEnd, const TVec3& vQuery, const TValue& dMaxDistSq, FuncOp funcOp) const
+			{
+				const TVec3* pPoint = m_vecPoint.data();
+				for (size_t nIdx = nBegin; nIdx < nEnd; ++nIdx)
+				{
+					const TVec3& vX = pPoint[nIdx];
+					TValue dX = vX[0] - vQuery[0];
+					TValue dY = vX[1] - vQuery[1];
+					TValue dZ = vX[2] - vQuery[2];
+					TValue dDistSq = dX * dX + dY * dY + dZ * dZ;
+
+					if (dDistSq <= dMaxDistSq)
+					{
+						funcOp(nIdx, dDistSq);
+					}
+				}
+			}
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Stores the points of a spatial index as three separate float arrays (structure of arrays). This halves the
+		/// 	memory footprint for double precision point clouds and lets leaf scans test four points per SSE instruction.
+		/// 	Distances are evaluated in single precision.
+		/// </summary>
+		///
+		/// <typeparam name="_TValue"> Type of the coordinates of the query points. </typeparam>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename _TValue>
+		class CPointStoreSoAFloat
+		{
+		public:
+			using TValue = _TValue;
+			using TVec3 = _SVector<TValue, 3>;
+
+		protected:
+			std::vector<float> m_vecX, m_vecY, m_vecZ;
+
+		public:
+			void Resize(size_t nCount)
+			{
+				m_vecX.resize(nCount);
+				m_vecY.resize(nCount);
+				m_vecZ.resize(nCount);
+			}
+
+			void Clear()
+			{
+				m_vecX.clear();
+				m_vecX.shrink_to_fit();
+				m_vecY.clear();
+				m_vecY.shrink_to_fit();
+				m_vecZ.clear();
+				m_vecZ.shrink_to_fit();
+			}
+
+			size_t Count() const
+			{
+				return m_vecX.size();
+			}
+
+			void Set(size_t nIdx, const TVec3& vX)
+			{
+				m_vecX[nIdx] = float(vX[0]);
+				m_vecY[nIdx] = float(vX[1]);
+				m_vecZ[nIdx] = float(vX[2]);
+			}
+
+			TVec3 Get(size_t nIdx) const
+			{
+				TVec3 vX;
+				vX.SetElements(TValue(m_vecX[nIdx]), TValue(m_vecY[nIdx]), TValue(m_vecZ[nIdx]));
+				return vX;
+			}
+
+			/// <summary>	See CPointStoreAoS::ForEachInRange(). </summary>
+			template<typename FuncOp>
+			void ForEachInRange(size_t nBegin, size_t nEnd, const TVec3& vQuery, const TValue& dMaxDistSq, FuncOp funcOp) const
+			{
+				const float* pX = m_vecX.data();
+				const float* pY = m_vecY.data();
+				const float* pZ = m_vecZ.data();
+
+				const float fQX = float(vQuery[0]);
+				const float fQY = float(vQuery[1]);
+				const float fQZ = float(vQuery[2]);
+
+				const __m128 mQX = _mm_set1_ps(fQX);
+				const __m128 mQY = _mm_set1_ps(fQY);
+				const __m128 mQZ = _mm_set1_ps(fQZ);
+
+				size_t nIdx = nBegin;
+				for (; nIdx + 4 <= nEnd; nIdx += 4)
+				{
+					__m128 mDX = _mm_sub_ps(_mm_loadu_ps(pX + nIdx), mQX);
+					__m128 mDY = _mm_sub_ps(_mm_loadu_ps(pY + nIdx), mQY);
+					__m128 mDZ = _mm_sub_ps(_mm_loadu_ps(pZ + nIdx), mQZ);
+					__m128 mDistSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mDX, mDX), _mm_mul_ps(mDY, mDY)), _mm_mul_ps(mDZ, mDZ));
+
+					// The bound may have been lowered by the operator, so read it for every group of four points.
+					const float fMaxDistSq = float((std::min)(dMaxDistSq, TValue((std::numeric_limits<float>::max)())));
+					int iMask = _mm_movemask_ps(_mm_cmple_ps(mDistSq, _mm_set1_ps(fMaxDistSq)));
+					if (iMask == 0)
+					{
+						continue;
+					}
+
+					alignas(16) float pfDistSq[4];
+					_mm_store_ps(pfDistSq, mDistSq);
+					for (int iLane = 0; iLane < 4; ++iLane)
+					{
+						if ((iMask & (1 << iLane)) && TValue(pfDistSq[iLane]) <= dMaxDistSq)
+						{
+							funcOp(nIdx + iLane, TValue(pfDistSq[iLane]));
+						}
+					}
+				}
+
+				for (; nIdx < nEnd; ++nIdx)
+				{
+					float fDX = pX[nIdx] - fQX;
+					float fDY = pY[nIdx] - fQY;
+					float fDZ = pZ[nIdx] - fQZ;
+					TValue dDistSq = TValue(fDX * fDX + fDY * fDY + fDZ * fDZ);
+
+					if (dDistSq <= dMaxDistSq)
+					{
+						funcOp(nIdx, dDistSq);
+					}
+				}
+			}
+		};
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Batched radius search for any spatial index that offers ForEachInRadius(). Each thread collects its
+		/// 	neighbor lists locally, then the lists are concatenated in query order. The neighbors of query i are
+		/// 	vecIdx[vecOffset[i]] to vecIdx[vecOffset[i+1] - 1].
+		/// </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename TIndex, typename TValue>
+		void BatchFindInRadius(const TIndex& xIndex, const _SVector<TValue, 3>* pQuery, size_t nQueryCount, TValue dRadius
+			, std::vector<size_t>& vecOffset, std::vector<TIdx>& vecIdx)
+		{
+			vecOffset.assign(nQueryCount + 1, 0);
+			vecIdx.clear();
+
+			const unsigned uBlockCount = Clu::Parallel::BlockCount(nQueryCount, MinParallelQueryCount);
+			std::vector<std::vector<TIdx>> vecBlockIdx(uBlockCount);
+
+			Clu::Parallel::ForEachBlock(nQueryCount, MinParallelQueryCount, [&](size_t nBegin, size_t nEnd, unsigned uBlockIdx)
+			{
+				std::vector<TIdx>& vecLocal = vecBlockIdx[uBlockIdx];
+				for (size_t nQueryIdx = nBegin; nQueryIdx < nEnd; ++nQueryIdx)
+				{
+					const size_t nLocalBegin = vecLocal.size();
+					xIndex.ForEachInRadius(pQuery[nQueryIdx], dRadius, [&vecLocal](TIdx nIdx, TValue)
+					{
+						vecLocal.push_back(nIdx);
+					});
+
+					vecOffset[nQueryIdx + 1] = vecLocal.size() - nLocalBegin;
+				}
+			});
+
+			for (size_t nQueryIdx = 0; nQueryIdx < nQueryCount; ++nQueryIdx)
+			{
+				vecOffset[nQueryIdx + 1] += vecOffset[nQueryIdx];
+			}
+
+			vecIdx.reserve(vecOffset[nQueryCount]);
+			for (const std::vector<TIdx>& vecLocal : vecBlockIdx)
+			{
+				vecIdx.insert(vecIdx.end(), vecLocal.begin(), vecLocal.end());
+			}
+		}
+	} // namespace SpatialIndex
+} // namespace Clu
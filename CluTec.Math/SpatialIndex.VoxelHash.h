@@ -0,0 +1,549 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Math
+// file:      SpatialIndex.VoxelHash.h
+//
+// summary:   Declares the voxel hash grid spatial index for 3D point clouds
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "CluTec.Base/Defines.h"
+#include "CluTec.Base/Parallel.h"
+
+#include "Static.Vector.h"
+#include "SpatialIndex.Points.h"
+
+namespace Clu
+{
+	namespace SpatialIndex
+	{
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	A uniform voxel grid over a 3D point cloud, where only occupied voxels are stored.
+		///
+		/// 	The points are sorted by voxel, so that the points of a voxel form a contiguous range of the point store.
+		/// 	An open addressing hash table maps voxel coordinates to these ranges. Radius queries only visit the voxels
+		/// 	overlapping the query sphere, which makes the grid preferable to the k-d tree for dense clouds and radii
+		/// 	close to the voxel size. The grid is built in parallel and the batched queries distribute the query points
+		/// 	over all hardware threads. Query results refer to the indices of the points passed to Create().
+		/// </summary>
+		///
+		/// <typeparam name="_TValue"> Type of the point coordinates. </typeparam>
+		/// <typeparam name="_TStore"> The point store layout. Use CPointStoreSoAFloat for the float32 SoA layout. </typeparam>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		template<typename _TValue, typename _TStore = CPointStoreAoS<_TValue>>
+		class CVoxelHashGrid3D
+		{
+		public:
+			using TValue = _TValue;
+			using TVec3 = _SVector<TValue, 3>;
+			using TStore = _TStore;
+			using TKey = uint64_t;
+
+		protected:
+			/// <summary>	Voxel coordinates are stored with 21 bits per axis in the voxel key. </summary>
+			static const int32_t VoxelCoordBits = 21;
+			static const int32_t VoxelCoordOffset = 1 << (VoxelCoordBits - 1);
+
+			static const size_t MinParallelPoints = 4096;
+
+		protected:
+			std::vector<TKey> m_vecVoxelKey;
+			std::vector<TIdx> m_vecVoxelBegin;
+			std::vector<TIdx> m_vecHashSlot;
+			std::vector<TIdx> m_vecOrigIdx;
+			TStore m_xStore;
+
+			TValue m_dVoxelSize;
+			TValue m_dInvVoxelSize;
+			int32_t m_piMinVoxel[3];
+			int32_t m_piMaxVoxel[3];
+			uint32_t m_uHashShift;
+
+		public:
+			CVoxelHashGrid3D()
+			{
+				Destroy();
+			}
+
+			void Destroy()
+			{
+				m_vecVoxelKey.clear();
+				m_vecVoxelBegin.clear();
+				m_vecHashSlot.clear();
+				m_vecOrigIdx.clear();
+				m_xStore.Clear();
+
+				m_dVoxelSize = TValue(1);
+				m_dInvVoxelSize = TValue(1);
+				for (int i = 0; i < 3; ++i)
+				{
+					m_piMinVoxel[i] = 0;
+					m_piMaxVoxel[i] = -1;
+				}
+
+				m_uHashShift = 64;
+			}
+
+			bool IsValid() const
+			{
+				return !m_vecVoxelKey.empty();
+			}
+
+			size_t PointCount() const
+			{
+				return m_vecOrigIdx.size();
+			}
+
+			size_t VoxelCount() const
+			{
+				return m_vecVoxelKey.size();
+			}
+
+			TValue VoxelSize() const
+			{
+				return m_dVoxelSize;
+			}
+
+			const TStore& Store() const
+			{
+				return m_xStore;
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Creates the grid from the given points. The points are copied into the grid.
+			/// </summary>
+			///
+			/// <param name="pPoints">    The points. </param>
+			/// <param name="nCount">	  Number of points. </param>
+			/// <param name="dVoxelSize"> The edge length of a voxel. </param>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			void Create(const TVec3* pPoints, size_t nCount, TValue dVoxelSize)
+			{
+				Destroy();
+
+				if (!(dVoxelSize > TValue(0)))
+				{
+					throw CLU_EXCEPTION("Voxel size has to be positive");
+				}
+
+				m_dVoxelSize = dVoxelSize;
+				m_dInvVoxelSize = TValue(1) / dVoxelSize;
+
+				if (nCount == 0)
+				{
+					return;
+				}
+
+				if (pPoints == nullptr)
+				{
+					throw CLU_EXCEPTION("Invalid point array");
+				}
+
+				if (nCount >= size_t(InvalidIdx))
+				{
+					throw CLU_EXCEPTION("Too many points for voxel grid");
+				}
+
+				// Evaluate the voxel keys and the voxel bounding box in parallel.
+				using TKeyIdx = std::pair<TKey, TIdx>;
+				std::vector<TKeyIdx> vecKeyIdx(nCount);
+
+				const unsigned uBlockCount = Clu::Parallel::BlockCount(nCount, MinParallelPoints);
+				std::vector<int32_t> vecBlockMinMax(size_t(uBlockCount) * 6);
+				std::atomic<bool> bOutOfRange(false);
+
+				Clu::Parallel::ForEachBlock(nCount, MinParallelPoints, [&](size_t nBegin, size_t nEnd, unsigned uBlockIdx)
+				{
+					int32_t* piMin = &vecBlockMinMax[size_t(uBlockIdx) * 6];
+					int32_t* piMax = piMin + 3;
+					for (int i = 0; i < 3; ++i)
+					{
+						piMin[i] = (std::numeric_limits<int32_t>::max)();
+						piMax[i] = (std::numeric_limits<int32_t>::min)();
+					}
+
+					bool bBlockOutOfRange = false;
+					for (size_t nIdx = nBegin; nIdx < nEnd; ++nIdx)
+					{
+						int32_t piVoxel[3];
+						bBlockOutOfRange |= !_ToVoxel(pPoints[nIdx], piVoxel);
+
+						for (int i = 0; i < 3; ++i)
+						{
+							piMin[i] = (std::min)(piMin[i], piVoxel[i]);
+							piMax[i] = (std::max)(piMax[i], piVoxel[i]);
+						}
+
+						vecKeyIdx[nIdx] = TKeyIdx(_ToKey(piVoxel), TIdx(nIdx));
+					}
+
+					if (bBlockOutOfRange)
+					{
+						bOutOfRange = true;
+					}
+				});
+
+				if (bOutOfRange)
+				{
+					throw CLU_EXCEPTION("Point coordinates out of range for the given voxel size");
+				}
+
+				for (int i = 0; i < 3; ++i)
+				{
+					m_piMinVoxel[i] = (std::numeric_limits<int32_t>::max)();
+					m_piMaxVoxel[i] = (std::numeric_limits<int32_t>::min)();
+				}
+
+				for (unsigned uBlockIdx = 0; uBlockIdx < uBlockCount; ++uBlockIdx)
+				{
+					const int32_t* piMin = &vecBlockMinMax[size_t(uBlockIdx) * 6];
+					for (int i = 0; i < 3; ++i)
+					{
+						m_piMinVoxel[i] = (std::min)(m_piMinVoxel[i], piMin[i]);
+						m_piMaxVoxel[i] = (std::max)(m_piMaxVoxel[i], piMin[i + 3]);
+					}
+				}
+
+				// Sort the blocks in parallel and merge them pairwise.
+				Clu::Parallel::ForEachBlock(nCount, MinParallelPoints, [&](size_t nBegin, size_t nEnd, unsigned)
+				{
+					std::sort(vecKeyIdx.begin() + nBegin, vecKeyIdx.begin() + nEnd);
+				});
+
+				for (unsigned uStep = 1; uStep < uBlockCount; uStep *= 2)
+				{
+					const unsigned uMergeCount = (uBlockCount + 2 * uStep - 1) / (2 * uStep);
+					Clu::Parallel::ForEachIndex(uMergeCount, 1, [&](size_t nMergeIdx)
+					{
+						const size_t nFirstBlock = nMergeIdx * 2 * uStep;
+						const size_t nMidBlock = (std::min)(nFirstBlock + uStep, size_t(uBlockCount));
+						const size_t nLastBlock = (std::min)(nFirstBlock + 2 * uStep, size_t(uBlockCount));
+
+						// Same block boundaries as used by ForEachBlock().
+						auto itBegin = vecKeyIdx.begin() + (nCount * nFirstBlock) / uBlockCount;
+						auto itMid = vecKeyIdx.begin() + (nCount * nMidBlock) / uBlockCount;
+						auto itEnd = vecKeyIdx.begin() + (nCount * nLastBlock) / uBlockCount;
+
+						std::inplace_merge(itBegin, itMid, itEnd);
+					});
+				}
+
+				// Store the points in voxel order and collect the voxel ranges.
+				m_xStore.Resize(nCount);
+				m_vecOrigIdx.resize(nCount);
+				Clu::Parallel::ForEachIndex(nCount, MinParallelPoints, [&](size_t nIdx)
+				{
+					const TIdx nOrigIdx = vecKeyIdx[nIdx].second;
+					m_xStore.Set(nIdx, pPoints[nOrigIdx]);
+					m_vecOrigIdx[nIdx] = nOrigIdx;
+				});
+
+				for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+				{
+					if (nIdx == 0 || vecKeyIdx[nIdx].first != vecKeyIdx[nIdx - 1].first)
+					{
+						m_vecVoxelKey.push_back(vecKeyIdx[nIdx].first);
+						m_vecVoxelBegin.push_back(TIdx(nIdx));
+					}
+				}
+				m_vecVoxelBegin.push_back(TIdx(nCount));
+
+				// Build the hash table with a load factor of at most one half.
+				size_t nSlotCount = 2;
+				m_uHashShift = 63;
+				while (nSlotCount < 2 * m_vecVoxelKey.size())
+				{
+					nSlotCount *= 2;
+					--m_uHashShift;
+				}
+
+				m_vecHashSlot.assign(nSlotCount, InvalidIdx);
+				const size_t nSlotMask = nSlotCount - 1;
+				for (size_t nVoxelIdx = 0; nVoxelIdx < m_vecVoxelKey.size(); ++nVoxelIdx)
+				{
+					size_t nSlot = _Hash(m_vecVoxelKey[nVoxelIdx]);
+					while (m_vecHashSlot[nSlot] != InvalidIdx)
+					{
+						nSlot = (nSlot + 1) & nSlotMask;
+					}
+
+					m_vecHashSlot[nSlot] = TIdx(nVoxelIdx);
+				}
+			}
+
+			void Create(const std::vector<TVec3>& vecPoints, TValue dVoxelSize)
+			{
+				Create(vecPoints.data(), vecPoints.size(), dVoxelSize);
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Calls funcOp(nIdx, dDistSq) for each point within the given radius of the query point.
+			/// </summary>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			template<typename FuncOp>
+			void ForEachInRadius(const TVec3& vQuery, TValue dRadius, FuncOp funcOp) const
+			{
+				if (!IsValid())
+				{
+					return;
+				}
+
+				int32_t piMin[3], piMax[3];
+				for (int i = 0; i < 3; ++i)
+				{
+					const TValue dLo = floor((vQuery[i] - dRadius) * m_dInvVoxelSize);
+					const TValue dHi = floor((vQuery[i] + dRadius) * m_dInvVoxelSize);
+
+					piMin[i] = int32_t((std::max)(dLo, TValue(m_piMinVoxel[i])));
+					piMax[i] = int32_t((std::min)(dHi, TValue(m_piMaxVoxel[i])));
+				}
+
+				const TValue dRadiusSq = dRadius * dRadius;
+				_ForEachInVoxelBox(piMin, piMax, vQuery, dRadiusSq, funcOp);
+			}
+
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			/// <summary>
+			/// 	Finds the k nearest points of the given query point by searching shells of voxels of increasing size
+			/// 	around the voxel of the query point. Does not allocate memory.
+			/// </summary>
+			///
+			/// <param name="vQuery">  The query point. </param>
+			/// <param name="nK">	   The number of neighbors to find. </param>
+			/// <param name="pIdx">    [out] Array of nK point indices, sorted by ascending distance. Unused entries are set
+			/// 					   to InvalidIdx. </param>
+			/// <param name="pDistSq"> [out] Array of nK squared distances. </param>
+			///
+			/// <returns> The number of neighbors found. </returns>
+			/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+			uint32_t FindKNearest(const TVec3& vQuery, uint32_t nK, TIdx* pIdx, TValue* pDistSq) const
+			{
+				CNearestSet<TValue> xSet(pIdx, pDistSq, nK);
+				if (!IsValid() || nK == 0)
+				{
+					return xSet.Finalize();
+				}
+
+				// Voxel of the query point, clamped to the grid box, and the distance of the query point to the
+				// boundary of its voxel.
+				int32_t piCenter[3];
+				TValue dInnerDist = (std::numeric_limits<TValue>::max)();
+				int32_t iMaxShell = 0;
+				for (int i = 0; i < 3; ++i)
+				{
+					const TValue dPos = vQuery[i] * m_dInvVoxelSize;
+					const TValue dVoxel = floor(dPos);
+					const TValue dClamped = (std::min)((std::max)(dVoxel, TValue(m_piMinVoxel[i])), TValue(m_piMaxVoxel[i]));
+					piCenter[i] = int32_t(dClamped);
+
+					if (dClamped == dVoxel)
+					{
+						dInnerDist = (std::min)(dInnerDist, (std::min)(dPos - dVoxel, dVoxel + TValue(1) - dPos) * m_dVoxelSize);
+					}
+					else
+					{
+						dInnerDist = TValue(0);
+					}
+
+					iMaxShell = (std::max)(iMaxShell, (std::max)(piCenter[i] - m_piMinVoxel[i], m_piMaxVoxel[i] - piCenter[i]));
+				}
+
+				auto funcInsert = [&xSet](TIdx nIdx, TValue dDistSq)
+				{
+					xSet.Insert(nIdx, dDistSq);
+				};
+
+				for (int32_t iShell = 0; iShell <= iMaxShell; ++iShell)
+				{
+					_ForEachInVoxelShell(piCenter, iShell, vQuery, xSet, funcInsert);
+
+					// All points in shells further out are at least this far away.
+					const TValue dBound = TValue(iShell) * m_dVoxelSize + dInnerDist;
+					if (xSet.IsFull() && xSet.WorstDistSq() <= dBound * dBound)
+					{
+						break;
+					}
+				}
+
+				return xSet.Finalize();
+			}
+
+			/// <summary>	Finds the nearest point of the given query point. Returns InvalidIdx if the grid is empty. </summary>
+			TIdx FindNearest(const TVec3& vQuery, TValue& dDistSq) const
+			{
+				TIdx nIdx;
+				FindKNearest(vQuery, 1, &nIdx, &dDistSq);
+				return nIdx;
+			}
+
+			/// <summary>	Finds the k nearest points for each of the given query points in parallel. See CKdTree3D. </summary>
+			void FindKNearest(const TVec3* pQuery, size_t nQueryCount, uint32_t nK, TIdx* pIdx, TValue* pDistSq) const
+			{
+				Clu::Parallel::ForEachIndex(nQueryCount, MinParallelQueryCount, [&](size_t nQueryIdx)
+				{
+					FindKNearest(pQuery[nQueryIdx], nK, pIdx + nQueryIdx * nK, pDistSq + nQueryIdx * nK);
+				});
+			}
+
+			/// <summary>	Finds all points within the given radius for each of the given query points in parallel. See CKdTree3D. </summary>
+			void FindInRadius(const TVec3* pQuery, size_t nQueryCount, TValue dRadius
+				, std::vector<size_t>& vecOffset, std::vector<TIdx>& vecIdx) const
+			{
+				BatchFindInRadius(*this, pQuery, nQueryCount, dRadius, vecOffset, vecIdx);
+			}
+
+		protected:
+			bool _ToVoxel(const TVec3& vX, int32_t piVoxel[3]) const
+			{
+				bool bInRange = true;
+				for (int i = 0; i < 3; ++i)
+				{
+					const TValue dVoxel = floor(vX[i] * m_dInvVoxelSize);
+					if (!(dVoxel >= TValue(-VoxelCoordOffset) && dVoxel < TValue(VoxelCoordOffset)))
+					{
+						bInRange = false;
+						piVoxel[i] = 0;
+					}
+					else
+					{
+						piVoxel[i] = int32_t(dVoxel);
+					}
+				}
+
+				return bInRange;
+			}
+
+			static TKey _ToKey(const int32_t piVoxel[3])
+			{
+				return (TKey(uint32_t(piVoxel[0] + VoxelCoordOffset)) << (2 * VoxelCoordBits))
+					| (TKey(uint32_t(piVoxel[1] + VoxelCoordOffset)) << VoxelCoordBits)
+					| TKey(uint32_t(piVoxel[2] + VoxelCoordOffset));
+			}
+
+			size_t _Hash(TKey uKey) const
+			{
+				// Fibonacci hashing
+				return size_t((uKey * 0x9E3779B97F4A7C15ull) >> m_uHashShift);
+			}
+
+			/// <summary>	Returns the index of the voxel with the given coordinates or InvalidIdx if it is empty. </summary>
+			TIdx _FindVoxel(const int32_t piVoxel[3]) const
+			{
+				const TKey uKey = _ToKey(piVoxel);
+				const size_t nSlotMask = m_vecHashSlot.size() - 1;
+
+				for (size_t nSlot = _Hash(uKey); ; nSlot = (nSlot + 1) & nSlotMask)
+				{
+					const TIdx nVoxelIdx = m_vecHashSlot[nSlot];
+					if (nVoxelIdx == InvalidIdx || m_vecVoxelKey[nVoxelIdx] == uKey)
+					{
+						return nVoxelIdx;
+					}
+				}
+			}
+
+			template<typename FuncOp>
+			void _ForEachInVoxel(const int32_t piVoxel[3], const TVec3& vQuery, const TValue& dMaxDistSq, FuncOp funcOp) const
+			{
+				const TIdx nVoxelIdx = _FindVoxel(piVoxel);
+				if (nVoxelIdx == InvalidIdx)
+				{
+					return;
+				}
+
+				m_xStore.ForEachInRange(m_vecVoxelBegin[nVoxelIdx], m_vecVoxelBegin[nVoxelIdx + 1], vQuery, dMaxDistSq,
+					[&](size_t nIdx, TValue dDistSq)
+				{
+					funcOp(m_vecOrigIdx[nIdx], dDistSq);
+				});
+			}
+
+			template<typename FuncOp>
+			void _ForEachInVoxelBox(const int32_t piMin[3], const int32_t piMax[3], const TVec3& vQuery, TValue dMaxDistSq, FuncOp funcOp) const
+			{
+				int32_t piVoxel[3];
+				for (piVoxel[0] = piMin[0]; piVoxel[0] <= piMax[0]; ++piVoxel[0])
+				{
+					for (piVoxel[1] = piMin[1]; piVoxel[1] <= piMax[1]; ++piVoxel[1])
+					{
+						for (piVoxel[2] = piMin[2]; piVoxel[2] <= piMax[2]; ++piVoxel[2])
+						{
+							_ForEachInVoxel(piVoxel, vQuery, dMaxDistSq, funcOp);
+						}
+					}
+				}
+			}
+
+			/// <summary>	Visits all voxels at Chebyshev distance iShell from the center voxel that lie inside the grid box. </summary>
+			template<typename FuncOp>
+			void _ForEachInVoxelShell(const int32_t piCenter[3], int32_t iShell, const TVec3& vQuery
+				, const CNearestSet<TValue>& xSet, FuncOp funcOp) const
+			{
+				int32_t piMin[3], piMax[3];
+				for (int i = 0; i < 3; ++i)
+				{
+					piMin[i] = (std::max)(piCenter[i] - iShell, m_piMinVoxel[i]);
+					piMax[i] = (std::min)(piCenter[i] + iShell, m_piMaxVoxel[i]);
+				}
+
+				int32_t piVoxel[3];
+				for (piVoxel[0] = piMin[0]; piVoxel[0] <= piMax[0]; ++piVoxel[0])
+				{
+					const bool bShellX = (abs(piVoxel[0] - piCenter[0]) == iShell);
+					for (piVoxel[1] = piMin[1]; piVoxel[1] <= piMax[1]; ++piVoxel[1])
+					{
+						const bool bShellXY = bShellX || (abs(piVoxel[1] - piCenter[1]) == iShell);
+						for (piVoxel[2] = piMin[2]; piVoxel[2] <= piMax[2]; ++piVoxel[2])
+						{
+							if (!bShellXY && abs(piVoxel[2] - piCenter[2]) != iShell)
+							{
+								// Jump over the voxels inside the shell.
+								piVoxel[2] = (std::max)(piVoxel[2], piCenter[2] + iShell - 1);
+								continue;
+							}
+
+							TValue dMaxDistSq = xSet.WorstDistSq();
+							_ForEachInVoxel(piVoxel, vQuery, dMaxDistSq, [&](TIdx nIdx, TValue dDistSq)
+							{
+								funcOp(nIdx, dDistSq);
+								dMaxDistSq = xSet.WorstDistSq();
+							});
+						}
+					}
+				}
+			}
+		};
+	} // namespace SpatialIndex
+} // namespace Clu
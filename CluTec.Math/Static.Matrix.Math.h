@@ -128,10 +128,10 @@ namespace Clu
 		_SVector4<T> vecAxisAngle;
 
 		// Margin to allow for rounding errors
-		double epsilon1 = 0.01;
+		T epsilon1 = T(0.01);
 
 		// Margin to distinguish between 0 and 180 degrees
-		double epsilon2 = 0.1;
+		T epsilon2 = T(0.1);
 
 		// Optional check that input is pure rotation, is defined at:
 		// http://www.euclideanspace.com/maths/algebra/matrix/orthogonal/rotation/
@@ -159,12 +159,12 @@ namespace Clu
 
 			// Otherwise this singularity is angle = 180
 			vecAxisAngle.w() = Clu::Math::Constants<T>::Pi();
-			double xx = (mRotationMatrix(0, 0) + 1) / 2;
-			double yy = (mRotationMatrix(1, 1) + 1) / 2;
-			double zz = (mRotationMatrix(2, 2) + 1) / 2;
-			double xy = (mRotationMatrix(0, 1) + mRotationMatrix(1, 0)) / 4;
-			double xz = (mRotationMatrix(0, 2) + mRotationMatrix(2, 0)) / 4;
-			double yz = (mRotationMatrix(1, 2) + mRotationMatrix(2, 1)) / 4;
+			T xx = (mRotationMatrix(0, 0) + 1) / 2;
+			T yy = (mRotationMatrix(1, 1) + 1) / 2;
+			T zz = (mRotationMatrix(2, 2) + 1) / 2;
+			T xy = (mRotationMatrix(0, 1) + mRotationMatrix(1, 0)) / 4;
+			T xz = (mRotationMatrix(0, 2) + mRotationMatrix(2, 0)) / 4;
+			T yz = (mRotationMatrix(1, 2) + mRotationMatrix(2, 1)) / 4;
 
 			// mRotaionMatrix(0, 0) is the largest diagonal term
 			if ((xx > yy) && (xx > zz))
@@ -177,9 +177,9 @@ namespace Clu
 				}
 				else
 				{
-					vecAxisAngle.x() = ::sqrt(xx);
-					vecAxisAngle.y() = xy / vecAxisAngle.x;
-					vecAxisAngle.z() = xz / vecAxisAngle.x;
+					vecAxisAngle.x() = sqrt(xx);
+					vecAxisAngle.y() = xy / vecAxisAngle.x();
+					vecAxisAngle.z() = xz / vecAxisAngle.x();
 				}
 			}
 			// mRotaionMatrix(1,1) is the largest diagonal term
@@ -193,7 +193,7 @@ namespace Clu
 				}
 				else
 				{
-					vecAxisAngle.y() = ::sqrt(yy);
+					vecAxisAngle.y() = sqrt(yy);
 					vecAxisAngle.x() = xy / vecAxisAngle.y();
 					vecAxisAngle.z() = yz / vecAxisAngle.y();
 				}
@@ -209,7 +209,7 @@ namespace Clu
 				}
 				else
 				{
-					vecAxisAngle.z() = std::sqrt(zz);
+					vecAxisAngle.z() = sqrt(zz);
 					vecAxisAngle.x() = xz / vecAxisAngle.z();
 					vecAxisAngle.y() = yz / vecAxisAngle.z();
 				}
@@ -218,10 +218,10 @@ namespace Clu
 			return vecAxisAngle;
 		}
 
-		double dDivider = ::sqrt(
-				::pow((mRotationMatrix(2, 1) -  mRotationMatrix(1, 2)), 2)
-				+ ::pow((mRotationMatrix(0, 2) - mRotationMatrix(2, 0)), 2.0)
-				+  ::pow((mRotationMatrix(1, 0) - mRotationMatrix(0, 1)), 2.0));
+		T dDivider = sqrt(
+				pow((mRotationMatrix(2, 1) - mRotationMatrix(1, 2)), 2)
+				+ pow((mRotationMatrix(0, 2) - mRotationMatrix(2, 0)), 2)
+				+ pow((mRotationMatrix(1, 0) - mRotationMatrix(0, 1)), 2));
 
 		vecAxisAngle.x() = (mRotationMatrix(2, 1) - mRotationMatrix(1, 2)) / dDivider;
 		vecAxisAngle.y() = (mRotationMatrix(0, 2) - mRotationMatrix(2, 0)) / dDivider;
@@ -0,0 +1,662 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Math
+// file:      Static.Polynomial.Algo.h
+//
+// summary:   Declares batched evaluation, streaming least squares fit and real root finding of static polynomials
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+
+#include <immintrin.h>
+
+#include "CluTec.Base/Defines.h"
+#include "CluTec.Base/IntrinsicFunctions.h"
+#include "CluTec.Base/Parallel.h"
+
+#include "Static.Polynomial.h"
+#include "Static.Polynomial.Avx2.h"
+
+namespace Clu
+{
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	SIMD register abstraction used by the batched polynomial evaluation. The generic version processes one value
+	/// 	per step; float and double use SSE2, which all x64 processors support. Processors with AVX2 run the
+	/// 	kernels of Static.Polynomial.Avx2.cpp first, see _PolyEvaluateAvx2().
+	/// </summary>
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	template<typename T>
+	struct _SPolyScalar
+	{
+		using TReg = T;
+		static const size_t Width = 1;
+
+		static TReg Set1(T tX) { return tX; }
+		static TReg Load(const T* pX) { return *pX; }
+		static void Store(T* pX, TReg tX) { *pX = tX; }
+		static TReg MulAdd(TReg tA, TReg tB, TReg tC) { return tA * tB + tC; }
+	};
+
+	template<typename T>
+	struct _SPolySimd : public _SPolyScalar<T>
+	{
+	};
+
+	template<>
+	struct _SPolySimd<float>
+	{
+		using TReg = __m128;
+		static const size_t Width = 4;
+
+		static TReg Set1(float fX) { return _mm_set1_ps(fX); }
+		static TReg Load(const float* pX) { return _mm_loadu_ps(pX); }
+		static void Store(float* pX, TReg mX) { _mm_storeu_ps(pX, mX); }
+		static TReg MulAdd(TReg mA, TReg mB, TReg mC) { return _mm_add_ps(_mm_mul_ps(mA, mB), mC); }
+	};
+
+	template<>
+	struct _SPolySimd<double>
+	{
+		using TReg = __m128d;
+		static const size_t Width = 2;
+
+		static TReg Set1(double dX) { return _mm_set1_pd(dX); }
+		static TReg Load(const double* pX) { return _mm_loadu_pd(pX); }
+		static void Store(double* pX, TReg mX) { _mm_storeu_pd(pX, mX); }
+		static TReg MulAdd(TReg mA, TReg mB, TReg mC) { return _mm_add_pd(_mm_mul_pd(mA, mB), mC); }
+	};
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Evaluates the values nBegin to nEnd with the AVX2 kernels, as far as they fill whole vectors. Only float
+	/// 	and double have such kernels; other types are left to _PolyEvaluateRange().
+	/// </summary>
+	///
+	/// <returns> The index of the first value that was not evaluated. </returns>
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	template<typename T>
+	size_t _PolyEvaluateAvx2(const T* /*pCoef*/, unsigned /*uDegree*/, const T* /*pX*/, T* /*pY*/, T* /*pDY*/, T* /*pDDY*/, size_t nBegin, size_t /*nEnd*/)
+	{
+		return nBegin;
+	}
+
+	inline size_t _PolyEvaluateAvx2(const float* pCoef, unsigned uDegree, const float* pX, float* pY, float* pDY, float* pDDY, size_t nBegin, size_t nEnd)
+	{
+		return Clu::Intrinsics::HasAvx2() ? Avx2::PolyEvaluate(pCoef, uDegree, pX, pY, pDY, pDDY, nBegin, nEnd) : nBegin;
+	}
+
+	inline size_t _PolyEvaluateAvx2(const double* pCoef, unsigned uDegree, const double* pX, double* pY, double* pDY, double* pDDY, size_t nBegin, size_t nEnd)
+	{
+		return Clu::Intrinsics::HasAvx2() ? Avx2::PolyEvaluate(pCoef, uDegree, pX, pY, pDY, pDDY, nBegin, nEnd) : nBegin;
+	}
+
+	/// <summary>	Minimal number of values per thread for the batched polynomial evaluation. </summary>
+	static const size_t PolyMinParallelValues = 1 << 16;
+
+	template<typename T, const unsigned t_uDegree, typename TSimd>
+	void _PolyEvaluateRange(const _SPolynomial<T, t_uDegree>& yA, const T* pX, T* pY, T* pDY, T* pDDY, size_t nBegin, size_t nEnd)
+	{
+		using TReg = typename TSimd::TReg;
+
+		TReg pCoef[t_uDegree + 1];
+		for (unsigned uIdx = 0; uIdx <= t_uDegree; ++uIdx)
+		{
+			pCoef[uIdx] = TSimd::Set1(yA[uIdx]);
+		}
+
+		const TReg tZero = TSimd::Set1(T(0));
+		const TReg tTwo = TSimd::Set1(T(2));
+
+		size_t nIdx = nBegin;
+		for (; nIdx + TSimd::Width <= nEnd; nIdx += TSimd::Width)
+		{
+			const TReg tX = TSimd::Load(pX + nIdx);
+
+			// Horner scheme evaluating p, p' and p'' in the same pass:
+			// p'' = p'' x + 2 p', p' = p' x + p, p = p x + a_i
+			TReg tY = pCoef[t_uDegree];
+			TReg tDY = tZero;
+			TReg tDDY = tZero;
+
+			for (int iIdx = int(t_uDegree) - 1; iIdx >= 0; --iIdx)
+			{
+				if (pDDY)
+				{
+					tDDY = TSimd::MulAdd(tDDY, tX, tDY);
+				}
+
+				tDY = TSimd::MulAdd(tDY, tX, tY);
+				tY = TSimd::MulAdd(tY, tX, pCoef[iIdx]);
+			}
+
+			TSimd::Store(pY + nIdx, tY);
+
+			if (pDY)
+			{
+				TSimd::Store(pDY + nIdx, tDY);
+			}
+
+			if (pDDY)
+			{
+				// The recursion above accumulates p''/2.
+				TSimd::Store(pDDY + nIdx, TSimd::MulAdd(tDDY, tTwo, tZero));
+			}
+		}
+
+		if (nIdx < nEnd)
+		{
+			_PolyEvaluateRange<T, t_uDegree, _SPolyScalar<T>>(yA, pX, pY, pDY, pDDY, nIdx, nEnd);
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Evaluates the polynomial and optionally its first and second derivative at all given values. Uses SIMD
+	/// 	instructions for float and double and splits large arrays over several threads.
+	/// </summary>
+	///
+	/// <param name="yA">	  The polynomial. </param>
+	/// <param name="pX">	  The values to evaluate the polynomial at. </param>
+	/// <param name="pY">	  [out] The polynomial values. </param>
+	/// <param name="pDY">	  [out] The values of the first derivative. May be nullptr. </param>
+	/// <param name="pDDY">   [out] The values of the second derivative. May be nullptr. </param>
+	/// <param name="nCount"> Number of values. </param>
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	template<typename T, const unsigned t_uDegree>
+	void PolyEvaluate(const _SPolynomial<T, t_uDegree>& yA, const T* pX, T* pY, T* pDY, T* pDDY, size_t nCount)
+	{
+		Clu::Parallel::ForEachBlock(nCount, PolyMinParallelValues, [&](size_t nBegin, size_t nEnd, unsigned)
+		{
+			const size_t nIdx = _PolyEvaluateAvx2(&yA[0], t_uDegree, pX, pY, pDY, pDDY, nBegin, nEnd);
+			_PolyEvaluateRange<T, t_uDegree, _SPolySimd<T>>(yA, pX, pY, pDY, pDDY, nIdx, nEnd);
+		});
+	}
+
+	template<typename T, const unsigned t_uDegree>
+	void PolyEvaluate(const _SPolynomial<T, t_uDegree>& yA, const T* pX, T* pY, size_t nCount)
+	{
+		PolyEvaluate(yA, pX, pY, (T*)nullptr, (T*)nullptr, nCount);
+	}
+
+	template<typename T, const unsigned t_uDegree>
+	void PolyEvaluate(const _SPolynomial<T, t_uDegree>& yA, const T* pX, T* pY, T* pDY, size_t nCount)
+	{
+		PolyEvaluate(yA, pX, pY, pDY, (T*)nullptr, nCount);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Least squares polynomial fit that accumulates the normal equations while the samples are added, so that the
+	/// 	samples need not be stored. The samples are mapped to u = (x - center) / scale before accumulation, which
+	/// 	keeps the normal equations well conditioned if center and scale match the sample range. Fitters filled
+	/// 	from different threads can be combined with Merge().
+	/// </summary>
+	///
+	/// <typeparam name="T">		 Type of the samples and of the resultant polynomial. </typeparam>
+	/// <typeparam name="t_uDegree"> The polynomial degree. </typeparam>
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	template<typename T, const unsigned t_uDegree>
+	class CPolyFitLSStream
+	{
+	public:
+		static const unsigned ParCount = t_uDegree + 1;
+
+	protected:
+		/// <summary>	Sums of w * u^i for i = 0 .. 2 * degree. These are the entries of the normal matrix. </summary>
+		double m_pdPowerSum[2 * t_uDegree + 1];
+
+		/// <summary>	Sums of w * y * u^i. </summary>
+		double m_pdMomentSum[ParCount];
+
+		/// <summary>	Sum of w * y^2, used to evaluate the residual. </summary>
+		double m_dSumYY;
+
+		double m_dCenter;
+		double m_dInvScale;
+		size_t m_nCount;
+
+	public:
+		CPolyFitLSStream(T tCenter = T(0), T tScale = T(1))
+		{
+			Reset(tCenter, tScale);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Removes all samples and sets the normalization of the sample positions. </summary>
+		///
+		/// <param name="tCenter"> The center of the sample range. </param>
+		/// <param name="tScale">  The half width of the sample range. </param>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		void Reset(T tCenter = T(0), T tScale = T(1))
+		{
+			if (!(double(tScale) != 0.0))
+			{
+				throw CLU_EXCEPTION("Invalid polynomial fit scale");
+			}
+
+			for (double& dVal : m_pdPowerSum)
+			{
+				dVal = 0.0;
+			}
+
+			for (double& dVal : m_pdMomentSum)
+			{
+				dVal = 0.0;
+			}
+
+			m_dSumYY = 0.0;
+			m_dCenter = double(tCenter);
+			m_dInvScale = 1.0 / double(tScale);
+			m_nCount = 0;
+		}
+
+		size_t Count() const
+		{
+			return m_nCount;
+		}
+
+		void Add(T tX, T tY, T tWeight = T(1))
+		{
+			const double dU = (double(tX) - m_dCenter) * m_dInvScale;
+			const double dY = double(tY);
+			const double dW = double(tWeight);
+
+			double dPow = dW;
+			for (unsigned uIdx = 0; uIdx < 2 * t_uDegree + 1; ++uIdx)
+			{
+				m_pdPowerSum[uIdx] += dPow;
+				if (uIdx < ParCount)
+				{
+					m_pdMomentSum[uIdx] += dPow * dY;
+				}
+				dPow *= dU;
+			}
+
+			m_dSumYY += dW * dY * dY;
+			++m_nCount;
+		}
+
+		void Add(const T* pX, const T* pY, size_t nCount)
+		{
+			for (size_t nIdx = 0; nIdx < nCount; ++nIdx)
+			{
+				Add(pX[nIdx], pY[nIdx]);
+			}
+		}
+
+		/// <summary>	Adds the samples of another fitter with the same normalization. </summary>
+		void Merge(const CPolyFitLSStream& xFit)
+		{
+			if (xFit.m_dCenter != m_dCenter || xFit.m_dInvScale != m_dInvScale)
+			{
+				throw CLU_EXCEPTION("Polynomial fits with different normalization cannot be merged");
+			}
+
+			for (unsigned uIdx = 0; uIdx < 2 * t_uDegree + 1; ++uIdx)
+			{
+				m_pdPowerSum[uIdx] += xFit.m_pdPowerSum[uIdx];
+			}
+
+			for (unsigned uIdx = 0; uIdx < ParCount; ++uIdx)
+			{
+				m_pdMomentSum[uIdx] += xFit.m_pdMomentSum[uIdx];
+			}
+
+			m_dSumYY += xFit.m_dSumYY;
+			m_nCount += xFit.m_nCount;
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Solves the normal equations for the polynomial in x.
+		/// </summary>
+		///
+		/// <param name="yResult"> [out] The fit polynomial. </param>
+		/// <param name="tRMSDev"> [out] The weighted root mean square deviation of the samples from the fit. </param>
+		///
+		/// <returns> False if there are too few samples or the normal equations are singular. </returns>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		bool Solve(_SPolynomial<T, t_uDegree>& yResult, T& tRMSDev) const
+		{
+			if (m_nCount < ParCount)
+			{
+				return false;
+			}
+
+			// Cholesky decomposition of the Hankel matrix G(i, j) = PowerSum[i + j].
+			double pdL[ParCount][ParCount];
+			for (unsigned uC = 0; uC < ParCount; ++uC)
+			{
+				double dDiag = m_pdPowerSum[2 * uC];
+				for (unsigned k = 0; k < uC; ++k)
+				{
+					dDiag -= pdL[uC][k] * pdL[uC][k];
+				}
+
+				if (!(dDiag > m_pdPowerSum[2 * uC] * 1e-13))
+				{
+					return false;
+				}
+
+				pdL[uC][uC] = sqrt(dDiag);
+				for (unsigned uR = uC + 1; uR < ParCount; ++uR)
+				{
+					double dVal = m_pdPowerSum[uR + uC];
+					for (unsigned k = 0; k < uC; ++k)
+					{
+						dVal -= pdL[uR][k] * pdL[uC][k];
+					}
+					pdL[uR][uC] = dVal / pdL[uC][uC];
+				}
+			}
+
+			double pdZ[ParCount], pdA[ParCount];
+			for (unsigned uR = 0; uR < ParCount; ++uR)
+			{
+				double dVal = m_pdMomentSum[uR];
+				for (unsigned k = 0; k < uR; ++k)
+				{
+					dVal -= pdL[uR][k] * pdZ[k];
+				}
+				pdZ[uR] = dVal / pdL[uR][uR];
+			}
+
+			for (int iR = int(ParCount) - 1; iR >= 0; --iR)
+			{
+				double dVal = pdZ[iR];
+				for (unsigned k = unsigned(iR) + 1; k < ParCount; ++k)
+				{
+					dVal -= pdL[k][iR] * pdA[k];
+				}
+				pdA[iR] = dVal / pdL[iR][iR];
+			}
+
+			// Residual: sum w (y - a.u)^2 = sum w y^2 - a.b, as G a = b.
+			double dSqErr = m_dSumYY;
+			for (unsigned uIdx = 0; uIdx < ParCount; ++uIdx)
+			{
+				dSqErr -= pdA[uIdx] * m_pdMomentSum[uIdx];
+			}
+			tRMSDev = T(sqrt((std::max)(dSqErr, 0.0) / m_pdPowerSum[0]));
+
+			// Expand p((x - c) / s) into powers of x: ((x - c) / s)^i = s^-i SUM_k binom(i, k) x^k (-c)^(i-k)
+			double pdX[ParCount] = {};
+			for (unsigned uI = 0; uI < ParCount; ++uI)
+			{
+				double dFac = pdA[uI] * pow(m_dInvScale, double(uI));
+				double dBinom = 1.0;
+				for (unsigned uK = 0; uK <= uI; ++uK)
+				{
+					if (uK > 0)
+					{
+						dBinom = dBinom * double(uI - uK + 1) / double(uK);
+					}
+
+					pdX[uK] += dFac * dBinom * pow(-m_dCenter, double(uI - uK));
+				}
+			}
+
+			for (unsigned uIdx = 0; uIdx < ParCount; ++uIdx)
+			{
+				yResult[uIdx] = T(pdX[uIdx]);
+			}
+
+			return true;
+		}
+
+		bool Solve(_SPolynomial<T, t_uDegree>& yResult) const
+		{
+			T tRMSDev;
+			return Solve(yResult, tRMSDev);
+		}
+	};
+
+	/// <summary>	The maximal polynomial degree supported by PolyRealRoots(). </summary>
+	static const unsigned PolyRealRootsMaxDegree = 6;
+
+	template<typename T>
+	T _PolyValue(const T* pCoef, int iDegree, T tX)
+	{
+		T tY = pCoef[iDegree];
+		for (int iIdx = iDegree - 1; iIdx >= 0; --iIdx)
+		{
+			tY = tY * tX + pCoef[iIdx];
+		}
+
+		return tY;
+	}
+
+	/// <summary>	Finds the root of the polynomial in [tA, tB] with Newton steps safeguarded by bisection. </summary>
+	template<typename T>
+	T _PolyBracketedRoot(const T* pCoef, int iDegree, T tA, T tB, T tValA)
+	{
+		T tX = (tA + tB) / T(2);
+
+		for (int iIter = 0; iIter < 100; ++iIter)
+		{
+			// Horner for value and derivative
+			T tY = pCoef[iDegree];
+			T tDY = T(0);
+			for (int iIdx = iDegree - 1; iIdx >= 0; --iIdx)
+			{
+				tDY = tDY * tX + tY;
+				tY = tY * tX + pCoef[iIdx];
+			}
+
+			if (tY == T(0))
+			{
+				return tX;
+			}
+
+			if ((tY < T(0)) == (tValA < T(0)))
+			{
+				tA = tX;
+				tValA = tY;
+			}
+			else
+			{
+				tB = tX;
+			}
+
+			T tNext = tX - tY / tDY;
+			if (!(tNext > tA && tNext < tB))
+			{
+				tNext = (tA + tB) / T(2);
+			}
+
+			if (abs(tNext - tX) <= std::numeric_limits<T>::epsilon() * (abs(tX) + std::numeric_limits<T>::min()))
+			{
+				return tNext;
+			}
+
+			tX = tNext;
+		}
+
+		return tX;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Finds the real roots of a polynomial given by its coefficient array. The roots of the derivative split the
+	/// 	real line into intervals on which the polynomial is monotonic; each interval with a sign change contains
+	/// 	exactly one root. The derivative roots are found recursively. Does not allocate memory.
+	/// </summary>
+	///
+	/// <param name="pCoef">  The coefficients, starting with the constant term. </param>
+	/// <param name="iDegree"> The degree, at most PolyRealRootsMaxDegree. </param>
+	/// <param name="pRoots"> [out] The roots in ascending order. Has to hold iDegree elements. </param>
+	///
+	/// <returns> The number of distinct real roots found. </returns>
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	template<typename T>
+	unsigned PolyRealRoots(const T* pCoef, int iDegree, T* pRoots)
+	{
+		// Remove vanishing leading coefficients
+		while (iDegree > 0 && pCoef[iDegree] == T(0))
+		{
+			--iDegree;
+		}
+
+		if (iDegree <= 0)
+		{
+			return 0;
+		}
+
+		if (iDegree > int(PolyRealRootsMaxDegree))
+		{
+			throw CLU_EXCEPTION("Polynomial degree too large for real root finder");
+		}
+
+		if (iDegree == 1)
+		{
+			pRoots[0] = -pCoef[0] / pCoef[1];
+			return 1;
+		}
+
+		if (iDegree == 2)
+		{
+			const T tA = pCoef[2], tB = pCoef[1], tC = pCoef[0];
+			const T tDisc = tB * tB - T(4) * tA * tC;
+			if (tDisc < T(0))
+			{
+				return 0;
+			}
+
+			if (tDisc == T(0))
+			{
+				pRoots[0] = -tB / (T(2) * tA);
+				return 1;
+			}
+
+			// Numerically stable form avoiding cancellation
+			const T tQ = -(tB + (tB < T(0) ? -sqrt(tDisc) : sqrt(tDisc))) / T(2);
+			T tX1 = tQ / tA;
+			T tX2 = (tQ != T(0) ? tC / tQ : -tX1);
+			pRoots[0] = (std::min)(tX1, tX2);
+			pRoots[1] = (std::max)(tX1, tX2);
+			return 2;
+		}
+
+		// Cauchy bound on the magnitude of all roots
+		T tBound = T(0);
+		for (int iIdx = 0; iIdx < iDegree; ++iIdx)
+		{
+			tBound = (std::max)(tBound, abs(pCoef[iIdx] / pCoef[iDegree]));
+		}
+		tBound += T(1);
+
+		// Critical points from the roots of the derivative
+		T pDerivCoef[PolyRealRootsMaxDegree];
+		for (int iIdx = 1; iIdx <= iDegree; ++iIdx)
+		{
+			pDerivCoef[iIdx - 1] = T(iIdx) * pCoef[iIdx];
+		}
+
+		T pBreak[PolyRealRootsMaxDegree + 1];
+		unsigned uBreakCount = 0;
+		pBreak[uBreakCount++] = -tBound;
+
+		T pCrit[PolyRealRootsMaxDegree];
+		const unsigned uCritCount = PolyRealRoots(pDerivCoef, iDegree - 1, pCrit);
+		for (unsigned uIdx = 0; uIdx < uCritCount; ++uIdx)
+		{
+			if (pCrit[uIdx] > -tBound && pCrit[uIdx] < tBound)
+			{
+				pBreak[uBreakCount++] = pCrit[uIdx];
+			}
+		}
+		pBreak[uBreakCount++] = tBound;
+
+		// Values below this tolerance count as zero, so that multiple roots at critical points are found.
+		T tCoefSum = T(0);
+		for (int iIdx = 0; iIdx <= iDegree; ++iIdx)
+		{
+			tCoefSum += abs(pCoef[iIdx]);
+		}
+
+		unsigned uRootCount = 0;
+		T tValA = _PolyValue(pCoef, iDegree, pBreak[0]);
+		for (unsigned uIdx = 0; uIdx + 1 < uBreakCount; ++uIdx)
+		{
+			const T tA = pBreak[uIdx];
+			const T tB = pBreak[uIdx + 1];
+			const T tValB = _PolyValue(pCoef, iDegree, tB);
+
+			const T tScale = tCoefSum * pow((std::max)(T(1), abs(tB)), T(iDegree));
+			const bool bZeroB = (abs(tValB) <= T(16) * std::numeric_limits<T>::epsilon() * tScale);
+
+			if (bZeroB)
+			{
+				if (uIdx + 2 < uBreakCount)
+				{
+					// Multiple root at a critical point
+					if (uRootCount == 0 || pRoots[uRootCount - 1] != tB)
+					{
+						pRoots[uRootCount++] = tB;
+					}
+				}
+			}
+			else if (tValA != T(0) && (tValA < T(0)) != (tValB < T(0)))
+			{
+				pRoots[uRootCount++] = _PolyBracketedRoot(pCoef, iDegree, tA, tB, tValA);
+			}
+
+			tValA = (bZeroB ? T(0) : tValB);
+		}
+
+		return uRootCount;
+	}
+
+	/// <summary>	Finds the real roots of the polynomial. See PolyRealRoots(const T*, int, T*). </summary>
+	template<typename T, const unsigned t_uDegree>
+	unsigned PolyRealRoots(const _SPolynomial<T, t_uDegree>& yA, T pRoots[t_uDegree])
+	{
+		static_assert(t_uDegree <= PolyRealRootsMaxDegree, "Polynomial degree too large for real root finder");
+		return PolyRealRoots(yA.vtParameter.DataPointer(), int(t_uDegree), pRoots);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Finds the real roots of an array of polynomials in parallel.
+	/// </summary>
+	///
+	/// <param name="pPoly">	  The polynomials. </param>
+	/// <param name="nCount">	  Number of polynomials. </param>
+	/// <param name="pRoots">	  [out] Array of nCount * t_uDegree roots. The roots of polynomial i start at
+	/// 						  pRoots[i * t_uDegree]. </param>
+	/// <param name="puRootCount"> [out] The number of roots found per polynomial. </param>
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	template<typename T, const unsigned t_uDegree>
+	void PolyRealRoots(const _SPolynomial<T, t_uDegree>* pPoly, size_t nCount, T* pRoots, unsigned* puRootCount)
+	{
+		Clu::Parallel::ForEachIndex(nCount, 1024, [&](size_t nIdx)
+		{
+			puRootCount[nIdx] = PolyRealRoots(pPoly[nIdx], pRoots + nIdx * t_uDegree);
+		});
+	}
+} // namespace Clu
@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Math
+// file:      Static.Polynomial.Avx2.cpp
+//
+// summary:   Implements the AVX2 kernels of the batched polynomial evaluation
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <immintrin.h>
+
+#include "Static.Polynomial.Avx2.h"
+
+namespace Clu
+{
+	namespace Avx2
+	{
+		namespace
+		{
+			// No fused multiply-add, which would round differently from the SSE2 and the scalar code.
+			struct SPolyFloat
+			{
+				using T = float;
+				using TReg = __m256;
+				static const size_t Width = 8;
+
+				static TReg Set1(float fX) { return _mm256_set1_ps(fX); }
+				static TReg Load(const float* pX) { return _mm256_loadu_ps(pX); }
+				static void Store(float* pX, TReg mX) { _mm256_storeu_ps(pX, mX); }
+				static TReg MulAdd(TReg mA, TReg mB, TReg mC) { return _mm256_add_ps(_mm256_mul_ps(mA, mB), mC); }
+			};
+
+			struct SPolyDouble
+			{
+				using T = double;
+				using TReg = __m256d;
+				static const size_t Width = 4;
+
+				static TReg Set1(double dX) { return _mm256_set1_pd(dX); }
+				static TReg Load(const double* pX) { return _mm256_loadu_pd(pX); }
+				static void Store(double* pX, TReg mX) { _mm256_storeu_pd(pX, mX); }
+				static TReg MulAdd(TReg mA, TReg mB, TReg mC) { return _mm256_add_pd(_mm256_mul_pd(mA, mB), mC); }
+			};
+
+			// The Horner scheme of Clu::_PolyEvaluateRange() with the degree as a run time value.
+			template<typename TSimd>
+			size_t _PolyEvaluate(const typename TSimd::T* pCoef, unsigned uDegree, const typename TSimd::T* pX
+				, typename TSimd::T* pY, typename TSimd::T* pDY, typename TSimd::T* pDDY, size_t nBegin, size_t nEnd)
+			{
+				using T = typename TSimd::T;
+				using TReg = typename TSimd::TReg;
+
+				const TReg tZero = TSimd::Set1(T(0));
+				const TReg tTwo = TSimd::Set1(T(2));
+
+				size_t nIdx = nBegin;
+				for (; nIdx + TSimd::Width <= nEnd; nIdx += TSimd::Width)
+				{
+					const TReg tX = TSimd::Load(pX + nIdx);
+
+					TReg tY = TSimd::Set1(pCoef[uDegree]);
+					TReg tDY = tZero;
+					TReg tDDY = tZero;
+
+					for (int iIdx = int(uDegree) - 1; iIdx >= 0; --iIdx)
+					{
+						if (pDDY)
+						{
+							tDDY = TSimd::MulAdd(tDDY, tX, tDY);
+						}
+
+						tDY = TSimd::MulAdd(tDY, tX, tY);
+						tY = TSimd::MulAdd(tY, tX, TSimd::Set1(pCoef[iIdx]));
+					}
+
+					TSimd::Store(pY + nIdx, tY);
+
+					if (pDY)
+					{
+						TSimd::Store(pDY + nIdx, tDY);
+					}
+
+					if (pDDY)
+					{
+						TSimd::Store(pDDY + nIdx, TSimd::MulAdd(tDDY, tTwo, tZero));
+					}
+				}
+
+				return nIdx;
+			}
+		} // namespace
+
+		size_t PolyEvaluate(const float* pCoef, unsigned uDegree, const float* pX, float* pY, float* pDY, float* pDDY, size_t nBegin, size_t nEnd)
+		{
+			return _PolyEvaluate<SPolyFloat>(pCoef, uDegree, pX, pY, pDY, pDDY, nBegin, nEnd);
+		}
+
+		size_t PolyEvaluate(const double* pCoef, unsigned uDegree, const double* pX, double* pY, double* pDY, double* pDDY, size_t nBegin, size_t nEnd)
+		{
+			return _PolyEvaluate<SPolyDouble>(pCoef, uDegree, pX, pY, pDY, pDDY, nBegin, nEnd);
+		}
+	} // namespace Avx2
+} // namespace Clu
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Math
+// file:      Static.Polynomial.Avx2.h
+//
+// summary:   Declares the AVX2 kernels of the batched polynomial evaluation
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+
+// The kernels are implemented in Static.Polynomial.Avx2.cpp, which the project compiles with /arch:AVX2. They may only
+// be called if Clu::Intrinsics::HasAvx2() returns true. The file must not include headers with inline functions or
+// templates that other files use as well, since the linker could keep the AVX2 copy of such a function.
+
+namespace Clu
+{
+	namespace Avx2
+	{
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Evaluates the polynomial with the coefficients pCoef[0 .. uDegree] and optionally its first and second
+		/// 	derivative at the values nBegin to nEnd, 8 floats or 4 doubles per step. The remaining values are left to
+		/// 	the caller.
+		/// </summary>
+		///
+		/// <returns> The index of the first value that was not evaluated. </returns>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		size_t PolyEvaluate(const float* pCoef, unsigned uDegree, const float* pX, float* pY, float* pDY, float* pDDY, size_t nBegin, size_t nEnd);
+		size_t PolyEvaluate(const double* pCoef, unsigned uDegree, const double* pX, double* pY, double* pDY, double* pDDY, size_t nBegin, size_t nEnd);
+	} // namespace Avx2
+} // namespace Clu
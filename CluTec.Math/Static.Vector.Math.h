@@ -271,25 +271,25 @@ namespace Clu
 	template<class T>
 	__CUDA_HDI__ _SVector1<T> Sqrt(const _SVector1<T>& vA)
 	{
-		_SVector1<T> vX; vX.SetElements(::sqrt(vA.x())); return vX;
+		_SVector1<T> vX; vX.SetElements(sqrt(vA.x())); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector2<T> Sqrt(const _SVector2<T>& vA)
 	{
-		_SVector2<T> vX; vX.SetElements(::sqrt(vA.x()), ::sqrt(vA.y())); return vX;
+		_SVector2<T> vX; vX.SetElements(sqrt(vA.x()), sqrt(vA.y())); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector3<T> Sqrt(const _SVector3<T>& vA)
 	{
-		_SVector3<T> vX; vX.SetElements(::sqrt(vA.x()), ::sqrt(vA.y()), ::sqrt(vA.z())); return vX;
+		_SVector3<T> vX; vX.SetElements(sqrt(vA.x()), sqrt(vA.y()), sqrt(vA.z())); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector4<T> Sqrt(const _SVector4<T>& vA)
 	{
-		_SVector4<T> vX; vX.SetElements(::sqrt(vA.x()), ::sqrt(vA.y()), ::sqrt(vA.z()), ::sqrt(vA.w())); return vX;
+		_SVector4<T> vX; vX.SetElements(sqrt(vA.x()), sqrt(vA.y()), sqrt(vA.z()), sqrt(vA.w())); return vX;
 	}
 
 	template<class T, uint32_t t_nDim>
@@ -298,7 +298,7 @@ namespace Clu
 		SVector<T, t_nDim> vX;
 		vX.ForEachElementPair(vA, [](T& xValue, const T& xValA)
 		{
-			xValue = ::sqrt(xValA);
+			xValue = sqrt(xValA);
 		});
 
 		return vX;
@@ -349,25 +349,25 @@ namespace Clu
 	template<class T>
 	__CUDA_HDI__ T Length(const _SVector2<T>& vA)
 	{
-		return ::sqrt(vA.x() * vA.x() + vA.y() * vA.y());
+		return sqrt(vA.x() * vA.x() + vA.y() * vA.y());
 	}
 
 	template<class T>
 	__CUDA_HDI__ T Length(const _SVector3<T>& vA)
 	{
-		return ::sqrt(vA.x() * vA.x() + vA.y() * vA.y() + vA.z() * vA.z());
+		return sqrt(vA.x() * vA.x() + vA.y() * vA.y() + vA.z() * vA.z());
 	}
 
 	template<class T>
 	__CUDA_HDI__ T Length(const _SVector4<T>& vA)
 	{
-		return ::sqrt(vA.x() * vA.x() + vA.y() * vA.y() + vA.z() * vA.z() + vA.w() * vA.w());
+		return sqrt(vA.x() * vA.x() + vA.y() * vA.y() + vA.z() * vA.z() + vA.w() * vA.w());
 	}
 
 	template<class T, uint32_t t_nDim>
 	__CUDA_HDI__ T Length(const _SVector<T, t_nDim>& vA)
 	{
-		return ::sqrt(Dot(vA, vA));
+		return sqrt(Dot(vA, vA));
 	}
 
 
@@ -514,25 +514,25 @@ namespace Clu
 	template<class T>
 	__CUDA_HDI__ _SVector1<T> Pow(const _SVector1<T>& vA, T tPow)
 	{
-		_SVector1<T> vX; vX.SetElements(::pow(vA.x(), tPow)); return vX;
+		_SVector1<T> vX; vX.SetElements(pow(vA.x(), tPow)); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector2<T> Pow(const _SVector2<T>& vA, T tPow)
 	{
-		_SVector2<T> vX; vX.SetElements(::pow(vA.x(), tPow), ::pow(vA.y(), tPow)); return vX;
+		_SVector2<T> vX; vX.SetElements(pow(vA.x(), tPow), pow(vA.y(), tPow)); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector3<T> Pow(const _SVector3<T>& vA, T tPow)
 	{
-		_SVector3<T> vX; vX.SetElements(::pow(vA.x(), tPow), ::pow(vA.y(), tPow), ::pow(vA.z(), tPow)); return vX;
+		_SVector3<T> vX; vX.SetElements(pow(vA.x(), tPow), pow(vA.y(), tPow), pow(vA.z(), tPow)); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector4<T> Pow(const _SVector4<T>& vA, T tPow)
 	{
-		_SVector4<T> vX; vX.SetElements(::pow(vA.x(), tPow), ::pow(vA.y(), tPow), ::pow(vA.z(), tPow), ::pow(vA.w(), tPow)); return vX;
+		_SVector4<T> vX; vX.SetElements(pow(vA.x(), tPow), pow(vA.y(), tPow), pow(vA.z(), tPow), pow(vA.w(), tPow)); return vX;
 	}
 
 	template<class T, uint32_t t_nDim>
@@ -542,7 +542,7 @@ namespace Clu
 
 		vX.ForEachElementPair(vA, [&tPow](T& xValue, const T& xValA)
 		{
-			xValue = ::pow(xValA, tPow);
+			xValue = pow(xValA, tPow);
 		});
 
 		return vX;
@@ -554,25 +554,25 @@ namespace Clu
 	template<class T>
 	__CUDA_HDI__ _SVector1<T> Floor(const _SVector1<T>& vA)
 	{
-		_SVector1<T> vX; vX.SetElements(T(::floor(vA.x()))); return vX;
+		_SVector1<T> vX; vX.SetElements(T(floor(vA.x()))); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector2<T> Floor(const _SVector2<T>& vA)
 	{
-		_SVector2<T> vX; vX.SetElements(T(::floor(vA.x())), T(::floor(vA.y()))); return vX;
+		_SVector2<T> vX; vX.SetElements(T(floor(vA.x())), T(floor(vA.y()))); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector3<T> Floor(const _SVector3<T>& vA)
 	{
-		_SVector3<T> vX; vX.SetElements(T(::floor(vA.x())), T(::floor(vA.y())), T(::floor(vA.z()))); return vX;
+		_SVector3<T> vX; vX.SetElements(T(floor(vA.x())), T(floor(vA.y())), T(floor(vA.z()))); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector4<T> Floor(const _SVector4<T>& vA)
 	{
-		_SVector4<T> vX; vX.SetElements(T(::floor(vA.x())), T(::floor(vA.y())), T(::floor(vA.z())), T(::floor(vA.w()))); return vX;
+		_SVector4<T> vX; vX.SetElements(T(floor(vA.x())), T(floor(vA.y())), T(floor(vA.z())), T(floor(vA.w()))); return vX;
 	}
 
 	template<class T, uint32_t t_nDim>
@@ -582,7 +582,7 @@ namespace Clu
 
 		vX.ForEachElementPair(vA, [](T& xValue, const T& xValA)
 		{
-			xValue = (T)::floor(xValA);
+			xValue = (T)floor(xValA);
 		});
 
 		return vX;
@@ -594,25 +594,25 @@ namespace Clu
 	template<class T>
 	__CUDA_HDI__ _SVector1<T> Ceil(const _SVector1<T>& vA)
 	{
-		_SVector1<T> vX; vX.SetElements(T(::ceil(vA.x()))); return vX;
+		_SVector1<T> vX; vX.SetElements(T(ceil(vA.x()))); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector2<T> Ceil(const _SVector2<T>& vA)
 	{
-		_SVector2<T> vX; vX.SetElements(T(::ceil(vA.x())), T(::ceil(vA.y()))); return vX;
+		_SVector2<T> vX; vX.SetElements(T(ceil(vA.x())), T(ceil(vA.y()))); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector3<T> Ceil(const _SVector3<T>& vA)
 	{
-		_SVector3<T> vX; vX.SetElements(T(::ceil(vA.x())), T(::ceil(vA.y())), T(::ceil(vA.z()))); return vX;
+		_SVector3<T> vX; vX.SetElements(T(ceil(vA.x())), T(ceil(vA.y())), T(ceil(vA.z()))); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector4<T> Ceil(const _SVector4<T>& vA)
 	{
-		_SVector4<T> vX; vX.SetElements(T(::ceil(vA.x())), T(::ceil(vA.y())), T(::ceil(vA.z())), T(::ceil(vA.w()))); return vX;
+		_SVector4<T> vX; vX.SetElements(T(ceil(vA.x())), T(ceil(vA.y())), T(ceil(vA.z())), T(ceil(vA.w()))); return vX;
 	}
 
 	template<class T, uint32_t t_nDim>
@@ -622,7 +622,7 @@ namespace Clu
 
 		vX.ForEachElementPair(vA, [](T& xValue, const T& xValA)
 		{
-			xValue = (T)::ceil(xValA);
+			xValue = (T)ceil(xValA);
 		});
 
 		return vX;
@@ -633,32 +633,32 @@ namespace Clu
 	template<class T>
 	__CUDA_HDI__ T Abs(const T& dA)
 	{
-		return T(::abs(dA));
+		return T(abs(dA));
 	}
 
 
 	template<class T>
 	__CUDA_HDI__ _SVector1<T> Abs(const _SVector1<T>& vA)
 	{
-		_SVector1<T> vX; vX.SetElements(T(::abs(vA.x()))); return vX;
+		_SVector1<T> vX; vX.SetElements(T(abs(vA.x()))); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector2<T> Abs(const _SVector2<T>& vA)
 	{
-		_SVector2<T> vX; vX.SetElements(T(::abs(vA.x())), T(::abs(vA.y()))); return vX;
+		_SVector2<T> vX; vX.SetElements(T(abs(vA.x())), T(abs(vA.y()))); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector3<T> Abs(const _SVector3<T>& vA)
 	{
-		_SVector3<T> vX; vX.SetElements(T(::abs(vA.x())), T(::abs(vA.y())), T(::abs(vA.z()))); return vX;
+		_SVector3<T> vX; vX.SetElements(T(abs(vA.x())), T(abs(vA.y())), T(abs(vA.z()))); return vX;
 	}
 
 	template<class T>
 	__CUDA_HDI__ _SVector4<T> Abs(const _SVector4<T>& vA)
 	{
-		_SVector4<T> vX; vX.SetElements(T(::abs(vA.x())), T(::abs(vA.y())), T(::abs(vA.z())), T(::abs(vA.w()))); return vX;
+		_SVector4<T> vX; vX.SetElements(T(abs(vA.x())), T(abs(vA.y())), T(abs(vA.z())), T(abs(vA.w()))); return vX;
 	}
 
 	template<class T, uint32_t t_nDim>
@@ -668,7 +668,7 @@ namespace Clu
 
 		vX.ForEachElementPair(vA, [](T& xValue, const T& xValA)
 		{
-			xValue = (T)::abs(xValA);
+			xValue = (T)abs(xValA);
 		});
 
 		return vX;
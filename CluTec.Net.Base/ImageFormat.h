@@ -42,6 +42,9 @@ namespace Clu
 			int Width;
 			int Height;
 
+			/// <summary>	Number of bytes between the starts of consecutive rows. Zero denotes tightly packed rows. </summary>
+			int RowPitch;
+
 			ImageFormat()
 			{
 				Clear();
@@ -52,6 +55,7 @@ namespace Clu
 			{
 				Width = xS->Width;
 				Height = xS->Height;
+				RowPitch = xS->RowPitch;
 			}
 
 			ImageFormat(int _nWidth, int _nHeight, PixelTypes ePT, DataTypes eDT)
@@ -59,6 +63,7 @@ namespace Clu
 			{
 				Width = _nWidth;
 				Height = _nHeight;
+				RowPitch = 0;
 			}
 
 			ImageFormat(int _nWidth, int _nHeight, ImageType^ xType)
@@ -66,6 +71,7 @@ namespace Clu
 			{
 				Width = _nWidth;
 				Height = _nHeight;
+				RowPitch = 0;
 			}
 
 			ImageFormat(const Clu::SImageFormat& xS)
@@ -73,6 +79,7 @@ namespace Clu
 			{
 				Width = xS.iWidth;
 				Height = xS.iHeight;
+				RowPitch = int(xS.RowPitch());
 			}
 
 			bool operator== (ImageFormat^ xType)
@@ -89,6 +96,7 @@ namespace Clu
 			{
 				Width = 0;
 				Height = 0;
+				RowPitch = 0;
 				ImageType::Clear();
 			}
 
@@ -99,6 +107,11 @@ namespace Clu
 
 			size_t ByteCount() 
 			{
+				if (RowPitch > 0)
+				{
+					return size_t(RowPitch) * size_t(Height);
+				}
+
 				return PixelCount() * BytesPerPixel();
 			}
 
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.System
+// file:      MappedFile.cpp
+//
+// summary:   Implements the platform independent parts of the direct file writer
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "CluTec.Base/Exception.h"
+
+namespace Clu
+{
+	void CDirectFileWriter::Append(const void* pData, size_t nByteCount)
+	{
+		if (!IsOpen())
+		{
+			throw CLU_EXCEPTION("File is not open for writing");
+		}
+
+		const unsigned char* pucData = (const unsigned char*)pData;
+		while (nByteCount > 0)
+		{
+			// Aligned whole blocks are written without copying them, if nothing is buffered before them.
+			if (m_nBuffered == 0 && nByteCount >= BlockSize && uintptr_t(pucData) % BlockSize == 0)
+			{
+				const size_t nBlockBytes = nByteCount - nByteCount % BlockSize;
+				_WriteBlocks(pucData, nBlockBytes);
+				pucData += nBlockBytes;
+				nByteCount -= nBlockBytes;
+				continue;
+			}
+
+			const size_t nCopy = std::min(BufferSize - m_nBuffered, nByteCount);
+			memcpy(m_pucBuffer + m_nBuffered, pucData, nCopy);
+			m_nBuffered += nCopy;
+			pucData += nCopy;
+			nByteCount -= nCopy;
+
+			if (m_nBuffered == BufferSize)
+			{
+				_Flush();
+			}
+		}
+	}
+
+	void CDirectFileWriter::Pad(size_t nAlignment)
+	{
+		if (!IsOpen())
+		{
+			throw CLU_EXCEPTION("File is not open for writing");
+		}
+
+		size_t nPad = size_t((nAlignment - Size() % nAlignment) % nAlignment);
+		while (nPad > 0)
+		{
+			const size_t nFill = std::min(BufferSize - m_nBuffered, nPad);
+			memset(m_pucBuffer + m_nBuffered, 0, nFill);
+			m_nBuffered += nFill;
+			nPad -= nFill;
+
+			if (m_nBuffered == BufferSize)
+			{
+				_Flush();
+			}
+		}
+	}
+
+	void CDirectFileWriter::Close()
+	{
+		if (!IsOpen())
+		{
+			return;
+		}
+
+		try
+		{
+			const uint64_t uSize = Size();
+
+			// Unbuffered writes need whole blocks. The padding is removed again when the file is truncated.
+			if (m_nBuffered > 0)
+			{
+				const size_t nBlockBytes = (m_nBuffered + BlockSize - 1) / BlockSize * BlockSize;
+				memset(m_pucBuffer + m_nBuffered, 0, nBlockBytes - m_nBuffered);
+				m_nBuffered = 0;
+				_WriteBlocks(m_pucBuffer, nBlockBytes);
+			}
+
+			_Finish(uSize);
+			m_uWritten = uSize;
+			_FreeBuffer();
+		}
+		catch (...)
+		{
+			_FreeBuffer();
+			throw;
+		}
+	}
+
+	void CDirectFileWriter::_Flush()
+	{
+		const size_t nByteCount = m_nBuffered;
+		m_nBuffered = 0;
+		_WriteBlocks(m_pucBuffer, nByteCount);
+	}
+
+} // namespace Clu
@@ -0,0 +1,155 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.System
+// file:      MappedFile.h
+//
+// summary:   Declares the memory mapped file and the direct file writer classes
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace Clu
+{
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Maps a whole file into memory for reading. The pages are mapped copy on write, so that writing to the
+	/// 	memory changes neither the file nor other mappings of it.
+	/// </summary>
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	class CMappedFile
+	{
+	public:
+		CMappedFile();
+		~CMappedFile();
+
+		CMappedFile(const CMappedFile&) = delete;
+		CMappedFile& operator= (const CMappedFile&) = delete;
+
+		void Open(const std::string& sFilename);
+		void Close();
+
+		bool IsOpen() const
+		{
+			return m_pucData != nullptr;
+		}
+
+		unsigned char* Data() const
+		{
+			return m_pucData;
+		}
+
+		uint64_t Size() const
+		{
+			return m_uSize;
+		}
+
+	protected:
+		unsigned char* m_pucData;
+		uint64_t m_uSize;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Writes a file sequentially. The data is collected in an aligned buffer and written in whole blocks,
+	/// 	bypassing the page cache (O_DIRECT, FILE_FLAG_NO_BUFFERING) where the file system allows it. Disk space
+	/// 	can be preallocated, which keeps the file contiguous. Close() truncates the file to the appended size.
+	/// </summary>
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	class CDirectFileWriter
+	{
+	public:
+		/// <summary>	The alignment of the buffer, of the file offsets and of the sizes of unbuffered writes. </summary>
+		static const size_t BlockSize = 4096;
+
+		/// <summary>	The size of the write buffer. </summary>
+		static const size_t BufferSize = size_t(8) << 20;
+
+	public:
+		CDirectFileWriter();
+		~CDirectFileWriter();
+
+		CDirectFileWriter(const CDirectFileWriter&) = delete;
+		CDirectFileWriter& operator= (const CDirectFileWriter&) = delete;
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Creates or truncates a file. </summary>
+		///
+		/// <param name="sFilename">		 	The file name. </param>
+		/// <param name="uPreallocateBytes">	The number of bytes to reserve on disk. Zero reserves nothing. </param>
+		/// <param name="bUnbuffered">		 	True to bypass the page cache if possible. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void Create(const std::string& sFilename, uint64_t uPreallocateBytes, bool bUnbuffered = true);
+
+		/// <summary>	Appends bytes to the file. </summary>
+		void Append(const void* pData, size_t nByteCount);
+
+		/// <summary>	Appends zero bytes up to the next multiple of nAlignment. </summary>
+		void Pad(size_t nAlignment);
+
+		/// <summary>	Writes the buffered data, truncates the file to the appended size and closes it. </summary>
+		void Close();
+
+		bool IsOpen() const;
+
+		/// <summary>	True if the writes bypass the page cache. </summary>
+		bool IsUnbuffered() const
+		{
+			return m_bUnbuffered;
+		}
+
+		/// <summary>	The number of bytes appended. </summary>
+		uint64_t Size() const
+		{
+			return m_uWritten + m_nBuffered;
+		}
+
+	protected:
+		void _AllocateBuffer();
+		void _FreeBuffer();
+
+		/// <summary>	Writes whole blocks at the end of the file. </summary>
+		void _WriteBlocks(const void* pData, size_t nByteCount);
+
+		void _Flush();
+
+		/// <summary>	Truncates the file to the given size and closes it. </summary>
+		void _Finish(uint64_t uSize);
+
+	protected:
+#ifdef WIN32
+		void* m_hFile;
+#else
+		int m_iFile;
+#endif
+
+		bool m_bUnbuffered;
+		unsigned char* m_pucBuffer;
+		size_t m_nBuffered;
+
+		/// <summary>	The number of bytes written to the file. </summary>
+		uint64_t m_uWritten;
+	};
+
+} // namespace Clu
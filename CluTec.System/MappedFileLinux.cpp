@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.System
+// file:      MappedFileLinux.cpp
+//
+// summary:   Implements the memory mapped file and the direct file writer for linux
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#ifndef WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CluTec.Types1/ExceptionTypes.h"
+#include "CluTec.Base/Exception.h"
+
+namespace Clu
+{
+	CMappedFile::CMappedFile()
+	{
+		m_pucData = nullptr;
+		m_uSize = 0;
+	}
+
+	CMappedFile::~CMappedFile()
+	{
+		Close();
+	}
+
+	void CMappedFile::Open(const std::string& sFilename)
+	{
+		Close();
+
+		const int iFile = open(sFilename.c_str(), O_RDONLY);
+		if (iFile < 0)
+		{
+			throw CLU_EXCEPT_TYPE(FileNotFound, CLU_S "File '" << sFilename.c_str() << "' could not be opened: " << strerror(errno));
+		}
+
+		struct stat xStat;
+		if (fstat(iFile, &xStat) != 0 || xStat.st_size <= 0)
+		{
+			close(iFile);
+			throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' is empty or cannot be accessed");
+		}
+
+		// The mapping stays valid after the file is closed.
+		void* pData = mmap(nullptr, size_t(xStat.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, iFile, 0);
+		close(iFile);
+
+		if (pData == MAP_FAILED)
+		{
+			throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' could not be mapped: " << strerror(errno));
+		}
+
+		m_pucData = (unsigned char*)pData;
+		m_uSize = uint64_t(xStat.st_size);
+	}
+
+	void CMappedFile::Close()
+	{
+		if (m_pucData != nullptr)
+		{
+			munmap(m_pucData, size_t(m_uSize));
+		}
+
+		m_pucData = nullptr;
+		m_uSize = 0;
+	}
+
+
+	CDirectFileWriter::CDirectFileWriter()
+	{
+		m_iFile = -1;
+		m_bUnbuffered = false;
+		m_pucBuffer = nullptr;
+		m_nBuffered = 0;
+		m_uWritten = 0;
+	}
+
+	CDirectFileWriter::~CDirectFileWriter()
+	{
+		try
+		{
+			Close();
+		}
+		catch (...)
+		{
+		}
+
+		if (m_iFile >= 0)
+		{
+			close(m_iFile);
+		}
+
+		_FreeBuffer();
+	}
+
+	bool CDirectFileWriter::IsOpen() const
+	{
+		return m_iFile >= 0;
+	}
+
+	void CDirectFileWriter::Create(const std::string& sFilename, uint64_t uPreallocateBytes, bool bUnbuffered)
+	{
+		Close();
+
+		const int iFlags = O_WRONLY | O_CREAT | O_TRUNC;
+
+		m_bUnbuffered = false;
+		if (bUnbuffered)
+		{
+			// File systems without direct I/O, like tmpfs, reject O_DIRECT. They are written through the page cache.
+			m_iFile = open(sFilename.c_str(), iFlags | O_DIRECT, 0644);
+			m_bUnbuffered = (m_iFile >= 0);
+		}
+
+		if (m_iFile < 0)
+		{
+			m_iFile = open(sFilename.c_str(), iFlags, 0644);
+		}
+
+		if (m_iFile < 0)
+		{
+			throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' could not be created: " << strerror(errno));
+		}
+
+		// Preallocation only keeps the file contiguous, so file systems that do not support it are fine.
+		if (uPreallocateBytes > 0)
+		{
+			fallocate(m_iFile, 0, 0, off_t(uPreallocateBytes));
+		}
+
+		m_nBuffered = 0;
+		m_uWritten = 0;
+		_AllocateBuffer();
+	}
+
+	void CDirectFileWriter::_AllocateBuffer()
+	{
+		if (m_pucBuffer == nullptr)
+		{
+			void* pData = nullptr;
+			if (posix_memalign(&pData, BlockSize, BufferSize) != 0)
+			{
+				throw CLU_EXCEPTION("Out of memory allocating the file write buffer");
+			}
+
+			m_pucBuffer = (unsigned char*)pData;
+		}
+	}
+
+	void CDirectFileWriter::_FreeBuffer()
+	{
+		free(m_pucBuffer);
+		m_pucBuffer = nullptr;
+	}
+
+	void CDirectFileWriter::_WriteBlocks(const void* pData, size_t nByteCount)
+	{
+		const unsigned char* pucData = (const unsigned char*)pData;
+		while (nByteCount > 0)
+		{
+			const ssize_t iWritten = pwrite(m_iFile, pucData, nByteCount, off_t(m_uWritten));
+			if (iWritten < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				throw CLU_EXCEPTION(CLU_S "Error writing file: " << strerror(errno));
+			}
+
+			pucData += iWritten;
+			nByteCount -= size_t(iWritten);
+			m_uWritten += uint64_t(iWritten);
+		}
+	}
+
+	void CDirectFileWriter::_Finish(uint64_t uSize)
+	{
+		const int iFile = m_iFile;
+		m_iFile = -1;
+
+		const bool bTruncated = (ftruncate(iFile, off_t(uSize)) == 0);
+		const bool bClosed = (close(iFile) == 0);
+
+		if (!bTruncated || !bClosed)
+		{
+			throw CLU_EXCEPTION(CLU_S "Error closing file: " << strerror(errno));
+		}
+	}
+
+} // namespace Clu
+
+#endif // !WIN32
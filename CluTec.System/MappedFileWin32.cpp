@@ -0,0 +1,217 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.System
+// file:      MappedFileWin32.cpp
+//
+// summary:   Implements the memory mapped file and the direct file writer for windows
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#ifdef WIN32
+
+#include <malloc.h>
+#include <algorithm>
+#include <windows.h>
+
+#include "CluTec.Types1/ExceptionTypes.h"
+#include "CluTec.Base/Exception.h"
+
+namespace Clu
+{
+	CMappedFile::CMappedFile()
+	{
+		m_pucData = nullptr;
+		m_uSize = 0;
+	}
+
+	CMappedFile::~CMappedFile()
+	{
+		Close();
+	}
+
+	void CMappedFile::Open(const std::string& sFilename)
+	{
+		Close();
+
+		HANDLE hFile = CreateFileA(sFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE)
+		{
+			throw CLU_EXCEPT_TYPE(FileNotFound, CLU_S "File '" << sFilename.c_str() << "' could not be opened");
+		}
+
+		LARGE_INTEGER xSize;
+		if (!GetFileSizeEx(hFile, &xSize) || xSize.QuadPart <= 0)
+		{
+			CloseHandle(hFile);
+			throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' is empty or cannot be accessed");
+		}
+
+		// The view keeps the mapping and the file open after their handles are closed.
+		HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		void* pData = (hMapping != nullptr ? MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0) : nullptr);
+
+		if (hMapping != nullptr)
+		{
+			CloseHandle(hMapping);
+		}
+
+		CloseHandle(hFile);
+
+		if (pData == nullptr)
+		{
+			throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' could not be mapped");
+		}
+
+		m_pucData = (unsigned char*)pData;
+		m_uSize = uint64_t(xSize.QuadPart);
+	}
+
+	void CMappedFile::Close()
+	{
+		if (m_pucData != nullptr)
+		{
+			UnmapViewOfFile(m_pucData);
+		}
+
+		m_pucData = nullptr;
+		m_uSize = 0;
+	}
+
+
+	CDirectFileWriter::CDirectFileWriter()
+	{
+		m_hFile = INVALID_HANDLE_VALUE;
+		m_bUnbuffered = false;
+		m_pucBuffer = nullptr;
+		m_nBuffered = 0;
+		m_uWritten = 0;
+	}
+
+	CDirectFileWriter::~CDirectFileWriter()
+	{
+		try
+		{
+			Close();
+		}
+		catch (...)
+		{
+		}
+
+		if (m_hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_hFile);
+		}
+
+		_FreeBuffer();
+	}
+
+	bool CDirectFileWriter::IsOpen() const
+	{
+		return m_hFile != INVALID_HANDLE_VALUE;
+	}
+
+	void CDirectFileWriter::Create(const std::string& sFilename, uint64_t uPreallocateBytes, bool bUnbuffered)
+	{
+		Close();
+
+		const DWORD uFlags = FILE_ATTRIBUTE_NORMAL | (bUnbuffered ? FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH : 0);
+		m_hFile = CreateFileA(sFilename.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, uFlags, nullptr);
+		if (m_hFile == INVALID_HANDLE_VALUE)
+		{
+			throw CLU_EXCEPTION(CLU_S "File '" << sFilename.c_str() << "' could not be created");
+		}
+
+		m_bUnbuffered = bUnbuffered;
+
+		// Preallocation only keeps the file contiguous, so file systems that do not support it are fine.
+		if (uPreallocateBytes > 0)
+		{
+			FILE_ALLOCATION_INFO xInfo;
+			xInfo.AllocationSize.QuadPart = LONGLONG(uPreallocateBytes);
+			SetFileInformationByHandle(m_hFile, FileAllocationInfo, &xInfo, sizeof(xInfo));
+		}
+
+		m_nBuffered = 0;
+		m_uWritten = 0;
+		_AllocateBuffer();
+	}
+
+	void CDirectFileWriter::_AllocateBuffer()
+	{
+		if (m_pucBuffer == nullptr)
+		{
+			m_pucBuffer = (unsigned char*)_aligned_malloc(BufferSize, BlockSize);
+			if (m_pucBuffer == nullptr)
+			{
+				throw CLU_EXCEPTION("Out of memory allocating the file write buffer");
+			}
+		}
+	}
+
+	void CDirectFileWriter::_FreeBuffer()
+	{
+		_aligned_free(m_pucBuffer);
+		m_pucBuffer = nullptr;
+	}
+
+	void CDirectFileWriter::_WriteBlocks(const void* pData, size_t nByteCount)
+	{
+		const unsigned char* pucData = (const unsigned char*)pData;
+		while (nByteCount > 0)
+		{
+			// Keeps the chunks a multiple of the block size.
+			const DWORD uChunk = DWORD(std::min<size_t>(nByteCount, size_t(1) << 30));
+
+			DWORD uWritten = 0;
+			if (!WriteFile(m_hFile, pucData, uChunk, &uWritten, nullptr) || uWritten == 0)
+			{
+				throw CLU_EXCEPTION(CLU_S "Error writing file: system error " << uint32_t(GetLastError()));
+			}
+
+			pucData += uWritten;
+			nByteCount -= size_t(uWritten);
+			m_uWritten += uint64_t(uWritten);
+		}
+	}
+
+	void CDirectFileWriter::_Finish(uint64_t uSize)
+	{
+		HANDLE hFile = m_hFile;
+		m_hFile = INVALID_HANDLE_VALUE;
+
+		LARGE_INTEGER xPos;
+		xPos.QuadPart = LONGLONG(uSize);
+
+		const bool bTruncated = (SetFilePointerEx(hFile, xPos, nullptr, FILE_BEGIN) && SetEndOfFile(hFile));
+		const bool bClosed = (CloseHandle(hFile) != FALSE);
+
+		if (!bTruncated || !bClosed)
+		{
+			throw CLU_EXCEPTION(CLU_S "Error closing file: system error " << uint32_t(GetLastError()));
+		}
+	}
+
+} // namespace Clu
+
+#endif // WIN32
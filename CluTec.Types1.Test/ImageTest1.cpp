@@ -0,0 +1,284 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Types1.Test
+// file:      ImageTest1.cpp
+//
+// summary:   Implements the image memory test 1 class
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "CluTec.Types1/IException.h"
+#include "CluTec.Types1/IImage.h"
+#include "CluTec.Types1/ILayerImage.h"
+#include "CluTec.Types1/IImageMemoryPool.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace CluTecTypes1Test
+{
+	TEST_CLASS(ImageTest1)
+	{
+	public:
+		static unsigned char Pixel(const Clu::CIImage& imgImage, int iX, int iY)
+		{
+			const unsigned char* pData = (const unsigned char*)imgImage.DataPointer();
+			return pData[imgImage.Format().GetByteOffset(iX, iY)];
+		}
+
+		static unsigned char LayerPixel(const Clu::CILayerImage& imgImage, size_t nLayer, int iX, int iY)
+		{
+			const unsigned char* pData = (const unsigned char*)imgImage.DataPointer(nLayer);
+			return pData[size_t(iY) * imgImage.LayerRowPitch() + size_t(iX)];
+		}
+
+		static void Fill(Clu::CIImage& imgImage)
+		{
+			const Clu::SImageFormat& xFormat = imgImage.Format();
+			unsigned char* pData = (unsigned char*)imgImage.DataPointer();
+
+			for (int iY = 0; iY < xFormat.iHeight; ++iY)
+			{
+				for (int iX = 0; iX < xFormat.iWidth; ++iX)
+				{
+					pData[xFormat.GetByteOffset(iX, iY)] = (unsigned char)(iY * 16 + iX);
+				}
+			}
+		}
+
+		static void Fill(Clu::CILayerImage& imgImage)
+		{
+			for (size_t nLayer = 0; nLayer < imgImage.LayerCount(); ++nLayer)
+			{
+				unsigned char* pData = (unsigned char*)imgImage.DataPointer(nLayer);
+				for (int iY = 0; iY < imgImage.Height(); ++iY)
+				{
+					for (int iX = 0; iX < imgImage.Width(); ++iX)
+					{
+						pData[size_t(iY) * imgImage.LayerRowPitch() + size_t(iX)] = (unsigned char)(nLayer * 64 + iY * 8 + iX);
+					}
+				}
+			}
+		}
+
+	public:
+
+		TEST_METHOD(CopyOnWrite)
+		{
+			Clu::CIImage imgA(Clu::SImageFormat(16, 8, Clu::EPixelType::Lum, Clu::EDataType::UInt8));
+			Fill(imgA);
+			Assert::IsTrue(imgA.IsUnique(), L"New image is not unique");
+
+			Clu::CIImage imgB = imgA.Copy();
+			const Clu::CIImage& imgConstA = imgA;
+			const Clu::CIImage& imgConstB = imgB;
+			Assert::IsTrue(imgConstA.DataPointer() == imgConstB.DataPointer(), L"Copy does not share the memory");
+			Assert::IsTrue(!imgA.IsUnique() && !imgB.IsUnique(), L"Shared images are unique");
+
+			((unsigned char*)imgB.DataPointer())[0] = 200;
+			Assert::IsTrue(imgConstA.DataPointer() != imgConstB.DataPointer(), L"Write did not copy the memory");
+			Assert::IsTrue(Pixel(imgA, 0, 0) == 0, L"Write to the copy changed the original");
+			Assert::IsTrue(Pixel(imgB, 0, 0) == 200 && Pixel(imgB, 5, 3) == 53, L"Copy has wrong content");
+			Assert::IsTrue(imgA.IsUnique() && imgB.IsUnique(), L"Images are not unique after the write");
+
+			Clu::CIImage imgC = imgA.Copy();
+			imgC.Detach();
+			Assert::IsTrue(imgC.IsUnique() && imgA.IsUnique(), L"Detach did not give the image its own memory");
+		}
+
+		TEST_METHOD(WritableView)
+		{
+			Clu::CIImage imgA(Clu::SImageFormat(16, 8, Clu::EPixelType::Lum, Clu::EDataType::UInt8));
+			Fill(imgA);
+
+			Clu::CIImage imgView = imgA.CropView(2, 3, 4, 4);
+			Assert::IsTrue(imgView.IsView() && !imgView.IsDataOwner(), L"Crop view is no view");
+			Assert::IsTrue(Pixel(imgView, 0, 0) == 50, L"View has wrong content");
+
+			((unsigned char*)imgView.DataPointer())[0] = 222;
+			Assert::IsTrue(Pixel(imgA, 2, 3) == 222, L"Write to the view does not show in the parent");
+
+			// The parent memory is viewed, so copies of the parent are independent of it right away.
+			Clu::CIImage imgB = imgA.Copy();
+			((unsigned char*)imgView.DataPointer())[0] = 111;
+			Assert::IsTrue(Pixel(imgB, 2, 3) == 222, L"Write to the view shows in a copy of the parent");
+			Assert::IsTrue(Pixel(imgA, 2, 3) == 111, L"Write to the view does not show in the parent");
+
+			((unsigned char*)imgA.DataPointer())[imgA.Format().GetByteOffset(3, 3)] = 99;
+			Assert::IsTrue(Pixel(imgView, 1, 0) == 99, L"Write to the parent does not show in the view");
+		}
+
+		TEST_METHOD(ViewOutlivesParentMemory)
+		{
+			Clu::CIImage imgA(Clu::SImageFormat(16, 8, Clu::EPixelType::Lum, Clu::EDataType::UInt8));
+			Fill(imgA);
+
+			Clu::CIImage imgView = imgA.CropView(1, 1, 8, 4);
+			imgA.Create(Clu::SImageFormat(64, 64, Clu::EPixelType::RGBA, Clu::EDataType::Single));
+			memset(imgA.DataPointer(), 0xFF, imgA.ByteCount());
+			Assert::IsTrue(Pixel(imgView, 0, 0) == 17 && Pixel(imgView, 7, 3) == 72, L"View lost its memory when the parent was created anew");
+
+			imgA.Destroy();
+			Assert::IsTrue(Pixel(imgView, 2, 2) == 51, L"View lost its memory when the parent was destroyed");
+
+			// A copy of a view is a view of the same memory.
+			Clu::CIImage imgCopy = imgView;
+			Assert::IsTrue(Pixel(imgCopy, 2, 2) == 51, L"Copy of a view has wrong content");
+		}
+
+		TEST_METHOD(ReadOnlyView)
+		{
+			Clu::CIImage imgA(Clu::SImageFormat(16, 8, Clu::EPixelType::Lum, Clu::EDataType::UInt8));
+			Fill(imgA);
+			Clu::CIImage imgB = imgA.Copy();
+
+			const Clu::CIImage& imgConstA = imgA;
+			Clu::CIImage imgView = imgConstA.CropView(2, 3, 4, 4);
+			Assert::IsTrue(imgView.IsView(), L"Read-only crop view is no view");
+			Assert::IsTrue(((const Clu::CIImage&)imgB).DataPointer() == imgConstA.DataPointer(), L"Read-only view changed the parent");
+
+			// Writing to a read-only view copies its region and leaves the parent and its copies unchanged.
+			((unsigned char*)imgView.DataPointer())[0] = 222;
+			Assert::IsTrue(Pixel(imgView, 0, 0) == 222 && Pixel(imgView, 1, 1) == 67, L"Read-only view has wrong content");
+			Assert::IsTrue(Pixel(imgA, 2, 3) == 50 && Pixel(imgB, 2, 3) == 50, L"Write to a read-only view changed the parent");
+			Assert::IsTrue(!imgView.IsView() && imgView.IsUnique(), L"Written read-only view does not own its memory");
+
+			// Read-only views of one image can be taken concurrently.
+			std::vector<std::thread> vecThread;
+			std::vector<int> vecSum(4, 0);
+			for (size_t nThread = 0; nThread < vecSum.size(); ++nThread)
+			{
+				vecThread.emplace_back([&imgConstA, &vecSum, nThread]()
+				{
+					for (int iIdx = 0; iIdx < 1000; ++iIdx)
+					{
+						Clu::CIImage imgPart = imgConstA.CropView(int(nThread), 0, 4, 4);
+						vecSum[nThread] += Pixel(imgPart, 0, 0);
+					}
+				});
+			}
+
+			for (auto& xThread : vecThread)
+			{
+				xThread.join();
+			}
+
+			for (size_t nThread = 0; nThread < vecSum.size(); ++nThread)
+			{
+				Assert::IsTrue(vecSum[nThread] == int(nThread) * 1000, L"Concurrent read-only views have wrong content");
+			}
+		}
+
+		TEST_METHOD(PitchedCreate)
+		{
+			const int iPitch = 16 * 3 + 42;
+			Clu::CIImage imgA(Clu::SImageFormat(16, 8, Clu::EPixelType::RGB, Clu::EDataType::UInt8, iPitch));
+			Assert::IsTrue(imgA.RowPitch() == size_t(iPitch), L"Image does not have the given row pitch");
+			Assert::IsTrue(imgA.ByteCount() == size_t(iPitch) * 8, L"Image has wrong byte count");
+			Fill(imgA);
+
+			// The copy on write copy keeps the layout and the pixels.
+			Clu::CIImage imgB = imgA.Copy();
+			((unsigned char*)imgB.DataPointer())[1] = 7;
+			Assert::IsTrue(imgB.RowPitch() == size_t(iPitch), L"Copy has a different row pitch");
+			Assert::IsTrue(Pixel(imgB, 5, 7) == Pixel(imgA, 5, 7), L"Copy of a pitched image has wrong content");
+
+			// Rows are packed unless aligned rows are asked for.
+			const Clu::SImageFormat xPacked(17, 8, Clu::EPixelType::RGB, Clu::EDataType::UInt8);
+			Clu::CIImage imgPacked(xPacked);
+			Assert::IsTrue(imgPacked.RowPitch() == 17 * 3, L"Image rows are not packed");
+
+			Clu::CIImage imgAligned(Clu::SImageFormat(xPacked.AlignedLayout()));
+			Assert::IsTrue(imgAligned.RowPitch() % Clu::SImageFormat::RowAlignment == 0, L"Image rows are not aligned");
+
+			Clu::CILayerImage imgLayerPacked(xPacked);
+			Assert::IsTrue(imgLayerPacked.LayerRowPitch() == 17, L"Layer rows are not packed");
+
+			Clu::CILayerImage imgLayerAligned;
+			imgLayerAligned.Create(xPacked, Clu::SImageFormat::AlignedRowPitch(17, 1));
+			Assert::IsTrue(imgLayerAligned.LayerRowPitch() == Clu::SImageFormat::RowAlignment, L"Layer rows are not aligned");
+
+			bool bThrown = false;
+			try
+			{
+				imgA.Create(Clu::SImageFormat(16, 8, Clu::EPixelType::RGB, Clu::EDataType::UInt8, 16 * 3 - 3));
+			}
+			catch (Clu::CIException&)
+			{
+				bThrown = true;
+			}
+			Assert::IsTrue(bThrown, L"Row pitch below the row size was accepted");
+		}
+
+		TEST_METHOD(MemoryPool)
+		{
+			const Clu::SImageFormat xFormat(640, 480, Clu::EPixelType::RGBA, Clu::EDataType::UInt8);
+
+			Clu::CIImageMemoryPool::Enable(true);
+			Clu::CIImageMemoryPool::ResetStats();
+			{
+				Clu::CIImage imgA(xFormat);
+				Clu::CIImage imgB = imgA.Copy();
+			}
+			Assert::IsTrue(Clu::CIImageMemoryPool::Stats().nReturnCount == 1, L"Shared memory was not returned exactly once");
+
+			{
+				Clu::CIImage imgA(xFormat);
+			}
+			Assert::IsTrue(Clu::CIImageMemoryPool::Stats().nHitCount == 1, L"Returned memory was not reused");
+
+			Clu::CIImageMemoryPool::Trim();
+			Assert::IsTrue(Clu::CIImageMemoryPool::Stats().nCachedBufferCount == 0, L"Trim did not free the pool");
+			Clu::CIImageMemoryPool::Enable(false);
+		}
+
+		TEST_METHOD(LayerImageCopyAndViews)
+		{
+			Clu::CILayerImage imgA(Clu::SImageFormat(8, 6, Clu::EPixelType::RGB, Clu::EDataType::UInt8));
+			Fill(imgA);
+
+			Clu::CILayerImage imgB = imgA.Copy();
+			Assert::IsTrue(!imgA.IsUnique(), L"Layer image copy does not share the memory");
+			((unsigned char*)imgB.DataPointer(1))[0] = 200;
+			Assert::IsTrue(LayerPixel(imgA, 1, 0, 0) == 64 && LayerPixel(imgB, 1, 0, 0) == 200, L"Write to the copy changed the original");
+			Assert::IsTrue(LayerPixel(imgB, 2, 3, 2) == 128 + 19, L"Layer image copy has wrong content");
+
+			Clu::CILayerImage imgView = imgA.CropView(1, 2, 4, 3);
+			((unsigned char*)imgView.DataPointer(2))[0] = 222;
+			Assert::IsTrue(LayerPixel(imgA, 2, 1, 2) == 222, L"Write to the layer view does not show in the parent");
+
+			const Clu::CILayerImage& imgConstA = imgA;
+			Clu::CILayerImage imgReadOnly = imgConstA.CropView(1, 2, 4, 3);
+			((unsigned char*)imgReadOnly.DataPointer(0))[0] = 1;
+			Assert::IsTrue(LayerPixel(imgA, 0, 1, 2) == 17, L"Write to a read-only layer view changed the parent");
+
+			imgA.Create(Clu::SImageFormat(32, 32, Clu::EPixelType::Lum, Clu::EDataType::UInt16));
+			memset(imgA.DataPointer(0), 0xFF, imgA.TotalByteCount());
+			Assert::IsTrue(LayerPixel(imgView, 0, 0, 0) == 17 && LayerPixel(imgView, 2, 0, 0) == 222
+				, L"Layer view lost its memory when the parent was created anew");
+		}
+	};
+}
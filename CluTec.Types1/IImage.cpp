@@ -28,6 +28,9 @@
 #include "IImage.h"
 #include "IImageImpl.h"
 #include "ImageIntern.h"
+#include "ILayerImage.h"
+#include "ILayerImageImpl.h"
+#include "LayerImage.h"
 
 
 #include "IException.h"
@@ -169,6 +172,42 @@ namespace Clu
 		CLU_CATCH_RETHROW_ALL("Error obtaining data owner flag")
 	}
 
+	bool CIImage::IsView() const
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			return REF->IsView();
+		}
+		CLU_CATCH_RETHROW_ALL("Error obtaining view flag")
+	}
+
+	bool CIImage::IsUnique() const
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			return REF->IsUnique();
+		}
+		CLU_CATCH_RETHROW_ALL("Error obtaining unique flag")
+	}
+
+	void CIImage::Detach()
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			INTERN.Detach();
+		}
+		CLU_CATCH_RETHROW_ALL("Error detaching image")
+	}
+
 	CIImage CIImage::Copy() const
 	{
 		try
@@ -198,6 +237,48 @@ namespace Clu
 		CLU_CATCH_RETHROW_ALL("Error cropping image")
 	}
 
+	CIImage CIImage::CropView(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop)
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			CIImage xImg;
+			INTERN_(xImg).ViewFrom(REF, nX, nY, nWidth, nHeight, bYOriginAtTop);
+			return xImg;
+		}
+		CLU_CATCH_RETHROW_ALL("Error creating image view")
+	}
+
+	CIImage CIImage::CropView(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop) const
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			CIImage xImg;
+			INTERN_(xImg).ViewFrom(REF, nX, nY, nWidth, nHeight, bYOriginAtTop, true);
+			return xImg;
+		}
+		CLU_CATCH_RETHROW_ALL("Error creating image view")
+	}
+
+	CILayerImage CIImage::LayerView()
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			CILayerImage xImg;
+			INTERN_(xImg).ViewFrom(INTERN);
+			return xImg;
+		}
+		CLU_CATCH_RETHROW_ALL("Error creating layer image view")
+	}
+
 	void CIImage::Insert(const CIImage& xImage, int nX, int nY, bool bYOriginAtTop)
 	{
 		try
@@ -378,6 +459,18 @@ namespace Clu
 		CLU_CATCH_RETHROW_ALL("Error getting byte count")
 	}
 
+	size_t CIImage::RowPitch() const
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			return REF->RowPitch();
+		}
+		CLU_CATCH_RETHROW_ALL("Error getting row pitch")
+	}
+
 
 	void* CIImage::DataPointer()
 	{
@@ -398,7 +491,9 @@ namespace Clu
 			if (!IsValid())
 				throw CLU_EXCEPTION("Invalid image instance");
 
-			return REF->DataPointer();
+			// Use the const access, which does not copy shared pixel memory.
+			const CImageIntern& xImage = INTERN;
+			return xImage.DataPointer();
 		}
 		CLU_CATCH_RETHROW_ALL("Error getting data pointer")
 	}
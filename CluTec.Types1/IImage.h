@@ -38,6 +38,7 @@
 namespace Clu
 {
 	class CIImageImpl;
+	class CILayerImage;
 
 	class CLU_TYPES1_API CIImage
 	{
@@ -46,6 +47,8 @@ namespace Clu
 	private:
 		CIImageImpl *m_pImpl;
 
+		friend class CILayerImage;
+
 	public:
 		CIImage();
 		CIImage(CIImage&& xImage);
@@ -62,6 +65,16 @@ namespace Clu
 		bool IsValidRef() const;
 		bool IsValid() const;
 		bool IsDataOwner() const;
+		bool IsView() const;
+
+		/// <summary>	True if this image owns its pixel memory and no other image shares it. </summary>
+		bool IsUnique() const;
+
+		/// <summary>
+		/// 	Gives this image its own copy of the pixel memory, unless it is unique already. Copies of an image share
+		/// 	the pixel memory until the first call of the non-const DataPointer() on one of them.
+		/// </summary>
+		void Detach();
 
 		template<typename TPixel>
 		bool IsOfType()
@@ -71,6 +84,25 @@ namespace Clu
 
 		CIImage Copy() const;
 		CIImage Crop(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop = true) const;
+
+		/// <summary>
+		/// 	Returns an image that refers to the given region of this image without copying it. Writing to the view
+		/// 	writes to this image. The view keeps the memory of this image alive.
+		/// </summary>
+		CIImage CropView(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop = true);
+
+		/// <summary>
+		/// 	Returns a read-only view of the given region, which does not change this image. Several threads may take
+		/// 	such views of the same image. Writing to the view gives it its own copy of the region first.
+		/// </summary>
+		CIImage CropView(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop = true) const;
+
+		/// <summary>
+		/// 	Returns a single layer image that refers to the memory of this single channel image without copying it.
+		/// 	Writing to the view writes to this image. The view keeps the memory of this image alive.
+		/// </summary>
+		CILayerImage LayerView();
+
 		void Insert(const CIImage& xImage, int nX, int nY, bool bYOriginAtTop = true);
 
 		void Create(const SImageFormat& xStruct);
@@ -92,6 +124,7 @@ namespace Clu
 		size_t BytesPerPixel() const;
 		size_t PixelCount() const;
 		size_t ByteCount() const;
+		size_t RowPitch() const;
 
 		void* DataPointer();
 		const void* DataPointer() const;
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Types1.rtl
+// file:      IImageMemoryPool.cpp
+//
+// summary:   Implements the image memory pool interface
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "stdafx.h"
+#include "IImageMemoryPool.h"
+#include "ImageMemoryPool.h"
+#include "IException.h"
+
+#define CLU_EXCEPTION(theMsg) \
+	Clu::CIException(theMsg, __FILE__, __FUNCTION__, __LINE__)
+
+#define CLU_CATCH_RETHROW_ALL(theMsg) \
+	catch (std::exception& xEx) \
+		{ \
+		throw Clu::CIException(Clu::CIString(theMsg) << " : " << xEx.what(), __FILE__, __FUNCTION__, __LINE__); \
+		} \
+	catch (Clu::CIException& xEx) \
+		{ \
+		throw Clu::CIException(Clu::CIString(theMsg), __FILE__, __FUNCTION__, __LINE__, std::move(xEx)); \
+		} 
+
+namespace Clu
+{
+	void CIImageMemoryPool::Enable(bool bEnable)
+	{
+		CImageMemoryPool::Global().Enable(bEnable);
+	}
+
+	bool CIImageMemoryPool::IsEnabled()
+	{
+		return CImageMemoryPool::Global().IsEnabled();
+	}
+
+	void CIImageMemoryPool::SetMaxCachedByteCount(size_t nByteCount)
+	{
+		CImageMemoryPool::Global().SetMaxCachedByteCount(nByteCount);
+	}
+
+	size_t CIImageMemoryPool::MaxCachedByteCount()
+	{
+		return CImageMemoryPool::Global().MaxCachedByteCount();
+	}
+
+	void CIImageMemoryPool::PreWarm(const SImageFormat& xFormat, size_t nBufferCount, bool bLayered)
+	{
+		try
+		{
+			if (!xFormat.IsValid())
+				throw CLU_EXCEPTION("Invalid image format");
+
+			// Same layouts as used by CImageIntern::Create() and CLayerImage::Create(), where the layers have packed rows
+			size_t nByteCount;
+			if (bLayered)
+			{
+				nByteCount = xFormat.RowByteCount() * size_t(xFormat.iHeight);
+			}
+			else
+			{
+				nByteCount = xFormat.ByteCount();
+			}
+
+			CImageMemoryPool::Global().PreWarm(nByteCount, nBufferCount);
+		}
+		CLU_CATCH_RETHROW_ALL("Error pre-warming image memory pool")
+	}
+
+	void CIImageMemoryPool::Trim()
+	{
+		CImageMemoryPool::Global().Trim();
+	}
+
+	SImageMemoryPoolStats CIImageMemoryPool::Stats()
+	{
+		return CImageMemoryPool::Global().Stats();
+	}
+
+	void CIImageMemoryPool::ResetStats()
+	{
+		CImageMemoryPool::Global().ResetStats();
+	}
+
+} // namespace Clu
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Types1.rtl
+// file:      IImageMemoryPool.h
+//
+// summary:   Declares the image memory pool interface
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+
+#ifdef CLU_INTEROP_EXPORTS
+#define CLU_TYPES1_API __declspec(dllexport)
+#else
+#define CLU_TYPES1_API __declspec(dllimport)
+#endif
+
+#include "ImageFormat.h"
+
+namespace Clu
+{
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>	Usage statistics of the image memory pool. </summary>
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	struct SImageMemoryPoolStats
+	{
+		/// <summary>	Allocations served from a cached buffer. </summary>
+		size_t nHitCount;
+		/// <summary>	Allocations that had to allocate new memory while the pool was enabled. </summary>
+		size_t nMissCount;
+		/// <summary>	Buffers returned to the pool for reuse. </summary>
+		size_t nReturnCount;
+		/// <summary>	Buffers freed instead of cached, because the pool was full. </summary>
+		size_t nDiscardCount;
+
+		size_t nCachedBufferCount;
+		size_t nCachedByteCount;
+		size_t nPeakCachedByteCount;
+		size_t nSizeClassCount;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Controls the process wide pool that recycles the pixel memory of CIImage and CILayerImage. The pool is
+	/// 	disabled by default. Once enabled, memory of destroyed images is kept in per size free lists and handed
+	/// 	out again to images of the same byte size, instead of being returned to the system.
+	/// </summary>
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	class CLU_TYPES1_API CIImageMemoryPool
+	{
+	public:
+		static void Enable(bool bEnable);
+		static bool IsEnabled();
+
+		/// <summary>	Sets the maximal number of bytes held in the pool. Further returned buffers are freed. </summary>
+		static void SetMaxCachedByteCount(size_t nByteCount);
+		static size_t MaxCachedByteCount();
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>	Allocates buffers for images of the given format and stores them in the pool. </summary>
+		///
+		/// <param name="xFormat">	  	The image format. </param>
+		/// <param name="nBufferCount">	Number of buffers to allocate. </param>
+		/// <param name="bLayered">	  	True to allocate buffers for layer images of this format. </param>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		static void PreWarm(const SImageFormat& xFormat, size_t nBufferCount, bool bLayered = false);
+
+		/// <summary>	Frees all buffers held in the pool. </summary>
+		static void Trim();
+
+		static SImageMemoryPoolStats Stats();
+		static void ResetStats();
+	};
+
+} // namespace Clu
@@ -28,6 +28,9 @@
 #include "ILayerImage.h"
 #include "ILayerImageImpl.h"
 #include "LayerImage.h"
+#include "IImage.h"
+#include "IImageImpl.h"
+#include "ImageIntern.h"
 
 #include "IException.h"
 
@@ -180,6 +183,42 @@ namespace Clu
 		CLU_CATCH_RETHROW_ALL("Error copying image")
 	}
 
+	bool CILayerImage::IsView() const
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			return REF->IsView();
+		}
+		CLU_CATCH_RETHROW_ALL("Error obtaining view flag")
+	}
+
+	bool CILayerImage::IsUnique() const
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			return REF->IsUnique();
+		}
+		CLU_CATCH_RETHROW_ALL("Error obtaining unique flag")
+	}
+
+	void CILayerImage::Detach()
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			INTERN.Detach();
+		}
+		CLU_CATCH_RETHROW_ALL("Error detaching image")
+	}
+
 	CILayerImage CILayerImage::Copy() const
 	{
 		try
@@ -209,6 +248,48 @@ namespace Clu
 		CLU_CATCH_RETHROW_ALL("Error cropping image")
 	}
 
+	CILayerImage CILayerImage::CropView(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop)
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			CILayerImage xImg;
+			INTERN_(xImg).ViewFrom(REF, nX, nY, nWidth, nHeight, bYOriginAtTop);
+			return xImg;
+		}
+		CLU_CATCH_RETHROW_ALL("Error creating image view")
+	}
+
+	CILayerImage CILayerImage::CropView(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop) const
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			CILayerImage xImg;
+			INTERN_(xImg).ViewFrom(REF, nX, nY, nWidth, nHeight, bYOriginAtTop, true);
+			return xImg;
+		}
+		CLU_CATCH_RETHROW_ALL("Error creating image view")
+	}
+
+	CIImage CILayerImage::InterleavedView()
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			CIImage xImg;
+			INTERN_(xImg).ViewFrom(INTERN);
+			return xImg;
+		}
+		CLU_CATCH_RETHROW_ALL("Error creating interleaved image view")
+	}
+
 	void CILayerImage::Insert(const CILayerImage& xImage, int nX, int nY, bool bYOriginAtTop)
 	{
 		try
@@ -234,6 +315,18 @@ namespace Clu
 		CLU_CATCH_RETHROW_ALL("Eror creating image")
 	}
 
+	void CILayerImage::Create(const SImageFormat& xStruct, size_t nLayerRowPitch)
+	{
+		try
+		{
+			if (!IsValidRef())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			REF->Create(xStruct, nLayerRowPitch);
+		}
+		CLU_CATCH_RETHROW_ALL("Error creating image")
+	}
+
 	void CILayerImage::Create(const SImageFormat& xStruct, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData)
 	{
 		try
@@ -246,6 +339,18 @@ namespace Clu
 		CLU_CATCH_RETHROW_ALL("Error creating image")
 	}
 
+	void CILayerImage::Create(const SImageFormat& xStruct, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData, size_t nLayerRowPitch)
+	{
+		try
+		{
+			if (!IsValidRef())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			REF->Create(xStruct, ppImageLayerData, nLayerCount, bCopyData, nLayerRowPitch);
+		}
+		CLU_CATCH_RETHROW_ALL("Error creating image")
+	}
+
 	void CILayerImage::Destroy()
 	{
 		try
@@ -426,6 +531,18 @@ namespace Clu
 		CLU_CATCH_RETHROW_ALL("Error getting byte count")
 	}
 
+	size_t CILayerImage::LayerRowPitch() const
+	{
+		try
+		{
+			if (!IsValid())
+				throw CLU_EXCEPTION("Invalid image instance");
+
+			return REF->LayerRowPitch();
+		}
+		CLU_CATCH_RETHROW_ALL("Error getting layer row pitch")
+	}
+
 
 	void* CILayerImage::DataPointer(size_t nLayerId)
 	{
@@ -446,7 +563,9 @@ namespace Clu
 			if (!IsValid())
 				throw CLU_EXCEPTION("Invalid image instance");
 
-			return REF->DataPointer(nLayerId);
+			// Use the const access, which does not copy shared layer memory.
+			const CLayerImage& xImage = INTERN;
+			return xImage.DataPointer(nLayerId);
 		}
 		CLU_CATCH_RETHROW_ALL("Error getting data pointer")
 	}
@@ -38,6 +38,7 @@
 namespace Clu
 {
 	class CILayerImageImpl;
+	class CIImage;
 
 	class CLU_TYPES1_API CILayerImage
 	{
@@ -46,6 +47,8 @@ namespace Clu
 	private:
 		CILayerImageImpl *m_pImpl;
 
+		friend class CIImage;
+
 	public:
 		CILayerImage();
 		CILayerImage(CILayerImage&& xImage);
@@ -63,6 +66,16 @@ namespace Clu
 		bool IsValid() const;
 		bool IsCompactMemoryBlock() const;
 		bool IsDataOwner() const;
+		bool IsView() const;
+
+		/// <summary>	True if this image owns its layer memory and no other image shares it. </summary>
+		bool IsUnique() const;
+
+		/// <summary>
+		/// 	Gives this image its own copy of the layer memory, unless it is unique already. Copies of an image share
+		/// 	the layer memory until the first call of the non-const DataPointer() on one of them.
+		/// </summary>
+		void Detach();
 
 		template<typename TPixel>
 		bool IsOfType()
@@ -72,11 +85,37 @@ namespace Clu
 
 		CILayerImage Copy() const;
 		CILayerImage Crop(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop = true) const;
+
+		/// <summary>
+		/// 	Returns an image that refers to the given region of this image without copying it. Writing to the view
+		/// 	writes to this image. The view keeps the memory of this image alive.
+		/// </summary>
+		CILayerImage CropView(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop = true);
+
+		/// <summary>
+		/// 	Returns a read-only view of the given region, which does not change this image. Several threads may take
+		/// 	such views of the same image. Writing to the view gives it its own copy of the region first.
+		/// </summary>
+		CILayerImage CropView(int nX, int nY, int nWidth, int nHeight, bool bYOriginAtTop = true) const;
+
+		/// <summary>
+		/// 	Returns an image that refers to the memory of this single layer image without copying it. Writing to the
+		/// 	view writes to this image. The view keeps the memory of this image alive.
+		/// </summary>
+		CIImage InterleavedView();
+
 		void Insert(const CILayerImage& xImage, int nX, int nY, bool bYOriginAtTop = true);
 
 		void Create(const SImageFormat& xStruct);
+
+		/// <summary>	Creates the image with nLayerRowPitch bytes between the layer rows. A pitch of zero denotes packed rows. </summary>
+		void Create(const SImageFormat& xStruct, size_t nLayerRowPitch);
+
 		void Create(const SImageFormat& xStruct, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData = true);
 
+		/// <summary>	Creates the image from layers whose rows are nLayerRowPitch bytes apart. A pitch of zero denotes packed rows. </summary>
+		void Create(const SImageFormat& xStruct, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData, size_t nLayerRowPitch);
+
 		void Destroy();
 		void Release();
 
@@ -96,6 +135,7 @@ namespace Clu
 		size_t PixelCount() const;
 		size_t LayerByteCount() const;
 		size_t TotalByteCount() const;
+		size_t LayerRowPitch() const;
 
 		void* DataPointer(size_t nLayerId);
 		const void* DataPointer(size_t nLayerId) const;
@@ -40,20 +40,32 @@ namespace Clu
 
 	struct /*__CUDA_ALIGN__(16)*/ _SImageFormat: public _SImageType
 	{
+		/// <summary>	Alignment in bytes of image memory and of padded rows. </summary>
+		static const int RowAlignment = 64;
+
 		int iWidth;
 		int iHeight;
 
+		/// <summary>
+		/// 	Number of bytes from the start of one row to the start of the next. Zero denotes tightly packed rows. The
+		/// 	pitch has to be a multiple of the bytes per pixel. Layer images ignore it and store their layer row pitch
+		/// 	separately.
+		/// </summary>
+		int iRowPitch;
+
 		__CUDA_HDI__ _SImageFormat& operator= (const _SImageFormat& xFormat)
 		{
 			_SImageType::operator=(xFormat);
 			iWidth = xFormat.iWidth;
 			iHeight = xFormat.iHeight;
+			iRowPitch = xFormat.iRowPitch;
 			return *this;
 		}
 
 		__CUDA_HDI__ bool IsValid() const
 		{
-			return (iWidth > 0) && (iHeight > 0) && _SImageType::IsValid();
+			return (iWidth > 0) && (iHeight > 0) && _SImageType::IsValid()
+				&& (iRowPitch == 0 || (size_t(iRowPitch) >= RowByteCount() && size_t(iRowPitch) % BytesPerPixel() == 0));
 		}
 
 		template<typename TPixel>
@@ -122,13 +134,19 @@ namespace Clu
 
 		__CUDA_HDI__ size_t GetPixelIndex(int iX, int iY) const
 		{
-			return size_t(iY) * size_t(iWidth) + size_t(iX);
+			return size_t(iY) * PixelPitch() + size_t(iX);
+		}
+
+		__CUDA_HDI__ size_t GetByteOffset(int iX, int iY) const
+		{
+			return size_t(iY) * RowPitch() + size_t(iX) * BytesPerPixel();
 		}
 
 		__CUDA_HDI__ void Clear()
 		{
 			iWidth = 0;
 			iHeight = 0;
+			iRowPitch = 0;
 			_SImageType::Clear();
 		}
 
@@ -137,9 +155,67 @@ namespace Clu
 			return size_t(iWidth) * size_t(iHeight);
 		}
 
+		/// <summary>	Number of bytes of pixel data in a row, without padding. </summary>
+		__CUDA_HDI__ size_t RowByteCount() const
+		{
+			return size_t(iWidth) * BytesPerPixel();
+		}
+
+		/// <summary>	Number of bytes between the starts of consecutive rows. </summary>
+		__CUDA_HDI__ size_t RowPitch() const
+		{
+			return (iRowPitch > 0 ? size_t(iRowPitch) : RowByteCount());
+		}
+
+		/// <summary>	Number of pixels between the starts of consecutive rows. </summary>
+		__CUDA_HDI__ size_t PixelPitch() const
+		{
+			return (iRowPitch > 0 ? size_t(iRowPitch) / BytesPerPixel() : size_t(iWidth));
+		}
+
+		__CUDA_HDI__ bool IsPacked() const
+		{
+			return RowPitch() == RowByteCount();
+		}
+
+		/// <summary>	Number of bytes of the memory block that holds the image, including row padding. </summary>
 		__CUDA_HDI__ size_t ByteCount() const
 		{
-			return PixelCount() * BytesPerPixel();
+			return RowPitch() * size_t(iHeight);
+		}
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Returns the smallest row pitch not below nRowByteCount that is a multiple of RowAlignment and of the bytes
+		/// 	per pixel, so that every row starts aligned and pixel indices stay valid.
+		/// </summary>
+		/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		static __CUDA_HDI__ size_t AlignedRowPitch(size_t nRowByteCount, size_t nBytesPerPixel)
+		{
+			if (nBytesPerPixel == 0)
+			{
+				return nRowByteCount;
+			}
+
+			size_t nStep = size_t(RowAlignment);
+			while (nStep % nBytesPerPixel != 0)
+			{
+				nStep += size_t(RowAlignment);
+			}
+
+			return ((nRowByteCount + nStep - 1) / nStep) * nStep;
+		}
+
+		/// <summary>
+		/// 	Returns a copy of this format with the row pitch set to the aligned row pitch. Images are created with packed
+		/// 	rows unless their format is such a layout.
+		/// </summary>
+		__CUDA_HDI__ _SImageFormat AlignedLayout() const
+		{
+			_SImageFormat xFormat;
+			xFormat = *this;
+			xFormat.iRowPitch = int(AlignedRowPitch(RowByteCount(), BytesPerPixel()));
+			return xFormat;
 		}
 
 	};
@@ -162,18 +238,20 @@ namespace Clu
 			*this = xFormat;
 		}
 
-		SImageFormat(int _nWidth, int _nHeight, EPixelType ePT, EDataType eDT)
+		SImageFormat(int _nWidth, int _nHeight, EPixelType ePT, EDataType eDT, int _iRowPitch = 0)
 		{
 			Init(ePT, eDT);
 			iWidth = _nWidth;
 			iHeight = _nHeight;
+			iRowPitch = _iRowPitch;
 		}
 
-		SImageFormat(int _nWidth, int _nHeight, const _SImageType& xType)
+		SImageFormat(int _nWidth, int _nHeight, const _SImageType& xType, int _iRowPitch = 0)
 		{
 			Init(xType);
 			iWidth = _nWidth;
 			iHeight = _nHeight;
+			iRowPitch = _iRowPitch;
 		}
 
 		SImageFormat& operator= (const SImageFormat& xFormat)
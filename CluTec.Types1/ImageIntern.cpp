@@ -26,6 +26,9 @@
 
 #include "stdafx.h"
 #include "ImageIntern.h"
+#include "LayerImage.h"
+#include "ImageMemory.h"
+#include "ImageMemoryPool.h"
 #include "IException.h"
 #include "Defines.h"
 
@@ -59,6 +62,9 @@ namespace Clu
 
 		m_pucData = xImage.m_pucData;
 		m_bDataOwner = xImage.m_bDataOwner;
+		m_bReadOnly = xImage.m_bReadOnly;
+		m_pBuffer = std::move(xImage.m_pBuffer);
+		m_xParent = std::move(xImage.m_xParent);
 
 		xImage._Reset();
 		return *this;
@@ -74,13 +80,35 @@ namespace Clu
 		if (this == &xImage)
 			return *this;
 
+		// The given image may be the parent of this view. Keep it alive until the end of the assignment.
+		CReference<CImageIntern> xKeepParent(m_xParent);
+
 		if (!xImage.IsValid())
 		{
 			Destroy();
 		}
+		else if (xImage.m_bDataOwner && !xImage.m_pBuffer->HasViews())
+		{
+			// Share the pixel memory. It is copied on the first write access to either image.
+			Destroy();
+
+			m_xFormat = xImage.m_xFormat;
+			m_pucData = xImage.m_pucData;
+			m_pBuffer = xImage.m_pBuffer;
+			m_bDataOwner = true;
+		}
+		else if (xImage.m_bDataOwner)
+		{
+			Create(xImage.m_xFormat, xImage.m_pucData, true);
+		}
 		else
 		{
-			Create(xImage.m_xFormat, xImage.m_pucData, xImage.m_bDataOwner);
+			Create(xImage.m_xFormat, xImage.m_pucData, false);
+
+			// A copy of a view is a view of the same parent.
+			m_bReadOnly = xImage.m_bReadOnly;
+			m_pBuffer = xImage.m_pBuffer;
+			m_xParent = xImage.m_xParent;
 		}
 
 		return *this;
@@ -102,17 +130,25 @@ namespace Clu
 
 	void CImageIntern::Create(const SImageFormat& xFormat)
 	{
-		// If this image already has the correct format then don't create it again
-		if (m_xFormat == xFormat && m_bDataOwner)
+		if (xFormat.iRowPitch != 0
+			&& (size_t(xFormat.iRowPitch) < xFormat.RowByteCount() || size_t(xFormat.iRowPitch) % xFormat.BytesPerPixel() != 0))
+		{
+			throw CLU_EXCEPTION("Row pitch has to be at least the row size and a multiple of the pixel size");
+		}
+
+		// If this image already has the correct format and does not share its memory then don't create it again
+		if (m_xFormat == xFormat && IsUnique() && xFormat.RowPitch() == m_xFormat.RowPitch())
 		{
 			return;
 		}
 
 		Destroy();
 
+		// Rows are packed unless the format prescribes a row pitch. Pass xFormat.AlignedLayout() for aligned rows.
 		m_xFormat = xFormat;
 
-		m_pucData = new TData[ByteCount()];
+		m_pBuffer = std::make_shared<CImageBuffer>(ByteCount());
+		m_pucData = m_pBuffer->Data();
 		m_bDataOwner = true;
 	}
 
@@ -121,7 +157,7 @@ namespace Clu
 		if (bCopyData)
 		{
 			Create(xFormat);
-			memcpy(m_pucData, pImageData, ByteCount());
+			CopyImageRows(m_pucData, m_xFormat.RowPitch(), pImageData, xFormat.RowPitch(), m_xFormat.RowByteCount(), size_t(m_xFormat.iHeight));
 		}
 		else
 		{
@@ -139,17 +175,54 @@ namespace Clu
 
 		m_pucData = nullptr;
 		m_bDataOwner = false;
+		m_bReadOnly = false;
+		m_pBuffer.reset();
+		m_xParent.Reset();
 	}
 
 
 	void CImageIntern::Destroy()
 	{
-		if (m_bDataOwner)
+		_Reset();
+	}
+
+	void CImageIntern::_PrepareWrite()
+	{
+		// Memory that views refer to is written in place, so that the views see the changes.
+		if (m_bReadOnly || (m_bDataOwner && m_pBuffer.use_count() > 1 && !m_pBuffer->HasViews()))
 		{
-			delete[] m_pucData;
+			_MakePrivate();
 		}
+	}
 
-		_Reset();
+	void CImageIntern::_MakePrivate()
+	{
+		// An image that owns its memory keeps its layout. The copy of a view or of foreign memory has packed rows.
+		SImageFormat xFormat(m_xFormat.iWidth, m_xFormat.iHeight, m_xFormat);
+		if (m_bDataOwner && !IsView())
+		{
+			xFormat.iRowPitch = m_xFormat.iRowPitch;
+		}
+
+		auto pBuffer = std::make_shared<CImageBuffer>(xFormat.ByteCount());
+		CopyImageRows(pBuffer->Data(), xFormat.RowPitch(), m_pucData, m_xFormat.RowPitch(), m_xFormat.RowByteCount(), size_t(m_xFormat.iHeight));
+
+		m_xFormat = xFormat;
+		m_pucData = pBuffer->Data();
+		m_pBuffer = std::move(pBuffer);
+		m_bDataOwner = true;
+		m_bReadOnly = false;
+		m_xParent.Reset();
+	}
+
+	void CImageIntern::Detach()
+	{
+		if (!IsValid() || IsUnique())
+		{
+			return;
+		}
+
+		_MakePrivate();
 	}
 
 
@@ -160,7 +233,15 @@ namespace Clu
 			throw CLU_EXCEPTION("Invalid image to crop from");
 		}
 
-		Create(xImage.m_xFormat, xImage.m_pucData, true);
+		if (xImage.m_bDataOwner && !xImage.m_pBuffer->HasViews())
+		{
+			// The copy shares the memory until one of the images is written to.
+			*this = xImage;
+		}
+		else
+		{
+			Create(xImage.m_xFormat, xImage.m_pucData, true);
+		}
 	}
 
 
@@ -189,16 +270,80 @@ namespace Clu
 		Create(SImageFormat(iWidth, iHeight, xImage.m_xFormat.ePixelType, xImage.m_xFormat.eDataType));
 
 		int nAdjY = (bYOriginAtTop ? iY : xImage.m_xFormat.iHeight - iY - iHeight);
-		int nSrcStride = xImage.m_xFormat.iWidth * int(xImage.BytesPerPixel());
-		TData* pSrc = xImage.m_pucData + (nAdjY * nSrcStride) + (iX * int(xImage.BytesPerPixel()));
+		const TData* pSrc = xImage.m_pucData + xImage.m_xFormat.GetByteOffset(iX, nAdjY);
 
-		int nTrgStride = m_xFormat.iWidth * int(BytesPerPixel());
-		TData* pTrg = m_pucData;
+		CopyImageRows(m_pucData, m_xFormat.RowPitch(), pSrc, xImage.m_xFormat.RowPitch(), m_xFormat.RowByteCount(), size_t(iHeight));
+	}
 
-		for (int nIdx = 0; nIdx < iHeight; ++nIdx, pSrc += nSrcStride, pTrg += nTrgStride)
+	void CImageIntern::ViewFrom(const CReference<CImageIntern>& xParent, int iX, int iY, int iWidth, int iHeight, bool bYOriginAtTop
+		, bool bReadOnly)
+	{
+		if (!xParent.IsValid() || !xParent->IsValid())
+		{
+			throw CLU_EXCEPTION("Given image is invalid");
+		}
+
+		CReference<CImageIntern> xRef(xParent);
+		CImageIntern& xImage = *xRef;
+		if (this == &xImage)
+		{
+			throw CLU_EXCEPTION("Cannot view into same image");
+		}
+
+		if (iX < 0 || iWidth <= 0 || iX + iWidth > xImage.Width())
+		{
+			throw CLU_EXCEPTION("Horizontal view area out of range");
+		}
+
+		if (iY < 0 || iHeight <= 0 || iY + iHeight > xImage.Height())
+		{
+			throw CLU_EXCEPTION("Vertical view area out of range");
+		}
+
+		// Writes through the view must not show in copies of the parent, and the parent must not stop sharing its
+		// memory with the view when it is written to. A read-only view does not write and leaves the parent as it is.
+		if (!bReadOnly)
+		{
+			xImage._PrepareWrite();
+			if (xImage.m_pBuffer)
+			{
+				xImage.m_pBuffer->SetHasViews();
+			}
+		}
+
+		Destroy();
+
+		int nAdjY = (bYOriginAtTop ? iY : xImage.m_xFormat.iHeight - iY - iHeight);
+
+		m_xFormat = SImageFormat(iWidth, iHeight, xImage.m_xFormat, int(xImage.m_xFormat.RowPitch()));
+		m_pucData = xImage.m_pucData + xImage.m_xFormat.GetByteOffset(iX, nAdjY);
+		m_bDataOwner = false;
+		m_bReadOnly = bReadOnly;
+		m_pBuffer = xImage.m_pBuffer;
+		m_xParent = std::move(xRef);
+	}
+
+	void CImageIntern::ViewFrom(CLayerImage& xImage)
+	{
+		if (!xImage.IsValid() || xImage.LayerCount() != 1)
+		{
+			throw CLU_EXCEPTION("Only valid single layer images can be viewed as images");
+		}
+
+		// As for a writable view of an image of the same type, writes through the view show in the source.
+		xImage._PrepareWrite();
+		if (xImage.m_pBuffer)
 		{
-			memcpy(pTrg, pSrc, nTrgStride);
+			xImage.m_pBuffer->SetHasViews();
 		}
+
+		Destroy();
+
+		m_xFormat = SImageFormat(xImage.Width(), xImage.Height(), xImage.m_xFormat, int(xImage.LayerRowPitch()));
+		m_pucData = xImage.m_vecLayerPtr[0];
+		m_bDataOwner = false;
+		m_bReadOnly = false;
+		m_pBuffer = xImage.m_pBuffer;
 	}
 
 	void CImageIntern::Insert(const CImageIntern& xImage, int nX, int nY, bool bYOriginAtTop)
@@ -218,7 +363,7 @@ namespace Clu
 			throw CLU_EXCEPTION("Cannot insert into same image");
 		}
 
-		if (Type() != xImage.Type())
+		if (!m_xFormat.IsEqualType(xImage.m_xFormat))
 		{
 			throw CLU_EXCEPTION("Inserted image has to be of same type as this image");
 		}
@@ -233,18 +378,14 @@ namespace Clu
 			throw CLU_EXCEPTION("Vertical insert area out of range");
 		}
 
-		int nSrcStride = xImage.m_xFormat.iWidth * int(xImage.BytesPerPixel());
-		TData* pSrc = xImage.m_pucData;
+		_PrepareWrite();
 
 		int nAdjY = (bYOriginAtTop ? nY : m_xFormat.iHeight - nY - xImage.m_xFormat.iHeight);
-		int nTrgStride = m_xFormat.iWidth * int(BytesPerPixel());
-		TData* pTrg = m_pucData + (nAdjY * nTrgStride) + (nX * int(BytesPerPixel()));;
-
-		for (int nIdx = 0; nIdx < xImage.m_xFormat.iHeight; ++nIdx, pSrc += nSrcStride, pTrg += nTrgStride)
-		{
-			memcpy(pTrg, pSrc, nTrgStride);
-		}
+		TData* pTrg = m_pucData + m_xFormat.GetByteOffset(nX, nAdjY);
 
+		// Copy only the rows of the inserted image, not the full rows of this image.
+		CopyImageRows(pTrg, m_xFormat.RowPitch(), xImage.m_pucData, xImage.m_xFormat.RowPitch()
+			, xImage.m_xFormat.RowByteCount(), size_t(xImage.m_xFormat.iHeight));
 	}
 
 } // namespace Clu
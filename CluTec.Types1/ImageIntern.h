@@ -26,10 +26,16 @@
 
 #pragma once
 
+#include <memory>
+
 #include "ImageFormat.h"
+#include "Reference.h"
 
 namespace Clu
 {
+	class CImageBuffer;
+	class CLayerImage;
+
 	class CImageIntern
 	{
 	public:
@@ -41,8 +47,21 @@ namespace Clu
 		TData *m_pucData;
 		bool m_bDataOwner;
 
+		// True for a view that must not write to the memory of its parent. It copies its region on the first write.
+		bool m_bReadOnly;
+
+		// The pixel memory. Copies of an image share it until one of them is written to.
+		std::shared_ptr<CImageBuffer> m_pBuffer;
+
+		// The image this image is a view into. Keeps the memory of the parent alive.
+		CReference<CImageIntern> m_xParent;
+
 	protected:
 		void _Reset();
+		void _PrepareWrite();
+		void _MakePrivate();
+
+		friend class CLayerImage;
 
 	public :
 
@@ -62,6 +81,28 @@ namespace Clu
 		void CropFrom(const CImageIntern& xImage, int iX, int iY, int iWidth, int iHeight, bool bYOriginAtTop = true);
 		void Insert(const CImageIntern& xImage, int iX, int iY, bool bYOriginAtTop = true);
 
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Makes this image a view of a rectangular region of the referenced image. No memory is allocated or
+		/// 	copied: the view points into the memory of the parent and uses its row pitch. The view holds the
+		/// 	reference, so the parent stays alive as long as the view exists.
+		///
+		/// 	A writable view marks the memory of the parent as viewed, so that writes through the view show in
+		/// 	the parent. A read-only view leaves the parent untouched, so that several threads may take read-only
+		/// 	views of the same image. It shares the memory like a copy and receives its own copy of the region on
+		/// 	the first write.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		void ViewFrom(const CReference<CImageIntern>& xParent, int iX, int iY, int iWidth, int iHeight, bool bYOriginAtTop = true
+			, bool bReadOnly = false);
+
+		/// <summary>
+		/// 	Makes this image a writable view of the memory of a single layer image, whose layout coincides with that of
+		/// 	an image with a single channel. The view shares the layer memory, so the memory stays alive as long as
+		/// 	the view exists. Memory of external data is not kept alive.
+		/// </summary>
+		void ViewFrom(CLayerImage& xImage);
+
 		void Create(const SImageFormat& xStruct);
 		void Create(const SImageFormat& xStruct, const void *pImageData, bool bCopyData = true);
 		
@@ -78,6 +119,28 @@ namespace Clu
 			return m_bDataOwner;
 		}
 
+		bool IsView() const
+		{
+			return m_xParent.IsValid();
+		}
+
+		bool IsReadOnly() const
+		{
+			return m_bReadOnly;
+		}
+
+		/// <summary>	True if this image owns its pixel memory and no other image refers to it. </summary>
+		bool IsUnique() const
+		{
+			return m_bDataOwner && m_pBuffer.use_count() == 1;
+		}
+
+		/// <summary>
+		/// 	Gives this image its own copy of the pixel memory, unless it is unique already. A detached view is no
+		/// 	longer a view and external data is copied.
+		/// </summary>
+		void Detach();
+
 		bool IsOfType(Clu::EDataType eDataType, Clu::EPixelType ePixelType)
 		{
 			return (m_xFormat.eDataType == eDataType && m_xFormat.ePixelType == ePixelType);
@@ -108,6 +171,11 @@ namespace Clu
 			return m_xFormat.ByteCount();
 		}
 
+		size_t RowPitch() const
+		{
+			return m_xFormat.RowPitch();
+		}
+
 		int Width() const
 		{
 			return m_xFormat.iWidth;
@@ -139,8 +207,16 @@ namespace Clu
 			return (const SImageType&)m_xFormat;
 		}
 
+		////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// <summary>
+		/// 	Returns the pixel memory for writing. If the memory is shared with copies of this image, this image
+		/// 	first receives its own copy. The pointer stays valid for writing only until this image is copied
+		/// 	again.
+		/// </summary>
+		////////////////////////////////////////////////////////////////////////////////////////////////////
 		void* DataPointer()
 		{
+			_PrepareWrite();
 			return (void *)m_pucData;
 		}
 
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Types1.rtl
+// file:      ImageMemory.h
+//
+// summary:   Declares functions to allocate and copy image memory
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#ifdef _WIN32
+#	include <malloc.h>
+#endif
+
+namespace Clu
+{
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>	Allocates a memory block whose start address is a multiple of the given alignment. </summary>
+	///
+	/// <param name="nByteCount"> 	Number of bytes. </param>
+	/// <param name="nAlignment">	The alignment. Has to be a power of two and a multiple of sizeof(void*). </param>
+	///
+	/// <returns>	The memory block. Throws std::bad_alloc if the allocation fails. Free it with AlignedFree(). </returns>
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	inline void* AlignedAlloc(size_t nByteCount, size_t nAlignment)
+	{
+		if (nByteCount == 0)
+		{
+			nByteCount = 1;
+		}
+
+#ifdef _WIN32
+		void* pData = _aligned_malloc(nByteCount, nAlignment);
+#else
+		void* pData = nullptr;
+		if (posix_memalign(&pData, nAlignment, nByteCount) != 0)
+		{
+			pData = nullptr;
+		}
+#endif
+
+		if (pData == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+
+		return pData;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>	Frees a memory block allocated with AlignedAlloc(). Null pointers are ignored. </summary>
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	inline void AlignedFree(void* pData)
+	{
+#ifdef _WIN32
+		_aligned_free(pData);
+#else
+		free(pData);
+#endif
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>	Copies image rows between memory blocks with possibly different row pitches. </summary>
+	///
+	/// <param name="pTrg">		   	The target of the first row. </param>
+	/// <param name="nTrgPitch">   	Bytes between target rows. </param>
+	/// <param name="pSrc">		   	The source of the first row. </param>
+	/// <param name="nSrcPitch">   	Bytes between source rows. </param>
+	/// <param name="nRowByteCount">	Bytes to copy per row. </param>
+	/// <param name="nRowCount">   	Number of rows. </param>
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	inline void CopyImageRows(void* pTrg, size_t nTrgPitch, const void* pSrc, size_t nSrcPitch, size_t nRowByteCount, size_t nRowCount)
+	{
+		unsigned char* pucTrg = (unsigned char*)pTrg;
+		const unsigned char* pucSrc = (const unsigned char*)pSrc;
+
+		if (nTrgPitch == nRowByteCount && nSrcPitch == nRowByteCount)
+		{
+			memcpy(pucTrg, pucSrc, nRowByteCount * nRowCount);
+			return;
+		}
+
+		for (size_t nRow = 0; nRow < nRowCount; ++nRow, pucTrg += nTrgPitch, pucSrc += nSrcPitch)
+		{
+			memcpy(pucTrg, pucSrc, nRowByteCount);
+		}
+	}
+}
@@ -0,0 +1,290 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Types1.rtl
+// file:      ImageMemoryPool.cpp
+//
+// summary:   Implements the image memory pool
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "stdafx.h"
+#include "ImageMemoryPool.h"
+#include "ImageMemory.h"
+
+
+namespace Clu
+{
+	void CImageMemoryPool::CStack::Push(SNode* pNode)
+	{
+		uint64_t uHead = m_uHead.load(std::memory_order_acquire);
+		uint64_t uNewHead;
+
+		do
+		{
+			pNode->pNext.store(_Ptr(uHead), std::memory_order_relaxed);
+			uNewHead = _Next(pNode, uHead);
+		} while (!m_uHead.compare_exchange_weak(uHead, uNewHead, std::memory_order_release, std::memory_order_acquire));
+	}
+
+	CImageMemoryPool::SNode* CImageMemoryPool::CStack::Pop()
+	{
+		uint64_t uHead = m_uHead.load(std::memory_order_acquire);
+		uint64_t uNewHead;
+
+		do
+		{
+			SNode* pNode = _Ptr(uHead);
+			if (pNode == nullptr)
+			{
+				return nullptr;
+			}
+
+			// The node may have been popped by another thread meanwhile. Nodes are never freed, so reading it is safe
+			// and the changed tag of the head lets the exchange fail.
+			uNewHead = _Next(pNode->pNext.load(std::memory_order_relaxed), uHead);
+		} while (!m_uHead.compare_exchange_weak(uHead, uNewHead, std::memory_order_acq_rel, std::memory_order_acquire));
+
+		return _Ptr(uHead);
+	}
+
+
+	CImageMemoryPool::CImageMemoryPool()
+		: m_bEnabled(false)
+		, m_nMaxCachedByteCount(DefaultMaxCachedByteCount)
+		, m_nSizeClassCount(0)
+	{
+		for (auto& xClass : m_pSizeClass)
+		{
+			xClass.nByteCount = 0;
+		}
+
+		m_nCachedBufferCount = 0;
+		m_nCachedByteCount = 0;
+		ResetStats();
+	}
+
+	CImageMemoryPool::~CImageMemoryPool()
+	{
+		Trim();
+
+		while (SNode* pNode = m_xSpareNodes.Pop())
+		{
+			delete pNode;
+		}
+	}
+
+	CImageMemoryPool& CImageMemoryPool::Global()
+	{
+		// Never destroyed, so that images in static objects can still release their memory at process exit.
+		static CImageMemoryPool* s_pPool = new CImageMemoryPool();
+		return *s_pPool;
+	}
+
+	size_t CImageMemoryPool::ClassByteCount(size_t nByteCount)
+	{
+		const size_t nUnit = (nByteCount <= 4096 ? size_t(SImageFormat::RowAlignment) : size_t(4096));
+
+		if (nByteCount == 0)
+		{
+			return nUnit;
+		}
+
+		return ((nByteCount + nUnit - 1) / nUnit) * nUnit;
+	}
+
+	CImageMemoryPool::SSizeClass* CImageMemoryPool::_GetSizeClass(size_t nClassByteCount)
+	{
+		// Open addressing table, whose entries are only ever added.
+		size_t nIdx = size_t((uint64_t(nClassByteCount / SImageFormat::RowAlignment) * 0x9E3779B97F4A7C15ull) >> 32) % MaxSizeClassCount;
+
+		for (size_t nProbe = 0; nProbe < MaxSizeClassCount; ++nProbe, nIdx = (nIdx + 1) % MaxSizeClassCount)
+		{
+			SSizeClass& xClass = m_pSizeClass[nIdx];
+			size_t nKey = xClass.nByteCount.load(std::memory_order_acquire);
+
+			if (nKey == 0)
+			{
+				if (xClass.nByteCount.compare_exchange_strong(nKey, nClassByteCount, std::memory_order_acq_rel))
+				{
+					++m_nSizeClassCount;
+					return &xClass;
+				}
+			}
+
+			if (nKey == nClassByteCount)
+			{
+				return &xClass;
+			}
+		}
+
+		// All size classes are in use. Memory of this size is not pooled.
+		return nullptr;
+	}
+
+	CImageMemoryPool::SNode* CImageMemoryPool::_NewNode()
+	{
+		SNode* pNode = m_xSpareNodes.Pop();
+		if (pNode == nullptr)
+		{
+			pNode = new SNode();
+		}
+
+		return pNode;
+	}
+
+	bool CImageMemoryPool::_Store(void* pData, size_t nClassByteCount)
+	{
+		SSizeClass* pClass = _GetSizeClass(nClassByteCount);
+		if (pClass == nullptr)
+		{
+			return false;
+		}
+
+		// Reserve the bytes first, so that concurrent returns cannot exceed the limit together.
+		const size_t nCachedByteCount = m_nCachedByteCount.fetch_add(nClassByteCount) + nClassByteCount;
+		if (nCachedByteCount > m_nMaxCachedByteCount)
+		{
+			m_nCachedByteCount.fetch_sub(nClassByteCount);
+			return false;
+		}
+
+		SNode* pNode = _NewNode();
+		pNode->pData = pData;
+		pClass->xFree.Push(pNode);
+		++m_nCachedBufferCount;
+
+		size_t nPeak = m_nPeakCachedByteCount.load();
+		while (nCachedByteCount > nPeak && !m_nPeakCachedByteCount.compare_exchange_weak(nPeak, nCachedByteCount))
+		{
+		}
+
+		return true;
+	}
+
+	void* CImageMemoryPool::Allocate(size_t nByteCount)
+	{
+		const size_t nClassByteCount = ClassByteCount(nByteCount);
+
+		if (m_bEnabled)
+		{
+			SSizeClass* pClass = _GetSizeClass(nClassByteCount);
+			SNode* pNode = (pClass != nullptr ? pClass->xFree.Pop() : nullptr);
+
+			if (pNode != nullptr)
+			{
+				void* pData = pNode->pData;
+				m_xSpareNodes.Push(pNode);
+
+				m_nCachedByteCount.fetch_sub(nClassByteCount);
+				--m_nCachedBufferCount;
+				++m_nHitCount;
+				return pData;
+			}
+
+			++m_nMissCount;
+		}
+
+		return AlignedAlloc(nClassByteCount, SImageFormat::RowAlignment);
+	}
+
+	void CImageMemoryPool::Release(void* pData, size_t nByteCount)
+	{
+		if (pData == nullptr)
+		{
+			return;
+		}
+
+		if (m_bEnabled)
+		{
+			if (_Store(pData, ClassByteCount(nByteCount)))
+			{
+				++m_nReturnCount;
+				return;
+			}
+
+			++m_nDiscardCount;
+		}
+
+		AlignedFree(pData);
+	}
+
+	void CImageMemoryPool::PreWarm(size_t nByteCount, size_t nBufferCount)
+	{
+		const size_t nClassByteCount = ClassByteCount(nByteCount);
+
+		for (size_t nIdx = 0; nIdx < nBufferCount; ++nIdx)
+		{
+			void* pData = AlignedAlloc(nClassByteCount, SImageFormat::RowAlignment);
+			if (!_Store(pData, nClassByteCount))
+			{
+				AlignedFree(pData);
+				break;
+			}
+		}
+	}
+
+	void CImageMemoryPool::Trim()
+	{
+		for (auto& xClass : m_pSizeClass)
+		{
+			const size_t nClassByteCount = xClass.nByteCount.load(std::memory_order_acquire);
+			if (nClassByteCount == 0)
+			{
+				continue;
+			}
+
+			while (SNode* pNode = xClass.xFree.Pop())
+			{
+				AlignedFree(pNode->pData);
+				m_xSpareNodes.Push(pNode);
+
+				m_nCachedByteCount.fetch_sub(nClassByteCount);
+				--m_nCachedBufferCount;
+			}
+		}
+	}
+
+	SImageMemoryPoolStats CImageMemoryPool::Stats() const
+	{
+		SImageMemoryPoolStats xStats;
+
+		xStats.nHitCount = m_nHitCount;
+		xStats.nMissCount = m_nMissCount;
+		xStats.nReturnCount = m_nReturnCount;
+		xStats.nDiscardCount = m_nDiscardCount;
+		xStats.nCachedBufferCount = m_nCachedBufferCount;
+		xStats.nCachedByteCount = m_nCachedByteCount;
+		xStats.nPeakCachedByteCount = m_nPeakCachedByteCount;
+		xStats.nSizeClassCount = m_nSizeClassCount;
+
+		return xStats;
+	}
+
+	void CImageMemoryPool::ResetStats()
+	{
+		m_nHitCount = 0;
+		m_nMissCount = 0;
+		m_nReturnCount = 0;
+		m_nDiscardCount = 0;
+		m_nPeakCachedByteCount = m_nCachedByteCount.load();
+	}
+
+} // namespace Clu
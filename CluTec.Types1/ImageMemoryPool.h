@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// project:   CluTec.Types1.rtl
+// file:      ImageMemoryPool.h
+//
+// summary:   Declares the image memory pool
+//
+//            Copyright (c) 2019 by Christian Perwass.
+//
+//            This file is part of the CluTecLib library.
+//
+//            The CluTecLib library is free software: you can redistribute it and / or modify
+//            it under the terms of the GNU Lesser General Public License as published by
+//            the Free Software Foundation, either version 3 of the License, or
+//            (at your option) any later version.
+//
+//            The CluTecLib library is distributed in the hope that it will be useful,
+//            but WITHOUT ANY WARRANTY; without even the implied warranty of
+//            MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//            GNU Lesser General Public License for more details.
+//
+//            You should have received a copy of the GNU Lesser General Public License
+//            along with the CluTecLib library.
+//            If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "IImageMemoryPool.h"
+
+namespace Clu
+{
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	Thread safe pool of aligned memory blocks. Blocks are grouped into size classes, each of which keeps
+	/// 	its free blocks in a lock-free stack. The list nodes are never freed but recycled through a stack of
+	/// 	spare nodes, so that a node can always be read safely, and the stack heads carry a tag against the ABA
+	/// 	problem. Memory is always allocated in size class units, so blocks allocated while the pool is
+	/// 	disabled can still be returned to it later.
+	/// </summary>
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	class CImageMemoryPool
+	{
+	public:
+		static const size_t MaxSizeClassCount = 256;
+		static const size_t DefaultMaxCachedByteCount = size_t(256) << 20;
+
+	private:
+		struct SNode
+		{
+			void* pData;
+			std::atomic<SNode*> pNext;
+		};
+
+		class CStack
+		{
+		private:
+			static const unsigned PtrBitCount = (sizeof(void*) == 8 ? 48 : 32);
+			static const uint64_t PtrMask = (uint64_t(1) << PtrBitCount) - 1;
+
+			std::atomic<uint64_t> m_uHead;
+
+			static SNode* _Ptr(uint64_t uHead)
+			{
+				return (SNode*)uintptr_t(uHead & PtrMask);
+			}
+
+			static uint64_t _Next(SNode* pNode, uint64_t uHead)
+			{
+				return (uint64_t(uintptr_t(pNode)) & PtrMask) | (((uHead >> PtrBitCount) + 1) << PtrBitCount);
+			}
+
+		public:
+			CStack() : m_uHead(0)
+			{}
+
+			void Push(SNode* pNode);
+			SNode* Pop();
+		};
+
+		struct SSizeClass
+		{
+			std::atomic<size_t> nByteCount;
+			CStack xFree;
+		};
+
+	private:
+		SSizeClass m_pSizeClass[MaxSizeClassCount];
+		CStack m_xSpareNodes;
+
+		std::atomic<bool> m_bEnabled;
+		std::atomic<size_t> m_nMaxCachedByteCount;
+
+		std::atomic<size_t> m_nHitCount;
+		std::atomic<size_t> m_nMissCount;
+		std::atomic<size_t> m_nReturnCount;
+		std::atomic<size_t> m_nDiscardCount;
+		std::atomic<size_t> m_nCachedBufferCount;
+		std::atomic<size_t> m_nCachedByteCount;
+		std::atomic<size_t> m_nPeakCachedByteCount;
+		std::atomic<size_t> m_nSizeClassCount;
+
+	protected:
+		SSizeClass* _GetSizeClass(size_t nClassByteCount);
+		SNode* _NewNode();
+		bool _Store(void* pData, size_t nClassByteCount);
+
+	public:
+		CImageMemoryPool();
+		~CImageMemoryPool();
+
+		CImageMemoryPool(const CImageMemoryPool&) = delete;
+		CImageMemoryPool& operator= (const CImageMemoryPool&) = delete;
+
+		/// <summary>	The pool used by all images. It lives until the end of the process. </summary>
+		static CImageMemoryPool& Global();
+
+		/// <summary>
+		/// 	Number of bytes actually allocated for a request. Small blocks are rounded up to the row alignment,
+		/// 	larger ones to whole pages, so that images of similar size share a size class.
+		/// </summary>
+		static size_t ClassByteCount(size_t nByteCount);
+
+		/// <summary>	Allocates a block aligned to SImageFormat::RowAlignment. Throws std::bad_alloc on failure. </summary>
+		void* Allocate(size_t nByteCount);
+
+		/// <summary>	Returns a block obtained from Allocate() with the same byte count. Null pointers are ignored. </summary>
+		void Release(void* pData, size_t nByteCount);
+
+		void PreWarm(size_t nByteCount, size_t nBufferCount);
+		void Trim();
+
+		void Enable(bool bEnable)
+		{
+			m_bEnabled = bEnable;
+		}
+
+		bool IsEnabled() const
+		{
+			return m_bEnabled;
+		}
+
+		void SetMaxCachedByteCount(size_t nByteCount)
+		{
+			m_nMaxCachedByteCount = nByteCount;
+		}
+
+		size_t MaxCachedByteCount() const
+		{
+			return m_nMaxCachedByteCount;
+		}
+
+		SImageMemoryPoolStats Stats() const;
+		void ResetStats();
+	};
+
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// 	A block of pixel memory from the global pool, which is returned to the pool when the block is destroyed.
+	/// 	Images share blocks through std::shared_ptr.
+	/// </summary>
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+	class CImageBuffer
+	{
+	private:
+		unsigned char* m_pucData;
+		size_t m_nByteCount;
+
+		// Set once a view refers to this memory. Such memory must not be copied on write, since the view would not
+		// see the changes anymore.
+		std::atomic<bool> m_bHasViews;
+
+	public:
+		CImageBuffer(size_t nByteCount)
+			: m_pucData((unsigned char*)CImageMemoryPool::Global().Allocate(nByteCount))
+			, m_nByteCount(nByteCount)
+			, m_bHasViews(false)
+		{}
+
+		~CImageBuffer()
+		{
+			CImageMemoryPool::Global().Release(m_pucData, m_nByteCount);
+		}
+
+		CImageBuffer(const CImageBuffer&) = delete;
+		CImageBuffer& operator= (const CImageBuffer&) = delete;
+
+		unsigned char* Data() const
+		{
+			return m_pucData;
+		}
+
+		size_t ByteCount() const
+		{
+			return m_nByteCount;
+		}
+
+		bool HasViews() const
+		{
+			return m_bHasViews;
+		}
+
+		void SetHasViews()
+		{
+			m_bHasViews = true;
+		}
+	};
+
+} // namespace Clu
@@ -32,6 +32,9 @@
 #include "IException.h"
 
 #include "LayerImage.h"
+#include "ImageIntern.h"
+#include "ImageMemory.h"
+#include "ImageMemoryPool.h"
 
 
 
@@ -61,7 +64,12 @@ namespace Clu
 		m_xFormat = xImage.m_xFormat;
 
 		m_vecLayerPtr = std::move(xImage.m_vecLayerPtr);
+		m_nLayerRowPitch = xImage.m_nLayerRowPitch;
 		m_bDataOwner = xImage.m_bDataOwner;
+		m_bIsCompactMemoryBlock = xImage.m_bIsCompactMemoryBlock;
+		m_bReadOnly = xImage.m_bReadOnly;
+		m_pBuffer = std::move(xImage.m_pBuffer);
+		m_xParent = std::move(xImage.m_xParent);
 
 		xImage._Reset();
 		return *this;
@@ -77,13 +85,37 @@ namespace Clu
 		if (this == &xImage)
 			return *this;
 
+		// The given image may be the parent of this view. Keep it alive until the end of the assignment.
+		CReference<CLayerImage> xKeepParent(m_xParent);
+
 		if (!xImage.IsValid())
 		{
 			Destroy();
 		}
+		else if (xImage.m_bDataOwner && !xImage.m_pBuffer->HasViews())
+		{
+			// Share the layer memory. It is copied on the first write access to either image.
+			Destroy();
+
+			m_xFormat = xImage.m_xFormat;
+			m_vecLayerPtr = xImage.m_vecLayerPtr;
+			m_nLayerRowPitch = xImage.m_nLayerRowPitch;
+			m_bIsCompactMemoryBlock = xImage.m_bIsCompactMemoryBlock;
+			m_pBuffer = xImage.m_pBuffer;
+			m_bDataOwner = true;
+		}
+		else if (xImage.m_bDataOwner)
+		{
+			Create(xImage.m_xFormat, xImage.m_vecLayerPtr, true, xImage.LayerRowPitch());
+		}
 		else
 		{
-			Create(xImage.m_xFormat, xImage.m_vecLayerPtr, xImage.m_bDataOwner);
+			Create(xImage.m_xFormat, xImage.m_vecLayerPtr, false, xImage.LayerRowPitch());
+
+			// A copy of a view is a view of the same parent.
+			m_bReadOnly = xImage.m_bReadOnly;
+			m_pBuffer = xImage.m_pBuffer;
+			m_xParent = xImage.m_xParent;
 		}
 
 		return *this;
@@ -96,10 +128,10 @@ namespace Clu
 		Create(xStruct);
 	}
 
-	CLayerImage::CLayerImage(const SImageFormat& xStruct, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData)
+	CLayerImage::CLayerImage(const SImageFormat& xStruct, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData, size_t nLayerRowPitch)
 	{
 		_Reset();
-		Create(xStruct, ppImageLayerData, nLayerCount, bCopyData);
+		Create(xStruct, ppImageLayerData, nLayerCount, bCopyData, nLayerRowPitch);
 	}
 
 
@@ -108,27 +140,47 @@ namespace Clu
 		m_xFormat.Clear();
 
 		m_vecLayerPtr.clear();
+		m_nLayerRowPitch = 0;
 		m_bDataOwner = false;
 		m_bIsCompactMemoryBlock = false;
+		m_bReadOnly = false;
+		m_pBuffer.reset();
+		m_xParent.Reset();
 	}
 
 
 	void CLayerImage::Create(const SImageFormat& xFormat)
 	{
-		// If this image already has the correct format then don't create it again
-		if (m_xFormat == xFormat && m_bDataOwner)
+		Create(xFormat, size_t(0));
+	}
+
+	void CLayerImage::Create(const SImageFormat& xFormat, size_t nLayerRowPitch)
+	{
+		const size_t nValueByteCount = SImageFormat::SizeOf(xFormat.eDataType);
+		const size_t nLayerRowByteCount = size_t(xFormat.iWidth) * nValueByteCount;
+		if (nLayerRowPitch != 0 && (nLayerRowPitch < nLayerRowByteCount || nLayerRowPitch % nValueByteCount != 0))
+		{
+			throw CLU_EXCEPTION("Layer row pitch has to be at least the layer row size and a multiple of the value size");
+		}
+
+		// If this image already has the correct format and does not share its memory then don't create it again
+		if (m_xFormat == xFormat && IsUnique() && (nLayerRowPitch > 0 ? nLayerRowPitch : nLayerRowByteCount) == LayerRowPitch())
 		{
 			return;
 		}
 
 		Destroy();
 
+		// The layers use their own row pitch. Layer rows are packed unless a pitch is given.
 		m_xFormat = xFormat;
+		m_xFormat.iRowPitch = 0;
+		m_nLayerRowPitch = nLayerRowPitch;
 
 		size_t nLayerCount = SImageType::DimOf(m_xFormat.ePixelType);
 		m_vecLayerPtr.resize(nLayerCount);
-		TData *pCurLayer = new TData[TotalByteCount()];
-		
+		m_pBuffer = std::make_shared<CImageBuffer>(TotalByteCount());
+		TData *pCurLayer = m_pBuffer->Data();
+
 		m_bIsCompactMemoryBlock = true;
 
 		for (auto &pLayer : m_vecLayerPtr)
@@ -140,7 +192,7 @@ namespace Clu
 		m_bDataOwner = true;
 	}
 
-	void CLayerImage::Create(const SImageFormat& xFormat, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData)
+	void CLayerImage::Create(const SImageFormat& xFormat, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData, size_t nLayerRowPitch)
 	{
 		if (nLayerCount != SImageType::DimOf(xFormat.ePixelType))
 		{
@@ -151,10 +203,12 @@ namespace Clu
 		{
 			Create(xFormat);
 
+			const size_t nSrcPitch = (nLayerRowPitch > 0 ? nLayerRowPitch : LayerRowByteCount());
+
 			size_t nLayerIdx = 0;
 			for (auto pLayer : m_vecLayerPtr)
 			{
-				memcpy(pLayer, ppImageLayerData[nLayerIdx], LayerByteCount());
+				CopyImageRows(pLayer, LayerRowPitch(), ppImageLayerData[nLayerIdx], nSrcPitch, LayerRowByteCount(), size_t(m_xFormat.iHeight));
 				++nLayerIdx;
 			}
 		}
@@ -163,6 +217,8 @@ namespace Clu
 			Destroy();
 
 			m_xFormat = xFormat;
+			m_xFormat.iRowPitch = 0;
+			m_nLayerRowPitch = nLayerRowPitch;
 			m_vecLayerPtr.resize(nLayerCount);
 
 			size_t nLayerIdx = 0;
@@ -179,12 +235,51 @@ namespace Clu
 
 	void CLayerImage::Destroy()
 	{
-		if (m_bDataOwner)
+		_Reset();
+	}
+
+	void CLayerImage::_PrepareWrite()
+	{
+		// Memory that views refer to is written in place, so that the views see the changes.
+		if (m_bReadOnly || (m_bDataOwner && m_pBuffer.use_count() > 1 && !m_pBuffer->HasViews()))
 		{
-			delete[] m_vecLayerPtr[0];
+			_MakePrivate();
 		}
+	}
 
-		_Reset();
+	void CLayerImage::_MakePrivate()
+	{
+		// An image that owns its memory keeps its layout. The copy of a view or of foreign memory has packed rows.
+		const size_t nLayerRowByteCount = LayerRowByteCount();
+		const size_t nLayerRowPitch = (m_bDataOwner && !IsView() ? LayerRowPitch() : nLayerRowByteCount);
+		const size_t nLayerByteCount = nLayerRowPitch * size_t(m_xFormat.iHeight);
+
+		auto pBuffer = std::make_shared<CImageBuffer>(nLayerByteCount * m_vecLayerPtr.size());
+		TData *pCurLayer = pBuffer->Data();
+
+		for (auto &pLayer : m_vecLayerPtr)
+		{
+			CopyImageRows(pCurLayer, nLayerRowPitch, pLayer, LayerRowPitch(), nLayerRowByteCount, size_t(m_xFormat.iHeight));
+			pLayer = pCurLayer;
+			pCurLayer += nLayerByteCount;
+		}
+
+		m_nLayerRowPitch = nLayerRowPitch;
+		m_pBuffer = std::move(pBuffer);
+		m_bDataOwner = true;
+		m_bIsCompactMemoryBlock = true;
+		m_bReadOnly = false;
+		m_xParent.Reset();
+	}
+
+	void CLayerImage::Detach()
+	{
+		if (!IsValid() || IsUnique())
+		{
+			return;
+		}
+
+		_MakePrivate();
 	}
 
 
@@ -195,7 +290,15 @@ namespace Clu
 			throw CLU_EXCEPTION("Invalid image to crop from");
 		}
 
-		Create(xImage.m_xFormat, xImage.m_vecLayerPtr, true);
+		if (xImage.m_bDataOwner && !xImage.m_pBuffer->HasViews())
+		{
+			// The copy shares the memory until one of the images is written to.
+			*this = xImage;
+		}
+		else
+		{
+			Create(xImage.m_xFormat, xImage.m_vecLayerPtr, true, xImage.LayerRowPitch());
+		}
 	}
 
 
@@ -224,19 +327,96 @@ namespace Clu
 		Create(SImageFormat(iWidth, iHeight, xImage.m_xFormat.ePixelType, xImage.m_xFormat.eDataType));
 
 		int nAdjY = (bYOriginAtTop ? iY : xImage.m_xFormat.iHeight - iY - iHeight);
-		int nSrcStride = xImage.m_xFormat.iWidth * int(xImage.BytesPerLayerPixel());
-		int nTrgStride = m_xFormat.iWidth * int(BytesPerLayerPixel());
+		const size_t nSrcOffset = size_t(nAdjY) * xImage.LayerRowPitch() + size_t(iX) * xImage.BytesPerLayerPixel();
 
 		for (size_t nLayerIdx = 0; nLayerIdx < LayerCount(); ++nLayerIdx)
 		{
-			TData* pSrc = xImage.m_vecLayerPtr[nLayerIdx] + (nAdjY * nSrcStride) + (iX * int(xImage.BytesPerLayerPixel()));
-			TData* pTrg = m_vecLayerPtr[nLayerIdx];
+			CopyImageRows(m_vecLayerPtr[nLayerIdx], LayerRowPitch(), xImage.m_vecLayerPtr[nLayerIdx] + nSrcOffset, xImage.LayerRowPitch()
+				, LayerRowByteCount(), size_t(iHeight));
+		}
+	}
 
-			for (int nIdx = 0; nIdx < iHeight; ++nIdx, pSrc += nSrcStride, pTrg += nTrgStride)
+	void CLayerImage::ViewFrom(const CReference<CLayerImage>& xParent, int iX, int iY, int iWidth, int iHeight, bool bYOriginAtTop
+		, bool bReadOnly)
+	{
+		if (!xParent.IsValid() || !xParent->IsValid())
+		{
+			throw CLU_EXCEPTION("Given image is invalid");
+		}
+
+		CReference<CLayerImage> xRef(xParent);
+		CLayerImage& xImage = *xRef;
+		if (this == &xImage)
+		{
+			throw CLU_EXCEPTION("Cannot view into same image");
+		}
+
+		if (iX < 0 || iWidth <= 0 || iX + iWidth > xImage.Width())
+		{
+			throw CLU_EXCEPTION("Horizontal view area out of range");
+		}
+
+		if (iY < 0 || iHeight <= 0 || iY + iHeight > xImage.Height())
+		{
+			throw CLU_EXCEPTION("Vertical view area out of range");
+		}
+
+		// Writes through the view must not show in copies of the parent, and the parent must not stop sharing its
+		// memory with the view when it is written to. A read-only view does not write and leaves the parent as it is.
+		if (!bReadOnly)
+		{
+			xImage._PrepareWrite();
+			if (xImage.m_pBuffer)
 			{
-				memcpy(pTrg, pSrc, nTrgStride);
+				xImage.m_pBuffer->SetHasViews();
 			}
 		}
+
+		Destroy();
+
+		int nAdjY = (bYOriginAtTop ? iY : xImage.m_xFormat.iHeight - iY - iHeight);
+		const size_t nSrcOffset = size_t(nAdjY) * xImage.LayerRowPitch() + size_t(iX) * xImage.BytesPerLayerPixel();
+
+		m_xFormat = SImageFormat(iWidth, iHeight, xImage.m_xFormat.ePixelType, xImage.m_xFormat.eDataType);
+		m_nLayerRowPitch = xImage.LayerRowPitch();
+
+		m_vecLayerPtr.resize(xImage.LayerCount());
+		for (size_t nLayerIdx = 0; nLayerIdx < m_vecLayerPtr.size(); ++nLayerIdx)
+		{
+			m_vecLayerPtr[nLayerIdx] = xImage.m_vecLayerPtr[nLayerIdx] + nSrcOffset;
+		}
+
+		m_bDataOwner = false;
+		m_bIsCompactMemoryBlock = false;
+		m_bReadOnly = bReadOnly;
+		m_pBuffer = xImage.m_pBuffer;
+		m_xParent = std::move(xRef);
+	}
+
+	void CLayerImage::ViewFrom(CImageIntern& xImage)
+	{
+		if (!xImage.IsValid() || SImageType::DimOf(xImage.PixelType()) != 1)
+		{
+			throw CLU_EXCEPTION("Only valid single channel images can be viewed as layer images");
+		}
+
+		// As for a writable view of an image of the same type, writes through the view show in the source.
+		xImage._PrepareWrite();
+		if (xImage.m_pBuffer)
+		{
+			xImage.m_pBuffer->SetHasViews();
+		}
+
+		Destroy();
+
+		m_xFormat = SImageFormat(xImage.Width(), xImage.Height(), xImage.PixelType(), xImage.DataType());
+		m_nLayerRowPitch = xImage.RowPitch();
+		m_vecLayerPtr.assign(1, xImage.m_pucData);
+
+		m_bDataOwner = false;
+		m_bIsCompactMemoryBlock = false;
+		m_bReadOnly = false;
+		m_pBuffer = xImage.m_pBuffer;
 	}
 
 	void CLayerImage::Insert(const CLayerImage& xImage, int nX, int nY, bool bYOriginAtTop)
@@ -256,7 +436,7 @@ namespace Clu
 			throw CLU_EXCEPTION("Cannot insert into same image");
 		}
 
-		if (Type() != xImage.Type())
+		if (!m_xFormat.IsEqualType(xImage.m_xFormat))
 		{
 			throw CLU_EXCEPTION("Inserted image has to be of same type as this image");
 		}
@@ -271,19 +451,16 @@ namespace Clu
 			throw CLU_EXCEPTION("Vertical insert area out of range");
 		}
 
-		int nSrcStride = xImage.m_xFormat.iWidth * int(xImage.BytesPerLayerPixel());
+		_PrepareWrite();
+
 		int nAdjY = (bYOriginAtTop ? nY : m_xFormat.iHeight - nY - xImage.m_xFormat.iHeight);
-		int nTrgStride = m_xFormat.iWidth * int(BytesPerLayerPixel());
+		const size_t nTrgOffset = size_t(nAdjY) * LayerRowPitch() + size_t(nX) * BytesPerLayerPixel();
 
+		// Copy only the rows of the inserted image, not the full rows of this image.
 		for (size_t nLayerIdx = 0; nLayerIdx < LayerCount(); ++nLayerIdx)
 		{
-			TData* pSrc = xImage.m_vecLayerPtr[nLayerIdx];
-			TData* pTrg = m_vecLayerPtr[nLayerIdx] + (nAdjY * nTrgStride) + (nX * int(BytesPerLayerPixel()));
-
-			for (int nIdx = 0; nIdx < xImage.m_xFormat.iHeight; ++nIdx, pSrc += nSrcStride, pTrg += nTrgStride)
-			{
-				memcpy(pTrg, pSrc, nTrgStride);
-			}
+			CopyImageRows(m_vecLayerPtr[nLayerIdx] + nTrgOffset, LayerRowPitch(), xImage.m_vecLayerPtr[nLayerIdx], xImage.LayerRowPitch()
+				, xImage.LayerRowByteCount(), size_t(xImage.m_xFormat.iHeight));
 		}
 	}
 
@@ -25,13 +25,18 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <memory>
 #include <vector>
 
 #include "IException.h"
 #include "ImageFormat.h"
+#include "Reference.h"
 
 namespace Clu
 {
+	class CImageBuffer;
+	class CImageIntern;
+
 	class CLayerImage
 	{
 	public:
@@ -42,11 +47,25 @@ namespace Clu
 		Clu::SImageFormat m_xFormat;
 
 		TLayerVec m_vecLayerPtr;
+		size_t m_nLayerRowPitch;
 		bool m_bDataOwner;
 		bool m_bIsCompactMemoryBlock;
 
+		// True for a view that must not write to the memory of its parent. It copies its region on the first write.
+		bool m_bReadOnly;
+
+		// The memory of all layers. Copies of an image share it until one of them is written to.
+		std::shared_ptr<CImageBuffer> m_pBuffer;
+
+		// The image this image is a view into.
+		CReference<CLayerImage> m_xParent;
+
 	protected:
 		void _Reset();
+		void _PrepareWrite();
+		void _MakePrivate();
+
+		friend class CImageIntern;
 
 	public :
 
@@ -55,7 +74,7 @@ namespace Clu
 		CLayerImage(CLayerImage&& xImage);
 		CLayerImage(const CLayerImage& xImage);
 		CLayerImage(const SImageFormat& xFormat);
-		CLayerImage(const SImageFormat& xFormat, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData = true);
+		CLayerImage(const SImageFormat& xFormat, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData = true, size_t nLayerRowPitch = 0);
 		~CLayerImage();
 
 		CLayerImage& operator= (CLayerImage&& xImage);
@@ -66,13 +85,40 @@ namespace Clu
 		void CropFrom(const CLayerImage& xImage, int iX, int iY, int iWidth, int iHeight, bool bYOriginAtTop = true);
 		void Insert(const CLayerImage& xImage, int iX, int iY, bool bYOriginAtTop = true);
 
+		/// <summary>
+		/// 	Makes this image a view of a rectangular region of the referenced image. No memory is allocated or copied:
+		/// 	the layers point into the layers of the parent and use its layer row pitch. The view shares the layer
+		/// 	memory of the parent, so the memory stays alive as long as the view exists, even if the parent is
+		/// 	created anew or destroyed. A read-only view leaves the parent untouched and copies its region on the
+		/// 	first write, as CImageIntern::ViewFrom() does.
+		/// </summary>
+		void ViewFrom(const CReference<CLayerImage>& xParent, int iX, int iY, int iWidth, int iHeight, bool bYOriginAtTop = true
+			, bool bReadOnly = false);
+
+		/// <summary>
+		/// 	Makes this image a writable single layer view of the memory of an image with a single channel. The view
+		/// 	shares the pixel memory like CImageIntern::ViewFrom(CLayerImage&) does.
+		/// </summary>
+		void ViewFrom(CImageIntern& xImage);
+
 		void Create(const SImageFormat& xFormat);
-		void Create(const SImageFormat& xFormat, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData = true);
+
+		/// <summary>
+		/// 	Creates the image with nLayerRowPitch bytes between the layer rows, where zero denotes packed rows. Pass
+		/// 	SImageFormat::AlignedRowPitch(LayerRowByteCount(), BytesPerLayerPixel()) for layer rows that start aligned.
+		/// </summary>
+		void Create(const SImageFormat& xFormat, size_t nLayerRowPitch);
+
+		/// <summary>
+		/// 	Creates the image from layer data. nLayerRowPitch gives the bytes between the rows of the given layers, where
+		/// 	zero denotes tightly packed rows.
+		/// </summary>
+		void Create(const SImageFormat& xFormat, const void **ppImageLayerData, size_t nLayerCount, bool bCopyData = true, size_t nLayerRowPitch = 0);
 
 		template<typename T>
-		void Create(const SImageFormat& xFormat, const std::vector<T*>& vecLayerData, bool bCopyData = true)
+		void Create(const SImageFormat& xFormat, const std::vector<T*>& vecLayerData, bool bCopyData = true, size_t nLayerRowPitch = 0)
 		{
-			Create(xFormat, (const void **) vecLayerData.data(), vecLayerData.size(), bCopyData);
+			Create(xFormat, (const void **) vecLayerData.data(), vecLayerData.size(), bCopyData, nLayerRowPitch);
 		}
 
 		void Destroy();
@@ -104,6 +150,28 @@ namespace Clu
 			return m_bIsCompactMemoryBlock;
 		}
 
+		bool IsView() const
+		{
+			return m_xParent.IsValid();
+		}
+
+		bool IsReadOnly() const
+		{
+			return m_bReadOnly;
+		}
+
+		/// <summary>	True if this image owns its layer memory and no other image refers to it. </summary>
+		bool IsUnique() const
+		{
+			return m_bDataOwner && m_pBuffer.use_count() == 1;
+		}
+
+		/// <summary>
+		/// 	Gives this image its own copy of the layer memory, unless it is unique already. A detached view is no
+		/// 	longer a view and external data is copied.
+		/// </summary>
+		void Detach();
+
 		bool IsOfType(Clu::EDataType eDataType, Clu::EPixelType ePixelType)
 		{
 			return (m_xFormat.eDataType == eDataType && m_xFormat.ePixelType == ePixelType);
@@ -139,14 +207,25 @@ namespace Clu
 			return m_xFormat.PixelCount();
 		}
 
+		size_t LayerRowByteCount() const
+		{
+			return size_t(m_xFormat.iWidth) * BytesPerLayerPixel();
+		}
+
+		/// <summary>	Number of bytes between the starts of consecutive rows of a layer. </summary>
+		size_t LayerRowPitch() const
+		{
+			return (m_nLayerRowPitch > 0 ? m_nLayerRowPitch : LayerRowByteCount());
+		}
+
 		size_t LayerByteCount() const
 		{
-			return m_xFormat.PixelCount() * SImageType::SizeOf(m_xFormat.eDataType);
+			return LayerRowPitch() * size_t(m_xFormat.iHeight);
 		}
 
 		size_t TotalByteCount() const
 		{
-			return m_xFormat.ByteCount();
+			return LayerByteCount() * SImageType::DimOf(m_xFormat.ePixelType);
 		}
 
 		int Width() const
@@ -180,6 +259,10 @@ namespace Clu
 			return (const SImageType&)m_xFormat;
 		}
 
+		/// <summary>
+		/// 	Returns the memory of a layer for writing. If the memory is shared with copies of this image, this image
+		/// 	first receives its own copy of all layers.
+		/// </summary>
 		void* DataPointer(size_t nLayerId)
 		{
 			if (nLayerId >= m_vecLayerPtr.size())
@@ -187,6 +270,7 @@ namespace Clu
 				throw CLU_EXCEPTION("Invalid layer id");
 			}
 
+			_PrepareWrite();
 			return (void *)m_vecLayerPtr[nLayerId];
 		}
 